@@ -330,6 +330,12 @@ namespace QuantLib {
         return lossModel_->splitVaRLevel(date, loss);
     }
 
+    Disposable<std::vector<Real> > 
+        Basket::splitESFLevel(const Date& date, Real loss) const {
+        calculate();
+        return lossModel_->splitESFLevel(date, loss);
+    }
+
     Real Basket::expectedShortfall(const Date& d, Probability prob) const {
         calculate();
         return lossModel_->expectedShortfall(d, prob);
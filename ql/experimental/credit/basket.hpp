@@ -248,6 +248,10 @@ namespace QuantLib {
         corresponds to some percentile.*/
         Disposable<std::vector<Real> > 
             splitVaRLevel(const Date& date, Real loss) const;
+        /* Split the expected loss over a portfolio loss level along
+        counterparties.*/
+        Disposable<std::vector<Real> > 
+            splitESFLevel(const Date& date, Real loss) const;
         /*! Full loss distribution
         */
         Disposable<std::map<Real, Probability> > lossDistribution(
@@ -54,9 +54,14 @@ namespace QuantLib {
     parameter can then be dropped but the use of random recoveries should be
     added in some other way.
 
+    When the latent model integrates on a fixed set of nodes (as the
+    Gaussian quadrature does) the expected tranche losses and the loss
+    distribution are integrated in a single pass: the conditional default
+    probabilities of all names are computed on all nodes as a dense matrix
+    and the conditional distributions are built in parallel over the
+    nodes. Adaptive integrations integrate node by node.
+
     \todo untested/wip for the random recovery models.
-    \todo integrate with the previously computed probability inversions of
-    the cumulative functions.
     */
     template<class LLM>
     class BinomialLossModel : public DefaultLossModel {
@@ -73,6 +78,10 @@ namespace QuantLib {
           detachAmount_ = basket_->remainingDetachmentAmount();
 
           copula_->resetBasket(basket_.currentLink()); // forces interface
+          if(!copula_->integrationNodes(nodes_, nodeWeights_)) {
+              nodes_.clear();
+              nodeWeights_.clear();
+          }
       }
 
     protected:
@@ -90,6 +99,16 @@ namespace QuantLib {
                 invProbs[iName] = 
                     copula_->inverseCumulativeY(invProbs[iName], iName);
 
+            if(!nodes_.empty()) {
+                std::vector<std::vector<Real> > densities;
+                nodeLossProbabilities(date, notionals, invProbs, densities);
+                // reduced in node order, independently of the threads
+                std::vector<Real> results(densities.front().size(), 0.);
+                for(Size k=0; k<nodes_.size(); k++)
+                    for(Size i=0; i<results.size(); i++)
+                        results[i] += nodeWeights_[k] * densities[k][i];
+                return results;
+            }
             return copula_->integratedExpectedValue(
                 ext::function<Disposable<std::vector<Real> > (
                   const std::vector<Real>& v1)>(
@@ -143,12 +162,34 @@ namespace QuantLib {
                 const std::vector<Real>& bsktNots,
                 const std::vector<Real>& uncondDefProbInv, 
                             const std::vector<Real>&  mktFactor) const;
+        /*! Loss probability density for the given conditional fractional
+            LGDs and conditional default probabilities of the live names.
+        */
+        Disposable<std::vector<Real> >
+            lossProbability(const std::vector<Real>& fractionalEL,
+                            const std::vector<Real>& bsktNots,
+                            const Probability* condDefProbs) const;
+        /*! Loss probability densities on all the integration nodes, for
+            latent models integrating on a fixed set of them.
+        */
+        void nodeLossProbabilities(const Date& date,
+                                   const std::vector<Real>& bsktNots,
+                                   const std::vector<Real>& uncondDefProbInv,
+                                   std::vector<std::vector<Real> >& densities)
+                                                                        const;
+        //! Expected tranche loss for the given loss density.
+        Real trancheLoss(const std::vector<Real>& lossVals,
+                         const std::vector<Real>& lossProbs) const;
 
         const ext::shared_ptr<LLM> copula_;
 
         // cached arguments:
         // remaining basket magnitudes:
         mutable Real attachAmount_, detachAmount_;
+        // integration nodes and weights (density included) of the latent
+        //   model; empty if the integration is adaptive.
+        mutable std::vector<std::vector<Real> > nodes_;
+        mutable std::vector<Real> nodeWeights_;
     };
 
     //-------------------------------------------------------------------------
@@ -177,6 +218,21 @@ namespace QuantLib {
         // conditional fractional LGD expected as given by the recovery model 
         //   for the ramaining(live) names at the current eval date.
         std::vector<Real> fractionalEL = expConditionalLgd(date, mktFactors);
+        std::vector<Probability> condDefProb(bsktSize, 0.);
+        for(Size j=0; j<bsktSize; j++)//transform
+            condDefProb[j] = 
+                copula_->conditionalDefaultProbabilityInvP(uncondDefProbInv[j],
+                    j, mktFactors);
+        return lossProbability(fractionalEL, bsktNots, &condDefProb[0]);
+    }
+
+    template< class LLM>
+    Disposable<std::vector<Real> > BinomialLossModel<LLM>::lossProbability(
+        const std::vector<Real>& fractionalEL,
+        const std::vector<Real>& bsktNots,
+        const Probability* condDefProbs) const
+    {
+        Size bsktSize = fractionalEL.size();
         std::vector<Real> lgdsLeft;
         std::transform(fractionalEL.begin(), fractionalEL.end(), 
             bsktNots.begin(), std::back_inserter(lgdsLeft), 
@@ -185,11 +241,8 @@ namespace QuantLib {
             std::accumulate(lgdsLeft.begin(), lgdsLeft.end(), Real(0.)) /
                 bsktSize;
 
-        std::vector<Probability> condDefProb(bsktSize, 0.);
-        for(Size j=0; j<bsktSize; j++)//transform
-            condDefProb[j] = 
-                copula_->conditionalDefaultProbabilityInvP(uncondDefProbInv[j],
-                    j, mktFactors);
+        std::vector<Probability> condDefProb(condDefProbs,
+                                             condDefProbs + bsktSize);
         // of full portfolio:
         Real avgProb = avgLgd <= QL_EPSILON ? 0. : // only if all are 0
                 std::inner_product(condDefProb.begin(), 
@@ -255,6 +308,30 @@ namespace QuantLib {
         return lossProbDensity;
     }
 
+    template< class LLM>
+    void BinomialLossModel<LLM>::nodeLossProbabilities(
+        const Date& date,
+        const std::vector<Real>& bsktNots,
+        const std::vector<Real>& uncondDefProbInv,
+        std::vector<std::vector<Real> >& densities) const
+    {
+        const Size bsktSize = uncondDefProbInv.size();
+        std::vector<Probability> pDef;
+        copula_->conditionalDefaultProbabilitiesInvP(uncondDefProbInv,
+            nodes_, pDef);
+        // the basket is not touched from within the threads
+        std::vector<std::vector<Real> > fractionalELs;
+        for(Size k=0; k<nodes_.size(); k++)
+            fractionalELs.push_back(expConditionalLgd(date, nodes_[k]));
+        densities.resize(nodes_.size());
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for
+        #endif
+        for(long k=0; k<long(nodes_.size()); k++)
+            densities[k] = lossProbability(fractionalELs[k], bsktNots,
+                                           &pDef[k*bsktSize]);
+    }
+
     //-------------------------------------------------------------------------
 
     template< class LLM>
@@ -318,8 +395,14 @@ namespace QuantLib {
         const std::vector<Real>& uncondDefProbsInv,
         const std::vector<Real>& mkf) const {
 
-        std::vector<Real> condLProb = 
-            lossProbability(d, bsktNots, uncondDefProbsInv, mkf);
+        return trancheLoss(lossVals,
+            lossProbability(d, bsktNots, uncondDefProbsInv, mkf));
+    }
+
+    template< class LLM>
+    Real BinomialLossModel<LLM>::trancheLoss(
+        const std::vector<Real>& lossVals,
+        const std::vector<Real>& condLProb) const {
         // \to do: move to a do-while over attach to detach
         Real suma = 0.;
         for(Size i=0; i<lossVals.size(); i++) { 
@@ -340,7 +423,16 @@ namespace QuantLib {
         for(Size iName=0; iName<invProbs.size(); iName++)
             invProbs[iName] = 
                 copula_->inverseCumulativeY(invProbs[iName], iName);
-            
+
+        if(!nodes_.empty()) {
+            std::vector<std::vector<Real> > densities;
+            nodeLossProbabilities(d, notionals, invProbs, densities);
+            Real expLoss = 0.;
+            for(Size k=0; k<nodes_.size(); k++)
+                expLoss += nodeWeights_[k] * trancheLoss(lossVals,
+                                                         densities[k]);
+            return expLoss;
+        }
         return copula_->integratedExpectedValue(
             ext::function<Real (const std::vector<Real>& v1)>(
                 ext::bind(&BinomialLossModel<LLM>::condTrancheLoss,
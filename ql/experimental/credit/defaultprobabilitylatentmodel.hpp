@@ -160,9 +160,39 @@ namespace QuantLib {
             QL_REQUIRE (res >= 0. && res <= 1.,
                         "conditional probability " << res << "out of range");
             #endif
-        
+
             return res;
         }
+        /*! Conditional default probabilities of all names on a set of
+        values of the model factors, e.g. the nodes of the integration.
+        The result is a dense matrix stored node-major: the probability
+        of the i-th name on the k-th node is at <tt>k*names+i</tt>.
+        @param invCumYProbs Inverse cumulatives of the unconditional
+          default probabilities of the names.
+        @param nodes Values of LM independent factors.
+        @param probs Output matrix.
+        */
+        void conditionalDefaultProbabilitiesInvP(
+            const std::vector<Real>& invCumYProbs,
+            const std::vector<std::vector<Real> >& nodes,
+            std::vector<Probability>& probs) const {
+            const Size names = invCumYProbs.size();
+            QL_REQUIRE(names <= factorWeights_.size(),
+                "too many names for the model.");
+            probs.resize(nodes.size() * names);
+            // arguments of the cumulative first, in a tight loop over
+            //   contiguous storage, then the cumulative on all of them
+            for(Size k=0; k<nodes.size(); k++) {
+                Probability* row = &probs[k * names];
+                for(Size i=0; i<names; i++)
+                    row[i] = (invCumYProbs[i] -
+                        std::inner_product(factorWeights_[i].begin(),
+                            factorWeights_[i].end(), nodes[k].begin(), 0.))
+                        / idiosyncFctrs_[i];
+            }
+            for(Size j=0; j<probs.size(); j++)
+                probs[j] = cumulativeZ(probs[j]);
+        }
     protected:
         /*! Returns the probability of default of a given name conditional on
         the realization of a given set of values of the model independent
@@ -0,0 +1,445 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file fftlossmodel.hpp
+    \brief Characteristic function loss model for heterogeneous pools
+*/
+
+#ifndef quantlib_fft_loss_model_hpp
+#define quantlib_fft_loss_model_hpp
+
+#include <ql/experimental/credit/constantlosslatentmodel.hpp>
+#include <ql/experimental/credit/defaultlossmodel.hpp>
+#include <ql/math/fastfouriertransform.hpp>
+#include <algorithm>
+#include <complex>
+#include <map>
+#include <vector>
+
+namespace QuantLib {
+
+    /*! Default loss model for large heterogeneous pools, computing the
+        exact distribution of the discretised portfolio loss through its
+        characteristic function.
+
+        The losses given default of the names are expressed in units of
+        a grid spacing, the total remaining loss given default divided
+        by the requested number of buckets. A loss falling between two
+        grid points is split between them so that its expected value is
+        preserved: the loss of each name conditional to the latent
+        factors takes at most three values on the grid. On each
+        integration node of the latent model the characteristic function
+        of the portfolio loss is the product of those of the names,
+        evaluated on all the grid frequencies at once; the conditional
+        characteristic functions are computed in parallel over the nodes
+        and integrated, and a single inverse FFT per date returns the
+        unconditional loss distribution. The cost is proportional to the
+        number of names times the grid size, instead of the square of the
+        number of names of the recursive models on heterogeneous
+        notionals.
+
+        The contributions of the names to a given loss level (VaR) and to
+        the losses above it (expected shortfall) are computed in the
+        same way, replacing the characteristic function of the portfolio
+        by the product over the other names; the latter is built from
+        prefix and suffix products, since the characteristic function of
+        a single name can vanish at some frequencies.
+
+        The latent model must be integrated on a fixed set of nodes (e.g.
+        by Gaussian quadrature). As for the other latent models, copulas
+        other than Gaussian are only an approximation.
+
+        \warning The grid spans the largest discretised loss, which is
+                 at most the number of buckets plus the number of names;
+                 its size is rounded up to a power of two.
+
+        \test the loss distribution is checked against the recursive
+              model on a pool whose losses lie on the grid, the VaR and
+              expected shortfall splits against their totals, and the
+              tranche premiums against Hull-White values.
+    */
+    template<class copulaPolicy>
+    class FFTLossModel : public DefaultLossModel {
+      public:
+        explicit FFTLossModel(
+            const ext::shared_ptr<ConstantLossLatentmodel<copulaPolicy> >& m,
+            Size lossBuckets = 1024)
+        : copula_(m), lossBuckets_(lossBuckets) {
+            QL_REQUIRE(lossBuckets_ > 0, "null number of loss buckets");
+        }
+
+        Real expectedTrancheLoss(const Date& d) const override;
+        /*! The passed loss fraction refers to the tranche notional. */
+        Probability probOverLoss(const Date& d,
+                                 Real lossFraction) const override;
+        Real percentile(const Date& d, Real percentile) const override;
+        Real expectedShortfall(const Date& d,
+                               Real percentile) const override;
+        /*! Expected loss of each name conditional to the portfolio loss
+            being the grid loss closest to the given amount; they add up
+            to that loss. Refers to the whole portfolio, not the tranche.
+        */
+        Disposable<std::vector<Real> > splitVaRLevel(const Date& d,
+                                                     Real loss) const override;
+        /*! Expected loss of each name conditional to the portfolio loss
+            being at or above the given amount; they add up to the
+            expected portfolio loss in the same scenarios.
+        */
+        Disposable<std::vector<Real> > splitESFLevel(const Date& d,
+                                                     Real loss) const override;
+        //! Cumulative distribution of the portfolio loss, on the grid.
+        Disposable<std::map<Real, Probability> >
+            lossDistribution(const Date& d) const override;
+        //! Probabilities of the portfolio losses on the grid.
+        Disposable<std::vector<Probability> >
+            lossProbability(const Date& d) const;
+        //! Spacing of the loss grid, set on the basket being assigned.
+        Real lossUnit() const { return lossUnit_; }
+
+      protected:
+        void resetModel() override;
+
+        const ext::shared_ptr<ConstantLossLatentmodel<copulaPolicy> > copula_;
+
+      private:
+        typedef std::complex<Real> complex;
+
+        // conditional default probabilities, node-major
+        void conditionalProbabilities(const Date& d,
+                                      std::vector<Probability>& pDef) const;
+        // characteristic function of the loss of a name at the j-th
+        //   frequency, and its derivative times the default probability
+        complex nameCharacteristic(Size iName, Size j, Probability p) const {
+            complex jump = roots_[(lowerUnits_[iName] * j) & mask_];
+            if (upperWeights_[iName] > 0.0)
+                jump *= (1.0 - upperWeights_[iName])
+                    + upperWeights_[iName] * roots_[j];
+            return (1.0 - p) + p * jump;
+        }
+        complex nameLossTerm(Size iName, Size j, Probability p) const {
+            Real a = Real(lowerUnits_[iName]), f = upperWeights_[iName];
+            complex term = roots_[(lowerUnits_[iName] * j) & mask_];
+            if (f > 0.0)
+                term *= (1.0 - f) * a + f * (a + 1.0) * roots_[j];
+            else
+                term *= a;
+            return p * term;
+        }
+        // characteristic function of the portfolio loss on a node, for
+        //   the frequencies up to half the grid size
+        void conditionalCharacteristic(const Probability* pDef,
+                                       complex* phi) const;
+        // contributions of the names to the losses in [first, last], in
+        //   grid units; the last element is the probability of the range
+        Disposable<std::vector<Real> > lossSplit(const Date& d,
+                                                 Size first,
+                                                 Size last) const;
+        Real trancheLoss(Size units) const {
+            return std::min(std::max(units * lossUnit_ - attachAmount_, 0.),
+                            detachAmount_ - attachAmount_);
+        }
+
+        const Size lossBuckets_;
+        mutable Real lossUnit_, attachAmount_, detachAmount_;
+        mutable Size remainingBsktSize_;
+        // discretised losses given default: the lower grid point and the
+        //   weight of the upper one
+        mutable std::vector<Size> lowerUnits_;
+        mutable std::vector<Real> upperWeights_;
+        mutable Size maxUnits_, gridSize_, mask_;
+        mutable ext::shared_ptr<FastFourierTransform> fft_;
+        // exp(-2 pi i k/gridSize)
+        mutable std::vector<complex> roots_;
+        // integration nodes and weights, density included
+        mutable std::vector<std::vector<Real> > nodes_;
+        mutable std::vector<Real> nodeWeights_;
+    };
+
+    typedef FFTLossModel<GaussianCopulaPolicy> FFTGaussLossModel;
+    typedef FFTLossModel<TCopulaPolicy> FFTStudentLossModel;
+
+    // Inlines ------------------------------------------------
+
+    template<class CP>
+    void FFTLossModel<CP>::resetModel() {
+        std::vector<Real> notionals = basket_->remainingNotionals();
+        attachAmount_ = basket_->remainingAttachmentAmount();
+        detachAmount_ = basket_->remainingDetachmentAmount();
+        remainingBsktSize_ = notionals.size();
+
+        copula_->resetBasket(basket_.currentLink());
+
+        QL_REQUIRE(copula_->integrationNodes(nodes_, nodeWeights_),
+            "FFT loss model requires a latent model integrated on fixed "
+            "nodes");
+
+        std::vector<Real> lgds(remainingBsktSize_);
+        Real totalLgd = 0.;
+        for(Size i=0; i<remainingBsktSize_; ++i) {
+            lgds[i] = notionals[i] * (1. - copula_->recoveries()[i]);
+            totalLgd += lgds[i];
+        }
+        lossUnit_ = totalLgd > 0. ? totalLgd / lossBuckets_ : 1.;
+
+        lowerUnits_.resize(remainingBsktSize_);
+        upperWeights_.resize(remainingBsktSize_);
+        maxUnits_ = 0;
+        for(Size i=0; i<remainingBsktSize_; ++i) {
+            Real units = lgds[i] / lossUnit_;
+            // losses on the grid up to rounding stay there
+            Real lower = std::floor(units + 1.e-9);
+            lowerUnits_[i] = static_cast<Size>(lower);
+            upperWeights_[i] = units - lower > 1.e-9 ? units - lower : 0.;
+            maxUnits_ += lowerUnits_[i] + (upperWeights_[i] > 0. ? 1 : 0);
+        }
+
+        std::size_t order = std::max<std::size_t>(
+            FastFourierTransform::min_order(maxUnits_ + 1), 1);
+        fft_ = ext::make_shared<FastFourierTransform>(order);
+        gridSize_ = fft_->output_size();
+        mask_ = gridSize_ - 1;
+        roots_.resize(gridSize_);
+        for(Size k=0; k<gridSize_; ++k)
+            roots_[k] = std::polar(1., -2. * M_PI * k / gridSize_);
+    }
+
+    template<class CP>
+    void FFTLossModel<CP>::conditionalProbabilities(const Date& d,
+        std::vector<Probability>& pDef) const
+    {
+        // default thresholds, inverted once per name
+        std::vector<Probability> uncDefProb =
+            basket_->remainingProbabilities(d);
+        std::vector<Real> invProb(uncDefProb.size());
+        for(Size i=0; i<uncDefProb.size(); ++i)
+            invProb[i] = copula_->inverseCumulativeY(uncDefProb[i], i);
+        copula_->conditionalDefaultProbabilitiesInvP(invProb, nodes_, pDef);
+    }
+
+    template<class CP>
+    void FFTLossModel<CP>::conditionalCharacteristic(
+        const Probability* pDef, complex* phi) const
+    {
+        const Size frequencies = gridSize_/2 + 1;
+        std::fill(phi, phi + frequencies, complex(1.));
+        for(Size i=0; i<remainingBsktSize_; ++i) {
+            if(lowerUnits_[i] == 0 && upperWeights_[i] == 0.)
+                continue;
+            for(Size j=0; j<frequencies; ++j)
+                phi[j] *= nameCharacteristic(i, j, pDef[i]);
+        }
+    }
+
+    template<class CP>
+    Disposable<std::vector<Probability> >
+    FFTLossModel<CP>::lossProbability(const Date& d) const {
+        std::vector<Probability> pDef;
+        conditionalProbabilities(d, pDef);
+
+        const Size frequencies = gridSize_/2 + 1;
+        std::vector<complex> phis(nodes_.size() * frequencies);
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for
+        #endif
+        for(long k=0; k<long(nodes_.size()); ++k)
+            conditionalCharacteristic(&pDef[k*remainingBsktSize_],
+                                      &phis[k*frequencies]);
+
+        // the transform is linear: integrate the characteristic function
+        //   first, in node order, and invert once
+        std::vector<complex> phi(gridSize_, complex(0.));
+        for(Size k=0; k<nodes_.size(); ++k)
+            for(Size j=0; j<frequencies; ++j)
+                phi[j] += nodeWeights_[k] * phis[k*frequencies + j];
+        // the loss is real, the rest of the spectrum is conjugate
+        for(Size j=frequencies; j<gridSize_; ++j)
+            phi[j] = std::conj(phi[gridSize_ - j]);
+
+        std::vector<complex> transform(gridSize_);
+        fft_->inverse_transform(phi.begin(), phi.end(), transform.begin());
+
+        std::vector<Probability> probs(maxUnits_ + 1);
+        for(Size l=0; l<=maxUnits_; ++l)
+            probs[l] = std::max(transform[l].real() / gridSize_, 0.);
+        return probs;
+    }
+
+    template<class CP>
+    Disposable<std::map<Real, Probability> >
+    FFTLossModel<CP>::lossDistribution(const Date& d) const {
+        std::vector<Probability> probs = lossProbability(d);
+        std::map<Real, Probability> distrib;
+        Probability sum = 0.;
+        for(Size l=0; l<probs.size(); ++l) {
+            sum += probs[l];
+            distrib.insert(std::make_pair(l * lossUnit_, sum));
+        }
+        return distrib;
+    }
+
+    template<class CP>
+    Real FFTLossModel<CP>::expectedTrancheLoss(const Date& d) const {
+        std::vector<Probability> probs = lossProbability(d);
+        Real expLoss = 0.;
+        for(Size l=0; l<probs.size(); ++l)
+            expLoss += trancheLoss(l) * probs[l];
+        return expLoss;
+    }
+
+    template<class CP>
+    Probability FFTLossModel<CP>::probOverLoss(const Date& d,
+        Real lossFraction) const
+    {
+        std::vector<Probability> probs = lossProbability(d);
+        Real trancheAmount = lossFraction * (detachAmount_ - attachAmount_);
+        Probability prob = 0.;
+        for(Size l=probs.size(); l-- > 0 && trancheLoss(l) >= trancheAmount;)
+            prob += probs[l];
+        return prob;
+    }
+
+    template<class CP>
+    Real FFTLossModel<CP>::percentile(const Date& d, Real perc) const {
+        std::vector<Probability> probs = lossProbability(d);
+        Probability sum = 0.;
+        for(Size l=0; l<probs.size(); ++l) {
+            sum += probs[l];
+            if(sum >= perc)
+                return trancheLoss(l);
+        }
+        return trancheLoss(probs.size() - 1);
+    }
+
+    template<class CP>
+    Real FFTLossModel<CP>::expectedShortfall(const Date& d,
+        Real perc) const
+    {
+        QL_REQUIRE(perc >= 0. && perc < 1.,
+            "percentile " << perc << " out of range");
+        std::vector<Probability> probs = lossProbability(d);
+        // tail beyond the percentile, including the fraction of the
+        //   probability of the VaR loss needed to reach it
+        Probability sum = 0.;
+        Size l = 0;
+        for(; l<probs.size()-1; ++l) {
+            sum += probs[l];
+            if(sum >= perc)
+                break;
+        }
+        Real tail = (std::min(sum, 1.) - perc) * trancheLoss(l);
+        for(++l; l<probs.size(); ++l)
+            tail += probs[l] * trancheLoss(l);
+        return tail / (1. - perc);
+    }
+
+    template<class CP>
+    Disposable<std::vector<Real> >
+    FFTLossModel<CP>::lossSplit(const Date& d, Size first, Size last) const
+    {
+        std::vector<Probability> pDef;
+        conditionalProbabilities(d, pDef);
+
+        const Size frequencies = gridSize_/2 + 1;
+        // sums of exp(2 pi i j l/gridSize) over the losses in the range
+        std::vector<complex> range(frequencies);
+        range[0] = Real(last - first + 1);
+        for(Size j=1; j<frequencies; ++j) {
+            complex r = std::conj(roots_[j]);
+            range[j] = std::conj(roots_[(first * j) & mask_])
+                * (1. - std::conj(roots_[((last - first + 1) * j) & mask_]))
+                / (1. - r);
+        }
+
+        const Size n = remainingBsktSize_;
+        std::vector<Real> splits(nodes_.size() * (n + 1));
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for
+        #endif
+        for(long k=0; k<long(nodes_.size()); ++k) {
+            const Probability* p = &pDef[k*n];
+            Real* split = &splits[k*(n + 1)];
+            // the characteristic function without a name is the product
+            //   of the prefix and suffix products around it; dividing
+            //   the total by the name's own would fail where it vanishes
+            std::vector<complex> chars(n), prefix(n + 1);
+            for(Size j=0; j<frequencies; ++j) {
+                // the conjugate half of the spectrum doubles the inner
+                //   terms
+                complex weight = range[j]
+                    * ((j == 0 || j == frequencies - 1) ? 1. : 2.);
+                prefix[0] = 1.;
+                for(Size i=0; i<n; ++i) {
+                    chars[i] = (lowerUnits_[i] == 0 && upperWeights_[i] == 0.)
+                        ? complex(1.) : nameCharacteristic(i, j, p[i]);
+                    prefix[i + 1] = prefix[i] * chars[i];
+                }
+                split[n] += (prefix[n] * weight).real();
+                complex suffix(1.);
+                for(Size i=n; i-- > 0; ) {
+                    if(lowerUnits_[i] != 0 || upperWeights_[i] != 0.)
+                        split[i] += (prefix[i] * suffix
+                            * nameLossTerm(i, j, p[i]) * weight).real();
+                    suffix *= chars[i];
+                }
+            }
+        }
+
+        std::vector<Real> results(n + 1, 0.);
+        for(Size k=0; k<nodes_.size(); ++k)
+            for(Size i=0; i<=n; ++i)
+                results[i] += nodeWeights_[k] * splits[k*(n + 1) + i];
+        for(Size i=0; i<=n; ++i)
+            results[i] /= gridSize_;
+        return results;
+    }
+
+    template<class CP>
+    Disposable<std::vector<Real> >
+    FFTLossModel<CP>::splitVaRLevel(const Date& d, Real loss) const {
+        Size units = static_cast<Size>(std::max(
+            std::floor(loss / lossUnit_ + 0.5), 0.));
+        units = std::min(units, maxUnits_);
+        std::vector<Real> splits = lossSplit(d, units, units);
+        Probability prob = splits.back();
+        QL_REQUIRE(prob > 0., "null probability of a loss of "
+            << units * lossUnit_);
+        splits.pop_back();
+        for(Size i=0; i<splits.size(); ++i)
+            splits[i] *= lossUnit_ / prob;
+        return splits;
+    }
+
+    template<class CP>
+    Disposable<std::vector<Real> >
+    FFTLossModel<CP>::splitESFLevel(const Date& d, Real loss) const {
+        Size units = static_cast<Size>(std::max(
+            std::ceil(loss / lossUnit_ - 1.e-9), 0.));
+        QL_REQUIRE(units <= maxUnits_, "loss " << loss
+            << " above the largest portfolio loss");
+        std::vector<Real> splits = lossSplit(d, units, maxUnits_);
+        Probability prob = splits.back();
+        QL_REQUIRE(prob > 0., "null probability of a loss above "
+            << units * lossUnit_);
+        splits.pop_back();
+        for(Size i=0; i<splits.size(); ++i)
+            splits[i] *= lossUnit_ / prob;
+        return splits;
+    }
+
+}
+
+#endif
@@ -39,6 +39,10 @@
 
 #include <ql/math/randomnumbers/mt19937uniformrng.hpp>
 
+#include <algorithm>
+#include <exception>
+#include <numeric>
+
 /* Intended to replace
     ql\experimental\credit\randomdefaultmodel.Xpp
 */
@@ -71,15 +75,52 @@ namespace QuantLib {
     template <class simEventOwner> struct simEvent;
 
 
+    namespace detail {
+        /* Generator of a chunk of simulations starting at a given one; by
+        default, a generator with its own seed. */
+        template <class USNG>
+        struct RandomLMSubstream {
+            template <class Sampler, class Copula>
+            static ext::shared_ptr<Sampler> make(const Copula& copula,
+                BigNatural, BigNatural chunkSeed, Size) {
+                return ext::make_shared<Sampler>(copula, chunkSeed);
+            }
+        };
+
+        // Sobol sequences are skipped ahead instead.
+        template <>
+        struct RandomLMSubstream<SobolRsg> {
+            template <class Sampler, class Copula>
+            static ext::shared_ptr<Sampler> make(const Copula& copula,
+                BigNatural seed, BigNatural, Size firstSim) {
+                ext::shared_ptr<Sampler> rng =
+                    ext::make_shared<Sampler>(copula, seed);
+                rng->skipTo(firstSim);
+                return rng;
+            }
+        };
+    }
+
     /*! Base class for latent model monte carlo simulation. Independent of the
     copula type and the generator.
     Generates the factors and variable samples and determines event threshold
     but it is not responsible for actual event specification; thats the derived
     classes responsibility according to what they model.
-    Derived classes need mainly to implement nextSample (Worker::nextSample in
-    the multithreaded version) to compute the simulation event generated, if
-    any, from the latent variables sample. They also have the accompanying
-    event trait to specify.
+    Derived classes need mainly to implement nextSample to compute the
+    simulation event generated, if any, from the latent variables sample and
+    append it to the passed buffer. They also have the accompanying event trait
+    to specify.
+
+    Simulations are run in parallel in chunks of fixed size, each one with its
+    own generator. Sobol sequences are skipped ahead to the first simulation of
+    the chunk, so that the samples are the same as in a single sequence; other
+    generators are seeded independently for each chunk. Either way results do
+    not depend on the number of threads. Events are stored in a single flat
+    buffer, indexed by simulation through an offsets array, and the statistics
+    are computed in parallel over it.
+    nextSample must be safe to call concurrently; curves are bootstrapped by
+    initDates before the simulation starts. When sessions are enabled the
+    chunks are run sequentially.
     */
     /* CRTP used for performance to avoid virtual table resolution in the Monte
     Carlo. Not only in sample generation but access; quite an amount of time can
@@ -87,11 +128,6 @@ namespace QuantLib {
     positions that part of the problem will be starting to overtake the
     simulation costs.
 
-    \todo: someone with sound experience on cache misses look into this, the
-    statistics will be getting memory in and out of the cpu heavily and it
-    might be possible to get performance out of that.
-    \todo: parallelize the statistics computation, things like Var/ESF splits
-    are very expensive.
     \todo: consider another design, taking the statistics outside the models.
     */
     template<template <class, class> class derivedRandomLM, class copulaPolicy,
@@ -103,6 +139,7 @@ namespace QuantLib {
         // random generation is performed in this class only.
         typedef typename LatentModel<copulaPolicy>::template FactorSampler<USNG>
             copulaRNG_type;
+        typedef simEvent<derivedRandomLM<copulaPolicy, USNG> > event_type;
     protected:
         RandomLM(Size numFactors,
             Size numLMVars,
@@ -114,6 +151,7 @@ namespace QuantLib {
 
         void update() override {
             simsBuffer_.clear();
+            simsOffsets_.clear();
             // tell basket to notify instruments, etc, we are invalid
             if(!basket_.empty()) basket_->notifyObservers();
             LazyObject::update();
@@ -122,29 +160,85 @@ namespace QuantLib {
         void performCalculations() const override {
             static_cast<const derivedRandomLM<copulaPolicy, USNG>* >(
                 this)->initDates();//in update?
-            copulasRng_ = ext::make_shared<copulaRNG_type>(copula_, seed_);
             performSimulations();
         }
 
         void performSimulations() const {
-            // Next sequence should determine the event and push it into buffer
-            for (Size i = nSims_; i != 0U; i--) {
-                const std::vector<Real>& sample =
-                    copulasRng_->nextSequence().value;
-                static_cast<const derivedRandomLM<copulaPolicy, USNG>* >(
-                    this)->nextSample(sample);
-            // alternatively make call an explicit local method...
+            const Size nChunks = numChunks();
+            // the first chunk uses the model seed, as a single generator
+            std::vector<BigNatural> seeds(nChunks, seed_);
+            MersenneTwisterUniformRng seeder(seed_);
+            for(Size iChunk=1; iChunk<nChunks; iChunk++)
+                seeds[iChunk] = seeder.nextInt32();
+
+            // number of events of each simulation, shifted by one
+            simsOffsets_.assign(nSims_+1, 0);
+            std::vector<std::vector<event_type> > chunkEvents(nChunks);
+            std::vector<std::exception_ptr> errors(nChunks);
+
+            #if !defined(QL_ENABLE_SESSIONS)
+            #pragma omp parallel for schedule(dynamic)
+            #endif
+            for(long iChunk=0; iChunk<long(nChunks); iChunk++) {
+                try {
+                    const Size first = iChunk*simsPerChunk_,
+                        last = std::min(first + simsPerChunk_, nSims_);
+                    ext::shared_ptr<copulaRNG_type> rng =
+                        detail::RandomLMSubstream<USNG>::template
+                            make<copulaRNG_type>(copula_, seed_,
+                                                 seeds[iChunk], first);
+                    std::vector<event_type>& events = chunkEvents[iChunk];
+                    for(Size iSim=first; iSim<last; iSim++) {
+                        const std::vector<Real>& sample =
+                            rng->nextSequence().value;
+                        Size before = events.size();
+                        static_cast<const derivedRandomLM<copulaPolicy,
+                            USNG>* >(this)->nextSample(sample, events);
+                        simsOffsets_[iSim+1] = events.size() - before;
+                    }
+                } catch (...) {
+                    errors[iChunk] = std::current_exception();
+                }
+            }
+            for(Size iChunk=0; iChunk<nChunks; iChunk++)
+                if(errors[iChunk])
+                    std::rethrow_exception(errors[iChunk]);
+
+            std::partial_sum(simsOffsets_.begin(), simsOffsets_.end(),
+                simsOffsets_.begin());
+            simsBuffer_.clear();
+            simsBuffer_.reserve(simsOffsets_.back());
+            for(Size iChunk=0; iChunk<nChunks; iChunk++) {
+                simsBuffer_.insert(simsBuffer_.end(),
+                    chunkEvents[iChunk].begin(), chunkEvents[iChunk].end());
+                // release the memory as we go
+                std::vector<event_type>().swap(chunkEvents[iChunk]);
             }
         }
 
-        /* Method to access simulation results and avoiding a copy of
-        each thread results buffer. PerformCalculations should have been called.
-        Here in the monothread version this method is redundant/trivial but
-        serves to detach the statistics access to the way the simulations are
+        //! Read only view of the events of a simulation in the buffer.
+        class simEvents {
+          public:
+            simEvents(const event_type* begin, Size size)
+            : begin_(begin), size_(size) {}
+            Size size() const { return size_; }
+            const event_type& operator[](Size i) const { return begin_[i]; }
+            const event_type* begin() const { return begin_; }
+            const event_type* end() const { return begin_ + size_; }
+          private:
+            const event_type* begin_;
+            Size size_;
+        };
+
+        /* Method to access simulation results without copies.
+        PerformCalculations should have been called.
+        Serves to detach the statistics access to the way the simulations are
         stored.
         */
-        const std::vector<simEvent<derivedRandomLM<copulaPolicy, USNG> > >&
-            getSim(const Size iSim) const { return simsBuffer_[iSim]; }
+        simEvents getSim(const Size iSim) const {
+            return simEvents(simsBuffer_.data() + simsOffsets_[iSim],
+                simsOffsets_[iSim+1] - simsOffsets_[iSim]);
+        }
 
         /* Allows statistics to be written generically for fixed and random
         recovery rates. */
@@ -209,6 +303,13 @@ namespace QuantLib {
       ~RandomLM() override {}
 
     private:
+        Size numChunks() const {
+            return (nSims_ + simsPerChunk_ - 1) / simsPerChunk_;
+        }
+        /* Tranched portfolio losses of each simulation at the given date,
+        computed in parallel over the buffer. */
+        void simulatedLosses(const Date& d, std::vector<Real>& losses) const;
+
         BigNatural seed_;
     protected:
         const Size numFactors_;
@@ -216,20 +317,93 @@ namespace QuantLib {
 
         const Size nSims_;
 
-        mutable std::vector<std::vector<simEvent<derivedRandomLM<copulaPolicy,
-            USNG > > > > simsBuffer_;
+        // events of all simulations, those of simulation i being in
+        //   [simsOffsets_[i], simsOffsets_[i+1])
+        mutable std::vector<simEvent<derivedRandomLM<copulaPolicy,
+            USNG > > > simsBuffer_;
+        mutable std::vector<Size> simsOffsets_;
 
         mutable copulaPolicy copula_;
-        mutable ext::shared_ptr<copulaRNG_type> copulasRng_;
 
         // Maximum time inversion horizon
         static const Size maxHorizon_ = 4050; // over 11 years
+        // Simulations per chunk; fixed, so that results do not depend on
+        //   the number of threads.
+        static const Size simsPerChunk_ = 1024;
         // Inversion probability limits are computed by children in initdates()
     };
 
 
     /* ---- Statistics ---------------------------------------------------  */
 
+    namespace detail {
+        // (day, name) pairs of default events
+        inline bool earlierDefault(
+            const std::pair<unsigned short, unsigned short>& e1,
+            const std::pair<unsigned short, unsigned short>& e2) {
+            return e1.first < e2.first;
+        }
+        inline bool sameDefaultDay(
+            const std::pair<unsigned short, unsigned short>& e1,
+            const std::pair<unsigned short, unsigned short>& e2) {
+            return e1.first == e2.first;
+        }
+    }
+
+    /* Statistics are computed in parallel over the simulation chunks; partial
+    results are reduced in chunk order, so they do not depend on the number of
+    threads either. */
+
+    template<template <class, class> class D, class C, class URNG>
+    void RandomLM<D, C, URNG>::simulatedLosses(const Date& d,
+        std::vector<Real>& losses) const
+    {
+        Date today = Settings::instance().evaluationDate();
+        Date::serial_type val = d.serialNumber() - today.serialNumber();
+
+        Real attachAmount = basket_->attachmentAmount();
+        Real detachAmount = basket_->detachmentAmount();
+
+        losses.resize(nSims_);
+        const Size nChunks = numChunks();
+        std::vector<std::exception_ptr> errors(nChunks);
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for
+        #endif
+        for(long iChunk=0; iChunk<long(nChunks); iChunk++) {
+            try {
+                const Size last =
+                    std::min((iChunk+1)*simsPerChunk_, nSims_);
+                for(Size iSim=iChunk*simsPerChunk_; iSim < last; iSim++) {
+                    const simEvents events = getSim(iSim);
+                    Real portfSimLoss=0.;
+                    for(Size iEvt=0; iEvt < events.size(); iEvt++) {
+                        // if event is within time horizon...
+                        if(val > static_cast<Date::serial_type>(
+                               events[iEvt].dayFromRef)) {
+                            Size iName = events[iEvt].nameIdx;
+                            // ...and is contained in the basket.
+                  //if(basket_->pool()->has(copula_->pool()->names()[iName]))
+                            portfSimLoss +=
+                                basket_->exposure(basket_->names()[iName],
+                                    Date(events[iEvt].dayFromRef +
+                                        today.serialNumber())) *
+                                    (1.-getEventRecovery(events[iEvt]));
+                        }
+                    }
+                    losses[iSim] =
+                        std::min(std::max(portfSimLoss - attachAmount, 0.),
+                            detachAmount - attachAmount);
+                }
+            } catch (...) {
+                errors[iChunk] = std::current_exception();
+            }
+        }
+        for(Size iChunk=0; iChunk<nChunks; iChunk++)
+            if(errors[iChunk])
+                std::rethrow_exception(errors[iChunk]);
+    }
+
     template<template <class, class> class D, class C, class URNG>
     Probability RandomLM<D, C, URNG>::probAtLeastNEvents(Size n,
         const Date& d) const
@@ -243,17 +417,24 @@ namespace QuantLib {
 
         if(n==0) return 1.;
 
-        Real counts = 0.;
-        for(Size iSim=0; iSim < nSims_; iSim++) {
-            Size simCount = 0;
-            const std::vector<simEvent<D<C, URNG> > >& events =
-                getSim(iSim);
-            for(Size iEvt=0; iEvt < events.size(); iEvt++)
-                // duck type on the members:
-                if(val > events[iEvt].dayFromRef) simCount++;
-            if(simCount >= n) counts++;
+        const Size nChunks = numChunks();
+        std::vector<Size> counts(nChunks, 0);
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for
+        #endif
+        for(long iChunk=0; iChunk<long(nChunks); iChunk++) {
+            const Size last = std::min((iChunk+1)*simsPerChunk_, nSims_);
+            for(Size iSim=iChunk*simsPerChunk_; iSim < last; iSim++) {
+                Size simCount = 0;
+                const simEvents events = getSim(iSim);
+                for(Size iEvt=0; iEvt < events.size(); iEvt++)
+                    // duck type on the members:
+                    if(val > events[iEvt].dayFromRef) simCount++;
+                if(simCount >= n) counts[iChunk]++;
+            }
         }
-        return counts/nSims_;
+        return Real(std::accumulate(counts.begin(), counts.end(), Size(0)))
+            / nSims_;
         // \todo Provide confidence interval
     }
 
@@ -272,27 +453,51 @@ namespace QuantLib {
         // casted to natural to avoid warning, we have just checked the sign
         Natural val = d.serialNumber() - today.serialNumber();
 
-        std::vector<Probability> hitsByDate(basketSize, 0.);
-        for(Size iSim=0; iSim < nSims_; iSim++) {
-            const std::vector<simEvent<D<C, URNG> > >& events = getSim(iSim);
-            std::map<unsigned short, unsigned short> namesDefaulting;
-            for(Size iEvt=0; iEvt < events.size(); iEvt++) {
-                // if event is within time horizon...
-                if(val > events[iEvt].dayFromRef)
-                    //...count it. notice insertion sorts by date.
-                    namesDefaulting.insert(std::make_pair<unsigned short,
-                      unsigned short>(events[iEvt].dayFromRef,
-                        events[iEvt].nameIdx));
-            }
-            if(namesDefaulting.size() >= n) {
-                std::map<unsigned short, unsigned short>::const_iterator
-                    itdefs = namesDefaulting.begin();
-                // locate nth default in time:
-                std::advance(itdefs, n-1);
-                // update statistic:
-                hitsByDate[itdefs->second]++;
+        const Size nChunks = numChunks();
+        std::vector<std::vector<Size> > chunkHits(nChunks,
+            std::vector<Size>(basketSize, 0));
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for
+        #endif
+        for(long iChunk=0; iChunk<long(nChunks); iChunk++) {
+            std::vector<Size>& hits = chunkHits[iChunk];
+            // (day, name) pairs of the events within the time horizon
+            std::vector<std::pair<unsigned short, unsigned short> >
+                namesDefaulting;
+            const Size last = std::min((iChunk+1)*simsPerChunk_, nSims_);
+            for(Size iSim=iChunk*simsPerChunk_; iSim < last; iSim++) {
+                const simEvents events = getSim(iSim);
+                namesDefaulting.clear();
+                for(Size iEvt=0; iEvt < events.size(); iEvt++) {
+                    // if event is within time horizon...
+                    if(val > events[iEvt].dayFromRef)
+                        //...count it.
+                        namesDefaulting.push_back(std::make_pair(
+                            static_cast<unsigned short>(
+                                events[iEvt].dayFromRef),
+                            static_cast<unsigned short>(
+                                events[iEvt].nameIdx)));
+                }
+                if(namesDefaulting.size() >= n) {
+                    /* locate nth default in time; as in a map keyed by date
+                    the first event of the day is kept for simultaneous ones*/
+                    std::stable_sort(namesDefaulting.begin(),
+                        namesDefaulting.end(), detail::earlierDefault);
+                    std::vector<std::pair<unsigned short, unsigned short> >
+                        ::iterator lastDefault = std::unique(
+                            namesDefaulting.begin(), namesDefaulting.end(),
+                            detail::sameDefaultDay);
+                    if(Size(lastDefault - namesDefaulting.begin()) >= n)
+                        // update statistic:
+                        hits[namesDefaulting[n-1].second]++;
+                }
             }
         }
+
+        std::vector<Probability> hitsByDate(basketSize, 0.);
+        for(Size iChunk=0; iChunk<nChunks; iChunk++)
+            for(Size iName=0; iName<basketSize; iName++)
+                hitsByDate[iName] += chunkHits[iChunk][iName];
         std::transform(hitsByDate.begin(), hitsByDate.end(),
                        hitsByDate.begin(),
                        divide_by<Real>(Real(nSims_)));
@@ -313,27 +518,38 @@ namespace QuantLib {
         // casted to natural to avoid warning, we have just checked the sign
         Natural val = d.serialNumber() - today.serialNumber();
 
-        Real expectedDefiDefj = 0.;// E[1_i 1_j]
+        // E[1_i 1_j], E[1_i] and E[1_j] for each chunk;
         // the rest of magnitudes have known values (probabilities) but that
         //   would distort the simulation results.
-        Real expectedDefi = 0.;
-        Real expectedDefj = 0.;
-        for(Size iSim=0; iSim < nSims_; iSim++) {
-            const std::vector<simEvent<D<C, URNG> > >& events = getSim(iSim);
-            Real imatch = 0., jmatch = 0.;
-            for(Size iEvt=0; iEvt < events.size(); iEvt++) {
-                if((val > events[iEvt].dayFromRef) &&
-                   (events[iEvt].nameIdx == iName)) imatch = 1.;
-                if((val > events[iEvt].dayFromRef) &&
-                   (events[iEvt].nameIdx == jName)) jmatch = 1.;
+        const Size nChunks = numChunks();
+        std::vector<Array> chunkSums(nChunks, Array(3, 0.));
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for
+        #endif
+        for(long iChunk=0; iChunk<long(nChunks); iChunk++) {
+            Array& sums = chunkSums[iChunk];
+            const Size last = std::min((iChunk+1)*simsPerChunk_, nSims_);
+            for(Size iSim=iChunk*simsPerChunk_; iSim < last; iSim++) {
+                const simEvents events = getSim(iSim);
+                Real imatch = 0., jmatch = 0.;
+                for(Size iEvt=0; iEvt < events.size(); iEvt++) {
+                    if((val > events[iEvt].dayFromRef) &&
+                       (events[iEvt].nameIdx == iName)) imatch = 1.;
+                    if((val > events[iEvt].dayFromRef) &&
+                       (events[iEvt].nameIdx == jName)) jmatch = 1.;
+                }
+                sums[0] += imatch * jmatch;
+                sums[1] += imatch;
+                sums[2] += jmatch;
             }
-            expectedDefiDefj += imatch * jmatch;
-            expectedDefi += imatch;
-            expectedDefj += jmatch;
         }
-        expectedDefiDefj = expectedDefiDefj / (nSims_-1);// unbiased
-        expectedDefi = expectedDefi / nSims_;
-        expectedDefj = expectedDefj / nSims_;
+        Array sums(3, 0.);
+        for(Size iChunk=0; iChunk<nChunks; iChunk++)
+            sums += chunkSums[iChunk];
+
+        Real expectedDefiDefj = sums[0] / (nSims_-1);// unbiased
+        Real expectedDefi = sums[1] / nSims_;
+        Real expectedDefj = sums[2] / nSims_;
 
         return (expectedDefiDefj - expectedDefi*expectedDefj) /
             std::sqrt((expectedDefi*expectedDefj*(1.-expectedDefi)
@@ -354,35 +570,11 @@ namespace QuantLib {
         const Date& d, Probability confidencePerc) const
     {
         calculate();
-        Date today = Settings::instance().evaluationDate();
-        Date::serial_type val = d.serialNumber() - today.serialNumber();
-
-        Real attachAmount = basket_->attachmentAmount();
-        Real detachAmount = basket_->detachmentAmount();
 
-        // Real trancheLoss= 0.;
+        std::vector<Real> losses;
+        simulatedLosses(d, losses);
         GeneralStatistics lossStats;
-        for(Size iSim=0; iSim < nSims_; iSim++) {
-            const std::vector<simEvent<D<C, URNG> > >& events = getSim(iSim);
-
-            Real portfSimLoss=0.;
-            for(Size iEvt=0; iEvt < events.size(); iEvt++) {
-                // if event is within time horizon...
-                if(val > static_cast<Date::serial_type>(
-					   events[iEvt].dayFromRef)) {
-                    Size iName = events[iEvt].nameIdx;
-                    // ...and is contained in the basket.
-                        portfSimLoss +=
-                            basket_->exposure(basket_->names()[iName],
-                                Date(events[iEvt].dayFromRef +
-                                    today.serialNumber())) *
-                                        (1.-getEventRecovery(events[iEvt]));
-               }
-            }
-            lossStats.add(// d  ates? current losses? realized defaults, not yet
-                std::min(std::max(portfSimLoss - attachAmount, 0.),
-                    detachAmount - attachAmount) );
-        }
+        lossStats.addSequence(losses.begin(), losses.end());
         return std::make_pair(lossStats.mean(), lossStats.errorEstimate() *
             InverseCumulativeNormal::standard_value(0.5*(1.+confidencePerc)));
     }
@@ -408,40 +600,14 @@ namespace QuantLib {
 
     template<template <class, class> class D, class C, class URNG>
     Histogram RandomLM<D, C, URNG>::computeHistogram(const Date& d) const {
-        std::vector<Real> data;
-        std::set<Real> keys;// attainable loss values
-        keys.insert(0.);
         Date today = Settings::instance().evaluationDate();
-        Date::serial_type val = d.serialNumber() - today.serialNumber();
         // redundant test? should have been tested by the basket caller?
         QL_REQUIRE(d >= today,
             "Requested percentile date must lie after computation date.");
         calculate();
 
-        Real attachAmount = basket_->attachmentAmount();
-        Real detachAmount = basket_->detachmentAmount();
-
-        for(Size iSim=0; iSim < nSims_; iSim++) {
-            const std::vector<simEvent<D<C, URNG> > >& events = getSim(iSim);
-
-            Real portfSimLoss=0.;
-            for(Size iEvt=0; iEvt < events.size(); iEvt++) {
-                if(val > static_cast<Date::serial_type>(
-					 events[iEvt].dayFromRef)) {
-                    Size iName = events[iEvt].nameIdx;
-          // test needed (here and the others) to reuse simulations:
-          //          if(basket_->pool()->has(copula_->pool()->names()[iName]))
-                        portfSimLoss +=
-                            basket_->exposure(basket_->names()[iName],
-                                Date(events[iEvt].dayFromRef +
-                                    today.serialNumber())) *
-                                        (1.-getEventRecovery(events[iEvt]));
-                }
-            }
-            data.push_back(std::min(std::max(portfSimLoss - attachAmount, 0.),
-                detachAmount - attachAmount));
-            keys.insert(data.back());
-        }
+        std::vector<Real> data;
+        simulatedLosses(d, data);
         // avoid using as many points as in the simulation.
         Size nPts = std::min<Size>(data.size(), 150);// fix
         return Histogram(data.begin(), data.end(), nPts);
@@ -457,34 +623,11 @@ namespace QuantLib {
             "Requested percentile date must lie after computation date.");
         calculate();
 
-        Real attachAmount = basket_->attachmentAmount();
-        Real detachAmount = basket_->detachmentAmount();
-
         Date::serial_type val = d.serialNumber() - today.serialNumber();
         if(val <= 0) return 0.;// plus basket realized losses
 
-        //GenericRiskStatistics<GeneralStatistics> statsX;
         std::vector<Real> losses;
-        for(Size iSim=0; iSim < nSims_; iSim++) {
-            const std::vector<simEvent<D<C, URNG> > >& events = getSim(iSim);
-            Real portfSimLoss=0.;
-            for(Size iEvt=0; iEvt < events.size(); iEvt++) {
-                if(val > static_cast<Date::serial_type>(
-					  events[iEvt].dayFromRef)) {
-                    Size iName = events[iEvt].nameIdx;
-                    // ...and is contained in the basket.
-                    //if(basket_->pool()->has(copula_->pool()->names()[iName]))
-                        portfSimLoss +=
-                            basket_->exposure(basket_->names()[iName],
-                                Date(events[iEvt].dayFromRef +
-                                    today.serialNumber())) *
-                                        (1.-getEventRecovery(events[iEvt]));
-                }
-            }
-            portfSimLoss = std::min(std::max(portfSimLoss - attachAmount, 0.),
-                detachAmount - attachAmount);
-            losses.push_back(portfSimLoss);
-        }
+        simulatedLosses(d, losses);
 
         std::sort(losses.begin(), losses.end());
         Real posit = std::ceil(percent * nSims_);
@@ -552,32 +695,8 @@ namespace QuantLib {
             "Incorrect percentile");
         calculate();
 
-        Real attachAmount = basket_->attachmentAmount();
-        Real detachAmount = basket_->detachmentAmount();
-
         std::vector<Real> rankLosses;
-        Date today = Settings::instance().evaluationDate();
-        Date::serial_type val = d.serialNumber() - today.serialNumber();
-        for(Size iSim=0; iSim < nSims_; iSim++) {
-            const std::vector<simEvent<D<C, URNG> > >& events = getSim(iSim);
-            Real portfSimLoss=0.;
-            for(Size iEvt=0; iEvt < events.size(); iEvt++) {
-                if(val > static_cast<Date::serial_type>(
-					 events[iEvt].dayFromRef)) {
-                    Size iName = events[iEvt].nameIdx;
-                 //   if(basket_->pool()->has(copula_->pool()->names()[iName]))
-                        portfSimLoss +=
-                            basket_->exposure(basket_->names()[iName],
-                                Date(events[iEvt].dayFromRef +
-                                    today.serialNumber())) *
-                                        (1.-getEventRecovery(events[iEvt]));
-                }
-            }
-            portfSimLoss = std::min(std::max(portfSimLoss - attachAmount, 0.),
-                detachAmount - attachAmount);
-            // update dataset for rank stat:
-            rankLosses.push_back(portfSimLoss);
-        }
+        simulatedLosses(d, rankLosses);
 
         std::sort(rankLosses.begin(), rankLosses.end());
         Size quantilePosition = static_cast<Size>(floor(nSims_*percentile));
@@ -640,7 +759,6 @@ namespace QuantLib {
     }
 
 
-    // parallelize this one(if possible), it is really expensive
     template<template <class, class> class D, class C, class URNG>
     /* FIX ME: some trouble on limit cases, like zero loss or no losses over the
     requested level.*/
@@ -656,71 +774,97 @@ namespace QuantLib {
         Real detachAmount = basket_->detachmentAmount();
         Size numLiveNames = basket_->remainingSize();
 
-        std::vector<Real> split(numLiveNames, 0.);
-        std::vector<GeneralStatistics> splitStats(numLiveNames,
-            GeneralStatistics());
         Date today = Settings::instance().evaluationDate();
         Date::serial_type val = date.serialNumber() - today.serialNumber();
 
-        for(Size iSim=0; iSim < nSims_; iSim++) {
-            const std::vector<simEvent<D<C, URNG> > >& events = getSim(iSim);
-            Real portfSimLoss=0.;
-            //std::vector<Real> splitBuffer(numLiveNames_, 0.);
+        /* Each chunk stores the relative splits of its simulations over the
+        requested level, numLiveNames values per simulation; they are added to
+        the statistics in simulation order. */
+        const Size nChunks = numChunks();
+        std::vector<std::vector<Real> > chunkSplits(nChunks);
+        std::vector<std::exception_ptr> errors(nChunks);
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for schedule(dynamic)
+        #endif
+        for(long iChunk=0; iChunk<long(nChunks); iChunk++) {
+          try {
+            std::vector<Real> split(numLiveNames, 0.);
             std::vector<simEvent<D<C, URNG> > > splitEventsBuffer;
-
-            for(Size iEvt=0; iEvt < events.size(); iEvt++) {
-                if(val > static_cast<Date::serial_type>(
-					 events[iEvt].dayFromRef)) {
-                    Size iName = events[iEvt].nameIdx;
+            const Size last = std::min((iChunk+1)*simsPerChunk_, nSims_);
+            for(Size iSim=iChunk*simsPerChunk_; iSim < last; iSim++) {
+                const simEvents events = getSim(iSim);
+                Real portfSimLoss=0.;
+                splitEventsBuffer.clear();
+
+                for(Size iEvt=0; iEvt < events.size(); iEvt++) {
+                    if(val > static_cast<Date::serial_type>(
+                           events[iEvt].dayFromRef)) {
+                        Size iName = events[iEvt].nameIdx;
                 // if(basket_->pool()->has(copula_->pool()->names()[iName])) {
-                        portfSimLoss +=
-                            basket_->exposure(basket_->names()[iName],
-                                Date(events[iEvt].dayFromRef +
-                                    today.serialNumber())) *
-                                        (1.-getEventRecovery(events[iEvt]));
-                        //and will sort later if buffer applies:
-                        splitEventsBuffer.push_back(events[iEvt]);
+                            portfSimLoss +=
+                                basket_->exposure(basket_->names()[iName],
+                                    Date(events[iEvt].dayFromRef +
+                                        today.serialNumber())) *
+                                    (1.-getEventRecovery(events[iEvt]));
+                            //and will sort later if buffer applies:
+                            splitEventsBuffer.push_back(events[iEvt]);
+                    }
                 }
-            }
-            portfSimLoss = std::min(std::max(portfSimLoss - attachAmount, 0.),
-                detachAmount - attachAmount);
-
-            /* second pass; split is conditional to total losses within target
-            losses/percentile:  */
-            Real ptflCumulLoss = 0.;
-            if(portfSimLoss > loss) {
-                std::sort(splitEventsBuffer.begin(), splitEventsBuffer.end());
-                //NOW THIS:
-                split.assign(numLiveNames, 0.);
-                /*  if the name triggered a loss in the portf limits assign
-                this loss to that name..  */
-                for(Size i=0; i<splitEventsBuffer.size(); i++) {
-                    Size iName = splitEventsBuffer[i].nameIdx;
-                    Real lossName =
+                portfSimLoss =
+                    std::min(std::max(portfSimLoss - attachAmount, 0.),
+                        detachAmount - attachAmount);
+
+                /* second pass; split is conditional to total losses within
+                target losses/percentile:  */
+                Real ptflCumulLoss = 0.;
+                if(portfSimLoss > loss) {
+                    std::sort(splitEventsBuffer.begin(),
+                        splitEventsBuffer.end());
+                    split.assign(numLiveNames, 0.);
+                    /*  if the name triggered a loss in the portf limits assign
+                    this loss to that name..  */
+                    for(Size i=0; i<splitEventsBuffer.size(); i++) {
+                        Size iName = splitEventsBuffer[i].nameIdx;
+                        Real lossName =
             // allows amortizing (others should be like this)
             // basket_->remainingNotionals(Date(simsBuffer_[i].dayFromRef +
             //      today.serialNumber()))[iName] *
-                        basket_->exposure(basket_->names()[iName],
-                            Date(splitEventsBuffer[i].dayFromRef +
-                                today.serialNumber())) *
+                            basket_->exposure(basket_->names()[iName],
+                                Date(splitEventsBuffer[i].dayFromRef +
+                                    today.serialNumber())) *
                                 (1.-getEventRecovery(splitEventsBuffer[i]));
 
-                    Real tranchedLossBefore =
-                        std::min(std::max(ptflCumulLoss - attachAmount, 0.),
-                        detachAmount - attachAmount);
-                    ptflCumulLoss += lossName;
-                    Real tranchedLossAfter =
-                        std::min(std::max(ptflCumulLoss - attachAmount, 0.),
-                        detachAmount - attachAmount);
-                    // assign new losses:
-                    split[iName] += tranchedLossAfter - tranchedLossBefore;
-                }
-                for(Size iName=0; iName<numLiveNames; iName++) {
-                    splitStats[iName].add(split[iName] /
-                        std::min(std::max(ptflCumulLoss - attachAmount, 0.),
-                            detachAmount - attachAmount) );
+                        Real tranchedLossBefore =
+                            std::min(std::max(ptflCumulLoss - attachAmount,
+                                0.), detachAmount - attachAmount);
+                        ptflCumulLoss += lossName;
+                        Real tranchedLossAfter =
+                            std::min(std::max(ptflCumulLoss - attachAmount,
+                                0.), detachAmount - attachAmount);
+                        // assign new losses:
+                        split[iName] += tranchedLossAfter - tranchedLossBefore;
+                    }
+                    for(Size iName=0; iName<numLiveNames; iName++) {
+                        chunkSplits[iChunk].push_back(split[iName] /
+                            std::min(std::max(ptflCumulLoss - attachAmount,
+                                0.), detachAmount - attachAmount) );
+                    }
                 }
             }
+          } catch (...) {
+            errors[iChunk] = std::current_exception();
+          }
+        }
+        for(Size iChunk=0; iChunk<nChunks; iChunk++)
+            if(errors[iChunk])
+                std::rethrow_exception(errors[iChunk]);
+
+        std::vector<GeneralStatistics> splitStats(numLiveNames,
+            GeneralStatistics());
+        for(Size iChunk=0; iChunk<nChunks; iChunk++) {
+            const std::vector<Real>& splits = chunkSplits[iChunk];
+            for(Size i=0; i<splits.size(); i++)
+                splitStats[i % numLiveNames].add(splits[i]);
         }
 
         // Compute error in VaR split
@@ -744,6 +888,7 @@ namespace QuantLib {
 
 
 
+
     // --------- Time inversion solver target function: -----------------------
 
     /* It could be argued that this concept is part of the copula (more generic)
@@ -871,7 +1016,8 @@ namespace QuantLib {
         */
         friend class RandomLM< ::QuantLib::RandomDefaultLM, copulaPolicy, USNG>;
     protected:
-        void nextSample(const std::vector<Real>& values) const;
+        void nextSample(const std::vector<Real>& values,
+                        std::vector<defaultSimEvent>& events) const;
         void initDates() const {
             /* Precalculate horizon time default probabilities (used to
               determine if the default took place and subsequently compute its
@@ -930,11 +1076,10 @@ namespace QuantLib {
 
     template<class C, class URNG>
     void RandomDefaultLM<C, URNG>::nextSample(
-        const std::vector<Real>& values) const
+        const std::vector<Real>& values,
+        std::vector<defaultSimEvent>& events) const
     {
         const ext::shared_ptr<Pool>& pool = this->basket_->pool();
-        // starts with no events
-        this->simsBuffer_.push_back(std::vector<defaultSimEvent> ());
 
         for(Size iName=0; iName<model_->size(); iName++) {
             Real latentVarSample =
@@ -962,8 +1107,7 @@ namespace QuantLib {
                                         std::log(1.-simDefaultProb)
                     /std::log(1.-data_.horizonDefaultPs_[iName])));
                    */
-                this->simsBuffer_.back().push_back(defaultSimEvent(iName,
-                    dateSTride));
+                events.push_back(defaultSimEvent(iName, dateSTride));
                //emplace_back
             }
         /* Used to remove sims with no events. Uses less memory, faster
@@ -977,7 +1121,7 @@ namespace QuantLib {
 
 
 
-    // Common usage typedefs (notice they vary in the multithread version)
+    // Common usage typedefs
     // ---------- Gaussian default generators options ------------------------
     /* Uses copula direct normal inversion and MT generator
     typedef RandomDefaultLM<GaussianCopulaPolicy,
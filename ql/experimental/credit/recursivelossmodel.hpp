@@ -24,6 +24,7 @@
 #include <ql/experimental/credit/defaultlossmodel.hpp>
 #include <ql/functional.hpp>
 #include <map>
+#include <vector>
 #include <algorithm>
 
 namespace QuantLib {
@@ -37,6 +38,15 @@ namespace QuantLib {
         Notice that using copulas other than Gaussian it is only an
         approximation (see remark on p.68).
 
+        When the latent model integrates on a fixed set of nodes (as the
+        Gaussian quadrature does) the expected tranche losses and the loss
+        probabilities are integrated in a single pass: the default
+        thresholds are inverted once per name and date, the conditional
+        default probabilities of all names are computed on all nodes as a
+        dense matrix and the recursion runs on a dense vector of losses,
+        in parallel over the nodes. Adaptive integrations fall back to
+        integrating the conditional magnitudes node by node.
+
         \todo Make the loss unit equal to some small fraction depending on the
         portfolio loss weights (notionals and recoveries). As it is now this
         is ok for pricing but not for risk metrics. See the discussion in O'Kane
@@ -76,6 +86,14 @@ namespace QuantLib {
       Real expectedConditionalLossInvP(const std::vector<Real>& pDefDate,
                                        // const Date& date,
                                        const std::vector<Real>& mktFactor) const;
+      /* Dense version of the recursion, on all the losses multiple of the
+      loss unit, for the conditional default probabilities of the names
+      on a given node.
+      */
+      void conditionalLossDistribDense(const Probability* pDef,
+                                       std::vector<Probability>& distrib) const;
+      Disposable<std::vector<Real> > inverseProbabilities(
+                                                    const Date& date) const;
     protected:
       void resetModel() override;
 
@@ -123,6 +141,12 @@ namespace QuantLib {
             notional_;
         mutable Size remainingBsktSize_;
         mutable std::vector<Real> notionals_;
+        // integration nodes and weights (density included) of the latent
+        //   model; empty if the integration is adaptive.
+        mutable std::vector<std::vector<Real> > nodes_;
+        mutable std::vector<Real> nodeWeights_;
+        // whether each multiple of the loss unit is an attainable loss
+        mutable std::vector<bool> attainable_;
     };
 
 
@@ -172,12 +196,33 @@ namespace QuantLib {
 /**/
         using namespace ext::placeholders;
 
-        std::vector<Probability> uncDefProb = 
-            basket_->remainingProbabilities(date);
-        std::vector<Real> invProb;
-        for(Size i=0; i<uncDefProb.size(); ++i)
-           invProb.push_back(copula_->inverseCumulativeY(uncDefProb[i], i));
-           ///  invProb.push_back(CP::inverseCumulativeY(uncDefProb[i], i));//<-static call
+        std::vector<Real> invProb = inverseProbabilities(date);
+        if(!nodes_.empty()) {
+            std::vector<Probability> pDef;
+            copula_->conditionalDefaultProbabilitiesInvP(invProb, nodes_,
+                pDef);
+            std::vector<Real> condLosses(nodes_.size());
+            #if !defined(QL_ENABLE_SESSIONS)
+            #pragma omp parallel for
+            #endif
+            for(long k=0; k<long(nodes_.size()); ++k) {
+                std::vector<Probability> distrib;
+                conditionalLossDistribDense(&pDef[k*remainingBsktSize_],
+                    distrib);
+                Real expLoss = 0.;
+                for(Size l=0; l<distrib.size(); ++l) {
+                    Real loss = std::min(std::max(l * lossUnit_ 
+                        - attachAmount_, 0.), detachAmount_ - attachAmount_);
+                    expLoss += loss * distrib[l];
+                }
+                condLosses[k] = expLoss;
+            }
+            // reduced in node order, independently of the threads
+            Real expLoss = 0.;
+            for(Size k=0; k<nodes_.size(); ++k)
+                expLoss += nodeWeights_[k] * condLosses[k];
+            return expLoss;
+        }
         return copula_->integratedExpectedValue(
             ext::function<Real (const std::vector<Real>& v1)>(
                 ext::bind(
@@ -196,6 +241,28 @@ namespace QuantLib {
 
         using namespace ext::placeholders;
 
+        if(!nodes_.empty()) {
+            std::vector<Probability> pDef;
+            copula_->conditionalDefaultProbabilitiesInvP(
+                inverseProbabilities(date), nodes_, pDef);
+            std::vector<std::vector<Probability> > distribs(nodes_.size());
+            #if !defined(QL_ENABLE_SESSIONS)
+            #pragma omp parallel for
+            #endif
+            for(long k=0; k<long(nodes_.size()); ++k)
+                conditionalLossDistribDense(&pDef[k*remainingBsktSize_],
+                    distribs[k]);
+            // only attainable losses, as in the map based recursion
+            std::vector<Real> results;
+            for(Size l=0; l<attainable_.size(); ++l) {
+                if(!attainable_[l]) continue;
+                Probability prob = 0.;
+                for(Size k=0; k<nodes_.size(); ++k)
+                    prob += nodeWeights_[k] * distribs[k][l];
+                results.push_back(prob);
+            }
+            return results;
+        }
         std::vector<Probability> uncDefProb = 
             basket_->remainingProbabilities(date);
         return copula_->integratedExpectedValue(
@@ -231,8 +298,56 @@ namespace QuantLib {
         lgds.erase(std::remove(lgds.begin(), lgds.end(), 0.), lgds.end());
         lossUnit_ = *(std::min_element(lgds.begin(), lgds.end()))
             / nBuckets_;
+        wk_.clear();
         for(Size i=0; i<remainingBsktSize_; ++i)
             wk_.push_back(std::floor(lgdsTmp[i]/lossUnit_ + .5));
+
+        // attainable losses, for the dense recursion
+        attainable_.assign(1, true);
+        for(Size i=0; i<remainingBsktSize_; ++i) {
+            Size w = static_cast<Size>(wk_[i]);
+            Size top = attainable_.size();
+            attainable_.resize(top + w, false);
+            for(Size l=top; l-- > 0 && w > 0;)
+                if(attainable_[l]) attainable_[l + w] = true;
+        }
+        if(!copula_->integrationNodes(nodes_, nodeWeights_)) {
+            nodes_.clear();
+            nodeWeights_.clear();
+        }
+    }
+
+    template<class CP>
+    Disposable<std::vector<Real> >
+    RecursiveLossModel<CP>::inverseProbabilities(const Date& date) const {
+        // default thresholds, inverted once per name
+        std::vector<Probability> uncDefProb = 
+            basket_->remainingProbabilities(date);
+        std::vector<Real> invProb;
+        for(Size i=0; i<uncDefProb.size(); ++i)
+           invProb.push_back(copula_->inverseCumulativeY(uncDefProb[i], i));
+        return invProb;
+    }
+
+    template<class CP>
+    void RecursiveLossModel<CP>::conditionalLossDistribDense(
+        const Probability* pDef, std::vector<Probability>& distrib) const
+    {
+        // same recursion as below, eq. 10 p.68, updating in place from the
+        //   top loss down
+        distrib.assign(attainable_.size(), 0.);
+        distrib[0] = 1.;
+        Size top = 0;
+        for(Size iName=0; iName<remainingBsktSize_; ++iName) {
+            Size w = static_cast<Size>(wk_[iName]);
+            if(w == 0) continue;
+            Probability p = pDef[iName];
+            for(Size l=top+1; l-- > 0;) {
+                distrib[l + w] += distrib[l] * p;
+                distrib[l] *= 1. - p;
+            }
+            top += w;
+        }
     }
 
     // make it return a distribution object?
@@ -62,9 +62,11 @@ namespace QuantLib {
                 //Assign X=lb+(ub-lb)*random
                 x[j] = lX_[j] + bounds[j] * sample[j];
             }
-            //Evaluate point
-            values_.push_back(std::make_pair(P.value(x), i));
         }
+        //Evaluate all points at once
+        const Array values = P.batchValue(x_);
+        for (Size i = 0; i < M_; i++)
+            values_.push_back(std::make_pair(values[i], i));
 
         //init intensity & randomWalk
         intensity_->init(this);
@@ -171,30 +173,39 @@ namespace QuantLib {
                 //Prepare random walk
                 randomWalk_->walk();
 
-                //Loop over particles
+                //Loop over particles; the moves only depend on the
+                //current positions, so they can be evaluated at once
+                std::vector<Array> zs(Mfa_, Array(N_, 0.0));
                 for (Size i = 0; i < Mfa_; i++) {
                     Size index = values_[i].second;
                     Array& x   = x_[index];
                     Array& xI  = xI_[index];
                     Array& xRW = xRW_[index];
+                    Array& zi  = zs[i];
 
                     //Loop over dimensions
                     for (Size j = 0; j < N_; j++) {
                         //Update position
-                        z[j] = x[j] + xI[j] + xRW[j];
+                        zi[j] = x[j] + xI[j] + xRW[j];
                         //Enforce bounds on positions
-                        if (z[j] < lX_[j]) {
-                            z[j] = lX_[j];
+                        if (zi[j] < lX_[j]) {
+                            zi[j] = lX_[j];
                         }
-                        else if (z[j] > uX_[j]) {
-                            z[j] = uX_[j];
+                        else if (zi[j] > uX_[j]) {
+                            zi[j] = uX_[j];
                         }
                     }
-                    Real val = P.value(z);
+                }
+                const Array vals = P.batchValue(zs);
+
+                for (Size i = 0; i < Mfa_; i++) {
+                    Size index = values_[i].second;
+                    Array& x   = x_[index];
+                    Real val = vals[i];
                     if(!boost::math::isnan(val))
 					{
 						//Accept new point
-                        x = z;
+                        x = zs[i];
                         values_[index].first = val;
                         //mark best
                         if (val < bestValue) {
@@ -86,6 +86,15 @@ namespace QuantLib {
             const std::vector<Real>& arg)>& f) const {
             QL_FAIL("No vector integration provided");
         }
+        /* Nodes and weights of integrators working on a fixed set of
+        points, so that the integral of f is sum_k weights[k]*f(nodes[k]);
+        this allows integrating many functions at once. Adaptive integrators
+        return false.
+        */
+        virtual bool quadratureNodes(std::vector<std::vector<Real> >&,
+                                     std::vector<Real>&) const {
+            return false;
+        }
         virtual ~LMIntegration() {}
     };
 
@@ -130,6 +139,25 @@ namespace QuantLib {
             const override {
             return GaussianQuadMultidimIntegrator::integrate<Disposable<std::vector<Real> > >(f);
         }
+        // tensor product of the one-dimensional quadrature
+        bool quadratureNodes(std::vector<std::vector<Real> >& nodes,
+                             std::vector<Real>& weights) const override {
+            const Array& x = GaussianQuadMultidimIntegrator::x();
+            const Array& w = GaussianQuadMultidimIntegrator::weights();
+            const Size n = x.size(), dim = dimension();
+            Size size = 1;
+            for(Size i=0; i<dim; i++)
+                size *= n;
+            nodes.assign(size, std::vector<Real>(dim));
+            weights.assign(size, 1.);
+            for(Size k=0; k<size; k++) {
+                for(Size i=0, index=k; i<dim; i++, index /= n) {
+                    nodes[k][i] = x[index % n];
+                    weights[k] *= w[index % n];
+                }
+            }
+            return true;
+        }
         ~IntegrationBase() override {}
     };
 
@@ -437,6 +465,13 @@ namespace QuantLib {
                 x_.value = copula_.allFactorCumulInverter(sample.value);
                 return x_;
             }
+            /*! Moves the underlying sequence to the given draw, for the
+            generators supporting it (e.g. SobolRsg); used to split a
+            simulation in independent chunks.
+             */
+            void skipTo(BigNatural n) {
+                sequenceGen_.skipTo(n);
+            }
         private:
             USNG sequenceGen_;// copy, we might be mutithreaded
             mutable sample_type x_;
@@ -614,6 +649,21 @@ namespace QuantLib {
                                   ext::placeholders::_1),
                         ext::bind(ext::cref(f), ext::placeholders::_1)));
         }
+        /*! Provides the nodes of the factor space and the weights, density
+         included, of the integration algorithm, so that the expected value
+         of a function f is \f$ \sum_k w_k f(m_k) \f$. Returns false if
+         the algorithm does not work on a fixed set of nodes.
+         Models integrating many functions at once (e.g. for all names
+         in a basket) can use these to avoid the per-node function calls.
+        */
+        bool integrationNodes(std::vector<std::vector<Real> >& nodes,
+                              std::vector<Real>& weights) const {
+            if(!integration()->quadratureNodes(nodes, weights))
+                return false;
+            for(Size k=0; k<nodes.size(); k++)
+                weights[k] *= copula_.density(nodes[k]);
+            return true;
+        }
     protected:
         // Integrable models must provide their integrator.
         // Arguable, not having the integration in the LM class saves that 
@@ -92,6 +92,12 @@ namespace QuantLib {
             Real mu = 0.);
         //! Integration quadrature order.
         Size order() const {return integralV_.order();}
+        //! Number of dimensions of the integration domain.
+        Size dimension() const {return dimension_;}
+        //! Nodes of the one-dimensional quadrature.
+        const Array& x() const {return integral_.x();}
+        //! Weights of the one-dimensional quadrature.
+        const Array& weights() const {return integral_.weights();}
 
         //! Integrates function f over \f$ R^{dim} \f$
         /* This function is just syntax since the only thing it does is calling 
@@ -80,10 +80,11 @@ namespace QuantLib {
                 //Assign V=(ub-lb)*2*random-(ub-lb) -> between (lb-ub) and (ub-lb)
                 v[j] = bounds[j] * (2.0*sample[2 * j + 1] - 1.0);
             }
-            //Evaluate X and assign as personal best
+            //Assign X as personal best
             pBX_.push_back(X_.back());
-            pBF_[i] = P.value(X_.back());
         }
+        //Evaluate all particles at once
+        pBF_ = P.batchValue(X_);
 
         //init topology & inertia
         topology_->init(this);
@@ -148,8 +149,15 @@ namespace QuantLib {
                         v[j] = 0.0;
                     }
                 }
-                //Evaluate x
-                Real f = P.value(x);
+            }
+
+            //Evaluate all particles at once; the personal and global
+            //bests used above are not affected by the new positions
+            const Array F = P.batchValue(X_);
+            for (Size i = 0; i < M_; i++) {
+                const Array& x = X_[i];
+                Array& pB = pBX_[i];
+                const Real f = F[i];
                 if (f < pBF_[i]) {
                     //Update personal best
                     pBF_[i] = f;
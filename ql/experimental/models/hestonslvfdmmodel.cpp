@@ -47,6 +47,7 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/assign/std/vector.hpp>
 
+#include <chrono>
 #include <functional>
 
 using namespace boost::assign;
@@ -299,6 +300,9 @@ namespace QuantLib {
     }
 
     void HestonSLVFDMModel::performCalculations() const {
+        typedef std::chrono::steady_clock clock;
+        const clock::time_point start = clock::now();
+        timings_.clear();
         logEntries_.clear();
 
         const ext::shared_ptr<HestonProcess> hestonProcess
@@ -481,7 +485,14 @@ namespace QuantLib {
                 const ext::shared_ptr<FdmScheme> fdmScheme(
                     fdmSchemeFactory(fdmSchemeDesc, hestonFwdOp));
 
-                for (Size j=0; j < x.size(); ++j) {
+                // the local volatility is not evaluated in parallel
+                Array localVols(x.size());
+                for (Size j=0; j < x.size(); ++j)
+                    localVols[j] = localVol_->localVol(t, x[j]);
+
+                const long nx = static_cast<long>(x.size());
+                #pragma omp parallel for
+                for (long j=0; j < nx; ++j) {
                     Array pSlice(vGrid);
                     for (Size k=0; k < vGrid; ++k)
                         pSlice[k] = pn[j + k*xGrid];
@@ -497,15 +508,14 @@ namespace QuantLib {
                       : DiscreteSimpsonIntegral()(v, v*pSlice);
 
                     const Real scale = pInt/vpInt;
-                    const Volatility localVol = localVol_->localVol(t, x[j]);
+                    const Volatility localVol = localVols[j];
 
                     const Real l = (scale >= 0.0)
                       ? localVol*std::sqrt(scale) : 1.0;
 
                     (*L)[j][i] = std::min(50.0, std::max(0.001, l));
-
-                    leverageFct->setInterpolation(Linear());
                 }
+                leverageFct->setInterpolation(Linear());
 
                 const Real sLowerBound = std::max(x.front(),
                     std::exp(localVolRND.invcdf(
@@ -544,11 +554,27 @@ namespace QuantLib {
                     = { t, ext::make_shared<Array>(p), mesher };
                 logEntries_.push_back(entry);
             }
+
+            timings_.push_back(std::make_pair(t,
+                std::chrono::duration<Real>(clock::now() - start).count()));
+            if (progressCallback_)
+                progressCallback_(t, timeGrid->back());
         }
 
         leverageFunction_ = leverageFct;
     }
 
+    const std::vector<std::pair<Time, Real> >&
+    HestonSLVFDMModel::calibrationTimings() const {
+        calculate();
+        return timings_;
+    }
+
+    void HestonSLVFDMModel::setProgressCallback(
+                         const ext::function<void(Time, Time)>& callback) {
+        progressCallback_ = callback;
+    }
+
     const std::list<HestonSLVFDMModel::LogEntry>& HestonSLVFDMModel::logEntries()
     const {
         performCalculations();
@@ -25,6 +25,7 @@
 #ifndef quantlib_heston_slv_model_hpp
 #define quantlib_heston_slv_model_hpp
 
+#include <ql/functional.hpp>
 #include <ql/handle.hpp>
 #include <ql/patterns/lazyobject.hpp>
 #include <ql/patterns/observable.hpp>
@@ -92,6 +93,19 @@ class SimpleQuote;
 
         const std::list<LogEntry>& logEntries() const;
 
+        //! \name Instrumentation
+        //@{
+        /*! time grid points reached during the last calibration,
+            together with the wall-clock time (in seconds) elapsed
+            since its start
+        */
+        const std::vector<std::pair<Time, Real> >& calibrationTimings() const;
+        /*! sets a function to be called after each calibrated time
+            step; it is passed the time reached and the final time.
+        */
+        void setProgressCallback(const ext::function<void(Time, Time)>&);
+        //@}
+
       protected:
         void performCalculations() const override;
 
@@ -106,6 +120,9 @@ class SimpleQuote;
 
         const bool logging_;
         mutable std::list<LogEntry> logEntries_;
+
+        ext::function<void(Time, Time)> progressCallback_;
+        mutable std::vector<std::pair<Time, Real> > timings_;
     };
 }
 
@@ -25,17 +25,67 @@
 #include <ql/termstructures/volatility/equityfx/fixedlocalvolsurface.hpp>
 #include <ql/experimental/models/hestonslvmcmodel.hpp>
 #include <ql/experimental/processes/hestonslvprocess.hpp>
+#include <algorithm>
+#include <chrono>
+#include <exception>
 
-#if defined(__GNUC__) && (((__GNUC__ == 4) && (__GNUC_MINOR__ >= 8)) || (__GNUC__ > 4))
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-local-typedefs"
-#endif
-#include <boost/multi_array.hpp>
-#if defined(__GNUC__) && (((__GNUC__ == 4) && (__GNUC_MINOR__ >= 8)) || (__GNUC__ > 4))
-#pragma GCC diagnostic pop
-#endif
 
 namespace QuantLib {
+
+    namespace {
+
+        void evolveParticle(const HestonSLVProcess& process,
+                            Time t, Time dt,
+                            std::pair<Real, Real>& particle,
+                            const Real* increments) {
+            Array x0(2), dw(2);
+            x0[0] = particle.first;
+            x0[1] = particle.second;
+
+            dw[0] = increments[0];
+            dw[1] = increments[1];
+
+            x0 = process.evolve(t, x0, dt, dw);
+
+            particle.first = x0[0];
+            particle.second = x0[1];
+        }
+
+        // sorts contiguous chunks (in parallel, if enabled) and
+        // merges them pairwise afterwards
+        template <class T>
+        void chunkedSort(std::vector<T>& v) {
+            const Size minChunkSize = 4096, maxChunks = 16;
+            const Size nChunks =
+                std::min(maxChunks, std::max<Size>(v.size()/minChunkSize, 1));
+            if (nChunks == 1) {
+                std::sort(v.begin(), v.end());
+                return;
+            }
+
+            std::vector<Size> bounds(nChunks+1);
+            for (Size i=0; i <= nChunks; ++i)
+                bounds[i] = (v.size()*i)/nChunks;
+
+            const long n = static_cast<long>(nChunks);
+            #pragma omp parallel for
+            for (long i=0; i < n; ++i)
+                std::sort(v.begin()+bounds[i], v.begin()+bounds[i+1]);
+
+            for (long width=1; width < n; width*=2) {
+                #pragma omp parallel for
+                for (long i=0; i < n; i+=2*width) {
+                    if (i+width < n)
+                        std::inplace_merge(
+                            v.begin()+bounds[i],
+                            v.begin()+bounds[i+width],
+                            v.begin()+bounds[std::min(i+2*width, n)]);
+                }
+            }
+        }
+
+    }
+
     HestonSLVMCModel::HestonSLVMCModel(
         const Handle<LocalVolTermStructure>& localVol,
         const Handle<HestonModel>& hestonModel,
@@ -45,14 +95,19 @@ namespace QuantLib {
         Size nBins,
         Size calibrationPaths,
         const std::vector<Date>& mandatoryDates,
-        const Real mixingFactor)
+        const Real mixingFactor,
+        Size maxStoredTimeSteps)
     : localVol_(localVol),
       hestonModel_(hestonModel),
       brownianGeneratorFactory_(brownianGeneratorFactory),
       endDate_(endDate),
       nBins_(nBins),
       calibrationPaths_(calibrationPaths),
-      mixingFactor_(mixingFactor) {
+      mixingFactor_(mixingFactor),
+      maxStoredTimeSteps_(maxStoredTimeSteps) {
+
+        QL_REQUIRE(maxStoredTimeSteps_ > 0,
+                   "at least one time step must be stored");
 
         registerWith(localVol_);
         registerWith(hestonModel_);
@@ -87,7 +142,22 @@ namespace QuantLib {
         return leverageFunction_;
     }
 
+    const std::vector<std::pair<Time, Real> >&
+    HestonSLVMCModel::calibrationTimings() const {
+        calculate();
+        return timings_;
+    }
+
+    void HestonSLVMCModel::setProgressCallback(
+                         const ext::function<void(Time, Time)>& callback) {
+        progressCallback_ = callback;
+    }
+
     void HestonSLVMCModel::performCalculations() const {
+        typedef std::chrono::steady_clock clock;
+        const clock::time_point start = clock::now();
+        timings_.clear();
+
         const ext::shared_ptr<HestonProcess> hestonProcess
             = hestonModel_->process();
         const ext::shared_ptr<Quote> spot
@@ -132,62 +202,94 @@ namespace QuantLib {
 
         const Size timeSteps = timeGrid_->size()-1;
 
-        typedef boost::multi_array<Real, 3> path_type;
-        path_type paths(boost::extents[calibrationPaths_][timeSteps][2]);
+        // the Brownian increments are stored for blocks of time
+        // steps; the paths are regenerated for each block
+        const Size blockSize = (maxStoredTimeSteps_ == Null<Size>())
+            ? timeSteps : std::min(maxStoredTimeSteps_, timeSteps);
+        std::vector<Real> paths(calibrationPaths_*blockSize*2);
 
-        const ext::shared_ptr<BrownianGenerator> brownianGenerator =
-            brownianGeneratorFactory_->create(2, timeSteps);
+        // bin boundaries
+        std::vector<Size> binStart(nBins_+1, 0);
+        for (Size i=0; i < nBins_; ++i)
+            binStart[i+1] = binStart[i] + k + static_cast<Size>(i < m);
 
-        for (Size i=0; i < calibrationPaths_; ++i) {
-            brownianGenerator->nextPath();
-            std::vector<Real> tmp(2);
-            for (Size j=0; j < timeSteps; ++j) {
-                brownianGenerator->nextStep(tmp);
-                paths[i][j][0] = tmp[0];
-                paths[i][j][1] = tmp[1];
-            }
-        }
+        std::vector<Real> binAverages(nBins_);
+        std::vector<std::exception_ptr> errors(calibrationPaths_);
+
+        const long nPaths = static_cast<long>(calibrationPaths_);
+        const long nBins = static_cast<long>(nBins_);
 
+        Size blockBegin = 0, blockEnd = 0;
         for (Size n=1; n < timeGrid_->size(); ++n) {
+            if (n-1 == blockEnd) {
+                blockBegin = blockEnd;
+                blockEnd = std::min(timeSteps, blockBegin + blockSize);
+
+                const ext::shared_ptr<BrownianGenerator> brownianGenerator =
+                    brownianGeneratorFactory_->create(2, timeSteps);
+
+                std::vector<Real> tmp(2);
+                for (Size i=0; i < calibrationPaths_; ++i) {
+                    brownianGenerator->nextPath();
+                    Real* dw = &paths[i*blockSize*2];
+                    for (Size j=0; j < timeSteps; ++j) {
+                        brownianGenerator->nextStep(tmp);
+                        if (j >= blockBegin && j < blockEnd) {
+                            dw[2*(j-blockBegin)]   = tmp[0];
+                            dw[2*(j-blockBegin)+1] = tmp[1];
+                        }
+                    }
+                }
+            }
+
             const Time t = timeGrid_->at(n-1);
             const Time dt = timeGrid_->dt(n-1);
-
-            Array x0(2), dw(2);
-
-            for (Size i=0; i < calibrationPaths_; ++i) {
-                x0[0] = pairs[i].first;
-                x0[1] = pairs[i].second;
-
-                dw[0] = paths[i][n-1][0];
-                dw[1] = paths[i][n-1][1];
-
-                x0 = slvProcess->evolve(t, x0, dt, dw);
-
-                pairs[i].first = x0[0];
-                pairs[i].second = x0[1];
+            const Size offset = 2*(n-1-blockBegin);
+
+            // the first particle is evolved serially, so that lazy
+            // term structures are calculated outside the parallel loop
+            evolveParticle(*slvProcess, t, dt, pairs[0], &paths[offset]);
+
+            #pragma omp parallel for if(nPaths > 1024)
+            for (long i=1; i < nPaths; ++i) {
+                try {
+                    evolveParticle(*slvProcess, t, dt, pairs[i],
+                                   &paths[i*blockSize*2 + offset]);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
             }
+            for (Size i=0; i < calibrationPaths_; ++i)
+                if (errors[i])
+                    std::rethrow_exception(errors[i]);
 
-            std::sort(pairs.begin(), pairs.end());
+            chunkedSort(pairs);
 
-            Size s = 0U, e = 0U;
-            for (Size i=0; i < nBins_; ++i) {
-                const Size inc = k + static_cast<unsigned long>(i < m);
-                e = s + inc;
+            #pragma omp parallel for if(nPaths > 1024)
+            for (long i=0; i < nBins; ++i) {
+                const Size s = binStart[i], e = binStart[i+1];
 
                 Real sum=0.0;
                 for (Size j=s; j < e; ++j) {
                     sum+=pairs[j].second;
                 }
-                sum/=inc;
+                binAverages[i] = sum/(e-s);
 
                 vStrikes[n]->at(i) = 0.5*(pairs[e-1].first + pairs[s].first);
-                (*L)[i][n] = std::sqrt(square<Real>()(
-                     localVol_->localVol(t, vStrikes[n]->at(i), true))/sum);
+            }
 
-                s = e;
+            for (Size i=0; i < nBins_; ++i) {
+                (*L)[i][n] = std::sqrt(square<Real>()(
+                     localVol_->localVol(t, vStrikes[n]->at(i), true))
+                     /binAverages[i]);
             }
 
             leverageFunction_->setInterpolation<Linear>();
+
+            timings_.push_back(std::make_pair(timeGrid_->at(n),
+                std::chrono::duration<Real>(clock::now() - start).count()));
+            if (progressCallback_)
+                progressCallback_(timeGrid_->at(n), timeGrid_->back());
         }
     }
 }
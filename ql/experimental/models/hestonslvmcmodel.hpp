@@ -25,6 +25,7 @@
 #ifndef quantlib_heston_slv_mc_model_hpp
 #define quantlib_heston_slv_mc_model_hpp
 
+#include <ql/functional.hpp>
 #include <ql/handle.hpp>
 #include <ql/timegrid.hpp>
 #include <ql/patterns/lazyobject.hpp>
@@ -40,6 +41,17 @@ namespace QuantLib {
         http://papers.ssrn.com/sol3/papers.cfm?abstract_id=2278122
     */
 
+    /*! The particles are evolved in parallel, and sorted into bins
+        by means of a parallel sort, when OpenMP is enabled.
+
+        By default, the Brownian increments of all particles are
+        generated upfront and kept in memory for the whole time grid.
+        If maxStoredTimeSteps is given, they are kept for blocks of at
+        most that many time steps and the Brownian paths are
+        regenerated for each block; this bounds the memory used at
+        the cost of generating the random numbers again, and requires
+        the generators returned by the factory to be deterministic.
+    */
     class HestonSLVMCModel : public LazyObject {
       public:
         HestonSLVMCModel(const Handle<LocalVolTermStructure>& localVol,
@@ -50,12 +62,26 @@ namespace QuantLib {
                          Size nBins = 201,
                          Size calibrationPaths = (1 << 15),
                          const std::vector<Date>& mandatoryDates = std::vector<Date>(),
-                         Real mixingFactor = 1.0);
+                         Real mixingFactor = 1.0,
+                         Size maxStoredTimeSteps = Null<Size>());
 
         ext::shared_ptr<HestonProcess> hestonProcess() const;
         ext::shared_ptr<LocalVolTermStructure> localVol() const;
         ext::shared_ptr<LocalVolTermStructure> leverageFunction() const;
 
+        //! \name Instrumentation
+        //@{
+        /*! time grid points reached during the last calibration,
+            together with the wall-clock time (in seconds) elapsed
+            since its start
+        */
+        const std::vector<std::pair<Time, Real> >& calibrationTimings() const;
+        /*! sets a function to be called after each calibrated time
+            step; it is passed the time reached and the final time.
+        */
+        void setProgressCallback(const ext::function<void(Time, Time)>&);
+        //@}
+
       protected:
         void performCalculations() const override;
 
@@ -66,9 +92,12 @@ namespace QuantLib {
         const Date endDate_;
         const Size nBins_, calibrationPaths_;
         const Real mixingFactor_;
+        const Size maxStoredTimeSteps_;
         ext::shared_ptr<TimeGrid> timeGrid_;
+        ext::function<void(Time, Time)> progressCallback_;
 
         mutable ext::shared_ptr<FixedLocalVolSurface> leverageFunction_;
+        mutable std::vector<std::pair<Time, Real> > timings_;
     };
 }
 
@@ -1,6 +1,11 @@
 /* This file is automatically generated; do not edit.     */
 /* Add the files to be included into Makefile.am instead. */
 
+#include <ql/experimental/risk/amcregression.hpp>
 #include <ql/experimental/risk/creditriskplus.hpp>
+#include <ql/experimental/risk/exposuresimulator.hpp>
+#include <ql/experimental/risk/fftcreditriskplus.hpp>
+#include <ql/experimental/risk/portfoliopricer.hpp>
 #include <ql/experimental/risk/sensitivityanalysis.hpp>
+#include <ql/experimental/risk/sensitivityengine.hpp>
 
@@ -0,0 +1,272 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <ql/experimental/risk/amcregression.hpp>
+#include <ql/math/matrixutilities/svd.hpp>
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <iterator>
+
+namespace QuantLib {
+
+    namespace {
+
+        // least-squares solution of the normal equations, discarding
+        // the directions with negligible singular values
+        Array solveNormalEquations(const Matrix& A, const Array& b) {
+            const Size m = b.size();
+            Array result(m, 0.0);
+            const SVD svd(A);
+            const Matrix& U = svd.U();
+            const Matrix& V = svd.V();
+            const Array& w = svd.singularValues();
+            const Real threshold = m * QL_EPSILON * w[0];
+            for (Size i=0; i<m; ++i) {
+                if (w[i] > threshold) {
+                    Real u = 0.0;
+                    for (Size j=0; j<m; ++j)
+                        u += U[j][i]*b[j];
+                    u /= w[i];
+                    for (Size j=0; j<m; ++j)
+                        result[j] += u*V[j][i];
+                }
+            }
+            return result;
+        }
+
+    }
+
+    AmcRegression::AmcRegression(Size dates,
+                                 Size stateDimension,
+                                 Size polynomOrder,
+                                 LsmBasisSystem::PolynomType polynomType,
+                                 Size pathsPerBlock)
+    : dates_(dates), stateDimension_(stateDimension),
+      pathsPerBlock_(pathsPerBlock),
+      v_(LsmBasisSystem::multiPathBasisSystem(stateDimension, polynomOrder,
+                                              polynomType)),
+      paths_(0), exercisable_(false), deflated_(true) {
+        QL_REQUIRE(dates_ > 0, "no dates given");
+        QL_REQUIRE(stateDimension_ > 0, "null state dimension");
+        QL_REQUIRE(pathsPerBlock_ > 0, "null block size");
+    }
+
+    void AmcRegression::addPath(const std::vector<Array>& states,
+                                const std::vector<Real>& payments,
+                                const std::vector<Real>& exercises,
+                                const std::vector<Real>& numeraires) {
+        QL_REQUIRE(states.size() == dates_,
+                   "wrong number of states (" << states.size()
+                   << ", " << dates_ << " required)");
+        QL_REQUIRE(payments.size() == dates_,
+                   "wrong number of payments (" << payments.size()
+                   << ", " << dates_ << " required)");
+        QL_REQUIRE(exercises.empty() || exercises.size() == dates_,
+                   "wrong number of exercise values (" << exercises.size()
+                   << ", " << dates_ << " required)");
+        QL_REQUIRE(numeraires.empty() || numeraires.size() == dates_,
+                   "wrong number of numeraires (" << numeraires.size()
+                   << ", " << dates_ << " required)");
+        if (paths_ == 0) {
+            exercisable_ = !exercises.empty();
+            deflated_ = numeraires.empty();
+        } else {
+            QL_REQUIRE(exercisable_ != exercises.empty(),
+                       "exercise values must be given for all paths or "
+                       "for none");
+            QL_REQUIRE(deflated_ == numeraires.empty(),
+                       "numeraires must be given for all paths or for none");
+        }
+        for (Size d=0; d<dates_; ++d) {
+            QL_REQUIRE(states[d].size() == stateDimension_,
+                       "wrong state dimension at date #" << d << " ("
+                       << states[d].size() << ", " << stateDimension_
+                       << " required)");
+            std::copy(states[d].begin(), states[d].end(),
+                      std::back_inserter(states_));
+        }
+        std::copy(payments.begin(), payments.end(),
+                  std::back_inserter(payments_));
+        std::copy(exercises.begin(), exercises.end(),
+                  std::back_inserter(exercises_));
+        std::copy(numeraires.begin(), numeraires.end(),
+                  std::back_inserter(numeraires_));
+        ++paths_;
+    }
+
+    AmcResults AmcRegression::calculate() const {
+        const Size m = v_.size();
+        QL_REQUIRE(paths_ >= m,
+                   "not enough paths (" << paths_ << ") for "
+                   << m << " basis functions");
+        const Size nBlocks = (paths_ + pathsPerBlock_ - 1)/pathsPerBlock_;
+
+        AmcResults results;
+        results.dates = dates_;
+        results.paths = paths_;
+        results.values.resize(dates_*paths_);
+        results.coefficients.resize(dates_);
+        results.exerciseDate.assign(paths_, Null<Size>());
+
+        // deflated cash flows after the current date, under the policy
+        std::vector<Real> future(paths_, 0.0);
+        // basis functions at the current date, m per path
+        std::vector<Real> basis(paths_*m);
+        // normal equations for the values (all paths) and, if the
+        // trade can be exercised, for the exercise decisions (paths
+        // in the money only)
+        std::vector<Matrix> partialA(nBlocks, Matrix(m, m)),
+                            partialExerciseA(nBlocks, Matrix(m, m));
+        std::vector<Array> partialB(nBlocks, Array(m)),
+                           partialExerciseB(nBlocks, Array(m));
+        std::vector<Size> inTheMoney(nBlocks);
+        std::vector<std::exception_ptr> errors(nBlocks);
+
+        for (Size d=dates_; d-- > 0;) {
+
+            // accumulate the normal equations over each block
+            #if !defined(QL_ENABLE_SESSIONS)
+            #pragma omp parallel for
+            #endif
+            for (long b=0; b<long(nBlocks); ++b) {
+                try {
+                    Matrix& A = partialA[b];
+                    Array& rhs = partialB[b];
+                    Matrix& exerciseA = partialExerciseA[b];
+                    Array& exerciseRhs = partialExerciseB[b];
+                    std::fill(A.begin(), A.end(), 0.0);
+                    std::fill(rhs.begin(), rhs.end(), 0.0);
+                    std::fill(exerciseA.begin(), exerciseA.end(), 0.0);
+                    std::fill(exerciseRhs.begin(), exerciseRhs.end(), 0.0);
+                    inTheMoney[b] = 0;
+                    Array x(stateDimension_);
+                    const Size end =
+                        std::min<Size>((b+1)*pathsPerBlock_, paths_);
+                    for (Size p=b*pathsPerBlock_; p<end; ++p) {
+                        const Real* state =
+                            &states_[(p*dates_ + d)*stateDimension_];
+                        std::copy(state, state+stateDimension_, x.begin());
+                        Real* phi = &basis[p*m];
+                        for (Size l=0; l<m; ++l)
+                            phi[l] = v_[l](x);
+                        for (Size i=0; i<m; ++i) {
+                            for (Size j=i; j<m; ++j)
+                                A[i][j] += phi[i]*phi[j];
+                            rhs[i] += phi[i]*future[p];
+                        }
+                        if (exercisable_) {
+                            Real exercise = exercises_[p*dates_ + d];
+                            if (exercise != Null<Real>() && exercise > 0.0) {
+                                for (Size i=0; i<m; ++i) {
+                                    for (Size j=i; j<m; ++j)
+                                        exerciseA[i][j] += phi[i]*phi[j];
+                                    exerciseRhs[i] += phi[i]*future[p];
+                                }
+                                ++inTheMoney[b];
+                            }
+                        }
+                    }
+                } catch (...) {
+                    errors[b] = std::current_exception();
+                }
+            }
+            for (Size b=0; b<nBlocks; ++b) {
+                if (errors[b])
+                    std::rethrow_exception(errors[b]);
+            }
+
+            // reduce in block order and solve
+            Matrix A(m, m, 0.0), exerciseA(m, m, 0.0);
+            Array rhs(m, 0.0), exerciseRhs(m, 0.0);
+            Size itm = 0;
+            for (Size b=0; b<nBlocks; ++b) {
+                A += partialA[b];
+                rhs += partialB[b];
+                exerciseA += partialExerciseA[b];
+                exerciseRhs += partialExerciseB[b];
+                itm += inTheMoney[b];
+            }
+            for (Size i=0; i<m; ++i) {
+                for (Size j=0; j<i; ++j) {
+                    A[i][j] = A[j][i];
+                    exerciseA[i][j] = exerciseA[j][i];
+                }
+            }
+            const Array beta = solveNormalEquations(A, rhs);
+            results.coefficients[d] = beta;
+            // as in Longstaff-Schwartz, never exercise if there are
+            // too few paths in the money to regress on
+            const bool canExercise = itm >= m;
+            const Array exerciseBeta = canExercise ?
+                solveNormalEquations(exerciseA, exerciseRhs) : Array();
+
+            // fitted values, exercise decisions and roll-back
+            #if !defined(QL_ENABLE_SESSIONS)
+            #pragma omp parallel for
+            #endif
+            for (long b=0; b<long(nBlocks); ++b) {
+                const Size end = std::min<Size>((b+1)*pathsPerBlock_, paths_);
+                for (Size p=b*pathsPerBlock_; p<end; ++p) {
+                    const Real* phi = &basis[p*m];
+                    Real value = 0.0;
+                    for (Size l=0; l<m; ++l)
+                        value += beta[l]*phi[l];
+                    Real exercise = canExercise ? exercises_[p*dates_ + d]
+                                                : Real(Null<Real>());
+                    if (exercise != Null<Real>() && exercise > 0.0) {
+                        Real continuation = 0.0;
+                        for (Size l=0; l<m; ++l)
+                            continuation += exerciseBeta[l]*phi[l];
+                        if (exercise > continuation) {
+                            value = exercise;
+                            future[p] = exercise;
+                            results.exerciseDate[p] = d;
+                        }
+                    }
+                    if (!deflated_)
+                        value *= numeraires_[p*dates_ + d];
+                    results.values[d*paths_ + p] = float(value);
+                    future[p] += payments_[p*dates_ + d];
+                }
+            }
+        }
+
+        // nothing is left after exercise
+        if (exercisable_) {
+            for (Size p=0; p<paths_; ++p) {
+                Size exerciseDate = results.exerciseDate[p];
+                if (exerciseDate != Null<Size>()) {
+                    for (Size d=exerciseDate+1; d<dates_; ++d)
+                        results.values[d*paths_ + p] = 0.0f;
+                }
+            }
+        }
+
+        Real sum = 0.0, sum2 = 0.0;
+        for (Size p=0; p<paths_; ++p) {
+            sum += future[p];
+            sum2 += future[p]*future[p];
+        }
+        results.npv = sum/paths_;
+        results.errorEstimate =
+            std::sqrt(std::max(sum2/paths_ - results.npv*results.npv, 0.0)
+                      / paths_);
+        return results;
+    }
+
+}
@@ -0,0 +1,110 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file amcregression.hpp
+    \brief American Monte Carlo regression of conditional trade values
+*/
+
+#ifndef quantlib_amc_regression_hpp
+#define quantlib_amc_regression_hpp
+
+#include <ql/methods/montecarlo/lsmbasissystem.hpp>
+#include <vector>
+
+namespace QuantLib {
+
+    //! results of an American Monte Carlo regression
+    struct AmcResults {
+        Size dates, paths;
+        /*! conditional trade values, date-major: the value on path
+            \f$ p \f$ at date \f$ d \f$ is stored at
+            <tt>values[d*paths+p]</tt>.
+        */
+        std::vector<float> values;
+        //! regression coefficients for each date
+        std::vector<Array> coefficients;
+        //! first exercise date on each path; Null<Size>() if none
+        std::vector<Size> exerciseDate;
+        //! average of the deflated cash flows under the exercise policy
+        Real npv;
+        Real errorEstimate;
+    };
+
+    //! American Monte Carlo regression
+    /*! Given simulated paths, the class estimates the value of a trade
+        at each date of a grid and on each path as the conditional
+        expectation of its future cash flows, regressed on the state
+        variables at that date with the Longstaff-Schwartz basis
+        functions.  Dates are processed backwards; if the trade has
+        exercise rights (exercise cancels all payments after the
+        exercise date) the exercise decisions are taken on the way, and
+        values after exercise are zero.
+
+        For each path, the caller provides the cash flows paid at each
+        date and the exercise values, both deflated by the numeraire,
+        the state variables and, optionally, the numeraire itself;
+        values at a date don't include the cash flows paid at that
+        date.  Unlike the Longstaff-Schwartz path pricers, all paths
+        take part in the regressions, since values are needed on each
+        of them; as in Longstaff-Schwartz, the exercise decisions are
+        based on a separate regression over the paths with a positive
+        exercise value, the only ones that can be exercised.  States
+        should be scaled to be of order one, as for the other users of
+        LsmBasisSystem.
+
+        The regressions use normal equations accumulated over blocks
+        of paths in parallel and reduced in a fixed order, so that the
+        results don't depend on the number of threads; the fitted
+        values are stored as single-precision floats.
+
+        \test conditional values are checked against analytic
+              Black-Scholes prices, and the exercise policy against a
+              finite-difference price of an American option.
+    */
+    class AmcRegression {
+      public:
+        AmcRegression(Size dates,
+                      Size stateDimension,
+                      Size polynomOrder,
+                      LsmBasisSystem::PolynomType polynomType,
+                      Size pathsPerBlock = 1024);
+        /*! adds a path; <tt>states[d]</tt> must have the state
+            dimension.  Exercise values can be empty if the trade has
+            no exercise rights, or contain Null<Real>() at dates where
+            it can't be exercised; the numeraire can be empty if values
+            are to be returned deflated.
+        */
+        void addPath(const std::vector<Array>& states,
+                     const std::vector<Real>& payments,
+                     const std::vector<Real>& exercises = std::vector<Real>(),
+                     const std::vector<Real>& numeraires
+                                                    = std::vector<Real>());
+        Size paths() const { return paths_; }
+        Size basisSize() const { return v_.size(); }
+        AmcResults calculate() const;
+      private:
+        Size dates_, stateDimension_, pathsPerBlock_;
+        std::vector<ext::function<Real(Array)> > v_;
+        Size paths_;
+        bool exercisable_, deflated_;
+        // path-major storage, as paths are added one at a time
+        std::vector<Real> states_, payments_, exercises_, numeraires_;
+    };
+
+}
+
+#endif
@@ -0,0 +1,613 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <ql/experimental/risk/exposuresimulator.hpp>
+#include <ql/cashflows/fixedratecoupon.hpp>
+#include <ql/cashflows/floatingratecoupon.hpp>
+#include <ql/exercise.hpp>
+#include <ql/math/distributions/normaldistribution.hpp>
+#include <ql/math/randomnumbers/inversecumulativerng.hpp>
+#include <ql/math/randomnumbers/mt19937uniformrng.hpp>
+#include <ql/math/solvers1d/brent.hpp>
+#include <ql/pricingengines/blackformula.hpp>
+#include <ql/processes/g2process.hpp>
+#include <ql/processes/hullwhiteprocess.hpp>
+#include <algorithm>
+#include <exception>
+
+namespace QuantLib {
+
+    namespace {
+
+        // value at expiry, as a function of the short rate, of the
+        // coupon bond whose put (call) is a payer (receiver) swaption
+        class CouponBondValue {
+          public:
+            CouponBondValue(const HullWhite& model, Time expiry,
+                            Time valueTime, const std::vector<Time>& times,
+                            const std::vector<Real>& amounts, Real nominal)
+            : model_(model), expiry_(expiry), valueTime_(valueTime),
+              times_(times), amounts_(amounts), nominal_(nominal) {}
+            Real operator()(Rate r) const {
+                Real start = model_.discountBond(expiry_, valueTime_, r);
+                Real value = nominal_;
+                for (Size i=0; i<times_.size(); ++i)
+                    value -= amounts_[i]
+                           * model_.discountBond(expiry_, times_[i], r)/start;
+                return value;
+            }
+          private:
+            const HullWhite& model_;
+            Time expiry_, valueTime_;
+            const std::vector<Time>& times_;
+            const std::vector<Real>& amounts_;
+            Real nominal_;
+        };
+
+        Real B(Real a, Time t, Time T) {
+            if (a < std::sqrt(QL_EPSILON))
+                return T-t;
+            return (1.0 - std::exp(-a*(T-t)))/a;
+        }
+
+        /* factors of the bond price P(t,T) = A exp(-sum_k B_k x_k) as
+           a function of the model state; returns A and writes the B_k
+           for the given mean reversions */
+        Real bondFactors(const AffineModel& model,
+                         const std::vector<Real>& meanReversions,
+                         Time t, Time T, Real* b) {
+            for (Size k=0; k<meanReversions.size(); ++k)
+                b[k] = B(meanReversions[k], t, T);
+            return model.discountBond(
+                t, T, Array(meanReversions.size(), 0.0));
+        }
+
+        Real dot(const Real* b, const Real* x, Size n) {
+            Real result = 0.0;
+            for (Size k=0; k<n; ++k)
+                result += b[k]*x[k];
+            return result;
+        }
+
+        /* standard deviation of the price at time m of a bond from s
+           to M, seen from now; same as in
+           HullWhite::discountBondOption, but for any origin */
+        Real bondOptionStdDev(Real a, Real sigma, Time m, Time s, Time M) {
+            if (a < std::sqrt(QL_EPSILON))
+                return sigma*B(a, s, M)*std::sqrt(m);
+            Real c = std::exp(-2.0*a*(s-m)) - std::exp(-2.0*a*s)
+                - 2.0*(std::exp(-a*(s+M-2.0*m)) - std::exp(-a*(s+M)))
+                + std::exp(-2.0*a*(M-m)) - std::exp(-2.0*a*M);
+            return sigma/(a*std::sqrt(2.0*a)) * std::sqrt(std::max(c, 0.0));
+        }
+
+    }
+
+    ExposureSimulator::ExposureSimulator(
+                                     const ext::shared_ptr<HullWhite>& model,
+                                     const std::vector<Date>& exposureDates,
+                                     Size samples,
+                                     BigNatural seed,
+                                     Real pfeQuantile,
+                                     Size pathsPerBlock)
+    : model_(model), hullWhite_(model), samples_(samples), seed_(seed),
+      pfeQuantile_(pfeQuantile), pathsPerBlock_(pathsPerBlock),
+      nettingSets_(0) {
+        QL_REQUIRE(model, "null model");
+        termStructure_ = model->termStructure();
+        factors_ = 1;
+        initialize(exposureDates);
+    }
+
+    ExposureSimulator::ExposureSimulator(
+                                     const ext::shared_ptr<G2>& model,
+                                     const std::vector<Date>& exposureDates,
+                                     Size samples,
+                                     BigNatural seed,
+                                     Real pfeQuantile,
+                                     Size pathsPerBlock)
+    : model_(model), g2_(model), samples_(samples), seed_(seed),
+      pfeQuantile_(pfeQuantile), pathsPerBlock_(pathsPerBlock),
+      nettingSets_(0) {
+        QL_REQUIRE(model, "null model");
+        termStructure_ = model->termStructure();
+        factors_ = 2;
+        initialize(exposureDates);
+    }
+
+    void ExposureSimulator::initialize(
+                                    const std::vector<Date>& exposureDates) {
+        QL_REQUIRE(!exposureDates.empty(), "no exposure dates given");
+        QL_REQUIRE(samples_ > 0, "no samples required");
+        QL_REQUIRE(pathsPerBlock_ > 0, "at least one path per block required");
+        QL_REQUIRE(pfeQuantile_ > 0.0 && pfeQuantile_ < 1.0,
+                   "PFE quantile (" << pfeQuantile_ << ") out of range");
+        grid_.push_back(0.0);
+        for (Size i=0; i<exposureDates.size(); ++i) {
+            Time t = time(exposureDates[i]);
+            QL_REQUIRE(t > grid_.back(),
+                       "exposure dates must be sorted and after the "
+                       "reference date");
+            times_.push_back(t);
+            grid_.push_back(t);
+        }
+    }
+
+    Time ExposureSimulator::time(const Date& d) const {
+        return termStructure_->dayCounter().yearFraction(
+                                       termStructure_->referenceDate(), d);
+    }
+
+    Size ExposureSimulator::lastSimulationDate(Time t) const {
+        return std::upper_bound(grid_.begin(), grid_.end(), t)
+            - grid_.begin() - 1;
+    }
+
+    void ExposureSimulator::addFixedFlow(Time payTime, Real amount,
+                                         Time lastTime) {
+        if (lastTime <= 0.0)
+            return;
+        fixedPayTime_.push_back(payTime);
+        fixedAmount_.push_back(amount);
+        fixedLastTime_.push_back(lastTime);
+    }
+
+    void ExposureSimulator::addLegs(const VanillaSwap& swap) {
+        Real sign = swap.type() == VanillaSwap::Payer ? 1.0 : -1.0;
+
+        const Leg& fixedLeg = swap.fixedLeg();
+        for (Size i=0; i<fixedLeg.size(); ++i) {
+            Time t = time(fixedLeg[i]->date());
+            if (t > 0.0)
+                addFixedFlow(t, -sign*fixedLeg[i]->amount(), t);
+        }
+
+        const Leg& floatingLeg = swap.floatingLeg();
+        for (Size i=0; i<floatingLeg.size(); ++i) {
+            ext::shared_ptr<FloatingRateCoupon> coupon =
+                ext::dynamic_pointer_cast<FloatingRateCoupon>(floatingLeg[i]);
+            QL_REQUIRE(coupon, "floating coupon required");
+            Time pay = time(coupon->date());
+            if (pay <= 0.0)
+                continue;
+            Time fixing = time(coupon->fixingDate());
+            if (fixing <= 0.0) {
+                addFixedFlow(pay, sign*coupon->amount(), pay);
+                continue;
+            }
+            Real nominal = coupon->nominal();
+            if (coupon->spread() != 0.0)
+                addFixedFlow(pay, sign*nominal*coupon->accrualPeriod()
+                                 *coupon->spread(), pay);
+            floatingStart_.push_back(time(coupon->accrualStartDate()));
+            floatingEnd_.push_back(time(coupon->accrualEndDate()));
+            floatingPay_.push_back(pay);
+            floatingMultiplier_.push_back(sign*nominal*coupon->gearing());
+            floatingFixingIndex_.push_back(lastSimulationDate(fixing));
+        }
+    }
+
+    void ExposureSimulator::addTrade(Size nettingSet, Size fixedBegin,
+                                     Size floatingBegin, Size swaption) {
+        Trade trade;
+        trade.nettingSet = nettingSet;
+        trade.fixedBegin = fixedBegin;
+        trade.fixedEnd = fixedAmount_.size();
+        trade.floatingBegin = floatingBegin;
+        trade.floatingEnd = floatingMultiplier_.size();
+        trade.swaption = swaption;
+        trades_.push_back(trade);
+        nettingSets_ = std::max(nettingSets_, nettingSet+1);
+        values_.clear();
+    }
+
+    void ExposureSimulator::addSwap(const VanillaSwap& swap,
+                                    Size nettingSet) {
+        Size fixedBegin = fixedAmount_.size(),
+             floatingBegin = floatingMultiplier_.size();
+        addLegs(swap);
+        addTrade(nettingSet, fixedBegin, floatingBegin, Null<Size>());
+    }
+
+    void ExposureSimulator::addFra(const ForwardRateAgreement& fra,
+                                   Size nettingSet) {
+        Real sign = fra.type() == Position::Long ? 1.0 : -1.0;
+        Real notional = fra.notionalAmount();
+        Time start = time(fra.valueDate()), end = time(fra.maturityDate());
+        Real compound = fra.strikeForwardRate().compoundFactor(
+                                       fra.valueDate(), fra.maturityDate());
+        // a FRA is worth N (P(t,S) - (1 + tau K) P(t,E)) until it settles
+        Size fixedBegin = fixedAmount_.size();
+        addFixedFlow(start, sign*notional, start);
+        addFixedFlow(end, -sign*notional*compound, start);
+        addTrade(nettingSet, fixedBegin, floatingMultiplier_.size(),
+                 Null<Size>());
+    }
+
+    void ExposureSimulator::addSwaption(
+                                   const ext::shared_ptr<Swaption>& swaption,
+                                   Size nettingSet) {
+        QL_REQUIRE(hullWhite_,
+                   "swaptions are only supported under the Hull-White "
+                   "model");
+        ext::shared_ptr<Exercise> exercise = swaption->exercise();
+        QL_REQUIRE(exercise->type() == Exercise::European,
+                   "European swaption required");
+        const VanillaSwap& swap = *swaption->underlyingSwap();
+
+        SwaptionData data;
+        data.expiry = time(exercise->lastDate());
+        QL_REQUIRE(data.expiry > 0.0, "swaption already expired");
+        data.exerciseIndex = lastSimulationDate(data.expiry);
+        data.type = swap.type() == VanillaSwap::Payer ? Option::Put
+                                                      : Option::Call;
+
+        // Jamshidian's decomposition, as in JamshidianSwaptionEngine
+        const Leg& fixedLeg = swap.fixedLeg();
+        std::vector<Time> times(fixedLeg.size());
+        std::vector<Real> amounts(fixedLeg.size());
+        for (Size i=0; i<fixedLeg.size(); ++i) {
+            times[i] = time(fixedLeg[i]->date());
+            amounts[i] = fixedLeg[i]->amount();
+        }
+        amounts.back() += swap.nominal();
+        ext::shared_ptr<Coupon> first =
+            ext::dynamic_pointer_cast<Coupon>(fixedLeg.front());
+        data.valueTime = time(first->accrualStartDate());
+
+        CouponBondValue finder(*hullWhite_, data.expiry, data.valueTime,
+                               times, amounts, swap.nominal());
+        Brent solver;
+        solver.setMaxEvaluations(10000);
+        Real minRate = -10.0, maxRate = 10.0;
+        solver.setLowerBound(minRate);
+        solver.setUpperBound(maxRate);
+        Rate rStar = solver.solve(finder, 1.0e-8, 0.05, minRate, maxRate);
+
+        Real start =
+            hullWhite_->discountBond(data.expiry, data.valueTime, rStar);
+        data.couponBegin = couponTime_.size();
+        for (Size i=0; i<times.size(); ++i) {
+            couponTime_.push_back(times[i]);
+            couponAmount_.push_back(amounts[i]);
+            couponStrike_.push_back(
+                hullWhite_->discountBond(data.expiry, times[i], rStar)/start);
+        }
+        data.couponEnd = couponTime_.size();
+        swaptions_.push_back(data);
+
+        Size fixedBegin = fixedAmount_.size(),
+             floatingBegin = floatingMultiplier_.size();
+        addLegs(swap);
+        addTrade(nettingSet, fixedBegin, floatingBegin, swaptions_.size()-1);
+    }
+
+    std::vector<ExposureProfile> ExposureSimulator::calculate() const {
+        QL_REQUIRE(!trades_.empty(), "no trades given");
+
+        const Size nF = factors_;
+        const Size nDates = times_.size(), nGrid = grid_.size();
+        const Size nFixed = fixedAmount_.size(),
+                   nFloating = floatingMultiplier_.size(),
+                   nCoupons = couponAmount_.size();
+        const Size blocks = (samples_ + pathsPerBlock_ - 1)/pathsPerBlock_;
+
+        /* exact transition of the state variables between simulation
+           dates; the state is the short rate itself under Hull-White,
+           and the two factors x and y under G2++, with the short rate
+           given by r = phi(t) + x + y */
+        std::vector<Real> meanReversions;
+        ext::shared_ptr<StochasticProcess> process;
+        std::vector<Real> shortRateShift(nGrid, 0.0);
+        if (hullWhite_) {
+            meanReversions.push_back(hullWhite_->a());
+            process = ext::make_shared<HullWhiteProcess>(
+                termStructure_, hullWhite_->a(), hullWhite_->sigma());
+        } else {
+            meanReversions.push_back(g2_->a());
+            meanReversions.push_back(g2_->b());
+            process = ext::make_shared<G2Process>(
+                g2_->a(), g2_->sigma(), g2_->b(), g2_->eta(), g2_->rho());
+            ext::shared_ptr<TwoFactorModel::ShortRateDynamics> dynamics =
+                g2_->dynamics();
+            for (Size j=0; j<nGrid; ++j)
+                shortRateShift[j] = dynamics->shortRate(grid_[j], 0.0, 0.0);
+        }
+        const Array x0 = process->initialValues();
+        // the factors revert independently, so the decay is diagonal
+        std::vector<Real> mean(nGrid*nF, 0.0), decay(nGrid*nF, 0.0);
+        std::vector<Matrix> stdDev(nGrid);
+        for (Size j=1; j<nGrid; ++j) {
+            Time dt = grid_[j] - grid_[j-1];
+            Array origin(nF, 0.0);
+            Array m = process->expectation(grid_[j-1], origin, dt);
+            for (Size k=0; k<nF; ++k) {
+                mean[j*nF+k] = m[k];
+                Array unit(nF, 0.0);
+                unit[k] = 1.0;
+                decay[j*nF+k] =
+                    process->expectation(grid_[j-1], unit, dt)[k] - m[k];
+            }
+            stdDev[j] = process->stdDeviation(grid_[j-1], origin, dt);
+        }
+
+        // bond factors at the fixing dates of the floating coupons
+        std::vector<Real> fixingStartA(nFloating), fixingEndA(nFloating),
+                          fixingStartB(nFloating*nF), fixingEndB(nFloating*nF);
+        for (Size f=0; f<nFloating; ++f) {
+            Time t = grid_[floatingFixingIndex_[f]];
+            fixingStartA[f] = bondFactors(*model_, meanReversions, t,
+                                          floatingStart_[f],
+                                          &fixingStartB[f*nF]);
+            fixingEndA[f] = bondFactors(*model_, meanReversions, t,
+                                        floatingEnd_[f], &fixingEndB[f*nF]);
+        }
+
+        values_.assign(nettingSets_*nDates*samples_, 0.0f);
+        // per block: EE, ENE, discounted EE and ENE by set and date
+        const Size nSums = 4*nettingSets_*nDates;
+        std::vector<std::vector<Real> > sums(blocks);
+        std::vector<std::exception_ptr> errors(blocks);
+
+        #pragma omp parallel for schedule(dynamic)
+        for (long b=0; b<long(blocks); ++b) {
+            try {
+                const Size firstPath = b*pathsPerBlock_;
+                const Size paths =
+                    std::min(pathsPerBlock_, samples_ - firstPath);
+
+                // simulate the block
+                InverseCumulativeRng<MersenneTwisterUniformRng,
+                                     InverseCumulativeNormal>
+                    rng(MersenneTwisterUniformRng(seed_ + b));
+                std::vector<Real> state(nGrid*paths*nF),
+                                  logDiscount(nGrid*paths);
+                std::vector<Real> w(nF);
+                for (Size p=0; p<paths; ++p) {
+                    std::copy(x0.begin(), x0.end(), &state[p*nF]);
+                    logDiscount[p] = 0.0;
+                }
+                for (Size j=1; j<nGrid; ++j) {
+                    Time dt = grid_[j] - grid_[j-1];
+                    const Matrix& s = stdDev[j];
+                    for (Size p=0; p<paths; ++p) {
+                        const Real* x = &state[((j-1)*paths+p)*nF];
+                        Real* y = &state[(j*paths+p)*nF];
+                        for (Size k=0; k<nF; ++k)
+                            w[k] = rng.next().value;
+                        Real r0 = shortRateShift[j-1], r = shortRateShift[j];
+                        for (Size k=0; k<nF; ++k) {
+                            y[k] = mean[j*nF+k] + decay[j*nF+k]*x[k];
+                            for (Size l=0; l<=k; ++l)
+                                y[k] += s[k][l]*w[l];
+                            r0 += x[k];
+                            r += y[k];
+                        }
+                        logDiscount[j*paths+p] =
+                            logDiscount[(j-1)*paths+p] - 0.5*(r0+r)*dt;
+                    }
+                }
+
+                std::vector<Real> fixedA(nFixed), fixedB(nFixed*nF);
+                std::vector<Real> startA(nFloating), startB(nFloating*nF),
+                                  endA(nFloating), endB(nFloating*nF),
+                                  payA(nFloating), payB(nFloating*nF);
+                std::vector<Real> couponA(nCoupons), couponB(nCoupons),
+                                  couponStdDev(nCoupons);
+                std::vector<Real> valueA(swaptions_.size()),
+                                  valueB(swaptions_.size());
+                std::vector<char> exercised(swaptions_.size()*paths, 0);
+                std::vector<Real> netted(nettingSets_);
+                std::vector<Real>& blockSums = sums[b];
+                blockSums.assign(nSums, 0.0);
+
+                for (Size j=0; j<nGrid; ++j) {
+                    const Time t = grid_[j];
+
+                    // bond factors for this date, shared by all paths
+                    for (Size f=0; f<nFixed; ++f) {
+                        if (t < fixedLastTime_[f])
+                            fixedA[f] = bondFactors(*model_, meanReversions,
+                                                    t, fixedPayTime_[f],
+                                                    &fixedB[f*nF]);
+                    }
+                    for (Size f=0; f<nFloating; ++f) {
+                        if (t < floatingPay_[f]) {
+                            payA[f] = bondFactors(*model_, meanReversions,
+                                                  t, floatingPay_[f],
+                                                  &payB[f*nF]);
+                            if (j <= floatingFixingIndex_[f]) {
+                                startA[f] = bondFactors(
+                                    *model_, meanReversions, t,
+                                    floatingStart_[f], &startB[f*nF]);
+                                endA[f] = bondFactors(
+                                    *model_, meanReversions, t,
+                                    floatingEnd_[f], &endB[f*nF]);
+                            }
+                        }
+                    }
+                    // swaptions are only added under Hull-White
+                    for (Size s=0; s<swaptions_.size(); ++s) {
+                        const SwaptionData& data = swaptions_[s];
+                        if (t >= data.expiry)
+                            continue;
+                        const Real a = hullWhite_->a(),
+                                   sigma = hullWhite_->sigma();
+                        valueA[s] =
+                            hullWhite_->discountBond(t, data.valueTime, 0.0);
+                        valueB[s] = B(a, t, data.valueTime);
+                        for (Size c=data.couponBegin; c<data.couponEnd; ++c) {
+                            couponA[c] = hullWhite_->discountBond(
+                                                     t, couponTime_[c], 0.0);
+                            couponB[c] = B(a, t, couponTime_[c]);
+                            couponStdDev[c] = bondOptionStdDev(
+                                a, sigma, data.expiry - t,
+                                data.valueTime - t, couponTime_[c] - t);
+                        }
+                    }
+
+                    for (Size p=0; p<paths; ++p) {
+                        const Real* x = &state[(j*paths+p)*nF];
+                        std::fill(netted.begin(), netted.end(), 0.0);
+                        for (Size k=0; k<trades_.size(); ++k) {
+                            const Trade& trade = trades_[k];
+
+                            // before expiry, a swaption only needs the
+                            // value of its underlying to decide exercise
+                            bool underlyingNeeded = true;
+                            if (trade.swaption != Null<Size>()) {
+                                const SwaptionData& data =
+                                    swaptions_[trade.swaption];
+                                underlyingNeeded = t >= data.expiry
+                                    || j == data.exerciseIndex;
+                            }
+
+                            // value of the (underlying) cash flows
+                            Real value = 0.0;
+                            for (Size f=trade.fixedBegin;
+                                 underlyingNeeded && f<trade.fixedEnd; ++f) {
+                                if (t < fixedLastTime_[f])
+                                    value += fixedAmount_[f]*fixedA[f]
+                                        * std::exp(-dot(&fixedB[f*nF], x, nF));
+                            }
+                            for (Size f=trade.floatingBegin;
+                                 underlyingNeeded && f<trade.floatingEnd;
+                                 ++f) {
+                                if (t >= floatingPay_[f])
+                                    continue;
+                                Real ratio;
+                                if (j <= floatingFixingIndex_[f]) {
+                                    ratio = startA[f]/endA[f]
+                                        * std::exp(dot(&endB[f*nF], x, nF)
+                                                   - dot(&startB[f*nF], x, nF));
+                                } else {
+                                    const Real* xf = &state[
+                                        (floatingFixingIndex_[f]*paths+p)*nF];
+                                    ratio = fixingStartA[f]/fixingEndA[f]
+                                        * std::exp(
+                                            dot(&fixingEndB[f*nF], xf, nF)
+                                            - dot(&fixingStartB[f*nF], xf, nF));
+                                }
+                                value += floatingMultiplier_[f]*(ratio-1.0)
+                                    * payA[f]
+                                    * std::exp(-dot(&payB[f*nF], x, nF));
+                            }
+
+                            if (trade.swaption != Null<Size>()) {
+                                const Size s = trade.swaption;
+                                const SwaptionData& data = swaptions_[s];
+                                const Real r = x[0];
+                                if (j == data.exerciseIndex)
+                                    exercised[s*paths+p] = value > 0.0;
+                                if (t < data.expiry) {
+                                    Real start = valueA[s]
+                                        * std::exp(-valueB[s]*r);
+                                    value = 0.0;
+                                    for (Size c=data.couponBegin;
+                                         c<data.couponEnd; ++c) {
+                                        Real bond = couponA[c]
+                                            * std::exp(-couponB[c]*r);
+                                        value += couponAmount_[c]
+                                            * blackFormula(data.type,
+                                                           couponStrike_[c]
+                                                           *start,
+                                                           bond,
+                                                           couponStdDev[c]);
+                                    }
+                                } else if (exercised[s*paths+p] == 0) {
+                                    value = 0.0;
+                                }
+                            }
+
+                            netted[trade.nettingSet] += value;
+                        }
+
+                        if (j == 0)
+                            continue;
+                        const Size d = j-1;
+                        const Real discount =
+                            std::exp(logDiscount[j*paths+p]);
+                        for (Size n=0; n<nettingSets_; ++n) {
+                            Real v = netted[n];
+                            values_[(n*nDates+d)*samples_ + firstPath+p] =
+                                static_cast<float>(v);
+                            Real* sum = &blockSums[4*(n*nDates+d)];
+                            if (v > 0.0) {
+                                sum[0] += v;
+                                sum[2] += discount*v;
+                            } else {
+                                sum[1] += v;
+                                sum[3] += discount*v;
+                            }
+                        }
+                    }
+                }
+            } catch (...) {
+                errors[b] = std::current_exception();
+            }
+        }
+
+        for (Size b=0; b<blocks; ++b) {
+            if (errors[b])
+                std::rethrow_exception(errors[b]);
+        }
+
+        std::vector<ExposureProfile> profiles(nettingSets_);
+        std::vector<Real> buffer(samples_);
+        const Size quantileIndex = std::min<Size>(
+            samples_-1, Size(std::ceil(pfeQuantile_*samples_)) - 1);
+        for (Size n=0; n<nettingSets_; ++n) {
+            ExposureProfile& profile = profiles[n];
+            profile.expectedExposure.assign(nDates, 0.0);
+            profile.expectedNegativeExposure.assign(nDates, 0.0);
+            profile.discountedExpectedExposure.assign(nDates, 0.0);
+            profile.discountedExpectedNegativeExposure.assign(nDates, 0.0);
+            profile.potentialFutureExposure.assign(nDates, 0.0);
+            for (Size d=0; d<nDates; ++d) {
+                Real total[4] = { 0.0, 0.0, 0.0, 0.0 };
+                for (Size b=0; b<blocks; ++b)
+                    for (Size i=0; i<4; ++i)
+                        total[i] += sums[b][4*(n*nDates+d)+i];
+                profile.expectedExposure[d] = total[0]/samples_;
+                profile.expectedNegativeExposure[d] = total[1]/samples_;
+                profile.discountedExpectedExposure[d] = total[2]/samples_;
+                profile.discountedExpectedNegativeExposure[d] =
+                    total[3]/samples_;
+
+                const float* v = &values_[(n*nDates+d)*samples_];
+                std::copy(v, v+samples_, buffer.begin());
+                std::nth_element(buffer.begin(),
+                                 buffer.begin()+quantileIndex,
+                                 buffer.end());
+                profile.potentialFutureExposure[d] =
+                    std::max(buffer[quantileIndex], 0.0);
+            }
+        }
+        return profiles;
+    }
+
+    Real ExposureSimulator::nettedValue(Size nettingSet, Size date,
+                                        Size path) const {
+        QL_REQUIRE(!values_.empty(), "exposures not calculated");
+        QL_REQUIRE(nettingSet < nettingSets_,
+                   "netting set #" << nettingSet << " out of range");
+        QL_REQUIRE(date < times_.size(), "date #" << date << " out of range");
+        QL_REQUIRE(path < samples_, "path #" << path << " out of range");
+        return values_[(nettingSet*times_.size()+date)*samples_ + path];
+    }
+
+}
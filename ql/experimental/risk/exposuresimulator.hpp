@@ -0,0 +1,179 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file exposuresimulator.hpp
+    \brief Monte Carlo exposure profiles under Gaussian short-rate models
+*/
+
+#ifndef quantlib_exposure_simulator_hpp
+#define quantlib_exposure_simulator_hpp
+
+#include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
+#include <ql/models/shortrate/twofactormodels/g2.hpp>
+#include <ql/instruments/forwardrateagreement.hpp>
+#include <ql/instruments/vanillaswap.hpp>
+#include <ql/instruments/swaption.hpp>
+#include <vector>
+
+namespace QuantLib {
+
+    //! exposure profile of a netting set
+    /*! Each entry refers to the corresponding exposure date.  Exposures
+        are the positive and negative parts of the netted value; the
+        discounted ones are weighted by the simulated bank account, as
+        needed for CVA and DVA.
+    */
+    struct ExposureProfile {
+        std::vector<Real> expectedExposure;
+        std::vector<Real> expectedNegativeExposure;
+        std::vector<Real> potentialFutureExposure;
+        std::vector<Real> discountedExpectedExposure;
+        std::vector<Real> discountedExpectedNegativeExposure;
+    };
+
+    //! Monte Carlo simulation of counterparty exposures
+    /*! The state variables of a Hull-White or G2++ model are
+        simulated exactly on the grid of exposure dates; at each date,
+        trades are revalued on each path with the analytic bond prices
+        of the model, which have the affine form
+        \f$ P(t,T) = A(t,T) e^{-\sum_k B_k(t,T) x_k(t)} \f$.
+
+        Trades are stored as contiguous arrays of cash flows (fixed
+        amounts and single-curve floating coupons, forecast on the
+        model curve); the factors \f$ A \f$ and \f$ B_k \f$ are
+        computed once per date and flow and shared by all paths.
+        European swaptions are valued before expiry through
+        Jamshidian's decomposition, conditional on the simulated rate;
+        after expiry they turn into their underlying swap on the paths
+        where it had a positive value.
+
+        Paths are processed in blocks, in parallel; only the netted
+        values of each netting set are kept (as single-precision
+        floats, for the calculation of the PFE quantiles), so that the
+        memory used doesn't depend on the number of trades.
+
+        \warning Floating coupons fixing between two simulation dates
+                 and swaptions expiring between two simulation dates
+                 use the state at the earlier date; the bank account
+                 is integrated with the trapezoidal rule on the same
+                 dates.  The exposure dates should be dense enough for
+                 the purpose at hand.
+
+        \warning Swaptions can only be added under the Hull-White
+                 model.  Jamshidian's decomposition requires the
+                 value of the underlying coupon bond to be monotonic
+                 in a single state variable, which is not the case
+                 in G2++; there, the conditional value of a swaption
+                 would need a numerical integration on each path and
+                 date.
+
+        \test the expected values of swaps and FRAs under both
+              models, and of swaptions under Hull-White, are checked
+              against their model prices; netting is checked against
+              offsetting trades.
+    */
+    class ExposureSimulator {
+      public:
+        ExposureSimulator(const ext::shared_ptr<HullWhite>& model,
+                          const std::vector<Date>& exposureDates,
+                          Size samples,
+                          BigNatural seed = 42,
+                          Real pfeQuantile = 0.95,
+                          Size pathsPerBlock = 1024);
+        ExposureSimulator(const ext::shared_ptr<G2>& model,
+                          const std::vector<Date>& exposureDates,
+                          Size samples,
+                          BigNatural seed = 42,
+                          Real pfeQuantile = 0.95,
+                          Size pathsPerBlock = 1024);
+        //! \name Portfolio
+        //@{
+        //! adds a swap; floating coupons must have no caps or floors
+        void addSwap(const VanillaSwap& swap, Size nettingSet = 0);
+        /*! adds a FRA, alive until its value date; the forward rate
+            is the one implied by the model curve between its value
+            and maturity dates.
+        */
+        void addFra(const ForwardRateAgreement& fra, Size nettingSet = 0);
+        //! adds a long, physically-settled European swaption
+        /*! \pre the simulator must use the Hull-White model */
+        void addSwaption(const ext::shared_ptr<Swaption>& swaption,
+                         Size nettingSet = 0);
+        Size trades() const { return trades_.size(); }
+        Size nettingSets() const { return nettingSets_; }
+        //@}
+        //! \name Calculations
+        //@{
+        const std::vector<Time>& exposureTimes() const { return times_; }
+        //! returns one profile per netting set
+        std::vector<ExposureProfile> calculate() const;
+        //! the netted value of a set on a path at an exposure date
+        Real nettedValue(Size nettingSet, Size date, Size path) const;
+        //@}
+      private:
+        struct Trade {
+            Size nettingSet;
+            Size fixedBegin, fixedEnd;
+            Size floatingBegin, floatingEnd;
+            Size swaption;  // Null<Size>() if not a swaption
+        };
+        struct SwaptionData {
+            Time expiry, valueTime;
+            Size exerciseIndex;  // last simulation date before expiry
+            Size couponBegin, couponEnd;
+            Option::Type type;
+        };
+        void initialize(const std::vector<Date>& exposureDates);
+        Time time(const Date& d) const;
+        Size lastSimulationDate(Time t) const;
+        void addFixedFlow(Time payTime, Real amount, Time lastTime);
+        void addLegs(const VanillaSwap& swap);
+        void addTrade(Size nettingSet, Size fixedBegin, Size floatingBegin,
+                      Size swaption);
+
+        ext::shared_ptr<AffineModel> model_;
+        ext::shared_ptr<HullWhite> hullWhite_;  // null under G2++
+        ext::shared_ptr<G2> g2_;                // null under Hull-White
+        Handle<YieldTermStructure> termStructure_;
+        Size factors_;
+        std::vector<Time> times_;  // exposure times
+        std::vector<Time> grid_;   // simulation times, starting at 0
+        Size samples_;
+        BigNatural seed_;
+        Real pfeQuantile_;
+        Size pathsPerBlock_;
+
+        std::vector<Trade> trades_;
+        Size nettingSets_;
+        // fixed cash flows
+        std::vector<Time> fixedPayTime_, fixedLastTime_;
+        std::vector<Real> fixedAmount_;
+        // floating coupons, paying multiplier*(P(S)/P(E)-1) at pay time
+        std::vector<Time> floatingStart_, floatingEnd_, floatingPay_;
+        std::vector<Real> floatingMultiplier_;
+        std::vector<Size> floatingFixingIndex_;
+        // swaptions, as options on coupon bonds
+        std::vector<SwaptionData> swaptions_;
+        std::vector<Time> couponTime_;
+        std::vector<Real> couponAmount_, couponStrike_;
+
+        mutable std::vector<float> values_;
+    };
+
+}
+
+#endif
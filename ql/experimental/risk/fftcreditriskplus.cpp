@@ -0,0 +1,376 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <ql/experimental/risk/fftcreditriskplus.hpp>
+#include <ql/math/fastfouriertransform.hpp>
+#include <ql/errors.hpp>
+#include <algorithm>
+#include <complex>
+#include <exception>
+#include <map>
+#include <numeric>
+
+namespace QuantLib {
+
+    namespace {
+
+        typedef std::complex<Real> complex;
+
+        // adjusted default probabilities of a sector, summed by number
+        // of loss units
+        typedef std::map<unsigned long, Real> Bands;
+
+        // log of the probability-generating function of the loss at
+        // exp(theta), or QL_MAX_REAL where it diverges
+        Real logGeneratingFunction(const std::vector<Bands>& bands,
+                                   const std::vector<Real>& variances,
+                                   Real theta) {
+            Real result = 0.0;
+            for (Size s = 0; s < bands.size(); ++s) {
+                Real x = 0.0;
+                for (Bands::const_iterator b = bands[s].begin();
+                     b != bands[s].end(); ++b)
+                    x += b->second * (std::exp(theta * b->first) - 1.0);
+                if (variances[s] > 0.0) {
+                    if (variances[s] * x >= 1.0)
+                        return QL_MAX_REAL;
+                    result -= std::log(1.0 - variances[s] * x) / variances[s];
+                } else {
+                    result += x;
+                }
+            }
+            return result;
+        }
+
+        // log of the characteristic function of the loss in a sector,
+        // and factor giving the one conditional on a default in the
+        // sector, at the non-negative frequencies of the transform
+        void sectorTerms(const Bands& bands,
+                         Real variance,
+                         const FastFourierTransform& fft,
+                         std::vector<complex>& logPhi,
+                         std::vector<complex>& sizeBias) {
+            if (bands.empty()) {
+                std::fill(logPhi.begin(), logPhi.end(), complex(0.0));
+                std::fill(sizeBias.begin(), sizeBias.end(), complex(1.0));
+                return;
+            }
+            const Size gridSize = fft.output_size();
+            const Size mask = gridSize - 1;
+            std::vector<complex> a(gridSize, complex(0.0)), A(gridSize);
+            Real mu = 0.0;
+            for (Bands::const_iterator b = bands.begin();
+                 b != bands.end(); ++b) {
+                // larger losses are aliased, as they would be anyway
+                a[b->first & mask] += b->second;
+                mu += b->second;
+            }
+            fft.transform(a.begin(), a.end(), A.begin());
+            for (Size j = 0; j < logPhi.size(); ++j) {
+                complex x = A[j] - mu;
+                if (variance > 0.0) {
+                    complex z = 1.0 - variance * x;
+                    logPhi[j] = -std::log(z) / variance;
+                    sizeBias[j] = 1.0 / z;
+                } else {
+                    logPhi[j] = x;
+                    sizeBias[j] = 1.0;
+                }
+            }
+        }
+
+        // probabilities of the losses 0...n of a distribution given
+        // its characteristic function at the non-negative frequencies
+        void invert(const std::vector<complex>& phi,
+                    const FastFourierTransform& fft,
+                    Size n,
+                    std::vector<Real>& probabilities) {
+            const Size gridSize = fft.output_size();
+            std::vector<complex> spectrum(gridSize), transform(gridSize);
+            std::copy(phi.begin(), phi.end(), spectrum.begin());
+            // the loss is real, the rest of the spectrum is conjugate
+            for (Size j = phi.size(); j < gridSize; ++j)
+                spectrum[j] = std::conj(phi[gridSize - j]);
+            fft.inverse_transform(spectrum.begin(), spectrum.end(),
+                                  transform.begin());
+            probabilities.resize(n + 1);
+            for (Size l = 0; l <= n; ++l)
+                probabilities[l] =
+                    std::max<Real>(transform[l].real() / gridSize, 0.0);
+        }
+
+    }
+
+    FFTCreditRiskPlus::FFTCreditRiskPlus(
+        const std::vector<Real> &exposure,
+        const std::vector<Real> &defaultProbability,
+        const std::vector<Size> &sector,
+        const std::vector<Real> &relativeDefaultVariance,
+        const Real unit,
+        Probability contributionLevel,
+        Probability truncationLevel)
+        : exposure_(exposure), pd_(defaultProbability), sector_(sector),
+          relativeDefaultVariance_(relativeDefaultVariance), unit_(unit),
+          contributionLevel_(contributionLevel),
+          truncationLevel_(truncationLevel) {
+
+        m_ = exposure_.size();
+
+        QL_REQUIRE(m_ > 0, "no exposures given");
+        QL_REQUIRE(m_ == pd_.size(), "number of exposures ("
+                                         << m_
+                                         << ") must be equal to number of pds ("
+                                         << pd_.size() << ")");
+        QL_REQUIRE(m_ == sector_.size(),
+                   "number of exposures ("
+                       << m_
+                       << ") must be equal to number of exposure sectors ("
+                       << sector_.size() << ")");
+
+        n_ = relativeDefaultVariance_.size();
+        QL_REQUIRE(n_ > 0, "no sectors given");
+        for (Size i = 0; i < n_; ++i)
+            QL_REQUIRE(relativeDefaultVariance_[i] >= 0.0,
+                       "relative default variance #"
+                           << i << " is negative ("
+                           << relativeDefaultVariance_[i] << ")");
+
+        exposureSum_ = 0.0;
+        el_ = 0.0;
+        for (Size i = 0; i < m_; ++i) {
+            QL_REQUIRE(exposure_[i] >= 0.0, "exposure #"
+                                                << i << " is negative ("
+                                                << exposure_[i] << ")");
+            QL_REQUIRE(pd_[i] > 0.0, "pd #" << i << " is negative (" << pd_[i]
+                                            << ")");
+            QL_REQUIRE(sector_[i] < n_, "sector #" << i << " (" << sector_[i]
+                                                   << ") is out of range 0..."
+                                                   << (n_ - 1));
+            exposureSum_ += exposure_[i];
+            el_ += pd_[i] * exposure_[i];
+        }
+
+        QL_REQUIRE(unit_ > 0.0, "loss unit (" << unit_ << ") must be positive");
+        QL_REQUIRE(truncationLevel_ > 0.0 && truncationLevel_ < 1.0,
+                   "truncation level (" << truncationLevel_
+                                        << ") out of range (0, 1)");
+        QL_REQUIRE(contributionLevel_ > 0.0 &&
+                       contributionLevel_ < truncationLevel_,
+                   "contribution level ("
+                       << contributionLevel_ << ") out of range (0, "
+                       << truncationLevel_ << ")");
+
+        compute();
+    }
+
+    Real FFTCreditRiskPlus::lossQuantile(Probability p) const {
+        QL_REQUIRE(p >= 0.0 && p <= truncationLevel_,
+                   "level (" << p << ") out of range [0, " << truncationLevel_
+                             << "]");
+        Real sum = 0.0;
+        for (Size i = 0; i < loss_.size(); ++i) {
+            sum += loss_[i];
+            if (sum >= p)
+                return i * unit_;
+        }
+        return truncationLoss();
+    }
+
+    void FFTCreditRiskPlus::compute() {
+
+        // compute exposure bands, as in CreditRiskPlus
+
+        std::vector<unsigned long> nu(m_, 0);
+        std::vector<Real> pdAdj(m_, 0.0);
+        std::vector<Bands> bands(n_);
+        std::vector<std::vector<Size> > obligors(n_);
+        std::vector<Real> sectorPoissonVariance(n_, 0.0);
+        sectorEl_ = std::vector<Real>(n_, 0.0);
+        unsigned long maxNu = 0;
+
+        for (Size k = 0; k < m_; ++k) {
+            auto exUnit = (unsigned long)(std::floor(0.5 + exposure_[k] / unit_)); // round
+            if (exposure_[k] > 0 && exUnit == 0)
+                exUnit = 1; // but avoid zero exposure
+            if (exUnit == 0)
+                continue;
+            const Size s = sector_[k];
+            nu[k] = exUnit;
+            pdAdj[k] = exposure_[k] * pd_[k] / (exUnit * unit_); // adjusted pd
+            bands[s][exUnit] += pdAdj[k];
+            obligors[s].push_back(k);
+            sectorEl_[s] += exposure_[k] * pd_[k];
+            sectorPoissonVariance[s] +=
+                pdAdj[k] * (exUnit * unit_) * (exUnit * unit_);
+            maxNu = std::max(maxNu, exUnit);
+        }
+        QL_REQUIRE(maxNu > 0, "no positive exposure given");
+
+        // moments of the loss on the grid
+
+        sectorUl_ = std::vector<Real>(n_, 0.0);
+        ul_ = 0.0;
+        for (Size s = 0; s < n_; ++s) {
+            sectorUl_[s] = relativeDefaultVariance_[s] * sectorEl_[s] *
+                               sectorEl_[s] +
+                           sectorPoissonVariance[s];
+            ul_ += sectorUl_[s];
+            sectorUl_[s] = std::sqrt(sectorUl_[s]);
+        }
+        ul_ = std::sqrt(ul_);
+
+        // truncate the grid where the Chernoff bound
+        // P(L >= n) <= G(e^theta) e^{-theta n} reaches the target
+
+        Real thetaMax = 700.0 / maxNu; // avoids overflows
+        if (logGeneratingFunction(bands, relativeDefaultVariance_,
+                                  thetaMax) == QL_MAX_REAL) {
+            Real lower = 0.0;
+            for (Size i = 0; i < 60; ++i) {
+                Real theta = 0.5 * (lower + thetaMax);
+                if (logGeneratingFunction(bands, relativeDefaultVariance_,
+                                          theta) == QL_MAX_REAL)
+                    thetaMax = theta;
+                else
+                    lower = theta;
+            }
+            thetaMax = lower;
+        }
+        const Real logTail = std::log(1.0 - truncationLevel_);
+        Real bound = QL_MAX_REAL;
+        const Size steps = 100;
+        for (Size i = 1; i <= steps; ++i) {
+            Real theta = thetaMax * i / steps;
+            Real logG =
+                logGeneratingFunction(bands, relativeDefaultVariance_, theta);
+            if (logG != QL_MAX_REAL)
+                bound = std::min(bound, (logG - logTail) / theta);
+        }
+        QL_REQUIRE(bound < Real(1UL << 30),
+                   "loss grid too large for truncation level "
+                       << truncationLevel_ << " and unit " << unit_);
+        const auto upperIndex = Size(std::ceil(bound));
+
+        FastFourierTransform fft(std::max<std::size_t>(
+            FastFourierTransform::min_order(upperIndex + 1), 1));
+        const Size frequencies = fft.output_size() / 2 + 1;
+
+        // aggregate the sector terms, computed in parallel over blocks
+        // of sectors and added in sector order
+
+        const Size blockSize = 16;
+        std::vector<complex> logPhi(frequencies, complex(0.0));
+        std::vector<std::vector<complex> > sectorLogPhi(
+            std::min(blockSize, n_), std::vector<complex>(frequencies));
+        std::vector<std::exception_ptr> errors(n_);
+        for (Size b = 0; b < n_; b += blockSize) {
+            const Size end = std::min(b + blockSize, n_);
+            #if !defined(QL_ENABLE_SESSIONS)
+            #pragma omp parallel for
+            #endif
+            for (long s = long(b); s < long(end); ++s) {
+                try {
+                    std::vector<complex> sizeBias(frequencies);
+                    sectorTerms(bands[s], relativeDefaultVariance_[s], fft,
+                                sectorLogPhi[s - b], sizeBias);
+                } catch (...) {
+                    errors[s] = std::current_exception();
+                }
+            }
+            for (Size s = b; s < end; ++s) {
+                if (errors[s])
+                    std::rethrow_exception(errors[s]);
+                for (Size j = 0; j < frequencies; ++j)
+                    logPhi[j] += sectorLogPhi[s - b][j];
+            }
+        }
+
+        // compute loss distribution
+
+        std::vector<complex> phi(frequencies);
+        for (Size j = 0; j < frequencies; ++j)
+            phi[j] = std::exp(logPhi[j]);
+        invert(phi, fft, upperIndex, loss_);
+
+        std::vector<Real> cumulative(upperIndex + 1);
+        std::partial_sum(loss_.begin(), loss_.end(), cumulative.begin());
+        const Size varIndex =
+            std::min<Size>(std::lower_bound(cumulative.begin(),
+                                            cumulative.end(),
+                                            contributionLevel_) -
+                               cumulative.begin(),
+                           upperIndex);
+        Real tail = 0.0, tailLoss = 0.0;
+        for (Size n = varIndex; n <= upperIndex; ++n) {
+            tail += loss_[n];
+            tailLoss += n * loss_[n];
+        }
+        valueAtRisk_ = varIndex * unit_;
+        expectedShortfall_ = tailLoss / tail * unit_;
+
+        // compute risk contributions: the expected loss of an obligor
+        // on the tail is its expected loss times the probability that
+        // the loss conditional on a default in its sector, less its
+        // own exposure, is on the tail
+
+        riskContributions_ = std::vector<Real>(m_, 0.0);
+        std::fill(errors.begin(), errors.end(), std::exception_ptr());
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for schedule(dynamic)
+        #endif
+        for (long s = 0; s < long(n_); ++s) {
+            try {
+                // without sector variance, defaults are independent
+                // and the conditional loss is the loss itself
+                std::vector<Real> sectorCumulative;
+                if (!obligors[s].empty() &&
+                    relativeDefaultVariance_[s] > 0.0) {
+                    std::vector<complex> sectorPhi(frequencies),
+                        sizeBias(frequencies);
+                    sectorTerms(bands[s], relativeDefaultVariance_[s], fft,
+                                sectorPhi, sizeBias);
+                    for (Size j = 0; j < frequencies; ++j)
+                        sectorPhi[j] = phi[j] * sizeBias[j];
+                    invert(sectorPhi, fft, upperIndex, sectorCumulative);
+                    std::partial_sum(sectorCumulative.begin(),
+                                     sectorCumulative.end(),
+                                     sectorCumulative.begin());
+                }
+                const std::vector<Real>& c =
+                    relativeDefaultVariance_[s] > 0.0 ? sectorCumulative
+                                                      : cumulative;
+                for (Size i = 0; i < obligors[s].size(); ++i) {
+                    const Size k = obligors[s][i];
+                    if (nu[k] > upperIndex)
+                        continue;
+                    Real p = c[upperIndex - nu[k]];
+                    if (varIndex > nu[k])
+                        p -= c[varIndex - nu[k] - 1];
+                    riskContributions_[k] =
+                        nu[k] * unit_ * pdAdj[k] * p / tail;
+                }
+            } catch (...) {
+                errors[s] = std::current_exception();
+            }
+        }
+        for (Size s = 0; s < n_; ++s) {
+            if (errors[s])
+                std::rethrow_exception(errors[s]);
+        }
+    }
+
+}
@@ -0,0 +1,122 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file fftcreditriskplus.hpp
+    \brief CreditRisk+ sector model computed by Fourier inversion
+*/
+
+#ifndef quantlib_fft_creditriskplus_hpp
+#define quantlib_fft_creditriskplus_hpp
+
+#include <ql/types.hpp>
+#include <vector>
+
+namespace QuantLib {
+
+    //! CreditRisk+ sector model computed by Fourier inversion
+    /*! In the sector model of CreditRisk+ (CSFB, 1997) the default
+        intensity of each obligor is its default probability scaled
+        by the gamma-distributed factor of its sector, with mean 1 and
+        variance given by the sector relative default variance;
+        sectors are independent, and a null variance gives a sector
+        of independent obligors.  Exposures are rounded to a number
+        of loss units, and default probabilities adjusted so that the
+        expected loss is preserved, as in CreditRiskPlus.
+
+        Instead of the Panjer recursion over the whole exposure range,
+        the loss distribution is obtained by inverting its
+        characteristic function, which is the product of closed-form
+        sector terms; the sector terms are computed in parallel by
+        fast Fourier transforms of the exposure bands.  The loss grid
+        is truncated at a loss whose exceedance probability is bounded
+        by one minus the given truncation level, using a Chernoff
+        bound on the probability-generating function; losses beyond
+        it only affect the results through the aliasing of the
+        transform, which is bounded by the same probability.
+
+        Expected-shortfall contributions of the obligors at the given
+        level are computed in the same pass: for each sector, the
+        distribution of the loss conditional on a default in the
+        sector is obtained from the same characteristic function by
+        increasing the sector gamma shape by one.  The contributions
+        add up to the expected shortfall.
+
+        \test the loss distribution is checked against the Panjer
+              recursion of CreditRiskPlus for a single sector and
+              against the convolution of single-sector distributions
+              for independent sectors; risk contributions are checked
+              to add up to the expected shortfall.
+    */
+    class FFTCreditRiskPlus {
+      public:
+        FFTCreditRiskPlus(const std::vector<Real>& exposure,
+                          const std::vector<Real>& defaultProbability,
+                          const std::vector<Size>& sector,
+                          const std::vector<Real>& relativeDefaultVariance,
+                          Real unit,
+                          Probability contributionLevel = 0.999,
+                          Probability truncationLevel = 0.999999);
+
+        //! probabilities of the losses on the grid, in loss units
+        const std::vector<Real>& loss() const { return loss_; }
+        //! largest loss on the grid
+        Real truncationLoss() const { return (loss_.size() - 1) * unit_; }
+
+        Real exposure() const { return exposureSum_; }
+        Real expectedLoss() const { return el_; }
+        Real unexpectedLoss() const { return ul_; }
+        const std::vector<Real>& sectorExpectedLoss() const {
+            return sectorEl_;
+        }
+        const std::vector<Real>& sectorUnexpectedLoss() const {
+            return sectorUl_;
+        }
+
+        /*! smallest loss on the grid whose cumulative probability is
+            not less than the given level
+        */
+        Real lossQuantile(Probability p) const;
+        //! loss quantile at the contribution level
+        Real valueAtRisk() const { return valueAtRisk_; }
+        /*! expected loss on the grid, conditional on the loss being
+            not less than the value at risk
+        */
+        Real expectedShortfall() const { return expectedShortfall_; }
+        //! contributions of the obligors to the expected shortfall
+        const std::vector<Real>& riskContributions() const {
+            return riskContributions_;
+        }
+
+      private:
+        const std::vector<Real> exposure_;
+        const std::vector<Real> pd_;
+        const std::vector<Size> sector_;
+        const std::vector<Real> relativeDefaultVariance_;
+        const Real unit_;
+        const Probability contributionLevel_, truncationLevel_;
+
+        Size n_, m_; // number of sectors, exposures
+
+        std::vector<Real> sectorEl_, sectorUl_, loss_, riskContributions_;
+        Real exposureSum_, el_, ul_, valueAtRisk_, expectedShortfall_;
+
+        void compute();
+    };
+
+}
+
+#endif
@@ -0,0 +1,310 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <ql/experimental/risk/portfoliopricer.hpp>
+#include <ql/cashflows/couponpricer.hpp>
+#include <ql/patterns/lazyobject.hpp>
+#include <ql/termstructure.hpp>
+#include <ql/settings.hpp>
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <map>
+#include <set>
+#include <thread>
+
+namespace QuantLib {
+
+    namespace {
+
+        typedef std::chrono::steady_clock clock;
+
+        // depth-first walk of the observer graph; nodes are appended
+        // after the nodes they depend upon
+        void collect(const Observer& node,
+                     std::set<const Observable*>& visited,
+                     std::vector<ext::shared_ptr<Observable> >& sorted) {
+            const Observer::set_type& observables = node.observables();
+            for (Observer::set_type::const_iterator i = observables.begin();
+                 i != observables.end(); ++i) {
+                if (!visited.insert(i->get()).second)
+                    continue;
+                ext::shared_ptr<Observer> observer =
+                    ext::dynamic_pointer_cast<Observer>(*i);
+                if (observer != nullptr)
+                    collect(*observer, visited, sorted);
+                sorted.push_back(*i);
+            }
+        }
+
+        std::vector<ext::shared_ptr<Observable> > dependencies(
+                  const std::vector<ext::shared_ptr<Instrument> >& instruments) {
+            std::set<const Observable*> visited;
+            for (Size i=0; i<instruments.size(); ++i)
+                visited.insert(instruments[i].get());
+            std::vector<ext::shared_ptr<Observable> > sorted;
+            for (Size i=0; i<instruments.size(); ++i)
+                collect(*instruments[i], visited, sorted);
+            return sorted;
+        }
+
+        // coupon pricers are observed by the floating-rate coupons,
+        // which are in turn observed by the instruments (possibly
+        // through other instruments, e.g., composite ones)
+        void collectCouponPricers(const Observer& node,
+                                  std::set<const Observable*>& visited,
+                                  std::vector<const Observable*>& pricers) {
+            const Observer::set_type& observables = node.observables();
+            for (Observer::set_type::const_iterator i = observables.begin();
+                 i != observables.end(); ++i) {
+                if (!visited.insert(i->get()).second)
+                    continue;
+                if (ext::dynamic_pointer_cast<FloatingRateCouponPricer>(*i)
+                    != nullptr) {
+                    pricers.push_back(i->get());
+                } else if (ext::dynamic_pointer_cast<CashFlow>(*i) != nullptr
+                           || ext::dynamic_pointer_cast<Instrument>(*i)
+                              != nullptr) {
+                    ext::shared_ptr<Observer> observer =
+                        ext::dynamic_pointer_cast<Observer>(*i);
+                    if (observer != nullptr)
+                        collectCouponPricers(*observer, visited, pricers);
+                }
+            }
+        }
+
+        Size root(std::vector<Size>& parent, Size i) {
+            while (parent[i] != i)
+                i = parent[i] = parent[parent[i]];
+            return i;
+        }
+
+        void priceGroup(
+                   const std::vector<ext::shared_ptr<Instrument> >& instruments,
+                   const std::vector<Size>& group,
+                   PortfolioResults& results) {
+            for (Size j=0; j<group.size(); ++j) {
+                const Size i = group[j];
+                try {
+                    results.npv[i] = instruments[i]->NPV();
+                    results.valid[i] = 1;
+                } catch (std::exception& e) {
+                    results.error[i] = e.what();
+                    continue;
+                }
+                try {
+                    results.errorEstimate[i] = instruments[i]->errorEstimate();
+                } catch (Error&) {
+                    // not provided by the engine
+                }
+            }
+        }
+
+    }
+
+    void PortfolioPricer::add(const ext::shared_ptr<Instrument>& instrument,
+                              const ext::shared_ptr<PricingEngine>& engine,
+                              bool threadSafeEngine) {
+        QL_REQUIRE(instrument, "null instrument");
+        QL_REQUIRE(engine, "null pricing engine");
+        for (Size i=0; i<instruments_.size(); ++i) {
+            QL_REQUIRE(instruments_[i] != instrument,
+                       "instrument already in portfolio");
+            QL_REQUIRE(engines_[i] != engine
+                       || (threadSafe_[i] != 0) == threadSafeEngine,
+                       "engine already declared as "
+                       << (threadSafeEngine ? "not " : "")
+                       << "thread-safe");
+        }
+        instrument->setPricingEngine(engine);
+        instruments_.push_back(instrument);
+        engines_.push_back(engine);
+        threadSafe_.push_back(threadSafeEngine ? 1 : 0);
+    }
+
+    void PortfolioPricer::add(
+           const std::vector<ext::shared_ptr<Instrument> >& instruments,
+           const ext::function<ext::shared_ptr<PricingEngine>()>& engineFactory,
+           Size clones) {
+        QL_REQUIRE(engineFactory, "null engine factory");
+        if (instruments.empty())
+            return;
+        if (clones == 0)
+            clones = std::max<Size>(std::thread::hardware_concurrency(), 1);
+        clones = std::min(clones, instruments.size());
+        std::vector<ext::shared_ptr<PricingEngine> > engines(clones);
+        for (Size k=0; k<clones; ++k) {
+            engines[k] = engineFactory();
+            QL_REQUIRE(engines[k], "null pricing engine");
+            QL_REQUIRE(std::find(engines.begin(), engines.begin()+k,
+                                 engines[k]) == engines.begin()+k
+                       && std::find(engines_.begin(), engines_.end(),
+                                    engines[k]) == engines_.end(),
+                       "engine factory returned an engine already in use");
+        }
+        for (Size i=0; i<instruments.size(); ++i)
+            add(instruments[i], engines[i % clones], true);
+    }
+
+    std::vector<ext::shared_ptr<LazyObject> >
+    PortfolioPricer::sharedObjects() const {
+        std::vector<ext::shared_ptr<Observable> > nodes =
+            dependencies(instruments_);
+        std::vector<ext::shared_ptr<LazyObject> > result;
+        for (Size i=0; i<nodes.size(); ++i) {
+            // instruments used as components of other objects (e.g.,
+            // by rate helpers) are calculated by their owners
+            if (ext::dynamic_pointer_cast<Instrument>(nodes[i]) != nullptr)
+                continue;
+            ext::shared_ptr<LazyObject> lazy =
+                ext::dynamic_pointer_cast<LazyObject>(nodes[i]);
+            if (lazy != nullptr)
+                result.push_back(lazy);
+        }
+        return result;
+    }
+
+    PortfolioResults PortfolioPricer::price(bool recalculate) const {
+        const Size n = instruments_.size();
+
+        PortfolioResults results;
+        results.npv.assign(n, Null<Real>());
+        results.errorEstimate.assign(n, Null<Real>());
+        results.valid.assign(n, 0);
+        results.error.assign(n, std::string());
+        results.setupTime = results.pricingTime = 0.0;
+
+        ObservableSettings& settings = ObservableSettings::instance();
+        const bool updatesWereEnabled = settings.updatesEnabled();
+        const Date evaluationDate = Settings::instance().evaluationDate();
+
+        clock::time_point start = clock::now();
+
+        // Everything that writes to shared state happens here, on the
+        // calling thread: term structures fix their reference date,
+        // lazy objects are recalculated (dependencies first) and the
+        // instruments to be repriced are invalidated.
+        std::vector<ext::shared_ptr<Observable> > nodes =
+            dependencies(instruments_);
+        for (Size i=0; i<nodes.size(); ++i) {
+            ext::shared_ptr<TermStructure> ts =
+                ext::dynamic_pointer_cast<TermStructure>(nodes[i]);
+            if (ts != nullptr)
+                ts->referenceDate();
+        }
+        // The calculation gives the results the objects would return
+        // if asked, so that their observers need not be notified; the
+        // notifications are discarded.  Frozen objects are skipped.
+        std::vector<ext::shared_ptr<LazyObject> > shared = sharedObjects();
+        if (updatesWereEnabled)
+            settings.disableUpdates(false);
+        try {
+            for (Size i=0; i<shared.size(); ++i) {
+                if (!shared[i]->isCalculated() && !shared[i]->isFrozen())
+                    shared[i]->recalculate();
+            }
+        } catch (...) {
+            if (updatesWereEnabled)
+                settings.enableUpdates();
+            throw;
+        }
+
+        if (updatesWereEnabled)
+            settings.disableUpdates(true);
+        if (recalculate) {
+            for (Size i=0; i<n; ++i)
+                instruments_[i]->update();
+        }
+
+        // instruments sharing an engine or a coupon pricer are priced
+        // by the same thread; groups whose engines are all thread-safe
+        // are priced in parallel
+        std::vector<Size> parent(n);
+        std::map<const Observable*, Size> owner;
+        for (Size i=0; i<n; ++i) {
+            parent[i] = i;
+            std::vector<const Observable*> resources(1, engines_[i].get());
+            std::set<const Observable*> visited;
+            collectCouponPricers(*instruments_[i], visited, resources);
+            for (Size j=0; j<resources.size(); ++j) {
+                std::pair<std::map<const Observable*, Size>::iterator, bool>
+                    r = owner.insert(std::make_pair(resources[j], i));
+                if (!r.second)
+                    parent[root(parent, i)] = root(parent, r.first->second);
+            }
+        }
+        std::map<Size, std::vector<Size> > members;
+        std::map<Size, bool> threadSafeGroup;
+        for (Size i=0; i<n; ++i) {
+            const Size g = root(parent, i);
+            members[g].push_back(i);
+            std::map<Size, bool>::iterator t =
+                threadSafeGroup.insert(std::make_pair(g, true)).first;
+            t->second = t->second && threadSafe_[i] != 0;
+        }
+        std::vector<std::vector<Size> > serialGroups, parallelGroups;
+        for (std::map<Size, std::vector<Size> >::iterator g = members.begin();
+             g != members.end(); ++g) {
+            std::vector<std::vector<Size> >& groups =
+                threadSafeGroup[g->first] ? parallelGroups : serialGroups;
+            groups.push_back(g->second);
+        }
+
+        clock::time_point pricingStart = clock::now();
+        results.setupTime =
+            std::chrono::duration<Real>(pricingStart - start).count();
+
+        std::vector<std::exception_ptr> errors(parallelGroups.size() + 1);
+
+        try {
+            for (Size k=0; k<serialGroups.size(); ++k)
+                priceGroup(instruments_, serialGroups[k], results);
+        } catch (...) {
+            errors.front() = std::current_exception();
+        }
+
+        if (!errors.front()) {
+            #if !defined(QL_ENABLE_SESSIONS)
+            #pragma omp parallel for schedule(dynamic)
+            #endif
+            for (long k=0; k<long(parallelGroups.size()); ++k) {
+                try {
+                    priceGroup(instruments_, parallelGroups[k], results);
+                } catch (...) {
+                    errors[k+1] = std::current_exception();
+                }
+            }
+        }
+
+        results.pricingTime =
+            std::chrono::duration<Real>(clock::now() - pricingStart).count();
+
+        if (updatesWereEnabled)
+            settings.enableUpdates();
+
+        for (Size k=0; k<errors.size(); ++k) {
+            if (errors[k])
+                std::rethrow_exception(errors[k]);
+        }
+
+        QL_ENSURE(Settings::instance().evaluationDate() == evaluationDate,
+                  "evaluation date changed while pricing the portfolio");
+
+        return results;
+    }
+
+}
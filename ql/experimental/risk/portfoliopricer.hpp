@@ -0,0 +1,163 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file portfoliopricer.hpp
+    \brief parallel revaluation of a portfolio of instruments
+*/
+
+#ifndef quantlib_portfolio_pricer_hpp
+#define quantlib_portfolio_pricer_hpp
+
+#include <ql/functional.hpp>
+#include <ql/instrument.hpp>
+#include <ql/pricingengine.hpp>
+#include <string>
+#include <vector>
+
+namespace QuantLib {
+
+    class LazyObject;
+
+    //! results of a portfolio revaluation, stored by column
+    /*! The i-th entry of each column refers to the i-th instrument
+        added to the pricer.  Instruments whose pricing failed have
+        <tt>valid[i] == 0</tt>, a null NPV and the error message in
+        <tt>error[i]</tt>.
+    */
+    struct PortfolioResults {
+        std::vector<Real> npv;
+        std::vector<Real> errorEstimate;
+        std::vector<char> valid;
+        std::vector<std::string> error;
+        //! time spent calculating the shared lazy objects
+        Real setupTime;
+        //! time spent pricing the instruments
+        Real pricingTime;
+    };
+
+    //! prices a portfolio of instruments in parallel
+    /*! The pricer walks the observer graph of the instruments (through
+        their engines, handles and term structures) and collects the
+        lazy objects they depend upon.  These are recalculated once, in
+        dependency order and on the calling thread, before any
+        instrument is priced; afterwards they are only read, so that
+        they can be shared safely by the pricing threads.
+
+        Instruments are then grouped so that those sharing a pricing
+        engine, or floating-rate coupons sharing a coupon pricer, fall
+        in the same group.  The instruments in a group are priced one
+        after the other, since both engines and coupon pricers store
+        the state of the calculation in progress and can't be used by
+        two threads at once.  Groups whose engines were all declared
+        thread-safe when added are distributed dynamically among the
+        available threads, so that a long-running group does not hold
+        up the others; the other groups are priced first, on the
+        calling thread.  To price in parallel instruments that would
+        otherwise share an engine, add them with an engine factory;
+        each thread will then use its own clone of the engine.
+
+        An engine can be declared thread-safe only if its calculations
+        neither register observers with shared objects nor send
+        notifications: the observer pattern is not thread-safe, and
+        deferred notifications are collected in a global set.  This
+        excludes, e.g., the engines building a process, a lattice or
+        a term structure observing the market data on each
+        calculation, such as BinomialVanillaEngine and most
+        finite-difference and tree engines.  Analytic engines such as
+        AnalyticEuropeanEngine are safe; DiscountingSwapEngine is
+        safe as well, given the grouping by coupon pricer described
+        above, as long as the pricers don't share mutable state in
+        turn (e.g., an optionlet volatility surface being modified.)
+
+        The following is enforced during a run:
+        - each instrument has an engine and appears in the portfolio
+          only once;
+        - notifications are deferred until all instruments are priced,
+          so that a change to the market data can't invalidate the
+          shared objects while they're being read; deferred
+          notifications are sent at the end of the run.
+
+        The following is the responsibility of the caller:
+        - instruments must not share components (e.g., legs of a
+          composite instrument which are also priced on their own)
+          and engines must not share mutable state besides the market
+          data collected above;
+        - engines must not modify the market data they read (e.g.,
+          by relinking handles or setting quote values);
+        - the global evaluation date must not change during a run.
+          A change is detected, and reported as an error, only after
+          all instruments are priced.
+
+        Shared objects whose results are still valid are not
+        recalculated; frozen objects are left alone and keep their
+        cached results.
+
+        When sessions are enabled, each thread might see a different
+        instance of Settings; in that case the instruments are priced
+        on the calling thread.
+
+        \ingroup instruments
+
+        \test the results are checked against the serial NPVs of a
+              portfolio of swaps and options sharing their curves,
+              also when the swaps are priced by engine clones or
+              share a coupon pricer.
+    */
+    class PortfolioPricer {
+      public:
+        /*! adds an instrument and sets the engine used to price it.
+            Instruments are priced in parallel only if their engine is
+            declared thread-safe as described above; an engine must be
+            declared in the same way for all its instruments.
+        */
+        void add(const ext::shared_ptr<Instrument>& instrument,
+                 const ext::shared_ptr<PricingEngine>& engine,
+                 bool threadSafeEngine = false);
+        /*! adds instruments priced by clones of an engine, which are
+            returned by the given factory and are declared thread-safe;
+            each clone prices a share of the instruments, so that they
+            can be priced in parallel.  The factory must return a new
+            engine at each call.  By default, as many clones are
+            created as hardware threads are available.
+        */
+        void add(
+           const std::vector<ext::shared_ptr<Instrument> >& instruments,
+           const ext::function<ext::shared_ptr<PricingEngine>()>& engineFactory,
+           Size clones = 0);
+        Size size() const { return instruments_.size(); }
+        const std::vector<ext::shared_ptr<Instrument> >& instruments() const {
+            return instruments_;
+        }
+        /*! Prices the portfolio.  If \p recalculate is true, all
+            instruments are recalculated even if their cached results
+            are still valid.
+        */
+        PortfolioResults price(bool recalculate = false) const;
+        /*! returns the lazy objects (curves, surfaces...) shared by the
+            instruments, sorted so that each of them comes after the
+            objects it depends upon.
+        */
+        std::vector<ext::shared_ptr<LazyObject> > sharedObjects() const;
+      private:
+        std::vector<ext::shared_ptr<Instrument> > instruments_;
+        std::vector<ext::shared_ptr<PricingEngine> > engines_;
+        std::vector<char> threadSafe_;
+    };
+
+}
+
+#endif
@@ -0,0 +1,249 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <ql/experimental/risk/sensitivityengine.hpp>
+#include <algorithm>
+#include <exception>
+#include <set>
+
+namespace QuantLib {
+
+    namespace {
+
+        void collect(const Observer& node,
+                     std::set<const Observable*>& visited) {
+            const Observer::set_type& observables = node.observables();
+            for (Observer::set_type::const_iterator i = observables.begin();
+                 i != observables.end(); ++i) {
+                if (!visited.insert(i->get()).second)
+                    continue;
+                ext::shared_ptr<Observer> observer =
+                    ext::dynamic_pointer_cast<Observer>(*i);
+                if (observer != nullptr)
+                    collect(*observer, visited);
+            }
+        }
+
+        // a set of simultaneous bumps and the instruments they affect
+        struct Scenario {
+            std::vector<std::pair<Size, Real> > bumps;
+            std::vector<Size> instruments;
+        };
+
+        Scenario makeScenario(Size i, Real shiftI,
+                              Size j, Real shiftJ,
+                              const std::vector<Size>& instruments) {
+            Scenario s;
+            s.bumps.push_back(std::make_pair(i, shiftI));
+            if (j != Null<Size>())
+                s.bumps.push_back(std::make_pair(j, shiftJ));
+            s.instruments = instruments;
+            return s;
+        }
+
+        void evaluate(const SensitivityEngine::Book& book,
+                      const Scenario& scenario,
+                      std::vector<Real>& npvs) {
+            std::vector<Real> values(scenario.bumps.size());
+            for (Size b=0; b<scenario.bumps.size(); ++b)
+                values[b] = book.quotes[scenario.bumps[b].first]->value();
+            try {
+                for (Size b=0; b<scenario.bumps.size(); ++b)
+                    book.quotes[scenario.bumps[b].first]->setValue(
+                                        values[b] + scenario.bumps[b].second);
+                for (Size k=0; k<scenario.instruments.size(); ++k) {
+                    Size i = scenario.instruments[k];
+                    npvs[i] = book.instruments[i]->NPV();
+                }
+            } catch (...) {
+                for (Size b=0; b<scenario.bumps.size(); ++b)
+                    book.quotes[scenario.bumps[b].first]->setValue(values[b]);
+                throw;
+            }
+            for (Size b=0; b<scenario.bumps.size(); ++b)
+                book.quotes[scenario.bumps[b].first]->setValue(values[b]);
+        }
+
+    }
+
+    SensitivityEngine::SensitivityEngine(const std::vector<Book>& books,
+                                         Real shift,
+                                         SensitivityAnalysis type)
+    : books_(books), shift_(shift), type_(type) {
+        QL_REQUIRE(!books_.empty(), "no books given");
+        QL_REQUIRE(shift_ != 0.0, "zero shift not allowed");
+        QL_REQUIRE(type_ == OneSide || type_ == Centered,
+                   "unknown SensitivityAnalysis (" << Integer(type_) << ")");
+        const Size nQuotes = books_.front().quotes.size();
+        const Size nInstruments = books_.front().instruments.size();
+        for (Size b=0; b<books_.size(); ++b) {
+            QL_REQUIRE(books_[b].quotes.size() == nQuotes,
+                       "book #" << b << " has " << books_[b].quotes.size()
+                       << " quotes instead of " << nQuotes);
+            QL_REQUIRE(books_[b].instruments.size() == nInstruments,
+                       "book #" << b << " has "
+                       << books_[b].instruments.size()
+                       << " instruments instead of " << nInstruments);
+            for (Size i=0; i<nQuotes; ++i)
+                QL_REQUIRE(!books_[b].quotes[i].empty(),
+                           "empty quote #" << i << " in book #" << b);
+        }
+
+        // the books are copies of each other, so the first one
+        // is enough to find out which instruments each quote affects
+        reachable_.assign(nQuotes, std::vector<char>(nInstruments, 0));
+        const Book& book = books_.front();
+        for (Size k=0; k<nInstruments; ++k) {
+            std::set<const Observable*> visited;
+            collect(*book.instruments[k], visited);
+            for (Size i=0; i<nQuotes; ++i) {
+                const Observable* quote = book.quotes[i].currentLink().get();
+                if (visited.count(quote) != 0)
+                    reachable_[i][k] = 1;
+            }
+        }
+    }
+
+    SensitivityResults SensitivityEngine::calculate(bool crossGammas) const {
+        QL_REQUIRE(!crossGammas || type_ == Centered,
+                   "cross gammas require a centered scheme");
+
+        const Size nQuotes = reachable_.size();
+        const Size nInstruments = books_.front().instruments.size();
+
+        std::vector<std::vector<Size> > affected(nQuotes);
+        for (Size i=0; i<nQuotes; ++i)
+            for (Size k=0; k<nInstruments; ++k)
+                if (reachable_[i][k] != 0)
+                    affected[i].push_back(k);
+
+        // generate the scenarios; the first one is the base case
+        std::vector<Scenario> scenarios(1);
+        for (Size k=0; k<nInstruments; ++k)
+            scenarios[0].instruments.push_back(k);
+        std::vector<Size> up(nQuotes, Null<Size>()),
+                          down(nQuotes, Null<Size>());
+        for (Size i=0; i<nQuotes; ++i) {
+            if (affected[i].empty())
+                continue;
+            up[i] = scenarios.size();
+            scenarios.push_back(makeScenario(i, shift_, Null<Size>(), 0.0,
+                                             affected[i]));
+            if (type_ == Centered) {
+                down[i] = scenarios.size();
+                scenarios.push_back(makeScenario(i, -shift_, Null<Size>(),
+                                                 0.0, affected[i]));
+            }
+        }
+        // for each pair of quotes, the four corners of the bump square
+        std::vector<std::vector<Size> > corner(
+                       nQuotes, std::vector<Size>(nQuotes, Null<Size>()));
+        if (crossGammas) {
+            for (Size i=0; i<nQuotes; ++i) {
+                for (Size j=i+1; j<nQuotes; ++j) {
+                    std::vector<Size> common;
+                    for (Size k=0; k<affected[i].size(); ++k)
+                        if (reachable_[j][affected[i][k]] != 0)
+                            common.push_back(affected[i][k]);
+                    if (common.empty())
+                        continue;
+                    corner[i][j] = scenarios.size();
+                    Real signs[][2] = { { 1.0,  1.0 }, { 1.0, -1.0 },
+                                        { -1.0, 1.0 }, { -1.0, -1.0 } };
+                    for (Size c=0; c<4; ++c)
+                        scenarios.push_back(makeScenario(i, signs[c][0]*shift_,
+                                                         j, signs[c][1]*shift_,
+                                                         common));
+                }
+            }
+        }
+
+        // evaluate them, each book on a single thread
+        std::vector<std::vector<Real> > npvs(
+                   scenarios.size(), std::vector<Real>(nInstruments, 0.0));
+        const Size nBooks = std::min<Size>(books_.size(), scenarios.size());
+        std::vector<std::exception_ptr> errors(nBooks);
+
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for
+        #endif
+        for (long b=0; b<long(nBooks); ++b) {
+            try {
+                for (Size s=b; s<scenarios.size(); s+=nBooks)
+                    evaluate(books_[b], scenarios[s], npvs[s]);
+            } catch (...) {
+                errors[b] = std::current_exception();
+            }
+        }
+        for (Size b=0; b<errors.size(); ++b) {
+            if (errors[b])
+                std::rethrow_exception(errors[b]);
+        }
+
+        SensitivityResults results;
+        results.npv = npvs[0];
+        results.delta = Matrix(nQuotes, nInstruments, 0.0);
+        results.gamma = Matrix(nQuotes, nInstruments,
+                               type_ == Centered ? 0.0 : Real(Null<Real>()));
+        results.scenarios = scenarios.size();
+        results.revaluations = 0;
+        for (Size s=0; s<scenarios.size(); ++s)
+            results.revaluations += scenarios[s].instruments.size();
+
+        for (Size i=0; i<nQuotes; ++i) {
+            for (Size k=0; k<affected[i].size(); ++k) {
+                Size n = affected[i][k];
+                Real npvUp = npvs[up[i]][n], npv = npvs[0][n];
+                if (type_ == OneSide) {
+                    results.delta[i][n] = (npvUp - npv)/shift_;
+                } else {
+                    Real npvDown = npvs[down[i]][n];
+                    results.delta[i][n] = (npvUp - npvDown)/(2.0*shift_);
+                    results.gamma[i][n] =
+                        (npvUp - 2.0*npv + npvDown)/(shift_*shift_);
+                }
+            }
+        }
+
+        if (crossGammas) {
+            results.crossGamma.assign(nInstruments,
+                                      Matrix(nQuotes, nQuotes, 0.0));
+            for (Size n=0; n<nInstruments; ++n)
+                for (Size i=0; i<nQuotes; ++i)
+                    results.crossGamma[n][i][i] = results.gamma[i][n];
+            for (Size i=0; i<nQuotes; ++i) {
+                for (Size j=i+1; j<nQuotes; ++j) {
+                    Size s = corner[i][j];
+                    if (s == Null<Size>())
+                        continue;
+                    const std::vector<Size>& common = scenarios[s].instruments;
+                    for (Size k=0; k<common.size(); ++k) {
+                        Size n = common[k];
+                        Real value = (npvs[s][n] - npvs[s+1][n]
+                                      - npvs[s+2][n] + npvs[s+3][n])
+                                   / (4.0*shift_*shift_);
+                        results.crossGamma[n][i][j] =
+                            results.crossGamma[n][j][i] = value;
+                    }
+                }
+            }
+        }
+
+        return results;
+    }
+
+}
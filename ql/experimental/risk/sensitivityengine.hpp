@@ -0,0 +1,104 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file sensitivityengine.hpp
+    \brief bucketed sensitivities over replicated market states
+*/
+
+#ifndef quantlib_sensitivity_engine_hpp
+#define quantlib_sensitivity_engine_hpp
+
+#include <ql/experimental/risk/sensitivityanalysis.hpp>
+#include <ql/handle.hpp>
+#include <ql/math/matrix.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/instrument.hpp>
+
+namespace QuantLib {
+
+    //! results of a bucketed sensitivity calculation
+    /*! Rows refer to quotes and columns to instruments; the entries
+        for quotes on which an instrument doesn't depend are zero.
+    */
+    struct SensitivityResults {
+        std::vector<Real> npv;
+        Matrix delta;
+        //! null entries for one-sided schemes
+        Matrix gamma;
+        /*! one quotes-by-quotes matrix per instrument; empty unless
+            cross gammas were requested
+        */
+        std::vector<Matrix> crossGamma;
+        //! number of bumped market states that were priced
+        Size scenarios;
+        //! number of instrument revaluations
+        Size revaluations;
+    };
+
+    //! bucketed sensitivities of a book of instruments
+    /*! The engine bumps each quote in turn (and, for cross gammas,
+        each pair of quotes) and reprices the instruments as prescribed
+        by the SensitivityAnalysis type; it gives the same results as
+        the bucketAnalysis functions, but:
+        - the scenarios are generated up front and evaluated in
+          parallel.  Since the observer graph can't be shared between
+          threads, the caller passes one or more independent copies of
+          the book (quotes, term structures, engines and instruments,
+          sharing no mutable object) and each copy is used by a single
+          thread; the scenarios are distributed among the copies;
+        - for each quote, the engine only reprices the instruments
+          reachable from it through the observer graph; the
+          sensitivities of the others are zero and no revaluation is
+          performed.
+
+        Each copy of the book must list the same quotes and instruments
+        in the same order.  The quotes are restored to their original
+        values after the calculation.  When sessions are enabled, the
+        copies are used one after the other on the calling thread.
+
+        \test the results are checked against the bucketAnalysis
+              functions and against explicit bumping.
+    */
+    class SensitivityEngine {
+      public:
+        struct Book {
+            std::vector<Handle<SimpleQuote> > quotes;
+            std::vector<ext::shared_ptr<Instrument> > instruments;
+        };
+        explicit SensitivityEngine(const std::vector<Book>& books,
+                                   Real shift = 0.0001,
+                                   SensitivityAnalysis type = Centered);
+        /*! calculates deltas and, for centered schemes, gammas and
+            (optionally) cross gammas.
+        */
+        SensitivityResults calculate(bool crossGammas = false) const;
+        /*! returns, for each quote, whether each instrument depends on
+            it through the observer graph.
+        */
+        const std::vector<std::vector<char> >& dependencies() const {
+            return reachable_;
+        }
+      private:
+        std::vector<Book> books_;
+        Real shift_;
+        SensitivityAnalysis type_;
+        std::vector<std::vector<char> > reachable_;
+    };
+
+}
+
+#endif
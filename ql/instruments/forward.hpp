@@ -71,6 +71,10 @@ namespace QuantLib {
         const Calendar& calendar() const;
         BusinessDayConvention businessDayConvention() const;
         const DayCounter& dayCounter() const;
+        //! date the contract starts accruing
+        const Date& valueDate() const;
+        //! maturity of the contract or delivery date of the underlying
+        const Date& maturityDate() const;
         //! term structure relevant to the contract (e.g. repo curve)
         Handle<YieldTermStructure> discountCurve() const;
         //! term structure that discounts the underlying's income cash flows
@@ -178,6 +182,14 @@ namespace QuantLib {
         return dayCounter_;
     }
 
+    inline const Date& Forward::valueDate() const {
+        return valueDate_;
+    }
+
+    inline const Date& Forward::maturityDate() const {
+        return maturityDate_;
+    }
+
     inline Handle<YieldTermStructure> Forward::discountCurve() const {
         return discountCurve_;
     }
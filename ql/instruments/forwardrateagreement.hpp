@@ -85,6 +85,16 @@ namespace QuantLib {
                              const Handle<YieldTermStructure>& discountCurve =
                                                  Handle<YieldTermStructure>(),
                              bool useIndexedCoupon = true);
+        //! \name Inspectors
+        //@{
+        Position::Type type() const { return fraType_; }
+        Real notionalAmount() const { return notionalAmount_; }
+        //! the FRA rate, with the day counter of the index
+        const InterestRate& strikeForwardRate() const {
+            return strikeForwardRate_;
+        }
+        const ext::shared_ptr<IborIndex>& index() const { return index_; }
+        //@}
         //! \name Calculations
         //@{
         /*! A FRA expires/settles on the valueDate */
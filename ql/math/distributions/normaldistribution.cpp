@@ -29,6 +29,7 @@
 #endif
 
 #include <boost/math/distributions/normal.hpp>
+#include <type_traits>
 
 #if defined(__GNUC__) && (((__GNUC__ == 4) && (__GNUC_MINOR__ >= 8)) || (__GNUC__ > 4))
 #pragma GCC diagnostic pop
@@ -182,8 +183,22 @@ namespace QuantLib {
     : average_(average), sigma_(sigma) {}
 
     Real MaddockInverseCumulativeNormal::operator()(Real x) const {
-        return boost::math::quantile(
-            boost::math::normal_distribution<Real>(average_, sigma_), x);
+        const double average = static_cast<double>(average_);
+        const double sigma = static_cast<double>(sigma_);
+        const double p = static_cast<double>(x);
+        const double q = boost::math::quantile(
+            boost::math::normal_distribution<double>(average, sigma), p);
+
+        if (std::is_same<Real, double>::value)
+            return q;
+
+        // Boost.Math works in double precision: a first-order expansion
+        // around the evaluation point carries the derivatives of a
+        // user-defined Real
+        const double z = (q - average)/sigma;
+        const double density = M_SQRT1_2*M_1_SQRTPI*std::exp(-0.5*z*z);
+        return q + (average_ - average) + z*(sigma_ - sigma)
+            + sigma/density*(x - p);
     }
 
     MaddockCumulativeNormal::MaddockCumulativeNormal(
@@ -191,7 +206,19 @@ namespace QuantLib {
     : average_(average), sigma_(sigma) {}
 
     Real MaddockCumulativeNormal::operator()(Real x) const {
-        return boost::math::cdf(
-            boost::math::normal_distribution<Real>(average_, sigma_), x);
+        const double average = static_cast<double>(average_);
+        const double sigma = static_cast<double>(sigma_);
+        const double y = static_cast<double>(x);
+        const double c = boost::math::cdf(
+            boost::math::normal_distribution<double>(average, sigma), y);
+
+        if (std::is_same<Real, double>::value)
+            return c;
+
+        // first-order expansion as in the inverse above
+        const double z = (y - average)/sigma;
+        const double density = M_SQRT1_2*M_1_SQRTPI*std::exp(-0.5*z*z);
+        return c + density/sigma*((x - y) - (average_ - average)
+                                  - z*(sigma_ - sigma));
     }
 }
@@ -246,6 +246,9 @@ namespace QuantLib {
          result that is accurate to ~10^-19, then only if that has
          insufficient accuracy compared to the epsilon for type double,
          do we clean up the result using Halley iteration.
+
+        The result is computed in double precision; with a user-defined
+        Real type, its first derivatives are propagated analytically.
     */
     class MaddockInverseCumulativeNormal {
       public:
@@ -261,6 +264,9 @@ namespace QuantLib {
     };
 
     //! Maddock's cumulative normal distribution class
+    /*! The result is computed in double precision; with a user-defined
+        Real type, its first derivatives are propagated analytically.
+    */
     class MaddockCumulativeNormal {
       public:
         typedef Real argument_type;
@@ -294,8 +300,8 @@ namespace QuantLib {
         Real deltax = x-average_;
         Real exponent = -(deltax*deltax)/denominator_;
         // debian alpha had some strange problem in the very-low range
-        return exponent <= -690.0 ? 0.0 :  // exp(x) < 1.0e-300 anyway
-            normalizationFactor_*std::exp(exponent);
+        return exponent <= -690.0 ? Real(0.0) :  // exp(x) < 1.0e-300 anyway
+            Real(normalizationFactor_*std::exp(exponent));
     }
 
     inline Real NormalDistribution::derivative(Real x) const {
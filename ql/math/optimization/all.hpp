@@ -15,6 +15,7 @@
 #include <ql/math/optimization/linesearchbasedmethod.hpp>
 #include <ql/math/optimization/lmdif.hpp>
 #include <ql/math/optimization/method.hpp>
+#include <ql/math/optimization/multistartoptimizer.hpp>
 #include <ql/math/optimization/problem.hpp>
 #include <ql/math/optimization/projectedconstraint.hpp>
 #include <ql/math/optimization/projectedcostfunction.hpp>
@@ -28,6 +28,8 @@
 #include <ql/math/array.hpp>
 #include <ql/math/matrix.hpp>
 #include <ql/math/functional.hpp>
+#include <exception>
+#include <vector>
 
 namespace QuantLib {
 
@@ -39,7 +41,7 @@ namespace QuantLib {
         virtual Real value(const Array& x) const {
             Array v = values(x);
             std::transform(v.begin(), v.end(), v.begin(), square<Real>());
-            return std::sqrt(std::accumulate(v.begin(), v.end(), 0.0) /
+            return std::sqrt(std::accumulate(v.begin(), v.end(), Real(0.0)) /
                              static_cast<Real>(v.size()));
         }
         //! method to overload to compute the cost function values in x
@@ -48,16 +50,15 @@ namespace QuantLib {
         //! method to overload to compute grad_f, the first derivative of
         //  the cost function with respect to x
         virtual void gradient(Array& grad, const Array& x) const {
-            Real eps = finiteDifferenceEpsilon(), fp, fm;
-            Array xx(x);
+            Real eps = finiteDifferenceEpsilon();
+            std::vector<Array> xx(2*x.size(), x);
             for (Size i=0; i<x.size(); i++) {
-                xx[i] += eps;
-                fp = value(xx);
-                xx[i] -= 2.0*eps;
-                fm = value(xx);
-                grad[i] = 0.5*(fp - fm)/eps;
-                xx[i] = x[i];
+                xx[2*i][i] += eps;
+                xx[2*i+1][i] -= eps;
             }
+            const Array f = batchValue(xx);
+            for (Size i=0; i<x.size(); i++)
+                grad[i] = 0.5*(f[2*i] - f[2*i+1])/eps;
         }
 
         //! method to overload to compute grad_f, the first derivative of
@@ -72,16 +73,18 @@ namespace QuantLib {
         // the cost function with respect to x
         virtual void jacobian(Matrix &jac, const Array &x) const {
             Real eps = finiteDifferenceEpsilon();
-            Array xx(x), fp, fm;
-            for(Size i=0; i<x.size(); ++i) {
-                xx[i] += eps;
-                fp = values(xx);
-                xx[i] -= 2.0*eps;
-                fm = values(xx);
+            std::vector<Array> xx(2*x.size(), x);
+            for (Size i=0; i<x.size(); ++i) {
+                xx[2*i][i] += eps;
+                xx[2*i+1][i] -= eps;
+            }
+            const std::vector<Array> f = batchValues(xx);
+            for (Size i=0; i<x.size(); ++i) {
+                const Array& fp = f[2*i];
+                const Array& fm = f[2*i+1];
                 for(Size j=0; j<fp.size(); ++j) {
                     jac[j][i] = 0.5*(fp[j]-fm[j])/eps;
                 }
-                xx[i] = x[i];
             }
         }
 
@@ -95,8 +98,89 @@ namespace QuantLib {
 
         //! Default epsilon for finite difference method :
         virtual Real finiteDifferenceEpsilon() const { return 1e-8; }
+
+        /*! Returns true if value() and values() can be called
+            concurrently from several threads, i.e., if they don't
+            modify shared state. In this case, batch evaluations
+            (e.g., finite-difference derivatives or the members of a
+            population in global optimizers) are performed in parallel.
+        */
+        virtual bool isThreadSafe() const { return false; }
+
+        //! cost function values at several points
+        /*! The points are evaluated concurrently if the cost function
+            is thread-safe. If any evaluation fails, the error of the
+            first failing point is rethrown.
+        */
+        Disposable<Array> batchValue(const std::vector<Array>& x) const;
+        //! cost function values at several points
+        /*! As above, but the errors are returned point by point in
+            \p errors instead of being rethrown; the values of the
+            failing points are set to QL_MAX_REAL.
+        */
+        Disposable<Array> batchValue(
+                          const std::vector<Array>& x,
+                          std::vector<std::exception_ptr>& errors) const;
+        //! cost function values arrays at several points
+        std::vector<Array> batchValues(const std::vector<Array>& x) const;
     };
 
+    // inline definitions
+
+    inline Disposable<Array> CostFunction::batchValue(
+                                        const std::vector<Array>& x) const {
+        std::vector<std::exception_ptr> errors;
+        Array result = batchValue(x, errors);
+
+        for (Size i=0; i<errors.size(); ++i)
+            if (errors[i])
+                std::rethrow_exception(errors[i]);
+
+        return result;
+    }
+
+    inline Disposable<Array> CostFunction::batchValue(
+                          const std::vector<Array>& x,
+                          std::vector<std::exception_ptr>& errors) const {
+        const Integer n = static_cast<Integer>(x.size());
+        Array result(n);
+        errors.assign(n, std::exception_ptr());
+
+        #pragma omp parallel for if(isThreadSafe())
+        for (Integer i=0; i<n; ++i) {
+            try {
+                result[i] = value(x[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+                result[i] = QL_MAX_REAL;
+            }
+        }
+
+        return result;
+    }
+
+    inline std::vector<Array> CostFunction::batchValues(
+                                        const std::vector<Array>& x) const {
+        const Integer n = static_cast<Integer>(x.size());
+        std::vector<Array> result(n);
+        std::vector<std::exception_ptr> errors(n);
+
+        #pragma omp parallel for if(isThreadSafe())
+        for (Integer i=0; i<n; ++i) {
+            try {
+                result[i] = values(x[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+
+        for (Integer i=0; i<n; ++i)
+            if (errors[i])
+                std::rethrow_exception(errors[i]);
+
+        return result;
+    }
+
     class ParametersTransformation {
       public:
         virtual ~ParametersTransformation() {}
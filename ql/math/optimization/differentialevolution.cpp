@@ -76,8 +76,11 @@ namespace QuantLib {
                 population[i].values = configuration().initialPopulation[i];
                 QL_REQUIRE(population[i].values.size() == p.currentValue().size(),
                            "wrong values size in initial population");
-                population[i].cost = p.costFunction().value(population[i].values);
             }
+            const Array costs =
+                p.costFunction().batchValue(configuration().initialPopulation);
+            for (Size i = 0; i < population.size(); ++i)
+                population[i].cost = costs[i];
         } else {
             population = std::vector<Candidate>(configuration().populationMembers,
                                                 Candidate(p.currentValue().size()));
@@ -295,15 +298,34 @@ namespace QuantLib {
                                - lowerBound_[memIter]);
                 }
             }
-            // evaluate objective function as soon as possible to avoid unnecessary loops
-            try {
-                population[popIter].cost = p.value(population[popIter].values);
-            } catch (Error&) {
-                population[popIter].cost = QL_MAX_REAL;
+        }
+
+        // evaluate the objective function on the whole generation at
+        // once, so that thread-safe cost functions are run in parallel
+        evaluate(population, p);
+    }
+
+    void DifferentialEvolution::evaluate(std::vector<Candidate>& population,
+                                         Problem& p) const {
+        std::vector<Array> values(population.size());
+        for (Size popIter = 0; popIter < population.size(); popIter++)
+            values[popIter] = population[popIter].values;
+
+        std::vector<std::exception_ptr> errors;
+        const Array costs = p.batchValue(values, errors);
+
+        for (Size popIter = 0; popIter < population.size(); popIter++) {
+            // failing members get the maximum cost, errors other
+            // than QuantLib ones are propagated
+            if (errors[popIter]) {
+                try {
+                    std::rethrow_exception(errors[popIter]);
+                } catch (Error&) {}
             }
+
+            population[popIter].cost = costs[popIter];
             if(!boost::math::isfinite(population[popIter].cost))
                 population[popIter].cost = QL_MAX_REAL;
-
         }
     }
 
@@ -383,14 +405,22 @@ namespace QuantLib {
 
         // use initial values provided by the user
         population.front().values = p.currentValue();
-        population.front().cost = p.costFunction().value(population.front().values);
         // rest of the initial population is random
         for (Size j = 1; j < population.size(); ++j) {
             for (Size i = 0; i < p.currentValue().size(); ++i) {
                 Real l = lowerBound_[i], u = upperBound_[i];
                 population[j].values[i] = l + (u-l)*rng_.nextReal();
             }
-            population[j].cost = p.costFunction().value(population[j].values);
+        }
+
+        std::vector<Array> values(population.size());
+        for (Size j = 0; j < population.size(); ++j)
+            values[j] = population[j].values;
+        const Array costs = p.costFunction().batchValue(values);
+
+        population.front().cost = costs[0];
+        for (Size j = 1; j < population.size(); ++j) {
+            population[j].cost = costs[j];
             if(!boost::math::isfinite(population[j].cost))
                 population[j].cost = QL_MAX_REAL;
         }
@@ -206,6 +206,9 @@ namespace QuantLib {
                        const std::vector<Candidate>& mutantPopulation,
                        const std::vector<Candidate>& mirrorPopulation,
                        Problem& costFunction) const;
+
+        void evaluate(std::vector<Candidate>& population,
+                      Problem& costFunction) const;
     };
 
 }
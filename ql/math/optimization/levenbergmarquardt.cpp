@@ -84,11 +84,17 @@ namespace QuantLib {
         // in n variables by the Levenberg-Marquardt algorithm.
         MINPACK::LmdifCostFunction lmdifCostFunction =
             ext::bind(&LevenbergMarquardt::fcn, this, _1, _2, _3, _4, _5);
+        // if the cost function can be evaluated concurrently, the
+        // finite-difference columns are computed in parallel
         MINPACK::LmdifCostFunction lmdifJacFunction =
             useCostFunctionsJacobian_
                 ? ext::bind(&LevenbergMarquardt::jacFcn, this, _1, _2, _3,
                               _4, _5)
-                : MINPACK::LmdifCostFunction();
+                : P.costFunction().isThreadSafe()
+                    ? ext::bind(&LevenbergMarquardt::fdJacFcn, this,
+                                _1, _2, _3, _4, _5)
+                    : MINPACK::LmdifCostFunction();
+        lastX_ = Array();
         MINPACK::lmdif(m, n, xx.get(), fvec.get(),
                        endCriteria.functionEpsilon(),
                        xtol_,
@@ -125,7 +131,7 @@ namespace QuantLib {
         return ecType;
     }
 
-    void LevenbergMarquardt::fcn(int, int n, Real* x, Real* fvec, int*) {
+    void LevenbergMarquardt::fcn(int m, int n, Real* x, Real* fvec, int*) {
         Array xt(n);
         std::copy(x, x+n, xt.begin());
         // constraint handling needs some improvement in the future:
@@ -136,6 +142,8 @@ namespace QuantLib {
         } else {
             std::copy(initCostValues_.begin(), initCostValues_.end(), fvec);
         }
+        lastX_ = xt;
+        lastValues_ = Array(fvec, fvec+m);
     }
 
     void LevenbergMarquardt::jacFcn(int m, int n, Real* x, Real* fjac, int*) {
@@ -154,4 +162,51 @@ namespace QuantLib {
         }
     }
 
+    void LevenbergMarquardt::fdJacFcn(int m, int n, Real* x, Real* fjac,
+                                      int*) {
+        // same forward-difference scheme as MINPACK's fdjac2, with
+        // the shifted points evaluated as a single batch
+        const Real eps = std::sqrt(std::max(epsfcn_, MINPACK::MACHEP));
+
+        Array xt(n);
+        std::copy(x, x+n, xt.begin());
+
+        // lmdif computes the jacobian at the point of the last accepted
+        // step, which is the last one passed to fcn; the values in x
+        // are thus known and no further evaluation is needed
+        QL_REQUIRE(lastX_.size() == xt.size()
+                   && std::equal(xt.begin(), xt.end(), lastX_.begin()),
+                   "cost function values at the current point expected");
+
+        std::vector<Array> points;
+        points.reserve(n);
+        Array h(n);
+        for (Integer j=0; j<n; ++j) {
+            h[j] = eps*std::fabs(xt[j]);
+            if (h[j] == 0.0)
+                h[j] = eps;
+            points.push_back(xt);
+            points.back()[j] += h[j];
+        }
+
+        // constraint handling as in fcn
+        std::vector<Array> feasible;
+        std::vector<Size> index(points.size(), Null<Size>());
+        for (Size k=0; k<points.size(); ++k) {
+            if (currentProblem_->constraint().test(points[k])) {
+                index[k] = feasible.size();
+                feasible.push_back(points[k]);
+            }
+        }
+        const std::vector<Array> f = currentProblem_->batchValues(feasible);
+
+        const Array& fvec = lastValues_;
+        for (Integer j=0; j<n; ++j) {
+            const Array& fp =
+                (index[j] != Null<Size>()) ? f[index[j]] : initCostValues_;
+            for (Integer i=0; i<m; ++i)
+                fjac[i+m*j] = (fp[i] - fvec[i])/h[j];
+        }
+    }
+
 }
@@ -43,6 +43,9 @@ namespace QuantLib {
         (oder 2, but requiring more function
         evaluations) compared to the forward
         difference implemented here (order 1).
+        If the cost function is thread-safe, the
+        finite-difference columns of the jacobian
+        are evaluated in parallel.
 
         \ingroup optimizers
     */
@@ -68,9 +71,15 @@ namespace QuantLib {
                  Real* fjac,
                  int* iflag);
 
+        void fdJacFcn(int m,
+                      int n,
+                      Real* x,
+                      Real* fjac,
+                      int* iflag);
+
       private:
         Problem* currentProblem_;
-        Array initCostValues_;
+        Array initCostValues_, lastX_, lastValues_;
         Matrix initJacobian_;
         mutable Integer info_;
         const Real epsfcn_, xtol_, gtol_;
@@ -31,6 +31,9 @@
 namespace QuantLib {
 
     namespace MINPACK {
+        //! resolution of arithmetic used by the finite-difference scheme
+        extern double MACHEP;
+
         typedef ext::function<void (int,
                                       int, 
                                       Real*,
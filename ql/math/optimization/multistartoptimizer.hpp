@@ -0,0 +1,165 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file multistartoptimizer.hpp
+    \brief Multi-start driver for local optimization methods
+*/
+
+#ifndef quantlib_optimization_multi_start_optimizer_hpp
+#define quantlib_optimization_multi_start_optimizer_hpp
+
+#include <ql/math/optimization/problem.hpp>
+#include <ql/math/randomnumbers/sobolrsg.hpp>
+#include <exception>
+#include <vector>
+
+namespace QuantLib {
+
+    //! Multi-start driver for local optimization methods
+    /*! The local optimizer is run independently from a number of
+        starting points; the best local minimum is returned. The
+        starting points are either given explicitly or taken from a
+        Sobol sequence within the bounds of the problem constraint,
+        in which case the current value of the problem is used as the
+        first starting point.
+
+        Each run uses its own copy of the local optimizer and its own
+        Problem instance. If the cost function is thread-safe, the
+        runs are performed in parallel.
+
+        \ingroup optimizers
+    */
+    template <class LocalOptimizer>
+    class MultiStartOptimizer : public OptimizationMethod {
+      public:
+        MultiStartOptimizer(const LocalOptimizer& localOptimizer,
+                            Size startingPoints,
+                            unsigned long seed = 42)
+        : localOptimizer_(localOptimizer), nStartingPoints_(startingPoints),
+          seed_(seed) {
+            QL_REQUIRE(nStartingPoints_ > 0, "no starting points given");
+        }
+        MultiStartOptimizer(const LocalOptimizer& localOptimizer,
+                            const std::vector<Array>& startingPoints)
+        : localOptimizer_(localOptimizer), startingPoints_(startingPoints),
+          nStartingPoints_(startingPoints_.size()), seed_(0) {
+            QL_REQUIRE(nStartingPoints_ > 0, "no starting points given");
+        }
+
+        EndCriteria::Type minimize(Problem& P,
+                                   const EndCriteria& endCriteria) override;
+
+        //! \name Inspectors for the last minimization
+        //@{
+        const std::vector<Array>& localMinima() const { return minima_; }
+        const std::vector<Real>& localValues() const { return values_; }
+        //@}
+      private:
+        std::vector<Array> startingPoints(const Problem& P) const;
+
+        const LocalOptimizer localOptimizer_;
+        const std::vector<Array> startingPoints_;
+        const Size nStartingPoints_;
+        const unsigned long seed_;
+        std::vector<Array> minima_;
+        std::vector<Real> values_;
+    };
+
+
+    // template definitions
+
+    template <class LocalOptimizer>
+    std::vector<Array> MultiStartOptimizer<LocalOptimizer>::startingPoints(
+                                                    const Problem& P) const {
+        if (!startingPoints_.empty())
+            return startingPoints_;
+
+        const Array& x0 = P.currentValue();
+        const Array upper = P.constraint().upperBound(x0);
+        const Array lower = P.constraint().lowerBound(x0);
+        for (Size j=0; j<x0.size(); ++j)
+            QL_REQUIRE(upper[j] < QL_MAX_REAL && lower[j] > -QL_MAX_REAL,
+                       "finite bounds needed to generate starting points");
+
+        std::vector<Array> points(1, x0);
+        SobolRsg sobol(x0.size(), seed_);
+        for (Size k=0; points.size() < nStartingPoints_; ++k) {
+            QL_REQUIRE(k < 100*nStartingPoints_,
+                       "unable to find feasible starting points");
+            const std::vector<Real>& sample = sobol.nextSequence().value;
+            Array x(x0.size());
+            for (Size j=0; j<x.size(); ++j)
+                x[j] = lower[j] + (upper[j]-lower[j])*sample[j];
+            if (P.constraint().test(x))
+                points.push_back(x);
+        }
+        return points;
+    }
+
+    template <class LocalOptimizer>
+    EndCriteria::Type MultiStartOptimizer<LocalOptimizer>::minimize(
+                                            Problem& P,
+                                            const EndCriteria& endCriteria) {
+        P.reset();
+
+        const std::vector<Array> points = startingPoints(P);
+        const Integer n = static_cast<Integer>(points.size());
+
+        minima_ = points;
+        values_ = std::vector<Real>(n, QL_MAX_REAL);
+        std::vector<EndCriteria::Type> ecTypes(n, EndCriteria::None);
+        std::vector<std::exception_ptr> errors(n);
+        std::vector<Problem> problems(
+            n, Problem(P.costFunction(), P.constraint()));
+
+        #pragma omp parallel for if(P.costFunction().isThreadSafe())
+        for (Integer i=0; i<n; ++i) {
+            try {
+                LocalOptimizer localOptimizer(localOptimizer_);
+                Problem& problem = problems[i];
+                problem.setCurrentValue(points[i]);
+                ecTypes[i] = localOptimizer.minimize(problem, endCriteria);
+                minima_[i] = problem.currentValue();
+                values_[i] = (problem.functionValue() != Null<Real>())
+                    ? problem.functionValue()
+                    : problem.value(minima_[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+
+        // the evaluations of all runs, including the failed ones
+        for (Integer i=0; i<n; ++i)
+            P.addEvaluations(problems[i]);
+
+        Integer best = -1;
+        for (Integer i=0; i<n; ++i) {
+            if (!errors[i] && (best < 0 || values_[i] < values_[best]))
+                best = i;
+        }
+        // no local optimization succeeded
+        if (best < 0)
+            std::rethrow_exception(errors.front());
+
+        P.setCurrentValue(minima_[best]);
+        P.setFunctionValue(values_[best]);
+        return ecTypes[best];
+    }
+
+}
+
+#endif
@@ -45,7 +45,9 @@ namespace QuantLib {
                 Constraint& constraint,
                 const Array& initialValue = Array())
         : costFunction_(costFunction), constraint_(constraint),
-          currentValue_(initialValue) {
+          currentValue_(initialValue), functionValue_(Null<Real>()),
+          squaredNorm_(Null<Real>()), functionEvaluation_(0),
+          gradientEvaluation_(0) {
             QL_REQUIRE(!constraint.empty(), "empty constraint given");
         }
 
@@ -59,6 +61,19 @@ namespace QuantLib {
         //! call cost values computation and increment evaluation counter
         Disposable<Array> values(const Array& x);
 
+        //! call cost function computation at several points and
+        //  increment evaluation counter
+        Disposable<Array> batchValue(const std::vector<Array>& x);
+
+        //! call cost function computation at several points, storing
+        //  the errors point by point, and increment evaluation counter
+        Disposable<Array> batchValue(const std::vector<Array>& x,
+                                     std::vector<std::exception_ptr>& errors);
+
+        //! call cost values computation at several points and
+        //  increment evaluation counter
+        std::vector<Array> batchValues(const std::vector<Array>& x);
+
         //! call cost function gradient computation and increment
         //  evaluation counter
         void gradient(Array& grad_f,
@@ -100,6 +115,13 @@ namespace QuantLib {
         //! number of evaluation of cost function gradient
         Integer gradientEvaluation() const { return gradientEvaluation_; }
 
+        //! add the evaluation counters of a problem solved on behalf
+        //  of this one, e.g. a local optimization in a global optimizer
+        void addEvaluations(const Problem& subProblem) {
+            functionEvaluation_ += subProblem.functionEvaluation_;
+            gradientEvaluation_ += subProblem.gradientEvaluation_;
+        }
+
       protected:
         //! Unconstrained cost function
         CostFunction& costFunction_;
@@ -124,6 +146,25 @@ namespace QuantLib {
         return costFunction_.values(x);
     }
 
+    inline Disposable<Array> Problem::batchValue(
+                                            const std::vector<Array>& x) {
+        functionEvaluation_ += static_cast<Integer>(x.size());
+        return costFunction_.batchValue(x);
+    }
+
+    inline Disposable<Array> Problem::batchValue(
+                                   const std::vector<Array>& x,
+                                   std::vector<std::exception_ptr>& errors) {
+        functionEvaluation_ += static_cast<Integer>(x.size());
+        return costFunction_.batchValue(x, errors);
+    }
+
+    inline std::vector<Array> Problem::batchValues(
+                                            const std::vector<Array>& x) {
+        functionEvaluation_ += static_cast<Integer>(x.size());
+        return costFunction_.batchValues(x);
+    }
+
     inline void Problem::gradient(Array& grad_f,
                                   const Array& x) {
         ++gradientEvaluation_;
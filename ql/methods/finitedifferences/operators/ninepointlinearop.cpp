@@ -139,8 +139,9 @@ namespace QuantLib {
         const Size *i10(i10_.get()),                   *i12(i12_.get());
         const Size *i20(i20_.get()), *i21(i21_.get()), *i22(i22_.get());
 
-        //#pragma omp parallel for
-        for (Size i=0; i < retVal.size(); ++i) {
+        const long size = static_cast<long>(retVal.size());
+        #pragma omp parallel for if(size > 4096)
+        for (long i=0; i < size; ++i) {
             retVal[i] =   a00[i]*u[i00[i]]
                         + a01[i]*u[i01[i]]
                         + a02[i]*u[i02[i]]
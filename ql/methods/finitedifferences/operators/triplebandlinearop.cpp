@@ -24,6 +24,8 @@
 #include <ql/methods/finitedifferences/tridiagonaloperator.hpp>
 #include <ql/methods/finitedifferences/operators/fdmlinearoplayout.hpp>
 #include <ql/methods/finitedifferences/operators/triplebandlinearop.hpp>
+#include <algorithm>
+#include <vector>
 
 namespace QuantLib {
 
@@ -252,8 +254,9 @@ namespace QuantLib {
         const Size* i2ptr = i2_.get();
 
         array_type retVal(r.size());
-        //#pragma omp parallel for
-        for (Size i=0; i < index->size(); ++i) {
+        const long size = static_cast<long>(index->size());
+        #pragma omp parallel for if(size > 4096)
+        for (long i=0; i < size; ++i) {
             retVal[i] = r[i0ptr[i]]*lptr[i]+r[i]*dptr[i]+r[i2ptr[i]]*uptr[i];
         }
 
@@ -298,30 +301,52 @@ namespace QuantLib {
         const Real* lptr = lower_.get();
         const Real* dptr = diag_.get();
         const Real* uptr = upper_.get();
+        const Size* rptr = reverseIndex_.get();
 
         // Thomson algorithm to solve a tridiagonal system.
         // Example code taken from Tridiagonalopertor and
         // changed to fit for the triple band operator.
-        Size rim1 = reverseIndex_[0];
-        Real bet=1.0/(a*dptr[rim1]+b);
-        QL_REQUIRE(bet != 0.0, "division by zero");
-        retVal[reverseIndex_[0]] = r[rim1]*bet;
+        // The lines along the operator direction are decoupled (their
+        // boundary entries are zero) and are solved independently.
+        const Size n = layout->dim()[direction_];
+        const long nLines = static_cast<long>(layout->size()/n);
+        std::vector<char> singular(nLines, 0);
+
+        #pragma omp parallel for if(nLines > 1 && layout->size() > 4096)
+        for (long line=0; line < nLines; ++line) {
+            const Size first = line*n, last = first + n - 1;
+
+            Size rim1 = rptr[first];
+            Real bet=1.0/(a*dptr[rim1]+b);
+            if (bet == 0.0) {
+                singular[line] = 1;
+                continue;
+            }
+            retVal[rim1] = r[rim1]*bet;
+
+            for (Size j=first+1; j<=last; j++){
+                const Size ri = rptr[j];
+                tmp[j] = a*uptr[rim1]*bet;
 
-        for (Size j=1; j<=layout->size()-1; j++){
-            const Size ri = reverseIndex_[j];
-            tmp[j] = a*uptr[rim1]*bet;
+                bet=b+a*(dptr[ri]-tmp[j]*lptr[ri]);
+                if (bet == 0.0) {
+                    singular[line] = 1;
+                    break;
+                }
+                bet=1.0/bet;
 
-            bet=b+a*(dptr[ri]-tmp[j]*lptr[ri]);
-            QL_ENSURE(bet != 0.0, "division by zero");
-            bet=1.0/bet;
+                retVal[ri] = (r[ri]-a*lptr[ri]*retVal[rim1])*bet;
+                rim1 = ri;
+            }
+            if (singular[line])
+                continue;
 
-            retVal[ri] = (r[ri]-a*lptr[ri]*retVal[rim1])*bet;
-            rim1 = ri;
+            for (Size j=last; j>first; --j)
+                retVal[rptr[j-1]] -= tmp[j]*retVal[rptr[j]];
         }
-        // cannot be j>=0 with Size j
-        for (Size j=layout->size()-2; j>0; --j)
-            retVal[reverseIndex_[j]] -= tmp[j+1]*retVal[reverseIndex_[j+1]];
-        retVal[reverseIndex_[0]] -= tmp[1]*retVal[reverseIndex_[1]];
+
+        QL_ENSURE(std::find(singular.begin(), singular.end(), 1)
+                  == singular.end(), "division by zero");
 
         return retVal;
     }
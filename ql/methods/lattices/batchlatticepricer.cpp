@@ -0,0 +1,94 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <ql/methods/lattices/batchlatticepricer.hpp>
+#include <algorithm>
+#include <utility>
+
+namespace QuantLib {
+
+    BatchLatticePricer::BatchLatticePricer(
+                                    ext::shared_ptr<ShortRateModel> model,
+                                    Size timeSteps)
+    : model_(std::move(model)), timeSteps_(timeSteps) {
+        QL_REQUIRE(model_, "no model given");
+        QL_REQUIRE(timeSteps_ > 0,
+                   "timeSteps must be positive, " << timeSteps_ <<
+                   " not allowed");
+        registerWith(model_);
+    }
+
+    Size BatchLatticePricer::add(
+                        const ext::shared_ptr<DiscretizedAsset>& asset) {
+        QL_REQUIRE(asset, "null asset");
+        assets_.push_back(asset);
+        // the time grid must include the times of the new asset
+        lattice_.reset();
+        LazyObject::update();
+        return assets_.size()-1;
+    }
+
+    void BatchLatticePricer::update() {
+        lattice_.reset();
+        LazyObject::update();
+    }
+
+    const ext::shared_ptr<Lattice>& BatchLatticePricer::lattice() const {
+        calculate();
+        return lattice_;
+    }
+
+    const std::vector<Real>& BatchLatticePricer::values() const {
+        calculate();
+        return values_;
+    }
+
+    void BatchLatticePricer::performCalculations() const {
+        QL_REQUIRE(!assets_.empty(), "no assets given");
+
+        std::vector<Time> times, maturities(assets_.size());
+        for (Size k=0; k<assets_.size(); ++k) {
+            std::vector<Time> assetTimes = assets_[k]->mandatoryTimes();
+            maturities[k] = 0.0;
+            for (Size i=0; i<assetTimes.size(); ++i) {
+                if (assetTimes[i] >= 0.0) {
+                    times.push_back(assetTimes[i]);
+                    maturities[k] = std::max(maturities[k], assetTimes[i]);
+                }
+            }
+        }
+        QL_REQUIRE(!times.empty(),
+                   "no asset has mandatory times in the future");
+
+        if (!lattice_) {
+            TimeGrid grid(times.begin(), times.end(), timeSteps_);
+            lattice_ = model_->tree(grid);
+        }
+
+        std::vector<DiscretizedAsset*> assets(assets_.size());
+        for (Size k=0; k<assets_.size(); ++k) {
+            assets_[k]->initialize(lattice_, maturities[k]);
+            assets[k] = assets_[k].get();
+        }
+        lattice_->rollback(assets, 0.0);
+
+        values_.resize(assets_.size());
+        for (Size k=0; k<assets_.size(); ++k)
+            values_[k] = assets_[k]->presentValue();
+    }
+
+}
@@ -0,0 +1,73 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file batchlatticepricer.hpp
+    \brief Valuation of several discretized assets on a common lattice
+*/
+
+#ifndef quantlib_batch_lattice_pricer_hpp
+#define quantlib_batch_lattice_pricer_hpp
+
+#include <ql/discretizedasset.hpp>
+#include <ql/models/model.hpp>
+#include <ql/patterns/lazyobject.hpp>
+
+namespace QuantLib {
+
+    //! values several discretized assets on a common short-rate lattice
+    /*! The mandatory times of all the assets are merged into a single
+        time grid, on which the model tree is built once; each asset
+        is initialized at its last mandatory time and all of them are
+        rolled back to the present in a single traversal of the tree.
+
+        The tree is kept until the model changes or assets are added,
+        so that the assets can be revalued without rebuilding it.
+
+        \ingroup lattices
+    */
+    class BatchLatticePricer : public LazyObject {
+      public:
+        BatchLatticePricer(ext::shared_ptr<ShortRateModel> model,
+                           Size timeSteps);
+        //! adds an asset to the batch and returns its index
+        Size add(const ext::shared_ptr<DiscretizedAsset>& asset);
+        //! \name Inspectors
+        //@{
+        Size size() const { return assets_.size(); }
+        //! the lattice on which the assets are rolled back
+        const ext::shared_ptr<Lattice>& lattice() const;
+        //! present values of the assets, in the order they were added
+        const std::vector<Real>& values() const;
+        //@}
+        //! \name Observer interface
+        //@{
+        void update() override;
+        //@}
+      protected:
+        void performCalculations() const override;
+      private:
+        ext::shared_ptr<ShortRateModel> model_;
+        Size timeSteps_;
+        std::vector<ext::shared_ptr<DiscretizedAsset> > assets_;
+        mutable ext::shared_ptr<Lattice> lattice_;
+        mutable std::vector<Real> values_;
+    };
+
+}
+
+
+#endif
@@ -206,6 +206,42 @@ namespace QuantLib {
     };
 
 
+    //! tells whether the nodes of a binomial tree depend on the strike
+    /*! Trees built around the strike of the option cannot be shared
+        between options with different strikes.  Trees are assumed
+        to depend on the strike unless known otherwise; the trait
+        can be specialized for other strike-independent trees.
+    */
+    template <class T>
+    struct BinomialTreeDependsOnStrike {
+        static const bool value = true;
+    };
+
+    template <>
+    struct BinomialTreeDependsOnStrike<JarrowRudd> {
+        static const bool value = false;
+    };
+
+    template <>
+    struct BinomialTreeDependsOnStrike<CoxRossRubinstein> {
+        static const bool value = false;
+    };
+
+    template <>
+    struct BinomialTreeDependsOnStrike<AdditiveEQPBinomialTree> {
+        static const bool value = false;
+    };
+
+    template <>
+    struct BinomialTreeDependsOnStrike<Trigeorgis> {
+        static const bool value = false;
+    };
+
+    template <>
+    struct BinomialTreeDependsOnStrike<Tian> {
+        static const bool value = false;
+    };
+
 }
 
 
@@ -49,6 +49,9 @@ namespace QuantLib {
           void stepback(Size i,
                         const Array& values,
                         Array& newValues) const;
+          void batchStepback(Size i,
+                             const std::vector<const Array*>& values,
+                             const std::vector<Array*>& newValues) const;
         \endcode
 
         \ingroup lattices
@@ -70,6 +73,10 @@ namespace QuantLib {
         void initialize(DiscretizedAsset&, Time t) const override;
         void rollback(DiscretizedAsset&, Time to) const override;
         void partialRollback(DiscretizedAsset&, Time to) const override;
+        void rollback(const std::vector<DiscretizedAsset*>&,
+                      Time to) const override;
+        void partialRollback(const std::vector<DiscretizedAsset*>&,
+                             Time to) const override;
         //! Computes the present value of an asset using Arrow-Debrew prices
         Real presentValue(DiscretizedAsset&) const override;
         //@}
@@ -79,6 +86,10 @@ namespace QuantLib {
         void stepback(Size i,
                       const Array& values,
                       Array& newValues) const;
+        //! steps back several sets of values at once
+        void batchStepback(Size i,
+                           const std::vector<const Array*>& values,
+                           const std::vector<Array*>& newValues) const;
 
       protected:
         void computeStatePrices(Size until) const;
@@ -152,17 +163,87 @@ namespace QuantLib {
         auto iFrom = Integer(t_.index(from));
         auto iTo = Integer(t_.index(to));
 
+        // the two buffers are swapped at each step; as the tree
+        // usually narrows going backwards, no further allocation
+        // is needed after the first step
+        Array newValues;
         for (Integer i=iFrom-1; i>=iTo; --i) {
-            Array newValues(this->impl().size(i));
+            newValues.resize(this->impl().size(i));
             this->impl().stepback(i, asset.values(), newValues);
             asset.time() = t_[i];
-            asset.values() = newValues;
+            asset.values().swap(newValues);
             // skip the very last adjustment
             if (i != iTo)
                 asset.adjustValues();
         }
     }
 
+    template <class Impl>
+    inline void TreeLattice<Impl>::rollback(
+                                const std::vector<DiscretizedAsset*>& assets,
+                                Time to) const {
+        partialRollback(assets,to);
+        for (Size k=0; k<assets.size(); ++k)
+            assets[k]->adjustValues();
+    }
+
+    template <class Impl>
+    void TreeLattice<Impl>::partialRollback(
+                                const std::vector<DiscretizedAsset*>& assets,
+                                Time to) const {
+
+        auto iTo = Integer(t_.index(to));
+
+        // the level at which each asset joins the rollback
+        std::vector<Integer> iFrom(assets.size(), iTo);
+        Integer iStart = iTo;
+        for (Size k=0; k<assets.size(); ++k) {
+            Time from = assets[k]->time();
+            if (close(from,to))
+                continue;
+            QL_REQUIRE(from > to,
+                       "cannot roll the asset back to" << to
+                       << " (it is already at t = " << from << ")");
+            iFrom[k] = Integer(t_.index(from));
+            iStart = std::max(iStart, iFrom[k]);
+        }
+
+        std::vector<Array> buffers(assets.size());
+        std::vector<Size> active;
+        std::vector<const Array*> values;
+        std::vector<Array*> newValues;
+        for (Integer i=iStart-1; i>=iTo; --i) {
+            active.clear();
+            values.clear();
+            newValues.clear();
+            for (Size k=0; k<assets.size(); ++k) {
+                if (iFrom[k] > i) {
+                    active.push_back(k);
+                    buffers[k].resize(this->impl().size(i));
+                    values.push_back(&assets[k]->values());
+                    newValues.push_back(&buffers[k]);
+                }
+            }
+            this->impl().batchStepback(i, values, newValues);
+            for (Size k : active) {
+                assets[k]->time() = t_[i];
+                assets[k]->values().swap(buffers[k]);
+                // skip the very last adjustment
+                if (i != iTo)
+                    assets[k]->adjustValues();
+            }
+        }
+    }
+
+    template <class Impl>
+    void TreeLattice<Impl>::batchStepback(
+                                Size i,
+                                const std::vector<const Array*>& values,
+                                const std::vector<Array*>& newValues) const {
+        for (Size k=0; k<values.size(); ++k)
+            this->impl().stepback(i, *values[k], *newValues[k]);
+    }
+
     template <class Impl>
     void TreeLattice<Impl>::stepback(Size i, const Array& values,
                                      Array& newValues) const {
@@ -25,6 +25,7 @@
 #define quantlib_tree_lattice_1d_hpp
 
 #include <ql/methods/lattices/lattice.hpp>
+#include <vector>
 
 namespace QuantLib {
 
@@ -34,12 +35,23 @@ namespace QuantLib {
         Real underlying(Size i, Size index) const;
         \endcode
 
+        The branching structure (descendants and probabilities) and
+        the discount factors of each level are cached in contiguous
+        arrays the first time the level is rolled back through, so
+        that further rollbacks on the same lattice don't need to
+        query the derived class for each node.  The cache is filled
+        under a lock, so that the same lattice can be rolled back by
+        several threads at once.  Derived classes whose discount
+        factors can change after construction must call
+        resetDiscounts() whenever that happens; such changes must not
+        overlap with rollbacks in other threads.
+
         \ingroup lattices */
     template <class Impl>
     class TreeLattice1D : public TreeLattice<Impl> {
       public:
         TreeLattice1D(const TimeGrid& timeGrid, Size n)
-        : TreeLattice<Impl>(timeGrid,n) {}
+        : TreeLattice<Impl>(timeGrid,n), branches_(n) {}
         Disposable<Array> grid(Time t) const override {
             Size i = this->timeGrid().index(t);
             Array grid(this->impl().size(i));
@@ -50,8 +62,137 @@ namespace QuantLib {
         Real underlying(Size i, Size index) const {
             return this->impl().underlying(i,index);
         }
+        void stepback(Size i,
+                      const Array& values,
+                      Array& newValues) const;
+        void batchStepback(Size i,
+                           const std::vector<const Array*>& values,
+                           const std::vector<Array*>& newValues) const;
+      protected:
+        //! discards the cached discount factors
+        void resetDiscounts() const {
+            #pragma omp critical(ql_tree_lattice_1d_levels)
+            {
+                for (Size i=0; i<levels_.size(); ++i)
+                    levels_[i].discounts.clear();
+            }
+        }
+      private:
+        struct Level {
+            std::vector<Size> descendants;
+            std::vector<Real> probabilities;
+            std::vector<DiscountFactor> discounts;
+        };
+        const Level& level(Size i) const;
+        Size branches_;
+        mutable std::vector<Level> levels_;
     };
 
+
+    // template definitions
+
+    template <class Impl>
+    const typename TreeLattice1D<Impl>::Level&
+    TreeLattice1D<Impl>::level(Size i) const {
+        // the lock is only held to look up and publish the cached
+        // data, which are computed outside of it so that the derived
+        // class is never called (and can't throw) while it is held.
+        // The levels are not reallocated once created, so the returned
+        // reference stays valid.
+        Level* cached;
+        bool branching, discounting;
+        #pragma omp critical(ql_tree_lattice_1d_levels)
+        {
+            if (levels_.empty())
+                levels_.resize(this->timeGrid().size());
+            cached = &levels_[i];
+            branching = cached->descendants.empty();
+            discounting = cached->discounts.empty();
+        }
+        if (!branching && !discounting)
+            return *cached;
+
+        const Size size = this->impl().size(i);
+        Level level;
+        if (branching) {
+            level.descendants.resize(size*branches_);
+            level.probabilities.resize(size*branches_);
+            for (Size j=0, k=0; j<size; j++) {
+                for (Size l=0; l<branches_; l++, k++) {
+                    level.descendants[k] = this->impl().descendant(i,j,l);
+                    level.probabilities[k] = this->impl().probability(i,j,l);
+                }
+            }
+        }
+        if (discounting) {
+            level.discounts.resize(size);
+            for (Size j=0; j<size; j++)
+                level.discounts[j] = this->impl().discount(i,j);
+        }
+
+        // another thread might have got here first with the same data
+        #pragma omp critical(ql_tree_lattice_1d_levels)
+        {
+            if (branching && cached->descendants.empty()) {
+                cached->descendants.swap(level.descendants);
+                cached->probabilities.swap(level.probabilities);
+            }
+            if (discounting && cached->discounts.empty())
+                cached->discounts.swap(level.discounts);
+        }
+        return *cached;
+    }
+
+    template <class Impl>
+    void TreeLattice1D<Impl>::stepback(Size i, const Array& values,
+                                       Array& newValues) const {
+        const Level& level = this->level(i);
+        const Size* descendants = &level.descendants[0];
+        const Real* probabilities = &level.probabilities[0];
+        const DiscountFactor* discounts = &level.discounts[0];
+        const Size n = branches_;
+        const long size = static_cast<long>(level.discounts.size());
+
+        // only wide levels are worth the threading overhead
+        #pragma omp parallel for if(size > 1024)
+        for (long j=0; j<size; j++) {
+            const Size* d = descendants + j*n;
+            const Real* p = probabilities + j*n;
+            Real value = 0.0;
+            for (Size l=0; l<n; l++)
+                value += p[l]*values[d[l]];
+            newValues[j] = value*discounts[j];
+        }
+    }
+
+    template <class Impl>
+    void TreeLattice1D<Impl>::batchStepback(
+                                Size i,
+                                const std::vector<const Array*>& values,
+                                const std::vector<Array*>& newValues) const {
+        const Level& level = this->level(i);
+        const Size* descendants = &level.descendants[0];
+        const Real* probabilities = &level.probabilities[0];
+        const DiscountFactor* discounts = &level.discounts[0];
+        const Size n = branches_;
+        const Size m = values.size();
+        const long size = static_cast<long>(level.discounts.size());
+
+        // the branching data of each node are read once for all assets
+        #pragma omp parallel for if(size*m > 1024)
+        for (long j=0; j<size; j++) {
+            const Size* d = descendants + j*n;
+            const Real* p = probabilities + j*n;
+            for (Size k=0; k<m; k++) {
+                const Array& v = *values[k];
+                Real value = 0.0;
+                for (Size l=0; l<n; l++)
+                    value += p[l]*v[d[l]];
+                (*newValues[k])[j] = value*discounts[j];
+            }
+        }
+    }
+
 }
 
 
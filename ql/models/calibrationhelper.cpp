@@ -20,6 +20,7 @@
 
 #include <ql/models/calibrationhelper.hpp>
 #include <ql/math/solvers1d/brent.hpp>
+#include <exception>
 
 namespace QuantLib {
 
@@ -84,4 +85,63 @@ namespace QuantLib {
         
         return error;
     }
+
+    bool BlackCalibrationHelper::hasCalibrationErrorGradient() {
+        return hasModelValueGradient();
+    }
+
+    Disposable<Array> BlackCalibrationHelper::calibrationErrorGradient() {
+        Array gradient;
+        const Real modelPrice = modelValueAndGradient(gradient);
+        const Real marketPrice = marketValue();
+
+        switch (calibrationErrorType_) {
+          case RelativePriceError:
+            gradient *= ((marketPrice < modelPrice) ? 1.0 : -1.0)/marketPrice;
+            break;
+          case PriceError:
+            gradient *= -1.0;
+            break;
+          case ImpliedVolError:
+            {
+              Real minVol = volatilityType_ == ShiftedLognormal ? 0.0010 : 0.00005;
+              Real maxVol = volatilityType_ == ShiftedLognormal ? 10.0 : 0.50;
+              // Black prices are obtained by setting up engines which
+              // register with shared term structures; this is not
+              // thread-safe, hence the critical section
+              Real vega = 0.0;
+              std::exception_ptr error;
+              #pragma omp critical(blackcalibrationhelper_blackprice)
+              {
+                  try {
+                      if (modelPrice > blackPrice(minVol)
+                          && modelPrice < blackPrice(maxVol)) {
+                          const Volatility implied = this->impliedVolatility(
+                                      modelPrice, 1e-12, 5000, minVol, maxVol);
+                          const Real h = 1e-6*std::max(implied, 0.01);
+                          vega = (blackPrice(implied+h) -
+                                  blackPrice(implied-h))/(2*h);
+                      }
+                  } catch (...) {
+                      error = std::current_exception();
+                  }
+              }
+              if (error)
+                  std::rethrow_exception(error);
+              if (vega == 0.0) {
+                  // the implied volatility is floored or capped
+                  gradient *= 0.0;
+              }
+              else {
+                  QL_REQUIRE(vega > 0.0, "non-positive vega");
+                  gradient /= vega;
+              }
+            }
+            break;
+          default:
+            QL_FAIL("unknown Calibration Error Type");
+        }
+
+        return gradient;
+    }
 }
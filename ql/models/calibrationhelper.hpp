@@ -26,6 +26,7 @@
 #define quantlib_interest_rate_modelling_calibration_helper_h
 
 #include <ql/quote.hpp>
+#include <ql/math/array.hpp>
 #include <ql/termstructures/yieldtermstructure.hpp>
 #include <ql/termstructures/volatility/volatilitytype.hpp>
 #include <ql/patterns/lazyobject.hpp>
@@ -41,6 +42,16 @@ namespace QuantLib {
         virtual ~CalibrationHelper() {}
         //! returns the error resulting from the model valuation
         virtual Real calibrationError() = 0;
+        //! whether the gradient of the calibration error is available
+        virtual bool hasCalibrationErrorGradient() { return false; }
+        /*! returns the gradient of the calibration error w.r.t. the
+            model parameters. Once hasCalibrationErrorGradient() returned
+            true the method must not modify the helper, so that the
+            gradients of several helpers can be computed concurrently.
+        */
+        virtual Disposable<Array> calibrationErrorGradient() {
+            QL_FAIL("calibration error gradient not available");
+        }
     };
 
     /*! \deprecated Renamed to CalibrationHelper.
@@ -94,6 +105,11 @@ namespace QuantLib {
         //! returns the volatility type
         VolatilityType volatilityType() const { return volatilityType_; }
 
+        //! returns the calibration error type
+        CalibrationErrorType calibrationErrorType() const {
+            return calibrationErrorType_;
+        }
+
         //! returns the actual price of the instrument (from volatility)
         Real marketValue() const { calculate(); return marketValue_; }
 
@@ -103,6 +119,16 @@ namespace QuantLib {
         //! returns the error resulting from the model valuation
         Real calibrationError() override;
 
+        bool hasCalibrationErrorGradient() override;
+        Disposable<Array> calibrationErrorGradient() override;
+
+        //! whether the model value gradient is available
+        virtual bool hasModelValueGradient() const { return false; }
+        //! model value and its gradient w.r.t. the model parameters
+        virtual Real modelValueAndGradient(Array&) const {
+            QL_FAIL("model value gradient not available");
+        }
+
         virtual void addTimesTo(std::list<Time>& times) const = 0;
 
         //! Black volatility implied by the model
@@ -22,6 +22,8 @@
 #include <ql/models/equity/hestonmodelhelper.hpp>
 #include <ql/pricingengines/blackformula.hpp>
 #include <ql/processes/hestonprocess.hpp>
+#include <ql/pricingengines/vanilla/analytichestonengine.hpp>
+#include <ql/pricingengines/vanilla/analyticptdhestonengine.hpp>
 #include <ql/instruments/payoffs.hpp>
 #include <ql/quotes/simplequote.hpp>
 #include <ql/exercise.hpp>
@@ -87,6 +89,39 @@ namespace QuantLib {
         return option_->NPV();
     }
 
+    bool HestonModelHelper::hasModelValueGradient() const {
+        // otherwise, calibrations fall back to finite differences
+        const ext::shared_ptr<AnalyticHestonEngine> hestonEngine =
+            ext::dynamic_pointer_cast<AnalyticHestonEngine>(engine_);
+        if (hestonEngine)
+            return hestonEngine->supportsValueGradient();
+
+        const ext::shared_ptr<AnalyticPTDHestonEngine> ptdHestonEngine =
+            ext::dynamic_pointer_cast<AnalyticPTDHestonEngine>(engine_);
+        if (ptdHestonEngine)
+            return ptdHestonEngine->supportsValueGradient();
+
+        return false;
+    }
+
+    Real HestonModelHelper::modelValueAndGradient(Array& gradient) const {
+        calculate();
+
+        const ext::shared_ptr<AnalyticHestonEngine> hestonEngine =
+            ext::dynamic_pointer_cast<AnalyticHestonEngine>(engine_);
+        if (hestonEngine)
+            return hestonEngine->valueAndGradient(
+                gradient, exerciseDate_, type_, strikePrice_);
+
+        const ext::shared_ptr<AnalyticPTDHestonEngine> ptdHestonEngine =
+            ext::dynamic_pointer_cast<AnalyticPTDHestonEngine>(engine_);
+        if (ptdHestonEngine)
+            return ptdHestonEngine->valueAndGradient(
+                gradient, exerciseDate_, type_, strikePrice_);
+
+        QL_FAIL("model value gradient needs an analytic Heston engine");
+    }
+
     Real HestonModelHelper::blackPrice(Real volatility) const {
         calculate();
         const Real stdDev = volatility * std::sqrt(maturity());
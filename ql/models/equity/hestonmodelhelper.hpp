@@ -56,6 +56,8 @@ namespace QuantLib {
         void addTimesTo(std::list<Time>&) const override {}
         void performCalculations() const override;
         Real modelValue() const override;
+        bool hasModelValueGradient() const override;
+        Real modelValueAndGradient(Array& gradient) const override;
         Real blackPrice(Real volatility) const override;
         Time maturity() const  { calculate(); return tau_; }
       private:
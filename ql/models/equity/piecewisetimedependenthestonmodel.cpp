@@ -17,6 +17,7 @@
  FOR A PARTICULAR PURPOSE.  See the license for more details.
 */
 
+#include <ql/math/comparison.hpp>
 #include <ql/quotes/simplequote.hpp>
 #include <ql/models/equity/piecewisetimedependenthestonmodel.hpp>
 
@@ -49,6 +50,36 @@ namespace QuantLib {
         registerWith(dividendYield);
     }
 
+    Disposable<Matrix>
+    PiecewiseTimeDependentHestonModel::parameterSensitivities(Time t) const {
+        Size nParams = 0;
+        for (Size i=0; i < arguments_.size(); ++i)
+            nParams += arguments_[i].size();
+
+        Matrix sensitivities(4, nParams, 0.0);
+        for (Size i=0, k=0; i < 4; ++i) {
+            const Parameter& p = arguments_[i];
+
+            // the derivative w.r.t. the j-th param of a parameter which
+            // is linear in its params is its value for the j-th unit vector
+            Array e(p.size(), 0.0);
+            Real f = 0.0;
+            for (Size j=0; j < p.size(); ++j, ++k) {
+                e[j] = 1.0;
+                sensitivities[i][k] = p.implementation()->value(e, t);
+                e[j] = 0.0;
+
+                f += sensitivities[i][k]*p.params()[j];
+            }
+
+            QL_REQUIRE(close_enough(f, p(t)),
+                       "model parameter " << i << " is not linear "
+                       "in its params");
+        }
+
+        return sensitivities;
+    }
+
     const TimeGrid& PiecewiseTimeDependentHestonModel::timeGrid() const {
         return timeGrid_;
     }
@@ -25,6 +25,7 @@
 #define quantlib_piecewise_time_dependent_heston_model_hpp
 
 #include <ql/timegrid.hpp>
+#include <ql/math/matrix.hpp>
 #include <ql/models/model.hpp>
 
 namespace QuantLib {
@@ -67,6 +68,13 @@ namespace QuantLib {
         // spot
         Real s0()          const { return s0_->value(); }
 
+        // derivatives of theta(t), kappa(t), sigma(t) and rho(t), one
+        // row each, w.r.t. the model parameters in the order of params().
+        // The time-dependent parameters must be linear in their params,
+        // e.g. constant or piecewise constant, and the derivatives are
+        // exact.
+        Disposable<Matrix> parameterSensitivities(Time t) const;
+
         
         const TimeGrid& timeGrid() const;
         const Handle<YieldTermStructure>& dividendYield() const;
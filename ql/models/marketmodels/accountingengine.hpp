@@ -48,8 +48,11 @@ namespace QuantLib {
                          Real initialNumeraireValue);
         void multiplePathValues(SequenceStatisticsInc& stats,
                                 Size numberOfPaths);
-      private:
+        /*! collects the values of the products along the next path
+            of the evolver and returns the weight of the path.
+        */
         Real singlePathValues(std::vector<Real>& values);
+      private:
 
         ext::shared_ptr<MarketModelEvolver> evolver_;
         Clone<MarketModelMultiProduct> product_;
@@ -37,6 +37,12 @@ namespace QuantLib {
 
         virtual Size numberOfFactors() const = 0;
         virtual Size numberOfSteps() const = 0;
+
+        /*! skips the given number of paths.  The default
+            implementation generates and discards them; derived
+            classes can provide a faster skip-ahead.
+        */
+        virtual void skipPaths(Size n);
     };
 
     class BrownianGeneratorFactory {
@@ -47,6 +53,16 @@ namespace QuantLib {
                                                             Size steps) const = 0;
     };
 
+
+    inline void BrownianGenerator::skipPaths(Size n) {
+        std::vector<Real> variates(numberOfFactors());
+        for (Size i=0; i<n; ++i) {
+            nextPath();
+            for (Size j=0; j<numberOfSteps(); ++j)
+                nextStep(variates);
+        }
+    }
+
 }
 
 #endif
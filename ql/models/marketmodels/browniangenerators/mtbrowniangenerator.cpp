@@ -57,6 +57,13 @@ namespace QuantLib {
 
     Size MTBrownianGenerator::numberOfSteps() const { return steps_; }
 
+    void MTBrownianGenerator::skipPaths(Size n) {
+        // the uniform sequences are drawn, but not transformed
+        for (Size i=0; i<n; ++i)
+            generator_.nextSequence();
+        lastStep_ = 0;
+    }
+
 
     MTBrownianGeneratorFactory::MTBrownianGeneratorFactory(unsigned long seed)
     : seed_(seed) {}
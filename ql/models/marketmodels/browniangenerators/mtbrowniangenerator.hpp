@@ -52,6 +52,8 @@ namespace QuantLib {
         Size numberOfFactors() const override;
         Size numberOfSteps() const override;
 
+        void skipPaths(Size n) override;
+
       private:
         Size factors_, steps_;
         Size lastStep_;
@@ -114,9 +114,9 @@ namespace QuantLib {
                                         unsigned long seed,
                                         SobolRsg::DirectionIntegers integers)
     : factors_(factors), steps_(steps), ordering_(ordering),
-      generator_(SobolRsg(factors*steps, seed, integers),
-                 InverseCumulativeNormal()),
-      bridge_(steps), lastStep_(0),
+      generator_(factors*steps, seed, integers),
+      bridge_(steps), lastStep_(0), pathsDrawn_(0),
+      variates_(factors*steps),
       orderedIndices_(factors, std::vector<Size>(steps)),
       bridgedVariates_(factors, std::vector<Real>(steps)) {
 
@@ -137,18 +137,17 @@ namespace QuantLib {
 
 
     Real SobolBrownianGenerator::nextPath() {
-        typedef InverseCumulativeRsg<SobolRsg,
-                                     InverseCumulativeNormal>::sample_type
-            sample_type;
-
-        const sample_type& sample = generator_.nextSequence();
+        const SobolRsg::sample_type& sample = generator_.nextSequence();
+        for (Size i=0; i<variates_.size(); ++i)
+            variates_[i] = inverseCumulative_(sample.value[i]);
+        ++pathsDrawn_;
         // Brownian-bridge the variates according to the ordered indices
         for (Size i=0; i<factors_; ++i) {
             bridge_.transform(boost::make_permutation_iterator(
-                                                  sample.value.begin(),
+                                                  variates_.begin(),
                                                   orderedIndices_[i].begin()),
                               boost::make_permutation_iterator(
-                                                  sample.value.begin(),
+                                                  variates_.begin(),
                                                   orderedIndices_[i].end()),
                               bridgedVariates_[i].begin());
         }
@@ -208,6 +207,19 @@ namespace QuantLib {
 
     Size SobolBrownianGenerator::numberOfSteps() const { return steps_; }
 
+    void SobolBrownianGenerator::skipPaths(Size n) {
+        if (n == 0)
+            return;
+        // SobolRsg::skipTo(k) makes the next draw return the k-th
+        // point of the sequence if no point was drawn yet, and the
+        // (k+1)-th point otherwise
+        const Size next = pathsDrawn_ + n;
+        generator_.skipTo(static_cast<boost::uint_least32_t>(
+                                  pathsDrawn_ == 0 ? next : next-1));
+        pathsDrawn_ = next;
+        lastStep_ = 0;
+    }
+
 
 
     SobolBrownianGeneratorFactory::SobolBrownianGeneratorFactory(
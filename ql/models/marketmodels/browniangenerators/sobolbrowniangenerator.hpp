@@ -22,7 +22,6 @@
 #define quantlib_sobol_brownian_generator_hpp
 
 #include <ql/models/marketmodels/browniangenerator.hpp>
-#include <ql/math/randomnumbers/inversecumulativersg.hpp>
 #include <ql/math/randomnumbers/sobolrsg.hpp>
 #include <ql/methods/montecarlo/brownianbridge.hpp>
 #include <ql/math/distributions/normaldistribution.hpp>
@@ -60,6 +59,9 @@ namespace QuantLib {
         Size numberOfFactors() const override;
         Size numberOfSteps() const override;
 
+        //! skips ahead in the Sobol sequence
+        void skipPaths(Size n) override;
+
         // test interface
         const std::vector<std::vector<Size> >& orderedIndices() const;
         std::vector<std::vector<Real> > transform(
@@ -68,10 +70,13 @@ namespace QuantLib {
       private:
         Size factors_, steps_;
         Ordering ordering_;
-        InverseCumulativeRsg<SobolRsg,InverseCumulativeNormal> generator_;
+        SobolRsg generator_;
+        InverseCumulativeNormal inverseCumulative_;
         BrownianBridge bridge_;
         // work variables
         Size lastStep_;
+        Size pathsDrawn_;
+        std::vector<Real> variates_;
         std::vector<std::vector<Size> > orderedIndices_;
         std::vector<std::vector<Real> > bridgedVariates_;
     };
@@ -9,6 +9,7 @@
 #include <ql/models/marketmodels/callability/marketmodelparametricexercise.hpp>
 #include <ql/models/marketmodels/callability/nodedataprovider.hpp>
 #include <ql/models/marketmodels/callability/nothingexercisevalue.hpp>
+#include <ql/models/marketmodels/callability/parallelupperboundengine.hpp>
 #include <ql/models/marketmodels/callability/parametricexerciseadapter.hpp>
 #include <ql/models/marketmodels/callability/swapbasissystem.hpp>
 #include <ql/models/marketmodels/callability/swapforwardbasissystem.hpp>
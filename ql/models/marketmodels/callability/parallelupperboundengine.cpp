@@ -0,0 +1,356 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <ql/models/marketmodels/callability/parallelupperboundengine.hpp>
+#include <ql/models/marketmodels/products/multiproductcomposite.hpp>
+#include <ql/models/marketmodels/products/multistep/exerciseadapter.hpp>
+#include <ql/models/marketmodels/evolutiondescription.hpp>
+#include <ql/models/marketmodels/evolver.hpp>
+#include <ql/models/marketmodels/utilities.hpp>
+#include <algorithm>
+#include <exception>
+
+namespace QuantLib {
+
+    // Brownian increments of the inner paths of an outer path
+    class ParallelUpperBoundEngine::InnerBrownians {
+      public:
+        InnerBrownians(const BrownianGeneratorFactory& factory,
+                       Size steps)
+        : factory_(factory), steps_(steps), factors_(0), paths_(0),
+          generation_(0) {}
+        void create(Size factors) {
+            if (!generator_) {
+                generator_ = factory_.create(factors, steps_);
+                factors_ = factors;
+                variates_.resize(factors_);
+            }
+            QL_REQUIRE(factors == factors_, "factor mismatch");
+        }
+        void skipPaths(Size n) { generator_->skipPaths(n); }
+        void draw(Size paths) {
+            paths_ = paths;
+            pathWeights_.resize(paths);
+            stepWeights_.resize(paths*steps_);
+            brownians_.resize(paths*steps_*factors_);
+            for (Size i=0; i<paths; ++i) {
+                pathWeights_[i] = generator_->nextPath();
+                for (Size j=0; j<steps_; ++j) {
+                    stepWeights_[i*steps_+j] = generator_->nextStep(variates_);
+                    std::copy(variates_.begin(), variates_.end(),
+                              brownians_.begin() + (i*steps_+j)*factors_);
+                }
+            }
+            ++generation_;
+        }
+        Size steps() const { return steps_; }
+        Size factors() const { return factors_; }
+        Size paths() const { return paths_; }
+        unsigned long generation() const { return generation_; }
+        Real pathWeight(Size i) const { return pathWeights_[i]; }
+        Real stepWeight(Size i, Size j) const {
+            return stepWeights_[i*steps_+j];
+        }
+        std::vector<Real>::const_iterator brownians(Size i, Size j) const {
+            return brownians_.begin() + (i*steps_+j)*factors_;
+        }
+      private:
+        const BrownianGeneratorFactory& factory_;
+        Size steps_, factors_, paths_;
+        unsigned long generation_;
+        ext::shared_ptr<BrownianGenerator> generator_;
+        std::vector<Real> pathWeights_, stepWeights_, brownians_, variates_;
+    };
+
+
+    namespace {
+
+        // replays the final steps of the shared inner paths
+        template <class InnerBrownians>
+        class ReplayBrownianGenerator : public BrownianGenerator {
+          public:
+            ReplayBrownianGenerator(ext::shared_ptr<InnerBrownians> brownians,
+                                    Size steps)
+            : brownians_(std::move(brownians)), steps_(steps),
+              offset_(brownians_->steps()-steps), generation_(0),
+              path_(0), step_(0) {}
+            Real nextPath() override {
+                if (generation_ != brownians_->generation()) {
+                    generation_ = brownians_->generation();
+                    path_ = 0;
+                } else {
+                    ++path_;
+                }
+                QL_REQUIRE(path_ < brownians_->paths(),
+                           "shared inner paths exhausted");
+                step_ = 0;
+                return brownians_->pathWeight(path_);
+            }
+            Real nextStep(std::vector<Real>& output) override {
+                std::vector<Real>::const_iterator z =
+                    brownians_->brownians(path_, offset_+step_);
+                std::copy(z, z+brownians_->factors(), output.begin());
+                return brownians_->stepWeight(path_, offset_+step_++);
+            }
+            Size numberOfFactors() const override {
+                return brownians_->factors();
+            }
+            Size numberOfSteps() const override { return steps_; }
+          private:
+            ext::shared_ptr<InnerBrownians> brownians_;
+            Size steps_, offset_;
+            unsigned long generation_;
+            Size path_, step_;
+        };
+
+        template <class InnerBrownians>
+        class ReplayBrownianGeneratorFactory
+            : public BrownianGeneratorFactory {
+          public:
+            explicit ReplayBrownianGeneratorFactory(
+                                  ext::shared_ptr<InnerBrownians> brownians)
+            : brownians_(std::move(brownians)) {}
+            ext::shared_ptr<BrownianGenerator> create(
+                                     Size factors, Size steps) const override {
+                brownians_->create(factors);
+                QL_REQUIRE(steps <= brownians_->steps(),
+                           "too many steps for shared inner paths");
+                return ext::shared_ptr<BrownianGenerator>(
+                    new ReplayBrownianGenerator<InnerBrownians>(brownians_,
+                                                                steps));
+            }
+          private:
+            ext::shared_ptr<InnerBrownians> brownians_;
+        };
+
+        // keeps the generator it creates, so that it can be
+        // positioned at the first path of a batch
+        class RecordingBrownianGeneratorFactory
+            : public BrownianGeneratorFactory {
+          public:
+            explicit RecordingBrownianGeneratorFactory(
+                                     const BrownianGeneratorFactory& factory)
+            : factory_(factory) {}
+            ext::shared_ptr<BrownianGenerator> create(
+                                     Size factors, Size steps) const override {
+                generator_ = factory_.create(factors, steps);
+                return generator_;
+            }
+            const ext::shared_ptr<BrownianGenerator>& generator() const {
+                return generator_;
+            }
+          private:
+            const BrownianGeneratorFactory& factory_;
+            mutable ext::shared_ptr<BrownianGenerator> generator_;
+        };
+
+    }
+
+
+    ParallelUpperBoundEngine::ParallelUpperBoundEngine(
+             ext::shared_ptr<MarketModelEvolverFactory> evolverFactory,
+             ext::shared_ptr<BrownianGeneratorFactory> outerGeneratorFactory,
+             std::vector<ext::shared_ptr<BrownianGeneratorFactory> >
+                                                    innerGeneratorFactories,
+             const MarketModelMultiProduct& underlying,
+             const MarketModelExerciseValue& rebate,
+             const MarketModelMultiProduct& hedge,
+             const MarketModelExerciseValue& hedgeRebate,
+             const ExerciseStrategy<CurveState>& hedgeStrategy,
+             Real initialNumeraireValue,
+             bool shareInnerBrownians,
+             Size pathsPerBatch,
+             Size concurrentBatches)
+    : evolverFactory_(std::move(evolverFactory)),
+      outerGeneratorFactory_(std::move(outerGeneratorFactory)),
+      innerGeneratorFactories_(std::move(innerGeneratorFactories)),
+      underlying_(underlying.clone()), hedge_(hedge.clone()),
+      rebate_(rebate.clone()), hedgeRebate_(hedgeRebate.clone()),
+      hedgeStrategy_(hedgeStrategy.clone()),
+      initialNumeraireValue_(initialNumeraireValue),
+      shareInnerBrownians_(shareInnerBrownians),
+      pathsPerBatch_(pathsPerBatch), outerPathsDrawn_(0),
+      innerPathsDrawn_(0), lanes_(concurrentBatches) {
+        QL_REQUIRE(evolverFactory_, "no evolver factory given");
+        QL_REQUIRE(outerGeneratorFactory_, "no outer generator factory given");
+        QL_REQUIRE(pathsPerBatch_ > 0, "paths per batch must be positive");
+        QL_REQUIRE(concurrentBatches > 0,
+                   "number of concurrent batches must be positive");
+
+        // same evolution as the one used by UpperBoundEngine
+        MultiProductComposite composite;
+        composite.add(underlying);
+        composite.add(ExerciseAdapter(rebate));
+        composite.add(hedge);
+        composite.add(ExerciseAdapter(hedgeRebate));
+        composite.finalize();
+        numberOfSteps_ = composite.evolution().numberOfSteps();
+        std::valarray<bool> isExerciseTime =
+            isInSubset(composite.evolution().evolutionTimes(),
+                       hedgeStrategy.exerciseTimes());
+        for (Size s=0; s<isExerciseTime.size(); ++s)
+            if (isExerciseTime[s])
+                exerciseSteps_.push_back(s);
+        QL_REQUIRE(!exerciseSteps_.empty(), "no exercise times");
+
+        if (shareInnerBrownians_)
+            QL_REQUIRE(!innerGeneratorFactories_.empty(),
+                       "no inner generator factory given");
+        else
+            QL_REQUIRE(innerGeneratorFactories_.size() ==
+                       exerciseSteps_.size(),
+                       "one inner generator factory per exercise "
+                       "time required, " << innerGeneratorFactories_.size()
+                       << " given for " << exerciseSteps_.size()
+                       << " exercise times");
+        for (Size i=0; i<innerGeneratorFactories_.size(); ++i)
+            QL_REQUIRE(innerGeneratorFactories_[i],
+                       "null inner generator factory");
+    }
+
+    void ParallelUpperBoundEngine::createLane(Lane& lane) const {
+        std::vector<ext::shared_ptr<MarketModelEvolver> > innerEvolvers;
+        innerEvolvers.reserve(exerciseSteps_.size());
+        lane.innerGenerators.clear();
+        lane.innerBrownians.reset();
+
+        if (shareInnerBrownians_) {
+            lane.innerBrownians = ext::make_shared<InnerBrownians>(
+                                  *innerGeneratorFactories_.front(),
+                                  numberOfSteps_ - exerciseSteps_.front());
+            ReplayBrownianGeneratorFactory<InnerBrownians> factory(
+                                                         lane.innerBrownians);
+            for (Size j=0; j<exerciseSteps_.size(); ++j)
+                innerEvolvers.push_back(
+                    evolverFactory_->create(factory, exerciseSteps_[j]));
+        } else {
+            for (Size j=0; j<exerciseSteps_.size(); ++j) {
+                RecordingBrownianGeneratorFactory factory(
+                                             *innerGeneratorFactories_[j]);
+                innerEvolvers.push_back(
+                    evolverFactory_->create(factory, exerciseSteps_[j]));
+                // no inner simulation is run at the last step
+                if (exerciseSteps_[j] < numberOfSteps_-1)
+                    lane.innerGenerators.push_back(factory.generator());
+            }
+        }
+
+        RecordingBrownianGeneratorFactory factory(*outerGeneratorFactory_);
+        ext::shared_ptr<MarketModelEvolver> evolver =
+            evolverFactory_->create(factory, 0);
+        lane.outerGenerator = factory.generator();
+
+        lane.engine = ext::make_shared<UpperBoundEngine>(
+            evolver, innerEvolvers, *underlying_, *rebate_,
+            *hedge_, *hedgeRebate_, *hedgeStrategy_, initialNumeraireValue_);
+        lane.nextOuterPath = lane.nextInnerPath = 0;
+    }
+
+    void ParallelUpperBoundEngine::multiplePathValues(Statistics& stats,
+                                                      Size outerPaths,
+                                                      Size innerPaths) {
+        const Size lanes = lanes_.size();
+        std::vector<std::vector<std::pair<Real,Real> > > results(lanes);
+        std::vector<std::exception_ptr> errors(lanes);
+
+        const Size firstPath = outerPathsDrawn_,
+                   firstInnerPath = innerPathsDrawn_;
+        const Size lastPath = firstPath + outerPaths;
+        Size pathsDrawn = firstPath;
+        while (pathsDrawn < lastPath) {
+            const Size batches =
+                std::min(lanes, (lastPath - pathsDrawn + pathsPerBatch_ - 1)
+                                / pathsPerBatch_);
+
+            #pragma omp parallel for
+            for (long k=0; k<long(batches); ++k) {
+                try {
+                    Lane& lane = lanes_[k];
+                    const Size first = pathsDrawn + k*pathsPerBatch_;
+                    const Size paths = std::min(pathsPerBatch_,
+                                                lastPath - first);
+                    const Size firstInner =
+                        firstInnerPath + (first - firstPath)*innerPaths;
+                    if (!lane.engine)
+                        createLane(lane);
+
+                    lane.outerGenerator->skipPaths(first - lane.nextOuterPath);
+                    const Size innerSkip = firstInner - lane.nextInnerPath;
+                    if (lane.innerBrownians) {
+                        lane.innerBrownians->skipPaths(innerSkip);
+                    } else {
+                        for (Size j=0; j<lane.innerGenerators.size(); ++j)
+                            lane.innerGenerators[j]->skipPaths(innerSkip);
+                    }
+
+                    results[k].resize(paths);
+                    for (Size i=0; i<paths; ++i) {
+                        if (lane.innerBrownians)
+                            lane.innerBrownians->draw(innerPaths);
+                        results[k][i] = lane.engine->singlePathValue(innerPaths);
+                    }
+                    lane.nextOuterPath = first + paths;
+                    lane.nextInnerPath = firstInner + paths*innerPaths;
+                } catch (...) {
+                    errors[k] = std::current_exception();
+                }
+            }
+
+            for (Size k=0; k<batches; ++k) {
+                if (errors[k]) {
+                    // the engines are no longer in a known state
+                    for (Size j=0; j<lanes; ++j)
+                        lanes_[j] = Lane();
+                    std::rethrow_exception(errors[k]);
+                }
+            }
+
+            for (Size k=0; k<batches; ++k)
+                for (Size i=0; i<results[k].size(); ++i)
+                    stats.add(results[k][i].first, results[k][i].second);
+            pathsDrawn = std::min(lastPath,
+                                  pathsDrawn + batches*pathsPerBatch_);
+        }
+        outerPathsDrawn_ = lastPath;
+        innerPathsDrawn_ = firstInnerPath + outerPaths*innerPaths;
+    }
+
+    Real ParallelUpperBoundEngine::outerSimulationTime() const {
+        Real t = 0.0;
+        for (Size k=0; k<lanes_.size(); ++k)
+            if (lanes_[k].engine)
+                t += lanes_[k].engine->outerSimulationTime();
+        return t;
+    }
+
+    Real ParallelUpperBoundEngine::innerSimulationTime() const {
+        Real t = 0.0;
+        for (Size k=0; k<lanes_.size(); ++k)
+            if (lanes_[k].engine)
+                t += lanes_[k].engine->innerSimulationTime();
+        return t;
+    }
+
+    Size ParallelUpperBoundEngine::innerPathsSimulated() const {
+        Size n = 0;
+        for (Size k=0; k<lanes_.size(); ++k)
+            if (lanes_[k].engine)
+                n += lanes_[k].engine->innerPathsSimulated();
+        return n;
+    }
+
+}
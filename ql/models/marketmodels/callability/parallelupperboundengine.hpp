@@ -0,0 +1,118 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file parallelupperboundengine.hpp
+    \brief Upper-bound engine simulating outer paths in parallel
+*/
+
+#ifndef quantlib_parallel_upper_bound_engine_hpp
+#define quantlib_parallel_upper_bound_engine_hpp
+
+#include <ql/models/marketmodels/callability/upperboundengine.hpp>
+#include <ql/models/marketmodels/parallelaccountingengine.hpp>
+#include <ql/models/marketmodels/callability/exercisevalue.hpp>
+#include <ql/methods/montecarlo/exercisestrategy.hpp>
+
+namespace QuantLib {
+
+    //! Upper-bound engine simulating outer paths in parallel
+    /*! The outer paths are split in batches of fixed size, each of
+        which is simulated by its own UpperBoundEngine.  The engines
+        are built on evolvers returned by the given factory: the
+        outer evolver starts at step 0, while the inner evolver for
+        the exercise at step \f$ s \f$ starts at step \f$ s \f$ and
+        uses the corresponding inner generator factory.  Generators
+        are positioned by means of BrownianGenerator::skipPaths;
+        therefore, the results equal the ones of an UpperBoundEngine
+        built on evolvers from the same factories, regardless of the
+        number of threads.
+
+        If the inner Brownian increments are shared, the first inner
+        factory is used for all exercise dates.  For each outer
+        path, the increments of the inner paths are drawn once for
+        the longest inner simulation; the inner simulations at later
+        exercise dates reuse their final steps.  Each inner estimate
+        is still unbiased, while the generation of the increments is
+        no longer repeated for each exercise date.
+
+        As in UpperBoundEngine, inner paths end as soon as the hedge
+        strategy exercises; the time spent in outer and inner
+        simulations is reported separately.
+
+        \pre product and hedge must have the same rate times
+             and exercise times
+    */
+    class ParallelUpperBoundEngine {
+      public:
+        ParallelUpperBoundEngine(
+             ext::shared_ptr<MarketModelEvolverFactory> evolverFactory,
+             ext::shared_ptr<BrownianGeneratorFactory> outerGeneratorFactory,
+             std::vector<ext::shared_ptr<BrownianGeneratorFactory> >
+                                                    innerGeneratorFactories,
+             const MarketModelMultiProduct& underlying,
+             const MarketModelExerciseValue& rebate,
+             const MarketModelMultiProduct& hedge,
+             const MarketModelExerciseValue& hedgeRebate,
+             const ExerciseStrategy<CurveState>& hedgeStrategy,
+             Real initialNumeraireValue,
+             bool shareInnerBrownians = false,
+             Size pathsPerBatch = 8,
+             Size concurrentBatches = 16);
+        void multiplePathValues(Statistics& stats,
+                                Size outerPaths,
+                                Size innerPaths);
+        //! \name Instrumentation
+        /*! Times are in seconds and summed over the batch engines;
+            they do not include the time spent waiting for other
+            threads.
+        */
+        //@{
+        Real outerSimulationTime() const;
+        Real innerSimulationTime() const;
+        Size innerPathsSimulated() const;
+        //@}
+      private:
+        class InnerBrownians;
+        struct Lane {
+            ext::shared_ptr<UpperBoundEngine> engine;
+            ext::shared_ptr<BrownianGenerator> outerGenerator;
+            std::vector<ext::shared_ptr<BrownianGenerator> > innerGenerators;
+            ext::shared_ptr<InnerBrownians> innerBrownians;
+            Size nextOuterPath, nextInnerPath;
+        };
+        void createLane(Lane& lane) const;
+
+        ext::shared_ptr<MarketModelEvolverFactory> evolverFactory_;
+        ext::shared_ptr<BrownianGeneratorFactory> outerGeneratorFactory_;
+        std::vector<ext::shared_ptr<BrownianGeneratorFactory> >
+                                                    innerGeneratorFactories_;
+        Clone<MarketModelMultiProduct> underlying_, hedge_;
+        Clone<MarketModelExerciseValue> rebate_, hedgeRebate_;
+        Clone<ExerciseStrategy<CurveState> > hedgeStrategy_;
+        Real initialNumeraireValue_;
+        bool shareInnerBrownians_;
+        Size pathsPerBatch_;
+        Size numberOfSteps_;
+        std::vector<Size> exerciseSteps_;
+        Size outerPathsDrawn_, innerPathsDrawn_;
+        std::vector<Lane> lanes_;
+    };
+
+}
+
+
+#endif
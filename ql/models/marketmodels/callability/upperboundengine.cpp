@@ -30,6 +30,7 @@
 #include <ql/models/marketmodels/callability/exercisevalue.hpp>
 #include <ql/auto_ptr.hpp>
 #include <algorithm>
+#include <chrono>
 
 namespace QuantLib {
 
@@ -119,7 +120,9 @@ namespace QuantLib {
                    Real initialNumeraireValue)
     : evolver_(evolver), innerEvolvers_(innerEvolvers),
       composite_(MultiProductComposite()),
-      initialNumeraireValue_(initialNumeraireValue) {
+      initialNumeraireValue_(initialNumeraireValue),
+      outerSimulationTime_(0.0), innerSimulationTime_(0.0),
+      innerPathsSimulated_(0) {
 
         composite_.add(underlying);
         composite_.add(ExerciseAdapter(rebate));
@@ -179,6 +182,10 @@ namespace QuantLib {
 
     std::pair<Real,Real> UpperBoundEngine::singlePathValue(Size innerPaths) {
 
+        typedef std::chrono::steady_clock clock;
+        const clock::time_point start = clock::now();
+        Real innerTime = 0.0;
+
         auto& callable = dynamic_cast<DecoratedHedge&>(composite_.item(4));
         const ExerciseStrategy<CurveState>& strategy = callable.strategy();
 
@@ -253,11 +260,15 @@ namespace QuantLib {
                     callable.save();
 
                     // This allows us to write:
+                    const clock::time_point innerStart = clock::now();
                     AccountingEngine engine(currentEvolver, callable,
                                             1.0); // this causes the result
                                                   // to be in numeraire units
                     SequenceStatisticsInc innerStats(callable.numberOfProducts());
                     engine.multiplePathValues(innerStats, innerPaths);
+                    innerTime += std::chrono::duration<Real>(
+                                          clock::now() - innerStart).count();
+                    innerPathsSimulated_ += innerPaths;
 
                     const std::vector<Real>& values = innerStats.mean();
                     unexercisedHedgeValue =
@@ -317,6 +328,11 @@ namespace QuantLib {
         // all done; we just convert the result back to cash
         maximumValue *= initialNumeraireValue_;
 
+        innerSimulationTime_ += innerTime;
+        outerSimulationTime_ +=
+            std::chrono::duration<Real>(clock::now() - start).count()
+            - innerTime;
+
         return std::make_pair(maximumValue, weight);
     }
 
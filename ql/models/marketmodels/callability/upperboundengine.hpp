@@ -56,6 +56,16 @@ namespace QuantLib {
                                 Size outerPaths,
                                 Size innerPaths);
         std::pair<Real,Real> singlePathValue(Size innerPaths);
+        //! \name Instrumentation
+        /*! Wall-clock times, in seconds, accumulated over the paths
+            simulated so far.  The outer time excludes the time spent
+            in inner simulations.
+        */
+        //@{
+        Real outerSimulationTime() const { return outerSimulationTime_; }
+        Real innerSimulationTime() const { return innerSimulationTime_; }
+        Size innerPathsSimulated() const { return innerPathsSimulated_; }
+        //@}
       private:
         Real collectCashFlows(Size currentStep,
                               Real principalInNumerairePortfolio,
@@ -73,6 +83,9 @@ namespace QuantLib {
         Size numberOfSteps_;
         std::valarray<bool> isExerciseTime_;
 
+        Real outerSimulationTime_, innerSimulationTime_;
+        Size innerPathsSimulated_;
+
         // workspace
         std::vector<Size> numberCashFlowsThisStep_;
         std::vector<std::vector<MarketModelMultiProduct::CashFlow> >
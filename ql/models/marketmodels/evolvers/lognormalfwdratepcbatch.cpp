@@ -0,0 +1,309 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <ql/models/marketmodels/evolvers/lognormalfwdratepcbatch.hpp>
+#include <ql/models/marketmodels/marketmodel.hpp>
+#include <ql/models/marketmodels/evolutiondescription.hpp>
+#include <ql/models/marketmodels/browniangenerator.hpp>
+#include <ql/models/marketmodels/driftcomputation/lmmdriftcalculator.hpp>
+#include <algorithm>
+
+namespace QuantLib {
+
+    LogNormalFwdRatePcBatch::LogNormalFwdRatePcBatch(
+                           const ext::shared_ptr<MarketModel>& marketModel,
+                           const BrownianGeneratorFactory& factory,
+                           const std::vector<Size>& numeraires,
+                           Size initialStep,
+                           Size pathsPerBlock)
+    : marketModel_(marketModel),
+      numeraires_(numeraires),
+      initialStep_(initialStep), pathsPerBlock_(pathsPerBlock),
+      numberOfRates_(marketModel->numberOfRates()),
+      numberOfFactors_(marketModel->numberOfFactors()),
+      numberOfSteps_(marketModel->evolution().numberOfSteps()),
+      isFullFactor_(numberOfFactors_ == numberOfRates_),
+      displacements_(marketModel->displacements()),
+      oneOverTaus_(numberOfRates_),
+      alive_(marketModel->evolution().firstAliveRate()),
+      initialLogForwards_(numberOfRates_), initialDrifts_(numberOfRates_),
+      curveState_(marketModel->evolution().rateTimes()),
+      forwards_(marketModel->initialRates()),
+      currentStep_(initialStep), currentPath_(0), evolved_(false)
+    {
+        checkCompatibility(marketModel->evolution(), numeraires);
+        QL_REQUIRE(pathsPerBlock_ > 0, "paths per block must be positive");
+
+        generator_ = factory.create(numberOfFactors_,
+                                    numberOfSteps_-initialStep_);
+
+        const std::vector<Time>& taus = marketModel->evolution().rateTaus();
+        for (Size i=0; i<numberOfRates_; ++i)
+            oneOverTaus_[i] = 1.0/taus[i];
+
+        pseudoRoots_.reserve(numberOfSteps_);
+        fixedDrifts_.reserve(numberOfSteps_);
+        for (Size j=0; j<numberOfSteps_; ++j) {
+            const Matrix& A = marketModel->pseudoRoot(j);
+            pseudoRoots_.push_back(A);
+            if (isFullFactor_)
+                covariances_.push_back(A*transpose(A));
+            std::vector<Real> fixed(numberOfRates_);
+            for (Size k=0; k<numberOfRates_; ++k) {
+                Real variance =
+                    std::inner_product(A.row_begin(k), A.row_end(k),
+                                       A.row_begin(k), 0.0);
+                fixed[k] = -0.5*variance;
+            }
+            fixedDrifts_.push_back(fixed);
+        }
+
+        const Size steps = numberOfSteps_-initialStep_;
+        brownians_.resize(steps, Matrix(numberOfFactors_, pathsPerBlock_));
+        forwardPaths_.resize(steps, Matrix(numberOfRates_, pathsPerBlock_));
+        pathWeights_.resize(pathsPerBlock_);
+        stepWeights_ = Matrix(steps, pathsPerBlock_);
+        logForwards_ = drifts1_ = drifts2_ = tmp_ =
+            Matrix(numberOfRates_, pathsPerBlock_);
+        e_ = Matrix(numberOfFactors_, pathsPerBlock_);
+        correlatedBrownians_.resize(pathsPerBlock_);
+        variates_.resize(numberOfFactors_);
+
+        // the first call to startNewPath draws a new block
+        currentPath_ = pathsPerBlock_-1;
+
+        setForwards(marketModel_->initialRates());
+    }
+
+    const std::vector<Size>& LogNormalFwdRatePcBatch::numeraires() const {
+        return numeraires_;
+    }
+
+    void LogNormalFwdRatePcBatch::setForwards(
+                                        const std::vector<Real>& forwards) {
+        QL_REQUIRE(forwards.size()==numberOfRates_,
+                   "mismatch between forwards and rateTimes");
+        for (Size i=0; i<numberOfRates_; ++i)
+            initialLogForwards_[i] = std::log(forwards[i] +
+                                              displacements_[i]);
+        LMMDriftCalculator calculator(
+                              pseudoRoots_[initialStep_], displacements_,
+                              marketModel_->evolution().rateTaus(),
+                              numeraires_[initialStep_],
+                              alive_[initialStep_]);
+        calculator.compute(forwards, initialDrifts_);
+        // paths already drawn must be evolved again
+        evolved_ = false;
+    }
+
+    void LogNormalFwdRatePcBatch::setInitialState(const CurveState& cs) {
+        setForwards(cs.forwardRates());
+    }
+
+    Real LogNormalFwdRatePcBatch::startNewPath() {
+        if (++currentPath_ == pathsPerBlock_) {
+            generateBlock();
+            currentPath_ = 0;
+        }
+        if (!evolved_) {
+            evolveBlock();
+            evolved_ = true;
+        }
+        currentStep_ = initialStep_;
+        return pathWeights_[currentPath_];
+    }
+
+    Real LogNormalFwdRatePcBatch::advanceStep() {
+        const Size k = currentStep_-initialStep_;
+        const Matrix& paths = forwardPaths_[k];
+        for (Size i=0; i<numberOfRates_; ++i)
+            forwards_[i] = paths[i][currentPath_];
+        curveState_.setOnForwardRates(forwards_);
+        ++currentStep_;
+        return stepWeights_[k][currentPath_];
+    }
+
+    Size LogNormalFwdRatePcBatch::currentStep() const {
+        return currentStep_;
+    }
+
+    const CurveState& LogNormalFwdRatePcBatch::currentState() const {
+        return curveState_;
+    }
+
+    void LogNormalFwdRatePcBatch::generateBlock() {
+        const Size steps = numberOfSteps_-initialStep_;
+        for (Size p=0; p<pathsPerBlock_; ++p) {
+            pathWeights_[p] = generator_->nextPath();
+            for (Size k=0; k<steps; ++k) {
+                stepWeights_[k][p] = generator_->nextStep(variates_);
+                for (Size f=0; f<numberOfFactors_; ++f)
+                    brownians_[k][f][p] = variates_[f];
+            }
+        }
+        evolved_ = false;
+    }
+
+    void LogNormalFwdRatePcBatch::evolveBlock() {
+        const Size n = numberOfRates_, m = pathsPerBlock_;
+        const std::vector<Rate>& initialRates = marketModel_->initialRates();
+
+        for (Size i=0; i<n; ++i)
+            std::fill(logForwards_.row_begin(i), logForwards_.row_end(i),
+                      initialLogForwards_[i]);
+
+        for (Size k=0; k<numberOfSteps_-initialStep_; ++k) {
+            const Size step = initialStep_+k;
+            const Size alive = alive_[step];
+            Matrix& forwards = forwardPaths_[k];
+
+            // rates no longer alive keep their last value
+            if (k == 0) {
+                for (Size i=0; i<n; ++i)
+                    std::fill(forwards.row_begin(i), forwards.row_end(i),
+                              initialRates[i]);
+            } else {
+                forwards = forwardPaths_[k-1];
+            }
+
+            // a) compute drifts D1 at T1;
+            if (k > 0) {
+                computeDrifts(step, forwards, drifts1_);
+            } else {
+                for (Size i=alive; i<n; ++i)
+                    std::fill(drifts1_.row_begin(i), drifts1_.row_end(i),
+                              initialDrifts_[i]);
+            }
+
+            // b) evolve forwards up to T2 using D1; the correlated
+            //    Brownians of all paths are accumulated factor by
+            //    factor, as a product between the pseudo-root and
+            //    the block of variates
+            const Matrix& A = pseudoRoots_[step];
+            const Matrix& z = brownians_[k];
+            const std::vector<Real>& fixedDrift = fixedDrifts_[step];
+            for (Size i=alive; i<n; ++i) {
+                Real* logF = logForwards_.row_begin(i);
+                Real* f = forwards.row_begin(i);
+                const Real* d1 = drifts1_.row_begin(i);
+                Real* w = &correlatedBrownians_[0];
+                for (Size p=0; p<m; ++p) {
+                    logF[p] += d1[p] + fixedDrift[i];
+                    w[p] = 0.0;
+                }
+                for (Size r=0; r<numberOfFactors_; ++r) {
+                    const Real a = A[i][r];
+                    const Real* zr = z.row_begin(r);
+                    for (Size p=0; p<m; ++p)
+                        w[p] += a*zr[p];
+                }
+                for (Size p=0; p<m; ++p) {
+                    logF[p] += w[p];
+                    f[p] = std::exp(logF[p]) - displacements_[i];
+                }
+            }
+
+            // c) recompute drifts D2 using the predicted forwards;
+            computeDrifts(step, forwards, drifts2_);
+
+            // d) correct forwards using both drifts
+            for (Size i=alive; i<n; ++i) {
+                Real* logF = logForwards_.row_begin(i);
+                Real* f = forwards.row_begin(i);
+                const Real* d1 = drifts1_.row_begin(i);
+                const Real* d2 = drifts2_.row_begin(i);
+                for (Size p=0; p<m; ++p) {
+                    logF[p] += (d2[p]-d1[p])/2.0;
+                    f[p] = std::exp(logF[p]) - displacements_[i];
+                }
+            }
+        }
+    }
+
+    // same calculations as LMMDriftCalculator, for all paths at once
+    void LogNormalFwdRatePcBatch::computeDrifts(Size step,
+                                                const Matrix& forwards,
+                                                Matrix& drifts) const {
+        const Size n = numberOfRates_, m = pathsPerBlock_;
+        const Size alive = alive_[step], numeraire = numeraires_[step];
+
+        for (Size i=alive; i<n; ++i) {
+            const Real* f = forwards.row_begin(i);
+            Real* t = tmp_.row_begin(i);
+            for (Size p=0; p<m; ++p)
+                t[p] = (f[p]+displacements_[i]) / (oneOverTaus_[i]+f[p]);
+        }
+
+        if (isFullFactor_) {
+            const Matrix& C = covariances_[step];
+            for (Size i=alive; i<n; ++i) {
+                Real* d = drifts.row_begin(i);
+                std::fill(d, d+m, 0.0);
+                Size down = std::min(i+1, numeraire),
+                     up = std::max(i+1, numeraire);
+                for (Size j=down; j<up; ++j) {
+                    const Real c = C[i][j];
+                    const Real* t = tmp_.row_begin(j);
+                    for (Size p=0; p<m; ++p)
+                        d[p] += t[p]*c;
+                }
+                if (numeraire > i+1) {
+                    for (Size p=0; p<m; ++p)
+                        d[p] = -d[p];
+                }
+            }
+        } else {
+            const Matrix& A = pseudoRoots_[step];
+            if (numeraire > 0)
+                std::fill(drifts.row_begin(numeraire-1),
+                          drifts.row_end(numeraire-1), 0.0);
+
+            // move backward from N-2 to alive...
+            std::fill(e_.begin(), e_.end(), 0.0);
+            for (Integer i=Integer(numeraire)-2; i>=Integer(alive); --i) {
+                Real* d = drifts.row_begin(i);
+                const Real* t = tmp_.row_begin(i+1);
+                std::fill(d, d+m, 0.0);
+                for (Size r=0; r<numberOfFactors_; ++r) {
+                    const Real a1 = A[i+1][r], a0 = A[i][r];
+                    Real* e = e_.row_begin(r);
+                    for (Size p=0; p<m; ++p) {
+                        e[p] += t[p]*a1;
+                        d[p] -= e[p]*a0;
+                    }
+                }
+            }
+
+            // ...and forward from N to the last rate
+            std::fill(e_.begin(), e_.end(), 0.0);
+            for (Size i=numeraire; i<n; ++i) {
+                Real* d = drifts.row_begin(i);
+                const Real* t = tmp_.row_begin(i);
+                std::fill(d, d+m, 0.0);
+                for (Size r=0; r<numberOfFactors_; ++r) {
+                    const Real a = A[i][r];
+                    Real* e = e_.row_begin(r);
+                    for (Size p=0; p<m; ++p) {
+                        e[p] += t[p]*a;
+                        d[p] += e[p]*a;
+                    }
+                }
+            }
+        }
+    }
+
+}
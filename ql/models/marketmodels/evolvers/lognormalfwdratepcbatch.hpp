@@ -0,0 +1,110 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file lognormalfwdratepcbatch.hpp
+    \brief Predictor-corrector evolving blocks of paths in lockstep
+*/
+
+#ifndef quantlib_forward_rate_pc_batch_evolver_hpp
+#define quantlib_forward_rate_pc_batch_evolver_hpp
+
+#include <ql/models/marketmodels/evolver.hpp>
+#include <ql/models/marketmodels/curvestates/lmmcurvestate.hpp>
+#include <ql/math/matrix.hpp>
+
+namespace QuantLib {
+
+    class MarketModel;
+    class BrownianGenerator;
+    class BrownianGeneratorFactory;
+
+    //! Predictor-Corrector evolving blocks of paths in lockstep
+    /*! The discretization is the one of LogNormalFwdRatePc.  When
+        the first path of a block is started, the Brownian variates
+        of the next pathsPerBlock paths are drawn and the paths are
+        evolved together; the state of each rate is stored
+        contiguously across the paths of the block, so that the
+        inner loops run over paths and can be vectorized by the
+        compiler.  At each step, the Brownian variates of the block
+        are correlated by a single product with the pseudo-root;
+        the covariance matrices and the variance corrections used by
+        the drifts are precomputed on construction.
+
+        The evolved forwards are stored for all steps of the block
+        and returned path by path through the MarketModelEvolver
+        interface, so that the evolver can be used with the
+        existing products and accounting engines.  Given the same
+        generator, the simulated paths are the same as the ones of
+        LogNormalFwdRatePc.
+
+        \warning Up to pathsPerBlock-1 paths more than the ones
+                 actually used are drawn from the generator.
+    */
+    class LogNormalFwdRatePcBatch : public MarketModelEvolver {
+      public:
+        LogNormalFwdRatePcBatch(const ext::shared_ptr<MarketModel>&,
+                                const BrownianGeneratorFactory&,
+                                const std::vector<Size>& numeraires,
+                                Size initialStep = 0,
+                                Size pathsPerBlock = 64);
+        //! \name MarketModel interface
+        //@{
+        const std::vector<Size>& numeraires() const override;
+        Real startNewPath() override;
+        Real advanceStep() override;
+        Size currentStep() const override;
+        const CurveState& currentState() const override;
+        void setInitialState(const CurveState&) override;
+        //@}
+      private:
+        void setForwards(const std::vector<Real>& forwards);
+        void generateBlock();
+        void evolveBlock();
+        void computeDrifts(Size step,
+                           const Matrix& forwards,
+                           Matrix& drifts) const;
+        // inputs
+        ext::shared_ptr<MarketModel> marketModel_;
+        std::vector<Size> numeraires_;
+        Size initialStep_, pathsPerBlock_;
+        ext::shared_ptr<BrownianGenerator> generator_;
+        // fixed variables
+        Size numberOfRates_, numberOfFactors_, numberOfSteps_;
+        bool isFullFactor_;
+        std::vector<Rate> displacements_;
+        std::vector<Real> oneOverTaus_;
+        std::vector<Size> alive_;
+        std::vector<Matrix> pseudoRoots_, covariances_;
+        std::vector<std::vector<Real> > fixedDrifts_;
+        std::vector<Real> initialLogForwards_, initialDrifts_;
+        // block variables; rows are rates (or factors), columns paths
+        std::vector<Matrix> brownians_, forwardPaths_;
+        std::vector<Real> pathWeights_;
+        Matrix stepWeights_;
+        Matrix logForwards_, drifts1_, drifts2_;
+        mutable Matrix tmp_, e_;
+        std::vector<Real> correlatedBrownians_, variates_;
+        // working variables
+        LMMCurveState curveState_;
+        std::vector<Rate> forwards_;
+        Size currentStep_, currentPath_;
+        bool evolved_;
+    };
+
+}
+
+#endif
@@ -86,13 +86,7 @@ namespace QuantLib {
 
         std::vector<Matrix>& swapCovariancePseudoRoots) {
 
-        CTSMMCapletCalibration::performChecks(evolution, corr,
-            displacedSwapVariances, capletVols, cs);
-
-        Size numberOfSteps = evolution.numberOfSteps();
         Size numberOfRates = evolution.numberOfRates();
-        const std::vector<Time>& rateTimes = evolution.rateTimes();
-
         QL_REQUIRE(numberOfFactors<=numberOfRates,
                    "number of factors (" << numberOfFactors <<
                    ") cannot be greater than numberOfRates (" <<
@@ -101,24 +95,75 @@ namespace QuantLib {
                    "number of factors (" << numberOfFactors <<
                    ") must be greater than zero");
 
-        Natural failures=0;
-
-        alpha.resize(numberOfRates);
-        a.resize(numberOfRates);
-        b.resize(numberOfRates);
-
         // factor reduction
-        std::vector<Matrix> corrPseudo(corr.times().size());
-        for (Size i=0; i<corrPseudo.size(); ++i)
-            corrPseudo[i] = rankReducedSqrt(corr.correlation(i),
-                                            numberOfFactors, 1.0,
-                                            SalvagingAlgorithm::None);
+        std::vector<Matrix> corrPseudo =
+            CTSMMCapletCalibration::correlationPseudoRoots(corr,
+                                                           numberOfFactors);
 
         // get Zinverse, we can get wj later
         Matrix zedMatrix =
             SwapForwardMappings::coterminalSwapZedMatrix(cs, displacement);
         Matrix invertedZedMatrix = inverse(zedMatrix);
 
+        return capletAlphaFormCalibration(evolution, corr,
+                                          displacedSwapVariances,
+                                          capletVols, cs,
+                                          alphaInitial, alphaMax, alphaMin,
+                                          maximizeHomogeneity,
+                                          parametricForm,
+                                          corrPseudo, invertedZedMatrix,
+                                          maxIterations, tolerance,
+                                          alpha, a, b,
+                                          swapCovariancePseudoRoots);
+    }
+
+    Natural CTSMMCapletAlphaFormCalibration::capletAlphaFormCalibration(
+        const EvolutionDescription& evolution,
+        const PiecewiseConstantCorrelation& corr,
+        const std::vector<ext::shared_ptr<PiecewiseConstantVariance> >& displacedSwapVariances,
+        const std::vector<Volatility>& capletVols,
+        const CurveState& cs,
+
+        const std::vector<Real>& alphaInitial,
+        const std::vector<Real>& alphaMax,
+        const std::vector<Real>& alphaMin,
+        bool maximizeHomogeneity,
+        const ext::shared_ptr<AlphaForm>& parametricForm,
+
+        const std::vector<Matrix>& corrPseudo,
+        const Matrix& invertedZedMatrix,
+        Integer maxIterations,
+        Real tolerance,
+
+        std::vector<Real>& alpha,
+        std::vector<Real>& a,
+        std::vector<Real>& b,
+
+        std::vector<Matrix>& swapCovariancePseudoRoots) {
+
+        CTSMMCapletCalibration::performChecks(evolution, corr,
+            displacedSwapVariances, capletVols, cs);
+
+        Size numberOfSteps = evolution.numberOfSteps();
+        Size numberOfRates = evolution.numberOfRates();
+        const std::vector<Time>& rateTimes = evolution.rateTimes();
+
+        QL_REQUIRE(corrPseudo.size()==numberOfSteps,
+                   "mismatch between number of steps (" << numberOfSteps <<
+                   ") and correlation pseudo-roots (" <<
+                   corrPseudo.size() << ")");
+        QL_REQUIRE(invertedZedMatrix.rows()==numberOfRates &&
+                   invertedZedMatrix.columns()==numberOfRates,
+                   "inverted Z matrix must be " << numberOfRates <<
+                   "x" << numberOfRates);
+        Size numberOfFactors = corrPseudo.front().columns();
+
+        Natural failures=0;
+
+        alpha.resize(numberOfRates);
+        a.resize(numberOfRates);
+        b.resize(numberOfRates);
+
         // vectors for new vol
         std::vector<std::vector<Volatility> > newVols;
         std::vector<Volatility> theseNewVols(numberOfRates);
@@ -231,7 +276,7 @@ namespace QuantLib {
     }
 
     Natural CTSMMCapletAlphaFormCalibration::calibrationImpl_(
-                                Natural numberOfFactors,
+                                Natural,
                                 Natural maxIterations,
                                 Real tolerance) {
 
@@ -241,7 +286,6 @@ namespace QuantLib {
                                           // not mktCapletVols_ but...
                                           usedCapletVols_,
                                           *cs_,
-                                          displacement_,
 
                                           alphaInitial_,
                                           alphaMax_,
@@ -249,7 +293,8 @@ namespace QuantLib {
                                           maximizeHomogeneity_,
                                           parametricForm_,
 
-                                          numberOfFactors,
+                                          corrPseudo_,
+                                          invertedZedMatrix_,
                                           maxIterations,
                                           tolerance,
 
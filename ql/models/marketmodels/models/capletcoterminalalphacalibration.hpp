@@ -66,6 +66,32 @@ namespace QuantLib {
             std::vector<Real>& a,
             std::vector<Real>& b,
 
+            std::vector<Matrix>& swapCovariancePseudoRoots);
+        /*! As above, with the factor reduction of the correlation
+            and the inverse of the Z matrix already computed.
+        */
+        static Natural capletAlphaFormCalibration(
+            const EvolutionDescription& evolution,
+            const PiecewiseConstantCorrelation& corr,
+            const std::vector<ext::shared_ptr<PiecewiseConstantVariance> >& displacedSwapVariances,
+            const std::vector<Volatility>& capletVols,
+            const CurveState& cs,
+
+            const std::vector<Real>& alphaInitial,
+            const std::vector<Real>& alphaMax,
+            const std::vector<Real>& alphaMin,
+            bool maximizeHomogeneity,
+            const ext::shared_ptr<AlphaForm>& parametricForm,
+
+            const std::vector<Matrix>& corrPseudo,
+            const Matrix& invertedZedMatrix,
+            Integer steps,
+            Real toleranceForAlphaSolving,
+
+            std::vector<Real>& alpha,
+            std::vector<Real>& a,
+            std::vector<Real>& b,
+
             std::vector<Matrix>& swapCovariancePseudoRoots);
 
       private:
@@ -280,14 +280,7 @@ namespace QuantLib {
         Real& totalSwaptionError, // ret value
         std::vector<Matrix>& swapCovariancePseudoRoots) 
     {
-
-            CTSMMCapletCalibration::performChecks(evolution, corr,
-                displacedSwapVariances, capletVols, cs);
-
-            Size numberOfSteps = evolution.numberOfSteps();
             Size numberOfRates = evolution.numberOfRates();
-            const std::vector<Time>& rateTimes = evolution.rateTimes();
-
             QL_REQUIRE(numberOfFactors<=numberOfRates,
                 "number of factors (" << numberOfFactors <<
                 ") cannot be greater than numberOfRates (" <<
@@ -296,24 +289,62 @@ namespace QuantLib {
                 "number of factors (" << numberOfFactors <<
                 ") must be greater than zero");
 
-
-            Natural failures=0;
-
-            totalSwaptionError = 0.0;
-            deformationSize = 0.0;
-
             // factor reduction
-            std::vector<Matrix> corrPseudo(corr.times().size());
-            for (Size i=0; i<corrPseudo.size(); ++i)
-                corrPseudo[i] = rankReducedSqrt(corr.correlation(i),
-                numberOfFactors, 1.0,
-                SalvagingAlgorithm::None);
+            std::vector<Matrix> corrPseudo =
+                CTSMMCapletCalibration::correlationPseudoRoots(corr,
+                                                               numberOfFactors);
 
             // get Zinverse, we can get wj later
             Matrix zedMatrix =
                 SwapForwardMappings::coterminalSwapZedMatrix(cs, displacement);
             Matrix invertedZedMatrix = inverse(zedMatrix);
 
+            return capletMaxHomogeneityCalibration(
+                evolution, corr, displacedSwapVariances, capletVols, cs,
+                caplet0Swaption1Priority, corrPseudo, invertedZedMatrix,
+                maxIterations, tolerance, deformationSize,
+                totalSwaptionError, swapCovariancePseudoRoots);
+    }
+
+    Natural CTSMMCapletMaxHomogeneityCalibration::capletMaxHomogeneityCalibration(
+        const EvolutionDescription& evolution,
+        const PiecewiseConstantCorrelation& corr,
+        const std::vector<ext::shared_ptr<
+        PiecewiseConstantVariance> >& displacedSwapVariances,
+        const std::vector<Volatility>& capletVols,
+        const CurveState& cs,
+        Real caplet0Swaption1Priority, 
+        const std::vector<Matrix>& corrPseudo,
+        const Matrix& invertedZedMatrix,
+        Size maxIterations,
+        Real tolerance,
+        Real& deformationSize,  // ret value
+        Real& totalSwaptionError, // ret value
+        std::vector<Matrix>& swapCovariancePseudoRoots) 
+    {
+
+            CTSMMCapletCalibration::performChecks(evolution, corr,
+                displacedSwapVariances, capletVols, cs);
+
+            Size numberOfSteps = evolution.numberOfSteps();
+            Size numberOfRates = evolution.numberOfRates();
+            const std::vector<Time>& rateTimes = evolution.rateTimes();
+
+            QL_REQUIRE(corrPseudo.size()==numberOfSteps,
+                "mismatch between number of steps (" << numberOfSteps <<
+                ") and correlation pseudo-roots (" <<
+                corrPseudo.size() << ")");
+            QL_REQUIRE(invertedZedMatrix.rows()==numberOfRates &&
+                invertedZedMatrix.columns()==numberOfRates,
+                "inverted Z matrix must be " << numberOfRates <<
+                "x" << numberOfRates);
+            Size numberOfFactors = corrPseudo.front().columns();
+
+            Natural failures=0;
+
+            totalSwaptionError = 0.0;
+            deformationSize = 0.0;
+
             // vectors for the new vol of all swap rates
             std::vector<std::vector<Volatility> > newVols;
             std::vector<Volatility> theseNewVols(numberOfRates);
@@ -396,7 +427,7 @@ namespace QuantLib {
     }
 
     Natural CTSMMCapletMaxHomogeneityCalibration::calibrationImpl_(
-        Natural numberOfFactors, 
+        Natural, 
         Natural maxIterations,
         Real tolerance) {
 
@@ -406,11 +437,11 @@ namespace QuantLib {
                 // not mktCapletVols_ but...
                 usedCapletVols_,
                 *cs_, 
-                displacement_, 
 
                 caplet0Swaption1Priority_,
 
-                numberOfFactors,
+                corrPseudo_,
+                invertedZedMatrix_,
                 maxIterations,
                 tolerance,
 
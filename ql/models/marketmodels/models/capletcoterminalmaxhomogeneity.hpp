@@ -54,6 +54,23 @@ namespace QuantLib {
             Real& totalSwaptionError,                        // ?
             std::vector<Matrix>& swapCovariancePseudoRoots); // the thing we really want the pseudo
                                                              // root for each time step
+        /*! As above, with the factor reduction of the correlation
+            and the inverse of the Z matrix already computed.
+        */
+        static Natural capletMaxHomogeneityCalibration(
+            const EvolutionDescription& evolution,
+            const PiecewiseConstantCorrelation& corr,
+            const std::vector<ext::shared_ptr<PiecewiseConstantVariance> >& displacedSwapVariances,
+            const std::vector<Volatility>& capletVols,
+            const CurveState& cs,
+            Real caplet0Swaption1Priority,
+            const std::vector<Matrix>& corrPseudo,
+            const Matrix& invertedZedMatrix,
+            Size maxIterations,
+            Real tolerance,
+            Real& deformationSize,
+            Real& totalSwaptionError,
+            std::vector<Matrix>& swapCovariancePseudoRoots);
 
       private:
         Natural
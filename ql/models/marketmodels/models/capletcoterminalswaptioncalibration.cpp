@@ -68,13 +68,7 @@ namespace QuantLib {
 
                             std::vector<Matrix>& swapCovariancePseudoRoots) {
 
-        CTSMMCapletCalibration::performChecks(evolution, corr,
-            displacedSwapVariances, capletVols, cs);
-
-        Size numberOfSteps = evolution.numberOfSteps();
         Size numberOfRates = evolution.numberOfRates();
-        const std::vector<Time>& rateTimes = evolution.rateTimes();
-
         QL_REQUIRE(numberOfFactors<=numberOfRates,
                    "number of factors (" << numberOfFactors <<
                    ") cannot be greater than numberOfRates (" <<
@@ -83,21 +77,59 @@ namespace QuantLib {
                    "number of factors (" << numberOfFactors <<
                    ") must be greater than zero");
 
-        Natural failures = 0;
-        Real extraMultiplier = useFullAprox ? 1.0 : 0.0;
-
         // factor reduction
-        std::vector<Matrix> corrPseudo(corr.times().size());
-        for (Size i=0; i<corrPseudo.size(); ++i)
-            corrPseudo[i] = rankReducedSqrt(corr.correlation(i),
-                                            numberOfFactors, 1.0,
-                                            SalvagingAlgorithm::None);
+        std::vector<Matrix> corrPseudo =
+            CTSMMCapletCalibration::correlationPseudoRoots(corr,
+                                                           numberOfFactors);
 
         Matrix zedMatrix =
             SwapForwardMappings::coterminalSwapZedMatrix(cs, displacement);
         Matrix invertedZedMatrix = inverse(zedMatrix);
 
+        return calibrationFunction(evolution, corr, displacedSwapVariances,
+                                   capletVols, cs,
+                                   alpha, lowestRoot, useFullAprox,
+                                   corrPseudo, invertedZedMatrix,
+                                   swapCovariancePseudoRoots);
+    }
+
+    Natural CTSMMCapletOriginalCalibration::calibrationFunction(
+                            const EvolutionDescription& evolution,
+                            const PiecewiseConstantCorrelation& corr,
+                            const std::vector<ext::shared_ptr<
+                                PiecewiseConstantVariance> >&
+                                    displacedSwapVariances,
+                            const std::vector<Volatility>& capletVols,
+                            const CurveState& cs,
+
+                            const std::vector<Real>& alpha,
+                            bool lowestRoot,
+                            bool useFullAprox,
+
+                            const std::vector<Matrix>& corrPseudo,
+                            const Matrix& invertedZedMatrix,
+
+                            std::vector<Matrix>& swapCovariancePseudoRoots) {
+
+        CTSMMCapletCalibration::performChecks(evolution, corr,
+            displacedSwapVariances, capletVols, cs);
 
+        Size numberOfSteps = evolution.numberOfSteps();
+        Size numberOfRates = evolution.numberOfRates();
+        const std::vector<Time>& rateTimes = evolution.rateTimes();
+
+        QL_REQUIRE(corrPseudo.size()==numberOfSteps,
+                   "mismatch between number of steps (" << numberOfSteps <<
+                   ") and correlation pseudo-roots (" <<
+                   corrPseudo.size() << ")");
+        QL_REQUIRE(invertedZedMatrix.rows()==numberOfRates &&
+                   invertedZedMatrix.columns()==numberOfRates,
+                   "inverted Z matrix must be " << numberOfRates <<
+                   "x" << numberOfRates);
+        Size numberOfFactors = corrPseudo.front().columns();
+
+        Natural failures = 0;
+        Real extraMultiplier = useFullAprox ? 1.0 : 0.0;
 
         // do alpha part
         // first modify variances to take account of alpha
@@ -330,7 +362,7 @@ namespace QuantLib {
     }
 
     Natural CTSMMCapletOriginalCalibration::calibrationImpl_(
-                                Natural numberOfFactors,
+                                Natural,
                                 Natural ,
                                 Real ) {
 
@@ -340,13 +372,13 @@ namespace QuantLib {
                                    // not mktCapletVols_ but...
                                    usedCapletVols_,
                                    *cs_,
-                                   displacement_,
 
                                    alpha_,
                                    lowestRoot_,
                                    useFullApprox_,
 
-                                   numberOfFactors,
+                                   corrPseudo_,
+                                   invertedZedMatrix_,
 
                                    swapCovariancePseudoRoots_);
     }
@@ -21,12 +21,14 @@
 #include <ql/models/marketmodels/models/ctsmmcapletcalibration.hpp>
 #include <ql/models/marketmodels/models/piecewiseconstantvariance.hpp>
 #include <ql/models/marketmodels/models/pseudorootfacade.hpp>
-#include <ql/models/marketmodels/models/cotswaptofwdadapter.hpp>
 #include <ql/models/marketmodels/swapforwardmappings.hpp>
 #include <ql/models/marketmodels/marketmodel.hpp>
 #include <ql/math/matrixutilities/pseudosqrt.hpp>
 #include <ql/math/comparison.hpp>
 #include <ql/utilities/dataformatters.hpp>
+#include <algorithm>
+#include <chrono>
+#include <exception>
 
 namespace QuantLib {
 
@@ -48,7 +50,8 @@ namespace QuantLib {
       mktSwaptionVols_(evolution_.numberOfRates()),
       mdlSwaptionVols_(evolution_.numberOfRates()),
       cs_(cs), displacement_(displacement),
-      numberOfRates_(evolution_.numberOfRates())
+      numberOfRates_(evolution_.numberOfRates()),
+      factorReductionTime_(0.0), solvingTime_(0.0), fitCheckTime_(0.0)
     {
         performChecks(evolution_, *corr_, displacedSwapVariances_,
                       mktCapletVols_, *cs_);
@@ -128,6 +131,28 @@ namespace QuantLib {
                    lastSwaptionVol-mktCapletVols[numberOfRates-1]);
     }
 
+    std::vector<Matrix> CTSMMCapletCalibration::correlationPseudoRoots(
+                                    const PiecewiseConstantCorrelation& corr,
+                                    Size numberOfFactors) {
+        const Size n = corr.times().size();
+        std::vector<Matrix> corrPseudo(n);
+        std::vector<std::exception_ptr> errors(n);
+        #pragma omp parallel for
+        for (long i=0; i<long(n); ++i) {
+            try {
+                corrPseudo[i] = rankReducedSqrt(corr.correlation(i),
+                                                numberOfFactors, 1.0,
+                                                SalvagingAlgorithm::None);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+        for (Size i=0; i<n; ++i)
+            if (errors[i])
+                std::rethrow_exception(errors[i]);
+        return corrPseudo;
+    }
+
     bool CTSMMCapletCalibration::calibrate(Natural numberOfFactors,
 
                                            Natural maxIterations,
@@ -135,12 +160,23 @@ namespace QuantLib {
 
                                            Natural innerSolvingMaxIterations,
                                            Real innerSolvingTolerance) {
+        typedef std::chrono::steady_clock clock;
+
         // initialize results
         calibrated_ = false;
         failures_ = 987654321; // a positive large number
         deformationSize_ = 987654321;
         capletRmsError_ = swaptionRmsError_ = 987654321;
         capletMaxError_ = swaptionMaxError_ = 987654321;
+        factorReductionTime_ = solvingTime_ = fitCheckTime_ = 0.0;
+
+        QL_REQUIRE(numberOfFactors<=numberOfRates_,
+                   "number of factors (" << numberOfFactors <<
+                   ") cannot be greater than numberOfRates (" <<
+                   numberOfRates_ << ")");
+        QL_REQUIRE(numberOfFactors>0,
+                   "number of factors (" << numberOfFactors <<
+                   ") must be greater than zero");
 
         // initialize working variables
         usedCapletVols_ = mktCapletVols_;
@@ -151,37 +187,77 @@ namespace QuantLib {
         std::vector<Spread> displacements(numberOfRates_,
                                           displacement_);
         const std::vector<Time>& rateTimes = evolution_.rateTimes();
+        const std::vector<Size>& alive = evolution_.firstAliveRate();
+        Size numberOfSteps = evolution_.numberOfSteps();
         Natural iterations = 0;
 
+        // neither the factor reduction nor the Z matrix depend on
+        // the caplet vols being fitted
+        clock::time_point start = clock::now();
+        corrPseudo_ = correlationPseudoRoots(*corr_, numberOfFactors);
+        invertedZedMatrix_ = inverse(
+            SwapForwardMappings::coterminalSwapZedMatrix(*cs_,
+                                                         displacement_));
+        factorReductionTime_ =
+            std::chrono::duration<Real>(clock::now() - start).count();
+
+        // model variances of swap rates (first half of each row)
+        // and forward rates (second half) contributed by each step
+        Matrix stepVariances(numberOfSteps, 2*numberOfRates_);
+
         // calibration loop
         do {
+            start = clock::now();
             failures_ = calibrationImpl_(numberOfFactors,
                                          innerSolvingMaxIterations,
                                          innerSolvingTolerance);
-
-            ext::shared_ptr<MarketModel> ctsmm(new
-                PseudoRootFacade(swapCovariancePseudoRoots_,
-                                 rateTimes,
-                                 cs_->coterminalSwapRates(),
-                                 displacements));
-            const Matrix& swaptionTotCovariance =
-                ctsmm->totalCovariance(numberOfRates_-1);
-
-            CotSwapToFwdAdapter flmm(ctsmm);
-            const Matrix& capletTotCovariance =
-                flmm.totalCovariance(numberOfRates_-1);
+            clock::time_point end = clock::now();
+            solvingTime_ += std::chrono::duration<Real>(end - start).count();
+            start = end;
+
+            // swap-rate and forward-rate variances; the forward-rate
+            // pseudo-roots are obtained as in CotSwapToFwdAdapter,
+            // but only their diagonal covariances are needed
+            #pragma omp parallel for
+            for (long k=0; k<long(numberOfSteps); ++k) {
+                const Matrix& pseudo = swapCovariancePseudoRoots_[k];
+                for (Size i=0; i<numberOfRates_; ++i) {
+                    Real swapVariance = 0.0;
+                    for (Size f=0; f<numberOfFactors; ++f)
+                        swapVariance += pseudo[i][f]*pseudo[i][f];
+                    stepVariances[k][i] = swapVariance;
+
+                    Real fwdVariance = 0.0;
+                    if (i >= alive[k]) {
+                        for (Size f=0; f<numberOfFactors; ++f) {
+                            Real fwdPseudo = 0.0;
+                            for (Size j=0; j<numberOfRates_; ++j)
+                                fwdPseudo +=
+                                    invertedZedMatrix_[i][j]*pseudo[j][f];
+                            fwdVariance += fwdPseudo*fwdPseudo;
+                        }
+                    }
+                    stepVariances[k][numberOfRates_+i] = fwdVariance;
+                }
+            }
 
             // check fit
             capletRmsError_ = swaptionRmsError_ = 0.0;
             capletMaxError_ = swaptionMaxError_ = -1.0;
 
             for (Size i=0; i<numberOfRates_; ++i) {
-                mdlSwaptionVols_[i] = std::sqrt(swaptionTotCovariance[i][i]/rateTimes[i]);
+                Real swaptionVariance = 0.0, capletVariance = 0.0;
+                for (Size k=0; k<numberOfSteps; ++k) {
+                    swaptionVariance += stepVariances[k][i];
+                    capletVariance += stepVariances[k][numberOfRates_+i];
+                }
+
+                mdlSwaptionVols_[i] = std::sqrt(swaptionVariance/rateTimes[i]);
                 Real swaptionError = std::fabs(mktSwaptionVols_[i]-mdlSwaptionVols_[i]);
                 swaptionRmsError_ += swaptionError*swaptionError;
                 swaptionMaxError_ = std::max(swaptionMaxError_, swaptionError);
 
-                mdlCapletVols_[i] = std::sqrt(capletTotCovariance[i][i]/rateTimes[i]);
+                mdlCapletVols_[i] = std::sqrt(capletVariance/rateTimes[i]);
                 Real capletError = std::fabs(mktCapletVols_[i]-mdlCapletVols_[i]);
                 capletRmsError_ += capletError*capletError;
                 capletMaxError_ = std::max(capletMaxError_, capletError);
@@ -192,6 +268,8 @@ namespace QuantLib {
             swaptionRmsError_ = std::sqrt(swaptionRmsError_/numberOfRates_);
             capletRmsError_ = std::sqrt(capletRmsError_/numberOfRates_);
             ++iterations;
+            fitCheckTime_ +=
+                std::chrono::duration<Real>(clock::now() - start).count();
         } while (iterations<maxIterations &&
                  capletRmsError_>capletVolTolerance);
 
@@ -211,4 +289,39 @@ namespace QuantLib {
         return failures_==0;
     }
 
+    bool CTSMMCapletCalibration::calibrateAll(
+            const std::vector<ext::shared_ptr<CTSMMCapletCalibration> >&
+                                                            calibrations,
+            Natural numberOfFactors,
+            Natural maxIterations,
+            Real tolerance,
+            Natural innerMaxIterations,
+            Real innerTolerance) {
+        const Size n = calibrations.size();
+        for (Size i=0; i<n; ++i)
+            QL_REQUIRE(calibrations[i],
+                       "null " << io::ordinal(i+1) << " calibration");
+        // not std::vector<bool>, whose elements can't be written
+        // concurrently
+        std::vector<char> successes(n);
+        std::vector<std::exception_ptr> errors(n);
+        #pragma omp parallel for schedule(dynamic)
+        for (long i=0; i<long(n); ++i) {
+            try {
+                successes[i] = calibrations[i]->calibrate(numberOfFactors,
+                                                          maxIterations,
+                                                          tolerance,
+                                                          innerMaxIterations,
+                                                          innerTolerance);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+        for (Size i=0; i<n; ++i)
+            if (errors[i])
+                std::rethrow_exception(errors[i]);
+        return std::find(successes.begin(), successes.end(), char(0))
+            == successes.end();
+    }
+
 }
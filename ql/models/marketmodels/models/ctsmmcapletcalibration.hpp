@@ -24,13 +24,13 @@
 #include <ql/models/marketmodels/curvestate.hpp>
 #include <ql/models/marketmodels/evolutiondescription.hpp>
 #include <ql/models/marketmodels/piecewiseconstantcorrelation.hpp>
+#include <ql/math/matrix.hpp>
 #include <ql/shared_ptr.hpp>
 #include <vector>
 
 namespace QuantLib {
 
     class PiecewiseConstantVariance;
-    class Matrix;
 
     class CTSMMCapletCalibration {
       public:
@@ -52,6 +52,21 @@ namespace QuantLib {
 
                        Natural innerMaxIterations = 100,
                        Real innerTolerance = 1e-8);
+        //! calibrates several independent models concurrently
+        /*! This can be used, e.g., to recalibrate the models for
+            different currencies.  Returns true if all calibrations
+            succeeded; the results are available from each model.
+        */
+        static bool calibrateAll(
+            const std::vector<ext::shared_ptr<CTSMMCapletCalibration> >&
+                                                            calibrations,
+            Natural numberOfFactors,
+
+            Natural maxIterations,
+            Real tolerance,
+
+            Natural innerMaxIterations = 100,
+            Real innerTolerance = 1e-8);
         // inspectors
         Natural failures() const;
         Real deformationSize() const;
@@ -71,6 +86,21 @@ namespace QuantLib {
         const std::vector<Volatility>& timeDependentCalibratedSwaptionVols(Size i) const;
         const std::vector<Volatility>& timeDependentUnCalibratedSwaptionVols(Size i) const;
 
+        //! \name Timings
+        /*! Wall-clock times, in seconds, spent in each stage of the
+            last calibration.
+        */
+        //@{
+        Real factorReductionTime() const;
+        Real solvingTime() const;
+        Real fitCheckTime() const;
+        //@}
+
+        //! rank-reduced pseudo-roots of the correlation at each step
+        /*! The steps are processed in parallel if OpenMP is enabled. */
+        static std::vector<Matrix> correlationPseudoRoots(
+            const PiecewiseConstantCorrelation& corr,
+            Size numberOfFactors);
 
         static void performChecks(
             const EvolutionDescription& evolution,
@@ -110,6 +140,13 @@ namespace QuantLib {
         Real capletRmsError_, capletMaxError_;
         Real swaptionRmsError_, swaptionMaxError_;
         std::vector<Matrix> swapCovariancePseudoRoots_;
+        // factor reduction and inverse of the Z matrix; they do not
+        // change across iterations, so they are computed only once
+        // for each calibration and used by calibrationImpl_
+        std::vector<Matrix> corrPseudo_;
+        Matrix invertedZedMatrix_;
+        // timings
+        Real factorReductionTime_, solvingTime_, fitCheckTime_;
     };
 
     // inline
@@ -166,6 +203,18 @@ namespace QuantLib {
         return swaptionMaxError_;
     }
 
+    inline Real CTSMMCapletCalibration::factorReductionTime() const {
+        return factorReductionTime_;
+    }
+
+    inline Real CTSMMCapletCalibration::solvingTime() const {
+        return solvingTime_;
+    }
+
+    inline Real CTSMMCapletCalibration::fitCheckTime() const {
+        return fitCheckTime_;
+    }
+
     inline const std::vector<Matrix>&
     CTSMMCapletCalibration::swapPseudoRoots() const {
         QL_REQUIRE(calibrated_, "not successfully calibrated yet");
@@ -0,0 +1,252 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <ql/models/marketmodels/parallelaccountingengine.hpp>
+#include <ql/models/marketmodels/evolvers/lognormalfwdrateeuler.hpp>
+#include <algorithm>
+#include <exception>
+
+namespace QuantLib {
+
+    namespace {
+
+        // keeps the generator it creates, so that the engine can
+        // position it at the first path of the next batch
+        class RecordingBrownianGeneratorFactory
+            : public BrownianGeneratorFactory {
+          public:
+            explicit RecordingBrownianGeneratorFactory(
+                                     const BrownianGeneratorFactory& factory)
+            : factory_(factory) {}
+            ext::shared_ptr<BrownianGenerator> create(
+                                     Size factors, Size steps) const override {
+                generator_ = factory_.create(factors, steps);
+                return generator_;
+            }
+            const ext::shared_ptr<BrownianGenerator>& generator() const {
+                return generator_;
+            }
+          private:
+            const BrownianGeneratorFactory& factory_;
+            mutable ext::shared_ptr<BrownianGenerator> generator_;
+        };
+
+        class AccountingEngineBuilder {
+          public:
+            AccountingEngineBuilder(
+                           const MarketModelEvolverFactory& evolverFactory,
+                           const Clone<MarketModelMultiProduct>& product,
+                           Real initialNumeraireValue)
+            : evolverFactory_(evolverFactory), product_(product),
+              initialNumeraireValue_(initialNumeraireValue) {}
+            ext::shared_ptr<AccountingEngine> operator()(
+                            const BrownianGeneratorFactory& factory) const {
+                return ext::make_shared<AccountingEngine>(
+                    evolverFactory_.create(factory, 0), product_,
+                    initialNumeraireValue_);
+            }
+          private:
+            const MarketModelEvolverFactory& evolverFactory_;
+            const Clone<MarketModelMultiProduct>& product_;
+            Real initialNumeraireValue_;
+        };
+
+        class PathwiseAccountingEngineBuilder {
+          public:
+            PathwiseAccountingEngineBuilder(
+                     const ext::shared_ptr<MarketModel>& marketModel,
+                     const std::vector<Size>& numeraires,
+                     const Clone<MarketModelPathwiseMultiProduct>& product,
+                     const ext::shared_ptr<MarketModel>& pseudoRootStructure,
+                     Real initialNumeraireValue)
+            : marketModel_(marketModel), numeraires_(numeraires),
+              product_(product), pseudoRootStructure_(pseudoRootStructure),
+              initialNumeraireValue_(initialNumeraireValue) {}
+            ext::shared_ptr<PathwiseAccountingEngine> operator()(
+                            const BrownianGeneratorFactory& factory) const {
+                ext::shared_ptr<LogNormalFwdRateEuler> evolver =
+                    ext::make_shared<LogNormalFwdRateEuler>(
+                                         marketModel_, factory, numeraires_);
+                return ext::make_shared<PathwiseAccountingEngine>(
+                    evolver, product_, pseudoRootStructure_,
+                    initialNumeraireValue_);
+            }
+          private:
+            const ext::shared_ptr<MarketModel>& marketModel_;
+            const std::vector<Size>& numeraires_;
+            const Clone<MarketModelPathwiseMultiProduct>& product_;
+            const ext::shared_ptr<MarketModel>& pseudoRootStructure_;
+            Real initialNumeraireValue_;
+        };
+
+        /* Batch k of each round is simulated by the k-th engine,
+           whose generator is moved forward to the first path of the
+           batch; the engines are created when first needed. */
+        template <class Engine, class EngineBuilder>
+        void simulateBatches(
+                const EngineBuilder& build,
+                const BrownianGeneratorFactory& generatorFactory,
+                std::vector<ext::shared_ptr<BrownianGenerator> >& generators,
+                std::vector<ext::shared_ptr<Engine> >& engines,
+                std::vector<Size>& nextPaths,
+                Size pathsPerBatch,
+                Size valueSize,
+                Size& pathsDrawn,
+                SequenceStatisticsInc& stats,
+                Size numberOfPaths) {
+
+            const Size lanes = engines.size();
+            std::vector<std::vector<Real> > values(lanes), weights(lanes);
+            std::vector<std::exception_ptr> errors(lanes);
+
+            const Size lastPath = pathsDrawn + numberOfPaths;
+            while (pathsDrawn < lastPath) {
+                const Size batches =
+                    std::min(lanes, (lastPath - pathsDrawn + pathsPerBatch - 1)
+                                    / pathsPerBatch);
+
+                #pragma omp parallel for
+                for (long k=0; k<long(batches); ++k) {
+                    try {
+                        const Size firstPath = pathsDrawn + k*pathsPerBatch;
+                        const Size paths =
+                            std::min(pathsPerBatch, lastPath - firstPath);
+                        if (!engines[k]) {
+                            RecordingBrownianGeneratorFactory factory(
+                                                           generatorFactory);
+                            engines[k] = build(factory);
+                            generators[k] = factory.generator();
+                            QL_REQUIRE(generators[k],
+                                       "no Brownian generator created");
+                            nextPaths[k] = 0;
+                        }
+                        generators[k]->skipPaths(firstPath - nextPaths[k]);
+
+                        values[k].resize(paths*valueSize);
+                        weights[k].resize(paths);
+                        std::vector<Real> pathValues(valueSize);
+                        for (Size i=0; i<paths; ++i) {
+                            weights[k][i] =
+                                engines[k]->singlePathValues(pathValues);
+                            std::copy(pathValues.begin(), pathValues.end(),
+                                      values[k].begin() + i*valueSize);
+                        }
+                        nextPaths[k] = firstPath + paths;
+                    } catch (...) {
+                        errors[k] = std::current_exception();
+                    }
+                }
+
+                for (Size k=0; k<batches; ++k) {
+                    if (errors[k]) {
+                        // the engines are no longer in a known state
+                        std::fill(engines.begin(), engines.end(),
+                                  ext::shared_ptr<Engine>());
+                        std::rethrow_exception(errors[k]);
+                    }
+                }
+
+                for (Size k=0; k<batches; ++k) {
+                    for (Size i=0; i<weights[k].size(); ++i)
+                        stats.add(values[k].begin() + i*valueSize,
+                                  values[k].begin() + (i+1)*valueSize,
+                                  weights[k][i]);
+                }
+                pathsDrawn = std::min(lastPath,
+                                      pathsDrawn + batches*pathsPerBatch);
+            }
+        }
+
+    }
+
+
+    ParallelAccountingEngine::ParallelAccountingEngine(
+                    ext::shared_ptr<MarketModelEvolverFactory> evolverFactory,
+                    ext::shared_ptr<BrownianGeneratorFactory> generatorFactory,
+                    const Clone<MarketModelMultiProduct>& product,
+                    Real initialNumeraireValue,
+                    Size pathsPerBatch,
+                    Size concurrentBatches)
+    : evolverFactory_(std::move(evolverFactory)),
+      generatorFactory_(std::move(generatorFactory)), product_(product),
+      initialNumeraireValue_(initialNumeraireValue),
+      pathsPerBatch_(pathsPerBatch), pathsDrawn_(0),
+      generators_(concurrentBatches), engines_(concurrentBatches),
+      nextPaths_(concurrentBatches, 0) {
+        QL_REQUIRE(evolverFactory_, "no evolver factory given");
+        QL_REQUIRE(generatorFactory_, "no generator factory given");
+        QL_REQUIRE(pathsPerBatch_ > 0, "paths per batch must be positive");
+        QL_REQUIRE(concurrentBatches > 0,
+                   "number of concurrent batches must be positive");
+    }
+
+    void ParallelAccountingEngine::multiplePathValues(
+                                                SequenceStatisticsInc& stats,
+                                                Size numberOfPaths) {
+        AccountingEngineBuilder build(*evolverFactory_, product_,
+                                      initialNumeraireValue_);
+        simulateBatches(build, *generatorFactory_, generators_, engines_,
+                        nextPaths_, pathsPerBatch_,
+                        product_->numberOfProducts(), pathsDrawn_,
+                        stats, numberOfPaths);
+    }
+
+
+    ParallelPathwiseAccountingEngine::ParallelPathwiseAccountingEngine(
+                    ext::shared_ptr<MarketModel> marketModel,
+                    ext::shared_ptr<BrownianGeneratorFactory> generatorFactory,
+                    std::vector<Size> numeraires,
+                    const Clone<MarketModelPathwiseMultiProduct>& product,
+                    ext::shared_ptr<MarketModel> pseudoRootStructure,
+                    Real initialNumeraireValue,
+                    Size pathsPerBatch,
+                    Size concurrentBatches)
+    : marketModel_(std::move(marketModel)),
+      generatorFactory_(std::move(generatorFactory)),
+      numeraires_(std::move(numeraires)), product_(product),
+      pseudoRootStructure_(std::move(pseudoRootStructure)),
+      initialNumeraireValue_(initialNumeraireValue),
+      pathsPerBatch_(pathsPerBatch), pathsDrawn_(0),
+      generators_(concurrentBatches), engines_(concurrentBatches),
+      nextPaths_(concurrentBatches, 0) {
+        QL_REQUIRE(marketModel_, "no market model given");
+        QL_REQUIRE(generatorFactory_, "no generator factory given");
+        QL_REQUIRE(pseudoRootStructure_, "no pseudo-root structure given");
+        QL_REQUIRE(pathsPerBatch_ > 0, "paths per batch must be positive");
+        QL_REQUIRE(concurrentBatches > 0,
+                   "number of concurrent batches must be positive");
+        // calculate the cached covariances before evolvers are
+        // created concurrently
+        marketModel_->totalCovariance(marketModel_->numberOfSteps()-1);
+        pseudoRootStructure_->totalCovariance(
+                                 pseudoRootStructure_->numberOfSteps()-1);
+    }
+
+    void ParallelPathwiseAccountingEngine::multiplePathValues(
+                                                SequenceStatisticsInc& stats,
+                                                Size numberOfPaths) {
+        PathwiseAccountingEngineBuilder build(marketModel_, numeraires_,
+                                              product_, pseudoRootStructure_,
+                                              initialNumeraireValue_);
+        const Size valueSize = product_->numberOfProducts()
+                             * (pseudoRootStructure_->numberOfRates()+1);
+        simulateBatches(build, *generatorFactory_, generators_, engines_,
+                        nextPaths_, pathsPerBatch_, valueSize, pathsDrawn_,
+                        stats, numberOfPaths);
+    }
+
+}
@@ -0,0 +1,154 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file parallelaccountingengine.hpp
+    \brief Accounting engines simulating batches of paths in parallel
+*/
+
+#ifndef quantlib_parallel_accounting_engine_hpp
+#define quantlib_parallel_accounting_engine_hpp
+
+#include <ql/models/marketmodels/accountingengine.hpp>
+#include <ql/models/marketmodels/pathwiseaccountingengine.hpp>
+#include <ql/models/marketmodels/browniangenerator.hpp>
+#include <ql/models/marketmodels/marketmodel.hpp>
+
+namespace QuantLib {
+
+    class MarketModelEvolver;
+
+    //! base class for market-model evolver factories
+    class MarketModelEvolverFactory {
+      public:
+        virtual ~MarketModelEvolverFactory() {}
+        virtual ext::shared_ptr<MarketModelEvolver> create(
+                                   const BrownianGeneratorFactory& factory,
+                                   Size initialStep) const = 0;
+    };
+
+    //! factory for evolvers built from a market model and numeraires
+    /*! The evolver class must provide a constructor taking the
+        market model, the Brownian-generator factory, the numeraires
+        and the initial step, as LogNormalFwdRateEuler does.
+
+        The covariances cached by the market model are calculated on
+        construction, so that the evolvers can be created
+        concurrently afterwards.
+    */
+    template <class Evolver>
+    class StandardMarketModelEvolverFactory
+        : public MarketModelEvolverFactory {
+      public:
+        StandardMarketModelEvolverFactory(
+                                ext::shared_ptr<MarketModel> marketModel,
+                                std::vector<Size> numeraires)
+        : marketModel_(std::move(marketModel)),
+          numeraires_(std::move(numeraires)) {
+            marketModel_->totalCovariance(marketModel_->numberOfSteps()-1);
+        }
+        ext::shared_ptr<MarketModelEvolver> create(
+                                   const BrownianGeneratorFactory& factory,
+                                   Size initialStep) const override {
+            return ext::shared_ptr<MarketModelEvolver>(
+                new Evolver(marketModel_, factory, numeraires_, initialStep));
+        }
+      private:
+        ext::shared_ptr<MarketModel> marketModel_;
+        std::vector<Size> numeraires_;
+    };
+
+
+    //! Accounting engine simulating batches of paths in parallel
+    /*! The paths are split in batches of fixed size; each batch is
+        simulated by its own evolver, product and discounters, which
+        are created by the engine and reused in later batches.  The
+        Brownian generators are positioned at the first path of their
+        batch by means of BrownianGenerator::skipPaths, so that the
+        collected statistics are the same as the ones obtained by an
+        AccountingEngine whose evolver uses a generator from the same
+        factory, independently of the number of threads.  The values
+        of each path are added to the statistics in path order.
+
+        Up to concurrentBatches batches are simulated in parallel
+        when OpenMP is enabled; the values of their paths are stored
+        until they are added to the statistics.
+
+        \warning The product clones, the evolvers and the generators
+                 must not share mutable state.
+    */
+    class ParallelAccountingEngine {
+      public:
+        ParallelAccountingEngine(
+                    ext::shared_ptr<MarketModelEvolverFactory> evolverFactory,
+                    ext::shared_ptr<BrownianGeneratorFactory> generatorFactory,
+                    const Clone<MarketModelMultiProduct>& product,
+                    Real initialNumeraireValue,
+                    Size pathsPerBatch = 1024,
+                    Size concurrentBatches = 16);
+        void multiplePathValues(SequenceStatisticsInc& stats,
+                                Size numberOfPaths);
+      private:
+        ext::shared_ptr<MarketModelEvolverFactory> evolverFactory_;
+        ext::shared_ptr<BrownianGeneratorFactory> generatorFactory_;
+        Clone<MarketModelMultiProduct> product_;
+        Real initialNumeraireValue_;
+        Size pathsPerBatch_;
+        Size pathsDrawn_;
+        std::vector<ext::shared_ptr<BrownianGenerator> > generators_;
+        std::vector<ext::shared_ptr<AccountingEngine> > engines_;
+        std::vector<Size> nextPaths_;
+    };
+
+
+    //! Pathwise accounting engine simulating batches of paths in parallel
+    /*! Batches are simulated as in ParallelAccountingEngine; each
+        of them uses a LogNormalFwdRateEuler evolver on the given
+        market model.  The collected statistics are the same as the
+        ones obtained by a PathwiseAccountingEngine whose evolver
+        uses a generator from the same factory.
+    */
+    class ParallelPathwiseAccountingEngine {
+      public:
+        ParallelPathwiseAccountingEngine(
+                    ext::shared_ptr<MarketModel> marketModel,
+                    ext::shared_ptr<BrownianGeneratorFactory> generatorFactory,
+                    std::vector<Size> numeraires,
+                    const Clone<MarketModelPathwiseMultiProduct>& product,
+                    ext::shared_ptr<MarketModel> pseudoRootStructure,
+                    Real initialNumeraireValue,
+                    Size pathsPerBatch = 1024,
+                    Size concurrentBatches = 16);
+        void multiplePathValues(SequenceStatisticsInc& stats,
+                                Size numberOfPaths);
+      private:
+        ext::shared_ptr<MarketModel> marketModel_;
+        ext::shared_ptr<BrownianGeneratorFactory> generatorFactory_;
+        std::vector<Size> numeraires_;
+        Clone<MarketModelPathwiseMultiProduct> product_;
+        ext::shared_ptr<MarketModel> pseudoRootStructure_;
+        Real initialNumeraireValue_;
+        Size pathsPerBatch_;
+        Size pathsDrawn_;
+        std::vector<ext::shared_ptr<BrownianGenerator> > generators_;
+        std::vector<ext::shared_ptr<PathwiseAccountingEngine> > engines_;
+        std::vector<Size> nextPaths_;
+    };
+
+}
+
+
+#endif
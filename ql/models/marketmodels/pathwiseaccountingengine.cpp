@@ -23,6 +23,7 @@ FOR A PARTICULAR PURPOSE.  See the license for more details.
 #include <ql/models/marketmodels/evolutiondescription.hpp>
 #include <ql/models/marketmodels/curvestate.hpp>
 #include <ql/models/marketmodels/marketmodel.hpp>
+#include <ql/math/functional.hpp>
 #include <algorithm>
 
 namespace QuantLib {
@@ -716,77 +717,42 @@ namespace QuantLib {
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     
-    PathwiseVegasOuterAccountingEngine::PathwiseVegasOuterAccountingEngine(
+    PathwiseVegasAccountingEngineBase::PathwiseVegasAccountingEngineBase(
         const ext::shared_ptr<LogNormalFwdRateEuler>& evolver, // method relies heavily on LMM Euler
         const Clone<MarketModelPathwiseMultiProduct>& product,
         const ext::shared_ptr<MarketModel>& pseudoRootStructure, // we need pseudo-roots and displacements
         const std::vector<std::vector<Matrix> >& vegaBumps,
         Real initialNumeraireValue)
-        : evolver_(evolver), 
+        : evolver_(evolver),
         product_(product),
         pseudoRootStructure_(pseudoRootStructure),
         vegaBumps_(vegaBumps),
         initialNumeraireValue_(initialNumeraireValue),
         numberProducts_(product->numberOfProducts()),
+        numberRates_(pseudoRootStructure->numberOfRates()),
+        numberSteps_(pseudoRootStructure->numberOfSteps()),
+        factors_(pseudoRootStructure->numberOfFactors()),
         doDeflation_(!product->alreadyDeflated()),
         numerairesHeld_(product->numberOfProducts()),
         numberCashFlowsThisStep_(product->numberOfProducts()),
         cashFlowsGenerated_(product->numberOfProducts()),
-        stepsDiscounts_(pseudoRootStructure_->numberOfRates()+1),
-        elementary_vegas_ThisPath_(product->numberOfProducts()),
-        deflatorAndDerivatives_(pseudoRootStructure_->numberOfRates()+1)
+        deflatorAndDerivatives_(pseudoRootStructure->numberOfRates()+1)
     {
-
-        stepsDiscounts_[0]=1.0;
-
-        numberRates_ = pseudoRootStructure_->numberOfRates();
-        numberSteps_ = pseudoRootStructure_->numberOfSteps();
-        factors_ = pseudoRootStructure_->numberOfFactors();
-        fullDerivatives_.resize(numberRates_);
-
-
-        const EvolutionDescription& evolution = pseudoRootStructure_->evolution();
-        numeraires_ =  moneyMarketMeasure(evolution);
-
-
         QL_REQUIRE(vegaBumps.size() == numberSteps_, "we need precisely one vector of vega bumps for each step.");
 
         numberBumps_ = vegaBumps[0].size();
 
-       std::vector<Matrix> jacobiansThisPathsModel;
-       for (Size i =0; i < numberRates_; ++i)
-              jacobiansThisPathsModel.push_back(Matrix(numberRates_,factors_));
-
-
-
-        for (Size i =0; i < numberSteps_; ++i)
-        {
-              jacobianComputers_.push_back(RatePseudoRootJacobianAllElements(pseudoRootStructure_->pseudoRoot(i),evolution.firstAliveRate()[i],
-                                numeraires_[i],
-                                evolution.rateTaus(),
-                                pseudoRootStructure_->displacements()));
-
-              // vector of vector of matrices to store jacobians of rates with respect to pseudo-root elements
-            jacobiansThisPaths_.push_back(jacobiansThisPathsModel);
-        }
-
-
-
         Matrix VModel(numberSteps_+1,numberRates_);
 
-
-
         Discounts_ = Matrix(numberSteps_+1,numberRates_+1);
 
         for (Size i=0; i <= numberSteps_; ++i)
             Discounts_[i][0] = 1.0;
 
-
         V_.reserve(numberProducts_);
 
         Matrix  modelCashFlowIndex(product_->possibleCashFlowTimes().size(), numberRates_+1);
 
-
         numberCashFlowsThisIndex_.resize(numberProducts_);
 
         for (Size i=0; i<numberProducts_; ++i)
@@ -801,16 +767,10 @@ namespace QuantLib {
 
             V_.push_back(VModel);
 
-
             totalCashFlowsThisIndex_.push_back(modelCashFlowIndex);
         }
 
-        LIBORRatios_ = VModel;
-        StepsDiscountsSquared_ = VModel;
-        LIBORRates_ =VModel;
-
-
-
+        LIBORRates_ = VModel;
 
         const std::vector<Time>& cashFlowTimes =
             product_->possibleCashFlowTimes();
@@ -824,10 +784,6 @@ namespace QuantLib {
             discounters_.push_back(MarketModelPathwiseDiscounter(cashFlowTimes[j],
             rateTimes));
 
-
-        // need to check that we are in money market measure
-
-
         // we need to allocate cash-flow times to steps, i.e. what is the last step completed before a flow occurs
         // what we really need is for each step, what cash flow time indices to look at
 
@@ -843,40 +799,16 @@ namespace QuantLib {
             cashFlowIndicesThisStep_[index].push_back(i);
         }
 
-        partials_ = Matrix(pseudoRootStructure_->numberOfFactors(),numberRates_);
-
-//      set up this container object        
-//        std::vector<std::vector<std::vector<Matrix> >  > elementary_vegas_ThisPath_;  // dimensions are product, step, rate, rate and factor
-
-        { // force destruction of modelVegaMatrix as soon as no longer needed 
-            Matrix modelVegaMatrix(numberRates_, factors_,0.0);
-
-            for (Size i=0; i < numberProducts_; ++i)
-            {  
-                elementary_vegas_ThisPath_[i].resize(numberSteps_);
-                for (Size j=0; j < numberSteps_; ++j)
-                {
-                   
-                        elementary_vegas_ThisPath_[i][j]= modelVegaMatrix;
-                }
-            }
-        } // modelVegaMatrix destroyed here 
+        partials_ = Matrix(factors_,numberRates_);
 
         numberElementaryVegas_ = numberSteps_*numberRates_*factors_;
-/*
-        gaussians_.resize(numberSteps_);
-        distinguishedFactor_=0;
-        distinguishedRate_=0;
-        distinguishedStep_=0;
-*/
+
+        elementaryVegas_.resize(numberProducts_,
+                                Matrix(numberSteps_, numberRates_*factors_));
     }
 
-    Real PathwiseVegasOuterAccountingEngine::singlePathValues(std::vector<Real>& values)
+    void PathwiseVegasAccountingEngineBase::resetAccumulators()
     {
-
-        const std::vector<Real>& initialForwards_(pseudoRootStructure_->initialRates());
-        currentForwards_ = initialForwards_;
-        // clear accumulation variables
         for (Size i=0; i < numberProducts_; ++i)
         {
             numerairesHeld_[i]=0.0;
@@ -893,9 +825,216 @@ namespace QuantLib {
                 for (Size m=0; m <= numberSteps_; ++m)
                     V_[i][m][l] =0.0;
 
+            std::fill(elementaryVegas_[i].begin(), elementaryVegas_[i].end(), 0.0);
+        }
+    }
+
+    void PathwiseVegasAccountingEngineBase::accumulateCashFlows(Real weight)
+    {
+        // for each product...
+        for (Size i=0; i<numberProducts_; ++i)
+        {
+            // ...and each cash flow...
+            for (Size j=0; j<numberCashFlowsThisStep_[i]; ++j)
+            {
+                Size k = cashFlowsGenerated_[i][j].timeIndex;
+                ++numberCashFlowsThisIndex_[i][ k];
+
+                for (Size l=0; l <= numberRates_; ++l)
+                    totalCashFlowsThisIndex_[i][k][l] += cashFlowsGenerated_[i][j].amount[l]*weight;
+            }
+        }
+    }
+
+    bool PathwiseVegasAccountingEngineBase::deflateCashFlows(Size currentStep, Size stepToUse)
+    {
+        bool flowsFound = false;
+
+        for (Size k=0; k < cashFlowIndicesThisStep_[currentStep].size(); ++k)
+        {
+            Size cashFlowIndex =cashFlowIndicesThisStep_[currentStep][k];
+
+            // first check to see if anything actually happened before spending time on computing stuff
+            bool noFlows = true;
+            for (Size l=0; l < numberProducts_ && noFlows; ++l)
+                noFlows = noFlows && (numberCashFlowsThisIndex_[l][cashFlowIndex] ==0);
+
+            flowsFound = flowsFound || !noFlows;
+
+            if (!noFlows)
+            {
+                if (doDeflation_)
+                    discounters_[cashFlowIndex].getFactors(LIBORRates_, Discounts_,stepToUse, deflatorAndDerivatives_); // get amount to discount cash flow by and amount to multiply its derivatives by
+
+                for (Size j=0; j < numberProducts_; ++j)
+                {
+                    if (numberCashFlowsThisIndex_[j][cashFlowIndex] > 0)
+                    {
+                        Real deflatedCashFlow = totalCashFlowsThisIndex_[j][cashFlowIndex][0];
+                        if (doDeflation_)
+                            deflatedCashFlow *= deflatorAndDerivatives_[0];
+                        numerairesHeld_[j] += deflatedCashFlow;
+
+                        for (Size i=1; i <= numberRates_; ++i)
+                        {
+                            Real thisDerivative =  totalCashFlowsThisIndex_[j][cashFlowIndex][i];
+                            if (doDeflation_)
+                            {
+                                thisDerivative *= deflatorAndDerivatives_[0];
+                                thisDerivative +=  totalCashFlowsThisIndex_[j][cashFlowIndex][0]*deflatorAndDerivatives_[i];
+                            }
+
+                            V_[j][stepToUse][i-1] += thisDerivative; // zeroth row of V is t =0 not t_0
+                        }
+                    }
+                }
+            }
+        }
+
+        return flowsFound;
+    }
+
+    void PathwiseVegasAccountingEngineBase::computePartials(Size product, Size stepToUse, const Matrix& pseudoRoot)
+    {
+        for (Size f=0; f < factors_; ++f)
+        {
+            Real libor = LIBORRates_[stepToUse][numberRates_-1];
+            Real V = V_[product][stepToUse][numberRates_-1];
+            Real pseudo = pseudoRoot[numberRates_-1][f];
+            partials_[f][numberRates_-1] = libor*V*pseudo;
+
+            for (Integer r = numberRates_-2; r >=0 ; --r)
+            {
+                Real thisPartialTermr = LIBORRates_[stepToUse][r]*V_[product][stepToUse][r]*pseudoRoot[r][f];
+
+                partials_[f][r] = partials_[f][r+1] + thisPartialTermr;
+            }
+        }
+    }
+
+    void PathwiseVegasAccountingEngineBase::writeValues(std::vector<Real>& values) const
+    {
+        Size entriesPerProduct = 1+numberRates_+numberElementaryVegas_;
+
+        for (Size i=0; i < numberProducts_; ++i)
+        {
+            values[i*entriesPerProduct] = numerairesHeld_[i]*initialNumeraireValue_;
+            for (Size j=0; j < numberRates_; ++j)
+                values[i*entriesPerProduct+1+j] = V_[i][0][j]*initialNumeraireValue_;
+
+            std::transform(elementaryVegas_[i].begin(), elementaryVegas_[i].end(),
+                           values.begin() + i*entriesPerProduct + 1 + numberRates_,
+                           multiply_by<Real>(initialNumeraireValue_));
+        }
+    }
+
+    void PathwiseVegasAccountingEngineBase::multiplePathValuesElementary(std::vector<Real>& means, std::vector<Real>& errors,
+        Size numberOfPaths)
+    {
+        std::vector<Real> values(product_->numberOfProducts()*(1+numberRates_+numberElementaryVegas_));
+        means.resize(values.size());
+        errors.resize(values.size());
+        std::vector<Real> sums(values.size(),0.0);
+        std::vector<Real> sumsqs(values.size(),0.0);
+
+        for (Size i=0; i<numberOfPaths; ++i)
+        {
+            singlePathValues(values);
+
+            for (Size j=0; j < values.size(); ++j)
+            {
+                sums[j] += values[j];
+                sumsqs[j] += values[j]*values[j];
+            }
+        }
+
+        for (Size j=0; j < values.size(); ++j)
+        {
+            means[j] = sums[j]/numberOfPaths;
+            Real meanSq = sumsqs[j]/numberOfPaths;
+            Real variance = meanSq - means[j]*means[j];
+            errors[j] = std::sqrt(variance/numberOfPaths);
+        }
+    }
+
+    void PathwiseVegasAccountingEngineBase::multiplePathValues(std::vector<Real>& means, std::vector<Real>& errors,Size numberOfPaths)
+    {
+        std::vector<Real> allMeans;
+        std::vector<Real> allErrors;
+
+        multiplePathValuesElementary(allMeans,allErrors,numberOfPaths);
+
+        Size outDataPerProduct = 1+numberRates_+numberBumps_;
+        Size inDataPerProduct = 1+numberRates_+numberElementaryVegas_;
+
+        means.resize(outDataPerProduct*numberProducts_);
+        errors.resize(outDataPerProduct*numberProducts_); // post linear combinations, errors are not meaningful so don't attempt to compute s.e.s for vegas
+
+        for (Size p=0; p < numberProducts_; ++p)
+        {
+            for (Size i=0; i < 1 + numberRates_; ++i)
+            {
+                means[i+p*outDataPerProduct] = allMeans[i+p*inDataPerProduct];
+                errors[i+p*outDataPerProduct] = allErrors[i+p*inDataPerProduct];
+            }
+
+            for (Size bump=0; bump<numberBumps_; ++bump)
+            {
+                Real thisVega=0.0;
+
+                for (Size t=0; t < numberSteps_; ++t)
+                    for (Size r=0; r < numberRates_; ++r)
+                        for (Size f=0; f < factors_; ++f)
+                            thisVega+= vegaBumps_[t][bump][r][f]*allMeans[p*inDataPerProduct+1+numberRates_+t*numberRates_*factors_+r*factors_+f];
+
+                means[p*outDataPerProduct+1+numberRates_+bump] = thisVega;
+            }
+        }
+    }
+
+    PathwiseVegasOuterAccountingEngine::PathwiseVegasOuterAccountingEngine(
+        const ext::shared_ptr<LogNormalFwdRateEuler>& evolver, // method relies heavily on LMM Euler
+        const Clone<MarketModelPathwiseMultiProduct>& product,
+        const ext::shared_ptr<MarketModel>& pseudoRootStructure, // we need pseudo-roots and displacements
+        const std::vector<std::vector<Matrix> >& vegaBumps,
+        Real initialNumeraireValue)
+        : PathwiseVegasAccountingEngineBase(evolver, product, pseudoRootStructure,
+                                            vegaBumps, initialNumeraireValue),
+        stepsDiscounts_(pseudoRootStructure->numberOfRates()+1)
+    {
+
+        stepsDiscounts_[0]=1.0;
+
+        const EvolutionDescription& evolution = pseudoRootStructure_->evolution();
+        numeraires_ =  moneyMarketMeasure(evolution);
+
+       std::vector<Matrix> jacobiansThisPathsModel;
+       for (Size i =0; i < numberRates_; ++i)
+              jacobiansThisPathsModel.push_back(Matrix(numberRates_,factors_));
+
+
+
+        for (Size i =0; i < numberSteps_; ++i)
+        {
+              jacobianComputers_.push_back(RatePseudoRootJacobianAllElements(pseudoRootStructure_->pseudoRoot(i),evolution.firstAliveRate()[i],
+                                numeraires_[i],
+                                evolution.rateTaus(),
+                                pseudoRootStructure_->displacements()));
+
+              // vector of vector of matrices to store jacobians of rates with respect to pseudo-root elements
+            jacobiansThisPaths_.push_back(jacobiansThisPathsModel);
         }
 
+        LIBORRatios_ = Matrix(numberSteps_+1,numberRates_);
+        StepsDiscountsSquared_ = LIBORRatios_;
+    }
+
+    Real PathwiseVegasOuterAccountingEngine::singlePathValues(std::vector<Real>& values)
+    {
 
+        const std::vector<Real>& initialForwards_(pseudoRootStructure_->initialRates());
+        currentForwards_ = initialForwards_;
+        resetAccumulators();
 
         Real weight = evolver_->startNewPath();
         product_->reset();
@@ -933,31 +1072,12 @@ namespace QuantLib {
                                          evolver_->browniansThisStep(),
                                          jacobiansThisPaths_[thisStep]);
 
-//            gaussians_[thisStep] = evolver_->browniansThisStep();
-
-
-
-            // for each product...
-            for (Size i=0; i<numberProducts_; ++i)
-            {
-                // ...and each cash flow...
-                for (Size j=0; j<numberCashFlowsThisStep_[i]; ++j)
-                {
-                    Size k = cashFlowsGenerated_[i][j].timeIndex;
-                    ++numberCashFlowsThisIndex_[i][ k];
-
-                    for (Size l=0; l <= numberRates_; ++l)
-                        totalCashFlowsThisIndex_[i][k][l] += cashFlowsGenerated_[i][j].amount[l]*weight;
-
-                }
-            }
-
+            accumulateCashFlows(weight);
 
         } while (!done);
 
         // ok we've gathered cash-flows, still have to backwards computation
 
-        Size factors = pseudoRootStructure_->numberOfFactors();
         const std::vector<Time>& taus= pseudoRootStructure_->evolution(). rateTaus();
 
         bool flowsFound = false;
@@ -968,50 +1088,8 @@ namespace QuantLib {
         {
             Integer stepToUse = std::min<Integer>(currentStep, finalStepDone)+1;
 
-            for (Size k=0; k < cashFlowIndicesThisStep_[currentStep].size(); ++k)
-            {
-                Size cashFlowIndex =cashFlowIndicesThisStep_[currentStep][k];
-
-                // first check to see if anything actually happened before spending time on computing stuff
-                bool noFlows = true;
-                for (Size l=0; l < numberProducts_ && noFlows; ++l)
-                    noFlows = noFlows && (numberCashFlowsThisIndex_[l][cashFlowIndex] ==0);
-
-                flowsFound = flowsFound || !noFlows;
-
-                if (!noFlows)
-                {
-                    if (doDeflation_)
-                        discounters_[cashFlowIndex].getFactors(LIBORRates_, Discounts_,stepToUse, deflatorAndDerivatives_); // get amount to discount cash flow by and amount to multiply its derivatives by
-
-                    for (Size j=0; j < numberProducts_; ++j)
-                    {
-                        if (numberCashFlowsThisIndex_[j][cashFlowIndex] > 0)
-                        {
-                            Real deflatedCashFlow = totalCashFlowsThisIndex_[j][cashFlowIndex][0];
-                            if (doDeflation_)
-                                deflatedCashFlow *= deflatorAndDerivatives_[0];
-                            //cashFlowsGenerated_[j][cashFlowIndex].amount[0]*deflatorAndDerivatives_[0];
-                            numerairesHeld_[j] += deflatedCashFlow;
-
-                            for (Size i=1; i <= numberRates_; ++i)
-                            {
-                                Real thisDerivative =  totalCashFlowsThisIndex_[j][cashFlowIndex][i];
-                                if (doDeflation_)
-                                {
-                                    thisDerivative *= deflatorAndDerivatives_[0];
-                                    thisDerivative +=  totalCashFlowsThisIndex_[j][cashFlowIndex][0]*deflatorAndDerivatives_[i];
-                                    fullDerivatives_[i-1] = thisDerivative;
-                                }
-                                else
-                                    fullDerivatives_[i-1] = thisDerivative;
-
-                                V_[j][stepToUse][i-1] += thisDerivative; // zeroth row of V is t =0 not t_0
-                            } // end of  for (Size i=1; i <= numberRates_; ++i)
-                        } // end of (numberCashFlowsThisIndex_[j][cashFlowIndex] > 0)
-                    } // end of (Size j=0; j < numberProducts_; ++j)
-                } // end of  if (!noFlows)
-            }
+            if (deflateCashFlows(currentStep, stepToUse))
+                flowsFound = true;
 
             // need to do backwards updating
             if (flowsFound)
@@ -1025,23 +1103,7 @@ namespace QuantLib {
 
                     for (Size i=0; i < numberProducts_; ++i)
                     {
-                        // compute partials
-                        for (Size f=0; f < factors; ++f)
-                        {
-                            Real libor = LIBORRates_[stepToUse][numberRates_-1];
-                            Real V = V_[i][stepToUse][numberRates_-1];
-                            Real pseudo = thisPseudoRoot_[numberRates_-1][f];
-                            Real thisPartialTerm = libor*V*pseudo;
-                            partials_[f][numberRates_-1] = thisPartialTerm;
-
-                            for (Integer r = numberRates_-2; r >=0 ; --r)
-                            {
-                                Real thisPartialTermr = LIBORRates_[stepToUse][r]*V_[i][stepToUse][r]*thisPseudoRoot_[r][f];
-
-                                partials_[f][r] = partials_[f][r+1] + thisPartialTermr;
-
-                            }
-                        } // end of (Size f=0; f < factors; ++f)
+                        computePartials(i, stepToUse, thisPseudoRoot_);
 
                         for (Size j=0; j < numberRates_; ++j)
                         {
@@ -1049,7 +1111,7 @@ namespace QuantLib {
                             V_[i][nextStepIndex][j] = nextV;
 
                             Real summandTerm = 0.0;
-                            for (Size f=0; f < factors; ++f)
+                            for (Size f=0; f < factors_; ++f)
                                 summandTerm += thisPseudoRoot_[j][f]*partials_[f][j];
 
                             summandTerm *= taus[j]*StepsDiscountsSquared_[stepToUse][j];
@@ -1088,112 +1150,154 @@ namespace QuantLib {
                                         sensitivity += V_[i][nextIndex][r]*jacobiansThisPaths_[j][r][k][f];
 
                                   }
-/*
-                                  if (j ==distinguishedStep_ && k ==distinguishedRate_ &&f== distinguishedFactor_)
-                                      std::cout << sensitivity << "," <<  jacobiansThisPaths_[j][j][k][f] << "," << gaussians_[j][f] << "," << V_[i][nextIndex][j] << "," << LIBORRates_[nextIndex][j] << "\n";
-  */                
-
 
-                                elementary_vegas_ThisPath_[i][j][k][f] = sensitivity;
+                                elementaryVegas_[i][j][k*factors_+f] = sensitivity;
                         }
                 }
         }
 
-
-        // write answer into values
-
-        Size entriesPerProduct = 1+numberRates_+numberElementaryVegas_;
-
-        for (Size i=0; i < numberProducts_; ++i)
-        {
-            values[i*entriesPerProduct] = numerairesHeld_[i]*initialNumeraireValue_;
-            for (Size j=0; j < numberRates_; ++j)
-                values[i*entriesPerProduct+1+j] = V_[i][0][j]*initialNumeraireValue_;
-
-            for (Size k=0; k < numberSteps_; ++k)
-                for (Size l=0; l < numberRates_; ++l)
-                    for (Size m=0; m < factors_; ++m)
-                        values[i*entriesPerProduct + numberRates_ +1 + m+ l*factors_ + k*numberRates_*factors_] = elementary_vegas_ThisPath_[i][k][l][m]*initialNumeraireValue_;
-
-        }
+        writeValues(values);
 
         return 1.0; // we have put the weight in already, this results in lower variance since weight changes along the path
     
 }
 
-    void PathwiseVegasOuterAccountingEngine::multiplePathValuesElementary(std::vector<Real>& means, std::vector<Real>& errors,
-        Size numberOfPaths)
+    PathwiseVegasAdjointAccountingEngine::PathwiseVegasAdjointAccountingEngine(
+        const ext::shared_ptr<LogNormalFwdRateEuler>& evolver, // method relies heavily on LMM Euler
+        const Clone<MarketModelPathwiseMultiProduct>& product,
+        const ext::shared_ptr<MarketModel>& pseudoRootStructure, // we need pseudo-roots and displacements
+        const std::vector<std::vector<Matrix> >& vegaBumps,
+        Real initialNumeraireValue)
+        : PathwiseVegasAccountingEngineBase(evolver, product, pseudoRootStructure,
+                                            vegaBumps, initialNumeraireValue),
+        e_(pseudoRootStructure->numberOfFactors())
     {
-        Size numberOfElementaryVegas = numberRates_*numberSteps_*factors_;
+        const EvolutionDescription& evolution = pseudoRootStructure_->evolution();
 
-        std::vector<Real> values(product_->numberOfProducts()*(1+numberRates_+numberOfElementaryVegas));
-        means.resize(values.size());
-        errors.resize(values.size());
-        std::vector<Real> sums(values.size(),0.0);
-        std::vector<Real> sumsqs(values.size(),0.0);
+        QL_REQUIRE(evolver_->numeraires() == moneyMarketMeasure(evolution),
+                   "we can only do discretely compounding MM account");
+
+        StepsDiscounts_ = Matrix(numberSteps_+1,numberRates_);
+        gaussians_ = Matrix(numberSteps_, factors_);
+    }
 
+    Real PathwiseVegasAdjointAccountingEngine::singlePathValues(std::vector<Real>& values)
+    {
+        const std::vector<Real>& initialForwards_(pseudoRootStructure_->initialRates());
+        std::copy(initialForwards_.begin(), initialForwards_.end(), LIBORRates_.row_begin(0));
 
+        resetAccumulators();
 
-        for (Size i=0; i<numberOfPaths; ++i)
+        Real weight = evolver_->startNewPath();
+        product_->reset();
+
+        Size thisStep;
+
+        bool done = false;
+        do
         {
-          singlePathValues(values);
-          
-          for (Size j=0; j < values.size(); ++j)
-            {
-                sums[j] += values[j];
-                sumsqs[j] += values[j]*values[j];
+            thisStep = evolver_->currentStep();
+            Size storeStep = thisStep+1;
+            weight *= evolver_->advanceStep();
 
-            }
-        }
+            done = product_->nextTimeStep(evolver_->currentState(),
+                numberCashFlowsThisStep_,
+                cashFlowsGenerated_);
 
-        for (Size j=0; j < values.size(); ++j)
-            {
-                means[j] = sums[j]/numberOfPaths;
-                Real meanSq = sumsqs[j]/numberOfPaths;
-                Real variance = meanSq - means[j]*means[j];
-                errors[j] = std::sqrt(variance/numberOfPaths);
+            // record what the backward sweep needs
+            currentForwards_ =  evolver_->currentState().forwardRates();
 
+            for (Size i=0; i < numberRates_; ++i)
+            {
+                StepsDiscounts_[storeStep][i] = evolver_->currentState().discountRatio(i+1,i);
+                LIBORRates_[storeStep][i] = currentForwards_[i];
+                Discounts_[storeStep][i+1] = evolver_->currentState().discountRatio(i+1,0);
             }
-    }
 
-        void PathwiseVegasOuterAccountingEngine::multiplePathValues(std::vector<Real>& means, std::vector<Real>& errors,Size numberOfPaths)
-        {
-            std::vector<Real> allMeans;
-            std::vector<Real> allErrors;
+            const std::vector<Real>& brownians = evolver_->browniansThisStep();
+            std::copy(brownians.begin(), brownians.end(), gaussians_.row_begin(thisStep));
+
+            accumulateCashFlows(weight);
+
+        } while (!done);
+
+        // ok we've gathered cash-flows, still have to do the backwards computation
+
+        const std::vector<Time>& taus= pseudoRootStructure_->evolution().rateTaus();
+        const std::vector<Size>& alive = pseudoRootStructure_->evolution().firstAliveRate();
+        const std::vector<Spread>& displacements = pseudoRootStructure_->displacements();
+
+        bool flowsFound = false;
 
-            multiplePathValuesElementary(allMeans,allErrors,numberOfPaths);
+        Integer finalStepDone = thisStep;
 
-            Size outDataPerProduct = 1+numberRates_+numberBumps_;
-            Size inDataPerProduct = 1+numberRates_+numberElementaryVegas_;
+        for (Integer currentStep =  numberSteps_-1; currentStep >=0 ; --currentStep) // must be a signed type as we go negative
+        {
+            Integer stepToUse = std::min<Integer>(currentStep, finalStepDone)+1;
 
-            means.resize((1+numberRates_+numberBumps_)*numberProducts_);
-            errors.resize((1+numberRates_+numberBumps_)*numberProducts_); // post linear combinations, errors are not meaningful so don't attempt to compute s.e.s for vegas
+            if (deflateCashFlows(currentStep, stepToUse))
+                flowsFound = true;
 
-            for (Size p=0; p < numberProducts_; ++p)
+            // need to do backwards updating
+            if (flowsFound)
             {
-                for (Size i=0; i < 1 + numberRates_; ++i)
+                Integer nextStepToUse  = std::min<Integer>(currentStep-1, finalStepDone);
+                Integer nextStepIndex = nextStepToUse+1;
+                if (nextStepIndex != stepToUse) // then we need to update V and get the vegas of this step
                 {
-                      means[i+p*outDataPerProduct] = allMeans[i+p*inDataPerProduct];
-                      errors[i+p*outDataPerProduct] = allErrors[i+p*inDataPerProduct];
-                }
+                    const Matrix& thisPseudoRoot_= pseudoRootStructure_->pseudoRoot(currentStep);
+                    Size aliveIndex = alive[currentStep];
 
-               for (Size bump=0; bump<numberBumps_; ++bump)
-                {
-                    Real thisVega=0.0;
+                    for (Size i=0; i < numberProducts_; ++i)
+                    {
+                        computePartials(i, stepToUse, thisPseudoRoot_);
+
+                        // elementary vegas: V paired against the sensitivities of the rates
+                        // to the pseudo-root elements of this step, row by row
+                        std::fill(e_.begin(), e_.end(), 0.0);
 
+                        for (Size k=aliveIndex; k < numberRates_; ++k)
+                        {
+                            Real ratio = (LIBORRates_[stepToUse-1][k]+displacements[k])*StepsDiscounts_[stepToUse][k];
+                            Real rateTerm = V_[i][stepToUse][k]*(LIBORRates_[stepToUse][k]+displacements[k]);
 
-                    for (Size t=0; t < numberSteps_; ++t)
-                        for (Size r=0; r < numberRates_; ++r)
                             for (Size f=0; f < factors_; ++f)
-                                thisVega+= vegaBumps_[t][bump][r][f]*allMeans[p*inDataPerProduct+1+numberRates_+t*numberRates_*factors_+r*factors_+f];
+                            {
+                                Real pseudo = thisPseudoRoot_[k][f];
+                                Real laterRates = k+1 < numberRates_ ? partials_[f][k+1] : 0.0;
+
+                                elementaryVegas_[i][currentStep][k*factors_+f] =
+                                    taus[k]*ratio*laterRates
+                                    + rateTerm*(2*ratio*taus[k]*pseudo - pseudo
+                                                + e_[f]*taus[k] + gaussians_[currentStep][f]);
 
+                                e_[f] += ratio*pseudo;
+                            }
+                        }
+
+                        for (Size j=0; j < numberRates_; ++j)
+                        {
+                            Real ratio = LIBORRates_[stepToUse][j]/LIBORRates_[nextStepIndex][j];
+                            Real nextV = V_[i][stepToUse][j] * ratio;
 
-                    means[p*outDataPerProduct+1+numberRates_+bump] = thisVega;
-               }
-                    
+                            Real summandTerm = 0.0;
+                            for (Size f=0; f < factors_; ++f)
+                                summandTerm += thisPseudoRoot_[j][f]*partials_[f][j];
+
+                            Real stepDiscount = StepsDiscounts_[stepToUse][j];
+                            summandTerm *= taus[j]*stepDiscount*stepDiscount;
+
+                            V_[i][nextStepIndex][j] = nextV + summandTerm;
+                        }
+                    }
+                }
             }
+        }
+
+        writeValues(values);
 
-        } // end of method
+        return 1.0; // we have put the weight in already, this results in lower variance since weight changes along the path
+    }
 
 } // end of namespace
 
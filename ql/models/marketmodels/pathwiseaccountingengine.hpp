@@ -51,9 +51,12 @@ namespace QuantLib {
 
         void multiplePathValues(SequenceStatisticsInc& stats,
                                 Size numberOfPaths);
+        /*! collects the values and the deltas of the products along
+            the next path of the evolver and returns the weight of the
+            path.
+        */
+        Real singlePathValues(std::vector<Real>& values);
       private:
-          Real singlePathValues(std::vector<Real>& values);
-
         ext::shared_ptr<LogNormalFwdRateEuler> evolver_;
         Clone<MarketModelPathwiseMultiProduct> product_;
         ext::shared_ptr<MarketModel> pseudoRootStructure_;
@@ -175,28 +178,22 @@ namespace QuantLib {
 
     };
 
-   //! Engine collecting cash flows along a market-model simulation for doing pathwise computation of Deltas and vegas
-    // using Giles--Glasserman smoking adjoints method
-    // note only works with displaced LMM, 
-    // 
-    // The method is intimately connected with log-normal Euler evolution 
-    // 
+    //! Common part of the engines computing pathwise Deltas and elementary vegas
+    // The engines derived from this one only differ in the backward sweep giving the elementary vegas,
+    // i.e. the sensitivities to the pseudo-root elements of each step, and in what they record
+    // on the forward sweep for it. Gathering the cash flows, deflating them into the adjoint vector V,
+    // writing the values of each path and combining the elementary vegas into the bumps' ones are shared.
     // We must work with discretely compounding MM account
-    // To compute a vega means changing the pseudo-square root at each time step
-    // So for each vega, we have a vector of matrices. So we need a vector of vectors of matrices to compute all the vegas.
-    // We do the outermost vector by time step and inner one by which vega.
-    // This implementation is different in that all the linear combinations by the bumps are done as late as possible,
-    // whereas PathwiseVegasAccountingEngine does them as early as possible. 
-    // This is tested in MarketModelTest::testPathwiseVegas
 
-    class PathwiseVegasOuterAccountingEngine 
+    class PathwiseVegasAccountingEngineBase
     {
       public:
-        PathwiseVegasOuterAccountingEngine(const ext::shared_ptr<LogNormalFwdRateEuler>& evolver, // method relies heavily on LMM Euler
+        PathwiseVegasAccountingEngineBase(const ext::shared_ptr<LogNormalFwdRateEuler>& evolver, // method relies heavily on LMM Euler
                          const Clone<MarketModelPathwiseMultiProduct>& product,
                          const ext::shared_ptr<MarketModel>& pseudoRootStructure, // we need pseudo-roots and displacements
-                         const std::vector<std::vector<Matrix> >& VegaBumps, 
+                         const std::vector<std::vector<Matrix> >& VegaBumps,
                          Real initialNumeraireValue);
+        virtual ~PathwiseVegasAccountingEngineBase() = default;
 
         //! Use to get vegas with respect to VegaBumps
         void multiplePathValues(std::vector<Real>& means,
@@ -208,14 +205,25 @@ namespace QuantLib {
                                 std::vector<Real>& errors,
                                 Size numberOfPaths);
 
-      private:
-          Real singlePathValues(std::vector<Real>& values);
+      protected:
+        virtual Real singlePathValues(std::vector<Real>& values) = 0;
+
+        // clears the accumulation variables before a new path
+        void resetAccumulators();
+        // adds the cash flows of the last step, times the weight of the path so far
+        void accumulateCashFlows(Real weight);
+        // deflates the cash flows paid in the given step into the numeraires held and V;
+        // returns whether any was found
+        bool deflateCashFlows(Size currentStep, Size stepToUse);
+        // partials_[f][r] = sum over the rates s >= r of L_s V_s a_sf
+        void computePartials(Size product, Size stepToUse, const Matrix& pseudoRoot);
+        // writes values, deltas and elementary vegas of the path
+        void writeValues(std::vector<Real>& values) const;
 
         ext::shared_ptr<LogNormalFwdRateEuler> evolver_;
         Clone<MarketModelPathwiseMultiProduct> product_;
         ext::shared_ptr<MarketModel> pseudoRootStructure_;
-        std::vector<std::vector<Matrix> > vegaBumps_; 
-        std::vector<Size> numeraires_;
+        std::vector<std::vector<Matrix> > vegaBumps_;
 
         Real initialNumeraireValue_;
         Size numberProducts_;
@@ -226,14 +234,9 @@ namespace QuantLib {
         Size numberBumps_;
         Size numberElementaryVegas_;
 
-        std::vector<RatePseudoRootJacobianAllElements> jacobianComputers_;
-
-        
         bool doDeflation_;
 
-
         // workspace
-        std::vector<Real> currentForwards_, lastForwards_;
         std::vector<Real> numerairesHeld_;
         std::vector<Size> numberCashFlowsThisStep_;
         std::vector<std::vector<MarketModelPathwiseMultiProduct::CashFlow> >
@@ -242,34 +245,89 @@ namespace QuantLib {
 
         std::vector<Matrix> V_;  // one V for each product, with components for each time step and rate
 
-        Matrix LIBORRatios_; // dimensions are step and rate number
-        Matrix Discounts_; // dimensions are step and rate number, goes from 0 to n. P(t_0, t_j)
-
-        Matrix StepsDiscountsSquared_; // dimensions are step and rate number
-        std::vector<Real> stepsDiscounts_;
-
         Matrix LIBORRates_; // dimensions are step and rate number
+        Matrix Discounts_; // dimensions are step and rate number, goes from 0 to n. P(t_0, t_j)
         Matrix partials_; // dimensions are factor and rate
 
-        std::vector<std::vector<Matrix>   > elementary_vegas_ThisPath_;  // dimensions are product, step,  rate and factor
-        std::vector<std::vector<Matrix> > jacobiansThisPaths_;                      // dimensions are step, rate, rate and factor
+        std::vector<Matrix> elementaryVegas_; // one for each product, dimensions are step and rate times factor
 
         std::vector<Real> deflatorAndDerivatives_;
-        std::vector<Real> fullDerivatives_;
-        
+
         std::vector<std::vector<Size> > numberCashFlowsThisIndex_;
         std::vector<Matrix> totalCashFlowsThisIndex_; // need product cross times cross which sensitivity
 
         std::vector<std::vector<Size> > cashFlowIndicesThisStep_;
-/*
-        // experimental
+    };
 
-        std::vector<std::vector<Real> > gaussians_;
-        int distinguishedFactor_;
-        int distinguishedRate_;
-        int  distinguishedStep_;
+   //! Engine collecting cash flows along a market-model simulation for doing pathwise computation of Deltas and vegas
+    // using Giles--Glasserman smoking adjoints method
+    // note only works with displaced LMM, 
+    // 
+    // The method is intimately connected with log-normal Euler evolution 
+    // 
+    // We must work with discretely compounding MM account
+    // To compute a vega means changing the pseudo-square root at each time step
+    // So for each vega, we have a vector of matrices. So we need a vector of vectors of matrices to compute all the vegas.
+    // We do the outermost vector by time step and inner one by which vega.
+    // This implementation is different in that all the linear combinations by the bumps are done as late as possible,
+    // whereas PathwiseVegasAccountingEngine does them as early as possible. 
+    // This is tested in MarketModelTest::testPathwiseVegas
 
-*/
+    class PathwiseVegasOuterAccountingEngine : public PathwiseVegasAccountingEngineBase
+    {
+      public:
+        PathwiseVegasOuterAccountingEngine(const ext::shared_ptr<LogNormalFwdRateEuler>& evolver, // method relies heavily on LMM Euler
+                         const Clone<MarketModelPathwiseMultiProduct>& product,
+                         const ext::shared_ptr<MarketModel>& pseudoRootStructure, // we need pseudo-roots and displacements
+                         const std::vector<std::vector<Matrix> >& VegaBumps, 
+                         Real initialNumeraireValue);
+
+      private:
+        Real singlePathValues(std::vector<Real>& values) override;
+
+        std::vector<Size> numeraires_;
+
+        std::vector<RatePseudoRootJacobianAllElements> jacobianComputers_;
+
+        // workspace
+        std::vector<Real> currentForwards_, lastForwards_;
+
+        Matrix LIBORRatios_; // dimensions are step and rate number
+
+        Matrix StepsDiscountsSquared_; // dimensions are step and rate number
+        std::vector<Real> stepsDiscounts_;
+
+        std::vector<std::vector<Matrix> > jacobiansThisPaths_;                      // dimensions are step, rate, rate and factor
+    };
+
+    //! Engine collecting cash flows along a market-model simulation for doing pathwise computation of Deltas and vegas
+    // Adjoint counterpart of PathwiseVegasOuterAccountingEngine: same constructor, same outputs and the same
+    // linearisation of the log-normal Euler step, but the elementary vegas are obtained from the adjoint vector V
+    // on the backward sweep instead of pairing V with a full Jacobian of rates against pseudo-root elements.
+    // Per path and step the cost is thus O(rates*factors) rather than O(rates^2*factors), and no Jacobians are stored.
+    // The forward sweep only records rates, discount ratios and Gaussians for each step.
+    // We must work with discretely compounding MM account
+    // This is tested in MarketModelTest::testPathwiseVegasAdjoint
+
+    class PathwiseVegasAdjointAccountingEngine : public PathwiseVegasAccountingEngineBase
+    {
+      public:
+        PathwiseVegasAdjointAccountingEngine(const ext::shared_ptr<LogNormalFwdRateEuler>& evolver, // method relies heavily on LMM Euler
+                         const Clone<MarketModelPathwiseMultiProduct>& product,
+                         const ext::shared_ptr<MarketModel>& pseudoRootStructure, // we need pseudo-roots and displacements
+                         const std::vector<std::vector<Matrix> >& VegaBumps,
+                         Real initialNumeraireValue);
+
+      private:
+        Real singlePathValues(std::vector<Real>& values) override;
+
+        // workspace
+        std::vector<Real> currentForwards_;
+
+        Matrix StepsDiscounts_; // dimensions are step and rate number
+        Matrix gaussians_; // dimensions are step and factor
+
+        std::vector<Real> e_; // dimension is factor
     };
 
 }
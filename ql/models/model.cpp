@@ -23,6 +23,7 @@
 #include <ql/math/optimization/projection.hpp>
 #include <ql/math/optimization/projectedconstraint.hpp>
 #include <ql/utilities/null_deleter.hpp>
+#include <exception>
 
 using std::vector;
 
@@ -64,9 +65,76 @@ namespace QuantLib {
             return values;
         }
 
+        void gradient(Array& grad, const Array& params) const override {
+            const Array errors = values(params);
+            if (!hasAnalyticGradient()) {
+                CostFunction::gradient(grad, params);
+                return;
+            }
+
+            Matrix jac(instruments_.size(), params.size());
+            errorGradients(jac);
+
+            Real value = 0.0;
+            for (Size i=0; i<errors.size(); ++i)
+                value += errors[i]*errors[i];
+            value = std::sqrt(value);
+
+            grad = Array(params.size(), 0.0);
+            if (value == 0.0)
+                return;
+            for (Size i=0; i<errors.size(); ++i)
+                for (Size j=0; j<params.size(); ++j)
+                    grad[j] += errors[i]*jac[i][j]/value;
+        }
+
+        void jacobian(Matrix& jac, const Array& params) const override {
+            model_->setParams(projection_.include(params));
+            if (!hasAnalyticGradient()) {
+                CostFunction::jacobian(jac, params);
+                return;
+            }
+            errorGradients(jac);
+        }
+
         Real finiteDifferenceEpsilon() const override { return 1e-6; }
 
       private:
+        // the gradients are computed in parallel; helpers sharing lazily
+        // cached data must synchronize its calculation themselves
+        bool hasAnalyticGradient() const {
+            for (Size i=0; i<instruments_.size(); ++i)
+                if (!instruments_[i]->hasCalibrationErrorGradient())
+                    return false;
+            return true;
+        }
+
+        void errorGradients(Matrix& jac) const {
+            const Integer n = instruments_.size();
+            std::vector<Array> gradients(n);
+
+            std::vector<std::exception_ptr> errors(n);
+
+            #pragma omp parallel for
+            for (Integer i=0; i<n; ++i) {
+                try {
+                    gradients[i] = projection_.project(
+                        instruments_[i]->calibrationErrorGradient());
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+            for (Integer i=0; i<n; ++i)
+                if (errors[i])
+                    std::rethrow_exception(errors[i]);
+
+            for (Integer i=0; i<n; ++i) {
+                const Real w = std::sqrt(weights_[i]);
+                for (Size j=0; j<jac.columns(); ++j)
+                    jac[i][j] = w*gradients[i][j];
+            }
+        }
+
         ext::shared_ptr<CalibratedModel> model_;
         const vector<ext::shared_ptr<CalibrationHelper> >& instruments_;
         vector<Real> weights_;
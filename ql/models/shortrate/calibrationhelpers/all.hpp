@@ -3,4 +3,5 @@
 
 #include <ql/models/shortrate/calibrationhelpers/caphelper.hpp>
 #include <ql/models/shortrate/calibrationhelpers/swaptionhelper.hpp>
+#include <ql/models/shortrate/calibrationhelpers/swaptionhelperbasket.hpp>
 
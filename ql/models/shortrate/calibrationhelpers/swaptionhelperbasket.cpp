@@ -0,0 +1,664 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <ql/models/shortrate/calibrationhelpers/swaptionhelperbasket.hpp>
+#include <ql/math/distributions/normaldistribution.hpp>
+#include <ql/math/solvers1d/newtonsafe.hpp>
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace QuantLib {
+
+    namespace {
+
+        // Jamshidian decomposition in the Hull-White model: the
+        // critical value z of the standardized state solves
+        //     sum_i c_i F_i exp(-s_i z - s_i^2/2) = K
+        class JamshidianCriticalState {
+          public:
+            JamshidianCriticalState(const std::vector<Real>& amounts,
+                                    const std::vector<Real>& forwards,
+                                    const std::vector<Real>& stdDevs,
+                                    Real strike)
+            : amounts_(amounts), forwards_(forwards), stdDevs_(stdDevs),
+              strike_(strike) {}
+            Real operator()(Real z) const {
+                Real value = -strike_;
+                for (Size i=0; i<amounts_.size(); ++i)
+                    value += amounts_[i]*forwards_[i]*
+                        std::exp(-stdDevs_[i]*(z+0.5*stdDevs_[i]));
+                return value;
+            }
+            Real derivative(Real z) const {
+                Real value = 0.0;
+                for (Size i=0; i<amounts_.size(); ++i)
+                    value -= amounts_[i]*forwards_[i]*stdDevs_[i]*
+                        std::exp(-stdDevs_[i]*(z+0.5*stdDevs_[i]));
+                return value;
+            }
+          private:
+            const std::vector<Real>& amounts_;
+            const std::vector<Real>& forwards_;
+            const std::vector<Real>& stdDevs_;
+            Real strike_;
+        };
+
+        // critical value of the second G2 factor, see G2::swaption
+        class G2CriticalState {
+          public:
+            G2CriticalState(const std::vector<Real>& lambda,
+                            const std::vector<Real>& Bb)
+            : lambda_(lambda), Bb_(Bb) {}
+            Real operator()(Real y) const {
+                Real value = 1.0;
+                for (Size i=0; i<lambda_.size(); ++i)
+                    value -= lambda_[i]*std::exp(-Bb_[i]*y);
+                return value;
+            }
+            Real derivative(Real y) const {
+                Real value = 0.0;
+                for (Size i=0; i<lambda_.size(); ++i)
+                    value += lambda_[i]*Bb_[i]*std::exp(-Bb_[i]*y);
+                return value;
+            }
+          private:
+            const std::vector<Real>& lambda_;
+            const std::vector<Real>& Bb_;
+        };
+
+        // value and derivatives w.r.t. the five G2 parameters
+        class G2Dual {
+          public:
+            static const Size n = 5;
+            G2Dual(Real v = 0.0) : v_(v) { std::fill(d_, d_+n, 0.0); }
+            static G2Dual variable(Real v, Size i) {
+                G2Dual x(v);
+                x.d_[i] = 1.0;
+                return x;
+            }
+            Real value() const { return v_; }
+            Real derivative(Size i) const { return d_[i]; }
+            // chain rule for a function with derivative df at v
+            G2Dual apply(Real f, Real df) const {
+                G2Dual x(f);
+                for (Size i=0; i<n; ++i)
+                    x.d_[i] = df*d_[i];
+                return x;
+            }
+            G2Dual& operator+=(const G2Dual& y) {
+                v_ += y.v_;
+                for (Size i=0; i<n; ++i)
+                    d_[i] += y.d_[i];
+                return *this;
+            }
+            G2Dual& operator-=(const G2Dual& y) {
+                v_ -= y.v_;
+                for (Size i=0; i<n; ++i)
+                    d_[i] -= y.d_[i];
+                return *this;
+            }
+            G2Dual& operator*=(const G2Dual& y) {
+                for (Size i=0; i<n; ++i)
+                    d_[i] = d_[i]*y.v_ + v_*y.d_[i];
+                v_ *= y.v_;
+                return *this;
+            }
+            G2Dual& operator/=(const G2Dual& y) {
+                v_ /= y.v_;
+                for (Size i=0; i<n; ++i)
+                    d_[i] = (d_[i] - v_*y.d_[i])/y.v_;
+                return *this;
+            }
+            G2Dual operator-() const { return apply(-v_, -1.0); }
+          private:
+            Real v_;
+            Real d_[n];
+        };
+
+        G2Dual operator+(G2Dual x, const G2Dual& y) { return x += y; }
+        G2Dual operator-(G2Dual x, const G2Dual& y) { return x -= y; }
+        G2Dual operator*(G2Dual x, const G2Dual& y) { return x *= y; }
+        G2Dual operator/(G2Dual x, const G2Dual& y) { return x /= y; }
+        G2Dual operator+(G2Dual x, Real y) { return x += G2Dual(y); }
+        G2Dual operator+(Real x, const G2Dual& y) { return y + x; }
+        G2Dual operator-(G2Dual x, Real y) { return x -= G2Dual(y); }
+        G2Dual operator-(Real x, const G2Dual& y) { return G2Dual(x) - y; }
+        G2Dual operator*(const G2Dual& x, Real y) { return x.apply(x.value()*y, y); }
+        G2Dual operator*(Real x, const G2Dual& y) { return y*x; }
+
+        G2Dual exp(const G2Dual& x) {
+            Real e = std::exp(x.value());
+            return x.apply(e, e);
+        }
+        G2Dual sqrt(const G2Dual& x) {
+            Real s = std::sqrt(x.value());
+            return x.apply(s, 0.5/s);
+        }
+        G2Dual cumulativeNormal(const G2Dual& x) {
+            return x.apply(CumulativeNormalDistribution()(x.value()),
+                           NormalDistribution()(x.value()));
+        }
+
+        Real value(Real x) { return x; }
+        Real value(const G2Dual& x) { return x.value(); }
+        Real cumulativeNormal(Real x) {
+            return CumulativeNormalDistribution()(x);
+        }
+
+        // see G2::V
+        template <class T>
+        T g2V(Time t, const T& a, const T& sigma, const T& b,
+              const T& eta, const T& rho) {
+            using std::exp;
+            T expat = exp(-a*t);
+            T expbt = exp(-b*t);
+            T cx = sigma/a;
+            T cy = eta/b;
+            T valuex = cx*cx*(t + (2.0*expat-0.5*expat*expat-1.5)/a);
+            T valuey = cy*cy*(t + (2.0*expbt-0.5*expbt*expbt-1.5)/b);
+            T value = 2.0*rho*cx*cy*(t + (expat - 1.0)/a
+                                       + (expbt - 1.0)/b
+                                       - (expat*expbt - 1.0)/(a+b));
+            return valuex + valuey + value;
+        }
+
+        /* G2 swaption value as in G2::swaption, with the integral
+           over the first factor written in terms of the standardized
+           variable u = (x-mux)/sigmax; the trapezoidal rule on the
+           nodes u_k is the same as in the original formulation. The
+           critical value of the second factor only enters through
+           the boundary of the integration domain, where the payoff
+           vanishes; therefore it does not contribute to the
+           derivatives and is solved for in plain numbers. */
+        template <class T>
+        T g2SwaptionValue(Real w, Real nominal, Time start,
+                          DiscountFactor startDiscount,
+                          const std::vector<Time>& payTimes,
+                          const std::vector<DiscountFactor>& payDiscounts,
+                          const std::vector<Real>& coefficients,
+                          const std::vector<Real>& nodes,
+                          const std::vector<Real>& weights,
+                          const T& a, const T& sigma, const T& b,
+                          const T& eta, const T& rho) {
+            using std::exp;
+            using std::sqrt;
+
+            const Size size = payTimes.size();
+
+            T sigmax = sigma*sqrt(0.5*(1.0-exp(-2.0*a*start))/a);
+            T sigmay = eta*sqrt(0.5*(1.0-exp(-2.0*b*start))/b);
+            T rhoxy = rho*eta*sigma*(1.0 - exp(-(a+b)*start))/
+                ((a+b)*sigmax*sigmay);
+            T txy = sqrt(1.0 - rhoxy*rhoxy);
+
+            T temp = sigma*sigma/(a*a);
+            T mux = -((temp+rho*sigma*eta/(a*b))*(1.0 - exp(-a*start)) -
+                      0.5*temp*(1.0 - exp(-2.0*a*start)) -
+                      rho*sigma*eta/(b*(a+b))*(1.0 - exp(-(b+a)*start)));
+            temp = eta*eta/(b*b);
+            T muy = -((temp+rho*sigma*eta/(a*b))*(1.0 - exp(-b*start)) -
+                      0.5*temp*(1.0 - exp(-2.0*b*start)) -
+                      rho*sigma*eta/(a*(a+b))*(1.0 - exp(-(b+a)*start)));
+
+            T vStart = g2V(start, a, sigma, b, eta, rho);
+            std::vector<T> cA(size), Ba(size), Bb(size);
+            std::vector<Real> BbValues(size);
+            for (Size i=0; i<size; ++i) {
+                Time tau = payTimes[i] - start;
+                T A = payDiscounts[i]/startDiscount *
+                    exp(0.5*(g2V(tau, a, sigma, b, eta, rho)
+                             - g2V(payTimes[i], a, sigma, b, eta, rho)
+                             + vStart));
+                cA[i] = coefficients[i]*A;
+                Ba[i] = (1.0 - exp(-a*tau))/a;
+                Bb[i] = (1.0 - exp(-b*tau))/b;
+                BbValues[i] = value(Bb[i]);
+            }
+
+            std::vector<T> lambda(size);
+            std::vector<Real> lambdaValues(size);
+            G2CriticalState criticalState(lambdaValues, BbValues);
+            NewtonSafe solver;
+            solver.setMaxEvaluations(1000);
+            Real yb = 0.0;
+
+            T result = 0.0;
+            for (Size k=0; k<nodes.size(); ++k) {
+                const Real u = nodes[k];
+                T x = mux + sigmax*u;
+                for (Size i=0; i<size; ++i) {
+                    lambda[i] = cA[i]*exp(-Ba[i]*x);
+                    lambdaValues[i] = value(lambda[i]);
+                }
+                yb = solver.solve(criticalState, 1.0e-12,
+                                  std::max(-99.0, std::min(yb, 99.0)),
+                                  -100.0, 100.0);
+
+                T h1 = (yb - muy)/(sigmay*txy) - rhoxy*u/txy;
+                T integrand = cumulativeNormal(-w*h1);
+                for (Size i=0; i<size; ++i) {
+                    T h2 = h1 + Bb[i]*sigmay*txy;
+                    T kappa = -Bb[i] *
+                        (muy - 0.5*txy*txy*sigmay*sigmay*Bb[i] +
+                         rhoxy*sigmay*u);
+                    integrand -= lambda[i]*exp(kappa)*cumulativeNormal(-w*h2);
+                }
+                result += weights[k]*integrand;
+            }
+
+            return nominal*w*startDiscount*result;
+        }
+
+
+        // shared valuation of the basket for the calibration helpers
+        class BasketValuation : public LazyObject {
+          public:
+            BasketValuation(ext::shared_ptr<SwaptionHelperBasket> basket,
+                            ext::shared_ptr<HullWhite> hullWhite,
+                            ext::shared_ptr<G2> g2,
+                            Real range,
+                            Size intervals)
+            : basket_(std::move(basket)), hullWhite_(std::move(hullWhite)),
+              g2_(std::move(g2)), range_(range), intervals_(intervals),
+              gradientsCalculated_(false) {
+                registerWith(basket_);
+                if (hullWhite_ != nullptr)
+                    registerWith(hullWhite_);
+                if (g2_ != nullptr)
+                    registerWith(g2_);
+            }
+            Real value(Size i) const {
+                calculate();
+                return values_[i];
+            }
+            /* can be called concurrently by the helpers sharing this
+               valuation; the first call calculates the gradients of
+               the whole basket, the others wait for it */
+            Real valueAndGradient(Size i, Array& gradient) const {
+                std::exception_ptr error;
+                #pragma omp critical(swaptionhelperbasket_gradients)
+                {
+                    try {
+                        calculate();
+                        if (!gradientsCalculated_) {
+                            if (hullWhite_ != nullptr)
+                                basket_->values(*hullWhite_, gradients_);
+                            else
+                                basket_->values(*g2_, range_, intervals_,
+                                                gradients_);
+                            gradientsCalculated_ = true;
+                        }
+                        gradient = Array(gradients_.row_begin(i),
+                                         gradients_.row_end(i));
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+                }
+                if (error)
+                    std::rethrow_exception(error);
+                return values_[i];
+            }
+          protected:
+            void performCalculations() const override {
+                if (hullWhite_ != nullptr)
+                    values_ = basket_->values(*hullWhite_);
+                else
+                    values_ = basket_->values(*g2_, range_, intervals_);
+                gradientsCalculated_ = false;
+            }
+          private:
+            ext::shared_ptr<SwaptionHelperBasket> basket_;
+            ext::shared_ptr<HullWhite> hullWhite_;
+            ext::shared_ptr<G2> g2_;
+            Real range_;
+            Size intervals_;
+            mutable Array values_;
+            mutable Matrix gradients_;
+            mutable bool gradientsCalculated_;
+        };
+
+        class BasketSwaptionHelper : public BlackCalibrationHelper {
+          public:
+            BasketSwaptionHelper(ext::shared_ptr<SwaptionHelper> helper,
+                                 ext::shared_ptr<BasketValuation> valuation,
+                                 Size index)
+            : BlackCalibrationHelper(helper->volatility(),
+                                     helper->calibrationErrorType(),
+                                     helper->volatilityType()),
+              helper_(std::move(helper)), valuation_(std::move(valuation)),
+              index_(index) {
+                registerWith(helper_);
+            }
+            void performCalculations() const override {
+                marketValue_ = helper_->marketValue();
+            }
+            Real modelValue() const override {
+                return valuation_->value(index_);
+            }
+            bool hasModelValueGradient() const override { return true; }
+            Real modelValueAndGradient(Array& gradient) const override {
+                return valuation_->valueAndGradient(index_, gradient);
+            }
+            void addTimesTo(std::list<Time>& times) const override {
+                helper_->addTimesTo(times);
+            }
+            Real blackPrice(Volatility volatility) const override {
+                return helper_->blackPrice(volatility);
+            }
+          private:
+            ext::shared_ptr<SwaptionHelper> helper_;
+            ext::shared_ptr<BasketValuation> valuation_;
+            Size index_;
+        };
+
+        std::vector<ext::shared_ptr<CalibrationHelper> >
+        basketHelpers(const ext::shared_ptr<SwaptionHelperBasket>& basket,
+                      const ext::shared_ptr<BasketValuation>& valuation) {
+            std::vector<ext::shared_ptr<CalibrationHelper> > result;
+            for (Size i=0; i<basket->size(); ++i)
+                result.push_back(ext::make_shared<BasketSwaptionHelper>(
+                    basket->helpers()[i], valuation, i));
+            return result;
+        }
+
+        void rethrowFirst(const std::vector<std::exception_ptr>& errors) {
+            for (Size i=0; i<errors.size(); ++i)
+                if (errors[i])
+                    std::rethrow_exception(errors[i]);
+        }
+
+    }
+
+
+    SwaptionHelperBasket::SwaptionHelperBasket(
+                    std::vector<ext::shared_ptr<SwaptionHelper> > helpers,
+                    Handle<YieldTermStructure> termStructure)
+    : helpers_(std::move(helpers)), termStructure_(std::move(termStructure)) {
+        QL_REQUIRE(!helpers_.empty(), "no swaption helpers given");
+        for (Size i=0; i<helpers_.size(); ++i)
+            registerWith(helpers_[i]);
+        registerWith(termStructure_);
+    }
+
+    void SwaptionHelperBasket::performCalculations() const {
+        const Date referenceDate = termStructure_->referenceDate();
+        const DayCounter dayCounter = termStructure_->dayCounter();
+
+        data_.resize(helpers_.size());
+        for (Size i=0; i<helpers_.size(); ++i) {
+            Swaption::arguments arguments;
+            helpers_[i]->swaption()->setupArguments(&arguments);
+
+            QL_REQUIRE(arguments.exercise->type() == Exercise::European,
+                       "European swaption expected for helper #" << i);
+            QL_REQUIRE(arguments.settlementType == Settlement::Physical,
+                       "physically settled swaption expected for helper #"
+                       << i);
+            for (Size j=0; j<arguments.floatingSpreads.size(); ++j)
+                QL_REQUIRE(arguments.floatingSpreads[j] == 0.0,
+                           "non zero spread not allowed for helper #" << i);
+
+            SwaptionData& data = data_[i];
+            data.w = arguments.type == VanillaSwap::Payer ? 1.0 : -1.0;
+            data.nominal = arguments.nominal;
+            data.exerciseTime =
+                dayCounter.yearFraction(referenceDate,
+                                        arguments.exercise->date(0));
+            data.valueTime =
+                dayCounter.yearFraction(referenceDate,
+                                        arguments.fixedResetDates[0]);
+            data.startTime =
+                dayCounter.yearFraction(referenceDate,
+                                        arguments.floatingResetDates[0]);
+            data.valueDiscount = termStructure_->discount(data.valueTime);
+            data.startDiscount = termStructure_->discount(data.startTime);
+
+            const Size n = arguments.fixedPayDates.size();
+            data.payTimes.resize(n);
+            data.payDiscounts.resize(n);
+            data.g2Coefficients.resize(n);
+            data.amounts = arguments.fixedCoupons;
+            data.amounts.back() += arguments.nominal;
+            for (Size j=0; j<n; ++j) {
+                data.payTimes[j] =
+                    dayCounter.yearFraction(referenceDate,
+                                            arguments.fixedPayDates[j]);
+                data.payDiscounts[j] =
+                    termStructure_->discount(data.payTimes[j]);
+                Time tau = data.payTimes[j] -
+                    (j == 0 ? data.startTime : data.payTimes[j-1]);
+                data.g2Coefficients[j] = arguments.swap->fixedRate()*tau;
+            }
+            data.g2Coefficients.back() += 1.0;
+        }
+    }
+
+    void SwaptionHelperBasket::checkTermStructure(
+                        const Handle<YieldTermStructure>& modelCurve) const {
+        QL_REQUIRE(modelCurve->referenceDate() ==
+                                        termStructure_->referenceDate() &&
+                   modelCurve->dayCounter() == termStructure_->dayCounter(),
+                   "model and basket term structures are not consistent");
+    }
+
+    Disposable<Array>
+    SwaptionHelperBasket::values(const HullWhite& model) const {
+        return hullWhiteValues(model, nullptr);
+    }
+
+    Disposable<Array>
+    SwaptionHelperBasket::values(const HullWhite& model,
+                                 Matrix& gradients) const {
+        return hullWhiteValues(model, &gradients);
+    }
+
+    Disposable<Array>
+    SwaptionHelperBasket::values(const G2& model,
+                                 Real range,
+                                 Size intervals) const {
+        return g2Values(model, range, intervals, nullptr);
+    }
+
+    Disposable<Array>
+    SwaptionHelperBasket::values(const G2& model,
+                                 Real range,
+                                 Size intervals,
+                                 Matrix& gradients) const {
+        return g2Values(model, range, intervals, &gradients);
+    }
+
+    Disposable<Array>
+    SwaptionHelperBasket::hullWhiteValues(const HullWhite& model,
+                                          Matrix* gradients) const {
+        calculate();
+        checkTermStructure(model.termStructure());
+
+        const Real a = model.a();
+        const Real sigma = model.sigma();
+        const bool smallReversion = a < std::sqrt(QL_EPSILON);
+
+        const Integer n = static_cast<Integer>(data_.size());
+        Array result(n);
+        if (gradients != nullptr)
+            *gradients = Matrix(n, 2);
+        std::vector<std::exception_ptr> errors(n);
+
+        #pragma omp parallel for
+        for (Integer k=0; k<n; ++k) {
+            try {
+                const SwaptionData& data = data_[k];
+                const Time T = data.exerciseTime;
+                const Time u = data.valueTime - T;
+
+                // standard deviation of the state at exercise and its
+                // derivative w.r.t. the mean reversion
+                Real g, dg;
+                if (smallReversion) {
+                    g = T;
+                    dg = -T*T;
+                } else {
+                    g = 0.5*(1.0 - std::exp(-2.0*a*T))/a;
+                    dg = (T*std::exp(-2.0*a*T) - g)/a;
+                }
+                const Real stdDev = sigma*std::sqrt(g);
+                const Real dStdDev = 0.5*sigma*dg/std::sqrt(g);
+
+                // log-volatilities of the bond ratios P(T,t_i)/P(T,t_0)
+                const Size m = data.payTimes.size();
+                std::vector<Real> forwards(m), stdDevs(m), dStdDevs(m);
+                Real sumForward = 0.0, sumStdDev = 0.0;
+                for (Size i=0; i<m; ++i) {
+                    const Time v = data.payTimes[i] - T;
+                    Real beta, dBeta;
+                    if (smallReversion) {
+                        beta = v - u;
+                        dBeta = -0.5*(v*v - u*u);
+                    } else {
+                        const Real eu = std::exp(-a*u), ev = std::exp(-a*v);
+                        beta = (eu - ev)/a;
+                        dBeta = (v*ev - u*eu - beta)/a;
+                    }
+                    forwards[i] = data.payDiscounts[i]/data.valueDiscount;
+                    stdDevs[i] = stdDev*beta;
+                    dStdDevs[i] = dStdDev*beta + stdDev*dBeta;
+                    sumForward += data.amounts[i]*forwards[i];
+                    sumStdDev += data.amounts[i]*forwards[i]*stdDevs[i];
+                }
+
+                JamshidianCriticalState criticalState(data.amounts, forwards,
+                                                      stdDevs, data.nominal);
+                const Real guess = std::log(sumForward/data.nominal)/
+                    (sumStdDev/sumForward);
+                NewtonSafe solver;
+                solver.setMaxEvaluations(1000);
+                const Real z = solver.solve(criticalState, 1.0e-12,
+                                            guess, 0.1);
+
+                // sum of the bond options on P(T,t_i)/P(T,t_0) struck
+                // at their values in z
+                CumulativeNormalDistribution N;
+                NormalDistribution phi;
+                const Real w = data.w;
+                Real value = data.nominal*N(-w*z), dA = 0.0, dSigma = 0.0;
+                for (Size i=0; i<m; ++i) {
+                    const Real c = data.amounts[i]*forwards[i];
+                    value -= c*N(-w*(z+stdDevs[i]));
+                    const Real vega = c*phi(z+stdDevs[i]);
+                    dA += vega*dStdDevs[i];
+                    dSigma += vega*stdDevs[i]/sigma;
+                }
+                result[k] = w*data.valueDiscount*value;
+                if (gradients != nullptr) {
+                    (*gradients)[k][0] = data.valueDiscount*dA;
+                    (*gradients)[k][1] = data.valueDiscount*dSigma;
+                }
+            } catch (...) {
+                errors[k] = std::current_exception();
+            }
+        }
+        rethrowFirst(errors);
+
+        return result;
+    }
+
+    Disposable<Array>
+    SwaptionHelperBasket::g2Values(const G2& model,
+                                   Real range,
+                                   Size intervals,
+                                   Matrix* gradients) const {
+        QL_REQUIRE(range > 0.0, "positive range required");
+        QL_REQUIRE(intervals > 0, "at least one interval required");
+        calculate();
+        checkTermStructure(model.termStructure());
+
+        // trapezoidal rule on the standardized first factor,
+        // weighted by its density
+        std::vector<Real> nodes(intervals+1), weights(intervals+1);
+        const Real h = 2.0*range/intervals;
+        NormalDistribution phi;
+        for (Size k=0; k<=intervals; ++k) {
+            nodes[k] = -range + k*h;
+            weights[k] = ((k == 0 || k == intervals) ? 0.5*h : h) *
+                phi(nodes[k]);
+        }
+
+        const Integer n = static_cast<Integer>(data_.size());
+        Array result(n);
+        if (gradients != nullptr)
+            *gradients = Matrix(n, G2Dual::n);
+        std::vector<std::exception_ptr> errors(n);
+
+        #pragma omp parallel for
+        for (Integer k=0; k<n; ++k) {
+            try {
+                const SwaptionData& data = data_[k];
+                if (gradients == nullptr) {
+                    result[k] = g2SwaptionValue<Real>(
+                        data.w, data.nominal, data.startTime,
+                        data.startDiscount, data.payTimes, data.payDiscounts,
+                        data.g2Coefficients, nodes, weights, model.a(),
+                        model.sigma(), model.b(), model.eta(), model.rho());
+                } else {
+                    G2Dual value = g2SwaptionValue<G2Dual>(
+                        data.w, data.nominal, data.startTime,
+                        data.startDiscount, data.payTimes, data.payDiscounts,
+                        data.g2Coefficients, nodes, weights,
+                        G2Dual::variable(model.a(), 0),
+                        G2Dual::variable(model.sigma(), 1),
+                        G2Dual::variable(model.b(), 2),
+                        G2Dual::variable(model.eta(), 3),
+                        G2Dual::variable(model.rho(), 4));
+                    result[k] = value.value();
+                    for (Size j=0; j<G2Dual::n; ++j)
+                        (*gradients)[k][j] = value.derivative(j);
+                }
+            } catch (...) {
+                errors[k] = std::current_exception();
+            }
+        }
+        rethrowFirst(errors);
+
+        return result;
+    }
+
+
+    std::vector<ext::shared_ptr<CalibrationHelper> >
+    basketCalibrationHelpers(
+                        const ext::shared_ptr<SwaptionHelperBasket>& basket,
+                        const ext::shared_ptr<HullWhite>& model) {
+        QL_REQUIRE(model != nullptr, "no model given");
+        return basketHelpers(basket,
+                             ext::make_shared<BasketValuation>(
+                                 basket, model, ext::shared_ptr<G2>(),
+                                 0.0, 0));
+    }
+
+    std::vector<ext::shared_ptr<CalibrationHelper> >
+    basketCalibrationHelpers(
+                        const ext::shared_ptr<SwaptionHelperBasket>& basket,
+                        const ext::shared_ptr<G2>& model,
+                        Real range,
+                        Size intervals) {
+        QL_REQUIRE(model != nullptr, "no model given");
+        return basketHelpers(basket,
+                             ext::make_shared<BasketValuation>(
+                                 basket, ext::shared_ptr<HullWhite>(), model,
+                                 range, intervals));
+    }
+
+}
@@ -0,0 +1,147 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file swaptionhelperbasket.hpp
+    \brief Batch valuation of swaption calibration helpers
+*/
+
+#ifndef quantlib_swaption_helper_basket_hpp
+#define quantlib_swaption_helper_basket_hpp
+
+#include <ql/models/shortrate/calibrationhelpers/swaptionhelper.hpp>
+#include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
+#include <ql/models/shortrate/twofactormodels/g2.hpp>
+#include <ql/math/matrix.hpp>
+
+namespace QuantLib {
+
+    //! basket of swaption helpers valued together in short-rate models
+    /*! The exercise and coupon times, the coupon amounts and the
+        discount factors of all swaptions in the basket are extracted
+        once; they are refreshed only when a helper or the term
+        structure changes.  Given a model, all swaptions are then
+        valued in one pass, together with the derivatives of their
+        values with respect to the model parameters if required.
+
+        In the Hull-White model, the swaptions are valued by means of
+        the Jamshidian decomposition, as in JamshidianSwaptionEngine.
+        The derivatives w.r.t. the mean reversion and the volatility
+        are analytic.
+
+        In the G2 model, the swaptions are valued by the
+        one-dimensional integral used by G2SwaptionEngine; the
+        integration nodes are shared by all swaptions.  The
+        derivatives w.r.t. the five model parameters are obtained by
+        differentiating the discretized integral exactly.
+
+        The swaptions are valued in parallel when OpenMP is enabled.
+
+        \warning The models must use the same term structure as the
+                 basket, which in turn should be the discount curve
+                 of the helpers.
+
+        \ingroup shortrate
+    */
+    class SwaptionHelperBasket : public LazyObject {
+      public:
+        SwaptionHelperBasket(
+                std::vector<ext::shared_ptr<SwaptionHelper> > helpers,
+                Handle<YieldTermStructure> termStructure);
+        //! \name Inspectors
+        //@{
+        Size size() const { return helpers_.size(); }
+        const std::vector<ext::shared_ptr<SwaptionHelper> >& helpers() const {
+            return helpers_;
+        }
+        //@}
+        //! \name Hull-White valuation
+        //@{
+        //! model values of the swaptions
+        Disposable<Array> values(const HullWhite& model) const;
+        /*! model values of the swaptions; the i-th row of the
+            gradient matrix holds the derivatives of the i-th value
+            w.r.t. the model parameters, i.e., the mean reversion and
+            the volatility.
+        */
+        Disposable<Array> values(const HullWhite& model,
+                                 Matrix& gradients) const;
+        //@}
+        //! \name G2 valuation
+        /*! The range (in standard deviations) and the number of
+            intervals have the same meaning as in G2SwaptionEngine.
+        */
+        //@{
+        Disposable<Array> values(const G2& model,
+                                 Real range,
+                                 Size intervals) const;
+        //! the columns of the gradient matrix are a, sigma, b, eta, rho
+        Disposable<Array> values(const G2& model,
+                                 Real range,
+                                 Size intervals,
+                                 Matrix& gradients) const;
+        //@}
+      protected:
+        void performCalculations() const override;
+      private:
+        struct SwaptionData {
+            Real w;       // 1 for payer, -1 for receiver swaptions
+            Real nominal;
+            Time exerciseTime, valueTime, startTime;
+            DiscountFactor valueDiscount, startDiscount;
+            std::vector<Time> payTimes;
+            std::vector<DiscountFactor> payDiscounts;
+            // fixed coupons, including the nominal at maturity
+            std::vector<Real> amounts;
+            // fixed coupons as used by the G2 integral
+            std::vector<Real> g2Coefficients;
+        };
+        void checkTermStructure(const Handle<YieldTermStructure>&) const;
+        Disposable<Array> hullWhiteValues(const HullWhite& model,
+                                          Matrix* gradients) const;
+        Disposable<Array> g2Values(const G2& model,
+                                   Real range,
+                                   Size intervals,
+                                   Matrix* gradients) const;
+        std::vector<ext::shared_ptr<SwaptionHelper> > helpers_;
+        Handle<YieldTermStructure> termStructure_;
+        mutable std::vector<SwaptionData> data_;
+    };
+
+    /*! returns calibration helpers for the swaptions of the basket.
+        Their model values are taken from a single valuation of the
+        whole basket, which is repeated only when the model
+        parameters change; they provide the gradient of their
+        calibration error to the calibration.  Market values and
+        calibration error types are those of the underlying swaption
+        helpers.
+    */
+    std::vector<ext::shared_ptr<CalibrationHelper> >
+    basketCalibrationHelpers(
+                        const ext::shared_ptr<SwaptionHelperBasket>& basket,
+                        const ext::shared_ptr<HullWhite>& model);
+
+    std::vector<ext::shared_ptr<CalibrationHelper> >
+    basketCalibrationHelpers(
+                        const ext::shared_ptr<SwaptionHelperBasket>& basket,
+                        const ext::shared_ptr<G2>& model,
+                        Real range,
+                        Size intervals);
+
+}
+
+
+#endif
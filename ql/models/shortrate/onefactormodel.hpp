@@ -106,6 +106,7 @@ namespace QuantLib {
         void setSpread(Spread spread)
         {
             spread_=spread;
+            resetDiscounts();
         }
       private:
         ext::shared_ptr<TrinomialTree> tree_;
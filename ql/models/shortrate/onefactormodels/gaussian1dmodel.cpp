@@ -20,11 +20,249 @@
 #include <ql/models/shortrate/onefactormodels/gaussian1dmodel.hpp>
 #include <ql/math/interpolations/cubicinterpolation.hpp>
 #include <ql/payoff.hpp>
+#include <list>
+#include <map>
 
 using std::exp;
 
 namespace QuantLib {
 
+    class Gaussian1dModel::GridCache : public Observer {
+      public:
+        struct Key {
+            int kind;
+            Date d1, d2;
+            Real yStdDevs;
+            int gridPoints;
+            // compared by owner, so that a new object allocated where a
+            // destroyed one was can't be mistaken for it
+            ext::weak_ptr<Observable> dependency;
+            bool operator<(const Key& o) const {
+                if (kind != o.kind) return kind < o.kind;
+                if (d1 != o.d1) return d1 < o.d1;
+                if (d2 != o.d2) return d2 < o.d2;
+                if (yStdDevs != o.yStdDevs) return yStdDevs < o.yStdDevs;
+                if (gridPoints != o.gridPoints) return gridPoints < o.gridPoints;
+                return dependency.owner_before(o.dependency);
+            }
+        };
+        explicit GridCache(Size maxTables) : maxTables_(maxTables) {}
+        void update() override { clear(); }
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tables_.clear();
+            recency_.clear();
+        }
+        bool find(const Key& key, Array& table) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Tables::iterator i = tables_.find(key);
+            if (i == tables_.end())
+                return false;
+            recency_.splice(recency_.begin(), recency_, i->second.second);
+            table = i->second.first;
+            return true;
+        }
+        void insert(const Key& key,
+                    const Array& table,
+                    const ext::shared_ptr<Observable>& dependency) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // another thread might have computed the same table
+            if (tables_.find(key) != tables_.end())
+                return;
+            // registrations are dropped here rather than in clear(),
+            // which can be called while a dependency notifies
+            if (tables_.empty())
+                unregisterWithAll();
+            else if (tables_.size() >= maxTables_)
+                evictLeastRecentlyUsed();
+            if (dependency != nullptr)
+                registerWith(dependency);
+            recency_.push_front(key);
+            tables_.insert(
+                std::make_pair(key, std::make_pair(table, recency_.begin())));
+        }
+      private:
+        typedef std::list<Key> Recency;
+        typedef std::map<Key, std::pair<Array, Recency::iterator> > Tables;
+        void evictLeastRecentlyUsed() {
+            Key key = recency_.back();
+            recency_.pop_back();
+            tables_.erase(key);
+            ext::shared_ptr<Observable> dependency = key.dependency.lock();
+            if (dependency == nullptr)
+                return;
+            for (Tables::const_iterator i = tables_.begin();
+                 i != tables_.end(); ++i) {
+                const ext::weak_ptr<Observable>& other = i->first.dependency;
+                if (!other.owner_before(key.dependency) &&
+                    !key.dependency.owner_before(other))
+                    return;
+            }
+            unregisterWith(dependency);
+        }
+        Size maxTables_;
+        Tables tables_;
+        Recency recency_;
+        std::mutex mutex_;
+    };
+
+    namespace {
+
+        enum GridKind { ZerobondGrid, NumeraireGrid, ForwardRateGrid };
+
+        class ZerobondOnGrid {
+          public:
+            ZerobondOnGrid(const Gaussian1dModel& model,
+                           const Date& maturity,
+                           const Date& referenceDate,
+                           const Handle<YieldTermStructure>& yts)
+            : model_(model), maturity_(maturity), referenceDate_(referenceDate),
+              yts_(yts) {}
+            Real operator()(Real y) const {
+                return model_.zerobond(maturity_, referenceDate_, y, yts_);
+            }
+          private:
+            const Gaussian1dModel& model_;
+            Date maturity_, referenceDate_;
+            const Handle<YieldTermStructure>& yts_;
+        };
+
+        class NumeraireOnGrid {
+          public:
+            NumeraireOnGrid(const Gaussian1dModel& model,
+                            const Date& referenceDate,
+                            const Handle<YieldTermStructure>& yts)
+            : model_(model), referenceDate_(referenceDate), yts_(yts) {}
+            Real operator()(Real y) const {
+                return model_.numeraire(referenceDate_, y, yts_);
+            }
+          private:
+            const Gaussian1dModel& model_;
+            Date referenceDate_;
+            const Handle<YieldTermStructure>& yts_;
+        };
+
+        class ForwardRateOnGrid {
+          public:
+            ForwardRateOnGrid(const Gaussian1dModel& model,
+                              const Date& fixing,
+                              const Date& referenceDate,
+                              const ext::shared_ptr<IborIndex>& iborIdx)
+            : model_(model), fixing_(fixing), referenceDate_(referenceDate),
+              iborIdx_(iborIdx) {}
+            Real operator()(Real y) const {
+                return model_.forwardRate(fixing_, referenceDate_, y, iborIdx_);
+            }
+          private:
+            const Gaussian1dModel& model_;
+            Date fixing_, referenceDate_;
+            const ext::shared_ptr<IborIndex>& iborIdx_;
+        };
+
+    }
+
+    Gaussian1dModel::Gaussian1dModel(
+        const Handle<YieldTermStructure>& yieldTermStructure)
+    : TermStructureConsistentModel(yieldTermStructure),
+      gridCache_(new GridCache(512)), upToDate_(false), calculating_(false) {
+        registerWith(Settings::instance().evaluationDate());
+    }
+
+    void Gaussian1dModel::performCalculations() const {
+        evaluationDate_ = Settings::instance().evaluationDate();
+        enforcesTodaysHistoricFixings_ =
+            Settings::instance().enforcesTodaysHistoricFixings();
+        gridCache_->clear();
+    }
+
+    void Gaussian1dModel::calculate() const {
+        // engines query the model from several threads, and most of
+        // its methods call calculate(); once the model is calculated,
+        // this costs an atomic read.  The flags of LazyObject are only
+        // read under the lock, since update() can write them.
+        if (upToDate_.load(std::memory_order_acquire))
+            return;
+        std::lock_guard<std::recursive_mutex> lock(calculationMutex_);
+        // calls made by performCalculations() find the lock held
+        if (calculating_)
+            return;
+        calculating_ = true;
+        try {
+            LazyObject::calculate();
+        } catch (...) {
+            calculating_ = false;
+            throw;
+        }
+        calculating_ = false;
+        upToDate_.store(calculated_, std::memory_order_release);
+    }
+
+    void Gaussian1dModel::update() {
+        upToDate_.store(false, std::memory_order_release);
+        LazyObject::update();
+    }
+
+    void Gaussian1dModel::recalculate() {
+        upToDate_.store(false, std::memory_order_release);
+        LazyObject::recalculate();
+    }
+
+    void Gaussian1dModel::flushGridCache() const { gridCache_->clear(); }
+
+    template <class F>
+    Disposable<Array> Gaussian1dModel::cachedGrid(
+        int kind, const Date& d1, const Date& d2, Real yStdDevs, int gridPoints,
+        const ext::shared_ptr<Observable>& dependency, const F& f) const {
+
+        calculate();
+
+        GridCache::Key key = {kind, d1, d2, yStdDevs, gridPoints,
+                              dependency};
+        Array table;
+        if (gridCache_->find(key, table))
+            return table;
+
+        Array z = yGrid(yStdDevs, gridPoints);
+        table = Array(z.size());
+        for (Size i = 0; i < z.size(); i++)
+            table[i] = f(z[i]);
+        gridCache_->insert(key, table, dependency);
+        return table;
+    }
+
+    Disposable<Array> Gaussian1dModel::zerobondGrid(
+        const Date& maturity, const Date& referenceDate, Real yStdDevs,
+        int gridPoints, const Handle<YieldTermStructure>& yts) const {
+        ext::shared_ptr<Observable> dependency;
+        if (!yts.empty())
+            dependency = yts;
+        return cachedGrid(ZerobondGrid, maturity, referenceDate, yStdDevs,
+                          gridPoints, dependency,
+                          ZerobondOnGrid(*this, maturity, referenceDate, yts));
+    }
+
+    Disposable<Array> Gaussian1dModel::numeraireGrid(
+        const Date& referenceDate, Real yStdDevs, int gridPoints,
+        const Handle<YieldTermStructure>& yts) const {
+        ext::shared_ptr<Observable> dependency;
+        if (!yts.empty())
+            dependency = yts;
+        return cachedGrid(NumeraireGrid, referenceDate, Date(), yStdDevs,
+                          gridPoints, dependency,
+                          NumeraireOnGrid(*this, referenceDate, yts));
+    }
+
+    Disposable<Array> Gaussian1dModel::forwardRateGrid(
+        const Date& fixing, const Date& referenceDate, Real yStdDevs,
+        int gridPoints, const ext::shared_ptr<IborIndex>& iborIdx) const {
+        QL_REQUIRE(iborIdx != nullptr, "no ibor index given");
+        // the index notifies changes of its forwarding curve and fixings
+        return cachedGrid(ForwardRateGrid, fixing, referenceDate, yStdDevs,
+                          gridPoints, iborIdx,
+                          ForwardRateOnGrid(*this, fixing, referenceDate,
+                                            iborIdx));
+    }
+
     Real Gaussian1dModel::forwardRate(const Date& fixing,
                                       const Date& referenceDate,
                                       const Real y,
@@ -283,4 +521,64 @@ Disposable<Array> Gaussian1dModel::yGrid(
 
     return result;
 }
+
+Gaussian1dGridIntegral::Gaussian1dGridIntegral(const Array& z)
+: n_(z.size()), m0_(z.size() - 1), m1_(z.size() - 1), m2_(z.size() - 1),
+  m3_(z.size() - 1) {
+    QL_REQUIRE(n_ >= 2, "at least two grid points required");
+    for (Size i = 0; i < n_ - 1; i++) {
+        m0_[i] = Gaussian1dModel::gaussianShiftedPolynomialIntegral(
+            0.0, 0.0, 0.0, 0.0, 1.0, z[i], z[i], z[i + 1]);
+        m1_[i] = Gaussian1dModel::gaussianShiftedPolynomialIntegral(
+            0.0, 0.0, 0.0, 1.0, 0.0, z[i], z[i], z[i + 1]);
+        m2_[i] = Gaussian1dModel::gaussianShiftedPolynomialIntegral(
+            0.0, 0.0, 1.0, 0.0, 0.0, z[i], z[i], z[i + 1]);
+        m3_[i] = Gaussian1dModel::gaussianShiftedPolynomialIntegral(
+            0.0, 1.0, 0.0, 0.0, 0.0, z[i], z[i], z[i + 1]);
+    }
+    r0_ = Gaussian1dModel::gaussianShiftedPolynomialIntegral(
+        0.0, 0.0, 0.0, 0.0, 1.0, z[n_ - 2], z[n_ - 1], 100.0);
+    r1_ = Gaussian1dModel::gaussianShiftedPolynomialIntegral(
+        0.0, 0.0, 0.0, 1.0, 0.0, z[n_ - 2], z[n_ - 1], 100.0);
+    r2_ = Gaussian1dModel::gaussianShiftedPolynomialIntegral(
+        0.0, 0.0, 1.0, 0.0, 0.0, z[n_ - 2], z[n_ - 1], 100.0);
+    r3_ = Gaussian1dModel::gaussianShiftedPolynomialIntegral(
+        0.0, 1.0, 0.0, 0.0, 0.0, z[n_ - 2], z[n_ - 1], 100.0);
+    l0_ = Gaussian1dModel::gaussianShiftedPolynomialIntegral(
+        0.0, 0.0, 0.0, 0.0, 1.0, z[0], -100.0, z[0]);
+    l1_ = Gaussian1dModel::gaussianShiftedPolynomialIntegral(
+        0.0, 0.0, 0.0, 1.0, 0.0, z[0], -100.0, z[0]);
+    l2_ = Gaussian1dModel::gaussianShiftedPolynomialIntegral(
+        0.0, 0.0, 1.0, 0.0, 0.0, z[0], -100.0, z[0]);
+    l3_ = Gaussian1dModel::gaussianShiftedPolynomialIntegral(
+        0.0, 1.0, 0.0, 0.0, 0.0, z[0], -100.0, z[0]);
+}
+
+Real Gaussian1dGridIntegral::operator()(const Array& p,
+                                        const std::vector<Real>& a,
+                                        const std::vector<Real>& b,
+                                        const std::vector<Real>& c,
+                                        const bool extrapolatePayoff,
+                                        const bool flatPayoffExtrapolation,
+                                        const Option::Type type) const {
+    QL_REQUIRE(p.size() == n_, "payoff size (" << p.size()
+                                   << ") does not match grid size (" << n_
+                                   << ")");
+    Real price = 0.0;
+    for (Size i = 0; i < n_ - 1; i++)
+        price += interval(i, p[i], a[i], b[i], c[i]);
+    if (extrapolatePayoff) {
+        if (flatPayoffExtrapolation) {
+            price += rightTail(p[n_ - 2], 0.0, 0.0, 0.0) +
+                     leftTail(p[0], 0.0, 0.0, 0.0);
+        } else {
+            if (type == Option::Call)
+                price += rightTail(p[n_ - 2], a[n_ - 2], b[n_ - 2], c[n_ - 2]);
+            if (type == Option::Put)
+                price += leftTail(p[0], a[0], b[0], c[0]);
+        }
+    }
+    return price;
+}
+
 }
@@ -32,6 +32,7 @@
 #include <ql/indexes/iborindex.hpp>
 #include <ql/indexes/swapindex.hpp>
 #include <ql/instruments/vanillaswap.hpp>
+#include <ql/option.hpp>
 #include <ql/time/date.hpp>
 #include <ql/time/period.hpp>
 #include <ql/termstructures/yieldtermstructure.hpp>
@@ -50,6 +51,8 @@
 #endif
 #include <boost/math/special_functions/erf.hpp>
 #include <boost/unordered_map.hpp>
+#include <atomic>
+#include <mutex>
 #if defined(__GNUC__) &&                                                       \
     (((__GNUC__ == 4) && (__GNUC_MINOR__ >= 8)) || (__GNUC__ > 4))
 #pragma GCC diagnostic pop
@@ -152,6 +155,38 @@ class Gaussian1dModel : public TermStructureConsistentModel, public LazyObject {
     Disposable<Array>
     yGrid(Real yStdDevs, int gridPoints, Real T = 1.0, Real t = 0, Real y = 0) const;
 
+    /*! Zerobond prices on the grid yGrid(yStdDevs, gridPoints) of the
+        standardized state variable at the reference date. The tables
+        are cached in the model, so that they are shared by all
+        engines using the same grid, and recomputed only if the model
+        or the given curve changes; the least recently used tables are
+        discarded when the cache is full. */
+    Disposable<Array>
+    zerobondGrid(const Date& maturity,
+                 const Date& referenceDate,
+                 Real yStdDevs,
+                 int gridPoints,
+                 const Handle<YieldTermStructure>& yts = Handle<YieldTermStructure>()) const;
+
+    //! numeraire on the grid of the standardized state variable, cached
+    Disposable<Array>
+    numeraireGrid(const Date& referenceDate,
+                  Real yStdDevs,
+                  int gridPoints,
+                  const Handle<YieldTermStructure>& yts = Handle<YieldTermStructure>()) const;
+
+    //! forward rates on the grid of the standardized state variable, cached
+    Disposable<Array> forwardRateGrid(const Date& fixing,
+                                      const Date& referenceDate,
+                                      Real yStdDevs,
+                                      int gridPoints,
+                                      const ext::shared_ptr<IborIndex>& iborIdx) const;
+
+    void update() override;
+    /*! hides LazyObject::recalculate(), which would leave the state
+        read by concurrent calls to calculate() up to date */
+    void recalculate();
+
   private:
     // It is of great importance for performance reasons to cache underlying
     // swaps generated from indexes. In addition the indexes may only be given
@@ -183,13 +218,26 @@ class Gaussian1dModel : public TermStructureConsistentModel, public LazyObject {
                                  CachedSwapKeyHasher> CacheType;
 
     mutable CacheType swapCache_;
+    mutable std::mutex swapCacheMutex_;
+
+    // quantities tabulated on the y-grid, see zerobondGrid()
+    class GridCache;
+    ext::shared_ptr<GridCache> gridCache_;
+
+    // calculate() can be called concurrently, see the implementation
+    mutable std::atomic<bool> upToDate_;
+    mutable bool calculating_;
+    mutable std::recursive_mutex calculationMutex_;
+
+    template <class F>
+    Disposable<Array> cachedGrid(int kind, const Date& d1, const Date& d2,
+                                 Real yStdDevs, int gridPoints,
+                                 const ext::shared_ptr<Observable>& dependency,
+                                 const F& f) const;
 
   protected:
     // we let derived classes register with the termstructure
-    Gaussian1dModel(const Handle<YieldTermStructure> &yieldTermStructure)
-        : TermStructureConsistentModel(yieldTermStructure) {
-        registerWith(Settings::instance().evaluationDate());
-    }
+    Gaussian1dModel(const Handle<YieldTermStructure> &yieldTermStructure);
 
     ~Gaussian1dModel() override {}
 
@@ -198,14 +246,16 @@ class Gaussian1dModel : public TermStructureConsistentModel, public LazyObject {
     virtual Real
     zerobondImpl(Time T, Time t, Real y, const Handle<YieldTermStructure>& yts) const = 0;
 
-    void performCalculations() const override {
-        evaluationDate_ = Settings::instance().evaluationDate();
-        enforcesTodaysHistoricFixings_ =
-            Settings::instance().enforcesTodaysHistoricFixings();
-    }
+    void calculate() const override;
+    void performCalculations() const override;
+
+    // to be called by derived classes when the model changes without
+    // triggering a recalculation, e.g. in generateArguments()
+    void flushGridCache() const;
 
     void generateArguments() {
         calculate();
+        flushGridCache();
         notifyObservers();
     }
 
@@ -216,14 +266,19 @@ class Gaussian1dModel : public TermStructureConsistentModel, public LazyObject {
                    const Date &expiry, const Period &tenor) const {
 
         CachedSwapKey k = {index, expiry, tenor};
-        CacheType::iterator i = swapCache_.find(k);
-        if (i == swapCache_.end()) {
-            ext::shared_ptr<VanillaSwap> underlying =
-                index->clone(tenor)->underlyingSwap(expiry);
+        ext::shared_ptr<VanillaSwap> underlying;
+        {
+            std::lock_guard<std::mutex> lock(swapCacheMutex_);
+            CacheType::iterator i = swapCache_.find(k);
+            if (i != swapCache_.end())
+                underlying = i->second;
+        }
+        if (underlying == nullptr) {
+            underlying = index->clone(tenor)->underlyingSwap(expiry);
+            std::lock_guard<std::mutex> lock(swapCacheMutex_);
             swapCache_.insert(std::make_pair(k, underlying));
-            return underlying;
         }
-        return i->second;
+        return underlying;
     }
 
     ext::shared_ptr<StochasticProcess1D> stateProcess_;
@@ -231,6 +286,50 @@ class Gaussian1dModel : public TermStructureConsistentModel, public LazyObject {
     mutable bool enforcesTodaysHistoricFixings_;
 };
 
+//! Integration of cubic splines on a standardized y-grid
+/*! The integral of a cubic spline on the grid z against the standard
+    normal density, as used for the roll back in Gaussian1d engines,
+    is linear in the spline coefficients (see
+    Gaussian1dModel::gaussianShiftedPolynomialIntegral).  The moments
+    of the density on the grid intervals are precomputed once per
+    grid, so that each integral reduces to a few dot products; this
+    pays off only if several integrals are taken on the same grid.
+*/
+class Gaussian1dGridIntegral {
+  public:
+    explicit Gaussian1dGridIntegral(const Array& z);
+    /*! returns the integral of the cubic spline through the values
+        p on the grid; the payoff is extrapolated beyond the grid as
+        in Gaussian1dModel::zerobondOption */
+    Real operator()(const Array& p,
+                    const std::vector<Real>& a,
+                    const std::vector<Real>& b,
+                    const std::vector<Real>& c,
+                    bool extrapolatePayoff,
+                    bool flatPayoffExtrapolation,
+                    Option::Type type) const;
+    //! integral of the cubic $p+a\,x+b\,x^2+c\,x^3$, $x=z-z_i$, on $[z_i,z_{i+1}]$
+    Real interval(Size i, Real p, Real a, Real b, Real c) const {
+        return p * m0_[i] + a * m1_[i] + b * m2_[i] + c * m3_[i];
+    }
+    //! integral of the cubic of the last interval on $[z_{n-1},\infty)$
+    Real rightTail(Real p, Real a, Real b, Real c) const {
+        return p * r0_ + a * r1_ + b * r2_ + c * r3_;
+    }
+    //! integral of the cubic of the first interval on $(-\infty,z_0]$
+    Real leftTail(Real p, Real a, Real b, Real c) const {
+        return p * l0_ + a * l1_ + b * l2_ + c * l3_;
+    }
+
+  private:
+    Size n_;
+    // moments on the intervals [z_i, z_{i+1}] shifted by z_i
+    std::vector<Real> m0_, m1_, m2_, m3_;
+    // moments on the tails, shifted by the left end of the outermost
+    // intervals
+    Real r0_, r1_, r2_, r3_, l0_, l1_, l2_, l3_;
+};
+
 inline ext::shared_ptr<StochasticProcess1D> Gaussian1dModel::stateProcess() const {
 
     QL_REQUIRE(stateProcess_ != nullptr, "state process not set");
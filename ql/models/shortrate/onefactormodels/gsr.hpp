@@ -143,6 +143,7 @@ class Gsr : public Gaussian1dModel, public CalibratedModel {
 
     void generateArguments() override {
         ext::static_pointer_cast<GsrProcess>(stateProcess_)->flushCache();
+        flushGridCache();
         notifyObservers();
     }
 
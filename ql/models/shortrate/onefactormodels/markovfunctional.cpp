@@ -230,6 +230,7 @@ namespace QuantLib {
             reversion_(0.0), volsteptimesArray_, sigma_.params());
 
         y_ = yGrid(modelSettings_.yStdDevs_, modelSettings_.yGridPoints_);
+        yIntegral_ = ext::make_shared<Gaussian1dGridIntegral>(y_);
 
         discreteNumeraire_ = ext::make_shared<Matrix>(
             times_.size(), 2 * modelSettings_.yGridPoints_ + 1, 1.0);
@@ -460,8 +461,34 @@ namespace QuantLib {
         QL_MFMESSAGE(modelOutputs_, "updating numeraire tabulation");
         modelOutputs_.dirty_ = true;
 
-        modelOutputs_.adjustmentFactors_.clear();
-        modelOutputs_.digitalsAdjustmentFactors_.clear();
+        // the numeraire at an expiry depends on the model parameters,
+        // the yield term structure and the smiles at this and later
+        // expiries; we go backwards and recompute it only from the
+        // latest expiry on where any of these changed
+
+        std::vector<Real> modelInputs(sigma_.params().begin(),
+                                      sigma_.params().end());
+        modelInputs.push_back(reversion_(0.0));
+        modelInputs.push_back(numeraireTime_);
+        modelInputs.push_back(termStructure()->discount(numeraireTime_, true));
+        for (Size k = 0; k < times_.size(); k++) {
+            modelInputs.push_back(times_[k]);
+            modelInputs.push_back(termStructure()->discount(times_[k], true));
+        }
+        bool dirty = modelInputs != tabulationModelInputs_ ||
+                     (modelSettings_.adjustments_ & ModelSettings::CustomSmile) != 0;
+        if (dirty)
+            tabulationInputs_.clear();
+        tabulationModelInputs_ = modelInputs;
+        tabulationInputs_.resize(times_.size());
+
+        std::vector<Real> adjustmentFactors, digitalsAdjustmentFactors;
+        adjustmentFactors.swap(modelOutputs_.adjustmentFactors_);
+        digitalsAdjustmentFactors.swap(modelOutputs_.digitalsAdjustmentFactors_);
+
+        bool keepFactors =
+            digitalsAdjustmentFactors.size() == calibrationPoints_.size() &&
+            adjustmentFactors.size() == calibrationPoints_.size();
 
         int idx = times_.size() - 2;
 
@@ -475,13 +502,39 @@ namespace QuantLib {
                            "no CustomSmileSection given, this is unexpected...");
             }
 
-            Array discreteDeflatedAnnuities(y_.size(), 0.0);
-            Array deflatedFinalPayments;
-
             Real numeraire0 = termStructure()->discount(numeraireTime_, true);
             Real normalization =
                 termStructure()->discount(times_[idx], true) / numeraire0;
 
+            // market digital prices, evaluated in one go for each
+            // expiry and used to bracket the market swap rates below
+            std::vector<Real> strikes, digitals;
+            if (mfSec == nullptr)
+                tabulateMarketDigitalPrices(i->first, i->second, strikes,
+                                            digitals);
+
+            std::vector<Real> inputs(digitals);
+            inputs.push_back(i->second.annuity_);
+            inputs.push_back(i->second.atm_);
+            if (!dirty && keepFactors && inputs == tabulationInputs_[idx]) {
+                // nothing changed, keep the numeraire from the last run
+                QL_MFMESSAGE(modelOutputs_,
+                             "numeraire tabulation unchanged for t="
+                                 << times_[idx]);
+                modelOutputs_.digitalsAdjustmentFactors_.insert(
+                    modelOutputs_.digitalsAdjustmentFactors_.begin(),
+                    digitalsAdjustmentFactors[idx - 1]);
+                modelOutputs_.adjustmentFactors_.insert(
+                    modelOutputs_.adjustmentFactors_.begin(),
+                    adjustmentFactors[idx - 1]);
+                continue;
+            }
+            dirty = true;
+            tabulationInputs_[idx].clear();
+
+            Array discreteDeflatedAnnuities(y_.size(), 0.0);
+            Array deflatedFinalPayments;
+
             for (unsigned int k = 0; k < i->second.paymentDates_.size(); k++) {
                 deflatedFinalPayments =
                     deflatedZerobondArray(termStructure()->timeFromReference(
@@ -497,6 +550,41 @@ namespace QuantLib {
                 0.0, CubicInterpolation::Lagrange, 0.0);
             deflatedAnnuities.enableExtrapolation();
 
+            // integrals of the deflated annuity over the grid intervals
+            Array integrals(y_.size(), 0.0);
+            for (int j = y_.size() - 1; j >= 0; j--) {
+                if (j == (int)(y_.size() - 1)) {
+                    if ((modelSettings_.adjustments_ &
+                         ModelSettings::NoPayoffExtrapolation) == 0) {
+                        if ((modelSettings_.adjustments_ &
+                             ModelSettings::ExtrapolatePayoffFlat) != 0) {
+                            integrals[j] = yIntegral_->rightTail(
+                                discreteDeflatedAnnuities[j - 1], 0.0, 0.0, 0.0);
+                        } else {
+                            integrals[j] = yIntegral_->rightTail(
+                                discreteDeflatedAnnuities[j - 1],
+                                deflatedAnnuities.aCoefficients()[j - 1],
+                                deflatedAnnuities.bCoefficients()[j - 1],
+                                deflatedAnnuities.cCoefficients()[j - 1]);
+                        }
+                    }
+                } else {
+                    integrals[j] = yIntegral_->interval(
+                        j, discreteDeflatedAnnuities[j],
+                        deflatedAnnuities.aCoefficients()[j],
+                        deflatedAnnuities.bCoefficients()[j],
+                        deflatedAnnuities.cCoefficients()[j]);
+                }
+                if (integrals[j] < 0) {
+                    QL_MFMESSAGE(modelOutputs_,
+                                 "WARNING: integral for digitalPrice is "
+                                 "negative for j="
+                                     << j << " (" << integrals[j]
+                                     << ") --- reset it to zero.");
+                    integrals[j] = 0.0;
+                }
+            }
+
             Real digitalsCorrectionFactor = 1.0;
             modelOutputs_.digitalsAdjustmentFactors_.insert(
                 modelOutputs_.digitalsAdjustmentFactors_.begin(),
@@ -520,49 +608,7 @@ namespace QuantLib {
                     modelSettings_.upperRateBound_ / 2.0; // initial guess
                 for (int j = y_.size() - 1; j >= 0; j--) {
 
-                    Real integral = 0.0;
-
-                    if (j == (int)(y_.size() - 1)) {
-                        if ((modelSettings_.adjustments_ &
-                             ModelSettings::NoPayoffExtrapolation) == 0) {
-                            if ((modelSettings_.adjustments_ &
-                                 ModelSettings::ExtrapolatePayoffFlat) != 0) {
-                                integral = gaussianShiftedPolynomialIntegral(
-                                    0.0, 0.0, 0.0, 0.0,
-                                    discreteDeflatedAnnuities[j - 1], y_[j - 1],
-                                    y_[j], 100.0);
-                            } else {
-                                Real ca =
-                                    deflatedAnnuities.aCoefficients()[j - 1];
-                                Real cb =
-                                    deflatedAnnuities.bCoefficients()[j - 1];
-                                Real cc =
-                                    deflatedAnnuities.cCoefficients()[j - 1];
-                                integral = gaussianShiftedPolynomialIntegral(
-                                    0.0, cc, cb, ca,
-                                    discreteDeflatedAnnuities[j - 1], y_[j - 1],
-                                    y_[j], 100.0);
-                            }
-                        }
-                    } else {
-                        Real ca = deflatedAnnuities.aCoefficients()[j];
-                        Real cb = deflatedAnnuities.bCoefficients()[j];
-                        Real cc = deflatedAnnuities.cCoefficients()[j];
-                        integral = gaussianShiftedPolynomialIntegral(
-                            0.0, cc, cb, ca, discreteDeflatedAnnuities[j],
-                            y_[j], y_[j], y_[j + 1]);
-                    }
-
-                    if (integral < 0) {
-                        QL_MFMESSAGE(modelOutputs_,
-                                     "WARNING: integral for digitalPrice is "
-                                     "negative for j="
-                                         << j << " (" << integral
-                                         << ") --- reset it to zero.");
-                        integral = 0.0;
-                    }
-
-                    digital += integral * numeraire0 * digitalsCorrectionFactor;
+                    digital += integrals[j] * numeraire0 * digitalsCorrectionFactor;
 
                     bool check = true;
                     if ((modelSettings_.adjustments_ & ModelSettings::CustomSmile) != 0) {
@@ -576,9 +622,8 @@ namespace QuantLib {
                         swapRate = modelSettings_.upperRateBound_;
                         check = false;
                     } else {
-                        swapRate = marketSwapRate(
-                            i->first, i->second, digital, swapRate0,
-                            i->second.rawSmileSection_->shift());
+                        swapRate = marketSwapRate(i->first, i->second, digital,
+                                                  strikes, digitals);
                     }
                     if (check && j < (int)y_.size() - 1 &&
                         swapRate > swapRate0) {
@@ -620,6 +665,8 @@ namespace QuantLib {
             }
 
             numeraire_[idx]->update();
+
+            tabulationInputs_[idx] = inputs;
         }
     }
 
@@ -742,7 +789,9 @@ namespace QuantLib {
         Real tb = times_[i];
         Real dt = tb - ta;
 
-        for (Size j = 0; j < y.size(); j++) {
+        // the interpolations are only read here
+        #pragma omp parallel for if(y.size() > 1000)
+        for (long j = 0; j < (long)y.size(); j++) {
             Real yv = y[j];
             if (yv < y_.front())
                 yv = y_.front();
@@ -780,15 +829,20 @@ namespace QuantLib {
         Real stdDev_0_T = stateProcess_->stdDeviation(0.0, 0.0, T);
         Real stdDev_t_T = stateProcess_->stdDeviation(t, 0.0, T - t);
 
+        // all integration points are evaluated in one go
+        const Size n = modelSettings_.gaussHermitePoints_;
+        Array ya(y.size() * n);
         for (Size j = 0; j < y.size(); j++) {
-            Array ya(modelSettings_.gaussHermitePoints_);
-            for (Size i = 0; i < modelSettings_.gaussHermitePoints_; i++) {
-                ya[i] = (y[j] * stdDev_0_t + stdDev_t_T * normalIntegralX_[i]) /
-                        stdDev_0_T;
+            for (Size i = 0; i < n; i++) {
+                ya[j * n + i] =
+                    (y[j] * stdDev_0_t + stdDev_t_T * normalIntegralX_[i]) /
+                    stdDev_0_T;
             }
-            Array res = numeraireArray(T, ya);
-            for (Size i = 0; i < modelSettings_.gaussHermitePoints_; i++) {
-                result[j] += normalIntegralW_[i] / res[i];
+        }
+        Array res = numeraireArray(T, ya);
+        for (Size j = 0; j < y.size(); j++) {
+            for (Size i = 0; i < n; i++) {
+                result[j] += normalIntegralW_[i] / res[j * n + i];
             }
         }
 
@@ -849,6 +903,107 @@ namespace QuantLib {
         return solution;
     }
 
+    namespace {
+
+        // returns the known values at the ends of the bracket without
+        // evaluating the wrapped function again
+        template <class F>
+        class BracketedFunction {
+          public:
+            BracketedFunction(const F& f, Real x0, Real f0, Real x1, Real f1)
+            : f_(f), x0_(x0), f0_(f0), x1_(x1), f1_(f1) {}
+            Real operator()(Real x) const {
+                if (x == x0_)
+                    return f0_;
+                if (x == x1_)
+                    return f1_;
+                return f_(x);
+            }
+          private:
+            F f_;
+            Real x0_, f0_, x1_, f1_;
+        };
+
+        template <class F>
+        BracketedFunction<F> bracketedFunction(const F& f, Real x0, Real f0,
+                                               Real x1, Real f1) {
+            return BracketedFunction<F>(f, x0, f0, x1, f1);
+        }
+
+    }
+
+    Real MarkovFunctional::marketSwapRate(const Date& expiry,
+                                          const CalibrationPoint& p,
+                                          const Real digitalPrice,
+                                          const std::vector<Real>& strikes,
+                                          const std::vector<Real>& digitals) const {
+
+        // the digital prices are decreasing in the strike for arbitrage
+        // free smiles, otherwise we look for any bracket of the root
+        Size u = std::upper_bound(digitals.begin(), digitals.end(),
+                                  digitalPrice, std::greater<Real>()) -
+                 digitals.begin();
+        if (u == 0 || u == digitals.size() || digitals[u - 1] < digitalPrice ||
+            digitals[u] >= digitalPrice) {
+            for (u = 1; u < digitals.size(); u++) {
+                if (digitals[u - 1] >= digitalPrice && digitals[u] < digitalPrice)
+                    break;
+            }
+            if (u == digitals.size())
+                return marketSwapRate(expiry, p, digitalPrice,
+                                      modelSettings_.upperRateBound_ / 2.0,
+                                      p.rawSmileSection_->shift());
+        }
+        if (digitals[u - 1] == digitalPrice)
+            return strikes[u - 1];
+
+        Real xMin = strikes[u - 1], xMax = strikes[u];
+        Real fMin = digitals[u - 1] - digitalPrice,
+             fMax = digitals[u] - digitalPrice;
+        Real guess = xMin + (xMax - xMin) * fMin / (fMin - fMax);
+        if (guess <= xMin || guess >= xMax)
+            guess = 0.5 * (xMin + xMax);
+
+        ZeroHelper z(this, expiry, p, digitalPrice);
+        Brent b;
+        return b.solve(bracketedFunction(z, xMin, fMin, xMax, fMax),
+                       modelSettings_.marketRateAccuracy_, guess, xMin, xMax);
+    }
+
+    void MarkovFunctional::tabulateMarketDigitalPrices(
+        const Date& expiry,
+        const CalibrationPoint& p,
+        std::vector<Real>& strikes,
+        std::vector<Real>& digitals) const {
+
+        // the strikes are quadratically clustered around the atm level
+        // between the lower and the upper rate bound
+        Real lower =
+            modelSettings_.lowerRateBound_ - p.rawSmileSection_->shift();
+        Real upper = modelSettings_.upperRateBound_;
+        Real centre = std::min(std::max(p.atm_, lower), upper);
+        Size n = modelSettings_.yGridPoints_;
+
+        strikes.clear();
+        for (Size k = n; k > 0; k--) {
+            Real u = static_cast<Real>(k) / static_cast<Real>(n);
+            strikes.push_back(centre - (centre - lower) * u * u);
+        }
+        strikes.push_back(centre);
+        for (Size k = 1; k <= n; k++) {
+            Real u = static_cast<Real>(k) / static_cast<Real>(n);
+            strikes.push_back(centre + (upper - centre) * u * u);
+        }
+        strikes.front() = lower;
+        strikes.back() = upper;
+        strikes.erase(std::unique(strikes.begin(), strikes.end()),
+                      strikes.end());
+
+        digitals.resize(strikes.size());
+        for (Size k = 0; k < strikes.size(); k++)
+            digitals[k] = marketDigitalPrice(expiry, p, Option::Call, strikes[k]);
+    }
+
     Real MarkovFunctional::marketDigitalPrice(const Date &expiry,
                                               const CalibrationPoint &p,
                                               const Option::Type &type,
@@ -89,6 +89,11 @@ namespace QuantLib {
       by the shift so that a lower bound of 0.0 always corresponds to the lower
       bound of the shifted distribution.
 
+      When the smiles change, the numeraire is only recomputed for the
+      expiries up to the latest expiry with a changed smile, since the
+      numeraire at an expiry only depends on the smiles at this and later
+      expiries. This does not apply to custom smiles.
+
       If a custom smile is used, this will take full responsibility of inverting
       digital prices to market rates, so digitalGap, marketRateAccuracy,
       lowerRateBound, upperRateBound are irrelavant and the smile moneyness
@@ -368,7 +373,7 @@ namespace QuantLib {
         #pragma warning(pop)
         #endif
 
-        void update() override { LazyObject::update(); }
+        void update() override { Gaussian1dModel::update(); }
 
         // returns the indices of the af region from the last smile update
         std::vector<std::pair<Size, Size> > arbitrageIndices() const {
@@ -395,6 +400,7 @@ namespace QuantLib {
             // hard to avoid though.
             calculate();
             updateNumeraireTabulation();
+            flushGridCache();
             notifyObservers();
         }
 
@@ -430,6 +436,15 @@ namespace QuantLib {
                             Real digitalPrice,
                             Real guess = 0.03,
                             Real shift = 0.0) const;
+        Real marketSwapRate(const Date& expiry,
+                            const CalibrationPoint& p,
+                            Real digitalPrice,
+                            const std::vector<Real>& strikes,
+                            const std::vector<Real>& digitals) const;
+        void tabulateMarketDigitalPrices(const Date& expiry,
+                                         const CalibrationPoint& p,
+                                         std::vector<Real>& strikes,
+                                         std::vector<Real>& digitals) const;
         Real marketDigitalPrice(const Date& expiry,
                                 const CalibrationPoint& p,
                                 const Option::Type& type,
@@ -544,6 +559,13 @@ namespace QuantLib {
 
         Array normalIntegralX_;
         Array normalIntegralW_;
+        ext::shared_ptr<Gaussian1dGridIntegral> yIntegral_;
+
+        // inputs of the last numeraire tabulation, used to recompute
+        // only the expiries affected by a change (see
+        // updateNumeraireTabulation)
+        mutable std::vector<Real> tabulationModelInputs_;
+        mutable std::vector<std::vector<Real> > tabulationInputs_;
 
         mutable std::vector<std::pair<Size,Size> > arbitrageIndices_;
         std::vector<std::pair<Size,Size> > forcedArbitrageIndices_;
@@ -27,6 +27,7 @@
 
 #include <ql/timegrid.hpp>
 #include <ql/math/array.hpp>
+#include <vector>
 
 namespace QuantLib {
 
@@ -83,6 +84,24 @@ namespace QuantLib {
         virtual void partialRollback(DiscretizedAsset&,
                                      Time to) const = 0;
 
+        /*! Roll back a set of assets until the given time, performing
+            any needed adjustment.  The assets need not be at the same
+            time when the rollback starts; each of them joins the
+            rollback when its own time is reached.
+
+            The default implementation rolls back the assets one at a
+            time; derived classes can override it so that all assets
+            are rolled back in a single traversal of the lattice.
+        */
+        virtual void rollback(const std::vector<DiscretizedAsset*>&,
+                              Time to) const;
+
+        /*! Roll back a set of assets until the given time, but do not
+            perform the final adjustment.
+        */
+        virtual void partialRollback(const std::vector<DiscretizedAsset*>&,
+                                     Time to) const;
+
         //! computes the present value of an asset.
         virtual Real presentValue(DiscretizedAsset&) const = 0;
 
@@ -67,6 +67,10 @@ namespace QuantLib {
             method, thus re-enabling recalculations.
         */
         void unfreeze();
+        //! whether the cached results are up to date
+        bool isCalculated() const { return calculated_; }
+        //! whether the object was frozen
+        bool isFrozen() const { return frozen_; }
         /*! This method causes the object to forward all
             notifications, even when not calculated.  The default
             behavior is to forward the first notification received,
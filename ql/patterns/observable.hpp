@@ -133,6 +133,9 @@ namespace QuantLib {
           should be implemented in derived classes whenever applicable */
         virtual void deepUpdate();
 
+        //! the observables the instance is registered with
+        const set_type& observables() const { return observables_; }
+
       private:
         set_type observables_;
     };
@@ -296,6 +299,9 @@ namespace QuantLib {
           should be implemented in derived classes whenever applicable */
         virtual void deepUpdate();
 
+        //! the observables the instance is registered with
+        const set_type& observables() const { return observables_; }
+
       private:
 
         class Proxy {
@@ -31,16 +31,7 @@
 #include <ql/math/functional.hpp>
 #include <ql/math/solvers1d/newtonsafe.hpp>
 #include <ql/math/distributions/normaldistribution.hpp>
-#if defined(__GNUC__) && (((__GNUC__ == 4) && (__GNUC_MINOR__ >= 8)) || (__GNUC__ > 4))
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wunused-local-typedefs"
-#endif
-#include <boost/math/special_functions/atanh.hpp>
-#if defined(__GNUC__) && (((__GNUC__ == 4) && (__GNUC_MINOR__ >= 8)) || (__GNUC__ > 4))
-#pragma GCC diagnostic pop
-#endif
-
-#include <boost/math/special_functions/sign.hpp>
+#include <cmath>
 
 namespace {
     void checkParameters(QuantLib::Real strike,
@@ -84,7 +75,7 @@ namespace QuantLib {
         // since displacement is non-negative strike==0 iff displacement==0
         // so returning forward*discount is OK
         if (strike==0.0)
-            return (optionType==Option::Call ? forward*discount : 0.0);
+            return (optionType==Option::Call ? Real(forward*discount) : Real(0.0));
 
         Real d1 = std::log(forward/strike)/stdDev + 0.5*stdDev;
         Real d2 = d1 - stdDev;
@@ -124,13 +115,14 @@ namespace QuantLib {
                    "discount (" << discount << ") must be positive");
         
         if (stdDev==0.0)
-            return optionType * std::max(1.0 * boost::math::sign((forward - strike) * optionType), 0.0) * discount;
+            return (forward - strike) * optionType > 0.0 ?
+                Real(optionType * discount) : Real(0.0);
 
         forward = forward + displacement;
         strike = strike + displacement;
 
         if (strike==0.0)
-            return (optionType==Option::Call ? discount : 0.0);
+            return (optionType==Option::Call ? discount : Real(0.0));
 
         Real d1 = std::log(forward/strike)/stdDev + 0.5*stdDev;
         CumulativeNormalDistribution phi;
@@ -263,8 +255,9 @@ namespace QuantLib {
 
     namespace {
         Real Af(Real x) {
-            return 0.5*(1.0+boost::math::sign(x)
-                *std::sqrt(1.0-std::exp(-M_2_PI*x*x)));
+            // the square root vanishes at x = 0, so the sign there is moot
+            Real sign = x < 0.0 ? -1.0 : 1.0;
+            return 0.5*(1.0+sign*std::sqrt(1.0-std::exp(-M_2_PI*x*x)));
         }
     }
 
@@ -567,12 +560,12 @@ namespace QuantLib {
                                         Real displacement) {
         checkParameters(strike, forward, displacement);
         if (stdDev==0.0)
-            return (forward*optionType > strike*optionType ? 1.0 : 0.0);
+            return (forward*optionType > strike*optionType ? Real(1.0) : Real(0.0));
 
         forward = forward + displacement;
         strike = strike + displacement;
         if (strike==0.0)
-            return (optionType==Option::Call ? 1.0 : 0.0);
+            return (optionType==Option::Call ? Real(1.0) : Real(0.0));
         Real d2 = std::log(forward/strike)/stdDev - 0.5*stdDev;
         CumulativeNormalDistribution phi;
         return phi(optionType*d2);
@@ -595,12 +588,12 @@ namespace QuantLib {
                         Real displacement) {
         checkParameters(strike, forward, displacement);
         if (stdDev==0.0)
-            return (forward*optionType < strike*optionType ? 1.0 : 0.0);
+            return (forward*optionType < strike*optionType ? Real(1.0) : Real(0.0));
 
         forward = forward + displacement;
         strike = strike + displacement;
         if (strike==0.0)
-            return (optionType==Option::Call ? 1.0 : 0.0);
+            return (optionType==Option::Call ? Real(1.0) : Real(0.0));
         Real d1 = std::log(forward/strike)/stdDev + 0.5*stdDev;
         CumulativeNormalDistribution phi;
         return phi(optionType*d1);
@@ -708,7 +701,7 @@ namespace QuantLib {
                    "discount (" << discount << ") must be positive");
         Real d = (forward-strike)*optionType, h = d/stdDev;
         if (stdDev==0.0)
-            return discount*std::max(d, 0.0);
+            return discount*std::max(d, Real(0.0));
         CumulativeNormalDistribution phi;
         Real result = discount*(stdDev*phi.derivative(h) + d*phi(h));
         QL_ENSURE(result>=0.0,
@@ -737,7 +730,8 @@ namespace QuantLib {
         QL_REQUIRE(discount>0.0,
                    "discount (" << discount << ") must be positive");
         if (stdDev==0.0)
-            return optionType * std::max(1.0 * boost::math::sign((forward - strike) * optionType), 0.0) * discount;
+            return (forward - strike) * optionType > 0.0 ?
+                Real(optionType * discount) : Real(0.0);
         Real d = (forward-strike)*optionType, h = d/stdDev;
         CumulativeNormalDistribution phi;
         return optionType * phi(h) * discount;
@@ -815,10 +809,10 @@ namespace QuantLib {
         QL_REQUIRE(nu>-1.0 || close_enough(nu,-1.0),
                      "nu (" << nu << ") must be >= -1.0");
 
-        nu = std::max(-1.0 + QL_EPSILON, std::min(nu,1.0 - QL_EPSILON));
+        nu = std::max(Real(-1.0 + QL_EPSILON), std::min(nu, Real(1.0 - QL_EPSILON)));
 
         // nu / arctanh(nu) -> 1 as nu -> 0
-        Real eta = (std::fabs(nu) < SQRT_QL_EPSILON) ? 1.0 : nu / boost::math::atanh(nu);
+        Real eta = (std::fabs(nu) < SQRT_QL_EPSILON) ? Real(1.0) : Real(nu / std::atanh(nu));
 
         Real heta = h(eta);
 
@@ -864,7 +858,7 @@ namespace QuantLib {
                    "stdDev (" << stdDev << ") must be non-negative");
         Real d = (forward-strike)*optionType, h = d/stdDev;
         if (stdDev==0.0)
-            return std::max(d, 0.0);
+            return std::max(d, Real(0.0));
         CumulativeNormalDistribution phi;
         Real result = phi(h);
         return result;
@@ -2,6 +2,7 @@
 /* Add the files to be included into Makefile.am instead. */
 
 #include <ql/pricingengines/credit/integralcdsengine.hpp>
+#include <ql/pricingengines/credit/isdacdsbatch.hpp>
 #include <ql/pricingengines/credit/isdacdsengine.hpp>
 #include <ql/pricingengines/credit/midpointcdsengine.hpp>
 
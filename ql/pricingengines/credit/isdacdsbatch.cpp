@@ -0,0 +1,517 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+#include <ql/pricingengines/credit/isdacdsbatch.hpp>
+#include <ql/cashflows/fixedratecoupon.hpp>
+#include <ql/event.hpp>
+#include <ql/math/interpolations/loginterpolation.hpp>
+#include <ql/math/solvers1d/brent.hpp>
+#include <ql/termstructures/credit/interpolatedsurvivalprobabilitycurve.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+#include <ql/time/schedule.hpp>
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <map>
+
+namespace QuantLib {
+
+    namespace {
+
+        Size nodeIndex(const Date& d, std::map<Date, Size>& indices) {
+            std::map<Date, Size>::const_iterator i = indices.find(d);
+            if (i != indices.end())
+                return i->second;
+            Size index = indices.size();
+            indices[d] = index;
+            return index;
+        }
+
+        // hazard rates searched by the bootstrap
+        const Real maxHazardRate = 50.0;
+
+    }
+
+    // difference between the quoted and the model value of the CDS
+    // quoted for a pillar, as a function of the hazard rate before it
+    class IsdaCdsBatch::PillarError {
+      public:
+        PillarError(const IsdaCdsBatch& batch,
+                    Size name,
+                    Size pillar,
+                    std::vector<Real>& logSurvival,
+                    std::vector<Probability>& q)
+        : batch_(batch), name_(name), pillar_(pillar),
+          logSurvival_(logSurvival), q_(q),
+          dt_(batch.pillarTimes_[pillar+1] - batch.pillarTimes_[pillar]) {}
+        Real operator()(Real hazardRate) const {
+            logSurvival_[pillar_+1] = logSurvival_[pillar_] - hazardRate*dt_;
+            batch_.survival(pillar_, logSurvival_, q_);
+            Real protection, annuity;
+            batch_.legValues(pillar_, q_, protection, annuity);
+            Size i = name_*batch_.legs_.size() + pillar_;
+            return (1.0 - batch_.recoveries_[name_]) * protection
+                - batch_.runningSpreads_[i] * annuity
+                + batch_.upfronts_[i] * batch_.legs_[pillar_].upfrontDiscount;
+        }
+      private:
+        const IsdaCdsBatch& batch_;
+        Size name_, pillar_;
+        std::vector<Real>& logSurvival_;
+        std::vector<Probability>& q_;
+        Time dt_;
+    };
+
+    IsdaCdsBatch::IsdaCdsBatch(
+                    const std::vector<Period>& tenors,
+                    const Handle<YieldTermStructure>& discountCurve,
+                    Integer settlementDays,
+                    const Calendar& calendar,
+                    Frequency frequency,
+                    BusinessDayConvention paymentConvention,
+                    DateGeneration::Rule rule,
+                    const DayCounter& dayCounter,
+                    const DayCounter& lastPeriodDayCounter,
+                    bool rebatesAccrual,
+                    Natural upfrontSettlementDays,
+                    IsdaCdsEngine::NumericalFix numericalFix,
+                    IsdaCdsEngine::AccrualBias accrualBias,
+                    IsdaCdsEngine::ForwardsInCouponPeriod forwardsInCouponPeriod)
+    : tenors_(tenors), discountCurve_(discountCurve),
+      settlementDays_(settlementDays), calendar_(calendar),
+      frequency_(frequency), paymentConvention_(paymentConvention),
+      rule_(rule), dayCounter_(dayCounter),
+      lastPeriodDayCounter_(lastPeriodDayCounter),
+      rebatesAccrual_(rebatesAccrual),
+      upfrontSettlementDays_(upfrontSettlementDays),
+      numericalFix_(numericalFix), accrualBias_(accrualBias),
+      forwardsInCouponPeriod_(forwardsInCouponPeriod),
+      legsLaidOut_(false) {
+
+        QL_REQUIRE(!tenors.empty(), "no tenors given");
+        QL_REQUIRE(numericalFix_ == IsdaCdsEngine::None ||
+                   numericalFix_ == IsdaCdsEngine::Taylor,
+                   "numerical fix must be None or Taylor");
+        QL_REQUIRE(accrualBias_ == IsdaCdsEngine::HalfDayBias ||
+                   accrualBias_ == IsdaCdsEngine::NoBias,
+                   "accrual bias must be HalfDayBias or NoBias");
+        QL_REQUIRE(forwardsInCouponPeriod_ == IsdaCdsEngine::Flat ||
+                   forwardsInCouponPeriod_ == IsdaCdsEngine::Piecewise,
+                   "forwards in coupon period must be Flat or Piecewise");
+
+        registerWith(discountCurve_);
+        registerWith(Settings::instance().evaluationDate());
+        // checks the conventions and the curve early
+        layOutLegs();
+    }
+
+    void IsdaCdsBatch::layOutLegs() const {
+        if (legsLaidOut_)
+            return;
+
+        evaluationDate_ = Settings::instance().evaluationDate();
+        Actual365Fixed dc;
+        QL_REQUIRE(!discountCurve_.empty(), "no discount term structure set");
+        QL_REQUIRE(discountCurve_->dayCounter() == dc,
+                   "yield term structure day counter ("
+                   << discountCurve_->dayCounter()
+                   << ") should be Act/365(Fixed)");
+        QL_REQUIRE(discountCurve_->referenceDate() == evaluationDate_,
+                   "yield term structure reference date ("
+                   << discountCurve_->referenceDate()
+                   << " should be evaluation date ("
+                   << evaluationDate_ << ")");
+        maturities_.clear();
+        pillars_.clear();
+        legs_.assign(tenors_.size(), Legs());
+        pillarTimes_.clear();
+
+        // the quoted contracts, built as the CDS helpers do, on unit
+        // notional and spread
+        const Date protectionStart = evaluationDate_ + settlementDays_;
+        const Date upfrontDate = calendar_.advance(evaluationDate_,
+                                                  upfrontSettlementDays_, Days,
+                                                  paymentConvention_);
+        std::vector<ext::shared_ptr<CreditDefaultSwap> > swaps;
+        for (Size k=0; k<tenors_.size(); ++k) {
+            // same dates as in CdsHelper::initializeDates()
+            Date startDate = protectionStart;
+            if (rule_ != DateGeneration::CDS &&
+                rule_ != DateGeneration::CDS2015)
+                startDate = calendar_.adjust(startDate, paymentConvention_);
+            Date endDate;
+            if (rule_ == DateGeneration::CDS2015 ||
+                rule_ == DateGeneration::CDS ||
+                rule_ == DateGeneration::OldCDS)
+                endDate = cdsMaturity(evaluationDate_, tenors_[k], rule_);
+            else
+                endDate = protectionStart + tenors_[k];
+            Schedule schedule = MakeSchedule().from(startDate)
+                                              .to(endDate)
+                                              .withFrequency(frequency_)
+                                              .withCalendar(calendar_)
+                                              .withConvention(paymentConvention_)
+                                              .withTerminationDateConvention(
+                                                                   Unadjusted)
+                                              .withRule(rule_);
+            maturities_.push_back(schedule.dates().back());
+            pillars_.push_back(calendar_.adjust(schedule.dates().back(),
+                                               paymentConvention_) + 1);
+            QL_REQUIRE(k == 0 || pillars_[k] > pillars_[k-1],
+                       "tenors must be increasing (" << tenors_[k-1]
+                       << " and " << tenors_[k] << " given)");
+            swaps.push_back(ext::make_shared<CreditDefaultSwap>(
+                Protection::Buyer, 1.0, 0.0, 1.0, schedule, paymentConvention_,
+                dayCounter_, true, true, protectionStart, upfrontDate,
+                ext::shared_ptr<Claim>(), lastPeriodDayCounter_,
+                rebatesAccrual_, evaluationDate_));
+        }
+
+        // nodes of the ISDA integrals, from both curves
+        std::vector<Date> yDates =
+            detail::isdaYieldCurveDates(**discountCurve_);
+        std::vector<Date> cDates(1, evaluationDate_);
+        cDates.insert(cDates.end(), pillars_.begin(), pillars_.end());
+        std::vector<Date> curveNodes;
+        std::set_union(yDates.begin(), yDates.end(),
+                       cDates.begin(), cDates.end(),
+                       std::back_inserter(curveNodes));
+
+        const Date effectiveProtectionStart =
+            std::max<Date>(protectionStart, evaluationDate_ + 1);
+        const Real bias = accrualBias_ == IsdaCdsEngine::HalfDayBias ?
+            1.0/730.0 : 0.0;
+
+        std::map<Date, Size> indices;
+        for (Size k=0; k<tenors_.size(); ++k) {
+            Legs& legs = legs_[k];
+            const Date maturity = maturities_[k];
+
+            // protection leg
+            legs.protectionNodes.push_back(
+                nodeIndex(effectiveProtectionStart - 1, indices));
+            std::vector<Date>::const_iterator it =
+                std::upper_bound(curveNodes.begin(), curveNodes.end(),
+                                 effectiveProtectionStart);
+            for (; it != curveNodes.end(); ++it) {
+                if (*it > maturity) {
+                    legs.protectionNodes.push_back(
+                        nodeIndex(maturity, indices));
+                    break;
+                }
+                legs.protectionNodes.push_back(nodeIndex(*it, indices));
+            }
+
+            // premium leg and default accruals
+            legs.accrualOffsets.push_back(0);
+            const Leg& coupons = swaps[k]->coupons();
+            for (Size i=0; i<coupons.size(); ++i) {
+                ext::shared_ptr<FixedRateCoupon> coupon =
+                    ext::dynamic_pointer_cast<FixedRateCoupon>(coupons[i]);
+                if (!coupon->hasOccurred(effectiveProtectionStart, false)) {
+                    legs.premiumAmounts.push_back(coupon->amount());
+                    legs.premiumDiscounts.push_back(
+                        discountCurve_->discount(coupon->date()));
+                    legs.premiumNodes.push_back(
+                        nodeIndex(coupon->date() - 1, indices));
+                }
+                if (!detail::simple_event(coupon->accrualEndDate())
+                         .hasOccurred(effectiveProtectionStart, false)) {
+                    Date start = std::max<Date>(coupon->accrualStartDate(),
+                                                effectiveProtectionStart) - 1;
+                    Date end = coupon->date() - 1;
+                    legs.accrualStartTimes.push_back(
+                        discountCurve_->timeFromReference(
+                                        coupon->accrualStartDate() - 1) - bias);
+                    legs.accrualNodes.push_back(nodeIndex(start, indices));
+                    if (forwardsInCouponPeriod_ == IsdaCdsEngine::Piecewise) {
+                        std::vector<Date>::const_iterator it0 =
+                            std::upper_bound(curveNodes.begin(),
+                                             curveNodes.end(), start);
+                        std::vector<Date>::const_iterator it1 =
+                            std::lower_bound(curveNodes.begin(),
+                                             curveNodes.end(), end);
+                        for (; it0 < it1; ++it0)
+                            legs.accrualNodes.push_back(
+                                nodeIndex(*it0, indices));
+                    }
+                    legs.accrualNodes.push_back(nodeIndex(end, indices));
+                    legs.accrualOffsets.push_back(legs.accrualNodes.size());
+                }
+            }
+
+            // upfront and accrual rebate
+            const ext::shared_ptr<SimpleCashFlow>& rebate =
+                swaps[k]->accrualRebate();
+            legs.rebate = 0.0;
+            if (rebate != nullptr && rebate->amount() != 0.0 &&
+                !rebate->hasOccurred(evaluationDate_, false))
+                legs.rebate = rebate->amount()
+                    * discountCurve_->discount(rebate->date());
+            const ext::shared_ptr<SimpleCashFlow>& upfront =
+                swaps[k]->upfrontPayment();
+            legs.upfrontDiscount =
+                upfront->hasOccurred(evaluationDate_, false) ? 0.0 :
+                discountCurve_->discount(upfront->date());
+        }
+
+        // common nodes: times, discounts and position between the pillars
+        pillarTimes_.push_back(0.0);
+        for (Size k=0; k<pillars_.size(); ++k)
+            pillarTimes_.push_back(dc.yearFraction(evaluationDate_,
+                                                   pillars_[k]));
+        nodeTimes_.resize(indices.size());
+        nodeDiscounts_.resize(indices.size());
+        nodeSegments_.resize(indices.size());
+        nodeWeights_.resize(indices.size());
+        for (std::map<Date, Size>::const_iterator i = indices.begin();
+             i != indices.end(); ++i) {
+            Time t = discountCurve_->timeFromReference(i->first);
+            nodeTimes_[i->second] = t;
+            nodeDiscounts_[i->second] = discountCurve_->discount(i->first);
+            // beyond the last pillar, the last hazard rate is extrapolated
+            Size segment = std::upper_bound(pillarTimes_.begin() + 1,
+                                            pillarTimes_.end() - 1, t)
+                - pillarTimes_.begin() - 1;
+            nodeSegments_[i->second] = segment;
+            nodeWeights_[i->second] = (t - pillarTimes_[segment]) /
+                (pillarTimes_[segment+1] - pillarTimes_[segment]);
+        }
+        legsLaidOut_ = true;
+    }
+
+    Size IsdaCdsBatch::addName(const std::vector<Rate>& spreads,
+                               Real recoveryRate) {
+        QL_REQUIRE(spreads.size() == tenors_.size(),
+                   "wrong number of spreads (" << spreads.size() << ", "
+                   << tenors_.size() << " required)");
+        QL_REQUIRE(recoveryRate >= 0.0 && recoveryRate < 1.0,
+                   "recovery rate (" << recoveryRate << ") out of range");
+        recoveries_.push_back(recoveryRate);
+        runningSpreads_.insert(runningSpreads_.end(),
+                               spreads.begin(), spreads.end());
+        upfronts_.resize(upfronts_.size() + tenors_.size(), 0.0);
+        // the legs are still valid, only the results are not
+        LazyObject::update();
+        return recoveries_.size() - 1;
+    }
+
+    Size IsdaCdsBatch::addName(const std::vector<Rate>& upfronts,
+                               Rate runningSpread,
+                               Real recoveryRate) {
+        QL_REQUIRE(upfronts.size() == tenors_.size(),
+                   "wrong number of upfronts (" << upfronts.size() << ", "
+                   << tenors_.size() << " required)");
+        QL_REQUIRE(recoveryRate >= 0.0 && recoveryRate < 1.0,
+                   "recovery rate (" << recoveryRate << ") out of range");
+        recoveries_.push_back(recoveryRate);
+        runningSpreads_.resize(runningSpreads_.size() + tenors_.size(),
+                               runningSpread);
+        upfronts_.insert(upfronts_.end(), upfronts.begin(), upfronts.end());
+        // the legs are still valid, only the results are not
+        LazyObject::update();
+        return recoveries_.size() - 1;
+    }
+
+    void IsdaCdsBatch::survival(Size tenor,
+                                const std::vector<Real>& logSurvival,
+                                std::vector<Probability>& q) const {
+        const Legs& legs = legs_[tenor];
+        const std::vector<Size>* nodes[] = {
+            &legs.protectionNodes, &legs.premiumNodes, &legs.accrualNodes
+        };
+        for (Size l=0; l<3; ++l) {
+            for (Size i=0; i<nodes[l]->size(); ++i) {
+                Size n = (*nodes[l])[i];
+                Size s = nodeSegments_[n];
+                q[n] = std::exp(logSurvival[s] + nodeWeights_[n] *
+                                (logSurvival[s+1] - logSurvival[s]));
+            }
+        }
+    }
+
+    void IsdaCdsBatch::legValues(Size tenor,
+                                 const std::vector<Probability>& q,
+                                 Real& protection,
+                                 Real& annuity) const {
+        // same integrals as in IsdaCdsEngine
+        const Legs& legs = legs_[tenor];
+        const bool taylor = numericalFix_ == IsdaCdsEngine::Taylor;
+
+        protection = 0.0;
+        const std::vector<Size>& nodes = legs.protectionNodes;
+        for (Size i=1; i<nodes.size(); ++i)
+            protection += detail::isdaProtectionIntegral(
+                nodeDiscounts_[nodes[i-1]], q[nodes[i-1]],
+                nodeDiscounts_[nodes[i]], q[nodes[i]], taylor);
+
+        Real premium = 0.0;
+        for (Size i=0; i<legs.premiumAmounts.size(); ++i)
+            premium += legs.premiumAmounts[i] * legs.premiumDiscounts[i]
+                * q[legs.premiumNodes[i]];
+
+        Real defaultAccrual = 0.0;
+        for (Size c=0; c<legs.accrualStartTimes.size(); ++c) {
+            Time tstart = legs.accrualStartTimes[c];
+            for (Size j=legs.accrualOffsets[c]+1;
+                 j<legs.accrualOffsets[c+1]; ++j) {
+                Size n0 = legs.accrualNodes[j-1], n1 = legs.accrualNodes[j];
+                defaultAccrual += detail::isdaAccrualIntegral(
+                    tstart,
+                    nodeTimes_[n0], nodeDiscounts_[n0], q[n0],
+                    nodeTimes_[n1], nodeDiscounts_[n1], q[n1], taylor);
+            }
+        }
+
+        annuity = premium + defaultAccrual * 365.0 / 360.0 - legs.rebate;
+    }
+
+    void IsdaCdsBatch::bootstrapName(Size name) const {
+        const Size pillars = legs_.size();
+        std::vector<Real> logSurvival(pillars + 1, 0.0);
+        std::vector<Probability> q(nodeTimes_.size());
+        Brent solver;
+        for (Size k=0; k<pillars; ++k) {
+            PillarError error(*this, name, k, logSurvival, q);
+            Size i = name*pillars + k;
+            Real guess = std::min(
+                std::max(runningSpreads_[i], 1.0e-4)
+                    / (1.0 - recoveries_[name]), maxHazardRate);
+            try {
+                Real hazardRate = solver.solve(error, 1.0e-12, guess,
+                                               0.0, maxHazardRate);
+                // sets the solution in the log-survival probabilities
+                error(hazardRate);
+            } catch (std::exception& e) {
+                QL_FAIL("failed to bootstrap name #" << name
+                        << " at pillar " << pillars_[k] << ": " << e.what());
+            }
+        }
+        std::copy(logSurvival.begin(), logSurvival.end(),
+                  logSurvival_.begin() + name*(pillars + 1));
+    }
+
+    const std::vector<Date>& IsdaCdsBatch::maturities() const {
+        layOutLegs();
+        return maturities_;
+    }
+
+    const std::vector<Date>& IsdaCdsBatch::pillarDates() const {
+        layOutLegs();
+        return pillars_;
+    }
+
+    void IsdaCdsBatch::update() {
+        legsLaidOut_ = false;
+        LazyObject::update();
+    }
+
+    void IsdaCdsBatch::performCalculations() const {
+        layOutLegs();
+        const Size n = names();
+        logSurvival_.assign(n * (legs_.size() + 1), 0.0);
+        std::vector<std::exception_ptr> errors(n);
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for schedule(dynamic)
+        #endif
+        for (long i=0; i<long(n); ++i) {
+            try {
+                bootstrapName(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+        for (Size i=0; i<n; ++i) {
+            if (errors[i])
+                std::rethrow_exception(errors[i]);
+        }
+    }
+
+    Disposable<std::vector<Probability> >
+    IsdaCdsBatch::survivalProbabilities(Size name) const {
+        QL_REQUIRE(name < names(), "name #" << name << " not available ("
+                   << names() << " names given)");
+        bootstrap();
+        const Size pillars = legs_.size();
+        std::vector<Probability> result(pillars);
+        for (Size k=0; k<pillars; ++k)
+            result[k] = std::exp(logSurvival_[name*(pillars + 1) + k + 1]);
+        return result;
+    }
+
+    ext::shared_ptr<DefaultProbabilityTermStructure>
+    IsdaCdsBatch::defaultCurve(Size name) const {
+        std::vector<Probability> probabilities = survivalProbabilities(name);
+        probabilities.insert(probabilities.begin(), 1.0);
+        std::vector<Date> dates(1, evaluationDate_);
+        dates.insert(dates.end(), pillars_.begin(), pillars_.end());
+        return ext::make_shared<
+            InterpolatedSurvivalProbabilityCurve<LogLinear> >(
+                dates, probabilities, Actual365Fixed());
+    }
+
+    Disposable<std::vector<Rate> >
+    IsdaCdsBatch::fairSpreads(Size tenor) const {
+        QL_REQUIRE(tenor < tenors_.size(), "tenor #" << tenor
+                   << " not available (" << tenors_.size() << " tenors given)");
+        bootstrap();
+        const Size n = names(), pillars = legs_.size();
+        std::vector<Rate> result(n);
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for
+        #endif
+        for (long i=0; i<long(n); ++i) {
+            std::vector<Real> logSurvival(
+                logSurvival_.begin() + i*(pillars + 1),
+                logSurvival_.begin() + (i + 1)*(pillars + 1));
+            std::vector<Probability> q(nodeTimes_.size());
+            survival(tenor, logSurvival, q);
+            Real protection, annuity;
+            legValues(tenor, q, protection, annuity);
+            result[i] = (1.0 - recoveries_[i]) * protection / annuity;
+        }
+        return result;
+    }
+
+    Disposable<std::vector<Rate> >
+    IsdaCdsBatch::fairUpfronts(Size tenor, Rate runningSpread) const {
+        QL_REQUIRE(tenor < tenors_.size(), "tenor #" << tenor
+                   << " not available (" << tenors_.size() << " tenors given)");
+        bootstrap();
+        QL_REQUIRE(legs_[tenor].upfrontDiscount != 0.0,
+                   "upfront already paid");
+        const Size n = names(), pillars = legs_.size();
+        std::vector<Rate> result(n);
+        #if !defined(QL_ENABLE_SESSIONS)
+        #pragma omp parallel for
+        #endif
+        for (long i=0; i<long(n); ++i) {
+            std::vector<Real> logSurvival(
+                logSurvival_.begin() + i*(pillars + 1),
+                logSurvival_.begin() + (i + 1)*(pillars + 1));
+            std::vector<Probability> q(nodeTimes_.size());
+            survival(tenor, logSurvival, q);
+            Real protection, annuity;
+            legValues(tenor, q, protection, annuity);
+            result[i] = (runningSpread * annuity
+                         - (1.0 - recoveries_[i]) * protection)
+                / legs_[tenor].upfrontDiscount;
+        }
+        return result;
+    }
+
+}
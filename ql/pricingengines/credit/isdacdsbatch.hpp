@@ -0,0 +1,190 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file isdacdsbatch.hpp
+    \brief ISDA pricing and bootstrap of many names with common conventions
+*/
+
+#ifndef quantlib_isda_cds_batch_hpp
+#define quantlib_isda_cds_batch_hpp
+
+#include <ql/pricingengines/credit/isdacdsengine.hpp>
+#include <ql/patterns/lazyobject.hpp>
+#include <ql/time/calendars/weekendsonly.hpp>
+#include <ql/time/daycounters/actual360.hpp>
+#include <ql/utilities/disposable.hpp>
+#include <vector>
+
+namespace QuantLib {
+
+    //! ISDA-standard CDS pricing and hazard-curve bootstrap for many names
+    /*! All names share the quoted tenors and the CDS conventions, so
+        the premium and protection legs are laid out once: coupon
+        schedules, integration nodes and discount factors are computed
+        together and stored in contiguous arrays shared by all names.
+        Each name then only needs its survival probabilities on those
+        nodes, and is bootstrapped on its own, in parallel with the
+        others, with the analytic leg integrals of the ISDA standard
+        model as implemented by IsdaCdsEngine.
+
+        The bootstrapped curves are log-linear in the survival
+        probability (i.e., piecewise-flat hazard rates) with pillars at
+        the same dates as the ones of a PiecewiseDefaultCurve built on
+        SpreadCdsHelper or UpfrontCdsHelper instances using the ISDA
+        model; the curves returned by defaultCurve() can be passed to
+        IsdaCdsEngine.
+
+        The legs are laid out again, and the names bootstrapped again,
+        when the evaluation date or the discount curve change.
+
+        \test the survival probabilities are checked against the ones
+              of piecewise curves bootstrapped on CDS helpers, and the
+              fair spreads and upfronts against IsdaCdsEngine.
+    */
+    class IsdaCdsBatch : public LazyObject {
+      public:
+        IsdaCdsBatch(
+            const std::vector<Period>& tenors,
+            const Handle<YieldTermStructure>& discountCurve,
+            Integer settlementDays = 0,
+            const Calendar& calendar = WeekendsOnly(),
+            Frequency frequency = Quarterly,
+            BusinessDayConvention paymentConvention = Following,
+            DateGeneration::Rule rule = DateGeneration::CDS2015,
+            const DayCounter& dayCounter = Actual360(),
+            const DayCounter& lastPeriodDayCounter = Actual360(true),
+            bool rebatesAccrual = true,
+            Natural upfrontSettlementDays = 3,
+            IsdaCdsEngine::NumericalFix numericalFix = IsdaCdsEngine::Taylor,
+            IsdaCdsEngine::AccrualBias accrualBias = IsdaCdsEngine::HalfDayBias,
+            IsdaCdsEngine::ForwardsInCouponPeriod forwardsInCouponPeriod =
+                                                    IsdaCdsEngine::Piecewise);
+        //! \name Names
+        //@{
+        //! adds a name quoted as par spreads, one for each tenor
+        Size addName(const std::vector<Rate>& spreads, Real recoveryRate);
+        //! adds a name quoted as upfronts on a fixed running spread
+        Size addName(const std::vector<Rate>& upfronts,
+                     Rate runningSpread,
+                     Real recoveryRate);
+        Size names() const { return recoveries_.size(); }
+        //@}
+        //! \name Legs
+        //@{
+        //! protection end dates of the quoted CDS
+        const std::vector<Date>& maturities() const;
+        //! pillar dates of the bootstrapped curves
+        const std::vector<Date>& pillarDates() const;
+        //@}
+        //! \name Observer interface
+        //@{
+        void update() override;
+        //@}
+        //! \name Results
+        //@{
+        //! bootstraps all names; called by the inspectors when needed
+        void bootstrap() const { calculate(); }
+        //! survival probabilities of a name at the pillar dates
+        Disposable<std::vector<Probability> >
+        survivalProbabilities(Size name) const;
+        /*! default curve of a name, with nodes at the evaluation date
+            and at the pillar dates.
+        */
+        ext::shared_ptr<DefaultProbabilityTermStructure>
+        defaultCurve(Size name) const;
+        //! fair spreads of all names for a quoted tenor
+        Disposable<std::vector<Rate> > fairSpreads(Size tenor) const;
+        /*! fair upfronts of all names for a quoted tenor and a running
+            spread, for the protection buyer as in CreditDefaultSwap.
+        */
+        Disposable<std::vector<Rate> > fairUpfronts(Size tenor,
+                                                    Rate runningSpread) const;
+        //@}
+      private:
+        // ISDA leg integrals of a tenor over the common nodes
+        struct Legs {
+            // protection leg: indices of the nodes, the first one being
+            //   the day before the protection start
+            std::vector<Size> protectionNodes;
+            // premium leg: per unit spread and notional
+            std::vector<Real> premiumAmounts;
+            std::vector<Size> premiumNodes;  // payment date - 1
+            std::vector<DiscountFactor> premiumDiscounts;
+            // default accrual: the nodes of coupon c are
+            //   accrualNodes[accrualOffsets[c]...accrualOffsets[c+1]-1]
+            std::vector<Size> accrualNodes, accrualOffsets;
+            std::vector<Time> accrualStartTimes;
+            // discounted accrual rebate per unit spread and notional
+            Real rebate;
+            DiscountFactor upfrontDiscount;
+        };
+        class PillarError;
+        void performCalculations() const override;
+        // lays out the legs at the evaluation date, if not done already
+        void layOutLegs() const;
+        /* survival probabilities on the nodes needed by the legs of the
+           given tenor, from the log-survival probabilities at the pillars
+           (with the evaluation date first)
+        */
+        void survival(Size tenor,
+                      const std::vector<Real>& logSurvival,
+                      std::vector<Probability>& q) const;
+        // protection leg per unit loss, and risky annuity net of the
+        //   accrual rebate per unit spread
+        void legValues(Size tenor,
+                       const std::vector<Probability>& q,
+                       Real& protection,
+                       Real& annuity) const;
+        void bootstrapName(Size name) const;
+
+        // conventions
+        std::vector<Period> tenors_;
+        Handle<YieldTermStructure> discountCurve_;
+        Integer settlementDays_;
+        Calendar calendar_;
+        Frequency frequency_;
+        BusinessDayConvention paymentConvention_;
+        DateGeneration::Rule rule_;
+        DayCounter dayCounter_, lastPeriodDayCounter_;
+        bool rebatesAccrual_;
+        Natural upfrontSettlementDays_;
+        IsdaCdsEngine::NumericalFix numericalFix_;
+        IsdaCdsEngine::AccrualBias accrualBias_;
+        IsdaCdsEngine::ForwardsInCouponPeriod forwardsInCouponPeriod_;
+        // legs, laid out at the evaluation date
+        mutable bool legsLaidOut_;
+        mutable Date evaluationDate_;
+        mutable std::vector<Date> maturities_, pillars_;
+        mutable std::vector<Legs> legs_;
+        // common nodes, in contiguous arrays
+        mutable std::vector<Time> nodeTimes_;
+        mutable std::vector<DiscountFactor> nodeDiscounts_;
+        // log-linear interpolation between the pillars (with the
+        //   evaluation date first): segment and weight
+        mutable std::vector<Time> pillarTimes_;
+        mutable std::vector<Size> nodeSegments_;
+        mutable std::vector<Real> nodeWeights_;
+        // quotes
+        std::vector<Real> recoveries_;
+        std::vector<Rate> runningSpreads_, upfronts_;  // name-major
+        // results: log-survival probabilities at the pillars, name-major
+        mutable std::vector<Real> logSurvival_;
+    };
+
+}
+
+#endif
@@ -31,6 +31,28 @@
 
 namespace QuantLib {
 
+    namespace detail {
+
+        std::vector<Date> isdaYieldCurveDates(const YieldTermStructure& curve) {
+            if (const auto* castY1 =
+                    dynamic_cast<const InterpolatedDiscountCurve<LogLinear>*>(&curve)) {
+                return castY1->dates();
+            } else if (const auto* castY2 =
+                           dynamic_cast<const InterpolatedForwardCurve<BackwardFlat>*>(&curve)) {
+                return castY2->dates();
+            } else if (const auto* castY3 =
+                           dynamic_cast<const InterpolatedForwardCurve<ForwardFlat>*>(&curve)) {
+                return castY3->dates();
+            } else if (dynamic_cast<const FlatForward*>(&curve) != nullptr) {
+                // no dates to extract
+                return std::vector<Date>();
+            } else {
+                QL_FAIL("Yield curve must be flat forward interpolated");
+            }
+        }
+
+    }
+
     IsdaCdsEngine::IsdaCdsEngine(const Handle<DefaultProbabilityTermStructure>& probability,
                                  Real recoveryRate,
                                  const Handle<YieldTermStructure>& discountCurve,
@@ -99,26 +121,7 @@ namespace QuantLib {
             std::max<Date>(arguments_.protectionStart, evalDate + 1);
 
         // collect nodes from both curves and sort them
-        std::vector<Date> yDates, cDates;
-
-        if(ext::shared_ptr<InterpolatedDiscountCurve<LogLinear> > castY1 =
-            ext::dynamic_pointer_cast<
-                InterpolatedDiscountCurve<LogLinear> >(*discountCurve_)) {
-            yDates = castY1->dates();
-        } else if(ext::shared_ptr<InterpolatedForwardCurve<BackwardFlat> >
-        castY2 = ext::dynamic_pointer_cast<
-            InterpolatedForwardCurve<BackwardFlat> >(*discountCurve_)) {
-            yDates = castY2->dates();
-        } else if(ext::shared_ptr<InterpolatedForwardCurve<ForwardFlat> >
-        castY3 = ext::dynamic_pointer_cast<
-            InterpolatedForwardCurve<ForwardFlat> >(*discountCurve_)) {
-            yDates = castY3->dates();
-        } else if(ext::shared_ptr<FlatForward> castY4 =
-            ext::dynamic_pointer_cast<FlatForward>(*discountCurve_)) {
-            // no dates to extract
-        } else {
-            QL_FAIL("Yield curve must be flat forward interpolated");
-        }
+        std::vector<Date> yDates = detail::isdaYieldCurveDates(**discountCurve_), cDates;
 
         if(ext::shared_ptr<InterpolatedSurvivalProbabilityCurve<LogLinear> >
         castC1 = ext::dynamic_pointer_cast<
@@ -145,7 +148,6 @@ namespace QuantLib {
         if(nodes.empty()){
             nodes.push_back(maturity);
         }
-        const Real nFix = (numericalFix_ == None ? 1E-50 : 0.0);
 
         // protection leg pricing (npv is always negative at this stage)
         Real protectionNpv = 0.0;
@@ -167,19 +169,8 @@ namespace QuantLib {
             Real P1 = discountCurve_->discount(d1);
             Real Q1 = probability_->survivalProbability(d1);
 
-            Real fhat = std::log(P0) - std::log(P1);
-            Real hhat = std::log(Q0) - std::log(Q1);
-            Real fhphh = fhat + hhat;
-
-            if (fhphh < 1E-4 && numericalFix_ == Taylor) {
-                Real fhphhq = fhphh * fhphh;
-                protectionNpv +=
-                    P0 * Q0 * hhat * (1.0 - 0.5 * fhphh + 1.0 / 6.0 * fhphhq -
-                                      1.0 / 24.0 * fhphhq * fhphh +
-                                      1.0 / 120 * fhphhq * fhphhq);
-            } else {
-                protectionNpv += hhat / (fhphh + nFix) * (P0 * Q0 - P1 * Q1);
-            }
+            protectionNpv += detail::isdaProtectionIntegral(
+                P0, Q0, P1, Q1, numericalFix_ == Taylor);
             d0 = d1;
             P0 = P1;
             Q0 = Q1;
@@ -243,29 +234,9 @@ namespace QuantLib {
                     Real t1 = discountCurve_->timeFromReference(*node);
                     Real P1 = discountCurve_->discount(*node);
                     Real Q1 = probability_->survivalProbability(*node);
-                    Real fhat = std::log(P0) - std::log(P1);
-                    Real hhat = std::log(Q0) - std::log(Q1);
-                    Real fhphh = fhat + hhat;
-                    if (fhphh < 1E-4 && numericalFix_ == Taylor) {
-                        // see above, terms up to (f+h)^3 seem more than enough,
-                        // what exactly is implemented in the standard isda C
-                        // code ?
-                        Real fhphhq = fhphh * fhphh;
-                        defaultAccrThisNode +=
-                            hhat * P0 * Q0 *
-                            ((t0 - tstart) *
-                                 (1.0 - 0.5 * fhphh + 1.0 / 6.0 * fhphhq -
-                                  1.0 / 24.0 * fhphhq * fhphh) +
-                             (t1 - t0) *
-                                 (0.5 - 1.0 / 3.0 * fhphh + 1.0 / 8.0 * fhphhq -
-                                  1.0 / 30.0 * fhphhq * fhphh));
-                    } else {
-                        defaultAccrThisNode +=
-                            (hhat / (fhphh + nFix)) *
-                            ((t1 - t0) * ((P0 * Q0 - P1 * Q1) / (fhphh + nFix) -
-                                          P1 * Q1) +
-                             (t0 - tstart) * (P0 * Q0 - P1 * Q1));
-                    }
+                    defaultAccrThisNode += detail::isdaAccrualIntegral(
+                        tstart, t0, P0, Q0, t1, P1, Q1,
+                        numericalFix_ == Taylor);
 
                     t0 = t1;
                     P0 = P1;
@@ -28,9 +28,72 @@
 #include <ql/instruments/creditdefaultswap.hpp>
 #include <ql/termstructures/yieldtermstructure.hpp>
 #include <ql/termstructures/defaulttermstructure.hpp>
+#include <cmath>
 
 namespace QuantLib {
 
+    namespace detail {
+
+        /*! Node dates of a yield curve compatible with the ISDA engine,
+            i.e., flat-forward interpolated; fails for other curves.
+        */
+        std::vector<Date> isdaYieldCurveDates(const YieldTermStructure& curve);
+
+        /*! ISDA integral of the protection leg between two nodes, per
+            unit loss, given the discount factors and the survival
+            probabilities at the nodes; see [1] and, for the Taylor
+            expansion, [2] below.
+        */
+        inline Real isdaProtectionIntegral(Real P0, Real Q0,
+                                           Real P1, Real Q1,
+                                           bool taylor) {
+            Real fhat = std::log(P0) - std::log(P1);
+            Real hhat = std::log(Q0) - std::log(Q1);
+            Real fhphh = fhat + hhat;
+            if (fhphh < 1E-4 && taylor) {
+                Real fhphhq = fhphh * fhphh;
+                return P0 * Q0 * hhat * (1.0 - 0.5 * fhphh + 1.0 / 6.0 * fhphhq -
+                                         1.0 / 24.0 * fhphhq * fhphh +
+                                         1.0 / 120 * fhphhq * fhphhq);
+            } else {
+                const Real nFix = (taylor ? 0.0 : 1E-50);
+                return hhat / (fhphh + nFix) * (P0 * Q0 - P1 * Q1);
+            }
+        }
+
+        /*! ISDA integral of the default accrual between two nodes at
+            times t0 and t1, per unit notional and coupon rate, for an
+            accrual period starting at tstart.
+        */
+        inline Real isdaAccrualIntegral(Time tstart,
+                                        Time t0, Real P0, Real Q0,
+                                        Time t1, Real P1, Real Q1,
+                                        bool taylor) {
+            Real fhat = std::log(P0) - std::log(P1);
+            Real hhat = std::log(Q0) - std::log(Q1);
+            Real fhphh = fhat + hhat;
+            if (fhphh < 1E-4 && taylor) {
+                // terms up to (f+h)^3 seem more than enough, what exactly
+                // is implemented in the standard isda C code ?
+                Real fhphhq = fhphh * fhphh;
+                return hhat * P0 * Q0 *
+                    ((t0 - tstart) *
+                         (1.0 - 0.5 * fhphh + 1.0 / 6.0 * fhphhq -
+                          1.0 / 24.0 * fhphhq * fhphh) +
+                     (t1 - t0) *
+                         (0.5 - 1.0 / 3.0 * fhphh + 1.0 / 8.0 * fhphhq -
+                          1.0 / 30.0 * fhphhq * fhphh));
+            } else {
+                const Real nFix = (taylor ? 0.0 : 1E-50);
+                return (hhat / (fhphh + nFix)) *
+                    ((t1 - t0) * ((P0 * Q0 - P1 * Q1) / (fhphh + nFix) -
+                                  P1 * Q1) +
+                     (t0 - tstart) * (P0 * Q0 - P1 * Q1));
+            }
+        }
+
+    }
+
     /*! References:
 
         [1] The Pricing and Risk Management of Credit Default Swaps, with a
@@ -148,6 +148,7 @@ namespace QuantLib {
                                                     // underlying
         Array z = model_->yGrid(stddevs_, integrationPoints_);
         Array p(z.size(), 0.0), pa(z.size(), 0.0);
+        Gaussian1dGridIntegral integral(z);
 
         // for probability computation
         std::vector<Array> npvp0, npvp1;
@@ -220,7 +221,40 @@ namespace QuantLib {
             event0Time = std::max(
                 model_->termStructure()->timeFromReference(event0), 0.0);
 
-            // todo add openmp support later on (as in gaussian1dswaptionengine)
+            // Unlike in Gaussian1dSwaptionEngine, the roll back is done
+            // on the calling thread and the structured coupons are not
+            // read from the tables cached in the model: they are mostly
+            // CMS and CMS spread rates, for which no tables exist, and
+            // the work arrays are shared across the grid points.
+
+            // the splines of the continuation values do not depend on
+            // the grid point at which we roll back
+            Real zSpreadDf = 1.0;
+            std::vector<CubicInterpolation> payoffs0;
+            if (event1Time != Null<Real>()) {
+                zSpreadDf = oas_.empty() ? 1.0
+                                         : std::exp(-oas_->value() *
+                                                    (event1Time - event0Time));
+                payoffs0.push_back(CubicInterpolation(
+                    z.begin(), z.end(), npv1.begin(),
+                    CubicInterpolation::Spline, true,
+                    CubicInterpolation::Lagrange, 0.0,
+                    CubicInterpolation::Lagrange, 0.0));
+                payoffs0.push_back(CubicInterpolation(
+                    z.begin(), z.end(), npv1a.begin(),
+                    CubicInterpolation::Spline, true,
+                    CubicInterpolation::Lagrange, 0.0,
+                    CubicInterpolation::Lagrange, 0.0));
+                // for probability computation
+                if (considerProbabilities && probabilities_ != None) {
+                    for (Size m = 0; m < npvp1.size(); m++)
+                        payoffs0.push_back(CubicInterpolation(
+                            z.begin(), z.end(), npvp1[m].begin(),
+                            CubicInterpolation::Spline, true,
+                            CubicInterpolation::Lagrange, 0.0,
+                            CubicInterpolation::Lagrange, 0.0));
+                }
+            }
 
             for (Size k = 0; k < (event0 > expiry ? npv0.size() : 1); k++) {
 
@@ -228,26 +262,12 @@ namespace QuantLib {
 
                 Real price = 0.0, pricea = 0.0;
                 if (event1Time != Null<Real>()) {
-                    Real zSpreadDf = oas_.empty()
-                                         ? 1.0
-                                         : std::exp(-oas_->value() *
-                                                    (event1Time - event0Time));
                     Array yg =
                         model_->yGrid(stddevs_, integrationPoints_, event1Time,
                                       event0Time, event0 > expiry ? z[k] : y);
-                    CubicInterpolation payoff0(
-                        z.begin(), z.end(), npv1.begin(),
-                        CubicInterpolation::Spline, true,
-                        CubicInterpolation::Lagrange, 0.0,
-                        CubicInterpolation::Lagrange, 0.0);
-                    CubicInterpolation payoff0a(
-                        z.begin(), z.end(), npv1a.begin(),
-                        CubicInterpolation::Spline, true,
-                        CubicInterpolation::Lagrange, 0.0,
-                        CubicInterpolation::Lagrange, 0.0);
                     for (Size i = 0; i < yg.size(); i++) {
-                        p[i] = payoff0(yg[i], true);
-                        pa[i] = payoff0a(yg[i], true);
+                        p[i] = payoffs0[0](yg[i], true);
+                        pa[i] = payoffs0[1](yg[i], true);
                     }
                     CubicInterpolation payoff1(
                         z.begin(), z.end(), p.begin(),
@@ -259,79 +279,17 @@ namespace QuantLib {
                         CubicInterpolation::Spline, true,
                         CubicInterpolation::Lagrange, 0.0,
                         CubicInterpolation::Lagrange, 0.0);
-                    for (Size i = 0; i < z.size() - 1; i++) {
-                        price += model_->gaussianShiftedPolynomialIntegral(
-                                     0.0, payoff1.cCoefficients()[i],
-                                     payoff1.bCoefficients()[i],
-                                     payoff1.aCoefficients()[i], p[i], z[i],
-                                     z[i], z[i + 1]) *
-                                 zSpreadDf;
-                        pricea += model_->gaussianShiftedPolynomialIntegral(
-                                      0.0, payoff1a.cCoefficients()[i],
-                                      payoff1a.bCoefficients()[i],
-                                      payoff1a.aCoefficients()[i], pa[i], z[i],
-                                      z[i], z[i + 1]) *
-                                  zSpreadDf;
-                    }
-                    if (extrapolatePayoff_) {
-                        if (flatPayoffExtrapolation_) {
-                            price +=
-                                model_->gaussianShiftedPolynomialIntegral(
-                                    0.0, 0.0, 0.0, 0.0, p[z.size() - 2],
-                                    z[z.size() - 2], z[z.size() - 1], 100.0) *
-                                zSpreadDf;
-                            price += model_->gaussianShiftedPolynomialIntegral(
-                                         0.0, 0.0, 0.0, 0.0, p[0], z[0], -100.0,
-                                         z[0]) *
-                                     zSpreadDf;
-                            pricea +=
-                                model_->gaussianShiftedPolynomialIntegral(
-                                    0.0, 0.0, 0.0, 0.0, pa[z.size() - 2],
-                                    z[z.size() - 2], z[z.size() - 1], 100.0) *
-                                zSpreadDf;
-                            pricea += model_->gaussianShiftedPolynomialIntegral(
-                                          0.0, 0.0, 0.0, 0.0, pa[0], z[0],
-                                          -100.0, z[0]) *
-                                      zSpreadDf;
-                        } else {
-                            if (type == Option::Call)
-                                price +=
-                                    model_->gaussianShiftedPolynomialIntegral(
-                                        0.0,
-                                        payoff1.cCoefficients()[z.size() - 2],
-                                        payoff1.bCoefficients()[z.size() - 2],
-                                        payoff1.aCoefficients()[z.size() - 2],
-                                        p[z.size() - 2], z[z.size() - 2],
-                                        z[z.size() - 1], 100.0) *
-                                    zSpreadDf;
-                            if (type == Option::Put)
-                                price +=
-                                    model_->gaussianShiftedPolynomialIntegral(
-                                        0.0, payoff1.cCoefficients()[0],
-                                        payoff1.bCoefficients()[0],
-                                        payoff1.aCoefficients()[0], p[0], z[0],
-                                        -100.0, z[0]) *
-                                    zSpreadDf;
-                            if (type == Option::Call)
-                                pricea +=
-                                    model_->gaussianShiftedPolynomialIntegral(
-                                        0.0,
-                                        payoff1a.cCoefficients()[z.size() - 2],
-                                        payoff1a.bCoefficients()[z.size() - 2],
-                                        payoff1a.aCoefficients()[z.size() - 2],
-                                        pa[z.size() - 2], z[z.size() - 2],
-                                        z[z.size() - 1], 100.0) *
-                                    zSpreadDf;
-                            if (type == Option::Put)
-                                pricea +=
-                                    model_->gaussianShiftedPolynomialIntegral(
-                                        0.0, payoff1a.cCoefficients()[0],
-                                        payoff1a.bCoefficients()[0],
-                                        payoff1a.aCoefficients()[0], pa[0],
-                                        z[0], -100.0, z[0]) *
-                                    zSpreadDf;
-                        }
-                    }
+                    price = integral(p, payoff1.aCoefficients(),
+                                     payoff1.bCoefficients(),
+                                     payoff1.cCoefficients(), extrapolatePayoff_,
+                                     flatPayoffExtrapolation_, type) *
+                            zSpreadDf;
+                    pricea = integral(pa, payoff1a.aCoefficients(),
+                                      payoff1a.bCoefficients(),
+                                      payoff1a.cCoefficients(),
+                                      extrapolatePayoff_,
+                                      flatPayoffExtrapolation_, type) *
+                             zSpreadDf;
                 }
 
                 npv0[k] = price;
@@ -342,84 +300,23 @@ namespace QuantLib {
                     for (Size m = 0; m < npvp0.size(); m++) {
                         Real price = 0.0;
                         if (event1Time != Null<Real>()) {
-                            Real zSpreadDf =
-                                oas_.empty()
-                                    ? 1.0
-                                    : std::exp(-oas_->value() *
-                                               (event1Time - event0Time));
                             Array yg = model_->yGrid(
                                 stddevs_, integrationPoints_, event1Time,
                                 event0Time, event0 > expiry ? z[k] : 0.0);
-                            CubicInterpolation payoff0(
-                                z.begin(), z.end(), npvp1[m].begin(),
-                                CubicInterpolation::Spline, true,
-                                CubicInterpolation::Lagrange, 0.0,
-                                CubicInterpolation::Lagrange, 0.0);
                             for (Size i = 0; i < yg.size(); i++) {
-                                p[i] = payoff0(yg[i], true);
+                                p[i] = payoffs0[m + 2](yg[i], true);
                             }
                             CubicInterpolation payoff1(
                                 z.begin(), z.end(), p.begin(),
                                 CubicInterpolation::Spline, true,
                                 CubicInterpolation::Lagrange, 0.0,
                                 CubicInterpolation::Lagrange, 0.0);
-                            for (Size i = 0; i < z.size() - 1; i++) {
-                                price +=
-                                    model_->gaussianShiftedPolynomialIntegral(
-                                        0.0, payoff1.cCoefficients()[i],
-                                        payoff1.bCoefficients()[i],
-                                        payoff1.aCoefficients()[i], p[i], z[i],
-                                        z[i], z[i + 1]) *
+                            price = integral(p, payoff1.aCoefficients(),
+                                             payoff1.bCoefficients(),
+                                             payoff1.cCoefficients(),
+                                             extrapolatePayoff_,
+                                             flatPayoffExtrapolation_, type) *
                                     zSpreadDf;
-                            }
-                            if (extrapolatePayoff_) {
-                                if (flatPayoffExtrapolation_) {
-                                    price +=
-                                        model_
-                                            ->gaussianShiftedPolynomialIntegral(
-                                                  0.0, 0.0, 0.0, 0.0,
-                                                  p[z.size() - 2],
-                                                  z[z.size() - 2],
-                                                  z[z.size() - 1], 100.0) *
-                                        zSpreadDf;
-                                    price +=
-                                        model_
-                                            ->gaussianShiftedPolynomialIntegral(
-                                                  0.0, 0.0, 0.0, 0.0, p[0],
-                                                  z[0], -100.0, z[0]) *
-                                        zSpreadDf;
-                                } else {
-                                    if (type == Option::Call)
-                                        price +=
-                                            model_
-                                                ->gaussianShiftedPolynomialIntegral(
-                                                      0.0,
-                                                      payoff1.cCoefficients()
-                                                          [z.size() - 2],
-                                                      payoff1.bCoefficients()
-                                                          [z.size() - 2],
-                                                      payoff1.aCoefficients()
-                                                          [z.size() - 2],
-                                                      p[z.size() - 2],
-                                                      z[z.size() - 2],
-                                                      z[z.size() - 1], 100.0) *
-                                            zSpreadDf;
-                                    if (type == Option::Put)
-                                        price +=
-                                            model_
-                                                ->gaussianShiftedPolynomialIntegral(
-                                                      0.0,
-                                                      payoff1
-                                                          .cCoefficients()[0],
-                                                      payoff1
-                                                          .bCoefficients()[0],
-                                                      payoff1
-                                                          .aCoefficients()[0],
-                                                      p[0], z[0], -100.0,
-                                                      z[0]) *
-                                            zSpreadDf;
-                                }
-                            }
                         }
 
                         npvp0[m][k] = price;
@@ -165,6 +165,7 @@ namespace QuantLib {
             npv1(2 * integrationPoints_ + 1, 0.0);
         Array z = model_->yGrid(stddevs_, integrationPoints_);
         Array p(z.size(), 0.0);
+        Gaussian1dGridIntegral integral(z);
 
         // for probability computation
         std::vector<Array> npvp0, npvp1;
@@ -200,241 +201,147 @@ namespace QuantLib {
                                  arguments_.floatingResetDates.end(), expiry0 - 1) -
                 arguments_.floatingResetDates.begin();
 
-            // todo add openmp support later on (as in gaussian1dswaptionengine)
-
-            for (Size k = 0; k < (expiry0 > settlement ? npv0.size() : 1);
-                 k++) {
-
-                Real price = 0.0;
-                if (expiry1Time != Null<Real>()) {
+            // the exercise value and the deflator on the grid are
+            // computed from the tables cached in the model, see
+            // Gaussian1dSwaptionEngine
+            Array exerciseValue, numeraire;
+            if (expiry0 > settlement) {
+                Array floatingLegNpv(z.size(), 0.0);
+                for (Size l = k1; l < arguments_.floatingCoupons.size(); l++) {
+                    Real zSpreadDf =
+                        oas_.empty()
+                            ? 1.0
+                            : std::exp(-oas_->value() *
+                                       (model_->termStructure()
+                                            ->dayCounter()
+                                            .yearFraction(
+                                                expiry0,
+                                                arguments_.floatingPayDates[l])));
+                    Array amount(z.size(), arguments_.floatingCoupons[l]);
+                    if (!arguments_.floatingIsRedemptionFlow[l]) {
+                        Array forward = model_->forwardRateGrid(
+                            arguments_.floatingFixingDates[l], expiry0,
+                            stddevs_, integrationPoints_,
+                            arguments_.swap->iborIndex());
+                        for (Size k = 0; k < z.size(); k++)
+                            amount[k] = arguments_.floatingNominal[l] *
+                                        arguments_.floatingAccrualTimes[l] *
+                                        (arguments_.floatingGearings[l] *
+                                             forward[k] +
+                                         arguments_.floatingSpreads[l]);
+                    }
+                    Array discount = model_->zerobondGrid(
+                        arguments_.floatingPayDates[l], expiry0, stddevs_,
+                        integrationPoints_, discountCurve_);
+                    for (Size k = 0; k < z.size(); k++)
+                        floatingLegNpv[k] += amount[k] * discount[k] * zSpreadDf;
+                }
+                Array fixedLegNpv(z.size(), 0.0);
+                for (Size l = j1; l < arguments_.fixedCoupons.size(); l++) {
                     Real zSpreadDf =
-                        oas_.empty() ? 1.0
-                                     : std::exp(-oas_->value() *
-                                                (expiry1Time - expiry0Time));
-                    Array yg = model_->yGrid(stddevs_, integrationPoints_,
-                                             expiry1Time, expiry0Time,
-                                             expiry0 > settlement ? z[k] : 0.0);
-                    CubicInterpolation payoff0(
-                        z.begin(), z.end(), npv1.begin(),
+                        oas_.empty()
+                            ? 1.0
+                            : std::exp(-oas_->value() *
+                                       (model_->termStructure()
+                                            ->dayCounter()
+                                            .yearFraction(
+                                                expiry0,
+                                                arguments_.fixedPayDates[l])));
+                    Array discount = model_->zerobondGrid(
+                        arguments_.fixedPayDates[l], expiry0, stddevs_,
+                        integrationPoints_, discountCurve_);
+                    for (Size k = 0; k < z.size(); k++)
+                        fixedLegNpv[k] +=
+                            arguments_.fixedCoupons[l] * discount[k] * zSpreadDf;
+                }
+                Real rebate = 0.0;
+                Real zSpreadDf = 1.0;
+                Date rebateDate = expiry0;
+                if (rebatedExercise != nullptr) {
+                    rebate = rebatedExercise->rebate(idx);
+                    rebateDate = rebatedExercise->rebatePaymentDate(idx);
+                    zSpreadDf =
+                        oas_.empty()
+                            ? 1.0
+                            : std::exp(-oas_->value() *
+                                       (model_->termStructure()
+                                            ->dayCounter()
+                                            .yearFraction(expiry0, rebateDate)));
+                }
+                Array rebateDiscount = model_->zerobondGrid(
+                    rebateDate, expiry0, stddevs_, integrationPoints_,
+                    discountCurve_);
+                numeraire = model_->numeraireGrid(expiry0, stddevs_,
+                                                  integrationPoints_,
+                                                  discountCurve_);
+                exerciseValue = Array(z.size());
+                for (Size k = 0; k < z.size(); k++)
+                    exerciseValue[k] =
+                        ((type == Option::Call ? 1.0 : -1.0) *
+                             (floatingLegNpv[k] - fixedLegNpv[k]) +
+                         rebate * rebateDiscount[k] * zSpreadDf) /
+                        numeraire[k];
+            }
+
+            // the splines of the continuation values do not depend on
+            // the grid point at which we roll back
+            std::vector<CubicInterpolation> payoffs0;
+            Real zSpreadDf = 1.0;
+            if (expiry1Time != Null<Real>()) {
+                zSpreadDf = oas_.empty() ? 1.0
+                                         : std::exp(-oas_->value() *
+                                                    (expiry1Time - expiry0Time));
+                payoffs0.push_back(CubicInterpolation(
+                    z.begin(), z.end(), npv1.begin(),
+                    CubicInterpolation::Spline, true,
+                    CubicInterpolation::Lagrange, 0.0,
+                    CubicInterpolation::Lagrange, 0.0));
+                // for probability computation
+                for (Size m = 0; m < npvp1.size(); m++)
+                    payoffs0.push_back(CubicInterpolation(
+                        z.begin(), z.end(), npvp1[m].begin(),
                         CubicInterpolation::Spline, true,
                         CubicInterpolation::Lagrange, 0.0,
-                        CubicInterpolation::Lagrange, 0.0);
+                        CubicInterpolation::Lagrange, 0.0));
+            }
+
+#pragma omp parallel for default(shared) firstprivate(p) if(expiry0>settlement)
+            for (long k = 0; k < (expiry0 > settlement ? (long)npv0.size() : 1);
+                 k++) {
+
+                Array yg;
+                if (expiry1Time != Null<Real>())
+                    yg = model_->yGrid(stddevs_, integrationPoints_,
+                                       expiry1Time, expiry0Time,
+                                       expiry0 > settlement ? z[k] : 0.0);
+
+                for (Size m = 0; m < payoffs0.size(); m++) {
                     for (Size i = 0; i < yg.size(); i++) {
-                        p[i] = payoff0(yg[i], true);
+                        p[i] = payoffs0[m](yg[i], true);
                     }
                     CubicInterpolation payoff1(
                         z.begin(), z.end(), p.begin(),
                         CubicInterpolation::Spline, true,
                         CubicInterpolation::Lagrange, 0.0,
                         CubicInterpolation::Lagrange, 0.0);
-                    for (Size i = 0; i < z.size() - 1; i++) {
-                        price += model_->gaussianShiftedPolynomialIntegral(
-                                     0.0, payoff1.cCoefficients()[i],
-                                     payoff1.bCoefficients()[i],
-                                     payoff1.aCoefficients()[i], p[i], z[i],
-                                     z[i], z[i + 1]) *
-                                 zSpreadDf;
-                    }
-                    if (extrapolatePayoff_) {
-                        if (flatPayoffExtrapolation_) {
-                            price +=
-                                model_->gaussianShiftedPolynomialIntegral(
-                                    0.0, 0.0, 0.0, 0.0, p[z.size() - 2],
-                                    z[z.size() - 2], z[z.size() - 1], 100.0) *
-                                zSpreadDf;
-                            price += model_->gaussianShiftedPolynomialIntegral(
-                                         0.0, 0.0, 0.0, 0.0, p[0], z[0], -100.0,
-                                         z[0]) *
-                                     zSpreadDf;
-                        } else {
-                            if (type == Option::Call)
-                                price +=
-                                    model_->gaussianShiftedPolynomialIntegral(
-                                        0.0,
-                                        payoff1.cCoefficients()[z.size() - 2],
-                                        payoff1.bCoefficients()[z.size() - 2],
-                                        payoff1.aCoefficients()[z.size() - 2],
-                                        p[z.size() - 2], z[z.size() - 2],
-                                        z[z.size() - 1], 100.0) *
-                                    zSpreadDf;
-                            if (type == Option::Put)
-                                price +=
-                                    model_->gaussianShiftedPolynomialIntegral(
-                                        0.0, payoff1.cCoefficients()[0],
-                                        payoff1.bCoefficients()[0],
-                                        payoff1.aCoefficients()[0], p[0], z[0],
-                                        -100.0, z[0]) *
-                                    zSpreadDf;
-                        }
-                    }
+                    Real price =
+                        integral(p, payoff1.aCoefficients(),
+                                 payoff1.bCoefficients(),
+                                 payoff1.cCoefficients(), extrapolatePayoff_,
+                                 flatPayoffExtrapolation_, type) *
+                        zSpreadDf;
+                    if (m == 0)
+                        npv0[k] = price;
+                    else
+                        npvp0[m - 1][k] = price;
                 }
-
-                npv0[k] = price;
-
-                // for probability computation
-                if (probabilities_ != None) {
-                    for (Size m = 0; m < npvp0.size(); m++) {
-                        Real price = 0.0;
-                        if (expiry1Time != Null<Real>()) {
-                            Real zSpreadDf =
-                                oas_.empty()
-                                    ? 1.0
-                                    : std::exp(-oas_->value() *
-                                               (expiry1Time - expiry0Time));
-                            Array yg = model_->yGrid(
-                                stddevs_, integrationPoints_, expiry1Time,
-                                expiry0Time, expiry0 > settlement ? z[k] : 0.0);
-                            CubicInterpolation payoff0(
-                                z.begin(), z.end(), npvp1[m].begin(),
-                                CubicInterpolation::Spline, true,
-                                CubicInterpolation::Lagrange, 0.0,
-                                CubicInterpolation::Lagrange, 0.0);
-                            for (Size i = 0; i < yg.size(); i++) {
-                                p[i] = payoff0(yg[i], true);
-                            }
-                            CubicInterpolation payoff1(
-                                z.begin(), z.end(), p.begin(),
-                                CubicInterpolation::Spline, true,
-                                CubicInterpolation::Lagrange, 0.0,
-                                CubicInterpolation::Lagrange, 0.0);
-                            for (Size i = 0; i < z.size() - 1; i++) {
-                                price +=
-                                    model_->gaussianShiftedPolynomialIntegral(
-                                        0.0, payoff1.cCoefficients()[i],
-                                        payoff1.bCoefficients()[i],
-                                        payoff1.aCoefficients()[i], p[i], z[i],
-                                        z[i], z[i + 1]) *
-                                    zSpreadDf;
-                            }
-                            if (extrapolatePayoff_) {
-                                if (flatPayoffExtrapolation_) {
-                                    price +=
-                                        model_
-                                            ->gaussianShiftedPolynomialIntegral(
-                                                  0.0, 0.0, 0.0, 0.0,
-                                                  p[z.size() - 2],
-                                                  z[z.size() - 2],
-                                                  z[z.size() - 1], 100.0) *
-                                        zSpreadDf;
-                                    price +=
-                                        model_
-                                            ->gaussianShiftedPolynomialIntegral(
-                                                  0.0, 0.0, 0.0, 0.0, p[0],
-                                                  z[0], -100.0, z[0]) *
-                                        zSpreadDf;
-                                } else {
-                                    if (type == Option::Call)
-                                        price +=
-                                            model_
-                                                ->gaussianShiftedPolynomialIntegral(
-                                                      0.0,
-                                                      payoff1.cCoefficients()
-                                                          [z.size() - 2],
-                                                      payoff1.bCoefficients()
-                                                          [z.size() - 2],
-                                                      payoff1.aCoefficients()
-                                                          [z.size() - 2],
-                                                      p[z.size() - 2],
-                                                      z[z.size() - 2],
-                                                      z[z.size() - 1], 100.0) *
-                                            zSpreadDf;
-                                    if (type == Option::Put)
-                                        price +=
-                                            model_
-                                                ->gaussianShiftedPolynomialIntegral(
-                                                      0.0,
-                                                      payoff1
-                                                          .cCoefficients()[0],
-                                                      payoff1
-                                                          .bCoefficients()[0],
-                                                      payoff1
-                                                          .aCoefficients()[0],
-                                                      p[0], z[0], -100.0,
-                                                      z[0]) *
-                                            zSpreadDf;
-                                }
-                            }
-                        }
-
-                        npvp0[m][k] = price;
-                    }
+                if (payoffs0.empty()) {
+                    npv0[k] = 0.0;
+                    for (Size m = 0; m < npvp0.size(); m++)
+                        npvp0[m][k] = 0.0;
                 }
-                // end probability computation
 
                 if (expiry0 > settlement) {
-                    Real floatingLegNpv = 0.0;
-                    for (Size l = k1; l < arguments_.floatingCoupons.size();
-                         l++) {
-                        Real zSpreadDf =
-                            oas_.empty()
-                                ? 1.0
-                                : std::exp(
-                                      -oas_->value() *
-                                      (model_->termStructure()
-                                           ->dayCounter()
-                                           .yearFraction(
-                                                expiry0,
-                                                arguments_
-                                                    .floatingPayDates[l])));
-                        Real amount;
-                        if (arguments_.floatingIsRedemptionFlow[l])
-                            amount = arguments_.floatingCoupons[l];
-                        else
-                            amount = arguments_.floatingNominal[l] *
-                                     arguments_.floatingAccrualTimes[l] *
-                                     (arguments_.floatingGearings[l] *
-                                          model_->forwardRate(
-                                              arguments_.floatingFixingDates[l],
-                                              expiry0, z[k],
-                                              arguments_.swap->iborIndex()) +
-                                      arguments_.floatingSpreads[l]);
-                        floatingLegNpv +=
-                            amount *
-                            model_->zerobond(arguments_.floatingPayDates[l],
-                                             expiry0, z[k], discountCurve_) *
-                            zSpreadDf;
-                    }
-                    Real fixedLegNpv = 0.0;
-                    for (Size l = j1; l < arguments_.fixedCoupons.size(); l++) {
-                        Real zSpreadDf =
-                            oas_.empty()
-                                ? 1.0
-                                : std::exp(
-                                      -oas_->value() *
-                                      (model_->termStructure()
-                                           ->dayCounter()
-                                           .yearFraction(
-                                                expiry0,
-                                                arguments_.fixedPayDates[l])));
-                        fixedLegNpv +=
-                            arguments_.fixedCoupons[l] *
-                            model_->zerobond(arguments_.fixedPayDates[l],
-                                             expiry0, z[k], discountCurve_) *
-                            zSpreadDf;
-                    }
-                    Real rebate = 0.0;
-                    Real zSpreadDf = 1.0;
-                    Date rebateDate = expiry0;
-                    if (rebatedExercise != nullptr) {
-                        rebate = rebatedExercise->rebate(idx);
-                        rebateDate = rebatedExercise->rebatePaymentDate(idx);
-                        zSpreadDf =
-                            oas_.empty()
-                                ? 1.0
-                                : std::exp(
-                                      -oas_->value() *
-                                      (model_->termStructure()
-                                           ->dayCounter()
-                                           .yearFraction(expiry0, rebateDate)));
-                    }
-                    Real exerciseValue =
-                        ((type == Option::Call ? 1.0 : -1.0) *
-                             (floatingLegNpv - fixedLegNpv) +
-                         rebate * model_->zerobond(rebateDate, expiry0, z[k],
-                                                   discountCurve_) *
-                             zSpreadDf) /
-                        model_->numeraire(expiry0Time, z[k], discountCurve_);
-
                     // for probability computation
                     if (probabilities_ != None) {
                         if (idx == static_cast<int>(
@@ -448,9 +355,8 @@ namespace QuantLib {
                                     : 1.0 / (model_->zerobond(expiry0Time, 0.0,
                                                               0.0,
                                                               discountCurve_) *
-                                             model_->numeraire(expiry0, z[k],
-                                                               discountCurve_));
-                        if (exerciseValue >= npv0[k]) {
+                                             numeraire[k]);
+                        if (exerciseValue[k] >= npv0[k]) {
                             npvp0[idx - minIdxAlive][k] =
                                 probabilities_ == Naive
                                     ? 1.0
@@ -458,8 +364,7 @@ namespace QuantLib {
                                           (model_->zerobond(expiry0Time, 0.0,
                                                             0.0,
                                                             discountCurve_) *
-                                           model_->numeraire(expiry0Time, z[k],
-                                                             discountCurve_));
+                                           numeraire[k]);
                             for (Size ii = idx - minIdxAlive + 1;
                                  ii < npvp0.size(); ii++)
                                 npvp0[ii][k] = 0.0;
@@ -467,7 +372,7 @@ namespace QuantLib {
                     }
                     // end probability computation
 
-                    npv0[k] = std::max(npv0[k], exerciseValue);
+                    npv0[k] = std::max(npv0[k], exerciseValue[k]);
                 }
             }
 
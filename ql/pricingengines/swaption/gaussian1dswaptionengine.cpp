@@ -54,6 +54,7 @@ namespace QuantLib {
             npv1(2 * integrationPoints_ + 1, 0.0);
         Array z = model_->yGrid(stddevs_, integrationPoints_);
         Array p(z.size(), 0.0);
+        Gaussian1dGridIntegral integral(z);
 
         // for probability computation
         std::vector<Array> npvp0, npvp1;
@@ -89,196 +90,101 @@ namespace QuantLib {
                                  floatSchedule.dates().end(), expiry0 - 1) -
                 floatSchedule.dates().begin();
 
-            // a lazy object is not thread safe, neither is the caching
-            // in gsrprocess. therefore we trigger computations here such
-            // that neither lazy object recalculation nor write access
-            // during caching occurs in the parallized loop below.
-            // this is known to work for the gsr and markov functional
-            // model implementations of Gaussian1dModel
-#ifdef _OPENMP
-            if (expiry1Time != Null<Real>())
-                model_->yGrid(stddevs_, integrationPoints_, expiry1Time,
-                              expiry0Time, 0.0);
+            // the exercise value and the deflator on the grid are
+            // computed from the tables cached in the model. This also
+            // triggers the lazy model recalculation, so that neither
+            // this nor write access to caches other than the (guarded)
+            // ones in the model and in gsrprocess occurs in the
+            // parallelized loop below
+            Array exerciseValue, numeraire;
             if (expiry0 > settlement) {
+                Array floatingLegNpv(z.size(), 0.0);
                 for (Size l = k1; l < arguments_.floatingCoupons.size(); l++) {
-                    model_->forwardRate(arguments_.floatingFixingDates[l],
-                                        expiry0, 0.0,
-                                        arguments_.swap->iborIndex());
-                    model_->zerobond(arguments_.floatingPayDates[l], expiry0,
-                                     0.0, discountCurve_);
+                    Array forward = model_->forwardRateGrid(
+                        arguments_.floatingFixingDates[l], expiry0, stddevs_,
+                        integrationPoints_, arguments_.swap->iborIndex());
+                    Array discount = model_->zerobondGrid(
+                        arguments_.floatingPayDates[l], expiry0, stddevs_,
+                        integrationPoints_, discountCurve_);
+                    for (Size k = 0; k < z.size(); k++)
+                        floatingLegNpv[k] +=
+                            arguments_.nominal *
+                            arguments_.floatingAccrualTimes[l] *
+                            (arguments_.floatingSpreads[l] + forward[k]) *
+                            discount[k];
                 }
+                Array fixedLegNpv(z.size(), 0.0);
                 for (Size l = j1; l < arguments_.fixedCoupons.size(); l++) {
-                    model_->zerobond(arguments_.fixedPayDates[l], expiry0, 0.0,
-                                     discountCurve_);
+                    Array discount = model_->zerobondGrid(
+                        arguments_.fixedPayDates[l], expiry0, stddevs_,
+                        integrationPoints_, discountCurve_);
+                    for (Size k = 0; k < z.size(); k++)
+                        fixedLegNpv[k] +=
+                            arguments_.fixedCoupons[l] * discount[k];
                 }
-                model_->numeraire(expiry0Time, 0.0, discountCurve_);
+                numeraire = model_->numeraireGrid(expiry0, stddevs_,
+                                                  integrationPoints_,
+                                                  discountCurve_);
+                exerciseValue = Array(z.size());
+                for (Size k = 0; k < z.size(); k++)
+                    exerciseValue[k] = (type == Option::Call ? 1.0 : -1.0) *
+                                       (floatingLegNpv[k] - fixedLegNpv[k]) /
+                                       numeraire[k];
+            }
+
+            // the splines of the continuation values do not depend on
+            // the grid point at which we roll back
+            std::vector<CubicInterpolation> payoffs0;
+            if (expiry1Time != Null<Real>()) {
+                payoffs0.push_back(CubicInterpolation(
+                    z.begin(), z.end(), npv1.begin(),
+                    CubicInterpolation::Spline, true,
+                    CubicInterpolation::Lagrange, 0.0,
+                    CubicInterpolation::Lagrange, 0.0));
+                // for probability computation
+                for (Size m = 0; m < npvp1.size(); m++)
+                    payoffs0.push_back(CubicInterpolation(
+                        z.begin(), z.end(), npvp1[m].begin(),
+                        CubicInterpolation::Spline, true,
+                        CubicInterpolation::Lagrange, 0.0,
+                        CubicInterpolation::Lagrange, 0.0));
             }
-#endif
 
 #pragma omp parallel for default(shared) firstprivate(p) if(expiry0>settlement)
             for (long k = 0; k < (expiry0 > settlement ? (long)npv0.size() : 1);
                  k++) {
 
-                Real price = 0.0;
-                if (expiry1Time != Null<Real>()) {
-                    Array yg = model_->yGrid(stddevs_, integrationPoints_,
-                                             expiry1Time, expiry0Time,
-                                             expiry0 > settlement ? z[k] : 0.0);
-                    CubicInterpolation payoff0(
-                        z.begin(), z.end(), npv1.begin(),
-                        CubicInterpolation::Spline, true,
-                        CubicInterpolation::Lagrange, 0.0,
-                        CubicInterpolation::Lagrange, 0.0);
+                Array yg;
+                if (expiry1Time != Null<Real>())
+                    yg = model_->yGrid(stddevs_, integrationPoints_,
+                                       expiry1Time, expiry0Time,
+                                       expiry0 > settlement ? z[k] : 0.0);
+
+                for (Size m = 0; m < payoffs0.size(); m++) {
                     for (Size i = 0; i < yg.size(); i++) {
-                        p[i] = payoff0(yg[i], true);
+                        p[i] = payoffs0[m](yg[i], true);
                     }
                     CubicInterpolation payoff1(
                         z.begin(), z.end(), p.begin(),
                         CubicInterpolation::Spline, true,
                         CubicInterpolation::Lagrange, 0.0,
                         CubicInterpolation::Lagrange, 0.0);
-                    for (Size i = 0; i < z.size() - 1; i++) {
-                        price += model_->gaussianShiftedPolynomialIntegral(
-                            0.0, payoff1.cCoefficients()[i],
-                            payoff1.bCoefficients()[i],
-                            payoff1.aCoefficients()[i], p[i], z[i], z[i],
-                            z[i + 1]);
-                    }
-                    if (extrapolatePayoff_) {
-                        if (flatPayoffExtrapolation_) {
-                            price += model_->gaussianShiftedPolynomialIntegral(
-                                0.0, 0.0, 0.0, 0.0, p[z.size() - 2],
-                                z[z.size() - 2], z[z.size() - 1], 100.0);
-                            price += model_->gaussianShiftedPolynomialIntegral(
-                                0.0, 0.0, 0.0, 0.0, p[0], z[0], -100.0, z[0]);
-                        } else {
-                            if (type == Option::Call)
-                                price +=
-                                    model_->gaussianShiftedPolynomialIntegral(
-                                        0.0,
-                                        payoff1.cCoefficients()[z.size() - 2],
-                                        payoff1.bCoefficients()[z.size() - 2],
-                                        payoff1.aCoefficients()[z.size() - 2],
-                                        p[z.size() - 2], z[z.size() - 2],
-                                        z[z.size() - 1], 100.0);
-                            if (type == Option::Put)
-                                price +=
-                                    model_->gaussianShiftedPolynomialIntegral(
-                                        0.0, payoff1.cCoefficients()[0],
-                                        payoff1.bCoefficients()[0],
-                                        payoff1.aCoefficients()[0], p[0], z[0],
-                                        -100.0, z[0]);
-                        }
-                    }
+                    Real price = integral(
+                        p, payoff1.aCoefficients(), payoff1.bCoefficients(),
+                        payoff1.cCoefficients(), extrapolatePayoff_,
+                        flatPayoffExtrapolation_, type);
+                    if (m == 0)
+                        npv0[k] = price;
+                    else
+                        npvp0[m - 1][k] = price;
                 }
-
-                npv0[k] = price;
-
-                // for probability computation
-                if (probabilities_ != None) {
-                    for (Size m = 0; m < npvp0.size(); m++) {
-                        Real price = 0.0;
-                        if (expiry1Time != Null<Real>()) {
-                            Array yg = model_->yGrid(
-                                stddevs_, integrationPoints_, expiry1Time,
-                                expiry0Time, expiry0 > settlement ? z[k] : 0.0);
-                            CubicInterpolation payoff0(
-                                z.begin(), z.end(), npvp1[m].begin(),
-                                CubicInterpolation::Spline, true,
-                                CubicInterpolation::Lagrange, 0.0,
-                                CubicInterpolation::Lagrange, 0.0);
-                            for (Size i = 0; i < yg.size(); i++) {
-                                p[i] = payoff0(yg[i], true);
-                            }
-                            CubicInterpolation payoff1(
-                                z.begin(), z.end(), p.begin(),
-                                CubicInterpolation::Spline, true,
-                                CubicInterpolation::Lagrange, 0.0,
-                                CubicInterpolation::Lagrange, 0.0);
-                            for (Size i = 0; i < z.size() - 1; i++) {
-                                price +=
-                                    model_->gaussianShiftedPolynomialIntegral(
-                                        0.0, payoff1.cCoefficients()[i],
-                                        payoff1.bCoefficients()[i],
-                                        payoff1.aCoefficients()[i], p[i], z[i],
-                                        z[i], z[i + 1]);
-                            }
-                            if (extrapolatePayoff_) {
-                                if (flatPayoffExtrapolation_) {
-                                    price +=
-                                        model_
-                                            ->gaussianShiftedPolynomialIntegral(
-                                                  0.0, 0.0, 0.0, 0.0,
-                                                  p[z.size() - 2],
-                                                  z[z.size() - 2],
-                                                  z[z.size() - 1], 100.0);
-                                    price +=
-                                        model_
-                                            ->gaussianShiftedPolynomialIntegral(
-                                                  0.0, 0.0, 0.0, 0.0, p[0],
-                                                  z[0], -100.0, z[0]);
-                                } else {
-                                    if (type == Option::Call)
-                                        price +=
-                                            model_
-                                                ->gaussianShiftedPolynomialIntegral(
-                                                      0.0,
-                                                      payoff1.cCoefficients()
-                                                          [z.size() - 2],
-                                                      payoff1.bCoefficients()
-                                                          [z.size() - 2],
-                                                      payoff1.aCoefficients()
-                                                          [z.size() - 2],
-                                                      p[z.size() - 2],
-                                                      z[z.size() - 2],
-                                                      z[z.size() - 1], 100.0);
-                                    if (type == Option::Put)
-                                        price +=
-                                            model_
-                                                ->gaussianShiftedPolynomialIntegral(
-                                                      0.0,
-                                                      payoff1
-                                                          .cCoefficients()[0],
-                                                      payoff1
-                                                          .bCoefficients()[0],
-                                                      payoff1
-                                                          .aCoefficients()[0],
-                                                      p[0], z[0], -100.0, z[0]);
-                                }
-                            }
-                        }
-
-                        npvp0[m][k] = price;
-                    }
+                if (payoffs0.empty()) {
+                    npv0[k] = 0.0;
+                    for (Size m = 0; m < npvp0.size(); m++)
+                        npvp0[m][k] = 0.0;
                 }
-                // end probability computation
 
                 if (expiry0 > settlement) {
-                    Real floatingLegNpv = 0.0;
-                    for (Size l = k1; l < arguments_.floatingCoupons.size();
-                         l++) {
-                        floatingLegNpv +=
-                            arguments_.nominal *
-                            arguments_.floatingAccrualTimes[l] *
-                            (arguments_.floatingSpreads[l] +
-                             model_->forwardRate(
-                                 arguments_.floatingFixingDates[l], expiry0,
-                                 z[k], arguments_.swap->iborIndex())) *
-                            model_->zerobond(arguments_.floatingPayDates[l],
-                                             expiry0, z[k], discountCurve_);
-                    }
-                    Real fixedLegNpv = 0.0;
-                    for (Size l = j1; l < arguments_.fixedCoupons.size(); l++) {
-                        fixedLegNpv +=
-                            arguments_.fixedCoupons[l] *
-                            model_->zerobond(arguments_.fixedPayDates[l],
-                                             expiry0, z[k], discountCurve_);
-                    }
-                    Real exerciseValue =
-                        (type == Option::Call ? 1.0 : -1.0) *
-                        (floatingLegNpv - fixedLegNpv) /
-                        model_->numeraire(expiry0Time, z[k], discountCurve_);
-
                     // for probability computation
                     if (probabilities_ != None) {
                         if (idx == static_cast<int>(
@@ -292,9 +198,8 @@ namespace QuantLib {
                                     : 1.0 / (model_->zerobond(expiry0Time, 0.0,
                                                               0.0,
                                                               discountCurve_) *
-                                             model_->numeraire(expiry0, z[k],
-                                                               discountCurve_));
-                        if (exerciseValue >= npv0[k]) {
+                                             numeraire[k]);
+                        if (exerciseValue[k] >= npv0[k]) {
                             npvp0[idx - minIdxAlive][k] =
                                 probabilities_ == Naive
                                     ? 1.0
@@ -302,8 +207,7 @@ namespace QuantLib {
                                           (model_->zerobond(expiry0Time, 0.0,
                                                             0.0,
                                                             discountCurve_) *
-                                           model_->numeraire(expiry0Time, z[k],
-                                                             discountCurve_));
+                                           numeraire[k]);
                             for (Size ii = idx - minIdxAlive + 1;
                                  ii < npvp0.size(); ii++)
                                 npvp0[ii][k] = 0.0;
@@ -311,7 +215,7 @@ namespace QuantLib {
                     }
                     // end probability computation
 
-                    npv0[k] = std::max(npv0[k], exerciseValue);
+                    npv0[k] = std::max(npv0[k], exerciseValue[k]);
                 }
             }
 
@@ -37,6 +37,8 @@
 #include <ql/pricingengines/blackcalculator.hpp>
 #include <ql/pricingengines/vanilla/analytichestonengine.hpp>
 
+#include <map>
+
 #if defined(QL_PATCH_MSVC)
 #pragma warning(disable: 4180)
 #endif
@@ -122,6 +124,49 @@ namespace QuantLib {
             const Real v0T2_, logEpsilon_;
             mutable Size evaluations_;
         };
+
+
+        // derivatives of the Heston characteristic function terms
+        //   A = (xi-D)(1-e)/(1-G e),
+        //   B = (xi-D)t - 2 log((1-G e)/(1-G)),  e = exp(-D t)
+        // given the derivatives of xi and sigma w.r.t. a model parameter
+        class HestonChFTerms {
+          public:
+            HestonChFTerms(const std::complex<Real>& xi,
+                           const std::complex<Real>& zz,
+                           Real sigma, Time t)
+            : xi_(xi), zz_(zz), sigma_(sigma), t_(t),
+              D_(std::sqrt(xi*xi + zz*sigma*sigma)),
+              G_((xi-D_)/(xi+D_)),
+              e_(std::exp(-D_*t)),
+              A_((xi-D_)*(1.0-e_)/(1.0-G_*e_)),
+              B_((xi-D_)*t - 2.0*std::log((1.0-G_*e_)/(1.0-G_))) {}
+
+            const std::complex<Real>& A() const { return A_; }
+            const std::complex<Real>& B() const { return B_; }
+
+            void derivatives(const std::complex<Real>& dXi, Real dSigma,
+                             std::complex<Real>& dA,
+                             std::complex<Real>& dB) const {
+                const std::complex<Real> dD =
+                    (xi_*dXi + zz_*sigma_*dSigma)/D_;
+                const std::complex<Real> dG =
+                    2.0*(D_*dXi - xi_*dD)/((xi_+D_)*(xi_+D_));
+                const std::complex<Real> de = -t_*e_*dD;
+                const std::complex<Real> dGe = dG*e_ + G_*de;
+
+                dA = ((dXi-dD)*(1.0-e_) - (xi_-D_)*de)/(1.0-G_*e_)
+                    + A_*dGe/(1.0-G_*e_);
+                dB = (dXi-dD)*t_ + 2.0*dGe/(1.0-G_*e_) - 2.0*dG/(1.0-G_);
+            }
+
+          private:
+            const std::complex<Real> xi_, zz_;
+            const Real sigma_;
+            const Time t_;
+            const std::complex<Real> D_, G_, e_, A_, B_;
+        };
+
     }
 
     // helper class for integration
@@ -162,6 +207,9 @@ namespace QuantLib {
 
       Real operator()(Real phi) const;
 
+      // strike independent exponent of the integrand, phi != 0
+      std::complex<Real> exponent(Real phi) const;
+
     private:
         const Size j_;
         //     const VanillaOption::arguments& arg_;
@@ -249,8 +297,8 @@ namespace QuantLib {
       engine_(nullptr) {}
 
 
-    Real AnalyticHestonEngine::Fj_Helper::operator()(Real phi) const
-    {
+    std::complex<Real>
+    AnalyticHestonEngine::Fj_Helper::exponent(Real phi) const {
         const Real rpsig(rsigma_*phi);
 
         const std::complex<Real> t1 = t0_+std::complex<Real>(0, -rpsig);
@@ -262,54 +310,24 @@ namespace QuantLib {
             engine_ != nullptr ? engine_->addOnTerm(phi, term_, j_) : Real(0.0);
 
         if (cpxLog_ == Gatheral) {
-            if (phi != 0.0) {
-                if (sigma_ > 1e-5) {
-                    const std::complex<Real> p = (t1-d)/(t1+d);
-                    const std::complex<Real> g
-                                            = std::log((1.0 - p*ex)/(1.0 - p));
-
-                    return
-                        std::exp(v0_*(t1-d)*(1.0-ex)/(sigma2_*(1.0-ex*p))
-                                 + (kappa_*theta_)/sigma2_*((t1-d)*term_-2.0*g)
-                                 + std::complex<Real>(0.0, phi*(dd_-sx_))
-                                 + addOnTerm
-                                 ).imag()/phi;
-                }
-                else {
-                    const std::complex<Real> td = phi/(2.0*t1)
-                                   *std::complex<Real>(-phi, (j_== 1)? 1 : -1);
-                    const std::complex<Real> p = td*sigma2_/(t1+d);
-                    const std::complex<Real> g = p*(1.0-ex);
-
-                    return
-                        std::exp(v0_*td*(1.0-ex)/(1.0-p*ex)
-                                 + (kappa_*theta_)*(td*term_-2.0*g/sigma2_)
-                                 + std::complex<Real>(0.0, phi*(dd_-sx_))
-                                 + addOnTerm
-                                 ).imag()/phi;
-                }
+            if (sigma_ > 1e-5) {
+                const std::complex<Real> p = (t1-d)/(t1+d);
+                const std::complex<Real> g
+                                        = std::log((1.0 - p*ex)/(1.0 - p));
+
+                return v0_*(t1-d)*(1.0-ex)/(sigma2_*(1.0-ex*p))
+                    + (kappa_*theta_)/sigma2_*((t1-d)*term_-2.0*g)
+                    + addOnTerm;
             }
             else {
-                // use l'Hospital's rule to get lim_{phi->0}
-                if (j_ == 1) {
-                    const Real kmr = rsigma_-kappa_;
-                    if (std::fabs(kmr) > 1e-7) {
-                        return dd_-sx_
-                            + (std::exp(kmr*term_)*kappa_*theta_
-                               -kappa_*theta_*(kmr*term_+1.0) ) / (2*kmr*kmr)
-                            - v0_*(1.0-std::exp(kmr*term_)) / (2.0*kmr);
-                    }
-                    else
-                        // \kappa = \rho * \sigma
-                        return dd_-sx_ + 0.25*kappa_*theta_*term_*term_
-                                       + 0.5*v0_*term_;
-                }
-                else {
-                    return dd_-sx_
-                        - (std::exp(-kappa_*term_)*kappa_*theta_
-                           +kappa_*theta_*(kappa_*term_-1.0))/(2*kappa_*kappa_)
-                        - v0_*(1.0-std::exp(-kappa_*term_))/(2*kappa_);
-                }
+                const std::complex<Real> td = phi/(2.0*t1)
+                               *std::complex<Real>(-phi, (j_== 1)? 1 : -1);
+                const std::complex<Real> p = td*sigma2_/(t1+d);
+                const std::complex<Real> g = p*(1.0-ex);
+
+                return v0_*td*(1.0-ex)/(1.0-p*ex)
+                    + (kappa_*theta_)*(td*term_-2.0*g/sigma2_)
+                    + addOnTerm;
             }
         }
         else if (cpxLog_ == BranchCorrection) {
@@ -355,17 +373,44 @@ namespace QuantLib {
             g_km1_ = g.imag();
             g += std::complex<Real>(0, 2*b_*M_PI);
 
-            return std::exp(v0_*(t1+d)*(ex-1.0)/(sigma2_*(ex-p))
-                            + (kappa_*theta_)/sigma2_*((t1+d)*term_-2.0*g)
-                            + std::complex<Real>(0,phi*(dd_-sx_))
-                            + addOnTerm
-                            ).imag()/phi;
+            return v0_*(t1+d)*(ex-1.0)/(sigma2_*(ex-p))
+                + (kappa_*theta_)/sigma2_*((t1+d)*term_-2.0*g)
+                + addOnTerm;
         }
         else {
             QL_FAIL("unknown complex logarithm formula");
         }
     }
 
+    Real AnalyticHestonEngine::Fj_Helper::operator()(Real phi) const
+    {
+        if (cpxLog_ == Gatheral && phi == 0.0) {
+            // use l'Hospital's rule to get lim_{phi->0}
+            if (j_ == 1) {
+                const Real kmr = rsigma_-kappa_;
+                if (std::fabs(kmr) > 1e-7) {
+                    return dd_-sx_
+                        + (std::exp(kmr*term_)*kappa_*theta_
+                           -kappa_*theta_*(kmr*term_+1.0) ) / (2*kmr*kmr)
+                        - v0_*(1.0-std::exp(kmr*term_)) / (2.0*kmr);
+                }
+                else
+                    // \kappa = \rho * \sigma
+                    return dd_-sx_ + 0.25*kappa_*theta_*term_*term_
+                                   + 0.5*v0_*term_;
+            }
+            else {
+                return dd_-sx_
+                    - (std::exp(-kappa_*term_)*kappa_*theta_
+                       +kappa_*theta_*(kappa_*term_-1.0))/(2*kappa_*kappa_)
+                    - v0_*(1.0-std::exp(-kappa_*term_))/(2*kappa_);
+            }
+        }
+
+        return std::exp(exponent(phi)
+                        + std::complex<Real>(0.0, phi*(dd_-sx_))).imag()/phi;
+    }
+
 
     AnalyticHestonEngine::AP_Helper::AP_Helper(
         Time term, Real fwd, Real strike, ComplexLogFormula cpxLog,
@@ -410,7 +455,8 @@ namespace QuantLib {
         }
     }
 
-    Real AnalyticHestonEngine::AP_Helper::operator()(Real u) const {
+    std::complex<Real>
+    AnalyticHestonEngine::AP_Helper::chFDifference(Real u) const {
         QL_REQUIRE(   enginePtr_->addOnTerm(u, term_, 1)
                         == std::complex<Real>(0.0)
                    && enginePtr_->addOnTerm(u, term_, 2)
@@ -434,8 +480,12 @@ namespace QuantLib {
             QL_FAIL("unknown control variate");
         }
 
+        return (phiBS - enginePtr_->chF(z, term_)) / (u*u + 0.25);
+    }
+
+    Real AnalyticHestonEngine::AP_Helper::operator()(Real u) const {
         return (std::exp(std::complex<Real>(0.0, u*freq_))
-            * (phiBS - enginePtr_->chF(z, term_)) / (u*u + 0.25)).real();
+                * chFDifference(u)).real();
     }
 
     Real AnalyticHestonEngine::AP_Helper::controlVariateValue() const {
@@ -514,6 +564,65 @@ namespace QuantLib {
         return std::log(chF(z, T));
     }
 
+    std::complex<Real> AnalyticHestonEngine::lnChFGradient(
+        const std::complex<Real>& z, Time t,
+        std::vector<std::complex<Real> >& gradient) const {
+
+        const Real kappa = model_->kappa();
+        const Real sigma = model_->sigma();
+        const Real theta = model_->theta();
+        const Real rho   = model_->rho();
+        const Real v0    = model_->v0();
+
+        const Real sigma2 = sigma*sigma;
+        const Real sigma3 = sigma2*sigma;
+
+        const std::complex<Real> iz(-z.imag(), z.real());
+        const std::complex<Real> xi = kappa - rho*sigma*iz;
+
+        const HestonChFTerms terms(xi, z*z + iz, sigma, t);
+        const std::complex<Real>& A = terms.A();
+        const std::complex<Real>& B = terms.B();
+
+        std::complex<Real> dA_kappa, dB_kappa, dA_sigma, dB_sigma,
+                           dA_rho, dB_rho;
+        terms.derivatives(1.0, 0.0, dA_kappa, dB_kappa);
+        terms.derivatives(-rho*iz, 1.0, dA_sigma, dB_sigma);
+        terms.derivatives(-sigma*iz, 0.0, dA_rho, dB_rho);
+
+        gradient.assign(model_->params().size(), std::complex<Real>(0.0));
+
+        gradient[0] = kappa*B/sigma2;
+        gradient[1] = (v0*dA_kappa + theta*B + kappa*theta*dB_kappa)/sigma2;
+        gradient[2] = (v0*dA_sigma + kappa*theta*dB_sigma)/sigma2
+            - 2.0*(v0*A + kappa*theta*B)/sigma3;
+        gradient[3] = (v0*dA_rho + kappa*theta*dB_rho)/sigma2;
+        gradient[4] = A/sigma2;
+
+        return (v0*A + kappa*theta*B)/sigma2
+            + addOnTermGradient(z, t, gradient);
+    }
+
+    std::complex<Real> AnalyticHestonEngine::addOnTermGradient(
+        const std::complex<Real>&, Time,
+        std::vector<std::complex<Real> >& gradient) const {
+        QL_REQUIRE(gradient.size() == 5,
+                   "analytic gradient is not supported for this model");
+
+        return std::complex<Real>(0.0);
+    }
+
+    bool AnalyticHestonEngine::hestonGradientAvailable() const {
+        // the gradient ignores the dependency of c_inf on the parameters
+        return integration_->hasParameterIndependentNodes()
+            && model_->sigma() > 1e-4
+            && cpxLog_ != AsymptoticChF && cpxLog_ != OptimalCV;
+    }
+
+    bool AnalyticHestonEngine::supportsValueGradient() const {
+        return hestonGradientAvailable();
+    }
+
     AnalyticHestonEngine::AnalyticHestonEngine(
                               const ext::shared_ptr<HestonModel>& model,
                               Size integrationOrder)
@@ -713,6 +822,368 @@ namespace QuantLib {
                       evaluations_);
     }
 
+    std::vector<Real> AnalyticHestonEngine::values(
+        const Date& maturity,
+        const std::vector<Option::Type>& types,
+        const std::vector<Real>& strikes) const {
+
+        QL_REQUIRE(types.size() == strikes.size(),
+                   "number of option types (" << types.size()
+                   << ") differs from number of strikes ("
+                   << strikes.size() << ")");
+        QL_REQUIRE(integration_->isGaussianQuadrature(),
+                   "batch pricing requires a Gaussian quadrature");
+
+        const ext::shared_ptr<HestonProcess>& process = model_->process();
+
+        const Real riskFreeDiscount =
+            process->riskFreeRate()->discount(maturity);
+        const Real dividendDiscount =
+            process->dividendYield()->discount(maturity);
+
+        const Real spotPrice = process->s0()->value();
+        QL_REQUIRE(spotPrice > 0.0, "negative or null underlying given");
+
+        const Time term = process->time(maturity);
+        const Real ratio = riskFreeDiscount/dividendDiscount;
+
+        const Real kappa = model_->kappa();
+        const Real theta = model_->theta();
+        const Real sigma = model_->sigma();
+        const Real v0    = model_->v0();
+        const Real rho   = model_->rho();
+
+        const Size n = strikes.size();
+        std::vector<Real> logStrikes(n);
+        for (Size k=0; k < n; ++k) {
+            QL_REQUIRE(strikes[k] > 0.0, "non-positive strike given");
+            logStrikes[k] = std::log(strikes[k]);
+        }
+
+        std::vector<Real> values(n);
+
+        switch(cpxLog_) {
+          case Gatheral:
+          case BranchCorrection: {
+            const Real c_inf = std::min(0.2, std::max(0.0001,
+                std::sqrt(1.0-rho*rho)/sigma))*(v0 + kappa*theta*term);
+
+            const Array x = integration_->nodes(c_inf);
+            const Array w = integration_->weights(c_inf);
+
+            const Real dd = std::log(spotPrice) - std::log(ratio);
+
+            std::vector<Real> p1(n, 0.0), p2(n, 0.0);
+            for (Size j=1; j <= 2; ++j) {
+                const Fj_Helper helper(kappa, theta, sigma, v0, spotPrice,
+                                       rho, this, cpxLog_, term, 1.0,
+                                       ratio, j);
+                std::vector<Real>& p = (j == 1) ? p1 : p2;
+
+                // same order as the Gaussian quadrature such that
+                // the log branch counter sees the identical sequence
+                for (Size i=x.size(); i-- > 0;) {
+                    if (w[i] == 0.0)
+                        continue;
+
+                    const Real phi = x[i];
+                    const std::complex<Real> f =
+                        std::exp(helper.exponent(phi))*(w[i]/phi);
+
+                    for (Size k=0; k < n; ++k) {
+                        const Real arg = phi*(dd - logStrikes[k]);
+                        p[k] += f.imag()*std::cos(arg)
+                            + f.real()*std::sin(arg);
+                    }
+                }
+            }
+            evaluations_ = 2*x.size();
+
+            for (Size k=0; k < n; ++k) {
+                const Real q1 = p1[k]/M_PI, q2 = p2[k]/M_PI;
+                switch (types[k]) {
+                  case Option::Call:
+                    values[k] = spotPrice*dividendDiscount*(q1+0.5)
+                        - strikes[k]*riskFreeDiscount*(q2+0.5);
+                    break;
+                  case Option::Put:
+                    values[k] = spotPrice*dividendDiscount*(q1-0.5)
+                        - strikes[k]*riskFreeDiscount*(q2-0.5);
+                    break;
+                  default:
+                    QL_FAIL("unknown option type");
+                }
+            }
+          }
+          break;
+          case AndersenPiterbarg:
+          case AndersenPiterbargOptCV:
+          case AsymptoticChF:
+          case OptimalCV: {
+            const Real c_inf =
+                std::sqrt(1.0-rho*rho)*(v0 + kappa*theta*term)/sigma;
+
+            const Array x = integration_->nodes(c_inf);
+            const Array w = integration_->weights(c_inf);
+
+            const Real fwdPrice = spotPrice / ratio;
+
+            const ComplexLogFormula cvFormula = (cpxLog_ == OptimalCV)
+                ? optimalControlVariate(term, v0, kappa, theta, sigma, rho)
+                : cpxLog_;
+
+            const AP_Helper atmHelper(
+                term, fwdPrice, fwdPrice, cvFormula, this);
+
+            std::vector<Real> h(n, 0.0);
+            for (Size i=x.size(); i-- > 0;) {
+                if (w[i] == 0.0)
+                    continue;
+
+                const Real u = x[i];
+                const std::complex<Real> f = w[i]*atmHelper.chFDifference(u);
+
+                for (Size k=0; k < n; ++k) {
+                    const Real arg = u*(std::log(fwdPrice) - logStrikes[k]);
+                    h[k] += f.real()*std::cos(arg) - f.imag()*std::sin(arg);
+                }
+            }
+            evaluations_ = x.size();
+
+            for (Size k=0; k < n; ++k) {
+                const Real cvValue = AP_Helper(
+                    term, fwdPrice, strikes[k], cvFormula, this)
+                    .controlVariateValue();
+                const Real h_cv = h[k]*std::sqrt(strikes[k]*fwdPrice)/M_PI;
+
+                switch (types[k]) {
+                  case Option::Call:
+                    values[k] = (cvValue + h_cv)*riskFreeDiscount;
+                    break;
+                  case Option::Put:
+                    values[k] = (cvValue + h_cv - (fwdPrice - strikes[k]))
+                        *riskFreeDiscount;
+                    break;
+                  default:
+                    QL_FAIL("unknown option type");
+                }
+            }
+          }
+          break;
+          default:
+            QL_FAIL("unknown complex log formula");
+        }
+
+        return values;
+    }
+
+    Real AnalyticHestonEngine::valueAndGradient(
+        Array& gradient,
+        const Date& maturity,
+        Option::Type type,
+        Real strike) const {
+
+        QL_REQUIRE(supportsValueGradient(),
+                   "analytic gradient not supported by this engine, "
+                   "integration or model parameters");
+
+        const ext::shared_ptr<HestonProcess>& process = model_->process();
+
+        const Real riskFreeDiscount =
+            process->riskFreeRate()->discount(maturity);
+        const Real dividendDiscount =
+            process->dividendYield()->discount(maturity);
+
+        const Real spotPrice = process->s0()->value();
+        QL_REQUIRE(spotPrice > 0.0, "negative or null underlying given");
+        QL_REQUIRE(strike > 0.0, "non-positive strike given");
+
+        const Time term = process->time(maturity);
+        const Real ratio = riskFreeDiscount/dividendDiscount;
+        const Real fwdPrice = spotPrice/ratio;
+
+        const Real kappa = model_->kappa();
+        const Real theta = model_->theta();
+        const Real sigma = model_->sigma();
+        const Real v0    = model_->v0();
+        const Real rho   = model_->rho();
+
+        const Size n = model_->params().size();
+
+        // the integration nodes don't depend on c_inf, hence the
+        // integrals below use the same nodes as calculate()
+        const Array x = integration_->nodes(1.0);
+        const Array w = integration_->weights(1.0);
+
+        std::vector<std::complex<Real> > lnChFGrad;
+        gradient = Array(n);
+
+        Real callValue;
+        switch (cpxLog_) {
+          case Gatheral:
+          case BranchCorrection: {
+            // Heston's probabilities P_1 and P_2. The derivatives of
+            // their integrands follow from the gradient of the log
+            // characteristic function at u-i and u
+            const Real dd = std::log(spotPrice) - std::log(ratio);
+            const Real sx = std::log(strike);
+
+            Array p1(n+1, 0.0), p2(n+1, 0.0);
+            for (Size j=1; j <= 2; ++j) {
+                const Fj_Helper helper(kappa, theta, sigma, v0, spotPrice,
+                                       rho, this, cpxLog_, term, strike,
+                                       ratio, j);
+                Array& p = (j == 1) ? p1 : p2;
+
+                // same order as the Gaussian quadrature such that
+                // the log branch counter sees the identical sequence
+                for (Size i=x.size(); i-- > 0;) {
+                    if (w[i] == 0.0)
+                        continue;
+
+                    const Real phi = x[i];
+                    const std::complex<Real> f = std::exp(
+                        helper.exponent(phi)
+                        + std::complex<Real>(0.0, phi*(dd - sx)))
+                        *(w[i]/phi);
+
+                    lnChFGradient(std::complex<Real>(
+                        phi, (j == 1) ? -1.0 : 0.0), term, lnChFGrad);
+
+                    p[0] += f.imag();
+                    for (Size k=0; k < n; ++k)
+                        p[k+1] += (f*lnChFGrad[k]).imag();
+                }
+            }
+
+            callValue = spotPrice*dividendDiscount*(p1[0]/M_PI + 0.5)
+                - strike*riskFreeDiscount*(p2[0]/M_PI + 0.5);
+            for (Size k=0; k < n; ++k)
+                gradient[k] = (spotPrice*dividendDiscount*p1[k+1]
+                               - strike*riskFreeDiscount*p2[k+1])/M_PI;
+          }
+          break;
+          case AndersenPiterbarg:
+          case AndersenPiterbargOptCV: {
+            // Lewis formula with the Black control variate of
+            // calculate(), which depends on the parameters via the
+            // average variance only
+            Real vAvg;
+            Array vAvgGrad(n, 0.0);
+            if (cpxLog_ == AndersenPiterbarg) {
+                const Real ekt = std::exp(-kappa*term);
+                const Real b = (1.0-ekt)/(kappa*term);
+
+                vAvg = b*(v0 - theta) + theta;
+                vAvgGrad[0] = 1.0 - b;
+                vAvgGrad[1] = (v0 - theta)*(ekt - b)/kappa;
+                vAvgGrad[4] = b;
+            }
+            else {
+                vAvg = -8.0*lnChFGradient(
+                    std::complex<Real>(0.0, -0.5), term, lnChFGrad)
+                        .real()/term;
+                for (Size k=0; k < n; ++k)
+                    vAvgGrad[k] = -8.0*lnChFGrad[k].real()/term;
+            }
+
+            const BlackCalculator black(
+                Option::Call, strike, fwdPrice, std::sqrt(vAvg*term));
+
+            const Real freq = std::log(fwdPrice/strike);
+
+            // h[0] and h[1..n] integrate the characteristic function
+            // and its gradient, h[n+1] and h[n+2] the one of the
+            // control variate and its derivative w.r.t. vAvg
+            Array h(n+3, 0.0);
+            for (Size i=x.size(); i-- > 0;) {
+                if (w[i] == 0.0)
+                    continue;
+
+                const Real u = x[i];
+                const std::complex<Real> z(u, -0.5);
+                const std::complex<Real> zz = z*z + std::complex<Real>(0.5, u);
+                const std::complex<Real> e =
+                    std::exp(std::complex<Real>(0.0, u*freq))
+                    *(w[i]/(u*u + 0.25));
+
+                const std::complex<Real> f =
+                    std::exp(lnChFGradient(z, term, lnChFGrad))*e;
+                const std::complex<Real> fBS =
+                    std::exp(-0.5*vAvg*term*zz)*e;
+
+                h[0] += f.real();
+                for (Size k=0; k < n; ++k)
+                    h[k+1] += (f*lnChFGrad[k]).real();
+                h[n+1] += fBS.real();
+                h[n+2] += (-0.5*term*zz*fBS).real();
+            }
+
+            const Real scale =
+                std::sqrt(strike*fwdPrice)*riskFreeDiscount/M_PI;
+            const Real dValue_dvAvg =
+                riskFreeDiscount*black.vega(term)/(2.0*std::sqrt(vAvg))
+                + scale*h[n+2];
+
+            callValue = riskFreeDiscount*black.value()
+                + scale*(h[n+1] - h[0]);
+            for (Size k=0; k < n; ++k)
+                gradient[k] = dValue_dvAvg*vAvgGrad[k] - scale*h[k+1];
+          }
+          break;
+          default:
+            QL_FAIL("analytic gradient not supported "
+                    "for this complex log formula");
+        }
+
+        switch (type) {
+          case Option::Call:
+            return callValue;
+          case Option::Put:
+            return callValue - riskFreeDiscount*(fwdPrice - strike);
+          default:
+            QL_FAIL("unknown option type");
+        }
+    }
+
+    std::vector<Real> AnalyticHestonEngine::values(
+        const std::vector<ext::shared_ptr<VanillaOption> >& options) const {
+
+        std::map<Date, std::vector<Size> > expiries;
+        for (Size i=0; i < options.size(); ++i) {
+            QL_REQUIRE(options[i]->exercise()->type() == Exercise::European,
+                       "not an European option");
+            expiries[options[i]->exercise()->lastDate()].push_back(i);
+        }
+
+        std::vector<Real> npvs(options.size());
+        Size evaluations = 0;
+        for (const auto& expiry : expiries) {
+            const std::vector<Size>& idx = expiry.second;
+
+            std::vector<Option::Type> types(idx.size());
+            std::vector<Real> strikes(idx.size());
+            for (Size k=0; k < idx.size(); ++k) {
+                const ext::shared_ptr<PlainVanillaPayoff> payoff =
+                    ext::dynamic_pointer_cast<PlainVanillaPayoff>(
+                        options[idx[k]]->payoff());
+                QL_REQUIRE(payoff, "non plain vanilla payoff given");
+
+                types[k] = payoff->optionType();
+                strikes[k] = payoff->strike();
+            }
+
+            const std::vector<Real> v = values(expiry.first, types, strikes);
+            evaluations += evaluations_;
+
+            for (Size k=0; k < idx.size(); ++k)
+                npvs[idx[k]] = v[k];
+        }
+        evaluations_ = evaluations;
+
+        return npvs;
+    }
+
 
     AnalyticHestonEngine::Integration::Integration(
             Algorithm intAlgo,
@@ -825,6 +1296,46 @@ namespace QuantLib {
             || intAlgo_ == Trapezoid;
     }
 
+    bool AnalyticHestonEngine::Integration::isGaussianQuadrature() const {
+        return gaussianQuadrature_ != nullptr;
+    }
+
+    bool AnalyticHestonEngine::Integration::hasParameterIndependentNodes()
+    const {
+        return intAlgo_ == GaussLaguerre;
+    }
+
+    Array AnalyticHestonEngine::Integration::nodes(Real c_inf) const {
+        QL_REQUIRE(isGaussianQuadrature(), "Gaussian quadrature required");
+
+        const Array& x = gaussianQuadrature_->x();
+        if (intAlgo_ == GaussLaguerre)
+            return x;
+
+        // variable transformation of integrand1
+        Array u(x.size());
+        for (Size i=0; i < x.size(); ++i)
+            u[i] = -std::log(0.5-0.5*x[i])/c_inf;
+
+        return u;
+    }
+
+    Array AnalyticHestonEngine::Integration::weights(Real c_inf) const {
+        QL_REQUIRE(isGaussianQuadrature(), "Gaussian quadrature required");
+
+        const Array& w = gaussianQuadrature_->weights();
+        if (intAlgo_ == GaussLaguerre)
+            return w;
+
+        const Array& x = gaussianQuadrature_->x();
+        Array v(w.size(), 0.0);
+        for (Size i=0; i < w.size(); ++i)
+            if ((1.0-x[i])*c_inf > QL_EPSILON)
+                v[i] = w[i]/((1.0-x[i])*c_inf);
+
+        return v;
+    }
+
     Real AnalyticHestonEngine::Integration::calculate(
         Real c_inf,
         const ext::function<Real(Real)>& f,
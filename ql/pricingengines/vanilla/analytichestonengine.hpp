@@ -33,6 +33,7 @@
 #include <ql/instruments/vanillaoption.hpp>
 #include <ql/functional.hpp>
 #include <complex>
+#include <vector>
 
 namespace QuantLib {
 
@@ -129,9 +130,50 @@ namespace QuantLib {
         std::complex<Real> chF(const std::complex<Real>& z, Time t) const;
         std::complex<Real> lnChF(const std::complex<Real>& z, Time t) const;
 
+        // logarithm of the normalized characteristic function including
+        // the add-on term of extended models and its derivatives w.r.t.
+        // the model parameters in the order given by model->params()
+        std::complex<Real> lnChFGradient(
+            const std::complex<Real>& z, Time t,
+            std::vector<std::complex<Real> >& gradient) const;
+
         void calculate() const override;
         Size numberOfEvaluations() const;
 
+        // batch pricing of plain vanilla options with a common expiry.
+        // The characteristic function is evaluated only once per
+        // integration node, the strike dependent factor is applied
+        // by an inner product over the nodes. Requires a non-adaptive
+        // Gaussian quadrature.
+        std::vector<Real> values(const Date& maturity,
+                                 const std::vector<Option::Type>& types,
+                                 const std::vector<Real>& strikes) const;
+
+        // batch pricing of european plain vanilla options.
+        // Options are grouped by expiry and priced as strike strips.
+        std::vector<Real> values(
+            const std::vector<ext::shared_ptr<VanillaOption> >& options) const;
+
+        // value of a plain vanilla option and its gradient w.r.t. the
+        // model parameters based on the closed-form derivatives of the
+        // characteristic function. The value is the one of calculate()
+        // using the engine's complex log formula and control variate.
+        // The engine state is not modified, hence the method can be
+        // called concurrently. Requires supportsValueGradient().
+        Real valueAndGradient(Array& gradient,
+                              const Date& maturity,
+                              Option::Type type,
+                              Real strike) const;
+
+        // whether valueAndGradient() is available for the current
+        // model parameters. The integration nodes must not depend on
+        // the model parameters, the volatility of variance must not be
+        // too small and the complex log formula must be neither
+        // AsymptoticChF nor OptimalCV. Engines adding terms to the
+        // characteristic function must override it, returning false
+        // unless they also override addOnTermGradient().
+        virtual bool supportsValueGradient() const;
+
         static void doCalculation(Real riskFreeDiscount,
                                   Real dividendDiscount,
                                   Real spotPrice,
@@ -163,6 +205,9 @@ namespace QuantLib {
             Real operator()(Real u) const;
             Real controlVariateValue() const;
 
+            // strike independent part of the integrand
+            std::complex<Real> chFDifference(Real u) const;
+
           private:
             const Time term_;
             const Real fwd_, strike_, freq_;
@@ -179,6 +224,19 @@ namespace QuantLib {
                                              Time t,
                                              Size j) const;
 
+        // call back for the analytic gradient of extended models:
+        // returns the add-on term of the log characteristic function
+        // at z and sets its derivatives w.r.t. the additional model
+        // parameters, which follow the Heston parameters in params()
+        virtual std::complex<Real> addOnTermGradient(
+            const std::complex<Real>& z,
+            Time t,
+            std::vector<std::complex<Real> >& gradient) const;
+
+        // conditions on the integration, the complex log formula and
+        // the Heston parameters for the analytic gradient
+        bool hestonGradientAvailable() const;
+
       private:
         class Fj_Helper;
 
@@ -227,6 +285,15 @@ namespace QuantLib {
 
         Size numberOfEvaluations() const;
         bool isAdaptiveIntegration() const;
+        bool isGaussianQuadrature() const;
+        // whether the integration nodes are independent of c_inf,
+        // hence of the model parameters
+        bool hasParameterIndependentNodes() const;
+
+        // abscissas and weights of the Gaussian quadratures
+        // mapped onto the Fourier integration domain [0, \infty)
+        Array nodes(Real c_inf) const;
+        Array weights(Real c_inf) const;
 
       private:
         enum Algorithm
@@ -79,6 +79,9 @@ namespace QuantLib {
         void update() override;
         void calculate() const override;
 
+        // no gradient is available for the add-on term
+        bool supportsValueGradient() const override { return false; }
+
       protected:
         std::complex<Real> addOnTerm(Real phi, Time t, Size j) const override;
 
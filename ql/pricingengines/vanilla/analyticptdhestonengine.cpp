@@ -208,6 +208,107 @@ namespace QuantLib {
         return std::exp(lnChF(z, T));
     }
 
+    std::complex<Real> AnalyticPTDHestonEngine::lnChFGradient(
+        const std::complex<Real>& z, Time T,
+        std::vector<std::complex<Real> >& gradient) const {
+
+        const Real v0 = model_->v0();
+
+        const Size n = model_->params().size();
+        std::vector<std::complex<Real> > dC(n), dD(n);
+
+        std::complex<Real> D = 0.0;
+        std::complex<Real> C = 0.0;
+
+        const TimeGrid& timeGrid = model_->timeGrid();
+        const Time lastModelTime = timeGrid.back();
+
+        QL_REQUIRE(T <= lastModelTime,
+                   "maturity (" << T << ") is too large, "
+                   "time grid is bounded by " << lastModelTime);
+
+        const Size lastI = std::distance(timeGrid.begin(),
+            std::lower_bound(timeGrid.begin(), timeGrid.end(), T));
+
+        const std::complex<Real> iz(-z.imag(), z.real());
+        const std::complex<Real> zz = z*z + iz;
+
+        for (Integer i=lastI-1; i >= 0; --i) {
+            const Time begin = timeGrid[i];
+            const Time end = std::min(T, timeGrid[i+1]);
+            const Time tau = end - begin;
+
+            const Time t     = 0.5*(end+begin);
+            const Real kappa = model_->kappa(t);
+            const Real sigma = model_->sigma(t);
+            const Real theta = model_->theta(t);
+            const Real rho   = model_->rho(t);
+
+            const Matrix s = model_->parameterSensitivities(t);
+
+            const Real sigma2 = sigma*sigma;
+            const Real sigma3 = sigma2*sigma;
+
+            const std::complex<Real> k = kappa - rho*sigma*iz;
+            const std::complex<Real> d = std::sqrt(k*k + zz*sigma2);
+            const std::complex<Real> g = (k-d)/(k+d);
+
+            const std::complex<Real> nom = k-d-D*sigma2;
+            const std::complex<Real> den = k+d-D*sigma2;
+            const std::complex<Real> gt = nom/den;
+            const std::complex<Real> e = std::exp(-d*tau);
+
+            const std::complex<Real> Q
+                = (k-d)*tau - 2.0*std::log((1.0-gt*e)/(1.0-gt));
+            const std::complex<Real> R = (k+d)/sigma2;
+            const std::complex<Real> W = (g - gt*e)/(1.0 - gt*e);
+
+            for (Size q=0; q < n; ++q) {
+                const Real dTheta = s[0][q];
+                const Real dKappa = s[1][q];
+                const Real dSigma = s[2][q];
+                const Real dRho   = s[3][q];
+
+                const std::complex<Real> dk
+                    = dKappa - (dRho*sigma + rho*dSigma)*iz;
+                const std::complex<Real> dd = (k*dk + zz*sigma*dSigma)/d;
+                const std::complex<Real> dg = 2.0*(d*dk - k*dd)/((k+d)*(k+d));
+
+                const std::complex<Real> dDs
+                    = dD[q]*sigma2 + 2.0*D*sigma*dSigma;
+                const std::complex<Real> dgt
+                    = ((dk-dd-dDs)*den - nom*(dk+dd-dDs))/(den*den);
+                const std::complex<Real> de = -tau*e*dd;
+                const std::complex<Real> dge = dgt*e + gt*de;
+
+                const std::complex<Real> dQ = (dk-dd)*tau
+                    + 2.0*dge/(1.0-gt*e) - 2.0*dgt/(1.0-gt);
+                const Real dP = (dKappa*theta + kappa*dTheta)/sigma2
+                    - 2.0*kappa*theta*dSigma/sigma3;
+                const std::complex<Real> dR
+                    = (dk+dd)/sigma2 - 2.0*(k+d)*dSigma/sigma3;
+                const std::complex<Real> dW
+                    = ((dg - dge)*(1.0 - gt*e) + (g - gt*e)*dge)
+                      /((1.0 - gt*e)*(1.0 - gt*e));
+
+                dC[q] += dP*Q + kappa*theta/sigma2*dQ;
+                dD[q] = dR*W + R*dW;
+            }
+
+            C += kappa*theta/sigma2*Q;
+            D = R*W;
+        }
+
+        gradient.resize(n);
+        for (Size q=0; q < n; ++q)
+            gradient[q] = dC[q] + v0*dD[q];
+
+        // v0 is the last model parameter
+        gradient[n-1] += D;
+
+        return C + v0*D;
+    }
+
     AnalyticPTDHestonEngine::AnalyticPTDHestonEngine(
         const ext::shared_ptr<PiecewiseTimeDependentHestonModel>& model,
         Size integrationOrder)
@@ -249,6 +350,101 @@ namespace QuantLib {
     }
 
 
+    bool AnalyticPTDHestonEngine::supportsValueGradient() const {
+        // the gradient ignores the dependency of c_inf on the parameters
+        if (!integration_->hasParameterIndependentNodes())
+            return false;
+        const TimeGrid& timeGrid = model_->timeGrid();
+        for (Size i=1; i < timeGrid.size(); ++i)
+            if (model_->sigma(0.5*(timeGrid[i-1] + timeGrid[i])) <= 1e-4)
+                return false;
+        return true;
+    }
+
+    Real AnalyticPTDHestonEngine::valueAndGradient(
+        Array& gradient,
+        const Date& maturity,
+        Option::Type type,
+        Real strike) const {
+
+        QL_REQUIRE(supportsValueGradient(),
+                   "analytic gradient not supported by this integration "
+                   "or model parameters");
+
+        const Real v0 = model_->v0();
+        const Real spotPrice = model_->s0();
+        QL_REQUIRE(spotPrice > 0.0, "negative or null underlying given");
+        QL_REQUIRE(strike > 0.0, "non-positive strike given");
+
+        const Real term
+            = model_->riskFreeRate()->dayCounter().yearFraction(
+                                     model_->riskFreeRate()->referenceDate(),
+                                     maturity);
+
+        const Real riskFreeDiscount = model_->riskFreeRate()->discount(maturity);
+        const Real dividendDiscount = model_->dividendYield()->discount(maturity);
+
+        const Real fwdPrice = spotPrice*dividendDiscount/riskFreeDiscount;
+        const Real freq = std::log(fwdPrice/strike);
+
+        //average values
+        const TimeGrid& timeGrid = model_->timeGrid();
+        QL_REQUIRE(timeGrid.size() > 1, "at least two model points needed");
+
+        const Size nT = timeGrid.size()-1;
+        Real kappaAvg = 0.0, thetaAvg = 0.0,  sigmaAvg=0.0, rhoAvg = 0.0;
+
+        for (Size i=1; i <= nT; ++i) {
+            const Time t = 0.5*(timeGrid[i-1] + timeGrid[i]);
+            kappaAvg += model_->kappa(t);
+            thetaAvg += model_->theta(t);
+            sigmaAvg += model_->sigma(t);
+            rhoAvg   += model_->rho(t);
+        }
+        kappaAvg/=nT; thetaAvg/=nT; sigmaAvg/=nT; rhoAvg/=nT;
+
+        const Real c_inf = std::sqrt(1.0-rhoAvg*rhoAvg)
+            *(v0 + kappaAvg*thetaAvg*term)/sigmaAvg;
+
+        const Size n = model_->params().size();
+
+        Array h(n+1, 0.0);
+        const Array x = integration_->nodes(c_inf);
+        const Array w = integration_->weights(c_inf);
+
+        std::vector<std::complex<Real> > lnChFGrad;
+        for (Size i=x.size(); i-- > 0;) {
+            if (w[i] == 0.0)
+                continue;
+
+            const Real u = x[i];
+            const std::complex<Real> f = std::exp(
+                lnChFGradient(std::complex<Real>(u, -0.5), term, lnChFGrad)
+                + std::complex<Real>(0.0, u*freq))*(w[i]/(u*u + 0.25));
+
+            h[0] += f.real();
+            for (Size k=0; k < n; ++k)
+                h[k+1] += (f*lnChFGrad[k]).real();
+        }
+
+        const Real scale = std::sqrt(strike*fwdPrice)*riskFreeDiscount/M_PI;
+
+        gradient = Array(n);
+        for (Size k=0; k < n; ++k)
+            gradient[k] = -scale*h[k+1];
+
+        const Real callValue = riskFreeDiscount*fwdPrice - scale*h[0];
+
+        switch (type) {
+          case Option::Call:
+            return callValue;
+          case Option::Put:
+            return callValue - riskFreeDiscount*(fwdPrice - strike);
+          default:
+            QL_FAIL("unknown option type");
+        }
+    }
+
     void AnalyticPTDHestonEngine::calculate() const {
         // this is an european option pricer
         QL_REQUIRE(arguments_.exercise->type() == Exercise::European,
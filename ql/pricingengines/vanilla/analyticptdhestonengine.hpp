@@ -87,6 +87,27 @@ namespace QuantLib {
         std::complex<Real> chF(const std::complex<Real>& z, Time t) const;
         std::complex<Real> lnChF(const std::complex<Real>& z, Time t) const;
 
+        // logarithm of the normalized characteristic function and its
+        // derivatives w.r.t. the model parameters in the order of params()
+        std::complex<Real> lnChFGradient(
+            const std::complex<Real>& z, Time t,
+            std::vector<std::complex<Real> >& gradient) const;
+
+        // value of a plain vanilla option and its gradient w.r.t. the
+        // model parameters based on the closed-form derivatives of the
+        // characteristic function. The engine state is not modified,
+        // hence the method can be called concurrently.
+        // Requires supportsValueGradient().
+        Real valueAndGradient(Array& gradient,
+                              const Date& maturity,
+                              Option::Type type,
+                              Real strike) const;
+
+        // whether valueAndGradient() is available: the integration
+        // nodes must not depend on the model parameters, and the
+        // volatility of variance must not be too small
+        bool supportsValueGradient() const;
+
       private:
         class Fj_Helper;
         class AP_Helper;
@@ -48,6 +48,37 @@ namespace QuantLib {
                           -g*(std::exp(nu_+delta2_) - 1.0));
     }
 
+    bool BatesEngine::supportsValueGradient() const {
+        return hestonGradientAvailable();
+    }
+
+    std::complex<Real> BatesEngine::addOnTermGradient(
+        const std::complex<Real>& z, Time t,
+        std::vector<std::complex<Real> >& gradient) const {
+
+        QL_REQUIRE(gradient.size() == 8,
+                   "analytic gradient is not supported for this model");
+
+        ext::shared_ptr<BatesModel> batesModel =
+                            ext::dynamic_pointer_cast<BatesModel>(*model_);
+
+        const Real nu     = batesModel->nu();
+        const Real delta  = batesModel->delta();
+        const Real delta2 = 0.5*delta*delta;
+        const Real lambda = batesModel->lambda();
+
+        const std::complex<Real> g(-z.imag(), z.real());
+        const std::complex<Real> jump = std::exp(nu*g + delta2*g*g);
+        const Real drift = std::exp(nu+delta2);
+
+        // parameter order: nu, delta, lambda
+        gradient[5] = t*lambda*(g*jump - g*drift);
+        gradient[6] = t*lambda*delta*(g*g*jump - g*drift);
+        gradient[7] = t*(jump - 1.0 - g*(drift - 1.0));
+
+        return lambda*gradient[7];
+    }
+
 
     BatesDetJumpEngine::BatesDetJumpEngine(
         const ext::shared_ptr<BatesDetJumpModel>& model,
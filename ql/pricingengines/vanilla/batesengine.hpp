@@ -110,8 +110,14 @@ namespace QuantLib {
         BatesEngine(const ext::shared_ptr<BatesModel>& model,
                     Real relTolerance, Size maxEvaluations);
 
+        bool supportsValueGradient() const override;
+
       protected:
         std::complex<Real> addOnTerm(Real phi, Time t, Size j) const override;
+        std::complex<Real> addOnTermGradient(
+            const std::complex<Real>& z,
+            Time t,
+            std::vector<std::complex<Real> >& gradient) const override;
     };
 
 
@@ -122,6 +128,9 @@ namespace QuantLib {
         BatesDetJumpEngine(const ext::shared_ptr<BatesDetJumpModel>& model,
                            Real relTolerance, Size maxEvaluations);
 
+        // the gradient of the Bates add-on term doesn't apply
+        bool supportsValueGradient() const override { return false; }
+
       protected:
         std::complex<Real> addOnTerm(Real phi, Time t, Size j) const override;
     };
@@ -136,6 +145,9 @@ namespace QuantLib {
             const ext::shared_ptr<BatesDoubleExpModel>& model,
             Real relTolerance, Size maxEvaluations);
 
+        // no gradient is available for the add-on term
+        bool supportsValueGradient() const override { return false; }
+
       protected:
         std::complex<Real> addOnTerm(Real phi, Time t, Size j) const override;
     };
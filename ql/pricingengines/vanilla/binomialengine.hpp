@@ -35,12 +35,25 @@
 #include <ql/processes/blackscholesprocess.hpp>
 #include <ql/termstructures/yield/flatforward.hpp>
 #include <ql/termstructures/volatility/equityfx/blackconstantvol.hpp>
+#include <list>
+#include <map>
 
 namespace QuantLib {
 
     //! Pricing engine for vanilla options using binomial trees
     /*! \ingroup vanillaengines
 
+        The underlying values and transition probabilities of the
+        trees are cached, so that options with the same maturity don't
+        need to rebuild them.  Trees depending on the strike (see
+        BinomialTreeDependsOnStrike) are not cached, since they would
+        pile up when pricing across the smile.  At most maxCachedTrees
+        trees are kept, the least recently used being discarded first;
+        the cache is cleared when the process changes.  The backward
+        induction works on contiguous arrays of node values, and
+        options sharing their exercise can be priced together by means
+        of the batchCalculate() method.
+
         \test the correctness of the returned values is tested by
               checking it against analytic results.
 
@@ -55,25 +68,65 @@ namespace QuantLib {
       public:
         BinomialVanillaEngine(
              const ext::shared_ptr<GeneralizedBlackScholesProcess>& process,
-             Size timeSteps)
-        : process_(process), timeSteps_(timeSteps) {
+             Size timeSteps,
+             Size maxCachedTrees = 4)
+        : process_(process), timeSteps_(timeSteps),
+          maxCachedTrees_(maxCachedTrees) {
             QL_REQUIRE(timeSteps >= 2,
                        "at least 2 time steps required, "
                        << timeSteps << " provided");
             registerWith(process_);
         }
         void calculate() const override;
+        void update() override;
+        /*! returns the value, delta, gamma and theta of options with
+            the given payoffs and a common exercise; the options are
+            priced in parallel when OpenMP is enabled.
+        */
+        std::vector<VanillaOption::results> batchCalculate(
+              const std::vector<ext::shared_ptr<PlainVanillaPayoff> >& payoffs,
+              const ext::shared_ptr<Exercise>& exercise) const;
 
       private:
+        // underlying values and transition data of a tree
+        struct Geometry {
+            TimeGrid grid;
+            Real pu, pd;
+            DiscountFactor discount;
+            std::vector<Array> underlying;
+        };
+        typedef std::vector<Real> Key;
+        // most recently used keys first
+        typedef std::list<Key> Recency;
+        typedef std::pair<ext::shared_ptr<Geometry>,
+                          typename Recency::iterator> CacheEntry;
+        ext::shared_ptr<Geometry> geometry(const Date& maturityDate,
+                                           Real strike) const;
+        void rollback(const Geometry& geometry,
+                      const PlainVanillaPayoff& payoff,
+                      const std::vector<bool>& exercisable,
+                      VanillaOption::results& results) const;
         ext::shared_ptr<GeneralizedBlackScholesProcess> process_;
         Size timeSteps_;
+        Size maxCachedTrees_;
+        mutable std::map<Key, CacheEntry> geometries_;
+        mutable Recency recency_;
     };
 
 
     // template definitions
 
     template <class T>
-    void BinomialVanillaEngine<T>::calculate() const {
+    void BinomialVanillaEngine<T>::update() {
+        geometries_.clear();
+        recency_.clear();
+        VanillaOption::engine::update();
+    }
+
+    template <class T>
+    ext::shared_ptr<typename BinomialVanillaEngine<T>::Geometry>
+    BinomialVanillaEngine<T>::geometry(const Date& maturityDate,
+                                       Real strike) const {
 
         DayCounter rfdc  = process_->riskFreeRate()->dayCounter();
         DayCounter divdc = process_->dividendYield()->dayCounter();
@@ -83,13 +136,33 @@ namespace QuantLib {
         Real s0 = process_->stateVariable()->value();
         QL_REQUIRE(s0 > 0.0, "negative or null underlying given");
         Volatility v = process_->blackVolatility()->blackVol(
-            arguments_.exercise->lastDate(), s0);
-        Date maturityDate = arguments_.exercise->lastDate();
+            maturityDate, s0);
         Rate r = process_->riskFreeRate()->zeroRate(maturityDate,
             rfdc, Continuous, NoFrequency);
         Rate q = process_->dividendYield()->zeroRate(maturityDate,
             divdc, Continuous, NoFrequency);
         Date referenceDate = process_->riskFreeRate()->referenceDate();
+        Time maturity = rfdc.yearFraction(referenceDate, maturityDate);
+
+        // trees for different strikes are not shared; avoid piling
+        // them up when pricing across the smile
+        const bool cached = maxCachedTrees_ > 0
+            && !BinomialTreeDependsOnStrike<T>::value;
+        Key key(5);
+        key[0] = maturity;
+        key[1] = s0;
+        key[2] = r;
+        key[3] = q;
+        key[4] = v;
+        if (cached) {
+            typename std::map<Key, CacheEntry>::iterator it =
+                geometries_.find(key);
+            if (it != geometries_.end()) {
+                recency_.splice(recency_.begin(), recency_,
+                                it->second.second);
+                return it->second.first;
+            }
+        }
 
         // binomial trees with constant coefficient
         Handle<YieldTermStructure> flatRiskFree(
@@ -102,74 +175,165 @@ namespace QuantLib {
             ext::shared_ptr<BlackVolTermStructure>(
                 new BlackConstantVol(referenceDate, volcal, v, voldc)));
 
-        ext::shared_ptr<PlainVanillaPayoff> payoff =
-            ext::dynamic_pointer_cast<PlainVanillaPayoff>(arguments_.payoff);
-        QL_REQUIRE(payoff, "non-plain payoff given");
-
-        Time maturity = rfdc.yearFraction(referenceDate, maturityDate);
-
         ext::shared_ptr<StochasticProcess1D> bs(
                          new GeneralizedBlackScholesProcess(
                                       process_->stateVariable(),
                                       flatDividends, flatRiskFree, flatVol));
 
-        TimeGrid grid(maturity, timeSteps_);
+        T tree(bs, maturity, timeSteps_, strike);
+
+        ext::shared_ptr<Geometry> geometry(new Geometry);
+        geometry->grid = TimeGrid(maturity, timeSteps_);
+        geometry->pd = tree.probability(0, 0, 0);
+        geometry->pu = tree.probability(0, 0, 1);
+        geometry->discount = std::exp(-r*(maturity/timeSteps_));
+        geometry->underlying.resize(timeSteps_+1);
+        for (Size i=0; i<=timeSteps_; i++) {
+            Array& underlying = geometry->underlying[i];
+            underlying.resize(tree.size(i));
+            for (Size j=0; j<underlying.size(); j++)
+                underlying[j] = tree.underlying(i, j);
+        }
 
-        ext::shared_ptr<T> tree(new T(bs, maturity, timeSteps_,
-                                        payoff->strike()));
+        if (!cached)
+            return geometry;
+        if (geometries_.size() >= maxCachedTrees_) {
+            geometries_.erase(recency_.back());
+            recency_.pop_back();
+        }
+        recency_.push_front(key);
+        geometries_[key] = CacheEntry(geometry, recency_.begin());
+        return geometry;
+    }
 
-        ext::shared_ptr<BlackScholesLattice<T> > lattice(
-            new BlackScholesLattice<T>(tree, r, maturity, timeSteps_));
+    template <class T>
+    void BinomialVanillaEngine<T>::rollback(
+                                    const Geometry& geometry,
+                                    const PlainVanillaPayoff& payoff,
+                                    const std::vector<bool>& exercisable,
+                                    VanillaOption::results& results) const {
+
+        const Real w = (payoff.optionType() == Option::Call ? 1.0 : -1.0);
+        const Real strike = payoff.strike();
+        const Real pu = geometry.pu, pd = geometry.pd;
+        const DiscountFactor discount = geometry.discount;
+
+        // option values are set at maturity by the exercise condition
+        const Size n = timeSteps_;
+        Array values(n+1, 0.0);
+
+        Real p[3], sn[3];
+        for (Size i=n+1; i-- > 0; ) {
+            Real* v = values.begin();
+            if (i < n) {
+                // values[j] is overwritten after values[j+1] was read
+                for (Size j=0; j<=i; j++)
+                    v[j] = (pd*v[j] + pu*v[j+1])*discount;
+            }
+            if (exercisable[i]) {
+                const Real* s = geometry.underlying[i].begin();
+                for (Size j=0; j<=i; j++)
+                    v[j] = std::max(v[j], std::max(w*(s[j]-strike), 0.0));
+            }
+            // Partial derivatives calculated from various points in
+            // the binomial tree (see J.C.Hull, "Options, Futures and
+            // other derivatives", 6th edition, pp 397/398)
+            if (i == 2 || i == 1) {
+                std::copy(v, v+i+1, p);
+                std::copy(geometry.underlying[i].begin(),
+                          geometry.underlying[i].end(), sn);
+            }
+            if (i == 2) {
+                // gamma is the first derivative of the two deltas
+                Real delta2u = (p[2]-p[1])/(sn[2]-sn[1]);
+                Real delta2d = (p[1]-p[0])/(sn[1]-sn[0]);
+                results.gamma = (delta2u - delta2d) / ((sn[2]-sn[0])/2);
+            } else if (i == 1) {
+                results.delta = (p[1]-p[0]) / (sn[1]-sn[0]);
+            }
+        }
 
-        DiscretizedVanillaOption option(arguments_, *process_, grid);
+        results.value = values[0];
+    }
 
-        option.initialize(lattice, maturity);
+    template <class T>
+    std::vector<VanillaOption::results>
+    BinomialVanillaEngine<T>::batchCalculate(
+              const std::vector<ext::shared_ptr<PlainVanillaPayoff> >& payoffs,
+              const ext::shared_ptr<Exercise>& exercise) const {
+
+        QL_REQUIRE(exercise, "no exercise given");
+        Date maturityDate = exercise->lastDate();
+
+        // the trees are built (or retrieved) before pricing in parallel
+        std::vector<ext::shared_ptr<Geometry> > geometries(payoffs.size());
+        for (Size k=0; k<payoffs.size(); k++) {
+            QL_REQUIRE(payoffs[k], "non-plain payoff given");
+            geometries[k] = geometry(maturityDate, payoffs[k]->strike());
+        }
 
-        // Partial derivatives calculated from various points in the
-        // binomial tree 
-        // (see J.C.Hull, "Options, Futures and other derivatives", 6th edition, pp 397/398)
+        std::vector<VanillaOption::results> results(payoffs.size());
+        if (payoffs.empty())
+            return results;
+
+        // levels at which the options can be exercised, as in
+        // DiscretizedVanillaOption
+        const TimeGrid& grid = geometries.front()->grid;
+        std::vector<Time> stoppingTimes(exercise->dates().size());
+        for (Size i=0; i<stoppingTimes.size(); ++i)
+            stoppingTimes[i] =
+                grid.closestTime(process_->time(exercise->date(i)));
+        std::vector<bool> exercisable(grid.size(), false);
+        for (Size i=0; i<grid.size(); i++) {
+            switch (exercise->type()) {
+              case Exercise::American:
+                exercisable[i] = (grid[i] <= stoppingTimes[1] &&
+                                  grid[i] >= stoppingTimes[0]);
+                break;
+              case Exercise::European:
+              case Exercise::Bermudan:
+                for (Size k=0; k<stoppingTimes.size(); k++) {
+                    if (close_enough(stoppingTimes[k], grid[i]))
+                        exercisable[i] = true;
+                }
+                break;
+              default:
+                QL_FAIL("invalid option type");
+            }
+        }
 
-        // Rollback to third-last step, and get underlying prices (s2) &
-        // option values (p2) at this point
-        option.rollback(grid[2]);
-        Array va2(option.values());
-        QL_ENSURE(va2.size() == 3, "Expect 3 nodes in grid at second step");
-        Real p2u = va2[2]; // up
-        Real p2m = va2[1]; // mid
-        Real p2d = va2[0]; // down (low)
-        Real s2u = lattice->underlying(2, 2); // up price
-        Real s2m = lattice->underlying(2, 1); // middle price
-        Real s2d = lattice->underlying(2, 0); // down (low) price
+        const long n = static_cast<long>(payoffs.size());
+        #pragma omp parallel for
+        for (long k=0; k<n; k++) {
+            results[k].reset();
+            rollback(*geometries[k], *payoffs[k], exercisable, results[k]);
+        }
 
-        // calculate gamma by taking the first derivate of the two deltas
-        Real delta2u = (p2u - p2m)/(s2u-s2m);
-        Real delta2d = (p2m-p2d)/(s2m-s2d);
-        Real gamma = (delta2u - delta2d) / ((s2u-s2d)/2);
+        // theta queries the process, which is not done in parallel
+        for (Size k=0; k<results.size(); k++)
+            results[k].theta = blackScholesTheta(process_,
+                                                 results[k].value,
+                                                 results[k].delta,
+                                                 results[k].gamma);
+        return results;
+    }
 
-        // Rollback to second-last step, and get option values (p1) at
-        // this point
-        option.rollback(grid[1]);
-        Array va(option.values());
-        QL_ENSURE(va.size() == 2, "Expect 2 nodes in grid at first step");
-        Real p1u = va[1];
-        Real p1d = va[0];
-        Real s1u = lattice->underlying(1, 1); // up (high) price
-        Real s1d = lattice->underlying(1, 0); // down (low) price
+    template <class T>
+    void BinomialVanillaEngine<T>::calculate() const {
 
-        Real delta = (p1u - p1d) / (s1u - s1d);
+        ext::shared_ptr<PlainVanillaPayoff> payoff =
+            ext::dynamic_pointer_cast<PlainVanillaPayoff>(arguments_.payoff);
+        QL_REQUIRE(payoff, "non-plain payoff given");
 
-        // Finally, rollback to t=0
-        option.rollback(0.0);
-        Real p0 = option.presentValue();
+        VanillaOption::results results = batchCalculate(
+            std::vector<ext::shared_ptr<PlainVanillaPayoff> >(1, payoff),
+            arguments_.exercise).front();
 
         // Store results
-        results_.value = p0;
-        results_.delta = delta;
-        results_.gamma = gamma;
-        results_.theta = blackScholesTheta(process_,
-                                           results_.value,
-                                           results_.delta,
-                                           results_.gamma);
+        results_.value = results.value;
+        results_.delta = results.delta;
+        results_.gamma = results.gamma;
+        results_.theta = results.theta;
     }
 
 }
@@ -20,6 +20,8 @@
 #include <ql/math/functional.hpp>
 #include <ql/pricingengines/vanilla/coshestonengine.hpp>
 
+#include <map>
+
 namespace QuantLib {
 
     COSHestonEngine::COSHestonEngine(
@@ -109,6 +111,111 @@ namespace QuantLib {
             QL_FAIL("unknown payoff type");
     }
 
+    std::vector<Real> COSHestonEngine::values(
+        const Date& maturityDate,
+        const std::vector<Option::Type>& types,
+        const std::vector<Real>& strikes) const {
+
+        QL_REQUIRE(types.size() == strikes.size(),
+                   "number of option types (" << types.size()
+                   << ") differs from number of strikes ("
+                   << strikes.size() << ")");
+
+        const ext::shared_ptr<HestonProcess> process = model_->process();
+        const Time maturity = process->time(maturityDate);
+
+        const Real cum1 = c1(maturity);
+        const Real w = std::sqrt(std::fabs(c2(maturity)));
+
+        const Real spot = process->s0()->value();
+        QL_REQUIRE(spot > 0.0, "negative or null underlying given");
+
+        const DiscountFactor df
+            = process->riskFreeRate()->discount(maturityDate);
+        const DiscountFactor qf
+            = process->dividendYield()->discount(maturityDate);
+        const Real fwd = spot*qf/df;
+
+        // a and b are shifted by the log-moneyness of each strike,
+        // x - a and the frequencies are the same for all strikes.
+        const Real d = 0.5/(L_*w);
+        const Real xma = L_*w - cum1;
+
+        std::vector<Real> cf(N_);
+        cf[0] = chF(0, maturity).real();
+        for (Size n=1; n < N_; ++n) {
+            const Real r = n*M_PI*d;
+            cf[n] = (chF(r, maturity)
+                     *std::exp(std::complex<Real>(0, r*xma))).real();
+        }
+
+        std::vector<Real> values(strikes.size());
+        for (Size k=0; k < strikes.size(); ++k) {
+            const Real strike = strikes[k];
+            QL_REQUIRE(strike > 0.0, "non-positive strike given");
+
+            const Real a = std::log(fwd/strike) - xma;
+            const Real expA = std::exp(a);
+
+            Real s = cf[0]*(expA-1-a)*d;
+            for (Size n=1; n < N_; ++n) {
+                const Real r = n*M_PI*d;
+                const Real sinRA = std::sin(r*a), cosRA = std::cos(r*a);
+                const Real U_n = 2.0*d*( 1.0/(1.0 + r*r)
+                    *(expA + r*sinRA - cosRA) - 1.0/r*sinRA);
+
+                s += U_n*cf[n];
+            }
+
+            switch (types[k]) {
+              case Option::Put:
+                values[k] = strike*df*s;
+                break;
+              case Option::Call:
+                values[k] = spot*qf - strike*df*(1-s);
+                break;
+              default:
+                QL_FAIL("unknown payoff type");
+            }
+        }
+
+        return values;
+    }
+
+    std::vector<Real> COSHestonEngine::values(
+        const std::vector<ext::shared_ptr<VanillaOption> >& options) const {
+
+        std::map<Date, std::vector<Size> > expiries;
+        for (Size i=0; i < options.size(); ++i) {
+            QL_REQUIRE(options[i]->exercise()->type() == Exercise::European,
+                       "not an European option");
+            expiries[options[i]->exercise()->lastDate()].push_back(i);
+        }
+
+        std::vector<Real> npvs(options.size());
+        for (const auto& expiry : expiries) {
+            const std::vector<Size>& idx = expiry.second;
+
+            std::vector<Option::Type> types(idx.size());
+            std::vector<Real> strikes(idx.size());
+            for (Size k=0; k < idx.size(); ++k) {
+                const ext::shared_ptr<PlainVanillaPayoff> payoff =
+                    ext::dynamic_pointer_cast<PlainVanillaPayoff>(
+                        options[idx[k]]->payoff());
+                QL_REQUIRE(payoff, "non plain vanilla payoff given");
+
+                types[k] = payoff->optionType();
+                strikes[k] = payoff->strike();
+            }
+
+            const std::vector<Real> v = values(expiry.first, types, strikes);
+            for (Size k=0; k < idx.size(); ++k)
+                npvs[idx[k]] = v[k];
+        }
+
+        return npvs;
+    }
+
     Real COSHestonEngine::muT(Time t) const {
         return std::log(  model_->process()->dividendYield()->discount(t)
                         / model_->process()->riskFreeRate()->discount(t));
@@ -29,6 +29,7 @@
 #include <ql/pricingengines/genericmodelengine.hpp>
 
 #include <complex>
+#include <vector>
 
 namespace QuantLib {
 
@@ -61,6 +62,19 @@ namespace QuantLib {
         void update() override;
         void calculate() const override;
 
+        // batch pricing of plain vanilla options with a common expiry.
+        // The truncation range is fixed relative to the forward, hence
+        // the characteristic function is evaluated only once per
+        // series term for all strikes.
+        std::vector<Real> values(const Date& maturity,
+                                 const std::vector<Option::Type>& types,
+                                 const std::vector<Real>& strikes) const;
+
+        // batch pricing of european plain vanilla options.
+        // Options are grouped by expiry and priced as strike strips.
+        std::vector<Real> values(
+            const std::vector<ext::shared_ptr<VanillaOption> >& options) const;
+
         // normalized characteristic function
         std::complex<Real> chF(Real u, Real t) const;
 
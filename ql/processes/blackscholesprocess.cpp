@@ -77,8 +77,8 @@ namespace QuantLib {
         // we could be more anticipatory if we know the right dt
         // for which the drift will be used
         Time t1 = t + 0.0001;
-        return riskFreeRate_->forwardRate(t,t1,Continuous,NoFrequency,true)
-             - dividendYield_->forwardRate(t,t1,Continuous,NoFrequency,true)
+        return riskFreeRate_->forwardRate(t,t1,Continuous,NoFrequency,true).rate()
+             - dividendYield_->forwardRate(t,t1,Continuous,NoFrequency,true).rate()
              - 0.5 * sigma * sigma;
     }
 
@@ -98,9 +98,9 @@ namespace QuantLib {
             // exact value for curves
             return x0 *
                 std::exp(dt * (riskFreeRate_->forwardRate(t0, t0 + dt, Continuous,
-                                                          NoFrequency, true) -
+                                                          NoFrequency, true).rate() -
                              dividendYield_->forwardRate(
-                                 t0, t0 + dt, Continuous, NoFrequency, true)));
+                                 t0, t0 + dt, Continuous, NoFrequency, true).rate()));
         } else {
             QL_FAIL("not implemented");
         }
@@ -136,9 +136,9 @@ namespace QuantLib {
             // exact value for curves
             Real var = variance(t0, x0, dt);
             Real drift = (riskFreeRate_->forwardRate(t0, t0 + dt, Continuous,
-                                                     NoFrequency, true) -
+                                                     NoFrequency, true).rate() -
                           dividendYield_->forwardRate(t0, t0 + dt, Continuous,
-                                                      NoFrequency, true)) *
+                                                      NoFrequency, true).rate()) *
                              dt -
                          0.5 * var;
             return apply(x0, std::sqrt(var) * dw + drift);
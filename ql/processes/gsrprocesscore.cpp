@@ -57,12 +57,15 @@ void GsrProcessCore::flushCache() const {
             revZero_[i] = true;
         else
             revZero_[i] = false;
-    cache1_.clear();
-    cache2a_.clear();
-    cache2b_.clear();
-    cache3_.clear();
-    cache4_.clear();
-    cache5_.clear();
+    #pragma omp critical(gsrprocesscore_cache)
+    {
+        cache1_.clear();
+        cache2a_.clear();
+        cache2b_.clear();
+        cache3_.clear();
+        cache4_.clear();
+        cache5_.clear();
+    }
 }
 
 Real GsrProcessCore::expectation_x0dep_part(const Time w, const Real xw,
@@ -70,14 +73,21 @@ Real GsrProcessCore::expectation_x0dep_part(const Time w, const Real xw,
     Real t = w + dt;
     std::pair<Real, Real> key;
     key = std::make_pair(w, t);
-    std::map<std::pair<Real, Real>, Real>::const_iterator k = cache1_.find(key);
-    if (k != cache1_.end())
-        return xw * (k->second);
+    Real cached = Null<Real>();
+    #pragma omp critical(gsrprocesscore_cache)
+    {
+        std::map<std::pair<Real, Real>, Real>::const_iterator k = cache1_.find(key);
+        if (k != cache1_.end())
+            cached = k->second;
+    }
+    if (cached != Null<Real>())
+        return xw * cached;
     // A(w,t)x(w)
     Real res2 = 1.0;
     for (int i = lowerIndex(w); i <= upperIndex(t) - 1; i++) {
         res2 *= exp(-rev(i) * (cappedTime(i + 1, t) - flooredTime(i, w)));
     }
+    #pragma omp critical(gsrprocesscore_cache)
     cache1_.insert(std::make_pair(key, res2));
     return res2 * xw;
 }
@@ -89,10 +99,16 @@ Real GsrProcessCore::expectation_rn_part(const Time w,
 
     std::pair<Real, Real> key;
     key = std::make_pair(w, t);
-    std::map<std::pair<Real, Real>, Real>::const_iterator k =
-        cache2a_.find(key);
-    if (k != cache2a_.end())
-        return k->second;
+    Real cached = Null<Real>();
+    #pragma omp critical(gsrprocesscore_cache)
+    {
+        std::map<std::pair<Real, Real>, Real>::const_iterator k =
+            cache2a_.find(key);
+        if (k != cache2a_.end())
+            cached = k->second;
+    }
+    if (cached != Null<Real>())
+        return cached;
 
     Real res = 0.0;
 
@@ -150,6 +166,7 @@ Real GsrProcessCore::expectation_rn_part(const Time w,
         res += res2;
     }
 
+    #pragma omp critical(gsrprocesscore_cache)
     cache2a_.insert(std::make_pair(key, res));
 
     return res;
@@ -162,10 +179,16 @@ Real GsrProcessCore::expectation_tf_part(const Time w,
 
     std::pair<Real, Real> key;
     key = std::make_pair(w, t);
-    std::map<std::pair<Real, Real>, Real>::const_iterator k =
-        cache2b_.find(key);
-    if (k != cache2b_.end())
-        return k->second;
+    Real cached = Null<Real>();
+    #pragma omp critical(gsrprocesscore_cache)
+    {
+        std::map<std::pair<Real, Real>, Real>::const_iterator k =
+            cache2b_.find(key);
+        if (k != cache2b_.end())
+            cached = k->second;
+    }
+    if (cached != Null<Real>())
+        return cached;
 
     Real res = 0.0;
     // int -A(s,t) \sigma^2 G(s,T)
@@ -228,6 +251,7 @@ Real GsrProcessCore::expectation_tf_part(const Time w,
         res += -vol(k) * vol(k) * res2;
     }
 
+    #pragma omp critical(gsrprocesscore_cache)
     cache2b_.insert(std::make_pair(key, res));
 
     return res;
@@ -239,9 +263,15 @@ Real GsrProcessCore::variance(const Time w, const Time dt) const {
 
     std::pair<Real, Real> key;
     key = std::make_pair(w, t);
-    std::map<std::pair<Real, Real>, Real>::const_iterator k = cache3_.find(key);
-    if (k != cache3_.end())
-        return k->second;
+    Real cached = Null<Real>();
+    #pragma omp critical(gsrprocesscore_cache)
+    {
+        std::map<std::pair<Real, Real>, Real>::const_iterator k = cache3_.find(key);
+        if (k != cache3_.end())
+            cached = k->second;
+    }
+    if (cached != Null<Real>())
+        return cached;
 
     Real res = 0.0;
     for (int k = lowerIndex(w); k <= upperIndex(t) - 1; k++) {
@@ -259,6 +289,7 @@ Real GsrProcessCore::variance(const Time w, const Time dt) const {
         res += res2;
     }
 
+    #pragma omp critical(gsrprocesscore_cache)
     cache3_.insert(std::make_pair(key, res));
     return res;
 }
@@ -266,9 +297,15 @@ Real GsrProcessCore::variance(const Time w, const Time dt) const {
 Real GsrProcessCore::y(const Time t) const {
     Real key;
     key = t;
-    std::map<Real, Real>::const_iterator k = cache4_.find(key);
-    if (k != cache4_.end())
-        return k->second;
+    Real cached = Null<Real>();
+    #pragma omp critical(gsrprocesscore_cache)
+    {
+        std::map<Real, Real>::const_iterator k = cache4_.find(key);
+        if (k != cache4_.end())
+            cached = k->second;
+    }
+    if (cached != Null<Real>())
+        return cached;
 
     Real res = 0.0;
     for (int i = 0; i <= upperIndex(t) - 1; i++) {
@@ -283,6 +320,7 @@ Real GsrProcessCore::y(const Time t) const {
         res += res2;
     }
 
+    #pragma omp critical(gsrprocesscore_cache)
     cache4_.insert(std::make_pair(key, res));
     return res;
 }
@@ -290,9 +328,15 @@ Real GsrProcessCore::y(const Time t) const {
 Real GsrProcessCore::G(const Time t, const Time w) const {
     std::pair<Real, Real> key;
     key = std::make_pair(w, t);
-    std::map<std::pair<Real, Real>, Real>::const_iterator k = cache5_.find(key);
-    if (k != cache5_.end())
-        return k->second;
+    Real cached = Null<Real>();
+    #pragma omp critical(gsrprocesscore_cache)
+    {
+        std::map<std::pair<Real, Real>, Real>::const_iterator k = cache5_.find(key);
+        if (k != cache5_.end())
+            cached = k->second;
+    }
+    if (cached != Null<Real>())
+        return cached;
 
     Real res = 0.0;
     for (int i = lowerIndex(t); i <= upperIndex(w) - 1; i++) {
@@ -307,6 +351,7 @@ Real GsrProcessCore::G(const Time t, const Time w) const {
         res += res2;
     }
 
+    #pragma omp critical(gsrprocesscore_cache)
     cache5_.insert(std::make_pair(key, res));
     return res;
 }
@@ -159,7 +159,7 @@ namespace QuantLib {
         {
             if (validData) {
                 Real r = *(std::min_element(c->data().begin(), c->data().end()));
-                return r<0.0 ? r*2.0 : r/2.0;
+                return r<0.0 ? Real(r*2.0) : Real(r/2.0);
             }
             // no constraints.
             // We choose as min a value very unlikely to be exceeded.
@@ -173,7 +173,7 @@ namespace QuantLib {
         {
             if (validData) {
                 Real r = *(std::max_element(c->data().begin(), c->data().end()));
-                return r<0.0 ? r/2.0 : r*2.0;
+                return r<0.0 ? Real(r/2.0) : Real(r*2.0);
             }
             // no constraints.
             // We choose as max a value very unlikely to be exceeded.
@@ -240,7 +240,7 @@ namespace QuantLib {
         {
             if (validData) {
                 Real r = *(std::min_element(c->data().begin(), c->data().end()));
-                return r<0.0 ? r*2.0 : r/2.0;
+                return r<0.0 ? Real(r*2.0) : Real(r/2.0);
             }
             // no constraints.
             // We choose as min a value very unlikely to be exceeded.
@@ -254,7 +254,7 @@ namespace QuantLib {
         {
             if (validData) {
                 Real r = *(std::max_element(c->data().begin(), c->data().end()));
-                return r<0.0 ? r/2.0 : r*2.0;
+                return r<0.0 ? Real(r/2.0) : Real(r*2.0);
             }
             // no constraints.
             // We choose as max a value very unlikely to be exceeded.
@@ -321,7 +321,7 @@ namespace QuantLib {
             Real result;
             if (validData) {
                 Real r = *(std::min_element(c->data().begin(), c->data().end()));
-                result = r<0.0 ? r*2.0 : r/2.0;
+                result = r<0.0 ? Real(r*2.0) : Real(r/2.0);
             } else {
                 // no constraints.
                 // We choose as min a value very unlikely to be exceeded.
@@ -338,7 +338,7 @@ namespace QuantLib {
         {
             if (validData) {
                 Real r = *(std::max_element(c->data().begin(), c->data().end()));
-                return r<0.0 ? r/2.0 : r*2.0;
+                return r<0.0 ? Real(r/2.0) : Real(r*2.0);
             }
             // no constraints.
             // We choose as max a value very unlikely to be exceeded.
@@ -0,0 +1,444 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/* Checks of the adjoint sensitivities computed through the core of the
+   library when built with the AD scalar of adreal.hpp as Real.  Each
+   sensitivity is compared with central differences of the value. */
+
+#include "../utilities.hpp"
+#include <ql/cashflows/cashflows.hpp>
+#include <ql/cashflows/fixedratecoupon.hpp>
+#include <ql/exercise.hpp>
+#include <ql/instruments/vanillaoption.hpp>
+#include <ql/math/interpolations/linearinterpolation.hpp>
+#include <ql/math/distributions/normaldistribution.hpp>
+#include <ql/math/matrix.hpp>
+#include <ql/pricingengines/blackformula.hpp>
+#include <ql/pricingengines/vanilla/analyticeuropeanengine.hpp>
+#include <ql/processes/blackscholesprocess.hpp>
+#include <ql/quotes/simplequote.hpp>
+#include <ql/settings.hpp>
+#include <ql/termstructures/volatility/equityfx/blackconstantvol.hpp>
+#include <ql/termstructures/yield/piecewiseyieldcurve.hpp>
+#include <ql/termstructures/yield/flatforward.hpp>
+#include <ql/termstructures/yield/zerocurve.hpp>
+#include <ql/time/calendars/nullcalendar.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+#include <ql/time/schedule.hpp>
+#include <iomanip>
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+
+class ADCheckTest {
+  public:
+    static void testArrayMatrix();
+    static void testBlackFormula();
+    static void testMaddockNormal();
+    static void testZeroCurveCashFlows();
+    static void testPiecewiseYieldCurve();
+    static void testAnalyticEuropeanEngine();
+
+    static test_suite* suite();
+};
+
+namespace {
+
+    // adjoints of the output with respect to the given inputs
+    std::vector<double> adjoints(const Real& output,
+                                 const std::vector<Real>& inputs) {
+        std::vector<double> a =
+            adcheck::Tape::instance().adjoints(output.index());
+        std::vector<double> result(inputs.size());
+        for (Size i=0; i<inputs.size(); ++i)
+            result[i] = a[inputs[i].index()];
+        return result;
+    }
+
+    void checkSensitivity(const std::string& name,
+                          double adjoint, double bumped, double tolerance) {
+        BOOST_CHECK_MESSAGE(std::fabs(adjoint - bumped) <= tolerance,
+                            "failed to reproduce bumped " << name
+                            << std::setprecision(10)
+                            << "\n    adjoint:   " << adjoint
+                            << "\n    bumped:    " << bumped
+                            << "\n    tolerance: " << tolerance);
+    }
+
+    // clears the tape and restores the evaluation date
+    struct TapeGuard {
+        TapeGuard()
+        : evaluationDate(Settings::instance().evaluationDate()) {
+            adcheck::Tape::instance().clear();
+        }
+        ~TapeGuard() {
+            Settings::instance().evaluationDate() = evaluationDate;
+            adcheck::Tape::instance().clear();
+        }
+        Date evaluationDate;
+    };
+
+    // value of a fixed-rate leg on a linear zero curve
+    Real fixedLegNPV(const std::vector<Date>& dates,
+                     const std::vector<Real>& zeroRates,
+                     const Leg& leg,
+                     const Date& today) {
+        Handle<YieldTermStructure> curve(
+            ext::make_shared<InterpolatedZeroCurve<Linear> >(
+                dates, zeroRates, Actual365Fixed()));
+        return CashFlows::npv(leg, **curve, false, today, today);
+    }
+
+    // par rate of annual fixed payments on a unit notional; it keeps
+    // the instruments behind the library's rate helpers out of the check
+    class ParRateHelper : public BootstrapHelper<YieldTermStructure> {
+      public:
+        ParRateHelper(const Handle<Quote>& rate,
+                      const Date& today,
+                      Integer years)
+        : BootstrapHelper<YieldTermStructure>(rate) {
+            dates_.push_back(today);
+            for (Integer i=1; i<=years; ++i)
+                dates_.push_back(today + i*Years);
+            earliestDate_ = today;
+            maturityDate_ = latestRelevantDate_ = pillarDate_ =
+                latestDate_ = dates_.back();
+        }
+        Real impliedQuote() const override {
+            const DayCounter dc = Actual365Fixed();
+            Real annuity = 0.0;
+            for (Size i=1; i<dates_.size(); ++i)
+                annuity += dc.yearFraction(dates_[i-1], dates_[i])
+                    * termStructure_->discount(dates_[i]);
+            return (1.0 - termStructure_->discount(dates_.back()))/annuity;
+        }
+      private:
+        std::vector<Date> dates_;
+    };
+
+    // value of a fixed-rate leg on a curve bootstrapped on par rates
+    Real bootstrappedLegNPV(
+                    const std::vector<ext::shared_ptr<SimpleQuote> >& quotes,
+                    const Integer years[],
+                    const Leg& leg,
+                    const Date& today) {
+        std::vector<ext::shared_ptr<BootstrapHelper<YieldTermStructure> > >
+            helpers;
+        for (Size i=0; i<quotes.size(); ++i)
+            helpers.push_back(ext::make_shared<ParRateHelper>(
+                Handle<Quote>(quotes[i]), today, years[i]));
+        PiecewiseYieldCurve<Discount, LogLinear> curve(
+            today, helpers, Actual365Fixed());
+        return CashFlows::npv(leg, curve, false, today, today);
+    }
+
+    const OneAssetOption::results& europeanResults(
+                                    AnalyticEuropeanEngine& engine,
+                                    const ext::shared_ptr<Payoff>& payoff,
+                                    const ext::shared_ptr<Exercise>& exercise) {
+        VanillaOption::arguments* arguments =
+            dynamic_cast<VanillaOption::arguments*>(engine.getArguments());
+        arguments->payoff = payoff;
+        arguments->exercise = exercise;
+        arguments->validate();
+        engine.reset();
+        engine.calculate();
+        return *dynamic_cast<const OneAssetOption::results*>(
+                                                       engine.getResults());
+    }
+
+}
+
+void ADCheckTest::testArrayMatrix() {
+    BOOST_TEST_MESSAGE("Testing adjoints through Array and Matrix...");
+
+    TapeGuard guard;
+
+    const Size n = 3;
+    Matrix m(n, n);
+    for (Size i=0; i<n; ++i)
+        for (Size j=0; j<n; ++j)
+            m[i][j] = 1.0/(1.0 + i + 2.0*j);
+
+    Array x(n);
+    for (Size i=0; i<n; ++i) {
+        x[i] = 0.5 + 0.25*i;
+        x[i].registerInput();
+    }
+
+    // f(x) = |M x|^2, whose gradient is 2 M^T M x
+    const Array y = m*x;
+    const Real f = DotProduct(y, y);
+    const std::vector<double> a =
+        adjoints(f, std::vector<Real>(x.begin(), x.end()));
+
+    const Array expected = 2.0*(transpose(m)*y);
+    for (Size i=0; i<n; ++i)
+        checkSensitivity("gradient", a[i], expected[i].value(), 1.0e-12);
+}
+
+void ADCheckTest::testBlackFormula() {
+    BOOST_TEST_MESSAGE("Testing adjoints of the Black formula...");
+
+    TapeGuard guard;
+
+    const double values[] = { 100.0, 105.0, 0.2, 0.95 };
+    std::vector<Real> inputs(values, values + 4);
+    for (Size i=0; i<inputs.size(); ++i)
+        inputs[i].registerInput();
+
+    const Real price = blackFormula(Option::Call, inputs[1], inputs[0],
+                                    inputs[2], inputs[3]);
+    const std::vector<double> a = adjoints(price, inputs);
+
+    const char* names[] = { "forward", "strike", "stdDev", "discount" };
+    const double h = 1.0e-5;
+    for (Size i=0; i<inputs.size(); ++i) {
+        std::vector<Real> up(values, values + 4), down(up);
+        up[i] += h;
+        down[i] -= h;
+        const double bumped =
+            (blackFormula(Option::Call, up[1], up[0], up[2], up[3])
+             - blackFormula(Option::Call, down[1], down[0], down[2], down[3]))
+            .value() / (2*h);
+        checkSensitivity(names[i], a[i], bumped, 1.0e-6);
+    }
+}
+
+void ADCheckTest::testMaddockNormal() {
+    BOOST_TEST_MESSAGE(
+        "Testing adjoints of Maddock's normal distributions...");
+
+    TapeGuard guard;
+
+    const double values[] = { 0.3, 0.05, 1.2 };
+    std::vector<Real> inputs(values, values + 3);
+    for (Size i=0; i<inputs.size(); ++i)
+        inputs[i].registerInput();
+
+    // inputs: probability or point, average and sigma
+    const Real p = MaddockInverseCumulativeNormal(
+        inputs[1], inputs[2])(inputs[0]);
+    const std::vector<double> a = adjoints(p, inputs);
+
+    const Real x = -0.4;
+    const Real c = MaddockCumulativeNormal(inputs[1], inputs[2])(x);
+    const std::vector<double> b = adjoints(c, inputs);
+
+    const char* names[] = { "probability", "average", "sigma" };
+    const double h = 1.0e-6;
+    for (Size i=0; i<inputs.size(); ++i) {
+        std::vector<Real> up(values, values + 3), down(up);
+        up[i] += h;
+        down[i] -= h;
+        const double bumped =
+            (MaddockInverseCumulativeNormal(up[1], up[2])(up[0])
+             - MaddockInverseCumulativeNormal(down[1], down[2])(down[0]))
+            .value() / (2*h);
+        checkSensitivity(std::string("inverse cumulative ") + names[i],
+                         a[i], bumped, 1.0e-7);
+    }
+    for (Size i=1; i<inputs.size(); ++i) {
+        std::vector<Real> up(values, values + 3), down(up);
+        up[i] += h;
+        down[i] -= h;
+        const double bumped =
+            (MaddockCumulativeNormal(up[1], up[2])(x)
+             - MaddockCumulativeNormal(down[1], down[2])(x))
+            .value() / (2*h);
+        checkSensitivity(std::string("cumulative ") + names[i],
+                         b[i], bumped, 1.0e-7);
+    }
+}
+
+void ADCheckTest::testZeroCurveCashFlows() {
+    BOOST_TEST_MESSAGE(
+        "Testing adjoints of cash-flow NPVs on an interpolated curve...");
+
+    TapeGuard guard;
+
+    const Date today(15, March, 2021);
+    Settings::instance().evaluationDate() = today;
+
+    std::vector<Date> dates;
+    std::vector<Real> zeroRates;
+    const Integer years[] = { 0, 1, 2, 3, 5, 7, 10 };
+    for (Size i=0; i<LENGTH(years); ++i) {
+        dates.push_back(today + years[i]*Years);
+        zeroRates.push_back(0.01 + 0.002*i);
+        zeroRates.back().registerInput();
+    }
+
+    const Schedule schedule(today, today + 8*Years, 6*Months,
+                            NullCalendar(), Unadjusted, Unadjusted,
+                            DateGeneration::Backward, false);
+    const Leg leg = FixedRateLeg(schedule)
+        .withNotionals(100.0)
+        .withCouponRates(0.02, Actual365Fixed());
+
+    const Real npv = fixedLegNPV(dates, zeroRates, leg, today);
+    const std::vector<double> a = adjoints(npv, zeroRates);
+
+    const double h = 1.0e-6;
+    for (Size i=0; i<zeroRates.size(); ++i) {
+        std::vector<Real> up, down;
+        for (Size j=0; j<zeroRates.size(); ++j) {
+            up.push_back(zeroRates[j].value());
+            down.push_back(zeroRates[j].value());
+        }
+        up[i] += h;
+        down[i] -= h;
+        const double bumped = (fixedLegNPV(dates, up, leg, today)
+                               - fixedLegNPV(dates, down, leg, today))
+                              .value() / (2*h);
+        checkSensitivity("zero-rate sensitivity", a[i], bumped, 1.0e-5);
+    }
+}
+
+void ADCheckTest::testPiecewiseYieldCurve() {
+    BOOST_TEST_MESSAGE(
+        "Testing adjoints of cash-flow NPVs on a bootstrapped curve...");
+
+    TapeGuard guard;
+
+    const Date today(15, March, 2021);
+    Settings::instance().evaluationDate() = today;
+
+    const Integer years[] = { 1, 2, 3, 5, 7, 10 };
+    std::vector<Real> rates;
+    std::vector<ext::shared_ptr<SimpleQuote> > quotes;
+    for (Size i=0; i<LENGTH(years); ++i) {
+        rates.push_back(0.01 + 0.002*i);
+        rates.back().registerInput();
+        quotes.push_back(ext::make_shared<SimpleQuote>(rates.back()));
+    }
+
+    const Schedule schedule(today, today + 8*Years, 6*Months,
+                            NullCalendar(), Unadjusted, Unadjusted,
+                            DateGeneration::Backward, false);
+    const Leg leg = FixedRateLeg(schedule)
+        .withNotionals(100.0)
+        .withCouponRates(0.02, Actual365Fixed());
+
+    // the adjoints go through the iterations of the bootstrap solver
+    const Real npv = bootstrappedLegNPV(quotes, years, leg, today);
+    const std::vector<double> a = adjoints(npv, rates);
+
+    const double h = 1.0e-6;
+    for (Size i=0; i<quotes.size(); ++i) {
+        const double rate = rates[i].value();
+        quotes[i]->setValue(rate + h);
+        const double up =
+            bootstrappedLegNPV(quotes, years, leg, today).value();
+        quotes[i]->setValue(rate - h);
+        const double down =
+            bootstrappedLegNPV(quotes, years, leg, today).value();
+        quotes[i]->setValue(rates[i]);
+        checkSensitivity("par-rate sensitivity", a[i],
+                         (up - down)/(2*h), 1.0e-5);
+    }
+}
+
+void ADCheckTest::testAnalyticEuropeanEngine() {
+    BOOST_TEST_MESSAGE(
+        "Testing adjoints of the analytic European engine...");
+
+    TapeGuard guard;
+
+    const Date today(15, March, 2021);
+    Settings::instance().evaluationDate() = today;
+    const DayCounter dc = Actual365Fixed();
+
+    const double values[] = { 100.0, 0.03, 0.01, 0.25 };
+    std::vector<Real> inputs(values, values + 4);
+    for (Size i=0; i<inputs.size(); ++i)
+        inputs[i].registerInput();
+
+    const ext::shared_ptr<SimpleQuote> spot =
+        ext::make_shared<SimpleQuote>(inputs[0]);
+    const ext::shared_ptr<SimpleQuote> rate =
+        ext::make_shared<SimpleQuote>(inputs[1]);
+    const ext::shared_ptr<SimpleQuote> dividend =
+        ext::make_shared<SimpleQuote>(inputs[2]);
+    const ext::shared_ptr<SimpleQuote> vol =
+        ext::make_shared<SimpleQuote>(inputs[3]);
+
+    const ext::shared_ptr<BlackScholesMertonProcess> process =
+        ext::make_shared<BlackScholesMertonProcess>(
+            Handle<Quote>(spot),
+            Handle<YieldTermStructure>(ext::make_shared<FlatForward>(
+                today, Handle<Quote>(dividend), dc)),
+            Handle<YieldTermStructure>(ext::make_shared<FlatForward>(
+                today, Handle<Quote>(rate), dc)),
+            Handle<BlackVolTermStructure>(ext::make_shared<BlackConstantVol>(
+                today, NullCalendar(), Handle<Quote>(vol), dc)));
+
+    // the engine is used directly; VanillaOption would also bring in
+    // the numerical engines used for its implied volatility
+    AnalyticEuropeanEngine engine(process);
+    const OneAssetOption::results& results = europeanResults(
+        engine, ext::make_shared<PlainVanillaPayoff>(Option::Put, 105.0),
+        ext::make_shared<EuropeanExercise>(today + 1*Years));
+
+    const Real npv = results.value;
+    const std::vector<double> a = adjoints(npv, inputs);
+
+    // the adjoints reproduce the Greeks of the engine...
+    checkSensitivity("delta", a[0], results.delta.value(), 1.0e-10);
+    checkSensitivity("rho", a[1], results.rho.value(), 1.0e-10);
+    checkSensitivity("dividend rho", a[2],
+                     results.dividendRho.value(), 1.0e-10);
+    checkSensitivity("vega", a[3], results.vega.value(), 1.0e-10);
+
+    // ...and the bumped values
+    const ext::shared_ptr<SimpleQuote> quotes[] = {
+        spot, rate, dividend, vol
+    };
+    const char* names[] = { "spot", "rate", "dividend", "volatility" };
+    const double h = 1.0e-6;
+    for (Size i=0; i<LENGTH(quotes); ++i) {
+        const ext::shared_ptr<Payoff> payoff =
+            ext::make_shared<PlainVanillaPayoff>(Option::Put, 105.0);
+        const ext::shared_ptr<Exercise> exercise =
+            ext::make_shared<EuropeanExercise>(today + 1*Years);
+        quotes[i]->setValue(values[i] + h);
+        const double up =
+            europeanResults(engine, payoff, exercise).value.value();
+        quotes[i]->setValue(values[i] - h);
+        const double down =
+            europeanResults(engine, payoff, exercise).value.value();
+        quotes[i]->setValue(values[i]);
+        checkSensitivity(names[i], a[i], (up - down)/(2*h), 1.0e-5);
+    }
+}
+
+test_suite* ADCheckTest::suite() {
+    auto* suite = BOOST_TEST_SUITE("AD check");
+
+    suite->add(QUANTLIB_TEST_CASE(&ADCheckTest::testArrayMatrix));
+    suite->add(QUANTLIB_TEST_CASE(&ADCheckTest::testBlackFormula));
+    suite->add(QUANTLIB_TEST_CASE(&ADCheckTest::testMaddockNormal));
+    suite->add(QUANTLIB_TEST_CASE(&ADCheckTest::testZeroCurveCashFlows));
+    suite->add(QUANTLIB_TEST_CASE(&ADCheckTest::testPiecewiseYieldCurve));
+    suite->add(QUANTLIB_TEST_CASE(&ADCheckTest::testAnalyticEuropeanEngine));
+
+    return suite;
+}
+
+test_suite* init_unit_test_suite(int, char* []) {
+    return ADCheckTest::suite();
+}
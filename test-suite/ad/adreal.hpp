@@ -0,0 +1,307 @@
+/* -*- mode: c++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/*
+ This file is part of QuantLib, a free-software/open-source library
+ for financial quantitative analysts and developers - http://quantlib.org/
+
+ QuantLib is free software: you can redistribute it and/or modify it
+ under the terms of the QuantLib license.  You should have received a
+ copy of the license along with this program; if not, please email
+ <quantlib-dev@lists.sf.net>. The license is also available online at
+ <http://quantlib.org/license.shtml>.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the license for more details.
+*/
+
+/*! \file adreal.hpp
+    \brief minimal reverse-mode AD scalar used to check the Real hook
+
+    This header is passed as QL_INCLUDE_FIRST when building the AD
+    check; it defines QL_REAL as an operator-overloading scalar which
+    records the operations on a global tape.  It is only meant to
+    check that the library compiles and differentiates correctly with
+    a non-double Real, not to be efficient.
+*/
+
+#ifndef quantlib_test_ad_real_hpp
+#define quantlib_test_ad_real_hpp
+
+#include <cmath>
+#include <cstddef>
+#include <iosfwd>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+namespace adcheck {
+
+    //! record of the operations on active variables
+    class Tape {
+      public:
+        static const std::size_t none = std::size_t(-1);
+        static Tape& instance() {
+            static Tape tape;
+            return tape;
+        }
+        //! records a node with up to two parents and its partials
+        std::size_t record(std::size_t parent1, double partial1,
+                           std::size_t parent2 = none,
+                           double partial2 = 0.0) {
+            Node node = { { parent1, parent2 }, { partial1, partial2 } };
+            nodes_.push_back(node);
+            return nodes_.size() - 1;
+        }
+        std::size_t size() const { return nodes_.size(); }
+        void clear() { nodes_.clear(); }
+        //! adjoints of all nodes with respect to the given output
+        std::vector<double> adjoints(std::size_t output) const {
+            std::vector<double> a(nodes_.size(), 0.0);
+            if (output == none)
+                return a;
+            a[output] = 1.0;
+            for (std::size_t i = output + 1; i-- > 0;) {
+                if (a[i] == 0.0)
+                    continue;
+                for (int k = 0; k < 2; ++k) {
+                    if (nodes_[i].parent[k] != none)
+                        a[nodes_[i].parent[k]] += nodes_[i].partial[k] * a[i];
+                }
+            }
+            return a;
+        }
+      private:
+        struct Node {
+            std::size_t parent[2];
+            double partial[2];
+        };
+        std::vector<Node> nodes_;
+    };
+
+    //! active scalar
+    /*! Values not depending on registered inputs are not recorded. */
+    class Real {
+      public:
+        Real() : value_(0.0), index_(Tape::none) {}
+        Real(double value) : value_(value), index_(Tape::none) {}
+        //! makes the value an input, i.e., a leaf of the tape
+        void registerInput() { index_ = Tape::instance().record(Tape::none, 0.0); }
+        double value() const { return value_; }
+        std::size_t index() const { return index_; }
+        template <class T, class = typename std::enable_if<
+                               std::is_arithmetic<T>::value>::type>
+        explicit operator T() const {
+            return static_cast<T>(value_);
+        }
+
+        // result of a unary operation with the given partial
+        static Real unary(double value, const Real& x, double dx) {
+            Real r(value);
+            if (x.index_ != Tape::none)
+                r.index_ = Tape::instance().record(x.index_, dx);
+            return r;
+        }
+        // result of a binary operation with the given partials
+        static Real binary(double value, const Real& x, double dx,
+                           const Real& y, double dy) {
+            Real r(value);
+            if (x.index_ != Tape::none && y.index_ != Tape::none)
+                r.index_ = Tape::instance().record(x.index_, dx, y.index_, dy);
+            else if (x.index_ != Tape::none)
+                r.index_ = Tape::instance().record(x.index_, dx);
+            else if (y.index_ != Tape::none)
+                r.index_ = Tape::instance().record(y.index_, dy);
+            return r;
+        }
+
+        Real& operator+=(const Real& y) { return *this = *this + y; }
+        Real& operator-=(const Real& y) { return *this = *this - y; }
+        Real& operator*=(const Real& y) { return *this = *this * y; }
+        Real& operator/=(const Real& y) { return *this = *this / y; }
+        Real& operator++() { value_ += 1.0; return *this; }
+        Real& operator--() { value_ -= 1.0; return *this; }
+        Real operator++(int) { Real r = *this; ++*this; return r; }
+        Real operator--(int) { Real r = *this; --*this; return r; }
+
+        friend Real operator+(const Real& x) { return x; }
+        friend Real operator-(const Real& x) {
+            return unary(-x.value_, x, -1.0);
+        }
+        friend Real operator+(const Real& x, const Real& y) {
+            return binary(x.value_ + y.value_, x, 1.0, y, 1.0);
+        }
+        friend Real operator-(const Real& x, const Real& y) {
+            return binary(x.value_ - y.value_, x, 1.0, y, -1.0);
+        }
+        friend Real operator*(const Real& x, const Real& y) {
+            return binary(x.value_ * y.value_, x, y.value_, y, x.value_);
+        }
+        friend Real operator/(const Real& x, const Real& y) {
+            const double r = x.value_ / y.value_;
+            return binary(r, x, 1.0 / y.value_, y, -r / y.value_);
+        }
+
+        friend bool operator==(const Real& x, const Real& y) {
+            return x.value_ == y.value_;
+        }
+        friend bool operator!=(const Real& x, const Real& y) {
+            return x.value_ != y.value_;
+        }
+        friend bool operator<(const Real& x, const Real& y) {
+            return x.value_ < y.value_;
+        }
+        friend bool operator<=(const Real& x, const Real& y) {
+            return x.value_ <= y.value_;
+        }
+        friend bool operator>(const Real& x, const Real& y) {
+            return x.value_ > y.value_;
+        }
+        friend bool operator>=(const Real& x, const Real& y) {
+            return x.value_ >= y.value_;
+        }
+
+        friend std::ostream& operator<<(std::ostream& out, const Real& x) {
+            return out << x.value_;
+        }
+
+      private:
+        double value_;
+        std::size_t index_;
+    };
+
+    inline Real exp(Real x) {
+        const double e = std::exp(x.value());
+        return Real::unary(e, x, e);
+    }
+    inline Real log(Real x) {
+        return Real::unary(std::log(x.value()), x, 1.0 / x.value());
+    }
+    inline Real sqrt(Real x) {
+        const double s = std::sqrt(x.value());
+        return Real::unary(s, x, 0.5 / s);
+    }
+    inline Real fabs(Real x) {
+        return Real::unary(std::fabs(x.value()), x,
+                           x.value() < 0.0 ? -1.0 : 1.0);
+    }
+    inline Real abs(Real x) { return fabs(x); }
+    inline Real pow(Real x, Real y) {
+        const double p = std::pow(x.value(), y.value());
+        return Real::binary(
+            p, x, y.value() * std::pow(x.value(), y.value() - 1.0),
+            y, x.value() > 0.0 ? p * std::log(x.value()) : 0.0);
+    }
+    inline Real sin(Real x) {
+        return Real::unary(std::sin(x.value()), x, std::cos(x.value()));
+    }
+    inline Real cos(Real x) {
+        return Real::unary(std::cos(x.value()), x, -std::sin(x.value()));
+    }
+    inline Real tan(Real x) {
+        const double t = std::tan(x.value());
+        return Real::unary(t, x, 1.0 + t * t);
+    }
+    inline Real atan(Real x) {
+        return Real::unary(std::atan(x.value()), x,
+                           1.0 / (1.0 + x.value() * x.value()));
+    }
+    inline Real sinh(Real x) {
+        return Real::unary(std::sinh(x.value()), x, std::cosh(x.value()));
+    }
+    inline Real cosh(Real x) {
+        return Real::unary(std::cosh(x.value()), x, std::sinh(x.value()));
+    }
+    inline Real tanh(Real x) {
+        const double t = std::tanh(x.value());
+        return Real::unary(t, x, 1.0 - t * t);
+    }
+    inline Real asinh(Real x) {
+        return Real::unary(std::asinh(x.value()), x,
+                           1.0 / std::sqrt(1.0 + x.value() * x.value()));
+    }
+    inline Real atanh(Real x) {
+        return Real::unary(std::atanh(x.value()), x,
+                           1.0 / (1.0 - x.value() * x.value()));
+    }
+    inline Real floor(Real x) { return Real(std::floor(x.value())); }
+    inline Real ceil(Real x) { return Real(std::ceil(x.value())); }
+    inline Real modf(Real x, Real* integral) {
+        double i;
+        const double f = std::modf(x.value(), &i);
+        *integral = Real(i);
+        return Real::unary(f, x, 1.0);
+    }
+    inline long lround(Real x) { return std::lround(x.value()); }
+    inline bool isnan(Real x) { return std::isnan(x.value()); }
+    inline bool isinf(Real x) { return std::isinf(x.value()); }
+    inline bool isfinite(Real x) { return std::isfinite(x.value()); }
+
+}
+
+// the library calls the qualified functions
+namespace std {
+    using adcheck::exp;
+    using adcheck::log;
+    using adcheck::sqrt;
+    using adcheck::fabs;
+    using adcheck::abs;
+    using adcheck::pow;
+    using adcheck::sin;
+    using adcheck::cos;
+    using adcheck::tan;
+    using adcheck::atan;
+    using adcheck::sinh;
+    using adcheck::cosh;
+    using adcheck::tanh;
+    using adcheck::asinh;
+    using adcheck::atanh;
+    using adcheck::floor;
+    using adcheck::ceil;
+    using adcheck::modf;
+    using adcheck::lround;
+    using adcheck::isnan;
+    using adcheck::isinf;
+    using adcheck::isfinite;
+
+    template <>
+    class numeric_limits<adcheck::Real> : public numeric_limits<double> {
+      public:
+        static adcheck::Real min() { return numeric_limits<double>::min(); }
+        static adcheck::Real max() { return numeric_limits<double>::max(); }
+        static adcheck::Real lowest() {
+            return numeric_limits<double>::lowest();
+        }
+        static adcheck::Real epsilon() {
+            return numeric_limits<double>::epsilon();
+        }
+        static adcheck::Real infinity() {
+            return numeric_limits<double>::infinity();
+        }
+        static adcheck::Real quiet_NaN() {
+            return numeric_limits<double>::quiet_NaN();
+        }
+    };
+}
+
+namespace QuantLib {
+
+    template <class T>
+    class Null;
+
+    // same null value as for double
+    template <>
+    class Null<adcheck::Real> {
+      public:
+        Null() {}
+        operator adcheck::Real() const {
+            return adcheck::Real(std::numeric_limits<float>::max());
+        }
+    };
+
+}
+
+#define QL_REAL adcheck::Real
+
+#endif
@@ -28,6 +28,8 @@
 #include <ql/pricingengines/vanilla/juquadraticengine.hpp>
 #include <ql/pricingengines/vanilla/fdblackscholesvanillaengine.hpp>
 #include <ql/pricingengines/vanilla/fdshoutengine.hpp>
+#include <ql/pricingengines/vanilla/binomialengine.hpp>
+#include <ql/experimental/lattices/extendedbinomialtree.hpp>
 #include <ql/termstructures/yield/flatforward.hpp>
 #include <ql/termstructures/volatility/equityfx/blackconstantvol.hpp>
 #include <ql/utilities/dataformatters.hpp>
@@ -566,6 +568,182 @@ void AmericanOptionTest::testFdShoutGreeks() {
     testFdGreeks<FDShoutEngine<CrankNicolson> >();
 }
 
+namespace {
+
+    // the rollback on a BlackScholesLattice formerly used by
+    // BinomialVanillaEngine
+    template <class T>
+    Real binomialLatticeValue(
+             const ext::shared_ptr<GeneralizedBlackScholesProcess>& process,
+             const ext::shared_ptr<StrikedTypePayoff>& payoff,
+             const ext::shared_ptr<Exercise>& exercise,
+             Size timeSteps) {
+        DayCounter rfdc  = process->riskFreeRate()->dayCounter();
+        DayCounter divdc = process->dividendYield()->dayCounter();
+        DayCounter voldc = process->blackVolatility()->dayCounter();
+        Calendar volcal = process->blackVolatility()->calendar();
+        Real s0 = process->stateVariable()->value();
+        Date maturityDate = exercise->lastDate();
+        Volatility v =
+            process->blackVolatility()->blackVol(maturityDate, s0);
+        Rate r = process->riskFreeRate()->zeroRate(maturityDate,
+            rfdc, Continuous, NoFrequency);
+        Rate q = process->dividendYield()->zeroRate(maturityDate,
+            divdc, Continuous, NoFrequency);
+        Date referenceDate = process->riskFreeRate()->referenceDate();
+        Time maturity = rfdc.yearFraction(referenceDate, maturityDate);
+
+        ext::shared_ptr<StochasticProcess1D> bs(
+            new GeneralizedBlackScholesProcess(
+                process->stateVariable(),
+                Handle<YieldTermStructure>(
+                    flatRate(referenceDate, q, divdc)),
+                Handle<YieldTermStructure>(
+                    flatRate(referenceDate, r, rfdc)),
+                Handle<BlackVolTermStructure>(
+                    ext::shared_ptr<BlackVolTermStructure>(
+                        new BlackConstantVol(referenceDate, volcal,
+                                             v, voldc)))));
+        ext::shared_ptr<T> tree(new T(bs, maturity, timeSteps,
+                                      payoff->strike()));
+        ext::shared_ptr<BlackScholesLattice<T> > lattice(
+            new BlackScholesLattice<T>(tree, r, maturity, timeSteps));
+
+        VanillaOption::arguments arguments;
+        arguments.payoff = payoff;
+        arguments.exercise = exercise;
+        TimeGrid grid(maturity, timeSteps);
+        DiscretizedVanillaOption option(arguments, *process, grid);
+        option.initialize(lattice, maturity);
+        option.rollback(0.0);
+        return option.presentValue();
+    }
+
+    template <class T>
+    void testBinomialBatch(const std::string& treeName) {
+
+        Date today = Date(15, March, 2021);
+        Settings::instance().evaluationDate() = today;
+        DayCounter dc = Actual360();
+        ext::shared_ptr<SimpleQuote> spot(new SimpleQuote(100.0));
+        ext::shared_ptr<BlackScholesMertonProcess> process(
+            new BlackScholesMertonProcess(
+                Handle<Quote>(spot),
+                Handle<YieldTermStructure>(flatRate(today, 0.02, dc)),
+                Handle<YieldTermStructure>(flatRate(today, 0.05, dc)),
+                Handle<BlackVolTermStructure>(flatVol(today, 0.25, dc))));
+
+        Size timeSteps = 201;
+        ext::shared_ptr<BinomialVanillaEngine<T> > engine(
+                        new BinomialVanillaEngine<T>(process, timeSteps));
+        // keeps a single tree, so that the trees of the two exercise
+        // dates evict each other (unless they depend on the strike, in
+        // which case they are not cached)
+        ext::shared_ptr<BinomialVanillaEngine<T> > bounded(
+                     new BinomialVanillaEngine<T>(process, timeSteps, 1));
+
+        std::vector<ext::shared_ptr<Exercise> > exercises;
+        exercises.push_back(ext::shared_ptr<Exercise>(
+            new AmericanExercise(today, today + Period(1, Years))));
+        exercises.push_back(ext::shared_ptr<Exercise>(
+            new EuropeanExercise(today + Period(6, Months))));
+        Real strikes[] = { 80.0, 95.0, 100.0, 110.0, 130.0 };
+        Option::Type types[] = { Option::Put, Option::Call };
+
+        Real tolerance = 1.0e-12;
+        for (Size n=0; n<2; n++) {
+            // the second pass checks that the cached trees are
+            // discarded when the market moves
+            if (n == 1)
+                spot->setValue(105.0);
+            for (Size e=0; e<exercises.size(); e++) {
+                std::vector<ext::shared_ptr<PlainVanillaPayoff> > payoffs;
+                for (Size i=0; i<LENGTH(types); i++)
+                    for (Size j=0; j<LENGTH(strikes); j++)
+                        payoffs.push_back(ext::shared_ptr<PlainVanillaPayoff>(
+                                new PlainVanillaPayoff(types[i], strikes[j])));
+                std::vector<VanillaOption::results> results =
+                    engine->batchCalculate(payoffs, exercises[e]);
+                std::vector<VanillaOption::results> boundedResults =
+                    bounded->batchCalculate(payoffs, exercises[e]);
+                for (Size k=0; k<payoffs.size(); k++) {
+                    Real expected = binomialLatticeValue<T>(
+                        process, payoffs[k], exercises[e], timeSteps);
+                    VanillaOption option(payoffs[k], exercises[e]);
+                    option.setPricingEngine(engine);
+                    Real single = option.NPV();
+                    if (std::fabs(results[k].value - expected) > tolerance
+                        || std::fabs(single - expected) > tolerance)
+                        BOOST_ERROR("failed to reproduce " << treeName
+                                    << " lattice value:\n"
+                                    << std::setprecision(12)
+                                    << "    type:       "
+                                    << payoffs[k]->optionType() << "\n"
+                                    << "    strike:     "
+                                    << payoffs[k]->strike() << "\n"
+                                    << "    spot:       "
+                                    << spot->value() << "\n"
+                                    << "    batch:      "
+                                    << results[k].value << "\n"
+                                    << "    single:     " << single << "\n"
+                                    << "    expected:   " << expected);
+                    if (std::fabs(results[k].delta - option.delta())
+                                                            > tolerance)
+                        BOOST_ERROR("batch and single delta differ:\n"
+                                    << std::setprecision(12)
+                                    << "    batch:      "
+                                    << results[k].delta << "\n"
+                                    << "    single:     "
+                                    << option.delta());
+                    if (std::fabs(boundedResults[k].value
+                                  - results[k].value) > tolerance)
+                        BOOST_ERROR("bounded tree cache changes the value:\n"
+                                    << std::setprecision(12)
+                                    << "    strike:     "
+                                    << payoffs[k]->strike() << "\n"
+                                    << "    bounded:    "
+                                    << boundedResults[k].value << "\n"
+                                    << "    unbounded:  "
+                                    << results[k].value);
+                }
+            }
+        }
+    }
+
+}
+
+void AmericanOptionTest::testBinomialBatchPricing() {
+    BOOST_TEST_MESSAGE(
+        "Testing batch pricing with cached binomial trees...");
+
+    SavedSettings backup;
+
+    testBinomialBatch<CoxRossRubinstein>("Cox-Ross-Rubinstein");
+    testBinomialBatch<LeisenReimer>("Leisen-Reimer");
+    testBinomialBatch<Joshi4>("Joshi");
+    testBinomialBatch<ExtendedLeisenReimer>("extended Leisen-Reimer");
+    testBinomialBatch<ExtendedJoshi4>("extended Joshi");
+
+    // with two steps, the gamma is read at maturity
+    Date today = Settings::instance().evaluationDate();
+    DayCounter dc = Actual360();
+    ext::shared_ptr<BlackScholesMertonProcess> process(
+        new BlackScholesMertonProcess(
+            Handle<Quote>(ext::make_shared<SimpleQuote>(100.0)),
+            Handle<YieldTermStructure>(flatRate(today, 0.02, dc)),
+            Handle<YieldTermStructure>(flatRate(today, 0.05, dc)),
+            Handle<BlackVolTermStructure>(flatVol(today, 0.25, dc))));
+    VanillaOption option(
+        ext::make_shared<PlainVanillaPayoff>(Option::Put, 100.0),
+        ext::make_shared<EuropeanExercise>(today + Period(1, Years)));
+    option.setPricingEngine(
+        ext::make_shared<BinomialVanillaEngine<CoxRossRubinstein> >(
+            process, 2));
+    Real gamma = option.gamma();
+    if (gamma == Null<Real>() || gamma <= 0.0)
+        BOOST_ERROR("invalid gamma with two time steps: " << gamma);
+}
+
 test_suite* AmericanOptionTest::suite() {
     auto* suite = BOOST_TEST_SUITE("American option tests");
     suite->add(
@@ -580,6 +758,8 @@ test_suite* AmericanOptionTest::suite() {
     suite->add(QUANTLIB_TEST_CASE(&AmericanOptionTest::testFdAmericanGreeks));
     // FLOATING_POINT_EXCEPTION
     suite->add(QUANTLIB_TEST_CASE(&AmericanOptionTest::testFdShoutGreeks));
+    suite->add(
+        QUANTLIB_TEST_CASE(&AmericanOptionTest::testBinomialBatchPricing));
     return suite;
 }
 
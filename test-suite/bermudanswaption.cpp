@@ -22,6 +22,8 @@
 #include "utilities.hpp"
 #include <ql/instruments/swaption.hpp>
 #include <ql/pricingengines/swaption/treeswaptionengine.hpp>
+#include <ql/pricingengines/swaption/discretizedswaption.hpp>
+#include <ql/methods/lattices/batchlatticepricer.hpp>
 #include <ql/pricingengines/swap/discountingswapengine.hpp>
 #include <ql/pricingengines/swaption/fdhullwhiteswaptionengine.hpp>
 #include <ql/pricingengines/swaption/fdg2swaptionengine.hpp>
@@ -104,6 +106,20 @@ namespace bermudan_swaption_test {
         }
     };
 
+    // value of a swaption rolled back to the origin of the lattice
+    Real latticeValue(const Swaption& swaption,
+                      const ext::shared_ptr<Lattice>& lattice,
+                      const Date& referenceDate,
+                      const DayCounter& dayCounter) {
+        Swaption::arguments arguments;
+        swaption.setupArguments(&arguments);
+        DiscretizedSwaption discretized(arguments, referenceDate, dayCounter);
+        discretized.initialize(lattice, dayCounter.yearFraction(
+                             referenceDate, arguments.exercise->lastDate()));
+        discretized.rollback(0.0);
+        return discretized.presentValue();
+    }
+
 }
 
 
@@ -309,10 +325,261 @@ void BermudanSwaptionTest::testCachedG2Values() {
     }
 }
 
+void BermudanSwaptionTest::testTreeLatticeReuse() {
+
+    BOOST_TEST_MESSAGE(
+        "Testing reuse of cached short-rate tree lattices...");
+
+    using namespace bermudan_swaption_test;
+
+    CommonVars vars;
+
+    vars.today = Date(15, February, 2002);
+
+    Settings::instance().evaluationDate() = vars.today;
+
+    vars.settlement = Date(19, February, 2002);
+    vars.termStructure.linkTo(flatRate(vars.settlement,
+                                          0.04875825,
+                                          Actual365Fixed()));
+
+    Rate atmRate = vars.makeSwap(0.0)->fairRate();
+    Rate strikes[] = { 0.8*atmRate, atmRate, 1.2*atmRate };
+
+    ext::shared_ptr<HullWhite> model(new HullWhite(vars.termStructure,
+                                                     0.048696, 0.0058904));
+
+    // time grid including all exercise and coupon times
+    ext::shared_ptr<VanillaSwap> atmSwap = vars.makeSwap(atmRate);
+    std::vector<Date> exerciseDates;
+    std::vector<Time> times;
+    DayCounter dayCounter = vars.termStructure->dayCounter();
+    for (Size k=0; k<2; k++) {
+        const Leg& leg = k == 0 ? atmSwap->fixedLeg()
+                                : atmSwap->floatingLeg();
+        for (Size i=0; i<leg.size(); i++) {
+            ext::shared_ptr<Coupon> coupon =
+                ext::dynamic_pointer_cast<Coupon>(leg[i]);
+            if (k == 0)
+                exerciseDates.push_back(coupon->accrualStartDate());
+            times.push_back(dayCounter.yearFraction(
+                             vars.settlement, coupon->accrualStartDate()));
+            times.push_back(dayCounter.yearFraction(
+                             vars.settlement, coupon->date()));
+        }
+    }
+    TimeGrid grid(times.begin(), times.end(), 200);
+    ext::shared_ptr<Exercise> exercise(new BermudanExercise(exerciseDates));
+
+    // the engine keeps its lattice for all swaptions
+    ext::shared_ptr<PricingEngine> sharedEngine(
+                                   new TreeSwaptionEngine(model, grid));
+
+    Real tolerance = 1.0e-10;
+    for (Size k=0; k<2; k++) {
+        for (Size i=0; i<LENGTH(strikes); i++) {
+            Swaption swaption(vars.makeSwap(strikes[i]), exercise);
+            swaption.setPricingEngine(sharedEngine);
+            Real calculated = swaption.NPV();
+            swaption.setPricingEngine(ext::shared_ptr<PricingEngine>(
+                                     new TreeSwaptionEngine(model, grid)));
+            Real expected = swaption.NPV();
+            if (std::fabs(calculated - expected) > tolerance)
+                BOOST_ERROR("failed to reproduce swaption value "
+                            "with shared lattice:\n"
+                            << std::setprecision(12)
+                            << "strike:     " << strikes[i] << "\n"
+                            << "calculated: " << calculated << "\n"
+                            << "expected:   " << expected);
+        }
+    }
+
+    /* a lattice reused across spread changes, whose cache is built
+       at the first spread, must give the same values as lattices
+       built from scratch for each spread */
+    ext::shared_ptr<Lattice> reused = model->tree(grid);
+    Spread spreads[] = { 0.0, 0.01, -0.005, 0.0 };
+    for (Size k=0; k<LENGTH(spreads); k++) {
+        ext::dynamic_pointer_cast<OneFactorModel::ShortRateTree>(reused)
+            ->setSpread(spreads[k]);
+        ext::shared_ptr<Lattice> fresh = model->tree(grid);
+        ext::dynamic_pointer_cast<OneFactorModel::ShortRateTree>(fresh)
+            ->setSpread(spreads[k]);
+        for (Size i=0; i<LENGTH(strikes); i++) {
+            Swaption swaption(vars.makeSwap(strikes[i]), exercise);
+            Real calculated =
+                latticeValue(swaption, reused, vars.settlement, dayCounter);
+            Real expected =
+                latticeValue(swaption, fresh, vars.settlement, dayCounter);
+            if (std::fabs(calculated - expected) > tolerance)
+                BOOST_ERROR("failed to reproduce swaption value "
+                            "on reused lattice after spread change:\n"
+                            << std::setprecision(12)
+                            << "spread:     " << spreads[k] << "\n"
+                            << "strike:     " << strikes[i] << "\n"
+                            << "calculated: " << calculated << "\n"
+                            << "expected:   " << expected);
+        }
+    }
+
+    // the cached discount factors follow changes in the spread
+    ext::shared_ptr<Lattice> lattice = model->tree(grid);
+    ext::shared_ptr<OneFactorModel::ShortRateTree> tree =
+        ext::dynamic_pointer_cast<OneFactorModel::ShortRateTree>(lattice);
+    Time maturity = grid.back();
+    Spread spread = 0.01;
+    Real values[3];
+    for (Size k=0; k<3; k++) {
+        tree->setSpread(k == 1 ? spread : 0.0);
+        DiscretizedDiscountBond bond;
+        bond.initialize(lattice, maturity);
+        bond.rollback(0.0);
+        values[k] = bond.values()[0];
+    }
+    if (std::fabs(values[1] - values[0]*std::exp(-spread*maturity))
+                                                              > tolerance
+        || std::fabs(values[2] - values[0]) > tolerance)
+        BOOST_ERROR("failed to reproduce discount bond values "
+                    "on spread-shifted tree:\n"
+                    << std::setprecision(12)
+                    << "without spread:      " << values[0] << "\n"
+                    << "with spread:         " << values[1] << "\n"
+                    << "expected:            "
+                    << values[0]*std::exp(-spread*maturity) << "\n"
+                    << "spread reset:        " << values[2]);
+
+    /* concurrent rollbacks on a lattice whose levels are not cached
+       yet; the assets are set up beforehand, since building them
+       goes through the observers */
+    ext::shared_ptr<Lattice> concurrent = model->tree(grid);
+    Time exerciseTime = dayCounter.yearFraction(vars.settlement,
+                                                exerciseDates.back());
+    const Size copies = 4;
+    std::vector<ext::shared_ptr<DiscretizedSwaption> > assets;
+    for (Size k=0; k<copies; k++) {
+        for (Size i=0; i<LENGTH(strikes); i++) {
+            Swaption swaption(vars.makeSwap(strikes[i]), exercise);
+            Swaption::arguments arguments;
+            swaption.setupArguments(&arguments);
+            assets.push_back(ext::make_shared<DiscretizedSwaption>(
+                              arguments, vars.settlement, dayCounter));
+        }
+    }
+    const long n = static_cast<long>(assets.size());
+    #pragma omp parallel for
+    for (long k=0; k<n; k++) {
+        assets[k]->initialize(concurrent, exerciseTime);
+        assets[k]->rollback(0.0);
+    }
+    for (Size k=0; k<assets.size(); k++) {
+        Size i = k % LENGTH(strikes);
+        Swaption swaption(vars.makeSwap(strikes[i]), exercise);
+        Real expected = latticeValue(swaption, model->tree(grid),
+                                     vars.settlement, dayCounter);
+        if (std::fabs(assets[k]->presentValue() - expected) > tolerance)
+            BOOST_ERROR("failed to reproduce swaption value "
+                        "with concurrent rollbacks:\n"
+                        << std::setprecision(12)
+                        << "strike:     " << strikes[i] << "\n"
+                        << "calculated: " << assets[k]->presentValue() << "\n"
+                        << "expected:   " << expected);
+    }
+}
+
+void BermudanSwaptionTest::testBatchLatticeRollback() {
+
+    BOOST_TEST_MESSAGE(
+        "Testing batch rollback of swaptions on a common lattice...");
+
+    using namespace bermudan_swaption_test;
+
+    CommonVars vars;
+
+    vars.today = Date(15, February, 2002);
+
+    Settings::instance().evaluationDate() = vars.today;
+
+    vars.settlement = Date(19, February, 2002);
+    vars.termStructure.linkTo(flatRate(vars.settlement,
+                                          0.04875825,
+                                          Actual365Fixed()));
+
+    Rate atmRate = vars.makeSwap(0.0)->fairRate();
+    Rate strikes[] = { 0.8*atmRate, atmRate, 1.2*atmRate };
+
+    ext::shared_ptr<HullWhite> model(new HullWhite(vars.termStructure,
+                                                     0.048696, 0.0058904));
+
+    // full Bermudan schedule and a shorter one, so that the assets
+    // don't start the rollback at the same time
+    ext::shared_ptr<VanillaSwap> atmSwap = vars.makeSwap(atmRate);
+    std::vector<Date> exerciseDates;
+    for (Size i=0; i<atmSwap->fixedLeg().size(); i++) {
+        ext::shared_ptr<Coupon> coupon =
+            ext::dynamic_pointer_cast<Coupon>(atmSwap->fixedLeg()[i]);
+        exerciseDates.push_back(coupon->accrualStartDate());
+    }
+    std::vector<ext::shared_ptr<Exercise> > exercises;
+    exercises.push_back(ext::shared_ptr<Exercise>(
+                                   new BermudanExercise(exerciseDates)));
+    exercises.push_back(ext::shared_ptr<Exercise>(
+                                   new EuropeanExercise(exerciseDates[2])));
+
+    Date referenceDate = vars.termStructure->referenceDate();
+    DayCounter dayCounter = vars.termStructure->dayCounter();
+
+    BatchLatticePricer pricer(model, 100);
+    std::vector<ext::shared_ptr<Swaption> > swaptions;
+    for (Size k=0; k<exercises.size(); k++) {
+        for (Size i=0; i<LENGTH(strikes); i++) {
+            ext::shared_ptr<Swaption> swaption(
+                new Swaption(vars.makeSwap(strikes[i]), exercises[k]));
+            Swaption::arguments arguments;
+            swaption->setupArguments(&arguments);
+            pricer.add(ext::shared_ptr<DiscretizedAsset>(
+                new DiscretizedSwaption(arguments, referenceDate,
+                                        dayCounter)));
+            swaptions.push_back(swaption);
+        }
+    }
+
+    // the single-asset rollback on the same lattice
+    ext::shared_ptr<PricingEngine> engine(
+        new TreeSwaptionEngine(model, pricer.lattice()->timeGrid()));
+
+    Real tolerance = 1.0e-10;
+    for (Size n=0; n<2; n++) {
+        // the second pass follows a change in the model parameters
+        if (n == 1) {
+            Array params = model->params();
+            params[1] *= 1.2;
+            model->setParams(params);
+            engine = ext::shared_ptr<PricingEngine>(
+                new TreeSwaptionEngine(model, pricer.lattice()->timeGrid()));
+        }
+        const std::vector<Real>& values = pricer.values();
+        for (Size i=0; i<swaptions.size(); i++) {
+            swaptions[i]->setPricingEngine(engine);
+            Real expected = swaptions[i]->NPV();
+            if (std::fabs(values[i] - expected) > tolerance)
+                BOOST_ERROR("failed to reproduce swaption value "
+                            "with batch rollback:\n"
+                            << std::setprecision(12)
+                            << "swaption:   " << i << "\n"
+                            << "calculated: " << values[i] << "\n"
+                            << "expected:   " << expected);
+        }
+    }
+}
+
+
 test_suite* BermudanSwaptionTest::suite(SpeedLevel speed) {
     auto* suite = BOOST_TEST_SUITE("Bermudan swaption tests");
 
     suite->add(QUANTLIB_TEST_CASE(&BermudanSwaptionTest::testCachedValues));
+    suite->add(QUANTLIB_TEST_CASE(&BermudanSwaptionTest::testTreeLatticeReuse));
+    suite->add(QUANTLIB_TEST_CASE(
+        &BermudanSwaptionTest::testBatchLatticeRollback));
 
     if (speed == Slow) {
         suite->add(QUANTLIB_TEST_CASE(
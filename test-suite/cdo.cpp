@@ -27,6 +27,9 @@
 #include <ql/experimental/credit/inhomogeneouspooldef.hpp>
 #include <ql/experimental/credit/homogeneouspooldef.hpp>
 #include <ql/experimental/credit/gaussianlhplossmodel.hpp>
+#include <ql/experimental/credit/binomiallossmodel.hpp>
+#include <ql/experimental/credit/recursivelossmodel.hpp>
+#include <ql/experimental/credit/fftlossmodel.hpp>
 #include <ql/termstructures/yield/flatforward.hpp>
 #include <ql/termstructures/credit/flathazardrate.hpp>
 #include <ql/time/calendars/target.hpp>
@@ -37,6 +40,7 @@
 #include <ql/functional.hpp>
 #include <boost/preprocessor/iteration/local.hpp>
 #include <iomanip>
+#include <numeric>
 #include <iostream>
 
 using namespace QuantLib;
@@ -89,6 +93,62 @@ namespace cdo_test {
                              << found << " vs. " << expected);
     }
 
+    // notionals of 200 every third name and 100 otherwise, flat hazard
+    // rates increasing by the given step from 50bp
+    ext::shared_ptr<Pool> heterogeneousPool(const Date& asofDate,
+                                            Size poolSize,
+                                            Real hazardRateStep,
+                                            vector<string>& names,
+                                            vector<Real>& nominals) {
+        ext::shared_ptr<Pool> pool(new Pool());
+        for (Size i=0; i<poolSize; ++i) {
+            ostringstream o;
+            o << "issuer-" << i;
+            names.push_back(o.str());
+            nominals.push_back(i % 3 == 0 ? 200.0 : 100.0);
+            Handle<Quote> hazardRate(ext::make_shared<SimpleQuote>(
+                                             0.005 + hazardRateStep*i));
+            vector<pair<DefaultProbKey,
+                   Handle<DefaultProbabilityTermStructure> > > probabilities;
+            probabilities.push_back(std::make_pair(
+                NorthAmericaCorpDefaultKey(EURCurrency(), SeniorSec,
+                                           Period(0,Weeks), 10.),
+                Handle<DefaultProbabilityTermStructure>(
+                    ext::make_shared<FlatHazardRate>(asofDate, hazardRate,
+                                                     ActualActual()))));
+            pool->add(names.back(), Issuer(probabilities),
+                      NorthAmericaCorpDefaultKey(EURCurrency(), SeniorSec,
+                                                 Period(), 1.));
+        }
+        return pool;
+    }
+
+    // integrates the conditional tranche losses node by node through
+    // the latent model, as the binomial model does for adaptive
+    // integrations
+    class NodeByNodeBinomialLossModel : public GaussianBinomialLossModel {
+      public:
+        explicit NodeByNodeBinomialLossModel(
+                       const ext::shared_ptr<GaussianConstantLossLM>& copula)
+        : GaussianBinomialLossModel(copula) {}
+        // integrates the conditional losses one node at a time
+        Real expectedTrancheLoss(const Date& d) const override {
+            using namespace ext::placeholders;
+            std::vector<Real> lossVals = lossPoints(d);
+            std::vector<Real> notionals = basket_->remainingNotionals(d);
+            std::vector<Probability> invProbs =
+                basket_->remainingProbabilities(d);
+            for (Size i=0; i<invProbs.size(); ++i)
+                invProbs[i] = copula_->inverseCumulativeY(invProbs[i], i);
+            return copula_->integratedExpectedValue(
+                ext::function<Real (const std::vector<Real>&)>(
+                    ext::bind(&NodeByNodeBinomialLossModel::condTrancheLoss,
+                              this, ext::cref(d), ext::cref(lossVals),
+                              ext::cref(notionals), ext::cref(invProbs),
+                              _1)));
+        }
+    };
+
 }
 
 #endif
@@ -222,7 +282,20 @@ void CdoTest::testHW(unsigned dataSet) {
         relativeTolerancePeriod.push_back(0.5);
         // Binomial...
         // Saddle point...
-        // Recursive ...
+        // Recursive gaussian
+        modelNames.push_back("Recursive gaussian");
+        basketModels.push_back(ext::shared_ptr<DefaultLossModel>(new
+            RecursiveGaussLossModel(gaussKtLossLM)));
+        absoluteTolerance.push_back(1.);
+        relativeToleranceMidp.push_back(0.04);
+        relativeTolerancePeriod.push_back(0.04);
+        // FFT gaussian
+        modelNames.push_back("FFT gaussian");
+        basketModels.push_back(ext::shared_ptr<DefaultLossModel>(new
+            FFTGaussLossModel(gaussKtLossLM)));
+        absoluteTolerance.push_back(1.);
+        relativeToleranceMidp.push_back(0.04);
+        relativeTolerancePeriod.push_back(0.04);
     }
     else if (hwData7[i].nm > 0 && hwData7[i].nz > 0) {
         TCopulaPolicy::initTraits initTG;
@@ -370,9 +443,256 @@ void CdoTest::testHW(unsigned dataSet) {
 }
 
 
+void CdoTest::testRecursiveLossModel() {
+    #ifndef QL_PATCH_SOLARIS
+
+    BOOST_TEST_MESSAGE("Testing the node-vectorised recursive and binomial "
+                       "loss models against adaptive integration...");
+
+    using namespace cdo_test;
+
+    SavedSettings backup;
+
+    Date asofDate(31, August, 2006);
+    Settings::instance().evaluationDate() = asofDate;
+
+    // heterogeneous in default probabilities and notionals
+    Size poolSize = 20;
+    Real recovery = 0.4;
+    vector<string> names;
+    vector<Real> nominals;
+    ext::shared_ptr<Pool> pool =
+        heterogeneousPool(asofDate, poolSize, 0.0015, names, nominals);
+    Handle<Quote> correlation(ext::make_shared<SimpleQuote>(0.3));
+
+    ext::shared_ptr<GaussianConstantLossLM> quadratureLM(
+        new GaussianConstantLossLM(correlation,
+            std::vector<Real>(poolSize, recovery),
+            LatentModelIntegrationType::GaussianQuadrature, poolSize,
+            GaussianCopulaPolicy::initTraits()));
+    ext::shared_ptr<GaussianConstantLossLM> adaptiveLM(
+        new GaussianConstantLossLM(correlation,
+            std::vector<Real>(poolSize, recovery),
+            LatentModelIntegrationType::Trapezoid, poolSize,
+            GaussianCopulaPolicy::initTraits()));
+
+    ext::shared_ptr<Basket> vectorised(new Basket(asofDate, names, nominals,
+                                                  pool, 0.03, 0.10));
+    vectorised->setLossModel(
+        ext::make_shared<RecursiveGaussLossModel>(quadratureLM));
+    ext::shared_ptr<Basket> adaptive(new Basket(asofDate, names, nominals,
+                                                pool, 0.03, 0.10));
+    adaptive->setLossModel(
+        ext::make_shared<RecursiveGaussLossModel>(adaptiveLM));
+
+    Real tolerance = 1.0e-4;
+    for (Size y=1; y<=5; y+=2) {
+        Date d = asofDate + Period(y, Years);
+
+        Real calculated = vectorised->expectedTrancheLoss(d);
+        Real expected = adaptive->expectedTrancheLoss(d);
+        if (std::fabs(calculated - expected) > tolerance * expected)
+            BOOST_ERROR("failed to reproduce expected tranche loss at "
+                        << d << ":"
+                        << "\n    vectorised: " << calculated
+                        << "\n    adaptive:   " << expected);
+
+        // the adaptive integration has no vector version; the loss
+        // distribution is checked against the expected tranche loss
+        std::map<Real, Probability> distrib = vectorised->lossDistribution(d);
+        Real attachment = 0.03 * vectorised->remainingNotional(),
+             detachment = 0.10 * vectorised->remainingNotional();
+        Real lossFromDistrib = 0.0;
+        Probability previous = 0.0;
+        for (std::map<Real, Probability>::const_iterator i = distrib.begin();
+             i != distrib.end(); ++i) {
+            Real loss = std::min(std::max(i->first - attachment, 0.0),
+                                 detachment - attachment);
+            lossFromDistrib += loss * (i->second - previous);
+            previous = i->second;
+        }
+        if (std::fabs(previous - 1.0) > 1.0e-10)
+            BOOST_ERROR("loss distribution at " << d
+                        << " doesn't add up to one: " << previous);
+        if (std::fabs(lossFromDistrib - calculated) > 1.0e-10 * calculated)
+            BOOST_ERROR("failed to reproduce expected tranche loss "
+                        "from loss distribution at " << d << ":"
+                        << "\n    from distribution: " << lossFromDistrib
+                        << "\n    expected:          " << calculated);
+    }
+
+    // same checks for the binomial model, whose loss points are not
+    // multiples of a loss unit.  Its conditional losses are not smooth
+    // in the market factor, so that the quadrature only agrees with
+    // the adaptive integration to within a looser tolerance; the
+    // latter doesn't converge at the longest horizon.  The vectorised
+    // integration must reproduce the node-by-node one on the same
+    // quadrature nodes, though.
+    ext::shared_ptr<Basket> nodeByNodeBasket(
+        new Basket(asofDate, names, nominals, pool, 0.03, 0.10));
+    nodeByNodeBasket->setLossModel(
+        ext::make_shared<NodeByNodeBinomialLossModel>(quadratureLM));
+    vectorised->setLossModel(
+        ext::make_shared<GaussianBinomialLossModel>(quadratureLM));
+    adaptive->setLossModel(
+        ext::make_shared<GaussianBinomialLossModel>(adaptiveLM));
+    Real binomialTolerance = 2.0e-2;
+    for (Size y=1; y<=5; y+=2) {
+        Date d = asofDate + Period(y, Years);
+
+        Real calculated = vectorised->expectedTrancheLoss(d);
+        Real expected = nodeByNodeBasket->expectedTrancheLoss(d);
+        if (std::fabs(calculated - expected) > 1.0e-10 * expected)
+            BOOST_ERROR("failed to reproduce node-by-node binomial expected "
+                        "tranche loss at " << d << ":"
+                        << std::setprecision(12)
+                        << "\n    vectorised:   " << calculated
+                        << "\n    node by node: " << expected);
+        if (y < 5) {
+            Real adaptiveLoss = adaptive->expectedTrancheLoss(d);
+            if (std::fabs(calculated - adaptiveLoss)
+                > binomialTolerance * adaptiveLoss)
+                BOOST_ERROR("failed to reproduce binomial expected tranche "
+                            "loss at " << d << ":"
+                            << "\n    vectorised: " << calculated
+                            << "\n    adaptive:   " << adaptiveLoss);
+        }
+
+        std::map<Real, Probability> distrib = vectorised->lossDistribution(d);
+        Real attachment = 0.03 * vectorised->remainingNotional(),
+             detachment = 0.10 * vectorised->remainingNotional();
+        Real lossFromDistrib = 0.0;
+        Probability previous = 0.0;
+        for (std::map<Real, Probability>::const_iterator i = distrib.begin();
+             i != distrib.end(); ++i) {
+            Real loss = std::min(std::max(i->first - attachment, 0.0),
+                                 detachment - attachment);
+            lossFromDistrib += loss * (i->second - previous);
+            previous = i->second;
+        }
+        if (std::fabs(lossFromDistrib - calculated) > 1.0e-10 * calculated)
+            BOOST_ERROR("failed to reproduce binomial expected tranche loss "
+                        "from loss distribution at " << d << ":"
+                        << "\n    from distribution: " << lossFromDistrib
+                        << "\n    expected:          " << calculated);
+    }
+    #endif
+}
+
+
+void CdoTest::testFFTLossModel() {
+    #ifndef QL_PATCH_SOLARIS
+
+    BOOST_TEST_MESSAGE("Testing the FFT loss model...");
+
+    using namespace cdo_test;
+
+    SavedSettings backup;
+
+    Date asofDate(31, August, 2006);
+    Settings::instance().evaluationDate() = asofDate;
+
+    // losses given default of 60 or 120, on a grid of 60
+    Size poolSize = 30;
+    Real recovery = 0.4;
+    vector<string> names;
+    vector<Real> nominals;
+    ext::shared_ptr<Pool> pool =
+        heterogeneousPool(asofDate, poolSize, 0.001, names, nominals);
+    Real totalLgd = (1.0 - recovery) *
+        std::accumulate(nominals.begin(), nominals.end(), 0.0);
+    Handle<Quote> correlation(ext::make_shared<SimpleQuote>(0.3));
+    ext::shared_ptr<GaussianConstantLossLM> lm(
+        new GaussianConstantLossLM(correlation,
+            std::vector<Real>(poolSize, recovery),
+            LatentModelIntegrationType::GaussianQuadrature, poolSize,
+            GaussianCopulaPolicy::initTraits()));
+
+    Size lossBuckets = Size(totalLgd / 60.0 + 0.5);
+    ext::shared_ptr<FFTGaussLossModel> fftModel(
+        new FFTGaussLossModel(lm, lossBuckets));
+    ext::shared_ptr<Basket> fft(new Basket(asofDate, names, nominals,
+                                           pool, 0.03, 0.10));
+    fft->setLossModel(fftModel);
+    ext::shared_ptr<Basket> recursive(new Basket(asofDate, names, nominals,
+                                                 pool, 0.03, 0.10));
+    recursive->setLossModel(ext::make_shared<RecursiveGaussLossModel>(lm));
+
+    Date d = asofDate + Period(5, Years);
+
+    Real tolerance = 1.0e-10;
+    Real calculated = fft->expectedTrancheLoss(d);
+    Real expected = recursive->expectedTrancheLoss(d);
+    if (std::fabs(calculated - expected) > tolerance * expected)
+        BOOST_ERROR("failed to reproduce expected tranche loss:"
+                    << "\n    FFT:       " << calculated
+                    << "\n    recursive: " << expected);
+
+    std::map<Real, Probability> calculatedDistrib = fft->lossDistribution(d);
+    std::map<Real, Probability> expectedDistrib =
+        recursive->lossDistribution(d);
+    std::map<Real, Probability>::const_iterator i1, i2;
+    for (i1 = calculatedDistrib.begin(), i2 = expectedDistrib.begin();
+         i1 != calculatedDistrib.end() && i2 != expectedDistrib.end();
+         ++i1, ++i2) {
+        if (std::fabs(i1->first - i2->first) > 1.0e-8 ||
+            std::fabs(i1->second - i2->second) > tolerance)
+            BOOST_ERROR("failed to reproduce loss distribution:"
+                        << "\n    FFT:       " << i1->first << ", "
+                        << i1->second
+                        << "\n    recursive: " << i2->first << ", "
+                        << i2->second);
+    }
+    if (std::fabs(calculatedDistrib.rbegin()->second - 1.0) > tolerance)
+        BOOST_ERROR("loss distribution doesn't add up to one: "
+                    << calculatedDistrib.rbegin()->second);
+
+    // splits of the portfolio loss at the 99% level and above it
+    Real varLevel = 0.0;
+    for (i1 = calculatedDistrib.begin(); i1 != calculatedDistrib.end(); ++i1) {
+        if (i1->second >= 0.99) {
+            varLevel = i1->first;
+            break;
+        }
+    }
+    std::vector<Real> varSplits = fft->splitVaRLevel(d, varLevel);
+    Real sum = std::accumulate(varSplits.begin(), varSplits.end(), 0.0);
+    if (std::fabs(sum - varLevel) > 1.0e-8 * varLevel)
+        BOOST_ERROR("VaR contributions don't add up to the VaR level:"
+                    << "\n    sum of contributions: " << sum
+                    << "\n    VaR level:            " << varLevel);
+
+    Real tailLoss = 0.0, tailProb = 0.0, previous = 0.0;
+    for (i1 = calculatedDistrib.begin(); i1 != calculatedDistrib.end(); ++i1) {
+        if (i1->first >= varLevel) {
+            tailLoss += i1->first * (i1->second - previous);
+            tailProb += i1->second - previous;
+        }
+        previous = i1->second;
+    }
+    std::vector<Real> esfSplits = fft->splitESFLevel(d, varLevel);
+    sum = std::accumulate(esfSplits.begin(), esfSplits.end(), 0.0);
+    if (std::fabs(sum - tailLoss/tailProb) > 1.0e-8 * sum)
+        BOOST_ERROR("expected shortfall contributions don't add up to the "
+                    "expected loss in the tail:"
+                    << "\n    sum of contributions: " << sum
+                    << "\n    expected tail loss:   " << tailLoss/tailProb);
+    // riskier names contribute more, for the same notional
+    if (varSplits[2] <= varSplits[1] || esfSplits[2] <= esfSplits[1])
+        BOOST_ERROR("riskier name contributing less than safer one:"
+                    << "\n    VaR contributions: " << varSplits[1]
+                    << ", " << varSplits[2]
+                    << "\n    ESF contributions: " << esfSplits[1]
+                    << ", " << esfSplits[2]);
+    #endif
+}
+
+
 test_suite* CdoTest::suite(SpeedLevel speed) {
     auto* suite = BOOST_TEST_SUITE("CDO tests");
 #ifndef QL_PATCH_SOLARIS
+    suite->add(QUANTLIB_TEST_CASE(&CdoTest::testRecursiveLossModel));
+    suite->add(QUANTLIB_TEST_CASE(&CdoTest::testFFTLossModel));
     if (speed == Slow) {
         #define BOOST_PP_LOCAL_MACRO(n) \
             suite->add(QUANTLIB_TEST_CASE(ext::bind(&CdoTest::testHW, n)));
@@ -29,6 +29,8 @@
 class CdoTest {
   public:
     static void testHW(unsigned dataSet);
+    static void testRecursiveLossModel();
+    static void testFFTLossModel();
     static boost::unit_test_framework::test_suite* suite(SpeedLevel);
 };
 
@@ -20,7 +20,9 @@
 #include "creditriskplus.hpp"
 #include "utilities.hpp"
 #include <ql/experimental/risk/creditriskplus.hpp>
+#include <ql/experimental/risk/fftcreditriskplus.hpp>
 #include <ql/math/comparison.hpp>
+#include <numeric>
 
 using namespace QuantLib;
 using namespace boost::unit_test_framework;
@@ -119,8 +121,164 @@ void CreditRiskPlusTest::testReferenceValues() {
                    << cr.lossQuantile(0.99) << ", should be 250)");
 }
 
+namespace {
+
+    // a single-sector portfolio with varying exposures and pds
+    void sectorPortfolio(Size obligors,
+                         Size sector,
+                         Real exposureScale,
+                         std::vector<Real>& exposure,
+                         std::vector<Real>& pd,
+                         std::vector<Size>& sectors) {
+        for (Size k = 0; k < obligors; ++k) {
+            exposure.push_back(exposureScale * (1.0 + 0.5 * (k % 7)));
+            pd.push_back(0.01 + 0.002 * (k % 5));
+            sectors.push_back(sector);
+        }
+    }
+
+}
+
+void CreditRiskPlusTest::testFFTSingleSector() {
+
+    BOOST_TEST_MESSAGE(
+        "Testing FFT credit risk plus against Panjer recursion...");
+
+    std::vector<Real> exposure, pd;
+    std::vector<Size> sector;
+    sectorPortfolio(200, 0, 1.0, exposure, pd, sector);
+    std::vector<Real> relativeDefaultVariance(1, 0.5);
+    Matrix rho(1, 1, 1.0);
+    Real unit = 0.25;
+
+    CreditRiskPlus panjer(exposure, pd, sector, relativeDefaultVariance,
+                          rho, unit);
+    FFTCreditRiskPlus fft(exposure, pd, sector, relativeDefaultVariance,
+                          unit, 0.99, 1.0 - 1.0e-12);
+
+    const std::vector<Real>& expected = panjer.loss();
+    const std::vector<Real>& calculated = fft.loss();
+    Size n = std::min(expected.size(), calculated.size());
+    Real tolerance = 1.0e-10;
+    for (Size i = 0; i < n; ++i) {
+        if (std::fabs(calculated[i] - expected[i]) > tolerance)
+            BOOST_FAIL("failed to reproduce loss probability at "
+                       << i * unit << ":"
+                       << "\n    FFT:       " << calculated[i]
+                       << "\n    Panjer:    " << expected[i]
+                       << "\n    tolerance: " << tolerance);
+    }
+
+    Real mass = std::accumulate(calculated.begin(), calculated.end(), 0.0);
+    if (std::fabs(mass - 1.0) > 1.0e-10)
+        BOOST_FAIL("truncated loss distribution has mass " << mass);
+
+    if (std::fabs(fft.unexpectedLoss() - panjer.unexpectedLoss()) > 1.0e-8)
+        BOOST_FAIL("failed to reproduce unexpected loss:"
+                   << "\n    FFT:    " << fft.unexpectedLoss()
+                   << "\n    Panjer: " << panjer.unexpectedLoss());
+}
+
+void CreditRiskPlusTest::testFFTIndependentSectors() {
+
+    BOOST_TEST_MESSAGE(
+        "Testing FFT credit risk plus with independent sectors...");
+
+    Real unit = 0.5;
+    std::vector<Real> relativeDefaultVariance;
+    relativeDefaultVariance.push_back(0.6);
+    relativeDefaultVariance.push_back(0.3);
+
+    // the distribution of each sector alone, from the Panjer recursion
+    std::vector<Real> exposure, pd;
+    std::vector<Size> sector;
+    std::vector<std::vector<Real> > sectorLoss;
+    Matrix rho(1, 1, 1.0);
+    for (Size s = 0; s < 2; ++s) {
+        std::vector<Real> sectorExposure, sectorPd;
+        std::vector<Size> sectorIndex;
+        sectorPortfolio(150, 0, 1.0 + s, sectorExposure, sectorPd,
+                        sectorIndex);
+        CreditRiskPlus panjer(sectorExposure, sectorPd, sectorIndex,
+                              std::vector<Real>(1, relativeDefaultVariance[s]),
+                              rho, unit);
+        sectorLoss.push_back(panjer.loss());
+        exposure.insert(exposure.end(), sectorExposure.begin(),
+                        sectorExposure.end());
+        pd.insert(pd.end(), sectorPd.begin(), sectorPd.end());
+        sector.insert(sector.end(), sectorExposure.size(), s);
+    }
+
+    FFTCreditRiskPlus fft(exposure, pd, sector, relativeDefaultVariance,
+                          unit, 0.995, 1.0 - 1.0e-12);
+
+    const std::vector<Real>& calculated = fft.loss();
+    Real tolerance = 1.0e-10;
+    for (Size n = 0; n < calculated.size(); ++n) {
+        Real expected = 0.0;
+        for (Size i = 0; i <= n && i < sectorLoss[0].size(); ++i) {
+            if (n - i < sectorLoss[1].size())
+                expected += sectorLoss[0][i] * sectorLoss[1][n - i];
+        }
+        if (std::fabs(calculated[n] - expected) > tolerance)
+            BOOST_FAIL("failed to reproduce loss probability at "
+                       << n * unit << ":"
+                       << "\n    FFT:         " << calculated[n]
+                       << "\n    convolution: " << expected
+                       << "\n    tolerance:   " << tolerance);
+    }
+
+    // add a sector of independent obligors and check the moments, the
+    // truncation and the risk contributions
+    sectorPortfolio(100, 2, 0.5, exposure, pd, sector);
+    relativeDefaultVariance.push_back(0.0);
+    Probability truncationLevel = 0.9999;
+    FFTCreditRiskPlus cr(exposure, pd, sector, relativeDefaultVariance,
+                         unit, 0.99, truncationLevel);
+
+    const std::vector<Real>& loss = cr.loss();
+    Real mass = 0.0, mean = 0.0, secondMoment = 0.0;
+    for (Size n = 0; n < loss.size(); ++n) {
+        mass += loss[n];
+        mean += n * unit * loss[n];
+        secondMoment += n * unit * n * unit * loss[n];
+    }
+    if (mass < truncationLevel)
+        BOOST_FAIL("truncated loss distribution has mass " << mass
+                   << " below the truncation level " << truncationLevel);
+    Real variance = secondMoment - mean * mean;
+    if (std::fabs(mean - cr.expectedLoss()) > 1.0e-3 * cr.expectedLoss())
+        BOOST_FAIL("failed to reproduce expected loss:"
+                   << "\n    distribution: " << mean
+                   << "\n    model:        " << cr.expectedLoss());
+    if (std::fabs(std::sqrt(variance) - cr.unexpectedLoss()) >
+        1.0e-2 * cr.unexpectedLoss())
+        BOOST_FAIL("failed to reproduce unexpected loss:"
+                   << "\n    distribution: " << std::sqrt(variance)
+                   << "\n    model:        " << cr.unexpectedLoss());
+
+    const std::vector<Real>& contributions = cr.riskContributions();
+    Real sum = std::accumulate(contributions.begin(), contributions.end(),
+                               0.0);
+    if (std::fabs(sum - cr.expectedShortfall()) >
+        1.0e-6 * cr.expectedShortfall())
+        BOOST_FAIL("risk contributions don't add up to expected shortfall:"
+                   << "\n    sum of contributions: " << sum
+                   << "\n    expected shortfall:   "
+                   << cr.expectedShortfall());
+    if (cr.expectedShortfall() < cr.valueAtRisk() ||
+        cr.valueAtRisk() != cr.lossQuantile(0.99))
+        BOOST_FAIL("inconsistent tail measures:"
+                   << "\n    value at risk:      " << cr.valueAtRisk()
+                   << "\n    99% quantile:       " << cr.lossQuantile(0.99)
+                   << "\n    expected shortfall: " << cr.expectedShortfall());
+}
+
 test_suite *CreditRiskPlusTest::suite() {
     auto* suite = BOOST_TEST_SUITE("Credit risk plus tests");
     suite->add(QUANTLIB_TEST_CASE(&CreditRiskPlusTest::testReferenceValues));
+    suite->add(QUANTLIB_TEST_CASE(&CreditRiskPlusTest::testFFTSingleSector));
+    suite->add(
+        QUANTLIB_TEST_CASE(&CreditRiskPlusTest::testFFTIndependentSectors));
     return suite;
 }
@@ -28,6 +28,8 @@
 class CreditRiskPlusTest {
   public:
     static void testReferenceValues();
+    static void testFFTSingleSector();
+    static void testFFTIndependentSectors();
     static boost::unit_test_framework::test_suite *suite();
 };
 
@@ -27,6 +27,8 @@
 #include <ql/termstructures/yield/discountcurve.hpp>
 #include <ql/instruments/creditdefaultswap.hpp>
 #include <ql/pricingengines/credit/midpointcdsengine.hpp>
+#include <ql/pricingengines/credit/isdacdsbatch.hpp>
+#include <ql/pricingengines/credit/isdacdsengine.hpp>
 #include <ql/math/interpolations/linearinterpolation.hpp>
 #include <ql/math/interpolations/backwardflatinterpolation.hpp>
 #include <ql/math/interpolations/loginterpolation.hpp>
@@ -558,6 +560,192 @@ void DefaultProbabilityCurveTest::testIterativeBootstrapRetries() {
 }
 
 
+void DefaultProbabilityCurveTest::testIsdaCdsBatch() {
+
+    BOOST_TEST_MESSAGE("Testing batch ISDA bootstrap against CDS helpers...");
+
+    SavedSettings backup;
+
+    Date asof(1, Apr, 2020);
+    Settings::instance().evaluationDate() = asof;
+    Actual365Fixed tsDayCounter;
+
+    // same USD discount curve as in testIterativeBootstrapRetries
+    vector<Date> usdCurveDates = list_of
+        (Date(1, Apr, 2020))(Date(2, Apr, 2020))(Date(14, Apr, 2020))
+        (Date(21, Apr, 2020))(Date(28, Apr, 2020))(Date(6, May, 2020))
+        (Date(5, Jun, 2020))(Date(7, Jul, 2020))(Date(5, Aug, 2020))
+        (Date(8, Sep, 2020))(Date(7, Oct, 2020))(Date(5, Nov, 2020))
+        (Date(7, Dec, 2020))(Date(6, Jan, 2021))(Date(5, Feb, 2021))
+        (Date(5, Mar, 2021))(Date(7, Apr, 2021))(Date(4, Apr, 2022))
+        (Date(3, Apr, 2023))(Date(3, Apr, 2024))(Date(3, Apr, 2025))
+        (Date(5, Apr, 2027))(Date(3, Apr, 2030))(Date(3, Apr, 2035))
+        (Date(3, Apr, 2040))(Date(4, Apr, 2050));
+    vector<DiscountFactor> usdCurveDfs = list_of
+        (1.000000000)(0.999955835)(0.999931070)(0.999914629)(0.999902799)
+        (0.999887990)(0.999825782)(0.999764392)(0.999709076)(0.999647785)
+        (0.999594638)(0.999536198)(0.999483093)(0.999419291)(0.999379417)
+        (0.999324981)(0.999262356)(0.999575101)(0.996135441)(0.995228348)
+        (0.989366687)(0.979271200)(0.961150726)(0.926265361)(0.891640651)
+        (0.839314063);
+    RelinkableHandle<YieldTermStructure> usdYts(
+        ext::make_shared<InterpolatedDiscountCurve<LogLinear> >(
+            usdCurveDates, usdCurveDfs, tsDayCounter));
+
+    // ISDA conventions
+    Integer settlementDays = 1;
+    WeekendsOnly calendar;
+    Frequency frequency = Quarterly;
+    BusinessDayConvention paymentConvention = Following;
+    DateGeneration::Rule rule = DateGeneration::CDS2015;
+    Actual360 dayCounter;
+    Actual360 lastPeriodDayCounter(true);
+    Natural upfrontSettlementDays = 3;
+
+    vector<Period> tenors = list_of
+        (6 * Months)(1 * Years)(2 * Years)(3 * Years)
+        (5 * Years)(7 * Years)(10 * Years);
+
+    vector<vector<Rate> > quotes;
+    quotes.push_back(list_of
+        (0.0030)(0.0035)(0.0045)(0.0055)(0.0075)(0.0090)(0.0100));
+    quotes.push_back(list_of
+        (0.0150)(0.0160)(0.0180)(0.0200)(0.0230)(0.0245)(0.0255));
+    quotes.push_back(list_of
+        (0.0600)(0.0580)(0.0540)(0.0510)(0.0480)(0.0470)(0.0465));
+    // upfronts on a 100bp running spread, for a name quoted wider; as
+    // for CreditDefaultSwap::fairUpfront, they are negative in that case
+    quotes.push_back(list_of
+        (-0.0140)(-0.0300)(-0.0630)(-0.0990)(-0.1570)(-0.2100)(-0.2800));
+    vector<Real> recoveries = list_of(0.4)(0.4)(0.25)(0.4);
+    Rate runningSpread = 0.01;
+    Size upfrontName = 3;
+
+    IsdaCdsBatch batch(tenors, usdYts, settlementDays, calendar, frequency,
+                       paymentConvention, rule, dayCounter,
+                       lastPeriodDayCounter, true, upfrontSettlementDays);
+    for (Size i=0; i<quotes.size(); ++i) {
+        if (i == upfrontName)
+            batch.addName(quotes[i], runningSpread, recoveries[i]);
+        else
+            batch.addName(quotes[i], recoveries[i]);
+    }
+
+    typedef PiecewiseDefaultCurve<SurvivalProbability, LogLinear> SPCurve;
+    Real tolerance = 1.0e-8;
+
+    for (Size i=0; i<quotes.size(); ++i) {
+        vector<ext::shared_ptr<DefaultProbabilityHelper> > instruments;
+        for (Size k=0; k<tenors.size(); ++k) {
+            if (i == upfrontName)
+                instruments.push_back(ext::make_shared<UpfrontCdsHelper>(
+                    quotes[i][k], runningSpread, tenors[k], settlementDays,
+                    calendar, frequency, paymentConvention, rule, dayCounter,
+                    recoveries[i], usdYts, upfrontSettlementDays, true, true,
+                    Date(), lastPeriodDayCounter, true,
+                    CreditDefaultSwap::ISDA));
+            else
+                instruments.push_back(ext::make_shared<SpreadCdsHelper>(
+                    quotes[i][k], tenors[k], settlementDays, calendar,
+                    frequency, paymentConvention, rule, dayCounter,
+                    recoveries[i], usdYts, true, true, Date(),
+                    lastPeriodDayCounter, true, CreditDefaultSwap::ISDA));
+        }
+        SPCurve expectedCurve(asof, instruments, tsDayCounter);
+
+        vector<Probability> survival = batch.survivalProbabilities(i);
+        for (Size k=0; k<tenors.size(); ++k) {
+            Date pillar = batch.pillarDates()[k];
+            if (pillar != instruments[k]->pillarDate())
+                BOOST_FAIL("pillar dates don't match for " << tenors[k]
+                           << ":\n    batch:   " << pillar
+                           << "\n    helpers: "
+                           << instruments[k]->pillarDate());
+            Probability expected = expectedCurve.survivalProbability(pillar);
+            if (std::fabs(survival[k] - expected) > tolerance)
+                BOOST_ERROR("failed to reproduce survival probability"
+                            << " of name #" << i << " at " << pillar
+                            << std::setprecision(12)
+                            << "\n    batch:     " << survival[k]
+                            << "\n    helpers:   " << expected
+                            << "\n    tolerance: " << tolerance);
+        }
+    }
+
+    // fair quotes are checked against the ISDA engine on the batch
+    // curves, for the 5-years tenor
+    Size k = 4;
+    Schedule schedule = MakeSchedule()
+        .from(asof + settlementDays)
+        .to(cdsMaturity(asof, tenors[k], rule))
+        .withFrequency(frequency)
+        .withCalendar(calendar)
+        .withConvention(paymentConvention)
+        .withTerminationDateConvention(Unadjusted)
+        .withRule(rule);
+    if (schedule.dates().back() != batch.maturities()[k])
+        BOOST_FAIL("maturity dates don't match:"
+                   << "\n    batch: " << batch.maturities()[k]
+                   << "\n    CDS:   " << schedule.dates().back());
+    Date upfrontDate = calendar.advance(asof, upfrontSettlementDays, Days,
+                                        paymentConvention);
+    CreditDefaultSwap cds(Protection::Buyer, 1.0, 0.0, runningSpread,
+                          schedule, paymentConvention, dayCounter, true, true,
+                          asof + settlementDays, upfrontDate,
+                          ext::shared_ptr<Claim>(), lastPeriodDayCounter,
+                          true, asof);
+
+    vector<Rate> fairSpreads = batch.fairSpreads(k);
+    vector<Rate> fairUpfronts = batch.fairUpfronts(k, runningSpread);
+    for (Size i=0; i<quotes.size(); ++i) {
+        cds.setPricingEngine(ext::make_shared<IsdaCdsEngine>(
+            Handle<DefaultProbabilityTermStructure>(batch.defaultCurve(i)),
+            recoveries[i], usdYts));
+        if (i != upfrontName &&
+            std::fabs(fairSpreads[i] - quotes[i][k]) > tolerance)
+            BOOST_ERROR("failed to reprice quoted spread of name #" << i
+                        << std::setprecision(12)
+                        << "\n    fair spread:  " << fairSpreads[i]
+                        << "\n    quote:        " << quotes[i][k]);
+        if (i == upfrontName &&
+            std::fabs(fairUpfronts[i] - quotes[i][k]) > tolerance)
+            BOOST_ERROR("failed to reprice quoted upfront of name #" << i
+                        << std::setprecision(12)
+                        << "\n    fair upfront: " << fairUpfronts[i]
+                        << "\n    quote:        " << quotes[i][k]);
+        if (std::fabs(fairSpreads[i] - cds.fairSpread()) > tolerance)
+            BOOST_ERROR("failed to reproduce fair spread of name #" << i
+                        << std::setprecision(12)
+                        << "\n    batch:  " << fairSpreads[i]
+                        << "\n    engine: " << cds.fairSpread());
+        if (std::fabs(fairUpfronts[i] - cds.fairUpfront()) > tolerance)
+            BOOST_ERROR("failed to reproduce fair upfront of name #" << i
+                        << std::setprecision(12)
+                        << "\n    batch:  " << fairUpfronts[i]
+                        << "\n    engine: " << cds.fairUpfront());
+    }
+
+    // the batch observes the discount curve and is bootstrapped again
+    vector<Probability> previous = batch.survivalProbabilities(0);
+    usdYts.linkTo(ext::make_shared<FlatForward>(asof, 0.03, tsDayCounter));
+    if (batch.survivalProbabilities(0)[k] == previous[k])
+        BOOST_ERROR("survival probabilities not updated "
+                    "after relinking the discount curve");
+    fairSpreads = batch.fairSpreads(k);
+    cds.setPricingEngine(ext::make_shared<IsdaCdsEngine>(
+        Handle<DefaultProbabilityTermStructure>(batch.defaultCurve(0)),
+        recoveries[0], usdYts));
+    if (std::fabs(fairSpreads[0] - quotes[0][k]) > tolerance ||
+        std::fabs(cds.fairSpread() - quotes[0][k]) > tolerance)
+        BOOST_ERROR("failed to reprice quoted spread of name #0 "
+                    "after relinking the discount curve"
+                    << std::setprecision(12)
+                    << "\n    batch:  " << fairSpreads[0]
+                    << "\n    engine: " << cds.fairSpread()
+                    << "\n    quote:  " << quotes[0][k]);
+}
+
+
 test_suite* DefaultProbabilityCurveTest::suite() {
     auto* suite = BOOST_TEST_SUITE("Default-probability curve tests");
     suite->add(QUANTLIB_TEST_CASE(
@@ -578,5 +766,7 @@ test_suite* DefaultProbabilityCurveTest::suite() {
                          &DefaultProbabilityCurveTest::testUpfrontBootstrap));
     suite->add(QUANTLIB_TEST_CASE(
                 &DefaultProbabilityCurveTest::testIterativeBootstrapRetries));
+    suite->add(QUANTLIB_TEST_CASE(
+                             &DefaultProbabilityCurveTest::testIsdaCdsBatch));
     return suite;
 }
@@ -37,6 +37,7 @@ class DefaultProbabilityCurveTest {
     static void testSingleInstrumentBootstrap();
     static void testUpfrontBootstrap();
     static void testIterativeBootstrapRetries();
+    static void testIsdaCdsBatch();
     static boost::unit_test_framework::test_suite* suite();
 };
 
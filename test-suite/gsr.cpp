@@ -285,9 +285,137 @@ void GsrTest::testGsrModel() {
                     << GsrJamNpv << ")");
 }
 
+void GsrTest::testCachedGrids() {
+
+    BOOST_TEST_MESSAGE("Testing Gaussian1d engines with cached grids...");
+
+    SavedSettings backup;
+
+    Date refDate = Settings::instance().evaluationDate();
+
+    Handle<YieldTermStructure> yts(ext::shared_ptr<YieldTermStructure>(
+        new FlatForward(0, TARGET(), 0.03, Actual365Fixed())));
+    RelinkableHandle<YieldTermStructure> disc(ext::shared_ptr<YieldTermStructure>(
+        new FlatForward(0, TARGET(), 0.02, Actual365Fixed())));
+
+    std::vector<Date> stepDates;
+    for (Size i = 1; i < 10; i++)
+        stepDates.push_back(refDate + (i * Years));
+    std::vector<Real> vols(stepDates.size() + 1, 0.01);
+    std::vector<Real> reversions(1, 0.02);
+    ext::shared_ptr<Gsr> model(new Gsr(yts, stepDates, vols, reversions, 50.0));
+
+    ext::shared_ptr<IborIndex> euribor(new Euribor6M(yts));
+    Date startDate = TARGET().advance(refDate, 2 * Years);
+    ext::shared_ptr<VanillaSwap> underlying =
+        MakeVanillaSwap(10 * Years, euribor, 0.03)
+            .withEffectiveDate(startDate)
+            .withDiscountingTermStructure(disc);
+    std::vector<Date> exerciseDates;
+    for (Size i = 0; i < underlying->fixedLeg().size() - 1; i++)
+        exerciseDates.push_back(TARGET().advance(
+            ext::dynamic_pointer_cast<Coupon>(underlying->fixedLeg()[i])
+                ->accrualStartDate(),
+            -2 * Days));
+    ext::shared_ptr<Exercise> exercise(new BermudanExercise(exerciseDates));
+    Swaption swaption(underlying, exercise);
+    NonstandardSwaption nonstdswaption(swaption);
+
+    swaption.setPricingEngine(ext::shared_ptr<PricingEngine>(
+        new Gaussian1dSwaptionEngine(model, 64, 7.0, true, false, disc)));
+    nonstdswaption.setPricingEngine(ext::shared_ptr<PricingEngine>(
+        new Gaussian1dNonstandardSwaptionEngine(
+            model, 64, 7.0, true, false, Handle<Quote>(), disc)));
+    Real npv = swaption.NPV();
+    Real nonstdNpv = nonstdswaption.NPV();
+
+    if (fabs(npv - nonstdNpv) > 1E-8)
+        BOOST_ERROR("Gaussian1dNonstandardSwaptionEngine NPV ("
+                    << nonstdNpv
+                    << ") deviates from Gaussian1dSwaptionEngine NPV ("
+                    << npv << ")");
+
+    // a second engine sharing the model uses the cached grids
+    Swaption swaption2(underlying, exercise);
+    swaption2.setPricingEngine(ext::shared_ptr<PricingEngine>(
+        new Gaussian1dSwaptionEngine(model, 64, 7.0, true, false, disc)));
+    Real npv2 = swaption2.NPV();
+    if (fabs(npv - npv2) > 1E-12)
+        BOOST_ERROR("NPV from cached grids (" << npv2
+                    << ") deviates from original NPV (" << npv << ")");
+
+    // a change in the discounting curve invalidates the cached grids
+    disc.linkTo(ext::shared_ptr<YieldTermStructure>(
+        new FlatForward(0, TARGET(), 0.025, Actual365Fixed())));
+    Real npv3 = swaption.NPV();
+    ext::shared_ptr<Gsr> model2(new Gsr(yts, stepDates, vols, reversions, 50.0));
+    swaption2.setPricingEngine(ext::shared_ptr<PricingEngine>(
+        new Gaussian1dSwaptionEngine(model2, 64, 7.0, true, false, disc)));
+    Real expected = swaption2.NPV();
+    if (fabs(npv3 - expected) > 1E-12 || fabs(npv3 - npv) < 1E-6)
+        BOOST_ERROR("NPV after change of discounting curve ("
+                    << npv3 << ") deviates from NPV with new model ("
+                    << expected << "), NPV before change was " << npv);
+
+    // so does a change in the model parameters
+    Array params = model->params();
+    params[1] = 0.012; // reversion first, then the volatilities
+    model->setParams(params);
+    Real npv4 = swaption.NPV();
+    std::vector<Real> vols2(vols);
+    vols2[0] = 0.012;
+    ext::shared_ptr<Gsr> model3(new Gsr(yts, stepDates, vols2, reversions, 50.0));
+    swaption2.setPricingEngine(ext::shared_ptr<PricingEngine>(
+        new Gaussian1dSwaptionEngine(model3, 64, 7.0, true, false, disc)));
+    expected = swaption2.NPV();
+    if (fabs(npv4 - expected) > 1E-12 || fabs(npv4 - npv3) < 1E-6)
+        BOOST_ERROR("NPV after change of model parameters ("
+                    << npv4 << ") deviates from NPV with new model ("
+                    << expected << "), NPV before change was " << npv3);
+
+    /* grids requested concurrently from a model which is not
+       calculated yet, more of them than the cache keeps, and on
+       curves which are destroyed in between */
+    ext::shared_ptr<Gsr> model4(new Gsr(yts, stepDates, vols, reversions, 50.0));
+    Date referenceDate = refDate + 1 * Years;
+    Array z = model4->yGrid(7.0, 8);
+    const long n = 600;
+    std::vector<Array> grids(n);
+    #pragma omp parallel for
+    for (long i = 0; i < n; i++)
+        grids[i] = model4->zerobondGrid(referenceDate + (i + 1) * Weeks,
+                                        referenceDate, 7.0, 8);
+    for (long i = 0; i < n; i += 50) {
+        Date maturity = referenceDate + (i + 1) * Weeks;
+        Array again = model4->zerobondGrid(maturity, referenceDate, 7.0, 8);
+        for (Size j = 0; j < z.size(); j++) {
+            Real direct = model4->zerobond(maturity, referenceDate, z[j]);
+            if (fabs(grids[i][j] - direct) > 1E-14 ||
+                fabs(again[j] - direct) > 1E-14)
+                BOOST_FAIL("zerobond grid (" << grids[i][j] << ", then "
+                           << again[j] << ") deviates from zerobond ("
+                           << direct << ") at maturity " << maturity);
+        }
+    }
+    for (Size k = 0; k < 2; k++) {
+        Handle<YieldTermStructure> curve(ext::shared_ptr<YieldTermStructure>(
+            new FlatForward(0, TARGET(), 0.01 + 0.01 * k, Actual365Fixed())));
+        Date maturity = referenceDate + 5 * Years;
+        Array grid = model4->zerobondGrid(maturity, referenceDate, 7.0, 8, curve);
+        for (Size j = 0; j < z.size(); j++) {
+            Real direct = model4->zerobond(maturity, referenceDate, z[j], curve);
+            if (fabs(grid[j] - direct) > 1E-14)
+                BOOST_FAIL("zerobond grid (" << grid[j]
+                           << ") deviates from zerobond (" << direct
+                           << ") on curve " << k);
+        }
+    }
+}
+
 test_suite *GsrTest::suite() {
     auto* suite = BOOST_TEST_SUITE("GSR model tests");
     suite->add(QUANTLIB_TEST_CASE(&GsrTest::testGsrProcess));
     suite->add(QUANTLIB_TEST_CASE(&GsrTest::testGsrModel));
+    suite->add(QUANTLIB_TEST_CASE(&GsrTest::testCachedGrids));
     return suite;
 }
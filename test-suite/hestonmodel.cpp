@@ -29,6 +29,8 @@
 #include <ql/models/equity/piecewisetimedependenthestonmodel.hpp>
 #include <ql/pricingengines/vanilla/analyticdividendeuropeanengine.hpp>
 #include <ql/pricingengines/vanilla/analytichestonengine.hpp>
+#include <ql/pricingengines/vanilla/analytichestonhullwhiteengine.hpp>
+#include <ql/pricingengines/vanilla/batesengine.hpp>
 #include <ql/pricingengines/vanilla/hestonexpansionengine.hpp>
 #include <ql/pricingengines/vanilla/coshestonengine.hpp>
 #include <ql/pricingengines/vanilla/analyticptdhestonengine.hpp>
@@ -3265,6 +3267,345 @@ void HestonModelTest::testAsymptoticControlVariate() {
 }
 
 
+void HestonModelTest::testBatchPricing() {
+    BOOST_TEST_MESSAGE("Testing Heston batch pricing of strike strips...");
+
+    SavedSettings backup;
+
+    const Date settlementDate(5, July, 2021);
+    Settings::instance().evaluationDate() = settlementDate;
+
+    const DayCounter dayCounter = Actual365Fixed();
+    const Handle<YieldTermStructure> riskFreeTS(flatRate(0.03, dayCounter));
+    const Handle<YieldTermStructure> dividendTS(flatRate(0.01, dayCounter));
+
+    const Handle<Quote> s0(ext::make_shared<SimpleQuote>(100.0));
+
+    const Real v0    =  0.04;
+    const Real rho   = -0.6;
+    const Real sigma =  0.5;
+    const Real kappa =  1.5;
+    const Real theta =  0.06;
+
+    const ext::shared_ptr<HestonProcess> process =
+        ext::make_shared<HestonProcess>(
+            riskFreeTS, dividendTS, s0, v0, kappa, theta, sigma, rho);
+
+    const ext::shared_ptr<HestonModel> hestonModel =
+        ext::make_shared<HestonModel>(process);
+
+    const ext::shared_ptr<BatesModel> batesModel =
+        ext::make_shared<BatesModel>(
+            ext::make_shared<BatesProcess>(
+                riskFreeTS, dividendTS, s0, v0, kappa, theta, sigma, rho,
+                0.3, -0.1, 0.15));
+
+    const Period maturities[] = { Period(1, Months), Period(1, Years),
+                                  Period(1, Years), Period(5, Years) };
+    const Real strikes[] = { 50.0, 80.0, 95.0, 100.0, 110.0, 150.0 };
+
+    std::vector<ext::shared_ptr<VanillaOption> > options;
+    for (Size i=0; i < LENGTH(maturities); ++i)
+        for (Size j=0; j < LENGTH(strikes); ++j)
+            options.push_back(ext::make_shared<VanillaOption>(
+                ext::make_shared<PlainVanillaPayoff>(
+                    ((i+j) % 2 == 0) ? Option::Call : Option::Put,
+                    strikes[j]),
+                ext::make_shared<EuropeanExercise>(
+                    settlementDate + maturities[i])));
+
+    typedef AnalyticHestonEngine::Integration Integration;
+    const ext::shared_ptr<AnalyticHestonEngine> analyticEngines[] = {
+        ext::make_shared<AnalyticHestonEngine>(hestonModel),
+        ext::make_shared<AnalyticHestonEngine>(
+            hestonModel, AnalyticHestonEngine::BranchCorrection,
+            Integration::gaussLaguerre(160)),
+        ext::make_shared<AnalyticHestonEngine>(
+            hestonModel, AnalyticHestonEngine::Gatheral,
+            Integration::gaussLegendre(256)),
+        ext::make_shared<AnalyticHestonEngine>(
+            hestonModel, AnalyticHestonEngine::AndersenPiterbarg,
+            Integration::gaussChebyshev(256)),
+        ext::make_shared<AnalyticHestonEngine>(
+            hestonModel, AnalyticHestonEngine::OptimalCV,
+            Integration::gaussLaguerre(96)),
+        ext::make_shared<BatesEngine>(batesModel)
+    };
+    const ext::shared_ptr<COSHestonEngine> cosEngine =
+        ext::make_shared<COSHestonEngine>(hestonModel, 16, 256);
+
+    const Real tol = 1e-9;
+
+    for (Size e=0; e <= LENGTH(analyticEngines); ++e) {
+        const ext::shared_ptr<PricingEngine> engine =
+            (e < LENGTH(analyticEngines))
+            ? ext::shared_ptr<PricingEngine>(analyticEngines[e])
+            : ext::shared_ptr<PricingEngine>(cosEngine);
+
+        const std::vector<Real> calculated =
+            (e < LENGTH(analyticEngines))
+            ? analyticEngines[e]->values(options)
+            : cosEngine->values(options);
+
+        for (Size i=0; i < options.size(); ++i) {
+            options[i]->setPricingEngine(engine);
+            const Real expected = options[i]->NPV();
+            const Real diff = std::fabs(calculated[i] - expected);
+
+            if (diff > tol) {
+                const ext::shared_ptr<StrikedTypePayoff> payoff =
+                    ext::dynamic_pointer_cast<StrikedTypePayoff>(
+                        options[i]->payoff());
+                BOOST_ERROR("failed to reproduce single option prices "
+                            "with batch pricing"
+                            << "\n  engine     : " << e
+                            << "\n  expiry     : "
+                            << options[i]->exercise()->lastDate()
+                            << "\n  strike     : " << payoff->strike()
+                            << "\n  calculated : " << calculated[i]
+                            << "\n  expected   : " << expected
+                            << "\n  difference : " << diff
+                            << "\n  tolerance  : " << tol);
+            }
+        }
+    }
+
+    const AnalyticHestonEngine adaptiveEngine(hestonModel, 1e-8, 10000);
+    BOOST_CHECK_THROW(adaptiveEngine.values(options), Error);
+}
+
+void HestonModelTest::testAnalyticGradient() {
+    BOOST_TEST_MESSAGE(
+        "Testing analytic gradients of Heston option prices...");
+
+    SavedSettings backup;
+
+    const Date settlementDate(5, July, 2021);
+    Settings::instance().evaluationDate() = settlementDate;
+
+    const DayCounter dayCounter = Actual365Fixed();
+    const Handle<YieldTermStructure> riskFreeTS(flatRate(0.03, dayCounter));
+    const Handle<YieldTermStructure> dividendTS(flatRate(0.01, dayCounter));
+
+    const Handle<Quote> s0(ext::make_shared<SimpleQuote>(100.0));
+
+    const Real v0    =  0.04;
+    const Real rho   = -0.6;
+    const Real sigma =  0.5;
+    const Real kappa =  1.5;
+    const Real theta =  0.06;
+
+    const ext::shared_ptr<HestonModel> hestonModel =
+        ext::make_shared<HestonModel>(
+            ext::make_shared<HestonProcess>(
+                riskFreeTS, dividendTS, s0, v0, kappa, theta, sigma, rho));
+
+    const ext::shared_ptr<BatesModel> batesModel =
+        ext::make_shared<BatesModel>(
+            ext::make_shared<BatesProcess>(
+                riskFreeTS, dividendTS, s0, v0, kappa, theta, sigma, rho,
+                0.3, -0.1, 0.15));
+
+    std::vector<Time> pTimes(1, 0.5);
+    PiecewiseConstantParameter ptdKappa(pTimes, PositiveConstraint());
+    ptdKappa.setParam(0, kappa); ptdKappa.setParam(1, 2.5);
+    PiecewiseConstantParameter ptdTheta(pTimes, PositiveConstraint());
+    ptdTheta.setParam(0, theta); ptdTheta.setParam(1, 0.04);
+    PiecewiseConstantParameter ptdSigma(pTimes, PositiveConstraint());
+    ptdSigma.setParam(0, sigma); ptdSigma.setParam(1, 0.3);
+    PiecewiseConstantParameter ptdRho(
+        pTimes, BoundaryConstraint(-1.0, 1.0));
+    ptdRho.setParam(0, rho); ptdRho.setParam(1, -0.3);
+
+    std::vector<Time> modelTimes(1, 0.5);
+    modelTimes.push_back(3.0);
+
+    const ext::shared_ptr<PiecewiseTimeDependentHestonModel> ptdModel =
+        ext::make_shared<PiecewiseTimeDependentHestonModel>(
+            riskFreeTS, dividendTS, s0, v0, ptdTheta, ptdKappa,
+            ptdSigma, ptdRho, TimeGrid(modelTimes.begin(), modelTimes.end()));
+
+    const ext::shared_ptr<AnalyticHestonEngine> hestonEngines[] = {
+        ext::make_shared<AnalyticHestonEngine>(hestonModel, 164),
+        ext::make_shared<AnalyticHestonEngine>(
+            hestonModel, AnalyticHestonEngine::AndersenPiterbarg,
+            AnalyticHestonEngine::Integration::gaussLaguerre(164)),
+        ext::make_shared<BatesEngine>(batesModel, 164),
+        ext::make_shared<AnalyticHestonEngine>(
+            hestonModel, AnalyticHestonEngine::AndersenPiterbargOptCV,
+            AnalyticHestonEngine::Integration::gaussLaguerre(164)),
+        ext::make_shared<AnalyticHestonEngine>(
+            hestonModel, AnalyticHestonEngine::BranchCorrection,
+            AnalyticHestonEngine::Integration::gaussLaguerre(164))
+    };
+    const ext::shared_ptr<CalibratedModel> hestonModels[] = {
+        hestonModel, hestonModel, batesModel, hestonModel, hestonModel
+    };
+
+    const ext::shared_ptr<AnalyticPTDHestonEngine> ptdEngine =
+        ext::make_shared<AnalyticPTDHestonEngine>(
+            ptdModel, AnalyticPTDHestonEngine::Gatheral,
+            AnalyticPTDHestonEngine::Integration::gaussLaguerre(164));
+
+    const Date maturities[] = {
+        settlementDate + Period(3, Months),
+        settlementDate + Period(1, Years),
+        settlementDate + Period(2, Years)
+    };
+    const Real strikes[] = { 70.0, 95.0, 100.0, 120.0 };
+    const Option::Type types[] = { Option::Put, Option::Call };
+
+    const Real tol = 1e-6;
+
+    for (Size e=0; e < LENGTH(hestonEngines)+1; ++e) {
+        const ext::shared_ptr<CalibratedModel> model =
+            (e < LENGTH(hestonEngines)) ? hestonModels[e]
+                : ext::shared_ptr<CalibratedModel>(ptdModel);
+        const Array params = model->params();
+
+        for (Size i=0; i < LENGTH(maturities); ++i) {
+            for (Size j=0; j < LENGTH(strikes); ++j) {
+                for (Size k=0; k < LENGTH(types); ++k) {
+                    Array gradient, tmp;
+                    const Real value = (e < LENGTH(hestonEngines))
+                        ? hestonEngines[e]->valueAndGradient(
+                            gradient, maturities[i], types[k], strikes[j])
+                        : ptdEngine->valueAndGradient(
+                            gradient, maturities[i], types[k], strikes[j]);
+
+                    VanillaOption option(
+                        ext::make_shared<PlainVanillaPayoff>(
+                            types[k], strikes[j]),
+                        ext::make_shared<EuropeanExercise>(maturities[i]));
+                    option.setPricingEngine(
+                        (e < LENGTH(hestonEngines))
+                            ? ext::shared_ptr<PricingEngine>(hestonEngines[e])
+                            : ext::shared_ptr<PricingEngine>(ptdEngine));
+
+                    const Real npv = option.NPV();
+                    if (std::fabs(value - npv) > tol) {
+                        BOOST_ERROR("failed to reproduce option value"
+                                   << "\n    engine:     " << e
+                                   << "\n    strike:     " << strikes[j]
+                                   << "\n    maturity:   " << maturities[i]
+                                   << "\n    calculated: " << value
+                                   << "\n    expected:   " << npv);
+                    }
+
+                    for (Size l=0; l < params.size(); ++l) {
+                        const Real h = 1e-5;
+                        Array p = params;
+
+                        p[l] = params[l] + h;
+                        model->setParams(p);
+                        const Real up = option.NPV();
+
+                        p[l] = params[l] - h;
+                        model->setParams(p);
+                        const Real down = option.NPV();
+
+                        model->setParams(params);
+
+                        const Real expected = (up - down)/(2*h);
+                        if (std::fabs(gradient[l] - expected) > tol) {
+                            BOOST_ERROR("failed to reproduce option gradient"
+                                       << "\n    engine:     " << e
+                                       << "\n    parameter:  " << l
+                                       << "\n    strike:     " << strikes[j]
+                                       << "\n    maturity:   " << maturities[i]
+                                       << "\n    calculated: " << gradient[l]
+                                       << "\n    expected:   " << expected);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // the gradient is not available, and calibrations fall back to
+    // finite differences, if the integration nodes depend on the model
+    // parameters, if sigma is too small, for the asymptotic control
+    // variate or if the engine adds terms to the characteristic
+    // function without their derivatives
+    BOOST_CHECK(hestonEngines[0]->supportsValueGradient());
+    BOOST_CHECK(hestonEngines[2]->supportsValueGradient());
+    BOOST_CHECK(ptdEngine->supportsValueGradient());
+    BOOST_CHECK(!AnalyticHestonEngine(
+        hestonModel, AnalyticHestonEngine::AndersenPiterbarg,
+        AnalyticHestonEngine::Integration::gaussLegendre(256))
+                .supportsValueGradient());
+    BOOST_CHECK(!AnalyticHestonEngine(hestonModel, 1e-8, 10000)
+                .supportsValueGradient());
+    BOOST_CHECK(!AnalyticHestonEngine(
+        hestonModel, AnalyticHestonEngine::AsymptoticChF,
+        AnalyticHestonEngine::Integration::gaussLaguerre(164))
+                .supportsValueGradient());
+    BOOST_CHECK(!AnalyticHestonEngine(
+        hestonModel, AnalyticHestonEngine::OptimalCV,
+        AnalyticHestonEngine::Integration::gaussLaguerre(164))
+                .supportsValueGradient());
+    BOOST_CHECK(!BatesDoubleExpEngine(
+        ext::make_shared<BatesDoubleExpModel>(
+            ext::make_shared<HestonProcess>(
+                riskFreeTS, dividendTS, s0, v0, kappa, theta, sigma, rho)),
+        164).supportsValueGradient());
+    BOOST_CHECK(!BatesDetJumpEngine(
+        ext::make_shared<BatesDetJumpModel>(
+            ext::make_shared<BatesProcess>(
+                riskFreeTS, dividendTS, s0, v0, kappa, theta, sigma, rho,
+                0.3, -0.1, 0.15)), 164).supportsValueGradient());
+    BOOST_CHECK(!AnalyticHestonHullWhiteEngine(
+        hestonModel, ext::make_shared<HullWhite>(riskFreeTS, 0.1, 0.01),
+        164).supportsValueGradient());
+
+    const ext::shared_ptr<HestonModel> lowSigmaModel =
+        ext::make_shared<HestonModel>(
+            ext::make_shared<HestonProcess>(
+                riskFreeTS, dividendTS, s0, v0, kappa, theta, 1e-5, rho));
+    BOOST_CHECK(!AnalyticHestonEngine(lowSigmaModel, 164)
+                .supportsValueGradient());
+
+    BOOST_TEST_MESSAGE(
+        "Testing Heston model calibration using analytic Jacobians...");
+
+    Settings::instance().evaluationDate() = Date(5, July, 2002);
+
+    CalibrationMarketData marketData = getDAXCalibrationMarketData();
+    const std::vector<ext::shared_ptr<CalibrationHelper> >& options
+        = marketData.options;
+
+    const ext::shared_ptr<HestonModel> daxModel =
+        ext::make_shared<HestonModel>(
+            ext::make_shared<HestonProcess>(
+                marketData.riskFreeTS, marketData.dividendYield,
+                marketData.s0, 0.1, 1.0, 0.1, 0.5, -0.5));
+
+    const ext::shared_ptr<PricingEngine> engine
+        = ext::make_shared<AnalyticHestonEngine>(daxModel, 64);
+    for (Size i = 0; i < options.size(); ++i) {
+        ext::dynamic_pointer_cast<BlackCalibrationHelper>(options[i])
+            ->setPricingEngine(engine);
+        BOOST_CHECK(options[i]->hasCalibrationErrorGradient());
+    }
+
+    LevenbergMarquardt om(1e-8, 1e-8, 1e-8, true);
+    daxModel->calibrate(options, om,
+                        EndCriteria(400, 40, 1.0e-8, 1.0e-8, 1.0e-8));
+
+    Real sse = 0;
+    for (Size i = 0; i < 13*8; ++i) {
+        const Real diff = options[i]->calibrationError()*100.0;
+        sse += diff*diff;
+    }
+    const Real expected = 177.2;
+    if (std::fabs(sse - expected) > 1.0) {
+        BOOST_ERROR("Failed to reproduce calibration error"
+                   << "\n    calculated: " << sse
+                   << "\n    expected:   " << expected);
+    }
+}
+
+
 test_suite* HestonModelTest::suite(SpeedLevel speed) {
     auto* suite = BOOST_TEST_SUITE("Heston model tests");
 
@@ -3314,6 +3655,8 @@ test_suite* HestonModelTest::suite(SpeedLevel speed) {
         &HestonModelTest::testOptimalControlVariateChoice));
     suite->add(QUANTLIB_TEST_CASE(
         &HestonModelTest::testAsymptoticControlVariate));
+    suite->add(QUANTLIB_TEST_CASE(&HestonModelTest::testBatchPricing));
+    suite->add(QUANTLIB_TEST_CASE(&HestonModelTest::testAnalyticGradient));
 
 
     if (speed <= Fast) {
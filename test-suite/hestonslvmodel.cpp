@@ -2105,6 +2105,94 @@ void HestonSLVModelTest::testMonteCarloCalibration() {
 }
 
 
+namespace {
+    class ProgressCounter {
+      public:
+        explicit ProgressCounter(Size* counter) : counter_(counter) {}
+        void operator()(Time, Time) const { ++(*counter_); }
+      private:
+        Size* counter_;
+    };
+}
+
+void HestonSLVModelTest::testMonteCarloCalibrationWithBoundedMemory() {
+    BOOST_TEST_MESSAGE(
+        "Testing Monte-Carlo calibration with bounded path storage...");
+
+    SavedSettings backup;
+
+    const DayCounter dc = ActualActual();
+    const Date todaysDate(5, Jan, 2016);
+    const Date maturityDate = todaysDate + Period(6, Months);
+    Settings::instance().evaluationDate() = todaysDate;
+
+    const Handle<Quote> spot(ext::make_shared<SimpleQuote>(100.0));
+    const Handle<YieldTermStructure> rTS(flatRate(0.05, dc));
+    const Handle<YieldTermStructure> qTS(flatRate(0.02, dc));
+
+    const Handle<LocalVolTermStructure> localVol(
+        ext::make_shared<LocalConstantVol>(todaysDate, 0.3, dc));
+
+    const Handle<HestonModel> hestonModel(
+        ext::make_shared<HestonModel>(
+            ext::make_shared<HestonProcess>(
+                rTS, qTS, spot, 0.09, 1.0, 0.06, 0.4, -0.75)));
+
+    const Size timeStepsPerYear = 24, nBins = 51, nSim = 8192;
+
+    const ext::shared_ptr<BrownianGeneratorFactory> factories[] = {
+        ext::make_shared<SobolBrownianGeneratorFactory>(
+            SobolBrownianGenerator::Diagonal, 1234UL, SobolRsg::JoeKuoD7),
+        ext::make_shared<MTBrownianGeneratorFactory>(1234UL)
+    };
+
+    for (Size i=0; i < LENGTH(factories); ++i) {
+        HestonSLVMCModel fullModel(
+            localVol, hestonModel, factories[i], maturityDate,
+            timeStepsPerYear, nBins, nSim);
+        HestonSLVMCModel boundedModel(
+            localVol, hestonModel, factories[i], maturityDate,
+            timeStepsPerYear, nBins, nSim, std::vector<Date>(), 1.0, 5);
+
+        Size progressCalls = 0;
+        boundedModel.setProgressCallback(ProgressCounter(&progressCalls));
+
+        const ext::shared_ptr<LocalVolTermStructure> expected
+            = fullModel.leverageFunction();
+        const ext::shared_ptr<LocalVolTermStructure> calculated
+            = boundedModel.leverageFunction();
+
+        const Time maturity = dc.yearFraction(todaysDate, maturityDate);
+        for (Real t=0.05; t < maturity; t+=0.1) {
+            for (Real strike=80.0; strike < 125.0; strike+=5.0) {
+                const Real l1 = expected->localVol(t, strike, true);
+                const Real l2 = calculated->localVol(t, strike, true);
+                if (std::fabs(l1 - l2) > 1e-12)
+                    BOOST_ERROR("failed to reproduce leverage function "
+                                "with bounded path storage"
+                                << std::setprecision(12)
+                                << "\n time       : " << t
+                                << "\n strike     : " << strike
+                                << "\n calculated : " << l2
+                                << "\n expected   : " << l1);
+            }
+        }
+
+        const std::vector<std::pair<Time, Real> >& timings
+            = boundedModel.calibrationTimings();
+        if (timings.empty() || progressCalls != timings.size()
+            || !close_enough(timings.back().first, maturity))
+            BOOST_ERROR("unexpected calibration instrumentation"
+                        << "\n time steps     : " << timings.size()
+                        << "\n progress calls : " << progressCalls);
+        for (Size j=1; j < timings.size(); ++j) {
+            if (timings[j].first <= timings[j-1].first
+                || timings[j].second < timings[j-1].second)
+                BOOST_ERROR("calibration timings are not increasing");
+        }
+    }
+}
+
 void HestonSLVModelTest::testForwardSkewSLV() {
     BOOST_TEST_MESSAGE("Testing the implied volatility skew of "
         "forward starting options in SLV model...");
@@ -2630,6 +2718,8 @@ test_suite* HestonSLVModelTest::experimental(SpeedLevel speed) {
         &HestonSLVModelTest::testLocalVolsvSLVPropDensity));
     suite->add(QUANTLIB_TEST_CASE(
         &HestonSLVModelTest::testDiffusionAndDriftSlvProcess));
+    suite->add(QUANTLIB_TEST_CASE(
+        &HestonSLVModelTest::testMonteCarloCalibrationWithBoundedMemory));
 
     if (speed <= Fast) {
         suite->add(QUANTLIB_TEST_CASE(
@@ -44,6 +44,7 @@ public:
     static void testBarrierPricingMixedModels();
     static void testMonteCarloVsFdmPricing();
     static void testMonteCarloCalibration();
+    static void testMonteCarloCalibrationWithBoundedMemory();
     static void testMoustacheGraph();
     static void testForwardSkewSLV();
     static void testDiffusionAndDriftSlvProcess();
@@ -20,15 +20,85 @@
 #include "instruments.hpp"
 #include "utilities.hpp"
 #include <ql/instruments/stock.hpp>
+#include <ql/cashflows/couponpricer.hpp>
+#include <ql/currencies/europe.hpp>
 #include <ql/instruments/compositeinstrument.hpp>
 #include <ql/instruments/europeanoption.hpp>
+#include <ql/instruments/makevanillaswap.hpp>
+#include <ql/experimental/risk/portfoliopricer.hpp>
+#include <ql/experimental/risk/sensitivityengine.hpp>
+#include <ql/indexes/ibor/euribor.hpp>
+#include <ql/pricingengines/swap/discountingswapengine.hpp>
 #include <ql/pricingengines/vanilla/analyticeuropeanengine.hpp>
+#include <ql/pricingengines/vanilla/binomialengine.hpp>
 #include <ql/quotes/simplequote.hpp>
+#include <ql/termstructures/yield/piecewiseyieldcurve.hpp>
+#include <ql/termstructures/yield/ratehelpers.hpp>
+#include <ql/time/calendars/target.hpp>
 #include <ql/time/daycounters/actual360.hpp>
+#include <algorithm>
+#include <iomanip>
 
 using namespace QuantLib;
 using namespace boost::unit_test_framework;
 
+namespace instruments_test {
+
+    // an independent copy of a small book: deposit-bootstrapped curve,
+    // swaps on it and options on a spot quote discounted on it
+    SensitivityEngine::Book makeBook(const Date& today) {
+        DayCounter dc = Actual360();
+        SensitivityEngine::Book book;
+
+        std::vector<ext::shared_ptr<RateHelper> > helpers;
+        Integer months[] = { 3, 6, 12, 24, 60 };
+        for (Size i=0; i<LENGTH(months); ++i) {
+            ext::shared_ptr<SimpleQuote> quote(
+                                         new SimpleQuote(0.01 + 0.002*i));
+            book.quotes.push_back(Handle<SimpleQuote>(quote));
+            ext::shared_ptr<IborIndex> index(
+                new IborIndex("dummy", months[i]*Months, 2, EURCurrency(),
+                              TARGET(), ModifiedFollowing, false, dc));
+            helpers.push_back(ext::shared_ptr<RateHelper>(
+                new DepositRateHelper(Handle<Quote>(quote), index)));
+        }
+        Handle<YieldTermStructure> curve(
+            ext::shared_ptr<YieldTermStructure>(
+                new PiecewiseYieldCurve<Discount,LogLinear>(2, TARGET(),
+                                                            helpers, dc)));
+
+        ext::shared_ptr<IborIndex> euribor(new Euribor6M(curve));
+        ext::shared_ptr<PricingEngine> swapEngine(
+                                        new DiscountingSwapEngine(curve));
+        for (Size i=0; i<3; ++i) {
+            ext::shared_ptr<VanillaSwap> swap =
+                MakeVanillaSwap((i+1)*Years, euribor, 0.012);
+            swap->setPricingEngine(swapEngine);
+            book.instruments.push_back(swap);
+        }
+
+        ext::shared_ptr<SimpleQuote> spot(new SimpleQuote(100.0));
+        book.quotes.push_back(Handle<SimpleQuote>(spot));
+        ext::shared_ptr<BlackScholesProcess> process(
+            new BlackScholesProcess(Handle<Quote>(spot), curve,
+                                    Handle<BlackVolTermStructure>(
+                                                flatVol(today, 0.2, dc))));
+        ext::shared_ptr<PricingEngine> optionEngine(
+                                         new AnalyticEuropeanEngine(process));
+        for (Size i=0; i<2; ++i) {
+            ext::shared_ptr<Instrument> option(
+                new EuropeanOption(
+                    ext::make_shared<PlainVanillaPayoff>(Option::Call,
+                                                         95.0 + 10.0*i),
+                    ext::make_shared<EuropeanExercise>(today + 1*Years)));
+            option->setPricingEngine(optionEngine);
+            book.instruments.push_back(option);
+        }
+        return book;
+    }
+
+}
+
 void InstrumentTest::testObservable() {
 
     BOOST_TEST_MESSAGE("Testing observability of instruments...");
@@ -113,11 +183,267 @@ void InstrumentTest::testCompositeWhenShiftingDates() {
         BOOST_FAIL("Composite didn't recalculate");
 }
 
+void InstrumentTest::testPortfolioPricer() {
+
+    BOOST_TEST_MESSAGE("Testing parallel pricing of a portfolio...");
+
+    SavedSettings backup;
+
+    Date today(15, March, 2021);
+    Settings::instance().evaluationDate() = today;
+    DayCounter dc = Actual360();
+
+    // a bootstrapped curve shared by all swaps
+    RelinkableHandle<YieldTermStructure> forwarding;
+    ext::shared_ptr<IborIndex> euribor(new Euribor6M(forwarding));
+    std::vector<ext::shared_ptr<RateHelper> > helpers;
+    Integer months[] = { 1, 3, 6, 12, 24, 60, 120 };
+    for (Size i=0; i<LENGTH(months); ++i) {
+        ext::shared_ptr<IborIndex> index(
+            new IborIndex("dummy", months[i]*Months, 2, EURCurrency(),
+                          TARGET(), ModifiedFollowing, false, dc));
+        helpers.push_back(ext::shared_ptr<RateHelper>(
+            new DepositRateHelper(0.01 + 0.001*i, index)));
+    }
+    ext::shared_ptr<YieldTermStructure> curve(
+        new PiecewiseYieldCurve<Discount,LogLinear>(2, TARGET(),
+                                                    helpers, dc));
+    forwarding.linkTo(curve);
+
+    ext::shared_ptr<PricingEngine> swapEngine(
+        new DiscountingSwapEngine(forwarding));
+
+    ext::shared_ptr<SimpleQuote> spot(new SimpleQuote(100.0));
+    ext::shared_ptr<BlackScholesProcess> process(
+        new BlackScholesProcess(Handle<Quote>(spot),
+                                Handle<YieldTermStructure>(curve),
+                                Handle<BlackVolTermStructure>(
+                                               flatVol(today, 0.2, dc))));
+    ext::shared_ptr<PricingEngine> optionEngines[] = {
+        ext::shared_ptr<PricingEngine>(new AnalyticEuropeanEngine(process)),
+        ext::shared_ptr<PricingEngine>(new AnalyticEuropeanEngine(process))
+    };
+
+    PortfolioPricer pricer;
+    std::vector<Real> expected;
+    for (Size i=0; i<10; ++i) {
+        ext::shared_ptr<VanillaSwap> swap =
+            MakeVanillaSwap((i+1)*Years, euribor, 0.01 + 0.0005*i);
+        swap->setPricingEngine(swapEngine);
+        expected.push_back(swap->NPV());
+        pricer.add(swap, swapEngine, true);
+    }
+    // swaps priced by three clones of an engine
+    std::vector<ext::shared_ptr<Instrument> > clonedSwaps;
+    for (Size i=0; i<10; ++i) {
+        ext::shared_ptr<VanillaSwap> swap =
+            MakeVanillaSwap((i+1)*Years, euribor, 0.012 - 0.0005*i);
+        swap->setPricingEngine(swapEngine);
+        expected.push_back(swap->NPV());
+        clonedSwaps.push_back(swap);
+    }
+    pricer.add(clonedSwaps,
+               [&forwarding]() {
+                   return ext::shared_ptr<PricingEngine>(
+                                  new DiscountingSwapEngine(forwarding));
+               },
+               3);
+    ext::shared_ptr<VanillaSwap> reusedEngineSwap =
+        MakeVanillaSwap(1*Years, euribor, 0.01);
+    BOOST_CHECK_THROW(
+        pricer.add(std::vector<ext::shared_ptr<Instrument> >(
+                       1, reusedEngineSwap),
+                   [&swapEngine]() { return swapEngine; }),
+        Error);
+    // swaps sharing a coupon pricer, priced by different engines
+    ext::shared_ptr<FloatingRateCouponPricer> couponPricer(
+        new BlackIborCouponPricer);
+    for (Size i=0; i<2; ++i) {
+        ext::shared_ptr<VanillaSwap> swap =
+            MakeVanillaSwap((i+2)*Years, euribor, 0.01);
+        setCouponPricer(swap->floatingLeg(), couponPricer);
+        ext::shared_ptr<PricingEngine> engine(
+            new DiscountingSwapEngine(forwarding));
+        swap->setPricingEngine(engine);
+        expected.push_back(swap->NPV());
+        pricer.add(swap, engine, true);
+    }
+    for (Size i=0; i<10; ++i) {
+        ext::shared_ptr<Instrument> option(
+            new EuropeanOption(
+                ext::make_shared<PlainVanillaPayoff>(
+                    i % 2 == 0 ? Option::Call : Option::Put, 80.0 + 4.0*i),
+                ext::make_shared<EuropeanExercise>(today + (i+1)*Months)));
+        option->setPricingEngine(optionEngines[i % 2]);
+        expected.push_back(option->NPV());
+        pricer.add(option, optionEngines[i % 2], true);
+    }
+    // instruments whose engine is not thread-safe; the binomial engine
+    // builds a process observing the market data at each calculation
+    ext::shared_ptr<PricingEngine> binomialEngine(
+        new BinomialVanillaEngine<CoxRossRubinstein>(process, 50));
+    for (Size i=0; i<3; ++i) {
+        ext::shared_ptr<Instrument> option(
+            new VanillaOption(
+                ext::make_shared<PlainVanillaPayoff>(Option::Put,
+                                                     90.0 + 10.0*i),
+                ext::make_shared<AmericanExercise>(today,
+                                                   today + 6*Months)));
+        option->setPricingEngine(binomialEngine);
+        expected.push_back(option->NPV());
+        pricer.add(option, binomialEngine);
+    }
+    BOOST_CHECK_THROW(
+        pricer.add(ext::make_shared<EuropeanOption>(
+                       ext::make_shared<PlainVanillaPayoff>(Option::Call,
+                                                            100.0),
+                       ext::make_shared<EuropeanExercise>(today + 1*Years)),
+                   binomialEngine, true),
+        Error);
+    // an instrument whose pricing fails
+    ext::shared_ptr<VanillaSwap> unpriceable =
+        MakeVanillaSwap(5*Years, euribor, 0.01);
+    ext::shared_ptr<PricingEngine> emptyEngine(
+        new DiscountingSwapEngine(Handle<YieldTermStructure>()));
+    pricer.add(unpriceable, emptyEngine);
+
+    BOOST_CHECK_THROW(pricer.add(unpriceable, emptyEngine), Error);
+
+    std::vector<ext::shared_ptr<LazyObject> > shared =
+        pricer.sharedObjects();
+    if (std::find(shared.begin(), shared.end(),
+                  ext::dynamic_pointer_cast<LazyObject>(curve))
+        == shared.end())
+        BOOST_FAIL("bootstrapped curve not found among shared objects");
+
+    PortfolioResults results = pricer.price(true);
+
+    if (!ObservableSettings::instance().updatesEnabled())
+        BOOST_FAIL("updates not enabled after pricing the portfolio");
+
+    for (Size i=0; i<expected.size(); ++i) {
+        if (results.valid[i] == 0)
+            BOOST_FAIL("instrument #" << i << " not priced: "
+                       << results.error[i]);
+        if (std::fabs(results.npv[i] - expected[i]) > 1.0e-12)
+            BOOST_ERROR("failed to reproduce serial NPV"
+                        << "\n    instrument: " << i
+                        << std::setprecision(12)
+                        << "\n    serial:     " << expected[i]
+                        << "\n    portfolio:  " << results.npv[i]);
+    }
+    Size last = expected.size();
+    if (results.valid[last] != 0 || results.error[last].empty())
+        BOOST_ERROR("failure of unpriceable instrument not reported");
+}
+
+
+void InstrumentTest::testSensitivityEngine() {
+
+    BOOST_TEST_MESSAGE("Testing bucketed sensitivities on copies of a book...");
+
+    using namespace instruments_test;
+
+    SavedSettings backup;
+
+    Date today(15, March, 2021);
+    Settings::instance().evaluationDate() = today;
+
+    std::vector<SensitivityEngine::Book> books;
+    for (Size b=0; b<3; ++b)
+        books.push_back(makeBook(today));
+    const SensitivityEngine::Book& book = books.front();
+    const Size nQuotes = book.quotes.size();
+    const Size nInstruments = book.instruments.size();
+    const Size spot = nQuotes-1;
+    Real shift = 1.0e-3;
+
+    SensitivityEngine engine(books, shift, Centered);
+    SensitivityResults results = engine.calculate(true);
+
+    // the spot quote only affects the options
+    for (Size k=0; k<3; ++k) {
+        if (engine.dependencies()[spot][k] != 0)
+            BOOST_FAIL("swap #" << k << " found to depend on spot");
+        if (results.delta[spot][k] != 0.0)
+            BOOST_ERROR("non-zero spot delta for swap #" << k);
+    }
+
+    // bumped curves are bootstrapped again starting from the previous
+    // solution, so results from different copies agree to within the
+    // bootstrap accuracy
+    Real deltaTolerance = 1.0e-8, gammaTolerance = 1.0e-5;
+    for (Size i=0; i<nQuotes; ++i) {
+        for (Size k=0; k<nInstruments; ++k) {
+            std::vector<ext::shared_ptr<Instrument> > instrument(
+                                                 1, book.instruments[k]);
+            std::pair<Real, Real> expected =
+                bucketAnalysis(book.quotes[i], instrument,
+                               std::vector<Real>(), shift, Centered);
+            if (std::fabs(results.delta[i][k] - expected.first)
+                > deltaTolerance
+                || std::fabs(results.gamma[i][k] - expected.second)
+                   > gammaTolerance)
+                BOOST_ERROR("failed to reproduce bucket analysis"
+                            << "\n    quote:      " << i
+                            << "\n    instrument: " << k
+                            << std::setprecision(12)
+                            << "\n    delta:      " << results.delta[i][k]
+                            << "\n    expected:   " << expected.first
+                            << "\n    gamma:      " << results.gamma[i][k]
+                            << "\n    expected:   " << expected.second);
+        }
+    }
+
+    // cross gamma between spot and the one-year deposit for a call
+    Size k = 3, i = 2;
+    Real npv[2][2];
+    Real spotValue = book.quotes[spot]->value(),
+         rateValue = book.quotes[i]->value();
+    for (Size a=0; a<2; ++a) {
+        for (Size b=0; b<2; ++b) {
+            book.quotes[i]->setValue(rateValue + (a == 0 ? shift : -shift));
+            book.quotes[spot]->setValue(spotValue + (b == 0 ? shift : -shift));
+            npv[a][b] = book.instruments[k]->NPV();
+        }
+    }
+    book.quotes[i]->setValue(rateValue);
+    book.quotes[spot]->setValue(spotValue);
+    Real expected = (npv[0][0] - npv[0][1] - npv[1][0] + npv[1][1])
+                  / (4.0*shift*shift);
+    if (std::fabs(results.crossGamma[k][i][spot] - expected) > gammaTolerance
+        || results.crossGamma[k][spot][i] != results.crossGamma[k][i][spot])
+        BOOST_ERROR("failed to reproduce cross gamma"
+                    << std::setprecision(12)
+                    << "\n    calculated: " << results.crossGamma[k][i][spot]
+                    << "\n    expected:   " << expected);
+    for (Size s=0; s<3; ++s) {
+        if (results.crossGamma[s][i][spot] != 0.0)
+            BOOST_ERROR("non-zero spot cross gamma for swap #" << s);
+    }
+
+    // the quotes are restored
+    for (Size b=0; b<books.size(); ++b) {
+        for (Size q=0; q<nQuotes; ++q) {
+            Real expectedValue = q == spot ? 100.0 : 0.01 + 0.002*q;
+            if (books[b].quotes[q]->value() != expectedValue)
+                BOOST_ERROR("quote #" << q << " of book #" << b
+                            << " not restored");
+        }
+    }
+
+    BOOST_CHECK_THROW(SensitivityEngine(books, shift, OneSide).calculate(true),
+                      Error);
+}
+
+
 test_suite* InstrumentTest::suite() {
     auto* suite = BOOST_TEST_SUITE("Instrument tests");
     suite->add(QUANTLIB_TEST_CASE(&InstrumentTest::testObservable));
     suite->add(QUANTLIB_TEST_CASE(
                             &InstrumentTest::testCompositeWhenShiftingDates));
+    suite->add(QUANTLIB_TEST_CASE(&InstrumentTest::testPortfolioPricer));
+    suite->add(QUANTLIB_TEST_CASE(&InstrumentTest::testSensitivityEngine));
     return suite;
 }
 
@@ -30,6 +30,8 @@ class InstrumentTest {
   public:
     static void testObservable();
     static void testCompositeWhenShiftingDates();
+    static void testPortfolioPricer();
+    static void testSensitivityEngine();
     static boost::unit_test_framework::test_suite* suite();
 };
 
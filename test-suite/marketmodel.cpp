@@ -35,6 +35,7 @@ FOR A PARTICULAR PURPOSE.  See the license for more details.
 #include <ql/models/marketmodels/callability/swapratetrigger.hpp>
 #include <ql/models/marketmodels/callability/triggeredswapexercise.hpp>
 #include <ql/models/marketmodels/callability/upperboundengine.hpp>
+#include <ql/models/marketmodels/callability/parallelupperboundengine.hpp>
 #include <ql/models/marketmodels/curvestates/lmmcurvestate.hpp>
 #include <ql/models/marketmodels/driftcomputation/lmmdriftcalculator.hpp>
 #include <ql/models/marketmodels/evolvers/lognormalfwdrateeuler.hpp>
@@ -42,6 +43,7 @@ FOR A PARTICULAR PURPOSE.  See the license for more details.
 #include <ql/models/marketmodels/evolvers/lognormalfwdrateipc.hpp>
 #include <ql/models/marketmodels/evolvers/lognormalfwdrateballand.hpp>
 #include <ql/models/marketmodels/evolvers/lognormalfwdratepc.hpp>
+#include <ql/models/marketmodels/evolvers/lognormalfwdratepcbatch.hpp>
 #include <ql/models/marketmodels/evolvers/normalfwdratepc.hpp>
 #include <ql/models/marketmodels/discounter.hpp>
 #include <ql/models/marketmodels/models/abcdvol.hpp>
@@ -90,6 +92,7 @@ FOR A PARTICULAR PURPOSE.  See the license for more details.
 #include <ql/models/marketmodels/products/pathwise/pathwiseproductswaption.hpp>
 
 #include <ql/models/marketmodels/pathwiseaccountingengine.hpp>
+#include <ql/models/marketmodels/parallelaccountingengine.hpp>
 #include <ql/models/marketmodels/pathwisegreeks/ratepseudorootjacobian.hpp>
 #include <ql/models/marketmodels/pathwisegreeks/swaptionpseudojacobian.hpp>
 
@@ -4342,6 +4345,424 @@ void MarketModelTest::testPathwiseMarketVegas()
 
 }
 
+void MarketModelTest::testPathwiseVegasAdjoint() {
+
+    BOOST_TEST_MESSAGE("Testing adjoint pathwise vegas against "
+                       "the outer pathwise vegas engine...");
+
+    using namespace market_model_test;
+
+    setup();
+
+    MarketModelPathwiseMultiCaplet caplets(rateTimes, accruals,
+                                           paymentTimes, todaysForwards);
+    std::vector<std::pair<Size,Size> > startsAndEnds;
+    for (Size i=0; i+2<todaysForwards.size(); i+=3)
+        startsAndEnds.push_back(std::make_pair(i+2, i+3));
+    MarketModelPathwiseMultiDeflatedCap caps(rateTimes, accruals,
+                                             paymentTimes,
+                                             todaysForwards[0],
+                                             startsAndEnds);
+    std::vector<Clone<MarketModelPathwiseMultiProduct> > products;
+    products.push_back(caplets);
+    products.push_back(caps);
+    std::string productNames[] = { "caplets", "deflated caps" };
+
+    const EvolutionDescription& evolution = caplets.evolution();
+    std::vector<Size> numeraires = moneyMarketMeasure(evolution);
+
+    Size factors[] = { 3, todaysForwards.size() };
+    Size paths = 500;
+    Real tolerance = 1.0e-10;
+
+    for (Size f=0; f<LENGTH(factors); ++f) {
+        ext::shared_ptr<MarketModel> marketModel =
+            makeMarketModel(true, evolution, factors[f],
+                            ExponentialCorrelationAbcdVolatility);
+        Real initialNumeraireValue = todaysDiscounts[numeraires.front()];
+
+        // scale the pseudo-root of each step, or bump it uniformly
+        std::vector<std::vector<Matrix> > vegaBumps(
+                                                 marketModel->numberOfSteps());
+        for (Size t=0; t<vegaBumps.size(); ++t) {
+            vegaBumps[t].push_back(marketModel->pseudoRoot(t));
+            vegaBumps[t].push_back(Matrix(marketModel->numberOfRates(),
+                                          factors[f], 0.01));
+        }
+
+        for (Size p=0; p<products.size(); ++p) {
+            for (Size elementary=0; elementary<2; ++elementary) {
+                MTBrownianGeneratorFactory generatorFactory(seed_);
+                PathwiseVegasOuterAccountingEngine outerEngine(
+                    ext::make_shared<LogNormalFwdRateEuler>(
+                            marketModel, generatorFactory, numeraires),
+                    products[p], marketModel, vegaBumps,
+                    initialNumeraireValue);
+                PathwiseVegasAdjointAccountingEngine adjointEngine(
+                    ext::make_shared<LogNormalFwdRateEuler>(
+                            marketModel, generatorFactory, numeraires),
+                    products[p], marketModel, vegaBumps,
+                    initialNumeraireValue);
+
+                std::vector<Real> values, errors, adjointValues,
+                                  adjointErrors;
+                if (elementary != 0) {
+                    outerEngine.multiplePathValuesElementary(values, errors,
+                                                             paths);
+                    adjointEngine.multiplePathValuesElementary(
+                                          adjointValues, adjointErrors, paths);
+                } else {
+                    outerEngine.multiplePathValues(values, errors, paths);
+                    adjointEngine.multiplePathValues(adjointValues,
+                                                     adjointErrors, paths);
+                }
+
+                if (values.size() != adjointValues.size())
+                    BOOST_FAIL("size mismatch"
+                               << "\n    outer:   " << values.size()
+                               << "\n    adjoint: " << adjointValues.size());
+
+                for (Size i=0; i<values.size(); ++i) {
+                    if (std::fabs(values[i]-adjointValues[i]) > tolerance)
+                        BOOST_FAIL("adjoint and outer pathwise vegas differ"
+                                   << "\n    product:    " << productNames[p]
+                                   << "\n    factors:    " << factors[f]
+                                   << "\n    elementary: "
+                                   << (elementary != 0 ? "yes" : "no")
+                                   << "\n    entry:      " << i
+                                   << std::setprecision(15)
+                                   << "\n    outer:      " << values[i]
+                                   << "\n    adjoint:    "
+                                   << adjointValues[i]);
+                }
+            }
+        }
+    }
+}
+
+void MarketModelTest::testParallelAccountingEngines() {
+
+    BOOST_TEST_MESSAGE("Testing parallel accounting engines "
+                       "against sequential ones...");
+
+    using namespace market_model_test;
+
+    setup();
+
+    std::vector<Rate> forwardStrikes(todaysForwards.size());
+    std::vector<ext::shared_ptr<Payoff> > optionletPayoffs(todaysForwards.size());
+    for (Size i=0; i<todaysForwards.size(); ++i) {
+        forwardStrikes[i] = todaysForwards[i] + 0.01;
+        optionletPayoffs[i] = ext::shared_ptr<Payoff>(new
+            PlainVanillaPayoff(Option::Call, todaysForwards[i]));
+    }
+
+    MultiStepForwards forwards(rateTimes, accruals,
+        paymentTimes, forwardStrikes);
+    MultiStepOptionlets optionlets(rateTimes, accruals,
+        paymentTimes, optionletPayoffs);
+    MultiProductComposite product;
+    product.add(forwards);
+    product.add(optionlets);
+    product.finalize();
+
+    MarketModelPathwiseMultiCaplet pathwiseProduct(rateTimes, accruals,
+        paymentTimes, todaysForwards);
+
+    std::vector<ext::shared_ptr<BrownianGeneratorFactory> > factories;
+    factories.push_back(ext::shared_ptr<BrownianGeneratorFactory>(
+        new MTBrownianGeneratorFactory(seed_)));
+    factories.push_back(ext::shared_ptr<BrownianGeneratorFactory>(
+        new SobolBrownianGeneratorFactory(SobolBrownianGenerator::Diagonal,
+                                          seed_)));
+    std::string factoryNames[] = { "MT", "Sobol" };
+
+    // the second call continues the sequence of paths
+    Size paths[] = { 1000, 1500 };
+    Size pathsPerBatch = 128, concurrentBatches = 3;
+    Real tolerance = 1.0e-12;
+
+    for (Size f=0; f<factories.size(); ++f) {
+
+        // plain accounting engine
+        {
+            ext::shared_ptr<MarketModel> marketModel =
+                makeMarketModel(true, product.evolution(), 3,
+                                ExponentialCorrelationFlatVolatility);
+            std::vector<Size> numeraires = makeMeasure(product, MoneyMarket);
+            Real initialNumeraireValue = todaysDiscounts[numeraires.front()];
+
+            ext::shared_ptr<MarketModelEvolver> evolver(
+                new LogNormalFwdRatePc(marketModel, *factories[f],
+                                       numeraires));
+            AccountingEngine engine(evolver, product, initialNumeraireValue);
+
+            ext::shared_ptr<MarketModelEvolverFactory> evolverFactory(
+                new StandardMarketModelEvolverFactory<LogNormalFwdRatePc>(
+                                                   marketModel, numeraires));
+            ParallelAccountingEngine parallelEngine(
+                evolverFactory, factories[f], product, initialNumeraireValue,
+                pathsPerBatch, concurrentBatches);
+
+            SequenceStatisticsInc stats(product.numberOfProducts());
+            SequenceStatisticsInc parallelStats(product.numberOfProducts());
+            for (Size i=0; i<LENGTH(paths); ++i) {
+                engine.multiplePathValues(stats, paths[i]);
+                parallelEngine.multiplePathValues(parallelStats, paths[i]);
+
+                std::vector<Real> means = stats.mean();
+                std::vector<Real> parallelMeans = parallelStats.mean();
+                std::vector<Real> errors = stats.errorEstimate();
+                std::vector<Real> parallelErrors =
+                    parallelStats.errorEstimate();
+                for (Size j=0; j<means.size(); ++j) {
+                    if (std::fabs(means[j]-parallelMeans[j]) > tolerance
+                        || std::fabs(errors[j]-parallelErrors[j]) > tolerance)
+                        BOOST_ERROR("failed to reproduce sequential results"
+                                    << "\n    generator: " << factoryNames[f]
+                                    << "\n    paths:     " << stats.samples()
+                                    << "\n    product:   " << j
+                                    << "\n    mean:      " << means[j]
+                                    << "\n    parallel:  " << parallelMeans[j]
+                                    << "\n    error:     " << errors[j]
+                                    << "\n    parallel:  " << parallelErrors[j]);
+                }
+            }
+        }
+
+        // pathwise accounting engine
+        {
+            ext::shared_ptr<MarketModel> marketModel =
+                makeMarketModel(true, pathwiseProduct.evolution(), 2,
+                                ExponentialCorrelationAbcdVolatility);
+            std::vector<Size> numeraires =
+                makeMeasure(optionlets, MoneyMarket);
+            Real initialNumeraireValue = todaysDiscounts[numeraires.front()];
+
+            PathwiseAccountingEngine engine(
+                ext::make_shared<LogNormalFwdRateEuler>(marketModel,
+                                                        *factories[f],
+                                                        numeraires),
+                pathwiseProduct, marketModel, initialNumeraireValue);
+            ParallelPathwiseAccountingEngine parallelEngine(
+                marketModel, factories[f], numeraires, pathwiseProduct,
+                marketModel, initialNumeraireValue,
+                pathsPerBatch, concurrentBatches);
+
+            Size size = pathwiseProduct.numberOfProducts()
+                      * (todaysForwards.size()+1);
+            SequenceStatisticsInc stats(size), parallelStats(size);
+            for (Size i=0; i<LENGTH(paths); ++i) {
+                engine.multiplePathValues(stats, paths[i]);
+                parallelEngine.multiplePathValues(parallelStats, paths[i]);
+
+                std::vector<Real> means = stats.mean();
+                std::vector<Real> parallelMeans = parallelStats.mean();
+                for (Size j=0; j<means.size(); ++j) {
+                    if (std::fabs(means[j]-parallelMeans[j]) > tolerance)
+                        BOOST_ERROR("failed to reproduce sequential "
+                                    "pathwise results"
+                                    << "\n    generator: " << factoryNames[f]
+                                    << "\n    paths:     " << stats.samples()
+                                    << "\n    value:     " << j
+                                    << "\n    mean:      " << means[j]
+                                    << "\n    parallel:  " << parallelMeans[j]);
+                }
+            }
+        }
+    }
+}
+
+void MarketModelTest::testBatchEvolver() {
+
+    BOOST_TEST_MESSAGE("Testing lockstep evolution of blocks of paths "
+                       "in a lognormal forward rate market model...");
+
+    using namespace market_model_test;
+
+    setup();
+
+    std::vector<ext::shared_ptr<Payoff> > payoffs(todaysForwards.size());
+    for (Size i=0; i<todaysForwards.size(); ++i)
+        payoffs[i] = ext::shared_ptr<Payoff>(new
+            PlainVanillaPayoff(Option::Call, todaysForwards[i]));
+    MultiStepOptionlets product(rateTimes, accruals,
+                                paymentTimes, payoffs);
+    const EvolutionDescription& evolution = product.evolution();
+
+    MTBrownianGeneratorFactory generatorFactory(seed_);
+
+    Size factors[] = { 3, todaysForwards.size() };
+    MeasureType measures[] = { MoneyMarket, Terminal };
+    // not a multiple of the block size, so that the last block is
+    // used only partially
+    Size paths = 150, pathsPerBlock = 64;
+    Real tolerance = 1.0e-12;
+
+    for (Size i=0; i<LENGTH(factors); ++i) {
+        ext::shared_ptr<MarketModel> marketModel =
+            makeMarketModel(false, evolution, factors[i],
+                            ExponentialCorrelationAbcdVolatility);
+        for (Size j=0; j<LENGTH(measures); ++j) {
+            std::vector<Size> numeraires = makeMeasure(product, measures[j]);
+
+            LogNormalFwdRatePc evolver(marketModel, generatorFactory,
+                                       numeraires);
+            LogNormalFwdRatePcBatch batchEvolver(marketModel,
+                                                 generatorFactory,
+                                                 numeraires, 0,
+                                                 pathsPerBlock);
+
+            for (Size n=0; n<paths; ++n) {
+                Real weight = evolver.startNewPath();
+                Real batchWeight = batchEvolver.startNewPath();
+                for (Size k=0; k<evolution.numberOfSteps(); ++k) {
+                    weight *= evolver.advanceStep();
+                    batchWeight *= batchEvolver.advanceStep();
+                    const std::vector<Rate>& forwards =
+                        evolver.currentState().forwardRates();
+                    const std::vector<Rate>& batchForwards =
+                        batchEvolver.currentState().forwardRates();
+                    for (Size r=0; r<forwards.size(); ++r) {
+                        if (std::fabs(forwards[r]-batchForwards[r])
+                                                            > tolerance)
+                            BOOST_FAIL("forward " << r << " differs"
+                                       << "\n    factors: " << factors[i]
+                                       << "\n    measure: "
+                                       << measureTypeToString(measures[j])
+                                       << "\n    path:    " << n
+                                       << "\n    step:    " << k
+                                       << std::setprecision(15)
+                                       << "\n    single:  " << forwards[r]
+                                       << "\n    batch:   "
+                                       << batchForwards[r]);
+                    }
+                }
+                if (std::fabs(weight-batchWeight) > tolerance)
+                    BOOST_FAIL("path weight differs"
+                               << "\n    path:   " << n
+                               << "\n    single: " << weight
+                               << "\n    batch:  " << batchWeight);
+            }
+        }
+    }
+}
+
+void MarketModelTest::testParallelUpperBoundEngine() {
+
+    BOOST_TEST_MESSAGE("Testing parallel upper-bound engine "
+                       "against sequential one...");
+
+    using namespace market_model_test;
+
+    setup();
+
+    Real fixedRate = 0.04;
+    MultiStepSwap receiverSwap(rateTimes, accruals, accruals, paymentTimes,
+                               fixedRate, false);
+    std::vector<Rate> exerciseTimes(rateTimes);
+    exerciseTimes.pop_back();
+    std::vector<Rate> swapTriggers(exerciseTimes.size(), fixedRate);
+    SwapRateTrigger exerciseStrategy(rateTimes, swapTriggers, exerciseTimes);
+    NothingExerciseValue nullRebate(rateTimes);
+
+    CallSpecifiedMultiProduct dummyProduct(receiverSwap, exerciseStrategy,
+                                           ExerciseAdapter(nullRebate));
+    const EvolutionDescription& evolution = dummyProduct.evolution();
+    std::vector<Size> numeraires = makeMeasure(dummyProduct, Terminal);
+    ext::shared_ptr<MarketModel> marketModel =
+        makeMarketModel(true, evolution, 3,
+                        ExponentialCorrelationAbcdVolatility);
+    Real initialNumeraireValue = todaysDiscounts[numeraires.front()];
+
+    ext::shared_ptr<BrownianGeneratorFactory> outerFactory(
+        new SobolBrownianGeneratorFactory(SobolBrownianGenerator::Diagonal,
+                                          seed_+142));
+    std::vector<ext::shared_ptr<BrownianGeneratorFactory> > innerFactories;
+    std::vector<ext::shared_ptr<MarketModelEvolver> > innerEvolvers;
+    std::valarray<bool> isExerciseTime =
+        isInSubset(evolution.evolutionTimes(),
+                   exerciseStrategy.exerciseTimes());
+    for (Size s=0; s<isExerciseTime.size(); ++s) {
+        if (isExerciseTime[s]) {
+            innerFactories.push_back(
+                ext::shared_ptr<BrownianGeneratorFactory>(
+                                  new MTBrownianGeneratorFactory(seed_+s)));
+            innerEvolvers.push_back(ext::shared_ptr<MarketModelEvolver>(
+                new LogNormalFwdRatePc(marketModel, *innerFactories.back(),
+                                       numeraires, s)));
+        }
+    }
+    ext::shared_ptr<MarketModelEvolver> evolver(
+        new LogNormalFwdRatePc(marketModel, *outerFactory, numeraires));
+
+    UpperBoundEngine engine(evolver, innerEvolvers,
+                            receiverSwap, nullRebate,
+                            receiverSwap, nullRebate,
+                            exerciseStrategy, initialNumeraireValue);
+
+    ext::shared_ptr<MarketModelEvolverFactory> evolverFactory(
+        new StandardMarketModelEvolverFactory<LogNormalFwdRatePc>(
+                                                   marketModel, numeraires));
+    ParallelUpperBoundEngine parallelEngine(
+                            evolverFactory, outerFactory, innerFactories,
+                            receiverSwap, nullRebate,
+                            receiverSwap, nullRebate,
+                            exerciseStrategy, initialNumeraireValue,
+                            false, 3, 4);
+
+    // the second call continues the sequence of paths
+    Size outerPaths[] = { 10, 7 };
+    Size innerPaths = 16;
+    Real tolerance = 1.0e-12;
+
+    Statistics stats, parallelStats;
+    for (Size i=0; i<LENGTH(outerPaths); ++i) {
+        engine.multiplePathValues(stats, outerPaths[i], innerPaths);
+        parallelEngine.multiplePathValues(parallelStats, outerPaths[i],
+                                          innerPaths);
+        if (std::fabs(stats.mean()-parallelStats.mean()) > tolerance
+            || std::fabs(stats.errorEstimate()
+                         -parallelStats.errorEstimate()) > tolerance)
+            BOOST_ERROR("parallel upper bound differs from sequential one"
+                        << std::setprecision(15)
+                        << "\n    call:       " << i
+                        << "\n    sequential: " << stats.mean()
+                        << " +- " << stats.errorEstimate()
+                        << "\n    parallel:   " << parallelStats.mean()
+                        << " +- " << parallelStats.errorEstimate());
+    }
+
+    if (engine.innerPathsSimulated() != parallelEngine.innerPathsSimulated())
+        BOOST_ERROR("inner paths simulated differ"
+                    << "\n    sequential: " << engine.innerPathsSimulated()
+                    << "\n    parallel:   "
+                    << parallelEngine.innerPathsSimulated());
+
+    // with shared inner increments, results must not depend on
+    // how the outer paths are split among batches
+    Size batchSizes[] = { 2, 5 }, concurrentBatches[] = { 3, 2 };
+    Real sharedMeans[2];
+    for (Size i=0; i<LENGTH(batchSizes); ++i) {
+        ParallelUpperBoundEngine sharingEngine(
+                            evolverFactory, outerFactory, innerFactories,
+                            receiverSwap, nullRebate,
+                            receiverSwap, nullRebate,
+                            exerciseStrategy, initialNumeraireValue,
+                            true, batchSizes[i], concurrentBatches[i]);
+        Statistics sharedStats;
+        sharingEngine.multiplePathValues(sharedStats, 11, innerPaths);
+        sharedMeans[i] = sharedStats.mean();
+    }
+    if (std::fabs(sharedMeans[0]-sharedMeans[1]) > tolerance)
+        BOOST_ERROR("upper bound with shared inner paths depends "
+                    "on batch size"
+                    << std::setprecision(15)
+                    << "\n    " << batchSizes[0] << " paths per batch: "
+                    << sharedMeans[0]
+                    << "\n    " << batchSizes[1] << " paths per batch: "
+                    << sharedMeans[1]);
+}
 
 
 
@@ -4920,6 +5341,12 @@ test_suite* MarketModelTest::suite(SpeedLevel speed) {
 
     suite->add(QUANTLIB_TEST_CASE(&MarketModelTest::testAbcdDegenerateCases));
     suite->add(QUANTLIB_TEST_CASE(&MarketModelTest::testCovariance));
+    suite->add(QUANTLIB_TEST_CASE(
+                    &MarketModelTest::testParallelAccountingEngines));
+    suite->add(QUANTLIB_TEST_CASE(&MarketModelTest::testBatchEvolver));
+    suite->add(QUANTLIB_TEST_CASE(
+                    &MarketModelTest::testParallelUpperBoundEngine));
+    suite->add(QUANTLIB_TEST_CASE(&MarketModelTest::testPathwiseVegasAdjoint));
 
     if (speed <= Fast) {
         suite->add(QUANTLIB_TEST_CASE(&MarketModelTest::testPathwiseVegas));
@@ -55,6 +55,10 @@ class MarketModelTest {
     static void testIsInSubset();
     static void testAbcdDegenerateCases();
     static void testCovariance();
+    static void testParallelAccountingEngines();
+    static void testBatchEvolver();
+    static void testParallelUpperBoundEngine();
+    static void testPathwiseVegasAdjoint();
     static boost::unit_test_framework::test_suite* suite(SpeedLevel);
 };
 
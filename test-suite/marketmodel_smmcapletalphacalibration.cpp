@@ -348,12 +348,137 @@ void MarketModelSmmCapletAlphaCalibrationTest::testFunction() {
 }
 
 
+void MarketModelSmmCapletAlphaCalibrationTest::testBulkCalibration() {
+
+    BOOST_TEST_MESSAGE("Testing bulk alpha caplet calibration "
+                       "in a lognormal coterminal swap market model...");
+
+    using namespace market_model_smm_caplet_alpha_calibration_test;
+
+    setup();
+
+    Size numberOfRates = todaysForwards_.size();
+    EvolutionDescription evolution(rateTimes_);
+
+    ext::shared_ptr<LMMCurveState> cs(new LMMCurveState(rateTimes_));
+    cs->setOnForwardRates(todaysForwards_);
+
+    std::vector<ext::shared_ptr<PiecewiseConstantVariance> >
+                                    swapVariances(numberOfRates);
+    for (Size i=0; i<numberOfRates; ++i) {
+        swapVariances[i] = ext::shared_ptr<PiecewiseConstantVariance>(new
+            PiecewiseConstantAbcdVariance(a_, b_, c_, d_,
+                                          i, rateTimes_));
+    }
+
+    std::vector<Real> alphaInitial(numberOfRates, alpha_);
+    std::vector<Real> alphaMax(numberOfRates,  1.0);
+    std::vector<Real> alphaMin(numberOfRates, -1.0);
+
+    // one calibration per correlation decay, standing for
+    // different markets; each is also calibrated on its own
+    Real betas[] = { 0.18, 0.2, 0.22 };
+    std::vector<ext::shared_ptr<CTSMMCapletCalibration> > calibrators,
+                                                          references;
+    for (Size i=0; i<LENGTH(betas); ++i) {
+        ext::shared_ptr<PiecewiseConstantCorrelation> fwdCorr(new
+            ExponentialForwardCorrelation(rateTimes_,
+                                          longTermCorrelation_,
+                                          betas[i]));
+        ext::shared_ptr<PiecewiseConstantCorrelation> corr(new
+            CotSwapFromFwdCorrelation(fwdCorr, *cs, displacement_));
+        for (Size j=0; j<2; ++j) {
+            ext::shared_ptr<CTSMMCapletCalibration> calibrator(new
+                CTSMMCapletAlphaFormCalibration(evolution, corr,
+                                                swapVariances, capletVols_,
+                                                cs, displacement_,
+                                                alphaInitial, alphaMax,
+                                                alphaMin, false));
+            (j == 0 ? calibrators : references).push_back(calibrator);
+        }
+    }
+
+    Natural maxIterations = 10;
+    Real capletTolerance = 1e-4;
+    Natural innerMaxIterations = 100;
+    Real innerTolerance = 1e-8;
+
+    bool result = CTSMMCapletCalibration::calibrateAll(calibrators,
+                                                       numberOfFactors_,
+                                                       maxIterations,
+                                                       capletTolerance,
+                                                       innerMaxIterations,
+                                                       innerTolerance);
+    if (!result)
+        BOOST_ERROR("bulk calibration failed");
+
+    Real tolerance = 1e-12;
+    for (Size i=0; i<calibrators.size(); ++i) {
+        references[i]->calibrate(numberOfFactors_, maxIterations,
+                                 capletTolerance, innerMaxIterations,
+                                 innerTolerance);
+
+        const std::vector<Matrix>& pseudoRoots =
+            calibrators[i]->swapPseudoRoots();
+        const std::vector<Matrix>& expected =
+            references[i]->swapPseudoRoots();
+        for (Size k=0; k<pseudoRoots.size(); ++k) {
+            for (Size r=0; r<pseudoRoots[k].rows(); ++r) {
+                for (Size f=0; f<pseudoRoots[k].columns(); ++f) {
+                    if (std::fabs(pseudoRoots[k][r][f]-expected[k][r][f])
+                                                                > tolerance)
+                        BOOST_ERROR("bulk calibration differs from "
+                                    "single calibration"
+                                    << "\n    beta:       " << betas[i]
+                                    << "\n    step:       " << k
+                                    << "\n    rate:       " << r
+                                    << "\n    factor:     " << f
+                                    << "\n    bulk:       "
+                                    << pseudoRoots[k][r][f]
+                                    << "\n    single:     "
+                                    << expected[k][r][f]);
+                }
+            }
+        }
+
+        // the model caplet vols computed during the calibration
+        // must match the ones of the forward-rate model
+        ext::shared_ptr<MarketModel> smm(new
+            PseudoRootFacade(pseudoRoots, rateTimes_,
+                             cs->coterminalSwapRates(),
+                             std::vector<Spread>(numberOfRates,
+                                                 displacement_)));
+        CotSwapToFwdAdapter flmm(smm);
+        Matrix capletTotCovariance = flmm.totalCovariance(numberOfRates-1);
+        const std::vector<Volatility>& mdlCapletVols =
+            calibrators[i]->mdlCapletVols();
+        for (Size r=0; r<numberOfRates; ++r) {
+            Volatility capletVol =
+                std::sqrt(capletTotCovariance[r][r]/rateTimes_[r]);
+            if (std::fabs(capletVol-mdlCapletVols[r]) > tolerance)
+                BOOST_ERROR("inconsistent " << io::ordinal(r+1)
+                            << " model caplet vol"
+                            << "\n    beta:       " << betas[i]
+                            << "\n    calibrator: " << mdlCapletVols[r]
+                            << "\n    adapter:    " << capletVol);
+        }
+
+        if (calibrators[i]->factorReductionTime() < 0.0
+            || calibrators[i]->solvingTime() < 0.0
+            || calibrators[i]->fitCheckTime() < 0.0)
+            BOOST_ERROR("negative calibration timings");
+    }
+}
+
+
 // --- Call the desired tests
 test_suite* MarketModelSmmCapletAlphaCalibrationTest::suite() {
     auto* suite = BOOST_TEST_SUITE("SMM Caplet alpha calibration test");
 #if !defined(QL_NO_UBLAS_SUPPORT)
     suite->add(QUANTLIB_TEST_CASE(
                     &MarketModelSmmCapletAlphaCalibrationTest::testFunction));
+    suite->add(QUANTLIB_TEST_CASE(
+                    &MarketModelSmmCapletAlphaCalibrationTest::testBulkCalibration));
     #endif
     return suite;
 }
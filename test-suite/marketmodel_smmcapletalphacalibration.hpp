@@ -28,6 +28,7 @@
 class MarketModelSmmCapletAlphaCalibrationTest {
   public:
     static void testFunction();
+    static void testBulkCalibration();
     static boost::unit_test_framework::test_suite* suite();
 };
 
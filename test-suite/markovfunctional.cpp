@@ -42,6 +42,8 @@
 #include <ql/time/daycounters/actual360.hpp>
 #include <ql/time/daycounters/thirty360.hpp>
 #include <ql/time/daycounters/actualactual.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+#include <ql/quotes/simplequote.hpp>
 #include <ql/instruments/makeswaption.hpp>
 #include <ql/instruments/makevanillaswap.hpp>
 #include <ql/instruments/makecapfloor.hpp>
@@ -1750,6 +1752,109 @@ void MarkovFunctionalTest::testBermudanSwaption() {
     Settings::instance().evaluationDate() = savedEvalDate;
 }
 
+void MarkovFunctionalTest::testWarmRecalibration() {
+
+    BOOST_TEST_MESSAGE("Testing Markov functional recalibration to changed "
+                       "smiles...");
+
+    SavedSettings backup;
+    Date referenceDate(14, November, 2012);
+    Settings::instance().evaluationDate() = referenceDate;
+
+    Handle<YieldTermStructure> flatYts_ = flatYts();
+
+    std::vector<Period> optionTenors, swapTenors;
+    optionTenors.push_back(1 * Years);
+    optionTenors.push_back(2 * Years);
+    optionTenors.push_back(3 * Years);
+    optionTenors.push_back(5 * Years);
+    optionTenors.push_back(10 * Years);
+    optionTenors.push_back(15 * Years);
+    swapTenors.push_back(1 * Years);
+    swapTenors.push_back(10 * Years);
+    swapTenors.push_back(20 * Years);
+
+    std::vector<std::vector<ext::shared_ptr<SimpleQuote> > > quotes(
+        optionTenors.size());
+    std::vector<std::vector<Handle<Quote> > > vols(optionTenors.size());
+    for (Size i = 0; i < optionTenors.size(); i++) {
+        for (Size j = 0; j < swapTenors.size(); j++) {
+            quotes[i].push_back(ext::make_shared<SimpleQuote>(0.20));
+            vols[i].push_back(Handle<Quote>(quotes[i].back()));
+        }
+    }
+    Handle<SwaptionVolatilityStructure> swaptionVts(
+        ext::make_shared<SwaptionVolatilityMatrix>(
+            TARGET(), ModifiedFollowing, optionTenors, swapTenors, vols,
+            Actual365Fixed(), true));
+
+    ext::shared_ptr<SwapIndex> swapIndexBase(
+        new EuriborSwapIsdaFixA(1 * Years));
+
+    std::vector<Date> volStepDates;
+    std::vector<Real> modelVols(1, 1.0);
+
+    MarkovFunctional::ModelSettings settings;
+    settings.withYGridPoints(32).withGaussHermitePoints(16).withAdjustments(
+        MarkovFunctional::ModelSettings::KahaleSmile |
+        MarkovFunctional::ModelSettings::SmileExponentialExtrapolation);
+
+    ext::shared_ptr<MarkovFunctional> mf(new MarkovFunctional(
+        flatYts_, 0.01, volStepDates, modelVols, swaptionVts,
+        expiriesCalBasket1(), tenorsCalBasket1(), swapIndexBase, settings));
+
+    Real times[] = { 0.5, 1.5, 2.5, 4.0, 7.5, 10.0 };
+    Real ys[] = { -3.0, -1.0, 0.0, 1.0, 3.0 };
+    Size nt = LENGTH(times), ny = LENGTH(ys);
+
+    std::vector<Real> before;
+    for (Size i = 0; i < nt; i++)
+        for (Size j = 0; j < ny; j++)
+            before.push_back(mf->numeraire(times[i], ys[j]));
+
+    // change the smile of an early expiry only
+    quotes[1][1]->setValue(0.22);
+    std::vector<Real> after;
+    for (Size i = 0; i < nt; i++)
+        for (Size j = 0; j < ny; j++)
+            after.push_back(mf->numeraire(times[i], ys[j]));
+
+    // the later part of the numeraire tabulation is reused ...
+    std::vector<std::string> messages = mf->modelOutputs().messages_;
+    Size unchanged = 0;
+    for (Size i = 0; i < messages.size(); i++)
+        if (messages[i].find("numeraire tabulation unchanged") !=
+            std::string::npos)
+            ++unchanged;
+    if (unchanged == 0)
+        BOOST_ERROR("no part of the numeraire tabulation was reused after "
+                    "changing the smile of an early expiry");
+
+    // ... but the result is the same as the one of a fresh calibration
+    ext::shared_ptr<MarkovFunctional> mfFresh(new MarkovFunctional(
+        flatYts_, 0.01, volStepDates, modelVols, swaptionVts,
+        expiriesCalBasket1(), tenorsCalBasket1(), swapIndexBase, settings));
+
+    Real tol = 1.0E-12;
+    bool changed = false;
+    for (Size i = 0; i < nt; i++) {
+        for (Size j = 0; j < ny; j++) {
+            Real expected = mfFresh->numeraire(times[i], ys[j]);
+            Real calculated = after[i * ny + j];
+            if (std::fabs(calculated - expected) > tol)
+                BOOST_ERROR("numeraire after recalibration ("
+                            << calculated
+                            << ") deviates from freshly calibrated model ("
+                            << expected << ") at t=" << times[i]
+                            << ", y=" << ys[j]);
+            if (std::fabs(calculated - before[i * ny + j]) > 1.0E-8)
+                changed = true;
+        }
+    }
+    if (!changed)
+        BOOST_ERROR("numeraire did not change after smile update");
+}
+
 test_suite *MarkovFunctionalTest::suite(SpeedLevel speed) {
     auto* suite = BOOST_TEST_SUITE("Markov functional model tests");
 
@@ -1758,6 +1863,8 @@ test_suite *MarkovFunctionalTest::suite(SpeedLevel speed) {
         &MarkovFunctionalTest::testKahaleSmileSection));
     suite->add(QUANTLIB_TEST_CASE(
         &MarkovFunctionalTest::testBermudanSwaption));
+    suite->add(QUANTLIB_TEST_CASE(
+        &MarkovFunctionalTest::testWarmRecalibration));
 
     if (speed <= Fast) {
         suite->add(QUANTLIB_TEST_CASE(
@@ -21,7 +21,10 @@
 
 #include "mclongstaffschwartzengine.hpp"
 #include "utilities.hpp"
+#include <ql/experimental/risk/amcregression.hpp>
 #include <ql/instruments/vanillaoption.hpp>
+#include <ql/math/randomnumbers/rngtraits.hpp>
+#include <ql/pricingengines/blackformula.hpp>
 #include <ql/termstructures/yield/flatforward.hpp>
 #include <ql/termstructures/volatility/equityfx/blackconstantvol.hpp>
 #include <ql/processes/stochasticprocessarray.hpp>
@@ -313,6 +316,102 @@ void MCLongstaffSchwartzEngineTest::testAmericanMaxOption() {
     }
 }
 
+void MCLongstaffSchwartzEngineTest::testAmcRegression() {
+    BOOST_TEST_MESSAGE("Testing American Monte Carlo regression...");
+
+    // the put of Longstaff and Schwartz, with 50 exercise dates a year
+    const Real spot = 36.0, strike = 40.0;
+    const Rate r = 0.06;
+    const Volatility sigma = 0.20;
+    const Size dates = 50, samples = 20000;
+    const Time dt = 1.0/dates;
+
+    AmcRegression european(dates, 1, 6, LsmBasisSystem::Monomial, 1000);
+    AmcRegression american(dates, 1, 3, LsmBasisSystem::Monomial, 1000);
+    std::vector<Real> spots(samples*dates);
+
+    PseudoRandom::rsg_type rsg =
+        PseudoRandom::make_sequence_generator(dates, 42);
+    std::vector<Array> states(dates, Array(1));
+    std::vector<Real> payments(dates, 0.0), numeraires(dates),
+                      exercises(dates), noPayments(dates, 0.0);
+    for (Size p=0; p<samples; ++p) {
+        const std::vector<Real>& w = rsg.nextSequence().value;
+        Real s = spot;
+        for (Size d=0; d<dates; ++d) {
+            s *= std::exp((r - 0.5*sigma*sigma)*dt + sigma*std::sqrt(dt)*w[d]);
+            spots[p*dates + d] = s;
+            states[d][0] = s/strike;
+            numeraires[d] = std::exp(r*(d+1)*dt);
+            exercises[d] = std::max(strike - s, 0.0)/numeraires[d];
+        }
+        payments[dates-1] = exercises[dates-1];
+        european.addPath(states, payments, std::vector<Real>(), numeraires);
+        american.addPath(states, noPayments, exercises);
+    }
+
+    // conditional values of the European put
+    AmcResults results = european.calculate();
+    Real expected = blackFormula(Option::Put, strike,
+                                 spot*std::exp(r), sigma, std::exp(-r));
+    if (std::fabs(results.npv - expected) > 3.0*results.errorEstimate)
+        BOOST_ERROR("failed to reproduce European price"
+                    << "\n    calculated: " << results.npv
+                    << " +/- " << results.errorEstimate
+                    << "\n    expected:   " << expected);
+
+    // the polynomial fit degrades as the payoff kink gets closer
+    Size checkedDates[] = { 9, 24 };
+    for (Size c=0; c<LENGTH(checkedDates); ++c) {
+        Size d = checkedDates[c];
+        Time tau = 1.0 - (d+1)*dt;
+        Real error = 0.0;
+        for (Size p=0; p<samples; ++p) {
+            Real s = spots[p*dates + d];
+            Real value = blackFormula(Option::Put, strike,
+                                      s*std::exp(r*tau),
+                                      sigma*std::sqrt(tau),
+                                      std::exp(-r*tau));
+            error += std::fabs(results.values[d*samples + p] - value);
+        }
+        error /= samples;
+        Real tolerance = 0.05;
+        if (error > tolerance)
+            BOOST_ERROR("failed to reproduce conditional values"
+                        << "\n    date:                " << d
+                        << "\n    mean absolute error: " << error
+                        << "\n    tolerance:           " << tolerance);
+    }
+    for (Size p=0; p<samples; ++p) {
+        if (results.exerciseDate[p] != Null<Size>())
+            BOOST_FAIL("exercise found for a European payoff");
+    }
+
+    // exercise policy of the American put
+    results = american.calculate();
+    expected = 4.478;  // finite differences, from the reference above
+    Real tolerance = 3.0*results.errorEstimate + 0.02;
+    if (std::fabs(results.npv - expected) > tolerance)
+        BOOST_ERROR("failed to reproduce American price"
+                    << "\n    calculated: " << results.npv
+                    << " +/- " << results.errorEstimate
+                    << "\n    expected:   " << expected
+                    << "\n    tolerance:  " << tolerance);
+    for (Size p=0; p<samples; ++p) {
+        Size e = results.exerciseDate[p];
+        if (e != Null<Size>()) {
+            Real s = spots[p*dates + e];
+            if (s >= strike || results.values[e*samples + p]
+                               < (strike - s)/std::exp(r*(e+1)*dt) - 1.0e-4)
+                BOOST_FAIL("wrong exercise on path " << p
+                           << " at date " << e);
+            for (Size d=e+1; d<dates; ++d)
+                if (results.values[d*samples + p] != 0.0f)
+                    BOOST_FAIL("nonzero value after exercise on path " << p);
+        }
+    }
+}
+
 test_suite* MCLongstaffSchwartzEngineTest::suite() {
     auto* suite = BOOST_TEST_SUITE("Longstaff Schwartz MC engine tests");
     // FLOATING_POINT_EXCEPTION
@@ -320,6 +419,8 @@ test_suite* MCLongstaffSchwartzEngineTest::suite() {
          &MCLongstaffSchwartzEngineTest::testAmericanOption));
     suite->add(QUANTLIB_TEST_CASE(
          &MCLongstaffSchwartzEngineTest::testAmericanMaxOption));
+    suite->add(QUANTLIB_TEST_CASE(
+         &MCLongstaffSchwartzEngineTest::testAmcRegression));
     return suite;
 }
 
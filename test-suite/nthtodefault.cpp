@@ -24,6 +24,9 @@
 #include <ql/experimental/credit/randomdefaultlatentmodel.hpp>
 #include <ql/experimental/credit/integralntdengine.hpp>
 #include <ql/experimental/credit/pool.hpp>
+#include <ql/math/randomnumbers/randomsequencegenerator.hpp>
+#include <ql/math/solvers1d/brent.hpp>
+#include <ql/math/statistics/generalstatistics.hpp>
 #include <ql/instruments/creditdefaultswap.hpp>
 #include <ql/pricingengines/credit/integralcdsengine.hpp>
 #include <ql/termstructures/yield/flatforward.hpp>
@@ -33,6 +36,9 @@
 #include <ql/quotes/simplequote.hpp>
 #include <ql/currencies/europe.hpp>
 #include <iostream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace QuantLib;
 using namespace std;
@@ -388,9 +394,194 @@ void NthToDefaultTest::testStudent() {
     #endif
 }
 
+void NthToDefaultTest::testRandomDefaultModel() {
+    BOOST_TEST_MESSAGE("Testing random default latent model statistics...");
+
+    SavedSettings backup;
+
+    Size names = 10;
+    Real recovery = 0.4;
+    Real hazardRate = 0.01;
+    Real nameNotional = 10.0;
+    Size numSimulations = 10000;
+
+    Date asofDate(31, August, 2006);
+    Settings::instance().evaluationDate() = asofDate;
+    DayCounter dc = Actual365Fixed();
+
+    Handle<DefaultProbabilityTermStructure> probability(
+        ext::shared_ptr<DefaultProbabilityTermStructure>(
+            new FlatHazardRate(asofDate, hazardRate, dc)));
+
+    std::vector<std::string> namesIds;
+    ext::shared_ptr<Pool> thePool = ext::make_shared<Pool>();
+    for(Size i=0; i<names; i++) {
+        namesIds.push_back(std::string("Name") +
+            boost::lexical_cast<std::string>(i));
+        std::vector<QuantLib::Issuer::key_curve_pair> curves(1,
+            std::make_pair(NorthAmericaCorpDefaultKey(
+                EURCurrency(), QuantLib::SeniorSec, Period(), 1.),
+                probability));
+        thePool->add(namesIds[i], Issuer(curves), NorthAmericaCorpDefaultKey(
+                EURCurrency(), QuantLib::SeniorSec, Period(), 1.));
+    }
+
+    // independent defaults
+    Handle<Quote> correlation(ext::shared_ptr<Quote>(new SimpleQuote(0.0)));
+    ext::shared_ptr<GaussianConstantLossLM> lm(new GaussianConstantLossLM(
+        correlation, std::vector<Real>(names, recovery),
+        LatentModelIntegrationType::GaussianQuadrature, names,
+        GaussianCopulaPolicy::initTraits()));
+
+    Date d = asofDate + 5*Years;
+    Probability p = probability->defaultProbability(d);
+    Real expectedLoss = names*nameNotional*(1.0-recovery)*p;
+    Probability atLeastOne = 1.0 - std::pow(1.0-p, Real(names));
+    // loss standard deviation over the square root of the sample size
+    Real lossError = nameNotional*(1.0-recovery)
+        * std::sqrt(names*p*(1.0-p)/numSimulations);
+    Real probError = std::sqrt(atLeastOne*(1.0-atLeastOne)/numSimulations);
+
+    // Sobol sequences are split by skipping, Mersenne twister by seeding
+    std::vector<ext::shared_ptr<DefaultLossModel> > models;
+    models.push_back(ext::make_shared<RandomDefaultLM<GaussianCopulaPolicy> >(
+        lm, numSimulations));
+    models.push_back(ext::make_shared<RandomDefaultLM<GaussianCopulaPolicy,
+        RandomSequenceGenerator<MersenneTwisterUniformRng> > >(
+            lm, numSimulations));
+
+    for (Size k=0; k<models.size(); k++) {
+        ext::shared_ptr<Basket> basket(new Basket(asofDate, namesIds,
+            std::vector<Real>(names, nameNotional), thePool, 0., 1.));
+        basket->setLossModel(models[k]);
+
+        Real calculated = basket->expectedTrancheLoss(d);
+        if (std::fabs(calculated - expectedLoss) > 3.0*lossError)
+            BOOST_ERROR("failed to reproduce expected loss"
+                        << "\n    model:      " << k
+                        << "\n    calculated: " << calculated
+                        << "\n    expected:   " << expectedLoss);
+
+        Probability calculatedProb = basket->probAtLeastNEvents(1, d);
+        if (std::fabs(calculatedProb - atLeastOne) > 3.0*probError)
+            BOOST_ERROR("failed to reproduce default probability"
+                        << "\n    model:      " << k
+                        << "\n    calculated: " << calculatedProb
+                        << "\n    expected:   " << atLeastOne);
+
+        // one of the names is the first to default
+        std::vector<Probability> firstToDefault =
+            basket->probsBeingNthEvent(1, d);
+        Probability total = std::accumulate(firstToDefault.begin(),
+            firstToDefault.end(), Real(0.0));
+        if (total > calculatedProb + 1.0e-12
+            || total < calculatedProb - 3.0*probError)
+            BOOST_ERROR("inconsistent first-to-default probabilities"
+                        << "\n    model:    " << k
+                        << "\n    total:    " << total
+                        << "\n    expected: " << calculatedProb);
+
+        // the contributions add up to the loss level
+        Real lossLevel = nameNotional*(1.0-recovery);
+        std::vector<Real> split = basket->splitVaRLevel(d, lossLevel);
+        Real splitTotal =
+            std::accumulate(split.begin(), split.end(), Real(0.0));
+        if (std::fabs(splitTotal - lossLevel) > 1.0e-10*lossLevel)
+            BOOST_ERROR("VaR split doesn't add up to the loss level"
+                        << "\n    model:    " << k
+                        << "\n    total:    " << splitTotal
+                        << "\n    expected: " << lossLevel);
+    }
+
+    /* The simulations are run in chunks; with Sobol sequences, which
+       are skipped ahead to the first draw of each chunk, they must be
+       the same as those of a single sequence. */
+    ext::shared_ptr<Basket> basket(new Basket(asofDate, namesIds,
+        std::vector<Real>(names, nameNotional), thePool, 0., 1.));
+    basket->setLossModel(models[0]);
+    Real chunkedLoss = basket->expectedTrancheLoss(d);
+    Probability chunkedProb = basket->probAtLeastNEvents(1, d);
+
+    // the default times are found as in RandomDefaultLM, which looks
+    // for defaults up to 4050 days from today
+    Probability horizonProb =
+        probability->defaultProbability(asofDate + 4050*Days, true);
+    Date::serial_type days = d - asofDate;
+    LatentModel<GaussianCopulaPolicy>::FactorSampler<SobolRsg>
+        sampler(lm->copula(), 2863311530UL);
+    GeneralStatistics serialLosses;
+    Size atLeastOneCount = 0;
+    for (Size i=0; i<numSimulations; i++) {
+        const std::vector<Real>& sample = sampler.nextSequence().value;
+        Size defaults = 0;
+        for (Size j=0; j<names; j++) {
+            Probability simProb =
+                lm->cumulativeY(lm->latentVarValue(sample, j), j);
+            if (horizonProb >= simProb) {
+                Date::serial_type day = static_cast<Size>(Brent().solve(
+                    detail::Root(probability, simProb), 1.e-6, 0., 1.));
+                if (days > day)
+                    defaults++;
+            }
+        }
+        serialLosses.add(defaults*nameNotional*(1.0-recovery));
+        if (defaults > 0)
+            atLeastOneCount++;
+    }
+    Probability serialProb = Real(atLeastOneCount)/numSimulations;
+    if (std::fabs(chunkedLoss - serialLosses.mean()) > 1.0e-12
+        || std::fabs(chunkedProb - serialProb) > 1.0e-12)
+        BOOST_ERROR("chunked Sobol simulation differs from "
+                    "a single sequence"
+                    << std::setprecision(15)
+                    << "\n    chunked loss:       " << chunkedLoss
+                    << "\n    single-sequence:    " << serialLosses.mean()
+                    << "\n    chunked prob.:      " << chunkedProb
+                    << "\n    single-sequence:    " << serialProb);
+
+    #ifdef _OPENMP
+    // results don't depend on the number of threads either
+    int maxThreads = omp_get_max_threads();
+    Size threads[] = { 1, 4 };
+    std::vector<std::vector<Real> > results(LENGTH(threads));
+    for (Size t=0; t<LENGTH(threads); t++) {
+        omp_set_num_threads(int(threads[t]));
+        std::vector<ext::shared_ptr<DefaultLossModel> > freshModels;
+        freshModels.push_back(
+            ext::make_shared<RandomDefaultLM<GaussianCopulaPolicy> >(
+                lm, numSimulations));
+        freshModels.push_back(ext::make_shared<RandomDefaultLM<
+            GaussianCopulaPolicy,
+            RandomSequenceGenerator<MersenneTwisterUniformRng> > >(
+                lm, numSimulations));
+        for (Size k=0; k<freshModels.size(); k++) {
+            basket->setLossModel(freshModels[k]);
+            results[t].push_back(basket->expectedTrancheLoss(d));
+            results[t].push_back(basket->probAtLeastNEvents(1, d));
+            std::vector<Probability> firstToDefault =
+                basket->probsBeingNthEvent(1, d);
+            results[t].insert(results[t].end(),
+                firstToDefault.begin(), firstToDefault.end());
+        }
+    }
+    omp_set_num_threads(maxThreads);
+    for (Size i=0; i<results[0].size(); i++) {
+        if (std::fabs(results[0][i] - results[1][i]) > 1.0e-12)
+            BOOST_ERROR("results depend on the number of threads"
+                        << std::setprecision(15)
+                        << "\n    statistic:  " << i
+                        << "\n    " << threads[0] << " thread(s): "
+                        << results[0][i]
+                        << "\n    " << threads[1] << " thread(s): "
+                        << results[1][i]);
+    }
+    #endif
+}
+
 test_suite* NthToDefaultTest::suite(SpeedLevel speed) {
     auto* suite = BOOST_TEST_SUITE("Nth-to-default tests");
 #ifndef QL_PATCH_SOLARIS
+    suite->add(QUANTLIB_TEST_CASE(&NthToDefaultTest::testRandomDefaultModel));
     if (speed == Slow) {
         suite->add(QUANTLIB_TEST_CASE(&NthToDefaultTest::testGauss));
         suite->add(QUANTLIB_TEST_CASE(&NthToDefaultTest::testStudent));
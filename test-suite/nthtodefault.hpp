@@ -30,6 +30,7 @@ class NthToDefaultTest {
   public:
     static void testGauss();
     static void testStudent();
+    static void testRandomDefaultModel();
     static boost::unit_test_framework::test_suite* suite(SpeedLevel);
 };
 
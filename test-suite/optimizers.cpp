@@ -33,6 +33,7 @@
 #include <ql/math/randomnumbers/mt19937uniformrng.hpp>
 #include <ql/math/optimization/differentialevolution.hpp>
 #include <ql/math/optimization/goldstein.hpp>
+#include <ql/math/optimization/multistartoptimizer.hpp>
 
 using namespace QuantLib;
 using namespace boost::unit_test_framework;
@@ -550,11 +551,105 @@ void OptimizersTest::testDifferentialEvolution() {
     }
 }
 
+namespace {
+
+    // sum of squares with a global minimum in x=1 and
+    // a local one close to x=-0.86
+    class LocalMinimumCostFunction : public CostFunction {
+      public:
+        explicit LocalMinimumCostFunction(bool threadSafe)
+        : threadSafe_(threadSafe) {}
+        Disposable<Array> values(const Array& x) const override {
+            Array retVal(2);
+            retVal[0] = x[0]*x[0] - 1.0;
+            retVal[1] = 0.5*(x[0] - 1.0);
+            return retVal;
+        }
+        bool isThreadSafe() const override { return threadSafe_; }
+      private:
+        bool threadSafe_;
+    };
+
+}
+
+void OptimizersTest::testMultiStart() {
+    BOOST_TEST_MESSAGE("Testing multi-start optimization...");
+
+    LocalMinimumCostFunction costFunction(true);
+    BoundaryConstraint constraint(-3.0, 3.0);
+    const EndCriteria endCriteria(1000, 100, 1e-12, 1e-12, 1e-12);
+    const Array initialValue(1, -2.0);
+
+    // a single local optimization gets stuck in the local minimum
+    Problem problem(costFunction, constraint, initialValue);
+    LevenbergMarquardt lm;
+    lm.minimize(problem, endCriteria);
+
+    if (std::fabs(problem.currentValue()[0] + 0.86) > 0.05) {
+        BOOST_ERROR("failed to find the local minimum"
+                    << "\n  calculated: " << problem.currentValue()[0]
+                    << "\n  expected:   " << -0.86);
+    }
+
+    // parallel evaluation must not change the results
+    LocalMinimumCostFunction sequentialCostFunction(false);
+    Problem sequentialProblem(
+        sequentialCostFunction, constraint, initialValue);
+    LevenbergMarquardt().minimize(sequentialProblem, endCriteria);
+
+    if (std::fabs(sequentialProblem.currentValue()[0]
+                  - problem.currentValue()[0]) > 1e-14
+        || sequentialProblem.functionEvaluation()
+           != problem.functionEvaluation()) {
+        BOOST_ERROR("results depend on the evaluation policy"
+                    << "\n  parallel:   " << problem.currentValue()[0]
+                    << " (" << problem.functionEvaluation()
+                    << " evaluations)"
+                    << "\n  sequential: "
+                    << sequentialProblem.currentValue()[0]
+                    << " (" << sequentialProblem.functionEvaluation()
+                    << " evaluations)");
+    }
+
+    // multi-start finds the global minimum
+    const Size nStartingPoints = 8;
+    MultiStartOptimizer<LevenbergMarquardt> multiStart(lm, nStartingPoints);
+
+    Problem multiStartProblem(costFunction, constraint, initialValue);
+    multiStart.minimize(multiStartProblem, endCriteria);
+
+    if (std::fabs(multiStartProblem.currentValue()[0] - 1.0) > 1e-6
+        || multiStartProblem.functionValue() > 1e-6) {
+        BOOST_ERROR("failed to find the global minimum"
+                    << "\n  calculated: "
+                    << multiStartProblem.currentValue()[0]
+                    << "\n  value:      " << multiStartProblem.functionValue()
+                    << "\n  expected:   " << 1.0);
+    }
+
+    if (multiStart.localMinima().size() != nStartingPoints
+        || std::fabs(multiStart.localMinima().front()[0]
+                     - problem.currentValue()[0]) > 1e-14) {
+        BOOST_ERROR("unexpected local minima");
+    }
+
+    // the evaluations of all local runs are reported, the first
+    // one being the single local optimization above
+    if (multiStartProblem.functionEvaluation()
+        <= problem.functionEvaluation()) {
+        BOOST_ERROR("evaluations of the local runs not reported"
+                    << "\n  multi-start:  "
+                    << multiStartProblem.functionEvaluation()
+                    << "\n  single start: " << problem.functionEvaluation());
+    }
+}
+
 test_suite* OptimizersTest::suite(SpeedLevel speed) {
     auto* suite = BOOST_TEST_SUITE("Optimizers tests");
 
     suite->add(QUANTLIB_TEST_CASE(&OptimizersTest::test));
     suite->add(QUANTLIB_TEST_CASE(&OptimizersTest::nestedOptimizationTest));
+    suite->add(QUANTLIB_TEST_CASE(&OptimizersTest::testMultiStart));
 
     if (speed <= Fast) {
         suite->add(QUANTLIB_TEST_CASE(
@@ -24,10 +24,16 @@
 #include "shortratemodels.hpp"
 #include "utilities.hpp"
 #include <ql/cashflows/iborcoupon.hpp>
+#include <ql/cashflows/cashflows.hpp>
+#include <ql/experimental/risk/exposuresimulator.hpp>
+#include <ql/instruments/forwardrateagreement.hpp>
+#include <ql/instruments/makevanillaswap.hpp>
 #include <ql/models/shortrate/onefactormodels/hullwhite.hpp>
 #include <ql/models/shortrate/onefactormodels/extendedcoxingersollross.hpp>
 #include <ql/models/shortrate/calibrationhelpers/swaptionhelper.hpp>
+#include <ql/models/shortrate/calibrationhelpers/swaptionhelperbasket.hpp>
 #include <ql/pricingengines/swaption/jamshidianswaptionengine.hpp>
+#include <ql/pricingengines/swaption/g2swaptionengine.hpp>
 #include <ql/pricingengines/swap/treeswapengine.hpp>
 #include <ql/pricingengines/swap/discountingswapengine.hpp>
 #include <ql/indexes/ibor/euribor.hpp>
@@ -35,9 +41,11 @@
 #include <ql/math/optimization/simplex.hpp>
 #include <ql/math/optimization/levenbergmarquardt.hpp>
 #include <ql/termstructures/yield/discountcurve.hpp>
+#include <ql/termstructures/yield/flatforward.hpp>
 #include <ql/time/calendars/target.hpp>
 #include <ql/time/daycounters/thirty360.hpp>
 #include <ql/time/daycounters/actual360.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
 #include <ql/time/schedule.hpp>
 #include <ql/quotes/simplequote.hpp>
 
@@ -470,6 +478,387 @@ void ShortRateModelTest::testExtendedCoxIngersollRossDiscountFactor() {
     }
 }
 
+void ShortRateModelTest::testSwaptionHelperBasket() {
+    BOOST_TEST_MESSAGE("Testing batch valuation of swaption helpers...");
+
+    using namespace short_rate_models_test;
+
+    SavedSettings backup;
+    IndexHistoryCleaner cleaner;
+
+    Date today(15, February, 2002);
+    Date settlement(19, February, 2002);
+    Settings::instance().evaluationDate() = today;
+    Handle<YieldTermStructure> termStructure(flatRate(settlement,0.04875825,
+                                                      Actual365Fixed()));
+    ext::shared_ptr<IborIndex> index(new Euribor6M(termStructure));
+
+    CalibrationData data[] = {{ 1, 5, 0.1148 },
+                              { 2, 4, 0.1108 },
+                              { 3, 3, 0.1070 },
+                              { 4, 2, 0.1021 },
+                              { 5, 1, 0.1000 },
+                              { 1, 1, 0.1200 },
+                              { 2, 2, 0.1150 },
+                              { 3, 7, 0.1050 }};
+    // ATM (receiver), out-of-the-money payer and receiver swaptions
+    Real strikes[] = { Null<Real>(), 0.07, 0.03 };
+
+    std::vector<ext::shared_ptr<SwaptionHelper> > helpers;
+    for (Size i=0; i<LENGTH(data); i++) {
+        ext::shared_ptr<Quote> vol(new SimpleQuote(data[i].volatility));
+        helpers.push_back(ext::make_shared<SwaptionHelper>(
+                             Period(data[i].start, Years),
+                             Period(data[i].length, Years),
+                             Handle<Quote>(vol), index,
+                             Period(1, Years), Thirty360(), Actual360(),
+                             termStructure,
+                             BlackCalibrationHelper::RelativePriceError,
+                             strikes[i % LENGTH(strikes)]));
+    }
+    ext::shared_ptr<SwaptionHelperBasket> basket(
+                          new SwaptionHelperBasket(helpers, termStructure));
+
+    // the Jamshidian engine solves for the critical rate to 1e-8 only
+    Real tolerance = 1.0e-8;
+
+    // Hull-White values and gradients
+    ext::shared_ptr<HullWhite> hw(new HullWhite(termStructure, 0.05, 0.008));
+    ext::shared_ptr<PricingEngine> jamshidian(
+                                         new JamshidianSwaptionEngine(hw));
+    Matrix hwGradients;
+    Array hwValues = basket->values(*hw, hwGradients);
+    for (Size i=0; i<helpers.size(); i++) {
+        helpers[i]->setPricingEngine(jamshidian);
+        Real expected = helpers[i]->modelValue();
+        if (std::fabs(hwValues[i] - expected) > tolerance)
+            BOOST_ERROR("failed to reproduce Jamshidian value for "
+                        "swaption #" << i << ":"
+                        << "\n    calculated: " << hwValues[i]
+                        << "\n    expected:   " << expected);
+    }
+
+    Array params = hw->params();
+    for (Size j=0; j<params.size(); j++) {
+        Real h = 1.0e-6*params[j];
+        Array bumped = params;
+        bumped[j] = params[j] + h;
+        hw->setParams(bumped);
+        Array up = basket->values(*hw);
+        bumped[j] = params[j] - h;
+        hw->setParams(bumped);
+        Array down = basket->values(*hw);
+        for (Size i=0; i<helpers.size(); i++) {
+            Real expected = (up[i] - down[i])/(2.0*h);
+            if (std::fabs(hwGradients[i][j] - expected) >
+                                        1.0e-6*std::fabs(expected) + 1.0e-10)
+                BOOST_ERROR("failed to reproduce Hull-White derivative #"
+                            << j << " for swaption #" << i << ":"
+                            << "\n    analytic:   " << hwGradients[i][j]
+                            << "\n    numerical:  " << expected);
+        }
+    }
+    hw->setParams(params);
+
+    // G2 values and gradients
+    ext::shared_ptr<G2> g2(
+                  new G2(termStructure, 0.05, 0.008, 0.3, 0.006, -0.6));
+    ext::shared_ptr<PricingEngine> g2Engine(
+                                    new G2SwaptionEngine(g2, 6.0, 32));
+    Matrix g2Gradients;
+    Array g2Values = basket->values(*g2, 6.0, 32, g2Gradients);
+    for (Size i=0; i<helpers.size(); i++) {
+        helpers[i]->setPricingEngine(g2Engine);
+        Real expected = helpers[i]->modelValue();
+        if (std::fabs(g2Values[i] - expected) > 1.0e-8)
+            BOOST_ERROR("failed to reproduce G2 value for "
+                        "swaption #" << i << ":"
+                        << "\n    calculated: " << g2Values[i]
+                        << "\n    expected:   " << expected);
+    }
+
+    params = g2->params();
+    for (Size j=0; j<params.size(); j++) {
+        Real h = 1.0e-6*std::fabs(params[j]);
+        Array bumped = params;
+        bumped[j] = params[j] + h;
+        g2->setParams(bumped);
+        Array up = basket->values(*g2, 6.0, 32);
+        bumped[j] = params[j] - h;
+        g2->setParams(bumped);
+        Array down = basket->values(*g2, 6.0, 32);
+        for (Size i=0; i<helpers.size(); i++) {
+            Real expected = (up[i] - down[i])/(2.0*h);
+            if (std::fabs(g2Gradients[i][j] - expected) >
+                                        1.0e-5*std::fabs(expected) + 1.0e-9)
+                BOOST_ERROR("failed to reproduce G2 derivative #"
+                            << j << " for swaption #" << i << ":"
+                            << "\n    analytic:   " << g2Gradients[i][j]
+                            << "\n    numerical:  " << expected);
+        }
+    }
+
+    // calibration through the basket
+    std::vector<ext::shared_ptr<CalibrationHelper> > swaptions;
+    for (Size i=0; i<helpers.size(); i++) {
+        helpers[i]->setPricingEngine(jamshidian);
+        swaptions.push_back(helpers[i]);
+    }
+    LevenbergMarquardt optimizationMethod(1.0e-8,1.0e-8,1.0e-8);
+    EndCriteria endCriteria(10000, 100, 1e-6, 1e-8, 1e-8);
+    hw->calibrate(swaptions, optimizationMethod, endCriteria);
+    Array expected = hw->params();
+
+    ext::shared_ptr<HullWhite> hw2(new HullWhite(termStructure, 0.05, 0.008));
+    std::vector<ext::shared_ptr<CalibrationHelper> > basketSwaptions =
+        basketCalibrationHelpers(basket, hw2);
+    LevenbergMarquardt analyticMethod(1.0e-8,1.0e-8,1.0e-8,true);
+    hw2->calibrate(basketSwaptions, analyticMethod, endCriteria);
+    Array calculated = hw2->params();
+
+    for (Size j=0; j<expected.size(); j++) {
+        if (std::fabs(calculated[j] - expected[j]) > 1.0e-6)
+            BOOST_ERROR("failed to reproduce Hull-White calibration "
+                        "through the basket:"
+                        << "\n    calculated: " << calculated
+                        << "\n    expected:   " << expected);
+    }
+}
+
+void ShortRateModelTest::testExposureSimulator() {
+
+    BOOST_TEST_MESSAGE("Testing Hull-White exposure simulation...");
+
+    SavedSettings backup;
+
+    Date today(15, March, 2021);
+    Settings::instance().evaluationDate() = today;
+    DayCounter dc = Actual365Fixed();
+    Handle<YieldTermStructure> curve(
+        ext::shared_ptr<YieldTermStructure>(new FlatForward(today, 0.03, dc)));
+    ext::shared_ptr<HullWhite> model(new HullWhite(curve, 0.05, 0.01));
+    ext::shared_ptr<IborIndex> index(new Euribor6M(curve));
+
+    Real notional = 1000000.0;
+    ext::shared_ptr<VanillaSwap> payer =
+        MakeVanillaSwap(5*Years, index, 0.03).withNominal(notional);
+    ext::shared_ptr<VanillaSwap> receiver =
+        MakeVanillaSwap(5*Years, index, 0.03).withNominal(notional)
+        .withType(VanillaSwap::Receiver);
+
+    ext::shared_ptr<VanillaSwap> forwardSwap =
+        MakeVanillaSwap(4*Years, index, 0.03, 1*Years).withNominal(notional);
+    Date expiry = index->fixingDate(forwardSwap->startDate());
+    ext::shared_ptr<Swaption> swaption(
+        new Swaption(forwardSwap,
+                     ext::make_shared<EuropeanExercise>(expiry)));
+    swaption->setPricingEngine(
+        ext::make_shared<JamshidianSwaptionEngine>(model));
+
+    Date fraStart = index->fixingCalendar().advance(today, 6*Months),
+         fraEnd = index->fixingCalendar().advance(today, 12*Months);
+    // forecast on the curve, as in the simulation
+    ForwardRateAgreement fra(fraStart, fraEnd, Position::Long, 0.031,
+                             notional, index, curve, false);
+
+    // monthly exposure dates, plus the swaption expiry
+    std::vector<Date> dates;
+    for (Integer i=1; i<=60; ++i)
+        dates.push_back(today + i*Months);
+    dates.push_back(expiry);
+    std::sort(dates.begin(), dates.end());
+    dates.erase(std::unique(dates.begin(), dates.end()), dates.end());
+
+    Size samples = 5000;
+    ExposureSimulator simulator(model, dates, samples, 42, 0.95, 512);
+    simulator.addSwap(*payer, 0);
+    simulator.addSwaption(swaption, 1);
+    simulator.addFra(fra, 2);
+    // offsetting swaps in the same set
+    simulator.addSwap(*payer, 3);
+    simulator.addSwap(*receiver, 3);
+
+    std::vector<ExposureProfile> profiles = simulator.calculate();
+    if (profiles.size() != 4)
+        BOOST_FAIL("wrong number of netting sets: " << profiles.size());
+
+    // the discounted expected value of each set is a martingale and
+    // should match the model value today of the flows still to come
+    Size swaptionDate =
+        std::find(dates.begin(), dates.end(), expiry) - dates.begin();
+    Size checkedDates[] = { 0, 11, swaptionDate + 1, 35, 58 };
+    for (Size c=0; c<LENGTH(checkedDates); ++c) {
+        Size d = checkedDates[c];
+        for (Size n=0; n<3; ++n) {
+            Real expected;
+            switch (n) {
+              case 0:
+                expected =
+                    CashFlows::npv(payer->floatingLeg(), **curve, false,
+                                   dates[d], today)
+                    - CashFlows::npv(payer->fixedLeg(), **curve, false,
+                                     dates[d], today);
+                break;
+              case 1:
+                // after exercise, the flows of the underlying are paid
+                if (d > swaptionDate + 1)
+                    continue;
+                expected = swaption->NPV();
+                break;
+              default:
+                if (dates[d] >= fraStart)
+                    continue;
+                expected = fra.NPV();
+            }
+            const ExposureProfile& profile = profiles[n];
+            Real calculated = profile.discountedExpectedExposure[d]
+                            + profile.discountedExpectedNegativeExposure[d];
+
+            // rough error estimate from the undiscounted values
+            Real sum = 0.0, sum2 = 0.0;
+            for (Size p=0; p<samples; ++p) {
+                Real v = simulator.nettedValue(n, d, p);
+                sum += v;
+                sum2 += v*v;
+            }
+            Real mean = sum/samples;
+            Real error = std::sqrt((sum2/samples - mean*mean)/samples);
+            Real tolerance = 4.0*error + 1.0e-6*notional;
+            if (std::fabs(calculated - expected) > tolerance)
+                BOOST_ERROR("failed to reproduce expected value"
+                            << "\n    netting set: " << n
+                            << "\n    date:        " << dates[d]
+                            << std::fixed << std::setprecision(2)
+                            << "\n    calculated:  " << calculated
+                            << "\n    expected:    " << expected
+                            << "\n    tolerance:   " << tolerance);
+        }
+    }
+
+    for (Size d=0; d<dates.size(); ++d) {
+        const ExposureProfile& swap = profiles[0];
+        if (swap.potentialFutureExposure[d] < swap.expectedExposure[d]
+            && swap.expectedExposure[d] > 0.0)
+            BOOST_ERROR("PFE below EE at " << dates[d]
+                        << "\n    EE:  " << swap.expectedExposure[d]
+                        << "\n    PFE: " << swap.potentialFutureExposure[d]);
+        // once exercised, the underlying swap can be out of the money
+        if (dates[d] < expiry
+            && profiles[1].expectedNegativeExposure[d] < -1.0e-6*notional)
+            BOOST_ERROR("negative exposure for a long swaption at "
+                        << dates[d] << ": "
+                        << profiles[1].expectedNegativeExposure[d]);
+        const ExposureProfile& netted = profiles[3];
+        if (netted.expectedExposure[d] > 1.0e-6*notional
+            || netted.expectedNegativeExposure[d] < -1.0e-6*notional
+            || netted.potentialFutureExposure[d] > 1.0e-6*notional)
+            BOOST_ERROR("offsetting trades not netted at " << dates[d]
+                        << "\n    EE:  " << netted.expectedExposure[d]
+                        << "\n    ENE: " << netted.expectedNegativeExposure[d]
+                        << "\n    PFE: " << netted.potentialFutureExposure[d]);
+    }
+}
+
+void ShortRateModelTest::testG2ExposureSimulator() {
+
+    BOOST_TEST_MESSAGE("Testing G2++ exposure simulation...");
+
+    SavedSettings backup;
+
+    Date today(15, March, 2021);
+    Settings::instance().evaluationDate() = today;
+    DayCounter dc = Actual365Fixed();
+    Handle<YieldTermStructure> curve(
+        ext::shared_ptr<YieldTermStructure>(new FlatForward(today, 0.03, dc)));
+    ext::shared_ptr<G2> model(new G2(curve, 0.05, 0.01, 0.3, 0.008, -0.6));
+    ext::shared_ptr<IborIndex> index(new Euribor6M(curve));
+
+    Real notional = 1000000.0;
+    ext::shared_ptr<VanillaSwap> payer =
+        MakeVanillaSwap(5*Years, index, 0.03).withNominal(notional);
+    ext::shared_ptr<VanillaSwap> receiver =
+        MakeVanillaSwap(5*Years, index, 0.03).withNominal(notional)
+        .withType(VanillaSwap::Receiver);
+
+    Date fraStart = index->fixingCalendar().advance(today, 6*Months),
+         fraEnd = index->fixingCalendar().advance(today, 12*Months);
+    ForwardRateAgreement fra(fraStart, fraEnd, Position::Short, 0.028,
+                             notional, index, curve, false);
+
+    std::vector<Date> dates;
+    for (Integer i=1; i<=60; ++i)
+        dates.push_back(today + i*Months);
+
+    Size samples = 5000;
+    ExposureSimulator simulator(model, dates, samples, 42, 0.95, 512);
+    simulator.addSwap(*payer, 0);
+    simulator.addFra(fra, 1);
+    simulator.addSwap(*payer, 2);
+    simulator.addSwap(*receiver, 2);
+
+    // swaptions need a one-factor model
+    ext::shared_ptr<Swaption> swaption(
+        new Swaption(MakeVanillaSwap(4*Years, index, 0.03, 1*Years),
+                     ext::make_shared<EuropeanExercise>(today + 1*Years)));
+    BOOST_CHECK_THROW(simulator.addSwaption(swaption, 3), Error);
+
+    std::vector<ExposureProfile> profiles = simulator.calculate();
+    if (profiles.size() != 3)
+        BOOST_FAIL("wrong number of netting sets: " << profiles.size());
+
+    // the discounted expected values are martingales under G2++ too
+    Size checkedDates[] = { 0, 4, 11, 35, 58 };
+    for (Size c=0; c<LENGTH(checkedDates); ++c) {
+        Size d = checkedDates[c];
+        for (Size n=0; n<2; ++n) {
+            Real expected;
+            if (n == 0) {
+                expected =
+                    CashFlows::npv(payer->floatingLeg(), **curve, false,
+                                   dates[d], today)
+                    - CashFlows::npv(payer->fixedLeg(), **curve, false,
+                                     dates[d], today);
+            } else {
+                if (dates[d] >= fraStart)
+                    continue;
+                expected = fra.NPV();
+            }
+            const ExposureProfile& profile = profiles[n];
+            Real calculated = profile.discountedExpectedExposure[d]
+                            + profile.discountedExpectedNegativeExposure[d];
+
+            Real sum = 0.0, sum2 = 0.0;
+            for (Size p=0; p<samples; ++p) {
+                Real v = simulator.nettedValue(n, d, p);
+                sum += v;
+                sum2 += v*v;
+            }
+            Real mean = sum/samples;
+            Real error = std::sqrt((sum2/samples - mean*mean)/samples);
+            Real tolerance = 4.0*error + 1.0e-6*notional;
+            if (std::fabs(calculated - expected) > tolerance)
+                BOOST_ERROR("failed to reproduce expected value"
+                            << "\n    netting set: " << n
+                            << "\n    date:        " << dates[d]
+                            << std::fixed << std::setprecision(2)
+                            << "\n    calculated:  " << calculated
+                            << "\n    expected:    " << expected
+                            << "\n    tolerance:   " << tolerance);
+        }
+    }
+
+    for (Size d=0; d<dates.size(); ++d) {
+        const ExposureProfile& netted = profiles[2];
+        if (netted.expectedExposure[d] > 1.0e-6*notional
+            || netted.expectedNegativeExposure[d] < -1.0e-6*notional
+            || netted.potentialFutureExposure[d] > 1.0e-6*notional)
+            BOOST_ERROR("offsetting trades not netted at " << dates[d]
+                        << "\n    EE:  " << netted.expectedExposure[d]
+                        << "\n    ENE: " << netted.expectedNegativeExposure[d]
+                        << "\n    PFE: " << netted.potentialFutureExposure[d]);
+    }
+}
+
 test_suite* ShortRateModelTest::suite(SpeedLevel speed) {
     auto* suite = BOOST_TEST_SUITE("Short-rate model tests");
 
@@ -477,8 +866,11 @@ test_suite* ShortRateModelTest::suite(SpeedLevel speed) {
     suite->add(QUANTLIB_TEST_CASE(&ShortRateModelTest::testCachedHullWhiteFixedReversion));
     suite->add(QUANTLIB_TEST_CASE(&ShortRateModelTest::testCachedHullWhite2));
     suite->add(QUANTLIB_TEST_CASE(&ShortRateModelTest::testFuturesConvexityBias));
+    suite->add(QUANTLIB_TEST_CASE(&ShortRateModelTest::testSwaptionHelperBasket));
     suite->add(QUANTLIB_TEST_CASE(
         &ShortRateModelTest::testExtendedCoxIngersollRossDiscountFactor));
+    suite->add(QUANTLIB_TEST_CASE(&ShortRateModelTest::testExposureSimulator));
+    suite->add(QUANTLIB_TEST_CASE(&ShortRateModelTest::testG2ExposureSimulator));
 
     if (speed == Slow) {
         suite->add(QUANTLIB_TEST_CASE(&ShortRateModelTest::testSwaps));
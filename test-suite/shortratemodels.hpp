@@ -33,7 +33,10 @@ class ShortRateModelTest {
     static void testCachedHullWhiteFixedReversion();
     static void testCachedHullWhite2();
     static void testSwaps();
+    static void testSwaptionHelperBasket();
     static void testExtendedCoxIngersollRossDiscountFactor();
+    static void testExposureSimulator();
+    static void testG2ExposureSimulator();
     static boost::unit_test_framework::test_suite* suite(SpeedLevel);
 };
 